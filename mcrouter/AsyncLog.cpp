@@ -16,7 +16,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <folly/Conv.h>
 #include <folly/File.h>
@@ -25,6 +27,8 @@
 #include <folly/json.h>
 #include <folly/system/ThreadName.h>
 
+#include "mcrouter/AsyncLogSpool.h"
+#include "mcrouter/AsyncWriter.h"
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
@@ -119,7 +123,7 @@ bool AsyncLog::openFile() {
   if (snprintf(
           path,
           PATH_MAX,
-          "%s/%04d%02d%02dT%02d%02d%02d-%lld-%s-%s-t%d-%p",
+          "%s/%04d%02d%02dT%02d%02d%02d-%lld-%s-%s-t%d-%p%s",
           hour_path,
           date.tm_year + 1900,
           date.tm_mon + 1,
@@ -131,7 +135,8 @@ bool AsyncLog::openFile() {
           options_.service_name.c_str(),
           options_.router_name.c_str(),
           tid,
-          this) > PATH_MAX) {
+          this,
+          spoolWriter_ ? ".bin" : "") > PATH_MAX) {
     path[PATH_MAX] = '\0';
     MC_LOG_FAILURE(
         options_,
@@ -190,6 +195,24 @@ bool AsyncLog::openFile() {
     return false;
   }
 
+  if (spoolWriter_ && st.st_size == 0) {
+    auto header = AsyncLogSpoolWriter::fileHeader(
+        options_.service_name,
+        options_.flavor_name,
+        options_.default_route.getRegion());
+    if (folly::writeFull(fd, header.data(), header.size()) !=
+        static_cast<ssize_t>(header.size())) {
+      MC_LOG_FAILURE(
+          options_,
+          failure::Category::kSystemError,
+          "Can't write header of async store {}: {}",
+          path,
+          folly::errnoStr(errno));
+      closeFd(fd);
+      return false;
+    }
+  }
+
   file_ = createFile(fd);
   if (!file_) {
     MC_LOG_FAILURE(
@@ -208,14 +231,20 @@ bool AsyncLog::openFile() {
   return true;
 }
 
-AsyncLog::AsyncLog(const McrouterOptions& options) : options_(options) {}
+AsyncLog::AsyncLog(const McrouterOptions& options) : options_(options) {
+  if (options_.asynclog_binary) {
+    spoolWriter_ = std::make_unique<AsyncLogSpoolWriter>(
+        options_.asynclog_binary_compression);
+  }
+}
 
-/** Adds an asynchronous request to the event log. */
-bool AsyncLog::writeDelete(
+AsyncLog::~AsyncLog() = default;
+
+std::string AsyncLog::formatDelete(
     const AccessPoint& ap,
     folly::StringPiece key,
     folly::StringPiece poolName,
-    std::unordered_map<std::string, uint64_t> attributes) {
+    std::unordered_map<std::string, uint64_t> attributes) const {
   dynamic json = dynamic::array;
   const auto& host = ap.getHost();
   const auto port = options_.asynclog_port_override == 0
@@ -239,16 +268,6 @@ bool AsyncLog::writeDelete(
     json.push_back(folly::sformat("delete {}\r\n", key));
   }
 
-  if (!openFile()) {
-    MC_LOG_FAILURE(
-        options_,
-        memcache::failure::Category::kSystemError,
-        "asynclog_open() failed (key {}, pool {})",
-        key,
-        poolName);
-    return false;
-  }
-
   // ["AS1.0", 1289416829.836, "C", ["10.0.0.1", 11302, "delete foo\r\n"]]
   // OR ["AS2.0", 1289416829.836, "C", {"f":"flavor","h":"[10.0.0.1]:11302",
   //                                    "p":"pool_name","k":"foo\r\n"}]
@@ -268,7 +287,60 @@ bool AsyncLog::writeDelete(
 
   jsonOut.push_back(json);
 
-  auto jstr = folly::toJson(jsonOut) + "\n";
+  return folly::toJson(jsonOut) + "\n";
+}
+
+std::string AsyncLog::encode(PendingDelete* const* entries, size_t n) {
+  if (!spoolWriter_) {
+    std::string out;
+    for (size_t i = 0; i < n; ++i) {
+      out += formatDelete(
+          entries[i]->ap,
+          entries[i]->key,
+          entries[i]->poolName,
+          entries[i]->attributes);
+    }
+    return out;
+  }
+
+  auto timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  for (size_t i = 0; i < n; ++i) {
+    const auto& ap = entries[i]->ap;
+    auto attributes = entries[i]->attributes;
+    attributes.emplace(AsyncLog::kAsyncLogMarker, 1);
+    spoolWriter_->add(
+        timestampMs,
+        ap.getHost(),
+        options_.asynclog_port_override == 0 ? ap.getPort()
+                                             : options_.asynclog_port_override,
+        entries[i]->poolName,
+        entries[i]->key,
+        attributes);
+  }
+  return spoolWriter_->finishBlock();
+}
+
+/** Adds an asynchronous request to the event log. */
+bool AsyncLog::writeDelete(
+    const AccessPoint& ap,
+    folly::StringPiece key,
+    folly::StringPiece poolName,
+    std::unordered_map<std::string, uint64_t> attributes) {
+  PendingDelete entry(ap, key, poolName, attributes);
+  PendingDelete* entries[] = {&entry};
+  auto jstr = encode(entries, 1);
+
+  if (!openFile()) {
+    MC_LOG_FAILURE(
+        options_,
+        memcache::failure::Category::kSystemError,
+        "asynclog_open() failed (key {}, pool {})",
+        key,
+        poolName);
+    return false;
+  }
 
   ssize_t size = folly::writeFull(file_->fd(), jstr.data(), jstr.size());
   if (size == -1 || size_t(size) < jstr.size()) {
@@ -283,6 +355,60 @@ bool AsyncLog::writeDelete(
   return true;
 }
 
+bool AsyncLog::enqueueDelete(AsyncWriter& writer, PendingDelete& entry) {
+  if (!pending_.insertHead(&entry)) {
+    // A write is already scheduled and will pick this entry up.
+    return true;
+  }
+  if (writer.run([this]() { writePending(); })) {
+    return true;
+  }
+  // Only this thread adds entries and nothing is draining them, so `entry`
+  // is the only one queued.
+  pending_.sweep([](PendingDelete*) {});
+  return false;
+}
+
+void AsyncLog::writePending() {
+  std::vector<PendingDelete*> batch;
+  pending_.sweep([&batch](PendingDelete* entry) { batch.push_back(entry); });
+
+  const size_t batchSize = std::max<size_t>(options_.asynclog_batch_size, 1);
+  for (size_t begin = 0; begin < batch.size(); begin += batchSize) {
+    const size_t end = std::min(batch.size(), begin + batchSize);
+    auto buf = encode(batch.data() + begin, end - begin);
+
+    bool written = false;
+    if (!openFile()) {
+      MC_LOG_FAILURE(
+          options_,
+          memcache::failure::Category::kSystemError,
+          "asynclog_open() failed ({} entries, first key {}, pool {})",
+          end - begin,
+          batch[begin]->key,
+          batch[begin]->poolName);
+    } else {
+      ssize_t size = folly::writeFull(file_->fd(), buf.data(), buf.size());
+      written = size != -1 && size_t(size) == buf.size();
+      if (!written) {
+        MC_LOG_FAILURE(
+            options_,
+            memcache::failure::Category::kSystemError,
+            "Error fully writing asynclog requests "
+            "({} entries, first key {}, pool {})",
+            end - begin,
+            batch[begin]->key,
+            batch[begin]->poolName);
+      }
+    }
+
+    for (size_t i = begin; i < end; ++i) {
+      batch[i]->written = written;
+      batch[i]->done.post();
+    }
+  }
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
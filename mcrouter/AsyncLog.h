@@ -8,10 +8,13 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 
+#include <folly/AtomicIntrusiveLinkedList.h>
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <folly/fibers/Baton.h>
 
 namespace facebook {
 namespace memcache {
@@ -21,11 +24,39 @@ class McrouterOptions;
 
 namespace mcrouter {
 
+class AsyncLogSpoolWriter;
+class AsyncWriter;
+
 class AsyncLog {
  public:
   static constexpr folly::StringPiece kAsyncLogMarker{"al"};
 
+  /**
+   * A 'delete' entry queued with enqueueDelete(). Lives on the stack of the
+   * fiber waiting for it to be written, so that queueing doesn't allocate.
+   */
+  struct PendingDelete {
+    PendingDelete(
+        const AccessPoint& ap_,
+        folly::StringPiece key_,
+        folly::StringPiece poolName_,
+        const std::unordered_map<std::string, uint64_t>& attributes_)
+        : ap(ap_), key(key_), poolName(poolName_), attributes(attributes_) {}
+
+    const AccessPoint& ap;
+    const folly::StringPiece key;
+    const folly::StringPiece poolName;
+    const std::unordered_map<std::string, uint64_t>& attributes;
+
+    // Posted once the entry was written (or failed to).
+    folly::fibers::Baton done;
+    bool written{false};
+
+    folly::AtomicIntrusiveLinkedListHook<PendingDelete> hook;
+  };
+
   explicit AsyncLog(const McrouterOptions& options);
+  ~AsyncLog();
 
   /**
    * Appends a 'delete' request entry to the asynclog.
@@ -38,10 +69,27 @@ class AsyncLog {
       folly::StringPiece poolName,
       std::unordered_map<std::string, uint64_t> attributes = {});
 
+  /**
+   * Queues `entry` to be appended by `writer`. All entries queued while
+   * the writer is busy are appended together, with one write per
+   * asynclog_batch_size entries.
+   *
+   * Must be called from a single thread (the proxy thread).
+   *
+   * @return  true if `entry` was queued, `entry.done` will be posted once
+   *          it's written. false if the writer is not accepting tasks.
+   */
+  bool enqueueDelete(AsyncWriter& writer, PendingDelete& entry);
+
  private:
   const McrouterOptions& options_;
   std::unique_ptr<folly::File> file_;
   time_t spoolTime_{0};
+  // Set iff asynclog_binary is enabled.
+  std::unique_ptr<AsyncLogSpoolWriter> spoolWriter_;
+
+  folly::AtomicIntrusiveLinkedList<PendingDelete, &PendingDelete::hook>
+      pending_;
 
   /**
    * Open async log file.
@@ -49,6 +97,26 @@ class AsyncLog {
    * @return True if the file is ready to use. False otherwise.
    */
   bool openFile();
+
+  /**
+   * @return  The line to append to the asynclog for a 'delete' entry.
+   */
+  std::string formatDelete(
+      const AccessPoint& ap,
+      folly::StringPiece key,
+      folly::StringPiece poolName,
+      std::unordered_map<std::string, uint64_t> attributes) const;
+
+  /**
+   * @return  `n` entries encoded in the configured format, ready to be
+   *          appended with a single write.
+   */
+  std::string encode(PendingDelete* const* entries, size_t n);
+
+  /**
+   * Writes out and completes everything in pending_. Runs on the writer.
+   */
+  void writePending();
 };
 } // namespace mcrouter
 } // namespace memcache
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "AsyncLogSpool.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Varint.h>
+#include <folly/io/IOBuf.h>
+#include <folly/lang/Bits.h>
+
+#include "mcrouter/lib/Compression.h"
+#include "mcrouter/lib/fbi/hash.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr uint32_t kBlockMagic = 0x4b424c41; // "ALBK"
+constexpr size_t kBlockHeaderSize = 6 * sizeof(uint32_t);
+// Sanity limit, way above any batch the writer produces.
+constexpr uint32_t kMaxBlockSize = 256 << 20;
+
+enum class SpoolCodec : uint32_t {
+  kNone = 0,
+  kLz4 = 1,
+};
+
+std::unique_ptr<CompressionCodec> createLz4Codec() {
+  return createCompressionCodec(
+      CompressionCodecType::LZ4, folly::IOBuf::create(0), /* id */ 0);
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto len = folly::encodeVarint(value, buf);
+  out.append(reinterpret_cast<const char*>(buf), len);
+}
+
+void appendString(std::string& out, folly::StringPiece s) {
+  appendVarint(out, s.size());
+  out.append(s.data(), s.size());
+}
+
+void appendUint32(std::string& out, uint32_t value) {
+  value = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+uint32_t readUint32(const char* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return folly::Endian::little(value);
+}
+
+uint64_t decodeVarint(folly::ByteRange& range) {
+  auto value = folly::tryDecodeVarint(range);
+  if (!value) {
+    throw std::runtime_error("asynclog spool: malformed varint");
+  }
+  return *value;
+}
+
+std::string decodeString(folly::ByteRange& range) {
+  auto len = decodeVarint(range);
+  if (len > range.size()) {
+    throw std::runtime_error("asynclog spool: string out of bounds");
+  }
+  std::string s(reinterpret_cast<const char*>(range.data()), len);
+  range.advance(len);
+  return s;
+}
+
+uint64_t readVarintFromFd(int fd) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  for (size_t i = 0; i < sizeof(buf); ++i) {
+    if (folly::readFull(fd, &buf[i], 1) != 1) {
+      throw std::runtime_error("asynclog spool: truncated file header");
+    }
+    if (!(buf[i] & 0x80)) {
+      folly::ByteRange range(buf, i + 1);
+      return decodeVarint(range);
+    }
+  }
+  throw std::runtime_error("asynclog spool: malformed file header");
+}
+
+std::string readStringFromFd(int fd) {
+  auto len = readVarintFromFd(fd);
+  if (len > kMaxBlockSize) {
+    throw std::runtime_error("asynclog spool: malformed file header");
+  }
+  std::string s(len, '\0');
+  if (folly::readFull(fd, &s[0], len) != static_cast<ssize_t>(len)) {
+    throw std::runtime_error("asynclog spool: truncated file header");
+  }
+  return s;
+}
+
+} // namespace
+
+AsyncLogSpoolWriter::AsyncLogSpoolWriter(bool compress)
+    : codec_(compress ? createLz4Codec() : nullptr) {}
+
+AsyncLogSpoolWriter::~AsyncLogSpoolWriter() = default;
+
+std::string AsyncLogSpoolWriter::fileHeader(
+    folly::StringPiece service,
+    folly::StringPiece flavor,
+    folly::StringPiece region) {
+  std::string header = kFileMagic.str();
+  appendString(header, service);
+  appendString(header, flavor);
+  appendString(header, region);
+  return header;
+}
+
+void AsyncLogSpoolWriter::add(
+    int64_t timestampMs,
+    folly::StringPiece host,
+    uint16_t port,
+    folly::StringPiece pool,
+    folly::StringPiece key,
+    const std::unordered_map<std::string, uint64_t>& attributes) {
+  appendVarint(payload_, timestampMs);
+  appendString(payload_, host);
+  appendVarint(payload_, port);
+  appendString(payload_, pool);
+  appendString(payload_, key);
+  appendVarint(payload_, attributes.size());
+  for (const auto& it : attributes) {
+    appendString(payload_, it.first);
+    appendVarint(payload_, it.second);
+  }
+  ++numEntries_;
+}
+
+std::string AsyncLogSpoolWriter::finishBlock() {
+  auto codec = SpoolCodec::kNone;
+  std::unique_ptr<folly::IOBuf> compressed;
+  if (codec_ && !payload_.empty()) {
+    compressed = codec_->compress(payload_.data(), payload_.size());
+    compressed->coalesce();
+    if (compressed->length() < payload_.size()) {
+      codec = SpoolCodec::kLz4;
+    }
+  }
+  folly::StringPiece stored = codec == SpoolCodec::kLz4
+      ? folly::StringPiece(
+            reinterpret_cast<const char*>(compressed->data()),
+            compressed->length())
+      : folly::StringPiece(payload_);
+
+  std::string block;
+  block.reserve(kBlockHeaderSize + stored.size());
+  appendUint32(block, kBlockMagic);
+  appendUint32(block, stored.size());
+  appendUint32(block, payload_.size());
+  appendUint32(block, numEntries_);
+  appendUint32(block, crc32_hash(stored.data(), stored.size()));
+  appendUint32(block, static_cast<uint32_t>(codec));
+  block.append(stored.data(), stored.size());
+
+  payload_.clear();
+  numEntries_ = 0;
+  return block;
+}
+
+AsyncLogSpoolReader::AsyncLogSpoolReader(int fd) : fd_(fd) {
+  char magic[AsyncLogSpoolWriter::kFileMagic.size()];
+  if (folly::readFull(fd_, magic, sizeof(magic)) !=
+          static_cast<ssize_t>(sizeof(magic)) ||
+      folly::StringPiece(magic, sizeof(magic)) !=
+          AsyncLogSpoolWriter::kFileMagic) {
+    throw std::runtime_error("asynclog spool: not a spool file");
+  }
+  service_ = readStringFromFd(fd_);
+  flavor_ = readStringFromFd(fd_);
+  region_ = readStringFromFd(fd_);
+}
+
+AsyncLogSpoolReader::~AsyncLogSpoolReader() = default;
+
+bool AsyncLogSpoolReader::readBlock() {
+  char header[kBlockHeaderSize];
+  auto n = folly::readFull(fd_, header, sizeof(header));
+  if (n != static_cast<ssize_t>(sizeof(header))) {
+    return false;
+  }
+  if (readUint32(header) != kBlockMagic) {
+    throw std::runtime_error("asynclog spool: bad block magic");
+  }
+  auto storedSize = readUint32(header + 4);
+  auto rawSize = readUint32(header + 8);
+  auto numEntries = readUint32(header + 12);
+  auto checksum = readUint32(header + 16);
+  auto codec = static_cast<SpoolCodec>(readUint32(header + 20));
+  if (storedSize > kMaxBlockSize || rawSize > kMaxBlockSize) {
+    throw std::runtime_error("asynclog spool: block too large");
+  }
+
+  block_.resize(storedSize);
+  n = folly::readFull(fd_, &block_[0], storedSize);
+  if (n != static_cast<ssize_t>(storedSize)) {
+    return false;
+  }
+  if (crc32_hash(block_.data(), block_.size()) != checksum) {
+    throw std::runtime_error("asynclog spool: block checksum mismatch");
+  }
+
+  switch (codec) {
+    case SpoolCodec::kNone:
+      break;
+    case SpoolCodec::kLz4: {
+      if (!codec_) {
+        codec_ = createLz4Codec();
+      }
+      auto raw = codec_->uncompress(block_.data(), block_.size(), rawSize);
+      raw->coalesce();
+      block_.assign(reinterpret_cast<const char*>(raw->data()), raw->length());
+      break;
+    }
+    default:
+      throw std::runtime_error(folly::to<std::string>(
+          "asynclog spool: unknown codec ", static_cast<uint32_t>(codec)));
+  }
+  if (block_.size() != rawSize) {
+    throw std::runtime_error("asynclog spool: block size mismatch");
+  }
+
+  remaining_ = folly::ByteRange(folly::StringPiece(block_));
+  entriesLeft_ = numEntries;
+  return true;
+}
+
+bool AsyncLogSpoolReader::next(AsyncLogSpoolEntry& entry) {
+  while (entriesLeft_ == 0) {
+    if (!readBlock()) {
+      return false;
+    }
+  }
+
+  entry.timestampMs = decodeVarint(remaining_);
+  entry.host = decodeString(remaining_);
+  entry.port = decodeVarint(remaining_);
+  entry.pool = decodeString(remaining_);
+  entry.key = decodeString(remaining_);
+  auto numAttributes = decodeVarint(remaining_);
+  entry.attributes.clear();
+  for (uint64_t i = 0; i < numAttributes; ++i) {
+    auto name = decodeString(remaining_);
+    entry.attributes.emplace_back(std::move(name), decodeVarint(remaining_));
+  }
+  --entriesLeft_;
+  return true;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
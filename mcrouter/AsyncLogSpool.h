@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+class CompressionCodec;
+
+namespace mcrouter {
+
+/**
+ * Binary asynclog spool format (--asynclog-binary).
+ *
+ *   file   := "MCSPOOL1" string(service) string(flavor) string(region) block*
+ *   block  := header payload
+ *   header := uint32 "ALBK", uint32 payload size, uint32 uncompressed size,
+ *             uint32 number of entries, uint32 crc32 of payload,
+ *             uint32 codec (0: none, 1: LZ4)          (all little endian)
+ *   entry  := varint(timestamp ms) string(host) varint(port) string(pool)
+ *             string(key) varint(#attributes) (string(name) varint(value))*
+ *   string := varint(length) bytes
+ *
+ * The payload of a block is its entries, possibly compressed. Every block is
+ * checksummed on its own and written with a single write, so a crash can only
+ * leave a truncated last block behind.
+ */
+struct AsyncLogSpoolEntry {
+  int64_t timestampMs{0};
+  std::string host;
+  uint16_t port{0};
+  std::string pool;
+  std::string key;
+  std::vector<std::pair<std::string, uint64_t>> attributes;
+};
+
+/**
+ * Encodes entries into spool blocks. Not thread-safe.
+ */
+class AsyncLogSpoolWriter {
+ public:
+  static constexpr folly::StringPiece kFileMagic{"MCSPOOL1"};
+
+  explicit AsyncLogSpoolWriter(bool compress);
+  ~AsyncLogSpoolWriter();
+
+  /**
+   * @return  The header to write at the start of every spool file.
+   */
+  static std::string fileHeader(
+      folly::StringPiece service,
+      folly::StringPiece flavor,
+      folly::StringPiece region);
+
+  void add(
+      int64_t timestampMs,
+      folly::StringPiece host,
+      uint16_t port,
+      folly::StringPiece pool,
+      folly::StringPiece key,
+      const std::unordered_map<std::string, uint64_t>& attributes);
+
+  size_t numEntries() const {
+    return numEntries_;
+  }
+
+  /**
+   * @return  A block with all entries added since the last call.
+   */
+  std::string finishBlock();
+
+ private:
+  std::unique_ptr<CompressionCodec> codec_;
+  std::string payload_;
+  size_t numEntries_{0};
+};
+
+/**
+ * Streams the entries of a spool file, one block at a time.
+ */
+class AsyncLogSpoolReader {
+ public:
+  /**
+   * @param fd  File to read, positioned at its start. Not owned.
+   *
+   * @throws std::runtime_error if the file is not a spool file.
+   */
+  explicit AsyncLogSpoolReader(int fd);
+  ~AsyncLogSpoolReader();
+
+  folly::StringPiece service() const {
+    return service_;
+  }
+  folly::StringPiece flavor() const {
+    return flavor_;
+  }
+  folly::StringPiece region() const {
+    return region_;
+  }
+
+  /**
+   * Reads the next entry.
+   *
+   * @return  false at the end of file. A truncated last block (e.g. after a
+   *          crash while writing it) is treated as the end of file.
+   *
+   * @throws std::runtime_error if a block is corrupted.
+   */
+  bool next(AsyncLogSpoolEntry& entry);
+
+ private:
+  const int fd_;
+  std::unique_ptr<CompressionCodec> codec_;
+  std::string service_;
+  std::string flavor_;
+  std::string region_;
+
+  std::string block_;
+  folly::ByteRange remaining_;
+  size_t entriesLeft_{0};
+
+  bool readBlock();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "AxonBatcher.h"
+
+#include <algorithm>
+
+#include <folly/Conv.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/invalidation/McInvalidationKvPairs.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+AxonBatcher::AxonBatcher(ProxyBase& proxy, Options opts)
+    : proxy_(proxy), opts_(std::move(opts)) {}
+
+bool AxonBatcher::write(
+    const std::shared_ptr<AxonContext>& axonCtx,
+    uint64_t bucketId,
+    std::optional<std::string> region,
+    std::optional<std::string> pool,
+    std::string key,
+    std::string serialized) {
+  if (opts_.maxPendingKeys != 0 && pendingKeys_ >= opts_.maxPendingKeys) {
+    proxy_.stats().increment(axon_batch_rejected_keys_stat);
+    return false;
+  }
+
+  // Region and pool are never empty strings when set.
+  auto destination = folly::to<std::string>(
+      reinterpret_cast<uintptr_t>(axonCtx.get()),
+      '\n',
+      bucketId,
+      '\n',
+      region.value_or(""),
+      '\n',
+      pool.value_or(""));
+
+  auto& batch = batches_[destination];
+  if (!batch) {
+    batch = std::make_shared<Batch>();
+    batch->axonCtx = axonCtx;
+    batch->bucketId = bucketId;
+    batch->region = std::move(region);
+    batch->pool = std::move(pool);
+    folly::fibers::addTask([this, destination, b = batch]() {
+      folly::fibers::Baton timer;
+      timer.try_wait_for(opts_.window);
+      auto it = batches_.find(destination);
+      if (it != batches_.end() && it->second == b) {
+        flush(destination, b);
+      }
+    });
+  }
+  auto b = batch;
+
+  if (b->keys.insert(std::move(key)).second) {
+    ++pendingKeys_;
+    b->bytes += serialized.size();
+    b->serialized.push_back(std::move(serialized));
+  } else {
+    proxy_.stats().increment(axon_batch_deduped_keys_stat);
+  }
+
+  if (b->serialized.size() >= std::max<size_t>(opts_.maxKeys, 1) ||
+      (opts_.maxBytes != 0 && b->bytes >= opts_.maxBytes)) {
+    flush(destination, b);
+    return b->written;
+  }
+  folly::fibers::Baton baton;
+  b->waiters.push_back(&baton);
+  baton.wait();
+  return b->written;
+}
+
+void AxonBatcher::flush(
+    const std::string& destination,
+    const std::shared_ptr<Batch>& b) {
+  // No more keys may join the batch once its write started.
+  batches_.erase(destination);
+
+  auto kvPairs = folly::fibers::runInMainContext([this, &b]() {
+    return invalidation::McInvalidationKvPairs::createAxonBatchKvPairs(
+        b->serialized, b->region, b->pool, std::nullopt, opts_.compress);
+  });
+  b->written = b->axonCtx->writeProxyFn(b->bucketId, std::move(kvPairs));
+  pendingKeys_ -= b->serialized.size();
+  proxy_.stats().increment(axon_batch_writes_stat);
+
+  for (auto* waiter : b->waiters) {
+    waiter->post();
+  }
+  b->waiters.clear();
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <folly/fibers/Baton.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyBase;
+
+/**
+ * Coalesces the invalidations a proxy writes to the Axon proxy service.
+ *
+ * Deletes going to the same bucket, region and pool within `window` are
+ * written as a single record (see
+ * McInvalidationKvPairs::createAxonBatchKvPairs), with every key only once,
+ * optionally LZ4 compressed. A batch is written as soon as it has `maxKeys`
+ * keys or `maxBytes` bytes of serialized deletes.
+ *
+ * write() blocks the calling fiber until its batch is written, and returns
+ * the result of the write, so callers can still fall back to asynclog when a
+ * batch fails. When `maxPendingKeys` keys are already waiting for their
+ * batches to be written (e.g. because a whole region is unreachable and every
+ * write waits for its timeout), write() fails right away instead, sending
+ * the delete to asynclog without queueing behind the others.
+ *
+ * Not thread safe, must only be used from the proxy's fibers.
+ */
+class AxonBatcher {
+ public:
+  struct Options {
+    std::chrono::microseconds window{0};
+    size_t maxKeys{100};
+    // 0 means no limit.
+    size_t maxBytes{0};
+    // 0 means no limit.
+    size_t maxPendingKeys{0};
+    bool compress{false};
+  };
+
+  AxonBatcher(ProxyBase& proxy, Options opts);
+
+  /**
+   * @param key         Key of the delete, used to dedup the batch.
+   * @param serialized  Serialized delete request.
+   *
+   * @return  true if the batch containing the delete was written, false if
+   *          it failed or too many deletes were already pending.
+   */
+  bool write(
+      const std::shared_ptr<AxonContext>& axonCtx,
+      uint64_t bucketId,
+      std::optional<std::string> region,
+      std::optional<std::string> pool,
+      std::string key,
+      std::string serialized);
+
+ private:
+  struct Batch {
+    std::shared_ptr<AxonContext> axonCtx;
+    uint64_t bucketId;
+    std::optional<std::string> region;
+    std::optional<std::string> pool;
+
+    folly::F14FastSet<std::string> keys;
+    std::vector<std::string> serialized;
+    size_t bytes{0};
+    // Fibers waiting for the batch to be written
+    std::vector<folly::fibers::Baton*> waiters;
+    bool written{false};
+  };
+
+  ProxyBase& proxy_;
+  const Options opts_;
+
+  // Keys in batches that are not written yet, including the ones being
+  // written.
+  size_t pendingKeys_{0};
+
+  // Batches not written yet, by destination
+  folly::F14FastMap<std::string, std::shared_ptr<Batch>> batches_;
+
+  void flush(const std::string& destination, const std::shared_ptr<Batch>& b);
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
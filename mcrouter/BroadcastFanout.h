@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+#include <folly/Format.h>
+#include <folly/fibers/Baton.h>
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/carbon/Result.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Progress of a request sent to every destination of the config (i.e.
+ * flush_all), shared by the proxies it is spread across: with
+ * broadcast_spread_proxies, proxy i sends it to every numSlices()-th
+ * destination starting from the i-th one (see ProxyRoute).
+ *
+ * Results may be added from any proxy thread.
+ */
+class BroadcastFanout {
+ public:
+  explicit BroadcastFanout(size_t numSlices)
+      : numSlices_(numSlices), remainingSlices_(numSlices) {}
+
+  BroadcastFanout(const BroadcastFanout&) = delete;
+  BroadcastFanout& operator=(const BroadcastFanout&) = delete;
+
+  size_t numSlices() const {
+    return numSlices_;
+  }
+
+  /**
+   * Records the reply of one destination.
+   */
+  void addResult(carbon::Result result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++numSent_;
+    if (isErrorResult(result)) {
+      ++numFailed_;
+    }
+    if (!hasResult_ || worseThan(result, worstResult_)) {
+      worstResult_ = result;
+      hasResult_ = true;
+    }
+  }
+
+  /**
+   * Records a slice that couldn't be sent at all, e.g. because the proxy
+   * it was given to rejected it.
+   */
+  void addSliceError(carbon::Result result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++numFailedSlices_;
+    if (!hasResult_ || worseThan(result, worstResult_)) {
+      worstResult_ = result;
+      hasResult_ = true;
+    }
+  }
+
+  /**
+   * Must be called once per slice, after all of its results were added.
+   */
+  void sliceDone() {
+    if (remainingSlices_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      baton_.post();
+    }
+  }
+
+  /**
+   * Waits (on the calling fiber) for all slices to be done.
+   */
+  void wait() {
+    baton_.wait();
+  }
+
+  /**
+   * The "most awful" reply of all destinations, with a message telling how
+   * many failed if any did. Only valid once wait() returned.
+   */
+  template <class Reply>
+  Reply reply() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Reply reply(hasResult_ ? worstResult_ : carbon::Result::OK);
+    if (numFailedSlices_ != 0) {
+      carbon::setMessageIfPresent(
+          reply,
+          folly::sformat(
+              "{} of {} destinations failed, {} of {} proxies didn't send it",
+              numFailed_,
+              numSent_,
+              numFailedSlices_,
+              numSlices_));
+    } else if (numFailed_ != 0) {
+      carbon::setMessageIfPresent(
+          reply,
+          folly::sformat("{} of {} destinations failed", numFailed_, numSent_));
+    }
+    return reply;
+  }
+
+ private:
+  const size_t numSlices_;
+  std::atomic<size_t> remainingSlices_;
+  folly::fibers::Baton baton_;
+
+  mutable std::mutex mutex_;
+  size_t numSent_{0};
+  size_t numFailed_{0};
+  size_t numFailedSlices_{0};
+  carbon::Result worstResult_{carbon::Result::UNKNOWN};
+  bool hasResult_{false};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cassert>
 
 #include "mcrouter/CarbonRouterInstance.h"
@@ -99,9 +100,8 @@ bool CarbonRouterClient<RouterInfo>::send(
     const Request& req,
     F&& callback,
     folly::StringPiece ipAddr) {
-  auto makePreq = [this, ipAddr, &req, &callback](bool inBatch) mutable {
-    return makeProxyRequestContext(
-        req, std::forward<F>(callback), ipAddr, inBatch);
+  auto makePreq = [this, ipAddr, &req, &callback]() mutable {
+    return makeProxyRequestContext(req, std::forward<F>(callback), ipAddr);
   };
 
   auto cancelRemaining = [&req, &callback]() {
@@ -111,6 +111,44 @@ bool CarbonRouterClient<RouterInfo>::send(
   return sendMultiImpl(1, std::move(makePreq), std::move(cancelRemaining));
 }
 
+template <class RouterInfo>
+template <class Request, class F>
+typename CarbonRouterClient<RouterInfo>::TrySendResult
+CarbonRouterClient<RouterInfo>::trySend(
+    const Request& req,
+    F&& callback,
+    folly::StringPiece ipAddr) {
+  auto router = router_.lock();
+  if (FOLLY_UNLIKELY(!router)) {
+    return TrySendResult::kError;
+  }
+
+  uint64_t routingHint = 0;
+  auto& proxy = selectProxy(req, routingHint);
+  // Checked before writing rather than with a non-blocking write, since a
+  // request context can't be dropped once created. The write below can
+  // still block, but only if more writers than there is room above the
+  // watermark race past the check at once.
+  if (mode_ != ThreadMode::SameThread &&
+      proxy.messageQueue_->size() >= queueWatermark_) {
+    proxy.stats().incrementSafe(client_queue_backpressure_stat);
+    return TrySendResult::kBackpressure;
+  }
+  if (maxOutstanding() != 0 &&
+      counting_sem_lazy_nonblocking(outstandingReqsSem(), 1) == 0) {
+    return TrySendResult::kQuotaExceeded;
+  }
+
+  auto preq = makeProxyRequestContext(
+      proxy, routingHint, req, std::forward<F>(callback), ipAddr);
+  if (mode_ == ThreadMode::SameThread) {
+    sendSameThread(std::move(preq));
+  } else {
+    sendRemoteThread(std::move(preq), /* skipNotification */ false);
+  }
+  return TrySendResult::kSent;
+}
+
 template <class RouterInfo>
 template <class F, class G>
 bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
@@ -122,36 +160,13 @@ bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
     return false;
   }
 
-  auto notify = [this]() {
-    assert(mode_ != ThreadMode::SameThread);
-    if (mode_ == ThreadMode::FixedRemoteThread) {
-      proxies_[proxyIdx_]->messageQueue_->notifyRelaxed();
-    } else {
-      assert(mode_ == ThreadMode::AffinitizedRemoteThread);
-      size_t i = 0;
-      for (const auto& p : proxies_) {
-        if (proxiesToNotify_[i]) {
-          p->messageQueue_->notifyRelaxed();
-          proxiesToNotify_[i] = false;
-        }
-        ++i;
-      }
-    }
-  };
-
   if (maxOutstanding() == 0) {
     if (mode_ == ThreadMode::SameThread) {
       for (size_t i = 0; i < nreqs; ++i) {
-        sendSameThread(makeNextPreq(/* inBatch */ false));
+        sendSameThread(makeNextPreq());
       }
     } else {
-      bool delayNotification = shouldDelayNotification(nreqs);
-      for (size_t i = 0; i < nreqs; ++i) {
-        sendRemoteThread(makeNextPreq(delayNotification), delayNotification);
-      }
-      if (delayNotification) {
-        notify();
-      }
+      sendRemoteThreadBatch(nreqs, makeNextPreq);
     }
   } else if (maxOutstandingError()) {
     for (size_t begin = 0; begin < nreqs;) {
@@ -164,16 +179,10 @@ bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
 
       if (mode_ == ThreadMode::SameThread) {
         for (size_t i = begin; i < end; i++) {
-          sendSameThread(makeNextPreq(/*  inBatch */ false));
+          sendSameThread(makeNextPreq());
         }
       } else {
-        bool delayNotification = shouldDelayNotification(end - begin);
-        for (size_t i = begin; i < end; i++) {
-          sendRemoteThread(makeNextPreq(delayNotification), delayNotification);
-        }
-        if (delayNotification) {
-          notify();
-        }
+        sendRemoteThreadBatch(end - begin, makeNextPreq);
       }
 
       begin = end;
@@ -186,13 +195,7 @@ bool CarbonRouterClient<RouterInfo>::sendMultiImpl(
 
     while (i < nreqs) {
       n += counting_sem_lazy_wait(outstandingReqsSem(), nreqs - n);
-      bool delayNotification = shouldDelayNotification(n);
-      for (size_t j = i; j < n; ++j) {
-        sendRemoteThread(makeNextPreq(delayNotification), delayNotification);
-      }
-      if (delayNotification) {
-        notify();
-      }
+      sendRemoteThreadBatch(n - i, makeNextPreq);
       i = n;
     }
   }
@@ -244,7 +247,7 @@ CarbonRouterClient<RouterInfo>::findAffinitizedProxyIdx(
     config.second.proxyRoute().traverse(req, t);
   }
 
-  return {hash % proxies_.size(), hint};
+  return {hash % proxies_[proxyIdx_]->router().activeProxies(), hint};
 }
 
 template <class RouterInfo>
@@ -258,6 +261,27 @@ CarbonRouterClient<RouterInfo>::findAffinitizedProxyIdx(
   return {0, 0};
 }
 
+template <class RouterInfo>
+template <class Request>
+typename std::enable_if<HasKeyTrait<Request>::value, size_t>::type
+CarbonRouterClient<RouterInfo>::findKeyAffinitizedProxyIdx(
+    const Request& req) const {
+  assert(mode_ == ThreadMode::KeyAffinitizedRemoteThread);
+  // Contiguous ranges of the 32 bit hash rather than a modulo, so that
+  // changing the number of active proxies only moves part of the keys.
+  const uint64_t hash = req.key_ref()->routingKeyHash();
+  return (hash * proxies_[proxyIdx_]->router().activeProxies()) >> 32;
+}
+
+template <class RouterInfo>
+template <class Request>
+typename std::enable_if<!HasKeyTrait<Request>::value, size_t>::type
+CarbonRouterClient<RouterInfo>::findKeyAffinitizedProxyIdx(
+    const Request& /* unused */) const {
+  assert(mode_ == ThreadMode::KeyAffinitizedRemoteThread);
+  return proxyIdx_;
+}
+
 template <class RouterInfo>
 template <class InputIt, class F>
 bool CarbonRouterClient<RouterInfo>::send(
@@ -269,9 +293,9 @@ bool CarbonRouterClient<RouterInfo>::send(
   using Request = typename std::decay<decltype(detail::unwrapRequest(
       std::declval<IterReference>()))>::type;
 
-  auto makeNextPreq = [this, ipAddr, &callback, &begin](bool inBatch) {
-    auto proxyRequestContext = makeProxyRequestContext(
-        detail::unwrapRequest(*begin), callback, ipAddr, inBatch);
+  auto makeNextPreq = [this, ipAddr, &callback, &begin]() {
+    auto proxyRequestContext =
+        makeProxyRequestContext(detail::unwrapRequest(*begin), callback, ipAddr);
     ++begin;
     return proxyRequestContext;
   };
@@ -307,6 +331,86 @@ void CarbonRouterClient<RouterInfo>::sendRemoteThread(
   }
 }
 
+template <class RouterInfo>
+template <class F>
+void CarbonRouterClient<RouterInfo>::sendRemoteThreadBatch(
+    size_t nreqs,
+    F& makeNextPreq) {
+  if (nreqs == 1) {
+    sendRemoteThread(makeNextPreq(), /* skipNotification */ false);
+    return;
+  }
+
+  // Group requests by destination proxy, so that every proxy gets a single
+  // queue write and a single notification for the whole batch.
+  for (size_t i = 0; i < nreqs; ++i) {
+    auto preq = makeNextPreq();
+    auto& batch = pendingBatches_[preq->proxyWithRouterInfo().getId()];
+    if (!batch) {
+      batch = std::make_unique<ProxyRequestBatch>();
+      batch->requests.reserve(nreqs - i);
+    }
+    batch->requests.push_back(preq.release());
+  }
+
+  for (size_t i = 0; i < pendingBatches_.size(); ++i) {
+    auto batch = std::move(pendingBatches_[i]);
+    if (!batch) {
+      continue;
+    }
+    auto& queue = *proxies_[i]->messageQueue_;
+    if (batch->requests.size() == 1) {
+      queue.blockingWriteNoNotify(
+          ProxyMessage::Type::REQUEST, batch->requests.front());
+    } else {
+      queue.blockingWriteNoNotify(
+          ProxyMessage::Type::REQUEST_BATCH, batch.release());
+    }
+    queue.notifyRelaxed();
+  }
+}
+
+template <class RouterInfo>
+template <class Request, class Reply, class CallbackFunc>
+void CarbonRouterClient<RouterInfo>::deliverReply(
+    CallbackFunc& cb,
+    const Request& request,
+    Reply&& reply) {
+  if (disconnected_) {
+    // "Cancelled" reply.
+    cb(request, ReplyT<Request>(carbon::Result::UNKNOWN));
+  } else {
+    cb(request, std::move(reply));
+  }
+}
+
+template <class RouterInfo>
+void CarbonRouterClient<RouterInfo>::deferReply(
+    ProxyRequestContext& ctx,
+    folly::Function<void()> reply) {
+  const auto proxyId = ctx.proxy().getId();
+  auto& batch = replyBatches_[proxyId];
+  batch.replies.push_back(std::move(reply));
+  if (batch.self == nullptr) {
+    batch.self = ctx.requester();
+    proxies_[proxyId]->eventBase().getEventBase().runInLoop(
+        [this, proxyId]() { flushReplies(proxyId); });
+  }
+}
+
+template <class RouterInfo>
+void CarbonRouterClient<RouterInfo>::flushReplies(size_t proxyId) {
+  auto& batch = replyBatches_[proxyId];
+  auto replies = std::move(batch.replies);
+  batch.replies.clear();
+  replyEventBase_->runInEventBaseThread(
+      [self = std::move(batch.self), replies = std::move(replies)]() mutable {
+        for (auto& reply : replies) {
+          reply();
+        }
+      });
+}
+
 template <class RouterInfo>
 void CarbonRouterClient<RouterInfo>::sendSameThread(
     std::unique_ptr<ProxyRequestContextWithInfo<RouterInfo>> req) {
@@ -324,7 +428,15 @@ CarbonRouterClient<RouterInfo>::CarbonRouterClient(
       router_(router),
       mode_(mode),
       proxies_(router->getProxies()),
-      proxiesToNotify_(proxies_.size(), false) {
+      queueWatermark_(
+          router->opts().client_queue_backpressure_watermark != 0
+              ? std::min(
+                    router->opts().client_queue_backpressure_watermark,
+                    router->opts().client_queue_size)
+              : std::max<size_t>(
+                    router->opts().client_queue_size * 3 / 4, 1)),
+      pendingBatches_(proxies_.size()),
+      replyBatches_(proxies_.size()) {
   // If the mode is SameThread, make sure to match the current EventBase with
   // the corresponding Proxy EventBase. This has the requirement that create
   // is called from an EventBase that's currently a Proxy EventBase.
@@ -364,9 +476,24 @@ CarbonRouterClient<RouterInfo>::~CarbonRouterClient() {
 }
 
 template <class RouterInfo>
-bool CarbonRouterClient<RouterInfo>::shouldDelayNotification(
-    size_t batchSize) const {
-  return mode_ != ThreadMode::SameThread && batchSize > 1;
+template <class Request>
+Proxy<RouterInfo>& CarbonRouterClient<RouterInfo>::selectProxy(
+    const Request& req,
+    uint64_t& routingHint) {
+  if (mode_ != ThreadMode::SameThread &&
+      proxyIdx_ >= proxies_[proxyIdx_]->router().activeProxies()) {
+    // The proxy was retired, see CarbonRouterInstanceBase::setActiveProxies().
+    proxyIdx_ = proxies_[proxyIdx_]->router().nextProxyIndex();
+  }
+  if (mode_ == ThreadMode::AffinitizedRemoteThread) {
+    auto [idx, hint] = findAffinitizedProxyIdx(req);
+    routingHint = hint;
+    return *proxies_[idx];
+  }
+  if (mode_ == ThreadMode::KeyAffinitizedRemoteThread) {
+    return *proxies_[findKeyAffinitizedProxyIdx(req)];
+  }
+  return *proxies_[proxyIdx_];
 }
 
 template <class RouterInfo>
@@ -375,39 +502,62 @@ std::unique_ptr<ProxyRequestContextWithInfo<RouterInfo>>
 CarbonRouterClient<RouterInfo>::makeProxyRequestContext(
     const Request& req,
     CallbackFunc&& callback,
-    folly::StringPiece ipAddr,
-    bool inBatch) {
-  Proxy<RouterInfo>* proxy = proxies_[proxyIdx_];
+    folly::StringPiece ipAddr) {
   uint64_t routingHint = 0;
-  if (mode_ == ThreadMode::AffinitizedRemoteThread) {
-    auto [idx, hint] = findAffinitizedProxyIdx(req);
-    routingHint = hint;
-    proxy = proxies_[idx];
-    if (inBatch) {
-      proxiesToNotify_[idx] = true;
-    }
-  }
+  auto& proxy = selectProxy(req, routingHint);
+  return makeProxyRequestContext(
+      proxy,
+      routingHint,
+      req,
+      std::forward<CallbackFunc>(callback),
+      ipAddr);
+}
+
+template <class RouterInfo>
+template <class Request, class CallbackFunc>
+std::unique_ptr<ProxyRequestContextWithInfo<RouterInfo>>
+CarbonRouterClient<RouterInfo>::makeProxyRequestContext(
+    Proxy<RouterInfo>& proxy,
+    uint64_t routingHint,
+    const Request& req,
+    CallbackFunc&& callback,
+    folly::StringPiece ipAddr) {
   auto proxyRequestContext = createProxyRequestContext(
-      *proxy,
+      proxy,
       req,
       [this, cb = std::forward<CallbackFunc>(callback)](
-          auto& /* reqCtx */,
+          auto& reqCtx,
           const Request& request,
           ReplyT<Request>&& reply) mutable {
         detail::bumpCarbonRouterClientStats(stats_, request, reply);
-        if (disconnected_) {
-          // "Cancelled" reply.
-          cb(request, ReplyT<Request>(carbon::Result::UNKNOWN));
-        } else {
-          cb(request, std::move(reply));
+        if (replyEventBase_ != nullptr) {
+          deferReply(
+              reqCtx,
+              [this,
+               cb = std::move(cb),
+               &request,
+               reply = std::move(reply)]() mutable {
+                deliverReply(cb, request, std::move(reply));
+              });
+          return;
         }
-      });
+        deliverReply(cb, request, std::move(reply));
+      },
+      priority_);
 
   if (routingHint) {
     proxyRequestContext->setRoutingHint(routingHint);
   }
 
   proxyRequestContext->setRequester(self_);
+  if (timeoutBudget_.count() > 0) {
+    proxyRequestContext->setDeadlineUs(nowUs() + timeoutBudget_.count() * 1000);
+  }
+  if (clientGone_) {
+    proxyRequestContext->setClientGone(clientGone_);
+  }
+  proxyRequestContext->setClientId(clientId_);
+  proxyRequestContext->setClientName(clientName_);
   if (!ipAddr.empty()) {
     proxyRequestContext->setUserIpAddress(ipAddr);
   }
@@ -7,13 +7,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <folly/Function.h>
 #include <folly/IntrusiveList.h>
 #include <folly/Range.h>
 
 #include "mcrouter/CarbonRouterClientBase.h"
+#include "mcrouter/ProxyRequestPriority.h"
 #include "mcrouter/lib/CacheClientStats.h"
 #include "mcrouter/lib/fbi/cpp/TypeList.h"
 #include "mcrouter/lib/mc/msg.h"
+#include "mcrouter/lib/network/MessageHelpers.h"
 
 namespace facebook {
 namespace memcache {
@@ -31,6 +39,20 @@ class ProxyRequestContext;
 template <class RouterInfo>
 class ProxyRequestContextWithInfo;
 
+struct ProxyRequestBatch;
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
+
+namespace folly {
+class EventBase;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
 /**
  * A mcrouter client is used to communicate with a mcrouter instance.
  * Typically a client is long lived. Request sent through a single client
@@ -73,6 +95,24 @@ class CarbonRouterClient : public CarbonRouterClientBase {
     // Routes the request deterministically, chosen at routing time, with the
     // goal to reduce the number of connections between client and server.
     AffinitizedRemoteThread,
+
+    // Routes the request in the proxy thread owning the hash range of its
+    // routing key, so that the per-proxy state of a key (near cache,
+    // coalescing, warm connections) lives in a single proxy.
+    KeyAffinitizedRemoteThread,
+  };
+
+  enum class TrySendResult {
+    // The request was scheduled to be sent, the callback will be called.
+    kSent,
+    // The client queue of the proxy is above its watermark (see
+    // client_queue_backpressure_watermark). Nothing was sent.
+    kBackpressure,
+    // maximum_outstanding requests of this client are in flight. Nothing was
+    // sent.
+    kQuotaExceeded,
+    // Nothing was sent, e.g. because the CarbonRouterInstance was destroyed.
+    kError,
   };
 
   /**
@@ -105,6 +145,27 @@ class CarbonRouterClient : public CarbonRouterClientBase {
       F&& callback,
       folly::StringPiece ipAddr = folly::StringPiece());
 
+  /**
+   * Non-blocking version of send(), for callers that would rather shed or
+   * reroute load than wait for mcrouter to catch up.
+   *
+   * Never blocks the calling thread, whatever maximum_outstanding_error was
+   * given on creation: if the client already has maximum_outstanding
+   * requests in flight, or the client queue of the proxy the request would
+   * go to is above its watermark, nothing is sent and the callback is not
+   * called.
+   *
+   * @param req       See send().
+   * @param callback  See send(). Only called if kSent is returned.
+   *
+   * @return  kSent iff the request was scheduled to be sent.
+   */
+  template <class Request, class F>
+  TrySendResult trySend(
+      const Request& req,
+      F&& callback,
+      folly::StringPiece ipAddr = folly::StringPiece());
+
   /**
    * Multi requests version of send.
    *
@@ -139,6 +200,63 @@ class CarbonRouterClient : public CarbonRouterClientBase {
     proxyIdx_ = proxyIdx;
   }
 
+  /**
+   * Priority of all requests sent through this client from now on.
+   * Only matters when proxies queue requests (proxy_max_inflight_requests),
+   * see proxy_critical_priority_weight.
+   */
+  void setPriority(ProxyRequestPriority priority) {
+    priority_ = priority;
+  }
+
+  /**
+   * How long the caller waits for the replies of the requests sent through
+   * this client from now on, 0 if unknown. Once it elapsed, requests are
+   * failed instead of being sent to destinations, and destination timeouts
+   * are clamped to what is left of it.
+   */
+  void setTimeoutBudget(std::chrono::milliseconds budget) {
+    timeoutBudget_ = budget;
+  }
+
+  /**
+   * Flag set once the caller of the requests sent through this client from
+   * now on went away (see McServerSession::clientGone()). Requests still
+   * waiting to be sent are then dropped. nullptr if the caller never does.
+   */
+  void setClientGone(std::shared_ptr<const std::atomic<bool>> clientGone) {
+    clientGone_ = std::move(clientGone);
+  }
+
+  /**
+   * Identity of the caller of the requests sent through this client from
+   * now on (see McServerSession::clientId()), 0 if unknown. Only matters
+   * with proxy_fair_queueing.
+   */
+  void setClientId(uint64_t clientId) {
+    clientId_ = clientId;
+  }
+
+  /**
+   * Name of the caller of the requests sent through this client from now on
+   * (see McServerSession::clientName()), used by per-client accounting.
+   * Empty if unknown. Must stay valid until the replies are delivered.
+   */
+  void setClientName(folly::StringPiece clientName) {
+    clientName_ = clientName;
+  }
+
+  /**
+   * Calls the callbacks of the requests sent through this client on `evb`
+   * instead of on the proxy threads, nullptr to go back to the proxy
+   * threads. The replies a proxy gets in one event loop iteration are
+   * handed over to `evb` together, with a single notification.
+   * Must be set before sending requests, `evb` must outlive them.
+   */
+  void setReplyEventBase(folly::EventBase* evb) {
+    replyEventBase_ = evb;
+  }
+
   CarbonRouterClient(const CarbonRouterClient<RouterInfo>&) = delete;
   CarbonRouterClient(CarbonRouterClient<RouterInfo>&&) noexcept = delete;
   CarbonRouterClient& operator=(const CarbonRouterClient<RouterInfo>&) = delete;
@@ -154,9 +272,26 @@ class CarbonRouterClient : public CarbonRouterClientBase {
   const std::vector<Proxy<RouterInfo>*>& proxies_;
   // The proxy to use when either on FixedRemoteThread or on SameThread mode.
   size_t proxyIdx_{0};
-  // Keeps track of proxies with notification pending.
-  // Only used for multi-request send() calls.
-  std::vector<bool> proxiesToNotify_;
+  // trySend() signals backpressure at this client queue size.
+  const size_t queueWatermark_;
+  ProxyRequestPriority priority_{ProxyRequestPriority::kCritical};
+  std::chrono::milliseconds timeoutBudget_{0};
+  std::shared_ptr<const std::atomic<bool>> clientGone_;
+  uint64_t clientId_{0};
+  folly::StringPiece clientName_;
+  // Per-proxy batches being assembled by a multi-request send() call.
+  // Indexed by proxy id, empty between calls.
+  std::vector<std::unique_ptr<ProxyRequestBatch>> pendingBatches_;
+
+  // Replies waiting to be handed over to replyEventBase_, indexed by proxy
+  // id. A batch is only accessed from the thread of its proxy.
+  struct ReplyBatch {
+    std::vector<folly::Function<void()>> replies;
+    // Keeps the client alive until the batch is delivered.
+    std::shared_ptr<CarbonRouterClientBase> self;
+  };
+  folly::EventBase* replyEventBase_{nullptr};
+  std::vector<ReplyBatch> replyBatches_;
 
   CacheClientStats stats_;
 
@@ -200,6 +335,26 @@ class CarbonRouterClient : public CarbonRouterClientBase {
   void sendSameThread(
       std::unique_ptr<ProxyRequestContextWithInfo<RouterInfo>> req);
 
+  /**
+   * Sends nreqs requests produced by makeNextPreq to their proxies.
+   * Requests going to the same proxy are handed off as a single
+   * REQUEST_BATCH queue element, with one notification per proxy.
+   */
+  template <class F>
+  void sendRemoteThreadBatch(size_t nreqs, F& makeNextPreq);
+
+  /**
+   * Queues `reply` (a callback invocation) to be run on replyEventBase_
+   * with the other replies of the current loop iteration of the proxy.
+   * Must be called from the proxy thread of `ctx`.
+   */
+  void deferReply(ProxyRequestContext& ctx, folly::Function<void()> reply);
+
+  void flushReplies(size_t proxyId);
+
+  template <class Request, class Reply, class CallbackFunc>
+  void deliverReply(CallbackFunc& cb, const Request& request, Reply&& reply);
+
   /**
    * Finds the best proxy to be used to route the request.
    * NOTE: This should only be used when ThreadMode == AffinitizedRemoteThread.
@@ -210,12 +365,35 @@ class CarbonRouterClient : public CarbonRouterClientBase {
       std::pair<uint64_t, uint64_t>>::type
   findAffinitizedProxyIdx(const Request& req) const;
 
+  /**
+   * Index of the active proxy owning the hash range of the routing key of
+   * `req`; the client's own proxy for requests without a key.
+   * NOTE: This should only be used when
+   * ThreadMode == KeyAffinitizedRemoteThread.
+   */
+  template <class Request>
+  typename std::enable_if<HasKeyTrait<Request>::value, size_t>::type
+  findKeyAffinitizedProxyIdx(const Request& req) const;
+
+  template <class Request>
+  typename std::enable_if<!HasKeyTrait<Request>::value, size_t>::type
+  findKeyAffinitizedProxyIdx(const Request& req) const;
+
   template <class Request>
   typename std::enable_if<
       !ListContains<typename RouterInfo::RoutableRequests, Request>::value,
       std::pair<uint64_t, uint64_t>>::type
   findAffinitizedProxyIdx(const Request& req) const;
 
+  /**
+   * The proxy that should route `req`, depending on the thread mode.
+   *
+   * @param routingHint  Set to the routing hint to give to the request, if
+   *                     any.
+   */
+  template <class Request>
+  Proxy<RouterInfo>& selectProxy(const Request& req, uint64_t& routingHint);
+
   /**
    * Creates the ProxyRequestContext that represents the given request.
    *
@@ -223,8 +401,6 @@ class CarbonRouterClient : public CarbonRouterClientBase {
    * @param callback    The callback function to be called once the reply
    *                    is received.
    * @param ipAddr      The ip address of the caller (can be empty).
-   * @param inBatch     Whether or not the given request is part of a batch
-   *                    of requests.
    *
    * @return            The ProxyRequestContext.
    */
@@ -233,10 +409,19 @@ class CarbonRouterClient : public CarbonRouterClientBase {
   makeProxyRequestContext(
       const Request& req,
       CallbackFunc&& callback,
-      folly::StringPiece ipAddr,
-      bool inBatch);
+      folly::StringPiece ipAddr);
 
-  bool shouldDelayNotification(size_t batchSize) const;
+  /**
+   * Same as above, for a proxy already picked by selectProxy().
+   */
+  template <class Request, class CallbackFunc>
+  std::unique_ptr<ProxyRequestContextWithInfo<RouterInfo>>
+  makeProxyRequestContext(
+      Proxy<RouterInfo>& proxy,
+      uint64_t routingHint,
+      const Request& req,
+      CallbackFunc&& callback,
+      folly::StringPiece ipAddr);
 
   friend class CarbonRouterInstance<RouterInfo>;
 };
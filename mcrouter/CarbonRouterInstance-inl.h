@@ -16,7 +16,9 @@
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/ThreadPoolExecutor.h>
 #include <folly/fibers/FiberManager.h>
+#include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
+#include <folly/synchronization/Baton.h>
 
 #include "mcrouter/AsyncWriter.h"
 #include "mcrouter/CarbonRouterInstanceBase.h"
@@ -32,6 +34,8 @@
 #include "mcrouter/TargetHooks.h"
 #include "mcrouter/ThreadUtil.h"
 #include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
+#include "mcrouter/lib/ZstdDictionaryTrainer.h"
+#include "mcrouter/lib/network/ThreadLocalSSLContextProvider.h"
 #include "mcrouter/routes/McRouteHandleProvider.h"
 #include "mcrouter/stats.h"
 
@@ -188,9 +192,20 @@ CarbonRouterInstance<RouterInfo>::createClient(
       this->shared_from_this(),
       max_outstanding,
       max_outstanding_error,
-      opts().thread_affinity
-          ? CarbonRouterClient<RouterInfo>::ThreadMode::AffinitizedRemoteThread
-          : CarbonRouterClient<RouterInfo>::ThreadMode::FixedRemoteThread);
+      clientThreadMode());
+}
+
+template <class RouterInfo>
+typename CarbonRouterClient<RouterInfo>::ThreadMode
+CarbonRouterInstance<RouterInfo>::clientThreadMode() const {
+  if (opts().thread_affinity) {
+    return CarbonRouterClient<RouterInfo>::ThreadMode::AffinitizedRemoteThread;
+  }
+  if (opts().key_affinity) {
+    return CarbonRouterClient<
+        RouterInfo>::ThreadMode::KeyAffinitizedRemoteThread;
+  }
+  return CarbonRouterClient<RouterInfo>::ThreadMode::FixedRemoteThread;
 }
 
 template <class RouterInfo>
@@ -232,10 +247,24 @@ CarbonRouterInstance<RouterInfo>::spinUp() {
     return folly::makeUnexpected(std::string(
         "force_same_thread and thread_affinity may not both be true"));
   }
+  if (opts_.key_affinity &&
+      (opts_.force_same_thread || opts_.thread_affinity)) {
+    return folly::makeUnexpected(std::string(
+        "key_affinity can't be used with force_same_thread or"
+        " thread_affinity"));
+  }
   // Must init compression before creating proxies.
   if (opts_.enable_compression) {
     initCompression(*this);
   }
+  setUpDictionaryTraining();
+  // Must configure session caches before any SSL context is created.
+  if (opts_.ssl_connection_cache &&
+      !configureClientSessionCaches(
+          opts_.ssl_connection_cache_size, opts_.ssl_connection_cache_file)) {
+    VLOG(1) << "SSL session caches were already created by another router, "
+               "ignoring ssl_connection_cache_size/ssl_connection_cache_file";
+  }
 
   bool configuringFromDisk = false;
   {
@@ -265,7 +294,8 @@ CarbonRouterInstance<RouterInfo>::spinUp() {
         proxyThreads_ = std::make_shared<folly::IOThreadPoolExecutor>(
             opts_.num_proxies /* max */,
             opts_.num_proxies /* min */,
-            std::make_shared<folly::NamedThreadFactory>(threadPrefix));
+            std::make_shared<folly::NamedThreadFactory>(threadPrefix),
+            getProxyEventBaseManager(opts_));
         embeddedMode_ = true;
 
       } catch (...) {
@@ -344,6 +374,9 @@ CarbonRouterInstance<RouterInfo>::spinUp() {
 
   configuredFromDisk_.store(configuringFromDisk, std::memory_order_relaxed);
 
+  prewarmConnections(
+      std::chrono::milliseconds(opts_.prewarm_connections_timeout_ms));
+
   startTime_.store(time(nullptr), std::memory_order_relaxed);
 
   spawnAuxiliaryThreads();
@@ -442,6 +475,9 @@ void CarbonRouterInstance<RouterInfo>::spawnAuxiliaryThreads() {
   startObservingRuntimeVarsFile();
   registerOnUpdateCallbackForRxmits();
   registerForStatsUpdates();
+  startDictionaryTraining();
+  startArenaPurging();
+  startStatsSnapshots();
   spawnStatLoggerThread();
 }
 
@@ -489,6 +525,9 @@ template <class RouterInfo>
 void CarbonRouterInstance<RouterInfo>::spawnStatLoggerThread() {
   mcrouterLogger_ = createMcrouterLogger(*this);
   mcrouterLogger_->start();
+  requestTraceExporter_ = std::make_unique<RequestTraceExporter>(*this);
+  requestTraceExporter_->start();
+  startTkoEventLog();
 }
 
 template <class RouterInfo>
@@ -500,10 +539,17 @@ void CarbonRouterInstance<RouterInfo>::joinAuxiliaryThreads() noexcept {
   }
 
   deregisterForStatsUpdates();
+  stopDictionaryTraining();
+  stopArenaPurging();
+  stopStatsSnapshots();
 
   if (mcrouterLogger_) {
     mcrouterLogger_->stop();
   }
+  if (requestTraceExporter_) {
+    requestTraceExporter_->stop();
+  }
+  stopTkoEventLog();
 
   runtimeVarsObserverHandle_.reset();
 }
@@ -520,11 +566,47 @@ bool CarbonRouterInstance<RouterInfo>::reconfigure(
     configApi_->abandonTrackedSources();
   } else {
     configApi_->subscribeToTrackedSources();
+    prewarmConnections(std::chrono::milliseconds(0));
   }
 
   return result.hasValue();
 }
 
+template <class RouterInfo>
+void CarbonRouterInstance<RouterInfo>::prewarmConnections(
+    std::chrono::milliseconds waitTimeout) {
+  if (!opts_.prewarm_connections || opts_.prewarm_connections_percent == 0 ||
+      proxies_.empty()) {
+    return;
+  }
+
+  struct PrewarmState {
+    std::atomic<size_t> remaining{0};
+    folly::Baton<> done;
+  };
+  auto state = std::make_shared<PrewarmState>();
+  state->remaining = proxies_.size();
+  for (auto* proxy : proxies_) {
+    proxy->eventBase().runInEventBaseThread(
+        [proxy,
+         state,
+         connectionsPerSecond = opts_.prewarm_connections_per_second,
+         percent = opts_.prewarm_connections_percent]() {
+          proxy->destinationMap()->prewarmConnections(
+              connectionsPerSecond, percent, [state]() {
+                if (--state->remaining == 0) {
+                  state->done.post();
+                }
+              });
+        });
+  }
+
+  if (waitTimeout.count() > 0 && !state->done.try_wait_for(waitTimeout)) {
+    LOG(WARNING) << "Connection pre-warming didn't finish in "
+                 << waitTimeout.count() << "ms, continuing in the background";
+  }
+}
+
 template <class RouterInfo>
 bool CarbonRouterInstance<RouterInfo>::reconfigurePartially() {
   auto partialUpdates = configApi_->releasePartialUpdatesLocked();
@@ -617,10 +699,31 @@ folly::Expected<folly::Unit, std::string>
 CarbonRouterInstance<RouterInfo>::configure(const ProxyConfigBuilder& builder) {
   VLOG_IF(1, !opts_.constantly_reload_configs) << "started reconfiguring";
   std::vector<std::shared_ptr<ProxyConfig<RouterInfo>>> newConfigs;
-  newConfigs.reserve(opts_.num_proxies);
+  newConfigs.resize(opts_.num_proxies);
   try {
-    for (size_t i = 0; i < opts_.num_proxies; i++) {
-      newConfigs.push_back(builder.buildConfig<RouterInfo>(*getProxy(i), i));
+    // The first config is always built alone: it parses all pools and
+    // fetches everything it needs from ConfigApi, so that the other configs
+    // only read what's already cached in the builder.
+    newConfigs[0] = builder.buildConfig<RouterInfo>(*getProxy(0), 0);
+    auto threadPool = opts_.parallel_config_build && opts_.num_proxies > 1
+        ? AuxiliaryCPUThreadPoolSingleton::try_get()
+        : nullptr;
+    if (threadPool) {
+      std::vector<folly::Future<folly::Unit>> futures;
+      futures.reserve(opts_.num_proxies - 1);
+      for (size_t i = 1; i < opts_.num_proxies; i++) {
+        futures.push_back(
+            folly::via(&threadPool->getThreadPool(), [&, i]() {
+              newConfigs[i] = builder.buildConfig<RouterInfo>(*getProxy(i), i);
+            }));
+      }
+      for (auto& result : folly::collectAll(std::move(futures)).get()) {
+        result.throwUnlessValue();
+      }
+    } else {
+      for (size_t i = 1; i < opts_.num_proxies; i++) {
+        newConfigs[i] = builder.buildConfig<RouterInfo>(*getProxy(i), i);
+      }
     }
   } catch (const std::exception& e) {
     std::string error = folly::sformat("Failed to reconfigure: {}", e.what());
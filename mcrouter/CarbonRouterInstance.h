@@ -8,6 +8,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <memory>
@@ -25,6 +26,7 @@
 #include "mcrouter/FileObserver.h"
 #include "mcrouter/Proxy.h"
 #include "mcrouter/ProxyConfigBuilder.h"
+#include "mcrouter/RequestTraceExporter.h"
 
 namespace facebook {
 namespace memcache {
@@ -171,6 +173,12 @@ class CarbonRouterInstance
   CarbonRouterInstance& operator=(CarbonRouterInstance&&) = delete;
 
  private:
+  /**
+   * Thread mode of the clients made by createClient(), from the
+   * thread_affinity and key_affinity options.
+   */
+  typename CarbonRouterClient<RouterInfo>::ThreadMode clientThreadMode() const;
+
   CallbackPool<> onReconfigureSuccess_;
 
   // Lock to get before regenerating config structure
@@ -185,6 +193,11 @@ class CarbonRouterInstance
    */
   std::unique_ptr<McrouterLogger> mcrouterLogger_;
 
+  /**
+   * Exports the spans of sampled requests, if tracing is enabled.
+   */
+  std::unique_ptr<RequestTraceExporter> requestTraceExporter_;
+
   std::atomic<bool> shutdownStarted_{false};
 
   FileObserverHandle runtimeVarsObserverHandle_;
@@ -244,6 +257,12 @@ class CarbonRouterInstance
 
   void registerOnUpdateCallbackForRxmits();
 
+  /**
+   * Starts pre-warming connections on all proxies, if enabled, and waits at
+   * most `waitTimeout` for it to finish.
+   */
+  void prewarmConnections(std::chrono::milliseconds waitTimeout);
+
  public:
   /* Do not use for new code */
   class LegacyPrivateAccessor {
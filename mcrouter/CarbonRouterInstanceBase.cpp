@@ -11,13 +11,20 @@
 
 #include <boost/filesystem/operations.hpp>
 
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
 #include <folly/Singleton.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/system/ThreadName.h>
 
 #include "mcrouter/AsyncWriter.h"
 #include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
 #include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/ZstdDictionaryTrainer.h"
+#include "mcrouter/lib/debug/FifoManager.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/HostResolver.h"
 #include "mcrouter/stats.h"
 
 namespace facebook {
@@ -63,6 +70,27 @@ std::string statsUpdateFunctionName(folly::StringPiece routerName) {
       "carbon-stats-update-fn-", routerName, "-", uniqueId.fetch_add(1));
 }
 
+std::string dictionaryTrainingFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-dictionary-training-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+std::string arenaPurgeFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-arena-purge-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+std::string statsSnapshotFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-stats-snapshot-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+// ZSTD needs a reasonable number of samples to train anything useful.
+constexpr size_t kMinDictionaryTrainingSamples = 100;
+
 McrouterOptions finalizeOpts(McrouterOptions&& opts) {
   facebook::memcache::mcrouter::finalizeOptions(opts);
   return std::move(opts);
@@ -74,9 +102,18 @@ CarbonRouterInstanceBase::CarbonRouterInstanceBase(McrouterOptions inputOptions)
     : opts_(finalizeOpts(std::move(inputOptions))),
       pid_(getpid()),
       configApi_(createConfigApi(opts_)),
+      probeScheduler_(
+          std::chrono::milliseconds(opts_.probe_delay_initial_ms),
+          std::chrono::milliseconds(opts_.probe_delay_max_ms),
+          folly::Random::secureRand64()),
       rtVarsData_(std::make_shared<ObservableRuntimeVars>()),
       leaseTokenMap_(globalFunctionScheduler.try_get()),
-      statsUpdateFunctionHandle_(statsUpdateFunctionName(opts_.router_name)) {
+      statsUpdateFunctionHandle_(statsUpdateFunctionName(opts_.router_name)),
+      dictionaryTrainingFunctionHandle_(
+          dictionaryTrainingFunctionName(opts_.router_name)),
+      arenaPurgeFunctionHandle_(arenaPurgeFunctionName(opts_.router_name)),
+      statsSnapshotFunctionHandle_(
+          statsSnapshotFunctionName(opts_.router_name)) {
   if (auto statsLogger = statsLogWriter()) {
     if (opts_.stats_async_queue_length) {
       statsLogger->increaseMaxQueueSize(opts_.stats_async_queue_length);
@@ -85,6 +122,12 @@ CarbonRouterInstanceBase::CarbonRouterInstanceBase(McrouterOptions inputOptions)
     }
   }
 
+  // Created up front (proxies look it up without synchronization), but only
+  // used once started.
+  if (opts_.tko_log_window_ms != 0) {
+    tkoEventLog_ = std::make_unique<TkoEventLog>(*this);
+  }
+
   if (!opts_.pool_stats_config_file.empty()) {
     try {
       folly::dynamic poolStatJson =
@@ -105,6 +148,18 @@ CarbonRouterInstanceBase::CarbonRouterInstanceBase(McrouterOptions inputOptions)
       LOG(ERROR) << "Invalid pool-stats-config-file : " << e.what();
     }
   }
+  if (!opts_.debug_fifo_root.empty() && opts_.debug_fifo_shm_ring_kb > 0) {
+    if (auto fifoManager = FifoManager::getInstance()) {
+      fifoManager->setShmRingCapacity(
+          static_cast<size_t>(opts_.debug_fifo_shm_ring_kb) * 1024);
+    }
+  }
+
+  if (auto hostResolver = HostResolver::getInstance()) {
+    hostResolver->setTtl(
+        std::chrono::milliseconds(opts_.host_resolution_ttl_ms));
+  }
+
   if (opts_.ssl_service_identity_authorization_log ||
       opts_.ssl_service_identity_authorization_enforce) {
     setSvcIdentAuthCallbackFunc(
@@ -118,7 +173,182 @@ void CarbonRouterInstanceBase::setUpCompressionDictionaries(
     return;
   }
   compressionCodecManager_ =
-      std::make_unique<const CompressionCodecManager>(std::move(codecConfigs));
+      std::make_unique<CompressionCodecManager>(std::move(codecConfigs));
+}
+
+void CarbonRouterInstanceBase::setUpDictionaryTraining() {
+  if (!opts_.enable_compression ||
+      opts_.compression_dictionary_training_interval_s == 0) {
+    return;
+  }
+  if (compressionCodecManager_ == nullptr) {
+    // No dictionaries were pushed through config, start from scratch.
+    compressionCodecManager_ = std::make_unique<CompressionCodecManager>(
+        std::unordered_map<uint32_t, CodecConfigPtr>());
+  }
+  dictionaryTrainer_ = std::make_unique<ZstdDictionaryTrainer>(
+      opts_.compression_dictionary_sample_bytes,
+      opts_.compression_dictionary_max_value_size);
+}
+
+void CarbonRouterInstanceBase::startDictionaryTraining() {
+  if (!dictionaryTrainer_) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    const std::chrono::seconds interval(
+        opts_.compression_dictionary_training_interval_s);
+    scheduler->addFunction(
+        [this]() {
+          // Training is CPU heavy, run it on the auxiliary pool and wait
+          // for it so that stopDictionaryTraining() waits for it as well.
+          auto threadPool = AuxiliaryCPUThreadPoolSingleton::try_get();
+          if (!threadPool) {
+            return;
+          }
+          folly::Baton<> done;
+          threadPool->getThreadPool().add([this, &done]() {
+            trainDictionary();
+            done.post();
+          });
+          done.wait();
+        },
+        interval,
+        dictionaryTrainingFunctionHandle_,
+        /*startDelay=*/interval);
+  }
+}
+
+void CarbonRouterInstanceBase::stopDictionaryTraining() {
+  if (!dictionaryTrainer_) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    scheduler->cancelFunctionAndWait(dictionaryTrainingFunctionHandle_);
+  }
+}
+
+void CarbonRouterInstanceBase::startArenaPurging() {
+  if (!opts_.proxy_jemalloc_arena ||
+      opts_.proxy_jemalloc_arena_idle_purge_ms == 0 || !opts_.num_proxies) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    const std::chrono::milliseconds interval(
+        opts_.proxy_jemalloc_arena_idle_purge_ms);
+    scheduler->addFunction(
+        [this]() {
+          for (size_t i = 0; i < opts_.num_proxies; ++i) {
+            auto proxy = getProxyBase(i);
+            // Wait, so that stopArenaPurging() doesn't return with a purge
+            // still queued on a proxy about to go away.
+            proxy->eventBase().getEventBase().runInEventBaseThreadAndWait(
+                [proxy]() { proxy->purgeJemallocArenaIfIdle(); });
+          }
+        },
+        interval,
+        arenaPurgeFunctionHandle_,
+        /*startDelay=*/interval);
+  }
+}
+
+void CarbonRouterInstanceBase::stopArenaPurging() {
+  if (!opts_.proxy_jemalloc_arena ||
+      opts_.proxy_jemalloc_arena_idle_purge_ms == 0) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    scheduler->cancelFunctionAndWait(arenaPurgeFunctionHandle_);
+  }
+}
+
+void CarbonRouterInstanceBase::startStatsSnapshots() {
+  if (opts_.stats_snapshot_interval_ms == 0 || !opts_.num_proxies) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    const std::chrono::milliseconds interval(opts_.stats_snapshot_interval_ms);
+    scheduler->addFunction(
+        [this,
+         collector = StatsSnapshot::Collector(
+             [this](folly::StringPiece group) {
+               try {
+                 return stats_reply(getProxyBase(0), group);
+               } catch (const std::exception& e) {
+                 McStatsReply reply(carbon::Result::LOCAL_ERROR);
+                 reply.message_ref() = folly::to<std::string>(
+                     "Error processing stats request: ", e.what());
+                 return reply;
+               }
+             })]() mutable { statsSnapshot_.collect(collector); },
+        interval,
+        statsSnapshotFunctionHandle_,
+        /*startDelay=*/interval);
+  }
+}
+
+void CarbonRouterInstanceBase::stopStatsSnapshots() {
+  if (opts_.stats_snapshot_interval_ms == 0) {
+    return;
+  }
+  if (auto scheduler = functionScheduler()) {
+    scheduler->cancelFunctionAndWait(statsSnapshotFunctionHandle_);
+  }
+}
+
+void CarbonRouterInstanceBase::startTkoEventLog() {
+  if (tkoEventLog_) {
+    tkoEventLog_->start();
+  }
+}
+
+void CarbonRouterInstanceBase::stopTkoEventLog() noexcept {
+  if (tkoEventLog_) {
+    tkoEventLog_->stop();
+  }
+}
+
+void CarbonRouterInstanceBase::trainDictionary() {
+  if (dictionaryTrainer_->numSamples() < kMinDictionaryTrainingSamples) {
+    return;
+  }
+  auto samples = dictionaryTrainer_->takeSamples();
+  auto dictionary = ZstdDictionaryTrainer::train(
+      samples, opts_.compression_dictionary_size);
+  if (!dictionary) {
+    return;
+  }
+
+  // New dictionaries inherit filtering and level from the newest ZSTD codec.
+  auto id = compressionCodecManager_->nextCodecId();
+  FilteringOptions filteringOptions;
+  uint32_t compressionLevel = 1;
+  if (auto latest = compressionCodecManager_->latestCodecConfig(
+          CompressionCodecType::ZSTD)) {
+    filteringOptions = latest->filteringOptions;
+    compressionLevel = latest->compressionLevel;
+  }
+  if (!opts_.compression_dictionary_dir.empty()) {
+    auto path = folly::sformat(
+        "{}/{}.{}.dict",
+        opts_.compression_dictionary_dir,
+        opts_.router_name,
+        id);
+    if (!folly::writeFile(*dictionary, path.c_str())) {
+      LOG(ERROR) << "Failed to write compression dictionary to " << path;
+    }
+  }
+  auto dictionarySize = dictionary->size();
+  if (compressionCodecManager_->addCodecConfig(std::make_unique<CodecConfig>(
+          id,
+          CompressionCodecType::ZSTD,
+          std::move(*dictionary),
+          filteringOptions,
+          compressionLevel))) {
+    LOG(INFO) << "Trained compression dictionary " << id << " ("
+              << dictionarySize << " bytes) from " << samples.size()
+              << " samples";
+  }
 }
 
 void CarbonRouterInstanceBase::setStartupOpts(
@@ -141,8 +371,12 @@ CarbonRouterInstanceBase::getStartupOpts() const {
 size_t CarbonRouterInstanceBase::nextProxyIndex() {
   std::lock_guard<std::mutex> guard(nextProxyMutex_);
   assert(nextProxy_ < opts().num_proxies);
+  const size_t active = activeProxies();
+  if (nextProxy_ >= active) {
+    nextProxy_ = 0;
+  }
   size_t res = nextProxy_;
-  nextProxy_ = (nextProxy_ + 1) % opts().num_proxies;
+  nextProxy_ = (nextProxy_ + 1) % active;
   return res;
 }
 
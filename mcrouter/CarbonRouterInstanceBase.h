@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 
@@ -24,7 +27,11 @@
 #include "mcrouter/LeaseTokenMap.h"
 #include "mcrouter/Observable.h"
 #include "mcrouter/PoolStats.h"
+#include "mcrouter/ProbeScheduler.h"
+#include "mcrouter/StatsSnapshot.h"
+#include "mcrouter/TkoEventLog.h"
 #include "mcrouter/TkoTracker.h"
+#include "mcrouter/lib/network/ServerLoad.h"
 #include "mcrouter/lib/network/Transport.h"
 #include "mcrouter/options.h"
 
@@ -35,6 +42,7 @@ namespace memcache {
 struct CodecConfig;
 using CodecConfigPtr = std::unique_ptr<CodecConfig>;
 class CompressionCodecManager;
+class ZstdDictionaryTrainer;
 
 namespace mcrouter {
 
@@ -82,14 +90,37 @@ class CarbonRouterInstanceBase {
   void setUpCompressionDictionaries(
       std::unordered_map<uint32_t, CodecConfigPtr>&& codecConfigs) noexcept;
 
+  /**
+   * Returns the sampler used to train new compression dictionaries, or nullptr
+   * if dictionary training is disabled.
+   */
+  ZstdDictionaryTrainer* dictionaryTrainer() const {
+    return dictionaryTrainer_.get();
+  }
+
   TkoTrackerMap& tkoTrackerMap() {
     return tkoTrackerMap_;
   }
 
+  /**
+   * Schedules the probes of TKO destinations, across all proxies.
+   */
+  ProbeScheduler& probeScheduler() {
+    return probeScheduler_;
+  }
+
   ExternalStatsHandler& externalStatsHandler() {
     return externalStatsHandler_;
   }
 
+  /**
+   * Stats replies collected in the background, only used if
+   * stats_snapshot_interval_ms is set.
+   */
+  StatsSnapshot& statsSnapshot() {
+    return statsSnapshot_;
+  }
+
   ConfigApi& configApi() {
     assert(configApi_.get() != nullptr);
     return *configApi_;
@@ -205,9 +236,41 @@ class CarbonRouterInstanceBase {
 
   /**
    * Bump and return the index of the next proxy to be used by clients.
+   * Only the active proxies (see setActiveProxies()) are handed out.
    */
   size_t nextProxyIndex();
 
+  /**
+   * Scales the proxies CarbonRouterClients send requests to down (or back
+   * up) to the first `n` ones, clamped to [1, num_proxies], without a
+   * restart. Retired proxies keep their threads, destinations and config:
+   * they finish the requests already queued to them, then go idle until
+   * they are made active again.
+   *
+   * New clients and AffinitizedRemoteThread requests only use the active
+   * proxies. FixedRemoteThread clients of a retired proxy move to an active
+   * one on their next request. SameThread clients stay where they are.
+   */
+  void setActiveProxies(size_t n) {
+    activeProxies_.store(
+        std::max<size_t>(std::min(n, opts().num_proxies), 1),
+        std::memory_order_relaxed);
+  }
+
+  size_t activeProxies() const {
+    return std::min(
+        activeProxies_.load(std::memory_order_relaxed), opts().num_proxies);
+  }
+
+  /**
+   * @return  the log TKO events are batched in, or nullptr if they should be
+   *          logged where they happen (see opts.tko_log_window_ms).
+   */
+  TkoEventLog* tkoEventLog() const {
+    return tkoEventLog_ && tkoEventLog_->running() ? tkoEventLog_.get()
+                                                   : nullptr;
+  }
+
   /**
    * Returns a FunctionScheduler suitable for running periodic background tasks
    * on. Null may be returned if the global instance has been destroyed.
@@ -219,6 +282,22 @@ class CarbonRouterInstanceBase {
    */
   virtual folly::StringPiece routerInfoName() const = 0;
 
+  /**
+   * Installs a source of the load on the host this router runs on (e.g. the
+   * CpuController of the standalone server), used to shed shadow traffic.
+   * Must be called before any request is routed.
+   */
+  void setHostLoadProvider(std::function<ServerLoad()> provider) {
+    hostLoadProvider_ = std::move(provider);
+  }
+
+  /**
+   * @return  load on the host, or zero if no provider is installed.
+   */
+  ServerLoad hostLoad() const {
+    return hostLoadProvider_ ? hostLoadProvider_() : ServerLoad::zero();
+  }
+
   template <class T>
   auto getMetadata() {
     return std::static_pointer_cast<T>(metadata_);
@@ -256,6 +335,41 @@ class CarbonRouterInstanceBase {
    */
   void deregisterForStatsUpdates();
 
+  /**
+   * Sets up sampling for compression dictionary training, if enabled.
+   * Must be called after compression is initialized and before proxies are
+   * created.
+   */
+  void setUpDictionaryTraining();
+
+  /**
+   * Start/stop periodically training compression dictionaries from the
+   * sampled values.
+   */
+  void startDictionaryTraining();
+  void stopDictionaryTraining();
+
+  /**
+   * Start/stop periodically purging the jemalloc arenas of idle proxies, if
+   * proxy_jemalloc_arena_idle_purge_ms is set.
+   */
+  void startArenaPurging();
+  void stopArenaPurging();
+
+  /**
+   * Start/stop periodically collecting stats replies into statsSnapshot(),
+   * if stats_snapshot_interval_ms is set.
+   */
+  void startStatsSnapshots();
+  void stopStatsSnapshots();
+
+  /**
+   * Start/stop batching the log lines of TKO events, if
+   * opts.tko_log_window_ms is set.
+   */
+  void startTkoEventLog();
+  void stopTkoEventLog() noexcept;
+
   const McrouterOptions opts_;
   const pid_t pid_;
   const std::unique_ptr<ConfigApi> configApi_;
@@ -287,8 +401,11 @@ class CarbonRouterInstanceBase {
   }
 
   TkoTrackerMap tkoTrackerMap_;
+  ProbeScheduler probeScheduler_;
   ExternalStatsHandler externalStatsHandler_;
-  std::unique_ptr<const CompressionCodecManager> compressionCodecManager_;
+  StatsSnapshot statsSnapshot_;
+  std::unique_ptr<CompressionCodecManager> compressionCodecManager_;
+  std::unique_ptr<ZstdDictionaryTrainer> dictionaryTrainer_;
 
   // Stores data for runtime variables.
   const std::shared_ptr<ObservableRuntimeVars> rtVarsData_;
@@ -301,11 +418,14 @@ class CarbonRouterInstanceBase {
   std::unique_ptr<ShadowLeaseTokenMap> shadowLeaseTokenMap_;
   folly::once_flag shadowLeaseTokenMapInitFlag_;
 
+  std::function<ServerLoad()> hostLoadProvider_;
+
   std::unordered_map<std::string, std::string> additionalStartupOpts_;
   std::atomic<bool> startupOptsInitialized_{false};
 
   std::mutex nextProxyMutex_;
   size_t nextProxy_{0};
+  std::atomic<size_t> activeProxies_{std::numeric_limits<size_t>::max()};
 
   // Current stats index. Only accessed / updated  by stats background thread.
   size_t statsIndex_{0};
@@ -313,11 +433,30 @@ class CarbonRouterInstanceBase {
   // Name of the stats update function registered with the function scheduler.
   const std::string statsUpdateFunctionHandle_;
 
+  // Name of the dictionary training function registered with the function
+  // scheduler.
+  const std::string dictionaryTrainingFunctionHandle_;
+
+  // Name of the arena purging function registered with the function
+  // scheduler.
+  const std::string arenaPurgeFunctionHandle_;
+
+  // Name of the stats snapshot function registered with the function
+  // scheduler.
+  const std::string statsSnapshotFunctionHandle_;
+
   std::vector<std::string> statsEnabledPools_;
 
+  // Declared after statsEnabledPools_, which it uses until it's destroyed.
+  std::unique_ptr<TkoEventLog> tkoEventLog_;
+
   // Aggregates stats for all associated proxies. Should be called periodically.
   void updateStats();
 
+  // Trains a new compression dictionary from the sampled values and rolls it
+  // out. Runs on the auxiliary thread pool.
+  void trainDictionary();
+
   /**
    * Opaque metadata used by SRRoute, to avoid circular dependency
    */
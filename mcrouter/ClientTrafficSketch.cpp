@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ClientTrafficSketch.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+void sortByRequests(std::vector<ClientTrafficSketch::Item>& items) {
+  std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+    return a.requests > b.requests ||
+        (a.requests == b.requests && a.client < b.client);
+  });
+}
+
+} // namespace
+
+ClientTrafficSketch::ClientTrafficSketch(size_t capacity)
+    : capacity_(capacity) {
+  assert(capacity_ > 0);
+  items_.reserve(capacity_);
+  index_.reserve(capacity_);
+}
+
+void ClientTrafficSketch::record(
+    folly::StringPiece client,
+    uint64_t bytesIn,
+    uint64_t bytesOut,
+    uint64_t durationUs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++total_;
+
+  Item* item;
+  auto it = index_.find(client);
+  if (it != index_.end()) {
+    item = &items_[it->second];
+  } else if (items_.size() < capacity_) {
+    items_.push_back(Item{client.str()});
+    index_.emplace(client.str(), items_.size() - 1);
+    item = &items_.back();
+  } else {
+    auto min = std::min_element(
+        items_.begin(), items_.end(), [](const auto& a, const auto& b) {
+          return a.requests < b.requests;
+        });
+    index_.erase(min->client);
+    const auto minRequests = min->requests;
+    *min = Item{client.str()};
+    min->requests = minRequests;
+    min->error = minRequests;
+    index_.emplace(min->client, min - items_.begin());
+    item = &*min;
+  }
+
+  ++item->requests;
+  item->bytesIn += bytesIn;
+  item->bytesOut += bytesOut;
+  item->durationUs += durationUs;
+}
+
+std::vector<ClientTrafficSketch::Item> ClientTrafficSketch::snapshot() const {
+  std::vector<Item> items;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    items = items_;
+  }
+  sortByRequests(items);
+  return items;
+}
+
+uint64_t ClientTrafficSketch::total() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_;
+}
+
+std::vector<ClientTrafficSketch::Item> ClientTrafficSketch::merge(
+    const std::vector<std::vector<Item>>& snapshots,
+    size_t limit) {
+  folly::F14FastMap<std::string, Item> merged;
+  for (const auto& snapshot : snapshots) {
+    for (const auto& item : snapshot) {
+      auto& out = merged[item.client];
+      out.requests += item.requests;
+      out.error += item.error;
+      out.bytesIn += item.bytesIn;
+      out.bytesOut += item.bytesOut;
+      out.durationUs += item.durationUs;
+    }
+  }
+
+  std::vector<Item> items;
+  items.reserve(merged.size());
+  for (auto& it : merged) {
+    it.second.client = it.first;
+    items.push_back(std::move(it.second));
+  }
+  sortByRequests(items);
+  if (items.size() > limit) {
+    items.resize(limit);
+  }
+  return items;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Traffic of the approximate top `capacity` clients, ranked by number of
+ * requests. Same "Space-Saving" scheme as HotKeySketch: a new client
+ * replaces the one with the fewest requests and inherits its request count
+ * as `error`. The byte and duration counters of a replaced client start
+ * from zero, so they only cover the traffic since it was (re)tracked.
+ *
+ * There are far fewer clients than keys and they rarely change, so the
+ * least active client is found by a linear scan.
+ *
+ * Each proxy owns one sketch and is the only writer; stats commands take
+ * snapshots from other threads.
+ */
+class ClientTrafficSketch {
+ public:
+  struct Item {
+    std::string client;
+    uint64_t requests{0};
+    uint64_t error{0};
+    uint64_t bytesIn{0};
+    uint64_t bytesOut{0};
+    // Sum of the time the requests spent in the proxy, until the reply.
+    uint64_t durationUs{0};
+  };
+
+  explicit ClientTrafficSketch(size_t capacity);
+
+  ClientTrafficSketch(const ClientTrafficSketch&) = delete;
+  ClientTrafficSketch& operator=(const ClientTrafficSketch&) = delete;
+
+  void record(
+      folly::StringPiece client,
+      uint64_t bytesIn,
+      uint64_t bytesOut,
+      uint64_t durationUs);
+
+  /**
+   * @return  copy of all tracked clients, sorted by descending requests.
+   */
+  std::vector<Item> snapshot() const;
+
+  /**
+   * Total number of requests recorded so far.
+   */
+  uint64_t total() const;
+
+  /**
+   * Sums up snapshots of several sketches (e.g. one per proxy) and returns
+   * the `limit` busiest clients, sorted by descending requests.
+   */
+  static std::vector<Item> merge(
+      const std::vector<std::vector<Item>>& snapshots,
+      size_t limit);
+
+ private:
+  const size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::vector<Item> items_;
+  folly::F14FastMap<std::string, size_t> index_;
+  uint64_t total_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -7,12 +7,15 @@
 
 #include "ConfigApi.h"
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
 #include <boost/filesystem.hpp>
 
 #include <folly/FileUtil.h>
 #include <folly/Random.h>
+#include <folly/system/MemoryMapping.h>
 #include <folly/String.h>
 #include <folly/dynamic.h>
 #include <folly/io/async/ScopedEventBaseThread.h>
@@ -35,6 +38,8 @@ const char* const kMcrouterConfigKey = "mcrouter_config";
 const char* const kConfigFile = "config_file";
 const char* const kConfigImport = "config_import";
 const int kConfigReloadInterval = 60;
+const int kMinDebounceQuietPeriodMs = 10;
+const char* const kConfigSnapshotFile = "preprocessed-config.bser";
 
 boost::filesystem::path getBackupConfigDirectory(const McrouterOptions& opts) {
   return boost::filesystem::path(opts.config_dump_root) / opts.service_name /
@@ -102,6 +107,7 @@ void logFailureEveryN(
 }
 struct DumpFileTag;
 struct TouchFileTag;
+struct DumpSnapshotTag;
 
 } // anonymous namespace
 
@@ -221,12 +227,23 @@ void ConfigApi::configThreadRun() {
     // watch for IN_MODIFY to IN_CLOSE_WRITE, but Race 2 has no apparent
     // elegant solution. The following jankiness fixes both.
 
-    {
-      std::unique_lock<std::mutex> lk(finishMutex_);
-      finishCV_.wait_for(
-          lk,
-          std::chrono::milliseconds(opts_.reconfiguration_delay_ms),
-          [this] { return finish_.load(); });
+    waitFor(std::chrono::milliseconds(opts_.reconfiguration_delay_ms));
+
+    if (hasUpdate) {
+      waitForUpdatesToSettle();
+      bool changed = true;
+      if (opts_.skip_unchanged_config_reloads) {
+        try {
+          changed = configSourcesChanged();
+        } catch (const std::exception& e) {
+          LOG(ERROR) << "Comparing config sources failed: " << e.what();
+        }
+      }
+      if (!changed) {
+        VLOG(1) << "Config files were updated with the same contents, "
+                << "not reconfiguring";
+        hasUpdate = false;
+      }
     }
 
     if (hasUpdate) {
@@ -257,6 +274,56 @@ void ConfigApi::configThreadRun() {
   }
 }
 
+void ConfigApi::waitForUpdatesToSettle() {
+  if (opts_.reconfiguration_debounce_max_ms <= 0) {
+    return;
+  }
+  const auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(opts_.reconfiguration_debounce_max_ms);
+  // Not to spin when reconfiguration_delay_ms is 0.
+  const auto quietPeriod = std::chrono::milliseconds(
+      std::max(opts_.reconfiguration_delay_ms, kMinDebounceQuietPeriodMs));
+  while (!finish_) {
+    bool moreUpdates = false;
+    try {
+      moreUpdates = checkFileUpdate();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Check for config update failed: " << e.what();
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (!moreUpdates || now >= deadline) {
+      return;
+    }
+    VLOG(1) << "Config files still changing, delaying reconfiguration";
+    waitFor(std::min<std::chrono::milliseconds>(
+        quietPeriod,
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - now)));
+  }
+}
+
+void ConfigApi::waitFor(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lk(finishMutex_);
+  finishCV_.wait_for(lk, timeout, [this] { return finish_.load(); });
+}
+
+bool ConfigApi::configSourcesChanged() {
+  std::lock_guard<std::mutex> lock(fileInfoMutex_);
+  if (fileInfos_.empty()) {
+    // Nothing to compare with.
+    return true;
+  }
+  for (const auto& fileIt : fileInfos_) {
+    const auto& file = fileIt.second;
+    std::string contents;
+    if (!folly::readFile(file.path.data(), contents) ||
+        Md5Hash(contents) != file.md5) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void ConfigApi::sleepForPostReconfiguration() {
   if (opts_.post_reconfiguration_delay_ms > 0) {
     std::unique_lock<std::mutex> lk(finishMutex_);
@@ -560,6 +627,45 @@ void ConfigApi::enableReadingFromBackupFiles() {
   LOG(WARNING) << "Enabling read config from backup files.";
 }
 
+void ConfigApi::dumpConfigSnapshot(ConfigSnapshot snapshot) {
+  if (!dumpConfigToDiskExecutor_ || !opts_.config_snapshot) {
+    return;
+  }
+
+  dumpConfigToDiskExecutor_->add([this, snapshot = std::move(snapshot)]() {
+    auto filePath =
+        (getBackupConfigDirectory(opts_) / kConfigSnapshotFile).string();
+    if (atomicallyWriteFileToDisk(snapshot.serialize(), filePath)) {
+      ensureHasPermission(filePath, 0664);
+    } else {
+      logFailureEveryN<DumpSnapshotTag>(
+          opts_,
+          memcache::failure::Category::kOther,
+          folly::sformat("Failed to write config snapshot {}", filePath),
+          1000);
+    }
+  });
+}
+
+folly::Optional<ConfigSnapshot> ConfigApi::readConfigSnapshot() const {
+  if (!isFirstConfig() || !opts_.config_snapshot ||
+      opts_.config_dump_root.empty()) {
+    return folly::none;
+  }
+  auto filePath = getBackupConfigDirectory(opts_) / kConfigSnapshotFile;
+  if (!boost::filesystem::exists(filePath)) {
+    return folly::none;
+  }
+  try {
+    folly::MemoryMapping mapping(filePath.c_str());
+    return ConfigSnapshot::deserialize(mapping.range());
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to read config snapshot " << filePath << ": "
+                 << e.what();
+    return folly::none;
+  }
+}
+
 bool ConfigApi::shouldReadFromBackupFiles() const {
   return readFromBackupFiles_;
 }
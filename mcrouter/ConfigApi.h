@@ -15,8 +15,11 @@
 #include <thread>
 #include <unordered_map>
 
+#include <folly/Optional.h>
+
 #include "mcrouter/CallbackPool.h"
 #include "mcrouter/ConfigApiIf.h"
+#include "mcrouter/ConfigSnapshot.h"
 
 namespace folly {
 struct dynamic;
@@ -149,6 +152,22 @@ class ConfigApi : public ConfigApiIf {
    */
   void enableReadingFromBackupFiles();
 
+  /**
+   * Saves a snapshot of the preprocessed config next to the backup config
+   * files. Asynchronous; does nothing unless both --config-snapshot and
+   * --config-dump-root are set.
+   */
+  void dumpConfigSnapshot(ConfigSnapshot snapshot);
+
+  /**
+   * Reads the snapshot saved by dumpConfigSnapshot(). Only done for the first
+   * configuration, since later the preprocessed config is built anyway.
+   *
+   * @return  none if there's no valid snapshot, or if this is not the first
+   *          configuration.
+   */
+  folly::Optional<ConfigSnapshot> readConfigSnapshot() const;
+
   struct PartialUpdate {
     std::string tierName;
     std::string oldApString;
@@ -175,6 +194,15 @@ class ConfigApi : public ConfigApiIf {
    */
   virtual bool checkFileUpdate();
 
+  /**
+   * Compares the contents of the sources of the current config with the
+   * ones it was built from, e.g. to skip reloads when a file was rewritten
+   * with the same data.
+   *
+   * @return true if any of them changed or can't be read anymore
+   */
+  virtual bool configSourcesChanged();
+
   /**
    * Save a piece of config source to disk.
    *
@@ -235,6 +263,17 @@ class ConfigApi : public ConfigApiIf {
   std::condition_variable finishCV_;
   std::atomic<bool> finish_;
 
+  /**
+   * Keeps polling for updates while the config files keep changing, so
+   * that a push writing several files causes a single reconfiguration.
+   */
+  void waitForUpdatesToSettle();
+
+  /**
+   * Waits for `timeout`, or until stopObserving() is called.
+   */
+  void waitFor(std::chrono::milliseconds timeout);
+
   std::atomic<bool> additionalCallbacksScheduled_{false};
   CallbackPool<> additionalCallbacks_;
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ConfigSnapshot.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <folly/experimental/bser/Bser.h>
+#include <folly/json.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+// Bump whenever the preprocessor output for the same inputs may change.
+constexpr int64_t kSnapshotVersion = 1;
+} // namespace
+
+bool ConfigSnapshot::importsUnchanged(ImportResolverIf& resolver) const {
+  for (const auto& it : imports.items()) {
+    try {
+      if (Md5Hash(resolver.import(it.first.stringPiece())) !=
+          it.second.stringPiece()) {
+        VLOG(1) << "Config snapshot is stale: " << it.first.asString()
+                << " changed";
+        return false;
+      }
+    } catch (const std::exception& e) {
+      VLOG(1) << "Config snapshot is stale: " << e.what();
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string ConfigSnapshot::serialize() const {
+  folly::dynamic snapshot = folly::dynamic::object("version", kSnapshotVersion)(
+      "key", key)("imports", imports)("config", config);
+  return folly::bser::toBser(snapshot, folly::bser::serialization_opts());
+}
+
+folly::Optional<ConfigSnapshot> ConfigSnapshot::deserialize(
+    folly::ByteRange data) {
+  try {
+    auto snapshot = folly::bser::parseBser(data);
+    auto jVersion = snapshot.get_ptr("version");
+    auto jKey = snapshot.get_ptr("key");
+    auto jImports = snapshot.get_ptr("imports");
+    auto jConfig = snapshot.get_ptr("config");
+    if (!jVersion || !jVersion->isInt() ||
+        jVersion->getInt() != kSnapshotVersion || !jKey || !jKey->isString() ||
+        !jImports || !jImports->isObject() || !jConfig) {
+      return folly::none;
+    }
+    for (const auto& it : jImports->items()) {
+      if (!it.first.isString() || !it.second.isString()) {
+        return folly::none;
+      }
+    }
+    ConfigSnapshot result;
+    result.key = jKey->getString();
+    result.imports = std::move(*jImports);
+    result.config = std::move(*jConfig);
+    return result;
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to parse config snapshot: " << e.what();
+    return folly::none;
+  }
+}
+
+std::string configSnapshotKey(
+    folly::StringPiece jsonC,
+    const folly::StringKeyedUnorderedMap<folly::dynamic>& globalParams) {
+  std::vector<std::pair<folly::StringPiece, const folly::dynamic*>> params;
+  params.reserve(globalParams.size());
+  for (const auto& it : globalParams) {
+    params.emplace_back(it.first, &it.second);
+  }
+  std::sort(params.begin(), params.end(), [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  });
+
+  std::string input = jsonC.str();
+  for (const auto& param : params) {
+    input.push_back('\0');
+    input.append(param.first.data(), param.first.size());
+    input.push_back('=');
+    input.append(folly::toJson(*param.second));
+  }
+  return Md5Hash(input);
+}
+
+std::string RecordingImportResolver::import(folly::StringPiece path) {
+  auto contents = resolver_.import(path);
+  imports_[path] = Md5Hash(contents);
+  return contents;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
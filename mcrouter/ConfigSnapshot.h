@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/dynamic.h>
+#include <folly/experimental/StringKeyedUnorderedMap.h>
+
+#include "mcrouter/lib/config/ImportResolverIf.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Fully preprocessed config (comments removed, macros expanded, @imports
+ * resolved), together with what's needed to tell whether it is still valid.
+ *
+ * Saved in a compact binary (BSER) file, so that loading it on startup is a
+ * single linear parse instead of a full macro expansion.
+ */
+struct ConfigSnapshot {
+  // See configSnapshotKey().
+  std::string key;
+  // md5 of the contents of every file resolved through @import, by path.
+  folly::dynamic imports = folly::dynamic::object;
+  folly::dynamic config;
+
+  /**
+   * @return  true if every import still has the recorded contents.
+   *          Imports are fetched through `resolver`, so that they get
+   *          tracked for changes exactly as if the config was expanded.
+   */
+  bool importsUnchanged(ImportResolverIf& resolver) const;
+
+  std::string serialize() const;
+
+  /**
+   * @return  none if `data` is not a valid snapshot.
+   */
+  static folly::Optional<ConfigSnapshot> deserialize(folly::ByteRange data);
+};
+
+/**
+ * Identifies the inputs of the preprocessor, other than imports:
+ * the config itself and all global params.
+ */
+std::string configSnapshotKey(
+    folly::StringPiece jsonC,
+    const folly::StringKeyedUnorderedMap<folly::dynamic>& globalParams);
+
+/**
+ * Forwards to another resolver and records md5 of everything imported.
+ */
+class RecordingImportResolver : public ImportResolverIf {
+ public:
+  explicit RecordingImportResolver(ImportResolverIf& resolver)
+      : resolver_(resolver) {}
+
+  std::string import(folly::StringPiece path) override;
+
+  folly::dynamic releaseImports() {
+    return std::move(imports_);
+  }
+
+ private:
+  ImportResolverIf& resolver_;
+  folly::dynamic imports_ = folly::dynamic::object;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Per proxy table of the reply counters of its destinations, one row per
+ * destination.
+ *
+ * Rows are allocated in chunks of kRowsPerChunk contiguous rows, so their
+ * addresses never change and a destination keeps a plain pointer to its row:
+ * counting a reply is one increment without an allocation check, and stats
+ * collection reads packed rows rather than one heap block per destination.
+ * Released rows are zeroed and reused by the next destination.
+ *
+ * Destinations are created with configs, possibly outside the proxy thread,
+ * so allocate() and release() take a lock. Counting doesn't: rows are only
+ * written on the proxy thread, and read by stats threads through the
+ * destinations, under the ProxyDestinationMap lock.
+ */
+class DestinationCounters {
+ public:
+  using Results =
+      std::array<uint64_t, static_cast<size_t>(carbon::Result::NUM_RESULTS)>;
+
+  static constexpr size_t kRowsPerChunk = 64;
+
+  DestinationCounters() = default;
+  DestinationCounters(const DestinationCounters&) = delete;
+  DestinationCounters& operator=(const DestinationCounters&) = delete;
+
+  /**
+   * @return  A zeroed row, valid until release().
+   */
+  Results* allocate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) {
+      chunks_.push_back(std::make_unique<Chunk>());
+      auto& rows = chunks_.back()->rows;
+      // Reversed, so that rows are handed out in address order.
+      for (size_t i = kRowsPerChunk; i > 0; --i) {
+        free_.push_back(&rows[i - 1]);
+      }
+    }
+    auto* row = free_.back();
+    free_.pop_back();
+    ++numAllocated_;
+    return row;
+  }
+
+  void release(Results* row) {
+    row->fill(0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(row);
+    --numAllocated_;
+  }
+
+  /**
+   * Number of rows in use.
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return numAllocated_;
+  }
+
+  /**
+   * Number of rows allocated, used or not.
+   */
+  size_t capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_.size() * kRowsPerChunk;
+  }
+
+ private:
+  struct Chunk {
+    std::array<Results, kRowsPerChunk> rows{};
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  std::vector<Results*> free_;
+  size_t numAllocated_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
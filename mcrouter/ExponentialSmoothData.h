@@ -37,6 +37,25 @@ class ExponentialSmoothData {
     }
   }
 
+  /**
+   * Same as calling insertSample() for every sample in [begin, end), with
+   * the value only loaded and stored once.
+   */
+  template <class Iterator>
+  void insertSamples(Iterator begin, Iterator end) {
+    if (begin == end) {
+      return;
+    }
+    auto value = currentValue_.load(std::memory_order_relaxed);
+    if (std::isnan(value)) {
+      value = *begin++;
+    }
+    for (; begin != end; ++begin) {
+      value = (*begin + (WindowSize - 1) * value) / WindowSize;
+    }
+    currentValue_.store(value, std::memory_order_relaxed);
+  }
+
   double value() const {
     auto value = currentValue_.load(std::memory_order_relaxed);
     return !std::isnan(value) ? value : 0.0;
@@ -46,6 +65,13 @@ class ExponentialSmoothData {
     return !std::isnan(currentValue_.load(std::memory_order_relaxed));
   }
 
+  /**
+   * Forgets all samples, the next one will be taken as is.
+   */
+  void reset() {
+    currentValue_.store(std::nan(""), std::memory_order_relaxed);
+  }
+
  private:
   std::atomic<double> currentValue_{std::nan("")};
 };
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "HotKeySketch.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+void sortByCount(std::vector<HotKeySketch::Item>& items) {
+  std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+    return a.count > b.count || (a.count == b.count && a.key < b.key);
+  });
+}
+
+} // namespace
+
+HotKeySketch::HotKeySketch(size_t capacity) : capacity_(capacity) {
+  assert(capacity_ > 0);
+  heap_.reserve(capacity_);
+  index_.reserve(capacity_);
+}
+
+void HotKeySketch::record(folly::StringPiece key, uint64_t weight) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  total_ += weight;
+
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    heap_[it->second].count += weight;
+    siftDown(it->second);
+    return;
+  }
+
+  if (heap_.size() < capacity_) {
+    heap_.push_back(Item{key.str(), weight, 0});
+    index_.emplace(key.str(), heap_.size() - 1);
+    siftUp(heap_.size() - 1);
+    return;
+  }
+
+  // Replace the least frequent key, inheriting its count as the error bound.
+  auto& min = heap_.front();
+  index_.erase(min.key);
+  auto minCount = min.count;
+  min.key = key.str();
+  min.count = minCount + weight;
+  min.error = minCount;
+  index_.emplace(min.key, 0);
+  siftDown(0);
+}
+
+bool HotKeySketch::isHot(folly::StringPiece key, uint64_t minCount) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+  const auto& item = heap_[it->second];
+  return item.count - item.error >= minCount;
+}
+
+std::vector<HotKeySketch::Item> HotKeySketch::snapshot() const {
+  std::vector<Item> items;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    items = heap_;
+  }
+  sortByCount(items);
+  return items;
+}
+
+uint64_t HotKeySketch::total() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_;
+}
+
+void HotKeySketch::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  heap_.clear();
+  index_.clear();
+  total_ = 0;
+}
+
+std::vector<HotKeySketch::Item> HotKeySketch::merge(
+    const std::vector<std::vector<Item>>& snapshots,
+    size_t limit) {
+  folly::F14FastMap<std::string, Item> merged;
+  for (const auto& snapshot : snapshots) {
+    for (const auto& item : snapshot) {
+      auto& out = merged[item.key];
+      out.count += item.count;
+      out.error += item.error;
+    }
+  }
+
+  std::vector<Item> items;
+  items.reserve(merged.size());
+  for (auto& it : merged) {
+    it.second.key = it.first;
+    items.push_back(std::move(it.second));
+  }
+  sortByCount(items);
+  if (items.size() > limit) {
+    items.resize(limit);
+  }
+  return items;
+}
+
+void HotKeySketch::siftUp(size_t pos) {
+  while (pos > 0) {
+    auto parent = (pos - 1) / 2;
+    if (heap_[parent].count <= heap_[pos].count) {
+      break;
+    }
+    swapItems(parent, pos);
+    pos = parent;
+  }
+}
+
+void HotKeySketch::siftDown(size_t pos) {
+  while (true) {
+    auto smallest = pos;
+    auto left = 2 * pos + 1;
+    auto right = left + 1;
+    if (left < heap_.size() && heap_[left].count < heap_[smallest].count) {
+      smallest = left;
+    }
+    if (right < heap_.size() && heap_[right].count < heap_[smallest].count) {
+      smallest = right;
+    }
+    if (smallest == pos) {
+      return;
+    }
+    swapItems(pos, smallest);
+    pos = smallest;
+  }
+}
+
+void HotKeySketch::swapItems(size_t a, size_t b) {
+  std::swap(heap_[a], heap_[b]);
+  index_.find(heap_[a].key)->second = a;
+  index_.find(heap_[b].key)->second = b;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
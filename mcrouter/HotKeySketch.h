@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Streaming heavy-hitters sketch ("Space-Saving", Metwally et al.) that tracks
+ * the approximate top `capacity` keys seen.
+ *
+ * Every tracked key has a count that overestimates its true frequency by at
+ * most `error`. Any key whose true frequency is above N / capacity, where N is
+ * the total number of recorded keys, is guaranteed to be tracked.
+ *
+ * Each proxy owns one sketch and is the only writer; readers on other threads
+ * (stats commands) take a snapshot, so the sketch is guarded by a mutex that
+ * is uncontended in the common case.
+ */
+class HotKeySketch {
+ public:
+  struct Item {
+    std::string key;
+    uint64_t count{0};
+    uint64_t error{0};
+  };
+
+  explicit HotKeySketch(size_t capacity);
+
+  HotKeySketch(const HotKeySketch&) = delete;
+  HotKeySketch& operator=(const HotKeySketch&) = delete;
+
+  void record(folly::StringPiece key, uint64_t weight = 1);
+
+  /**
+   * @return  true if `key` is currently among the tracked keys with a
+   *          guaranteed count (count - error) of at least `minCount`.
+   */
+  bool isHot(folly::StringPiece key, uint64_t minCount = 1) const;
+
+  /**
+   * @return  copy of all tracked keys, sorted by descending count.
+   */
+  std::vector<Item> snapshot() const;
+
+  /**
+   * Total weight recorded so far.
+   */
+  uint64_t total() const;
+
+  void clear();
+
+  /**
+   * Sums up snapshots of several sketches (e.g. one per proxy) and returns
+   * the `limit` heaviest keys, sorted by descending count.
+   */
+  static std::vector<Item> merge(
+      const std::vector<std::vector<Item>>& snapshots,
+      size_t limit);
+
+ private:
+  const size_t capacity_;
+
+  mutable std::mutex mutex_;
+  // Binary min-heap on count, so that the least frequent key can be replaced
+  // in O(log(capacity)).
+  std::vector<Item> heap_;
+  folly::F14FastMap<std::string, size_t> index_;
+  uint64_t total_{0};
+
+  void siftUp(size_t pos);
+  void siftDown(size_t pos);
+  void swapItems(size_t a, size_t b);
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
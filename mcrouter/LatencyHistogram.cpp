@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "LatencyHistogram.h"
+
+#include <cmath>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+void LatencyHistogram::advance() {
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    auto count = folly::make_atomic_ref(counts_[i]).load(
+        std::memory_order_relaxed);
+    auto delta = count - lastCounts_[i];
+    lastCounts_[i] = count;
+
+    auto ref = folly::make_atomic_ref(window_[i]);
+    auto window = ref.load(std::memory_order_relaxed);
+    // Round the decay up, so that the window eventually drains.
+    ref.store(
+        window - (window + kDecay - 1) / kDecay + delta,
+        std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::addWindowTo(Counts& counts) const {
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    counts[i] += folly::make_atomic_ref(const_cast<uint64_t&>(window_[i]))
+                     .load(std::memory_order_relaxed);
+  }
+}
+
+uint64_t LatencyHistogram::percentile(const Counts& counts, double p) {
+  uint64_t total = 0;
+  for (auto count : counts) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  auto target = static_cast<uint64_t>(std::ceil(total * p / 100.0));
+  if (target == 0) {
+    target = 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= target) {
+      return bucketValue(i);
+    }
+  }
+  return bucketValue(kNumBuckets - 1);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <folly/lang/Bits.h>
+#include <folly/synchronization/AtomicRef.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Log-linear (HDR style) histogram of latencies in microseconds.
+ *
+ * Every power of two is split into kSubBuckets buckets, so any percentile is
+ * known within 1/kSubBuckets of its value, from 1us up to ~17 minutes.
+ * Recording a sample is a couple of instructions and never allocates.
+ *
+ * Samples are folded into a decaying window by advance(), so percentiles
+ * reflect roughly the last kDecay calls to advance() (seconds, when called
+ * from the stats update). Windows of several histograms (e.g. one per proxy)
+ * can be added together with addWindowTo() before computing percentiles.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketsShift = 3;
+  static constexpr size_t kSubBuckets = 1 << kSubBucketsShift;
+  // Highest bit of the largest value tracked, larger values are clamped.
+  static constexpr size_t kMaxBit = 30;
+  static constexpr size_t kNumBuckets =
+      (kMaxBit - kSubBucketsShift + 2) * kSubBuckets;
+  static constexpr uint64_t kDecay = 16;
+
+  using Counts = std::array<uint64_t, kNumBuckets>;
+
+  /**
+   * Only the thread owning the histogram (i.e. proxy thread) may record.
+   */
+  void record(uint64_t valueUs) {
+    auto ref = folly::make_atomic_ref(counts_[bucketIndex(valueUs)]);
+    ref.store(
+        ref.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Folds samples recorded since the last call into the window, and decays
+   * older ones by 1/kDecay. Must not be called concurrently with itself.
+   */
+  void advance();
+
+  /**
+   * Adds the current window to `counts`. May be called from any thread.
+   */
+  void addWindowTo(Counts& counts) const;
+
+  /**
+   * @param p  Percentile in [0, 100].
+   * @return   Value below which `p` percent of `counts` fall. 0 if
+   *           `counts` is empty.
+   */
+  static uint64_t percentile(const Counts& counts, double p);
+
+  static size_t bucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    size_t bit = folly::findLastSet(value) - 1;
+    if (bit > kMaxBit) {
+      return kNumBuckets - 1;
+    }
+    size_t shift = bit - kSubBucketsShift;
+    return (shift + 1) * kSubBuckets + ((value >> shift) & (kSubBuckets - 1));
+  }
+
+  /**
+   * @return  Middle of the range of values in bucket `idx`.
+   */
+  static uint64_t bucketValue(size_t idx) {
+    if (idx < kSubBuckets) {
+      return idx;
+    }
+    size_t shift = idx / kSubBuckets - 1;
+    uint64_t lower = (kSubBuckets + idx % kSubBuckets) << shift;
+    return lower + ((uint64_t(1) << shift) >> 1);
+  }
+
+ private:
+  // Samples recorded since creation, written by the owning thread.
+  Counts counts_{};
+  // counts_ as of the last advance().
+  Counts lastCounts_{};
+  Counts window_{};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -58,15 +58,16 @@ LeaseTokenMap::~LeaseTokenMap() {
 }
 
 uint64_t LeaseTokenMap::insert(std::string routeName, Item item) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t specialToken =
+      applyMagic(nextId_.fetch_add(1, std::memory_order_relaxed));
 
-  uint64_t specialToken = applyMagic(nextId_++);
-
-  auto it = data_.emplace(
+  auto& shard = shardFor(specialToken);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.data.emplace(
       specialToken,
       LeaseTokenMap::ListItem(
           specialToken, std::move(routeName), std::move(item), leaseTokenTtl_));
-  invalidationQueue_.push_back(it.first->second);
+  shard.invalidationQueue.push_back(it.first->second);
 
   return specialToken;
 }
@@ -81,11 +82,12 @@ folly::Optional<LeaseTokenMap::Item> LeaseTokenMap::query(
   }
 
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = data_.find(token);
-    if (it != data_.end() && it->second.routeName == routeName) {
+    auto& shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.data.find(token);
+    if (it != shard.data.end() && it->second.routeName == routeName) {
       item.emplace(std::move(it->second.item));
-      data_.erase(it);
+      shard.data.erase(it);
     }
   }
 
@@ -100,9 +102,10 @@ uint64_t LeaseTokenMap::getOriginalLeaseToken(
   }
 
   {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = data_.find(token);
-    if (it != data_.end() && it->second.routeName == routeName) {
+    const auto& shard = shardFor(token);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.data.find(token);
+    if (it != shard.data.end() && it->second.routeName == routeName) {
       return it->second.item.originalToken;
     }
   }
@@ -111,18 +114,26 @@ uint64_t LeaseTokenMap::getOriginalLeaseToken(
 
 void LeaseTokenMap::tokenCleanupTimeout() {
   const auto now = ListItem::Clock::now();
-  std::lock_guard<std::mutex> lock(mutex_);
-  auto cur = invalidationQueue_.begin();
-  while (cur != invalidationQueue_.end() && cur->tokenTimeout <= now) {
-    uint64_t specialToken = cur->specialToken;
-    cur = invalidationQueue_.erase(cur);
-    data_.erase(specialToken);
+  // Shards are cleaned up one at a time, so a shard is never locked for
+  // longer than it takes to expire its own tokens.
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto cur = shard.invalidationQueue.begin();
+    while (cur != shard.invalidationQueue.end() && cur->tokenTimeout <= now) {
+      uint64_t specialToken = cur->specialToken;
+      cur = shard.invalidationQueue.erase(cur);
+      shard.data.erase(specialToken);
+    }
   }
 }
 
 size_t LeaseTokenMap::size() const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  return data_.size();
+  size_t total = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.data.size();
+  }
+  return total;
 }
 
 bool LeaseTokenMap::conflicts(uint64_t originalToken) {
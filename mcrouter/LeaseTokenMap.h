@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <memory>
@@ -16,6 +18,7 @@
 #include <folly/IntrusiveList.h>
 #include <folly/Optional.h>
 #include <folly/Range.h>
+#include <folly/concurrency/CacheLocality.h>
 #include <folly/experimental/FunctionScheduler.h>
 
 namespace folly {
@@ -29,6 +32,10 @@ namespace mcrouter {
 /**
  * Class responsible for mapping lease-tokens to destinations.
  * All operations are thread-safe.
+ *
+ * Tokens are spread over kNumShards independently locked shards, selected by
+ * the low bits of the id encoded in the special token, so concurrent proxies
+ * rarely contend on the same lock.
  */
 class LeaseTokenMap {
  public:
@@ -130,15 +137,34 @@ class LeaseTokenMap {
     folly::IntrusiveListHook listHook;
   };
 
+  static constexpr size_t kNumShards = 64;
+  static_assert(
+      (kNumShards & (kNumShards - 1)) == 0,
+      "kNumShards must be a power of two");
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    // Underlying data structure.
+    std::unordered_map<uint64_t, ListItem> data;
+    // Keeps an in-order list of what should be invalidated.
+    folly::IntrusiveList<ListItem, &ListItem::listHook> invalidationQueue;
+    // Mutex to synchronize access to this shard.
+    mutable std::mutex mutex;
+  };
+
   // Hold the id of the next element to be inserted in the data structure.
-  uint32_t nextId_{0};
-
-  // Underlying data structure.
-  std::unordered_map<uint64_t, ListItem> data_;
-  // Keeps an in-order list of what should be invalidated.
-  folly::IntrusiveList<ListItem, &ListItem::listHook> invalidationQueue_;
-  // Mutex to synchronize access to underlying data structure
-  mutable std::mutex mutex_;
+  std::atomic<uint32_t> nextId_{0};
+
+  std::array<Shard, kNumShards> shards_;
+
+  static size_t shardIndex(uint64_t specialToken) {
+    return specialToken & (kNumShards - 1);
+  }
+  Shard& shardFor(uint64_t specialToken) {
+    return shards_[shardIndex(specialToken)];
+  }
+  const Shard& shardFor(uint64_t specialToken) const {
+    return shards_[shardIndex(specialToken)];
+  }
 
   std::weak_ptr<folly::FunctionScheduler> functionScheduler_;
   const std::string timeoutFunctionName_;
@@ -51,7 +51,7 @@ FOLLY_NOINLINE bool spoolAxonProxy(
     pool.emplace(axonCtx->poolFilter);
   }
   // Run off fiber to save fiber stack for serialization
-  auto kvPairs = folly::fibers::runInMainContext([&req, &region, &pool]() {
+  auto serialized = folly::fibers::runInMainContext([&req]() {
     auto finalReq =
         req.attributes_ref()->find(memcache::kMcDeleteReqAttrSource) ==
             req.attributes_ref()->cend()
@@ -59,9 +59,20 @@ FOLLY_NOINLINE bool spoolAxonProxy(
               req, memcache::McDeleteRequestSource::FAILED_INVALIDATION))
         : req;
     finalReq.key_ref()->stripRoutingPrefix();
-    auto serialized = invalidation::McInvalidationKvPairs::serialize<
-                          memcache::McDeleteRequest>(finalReq)
-                          .template to<std::string>();
+    return invalidation::McInvalidationKvPairs::serialize<
+               memcache::McDeleteRequest>(finalReq)
+        .template to<std::string>();
+  });
+  if (auto batcher = proxy.axonBatcher()) {
+    return batcher->write(
+        axonCtx,
+        bucketId,
+        std::move(region),
+        std::move(pool),
+        req.key_ref()->keyWithoutRoute().str(),
+        std::move(serialized));
+  }
+  auto kvPairs = folly::fibers::runInMainContext([&]() {
     return invalidation::McInvalidationKvPairs::createAxonKvPairs(
         serialized, std::move(region), std::move(pool));
   });
@@ -79,18 +90,14 @@ FOLLY_NOINLINE bool spoolAsynclog(
   }
   folly::StringPiece key = keepRoutingPrefix ? req.key_ref()->fullKey()
                                              : req.key_ref()->keyWithoutRoute();
-  folly::fibers::Baton b;
   auto res = false;
-  auto attr = *req.attributes_ref();
+  const auto& attr = *req.attributes_ref();
   const auto asyncWriteStartUs = nowUs();
   auto asyncWriter = proxy->router().asyncWriter();
+  std::optional<AsyncLog::PendingDelete> entry;
   if (asyncWriter && host) {
-    res = asyncWriter->run([&b, &attr, &host, proxy, key, asynclogName]() {
-      if (proxy->asyncLog().writeDelete(*host, key, asynclogName, attr)) {
-        proxy->stats().increment(asynclog_spool_success_rate_stat);
-      }
-      b.post();
-    });
+    entry.emplace(*host, key, asynclogName, attr);
+    res = proxy->asyncLog().enqueueDelete(*asyncWriter, *entry);
   }
 
   if (!host) {
@@ -109,7 +116,12 @@ FOLLY_NOINLINE bool spoolAsynclog(
         asynclogName);
   } else {
     // Don't reply to the user until we safely logged the request to disk
-    b.wait();
+    proxy->stats().increment(asynclog_queue_size_stat);
+    entry->done.wait();
+    proxy->stats().decrement(asynclog_queue_size_stat);
+    if (entry->written) {
+      proxy->stats().increment(asynclog_spool_success_rate_stat);
+    }
     const auto asyncWriteDurationUs = nowUs() - asyncWriteStartUs;
     proxy->stats().asyncLogDurationUs().insertSample(asyncWriteDurationUs);
     proxy->stats().increment(asynclog_requests_rate_stat);
@@ -19,6 +19,7 @@
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Aligned.h>
 
+#include "mcrouter/lib/debug/RequestTracer.h"
 #include "mcrouter/lib/network/ServerLoad.h"
 
 namespace facebook {
@@ -88,14 +89,17 @@ class fiber_local {
     folly::StringPiece asynclogName;
     int64_t networkTransportTimeUs{0};
     ServerLoad load{0};
-    std::vector<ExtraDataCallbackT> extraDataCallbacks;
+    // Shared by all copies of the context (e.g. made by runWithLocals() or
+    // when spawning a fiber), cloned on first modification.
+    std::shared_ptr<std::vector<ExtraDataCallbackT>> extraDataCallbacks;
     std::shared_ptr<AxonContext> axonCtx{nullptr};
     int64_t accumulatedBeforeReqInjectedLatencyUs{0};
     int64_t accumulatedAfterReqInjectedLatencyUs{0};
+    RequestTracer::Context traceContext;
   };
 
   static auto makeGuardHelperBase(McrouterFiberContext&& tmp) {
-    return folly::makeGuard([tmp]() mutable {
+    return folly::makeGuard([tmp = std::move(tmp)]() mutable {
       folly::fibers::local<McrouterFiberContext>() = std::move(tmp);
     });
   }
@@ -111,6 +115,18 @@ class fiber_local {
     return makeGuardHelperBase(std::move(tmp));
   }
 
+  static std::vector<ExtraDataCallbackT>& mutableExtraDataCallbacks() {
+    auto& callbacks =
+        folly::fibers::local<McrouterFiberContext>().extraDataCallbacks;
+    if (!callbacks) {
+      callbacks = std::make_shared<std::vector<ExtraDataCallbackT>>();
+    } else if (callbacks.use_count() > 1) {
+      // All owners live on this thread, so the count can't change under us.
+      callbacks = std::make_shared<std::vector<ExtraDataCallbackT>>(*callbacks);
+    }
+    return *callbacks;
+  }
+
  public:
   using ContextTypeTag = folly::fibers::LocalType<McrouterFiberContext>;
 
@@ -164,6 +180,15 @@ class fiber_local {
     return folly::fibers::local<McrouterFiberContext>().sharedCtx.get();
   }
 
+  /**
+   * Trace context of current fiber (thread, if we're not on fiber): the span
+   * of the route handle being traced, if the request is sampled. Fibers
+   * started by a route handle inherit it.
+   */
+  static RequestTracer::Context& traceContext() {
+    return folly::fibers::local<McrouterFiberContext>().traceContext;
+  }
+
   /**
    * Add a RequestClass for current fiber (thread, if we're not on fiber)
    */
@@ -319,8 +344,7 @@ class fiber_local {
    * @return The index of new added callback function.
    */
   static size_t addExtraDataCallbacks(ExtraDataCallbackT&& callback) {
-    auto& callbacks =
-        folly::fibers::local<McrouterFiberContext>().extraDataCallbacks;
+    auto& callbacks = mutableExtraDataCallbacks();
     callbacks.push_back(std::move(callback));
     return callbacks.size() - 1;
   }
@@ -331,15 +355,17 @@ class fiber_local {
   static void updateExtraDataCallbacks(
       size_t idx,
       ExtraDataCallbackT&& callback) {
-    folly::fibers::local<McrouterFiberContext>().extraDataCallbacks[idx] =
-        std::move(callback);
+    mutableExtraDataCallbacks()[idx] = std::move(callback);
   }
 
   /**
    * Return all callback functions to compute extra data for logging.
    */
   static const std::vector<ExtraDataCallbackT>& getExtraDataCallbacks() {
-    return folly::fibers::local<McrouterFiberContext>().extraDataCallbacks;
+    static const std::vector<ExtraDataCallbackT> kEmpty;
+    const auto& callbacks =
+        folly::fibers::local<McrouterFiberContext>().extraDataCallbacks;
+    return callbacks ? *callbacks : kEmpty;
   }
 
   /**
@@ -371,7 +397,7 @@ class fiber_local {
 
   static void setDistributionTargetRegion(std::string region) {
     folly::fibers::local<McrouterFiberContext>().distributionTargetRegion =
-        region;
+        std::move(region);
   }
 
   static std::optional<std::string> getDistributionTargetRegion() {
@@ -16,6 +16,7 @@
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <folly/Conv.h>
 #include <folly/DynamicConverter.h>
 #include <folly/dynamic.h>
 #include <folly/json.h>
@@ -36,6 +37,7 @@ namespace mcrouter {
 namespace {
 
 const char* kStatsSfx = "stats";
+const char* kPrometheusStatsSfx = "prom";
 const char* kStatsStartupOptionsSfx = "startup_options";
 const char* kConfigSourcesInfoFileName = "config_sources_info";
 
@@ -124,6 +126,102 @@ void write_stats_to_disk(
   }
 }
 
+// Appends `name` with the characters Prometheus doesn't allow in metric names
+// replaced by '_'.
+void appendPrometheusName(std::string& out, folly::StringPiece name) {
+  for (const char c : name) {
+    const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9') || c == '_' || c == ':';
+    out.push_back(valid ? c : '_');
+  }
+}
+
+template <class Value>
+void appendPrometheusSample(
+    std::string& out,
+    folly::StringPiece name,
+    folly::StringPiece labels,
+    Value value) {
+  out.append("mcrouter_");
+  appendPrometheusName(out, name);
+  out.append(labels.begin(), labels.end());
+  out.push_back(' ');
+  folly::toAppend(value, &out);
+  out.push_back('\n');
+}
+
+/**
+ * Same stats as write_stats_to_disk(), in the Prometheus text exposition
+ * format. Every sample is labeled with the stats prefix of the router, so
+ * files of several routers can be collected together.
+ */
+void write_prometheus_stats_to_disk(
+    const McrouterOptions& opts,
+    std::vector<stat_t>& stats,
+    const folly::dynamic& requestStats) {
+  try {
+    std::string labels = "{router=\"";
+    for (const char c : getStatPrefix(opts)) {
+      if (c == '"' || c == '\\') {
+        labels.push_back('\\');
+      }
+      labels.push_back(c);
+    }
+    labels.append("\"}");
+
+    std::string out;
+    // Roughly the size of a sample, to not grow the buffer again and again.
+    out.reserve((stats.size() + requestStats.size()) * 64);
+    for (size_t i = 0; i < stats.size(); ++i) {
+      if (!(stats[i].group & ods_stats)) {
+        continue;
+      }
+      switch (stats[i].type) {
+        case stat_uint64:
+          appendPrometheusSample(
+              out,
+              stats[i].name,
+              labels,
+              folly::make_atomic_ref(stats[i].data.uint64)
+                  .load(std::memory_order_relaxed));
+          break;
+        case stat_int64:
+          appendPrometheusSample(
+              out,
+              stats[i].name,
+              labels,
+              folly::make_atomic_ref(stats[i].data.int64)
+                  .load(std::memory_order_relaxed));
+          break;
+        case stat_double:
+          appendPrometheusSample(
+              out,
+              stats[i].name,
+              labels,
+              folly::make_atomic_ref(stats[i].data.dbl)
+                  .load(std::memory_order_relaxed));
+          break;
+        default:
+          break;
+      }
+    }
+
+    for (const auto& kv : requestStats.items()) {
+      if (kv.second.isInt()) {
+        appendPrometheusSample(
+            out, kv.first.stringPiece(), labels, kv.second.getInt());
+      } else if (kv.second.isDouble()) {
+        appendPrometheusSample(
+            out, kv.first.stringPiece(), labels, kv.second.getDouble());
+      }
+    }
+
+    write_file(opts, kPrometheusStatsSfx, out);
+  } catch (const std::exception& e) {
+    VLOG(1) << "Failed to write Prometheus stats to disk: " << e.what();
+  }
+}
+
 void write_config_sources_info_to_disk(CarbonRouterInstanceBase& router) {
   auto config_info_json = router.configApi().getConfigSourcesInfo();
 
@@ -249,6 +347,9 @@ void McrouterLogger::log() {
   }
 
   write_stats_to_disk(router_.opts(), stats, requestStats);
+  if (router_.opts().stats_logging_prometheus) {
+    write_prometheus_stats_to_disk(router_.opts(), stats, requestStats);
+  }
   write_config_sources_info_to_disk(router_);
 
   for (const auto& filepath : touchStatsFilepaths_) {
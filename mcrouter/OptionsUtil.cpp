@@ -46,6 +46,14 @@ std::string getClientDebugFifoFullPath(const McrouterOptions& opts) {
 std::string getServerDebugFifoFullPath(const McrouterOptions& opts) {
   return getDebugFifoFullPath(opts, "server");
 }
+
+std::string getRouteProfileDebugFifoFullPath(const McrouterOptions& opts) {
+  return getDebugFifoFullPath(opts, "route_profile");
+}
+
+std::string getRequestTracesDebugFifoFullPath(const McrouterOptions& opts) {
+  return getDebugFifoFullPath(opts, "request_traces");
+}
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
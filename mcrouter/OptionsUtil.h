@@ -38,6 +38,10 @@ std::string getClientDebugFifoFullPath(const McrouterOptions& opts);
  * @return        Full path of the fifo.
  */
 std::string getServerDebugFifoFullPath(const McrouterOptions& opts);
+
+std::string getRouteProfileDebugFifoFullPath(const McrouterOptions& opts);
+
+std::string getRequestTracesDebugFifoFullPath(const McrouterOptions& opts);
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -97,6 +97,7 @@ PoolFactory::PoolJson PoolFactory::parsePool(const folly::dynamic& json) {
   checkLogic(
       json.isString() || json.isObject(),
       "Pool should be a string (name of pool) or an object");
+  std::lock_guard<std::mutex> lock(mutex_);
   if (json.isString()) {
     return parseNamedPool(json.stringPiece());
   }
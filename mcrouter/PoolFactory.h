@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include <folly/dynamic.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 #include <folly/json.h>
@@ -19,6 +21,9 @@ class ConfigApiIf;
 
 /**
  * Parses mcrouter pools from mcrouter config.
+ *
+ * parsePool() is thread-safe, so that one factory can be shared by configs
+ * built in parallel. Returned references stay valid for the factory lifetime.
  */
 class PoolFactory {
  public:
@@ -64,6 +69,7 @@ class PoolFactory {
 
  private:
   enum class PoolState { NEW, PARSING, PARSED };
+  std::mutex mutex_;
   folly::StringKeyedUnorderedMap<std::pair<folly::dynamic, PoolState>> pools_;
   ConfigApiIf& configApi_;
   // Contains metadata of the parsed config
@@ -8,8 +8,10 @@
 #pragma once
 
 #include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/io/IOBuf.h>
 
 #include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/stats.h"
 
 namespace facebook {
@@ -27,7 +29,35 @@ class PoolStats {
         durationUsStatName_(
             folly::to<std::string>(poolName, ".duration_us.avg")),
         totalDurationUsStatName_(
-            folly::to<std::string>(poolName, ".total_duration_us.avg")) {
+            folly::to<std::string>(poolName, ".total_duration_us.avg")),
+        durationUsP50StatName_(
+            folly::to<std::string>(poolName, ".duration_us.p50")),
+        durationUsP99StatName_(
+            folly::to<std::string>(poolName, ".duration_us.p99")),
+        durationUsP999StatName_(
+            folly::to<std::string>(poolName, ".duration_us.p999")),
+        tcpRttUsP50StatName_(
+            folly::to<std::string>(poolName, ".tcp_rtt_us.p50")),
+        tcpRttUsP99StatName_(
+            folly::to<std::string>(poolName, ".tcp_rtt_us.p99")),
+        tcpRetransP99StatName_(
+            folly::to<std::string>(poolName, ".tcp_retrans.p99")),
+        keyBytesP50StatName_(
+            folly::to<std::string>(poolName, ".key_bytes.p50")),
+        keyBytesP99StatName_(
+            folly::to<std::string>(poolName, ".key_bytes.p99")),
+        requestValueBytesP50StatName_(
+            folly::to<std::string>(poolName, ".request_value_bytes.p50")),
+        requestValueBytesP99StatName_(
+            folly::to<std::string>(poolName, ".request_value_bytes.p99")),
+        replyValueBytesP50StatName_(
+            folly::to<std::string>(poolName, ".reply_value_bytes.p50")),
+        replyValueBytesP99StatName_(
+            folly::to<std::string>(poolName, ".reply_value_bytes.p99")),
+        batchSizeP50StatName_(
+            folly::to<std::string>(poolName, ".batch_size.p50")),
+        batchSizeP99StatName_(
+            folly::to<std::string>(poolName, ".batch_size.p99")) {
     initStat(requestCountStat_, requestsCountStatName_);
     initStat(finalResultErrorStat_, finalResultErrorStatName_);
     initStat(nConnectionsStat_, nConnectionsStatName_);
@@ -67,6 +97,157 @@ class PoolStats {
 
   void addDurationSample(int64_t duration) {
     durationUsStat_.insertSample(duration);
+    durationHistogram_.record(duration > 0 ? duration : 0);
+  }
+
+  LatencyHistogram& durationHistogram() {
+    return durationHistogram_;
+  }
+
+  /**
+   * A TCP_INFO sample of one of the pool's connections: its RTT, and the
+   * retransmits since the previous sample.
+   */
+  void addTcpInfoSample(uint32_t rttUs, uint32_t retrans) {
+    tcpRttHistogram_.record(rttUs);
+    tcpRetransHistogram_.record(retrans);
+  }
+
+  LatencyHistogram& tcpRttHistogram() {
+    return tcpRttHistogram_;
+  }
+
+  LatencyHistogram& tcpRetransHistogram() {
+    return tcpRetransHistogram_;
+  }
+
+  /**
+   * Sizes in bytes of a request sent to the pool: its key, and its value if
+   * it has one (i.e. updates).
+   */
+  void addRequestSizeSample(size_t keyBytes, const folly::IOBuf* value) {
+    keyBytesHistogram_.record(keyBytes);
+    if (value != nullptr) {
+      requestValueBytesHistogram_.record(value->computeChainDataLength());
+    }
+  }
+
+  /**
+   * Size in bytes of a value returned by the pool (i.e. get hits).
+   */
+  void addReplyValueSizeSample(size_t valueBytes) {
+    replyValueBytesHistogram_.record(valueBytes);
+  }
+
+  /**
+   * Number of requests written at once to one of the pool's destinations:
+   * requests queued within the same event loop iteration, which for gets is
+   * the fan-out of a multiget onto a single server.
+   */
+  void addBatchSizeSample(size_t numRequests) {
+    batchSizeHistogram_.record(numRequests);
+  }
+
+  LatencyHistogram& keyBytesHistogram() {
+    return keyBytesHistogram_;
+  }
+
+  LatencyHistogram& requestValueBytesHistogram() {
+    return requestValueBytesHistogram_;
+  }
+
+  LatencyHistogram& replyValueBytesHistogram() {
+    return replyValueBytesHistogram_;
+  }
+
+  LatencyHistogram& batchSizeHistogram() {
+    return batchSizeHistogram_;
+  }
+
+  /**
+   * Advances the histograms (see LatencyHistogram::advance()).
+   */
+  void advance() {
+    durationHistogram_.advance();
+    tcpRttHistogram_.advance();
+    tcpRetransHistogram_.advance();
+    keyBytesHistogram_.advance();
+    requestValueBytesHistogram_.advance();
+    replyValueBytesHistogram_.advance();
+    batchSizeHistogram_.advance();
+    LatencyHistogram::Counts rtts{};
+    tcpRttHistogram_.addWindowTo(rtts);
+    folly::make_atomic_ref(rttMedianUs_)
+        .store(
+            LatencyHistogram::percentile(rtts, 50), std::memory_order_relaxed);
+  }
+
+  /**
+   * Median RTT of this proxy's connections to the pool as of the last
+   * advance(), 0 if none were sampled.
+   */
+  uint64_t rttMedianUs() const {
+    return folly::make_atomic_ref(rttMedianUs_).load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Percentile stats of the pool, given the duration histogram windows of
+   * this pool merged across all proxies.
+   */
+  std::vector<stat_t> getPercentileStats(
+      const LatencyHistogram::Counts& durations) const {
+    std::vector<stat_t> stats(3);
+    initStat(stats[0], durationUsP50StatName_);
+    initStat(stats[1], durationUsP99StatName_);
+    initStat(stats[2], durationUsP999StatName_);
+    stats[0].data.uint64 = LatencyHistogram::percentile(durations, 50);
+    stats[1].data.uint64 = LatencyHistogram::percentile(durations, 99);
+    stats[2].data.uint64 = LatencyHistogram::percentile(durations, 99.9);
+    return stats;
+  }
+
+  /**
+   * Same, for the TCP_INFO histograms.
+   */
+  std::vector<stat_t> getTcpInfoStats(
+      const LatencyHistogram::Counts& rtts,
+      const LatencyHistogram::Counts& retrans) const {
+    std::vector<stat_t> stats(3);
+    initStat(stats[0], tcpRttUsP50StatName_);
+    initStat(stats[1], tcpRttUsP99StatName_);
+    initStat(stats[2], tcpRetransP99StatName_);
+    stats[0].data.uint64 = LatencyHistogram::percentile(rtts, 50);
+    stats[1].data.uint64 = LatencyHistogram::percentile(rtts, 99);
+    stats[2].data.uint64 = LatencyHistogram::percentile(retrans, 99);
+    return stats;
+  }
+
+  /**
+   * Same, for the size histograms.
+   */
+  std::vector<stat_t> getSizeStats(
+      const LatencyHistogram::Counts& keyBytes,
+      const LatencyHistogram::Counts& requestValueBytes,
+      const LatencyHistogram::Counts& replyValueBytes,
+      const LatencyHistogram::Counts& batchSizes) const {
+    std::vector<stat_t> stats(8);
+    initStat(stats[0], keyBytesP50StatName_);
+    initStat(stats[1], keyBytesP99StatName_);
+    initStat(stats[2], requestValueBytesP50StatName_);
+    initStat(stats[3], requestValueBytesP99StatName_);
+    initStat(stats[4], replyValueBytesP50StatName_);
+    initStat(stats[5], replyValueBytesP99StatName_);
+    initStat(stats[6], batchSizeP50StatName_);
+    initStat(stats[7], batchSizeP99StatName_);
+    stats[0].data.uint64 = LatencyHistogram::percentile(keyBytes, 50);
+    stats[1].data.uint64 = LatencyHistogram::percentile(keyBytes, 99);
+    stats[2].data.uint64 = LatencyHistogram::percentile(requestValueBytes, 50);
+    stats[3].data.uint64 = LatencyHistogram::percentile(requestValueBytes, 99);
+    stats[4].data.uint64 = LatencyHistogram::percentile(replyValueBytes, 50);
+    stats[5].data.uint64 = LatencyHistogram::percentile(replyValueBytes, 99);
+    stats[6].data.uint64 = LatencyHistogram::percentile(batchSizes, 50);
+    stats[7].data.uint64 = LatencyHistogram::percentile(batchSizes, 99);
+    return stats;
   }
 
   void updateConnections(int64_t amount = 1) {
@@ -95,11 +276,34 @@ class PoolStats {
   const std::string nConnectionsStatName_;
   const std::string durationUsStatName_;
   const std::string totalDurationUsStatName_;
+  const std::string durationUsP50StatName_;
+  const std::string durationUsP99StatName_;
+  const std::string durationUsP999StatName_;
+  const std::string tcpRttUsP50StatName_;
+  const std::string tcpRttUsP99StatName_;
+  const std::string tcpRetransP99StatName_;
+  const std::string keyBytesP50StatName_;
+  const std::string keyBytesP99StatName_;
+  const std::string requestValueBytesP50StatName_;
+  const std::string requestValueBytesP99StatName_;
+  const std::string replyValueBytesP50StatName_;
+  const std::string replyValueBytesP99StatName_;
+  const std::string batchSizeP50StatName_;
+  const std::string batchSizeP99StatName_;
   stat_t nConnectionsStat_;
   stat_t requestCountStat_;
   stat_t finalResultErrorStat_;
   ExponentialSmoothData<64> totalDurationUsStat_;
   ExponentialSmoothData<64> durationUsStat_;
+  LatencyHistogram durationHistogram_;
+  LatencyHistogram tcpRttHistogram_;
+  LatencyHistogram tcpRetransHistogram_;
+  // Sizes aren't latencies, but are log-bucketed all the same.
+  LatencyHistogram keyBytesHistogram_;
+  LatencyHistogram requestValueBytesHistogram_;
+  LatencyHistogram replyValueBytesHistogram_;
+  LatencyHistogram batchSizeHistogram_;
+  uint64_t rttMedianUs_{0};
 };
 
 } // namespace mcrouter
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ProbeScheduler.h"
+
+#include <algorithm>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+ProbeScheduler::ProbeScheduler(
+    std::chrono::milliseconds initialDelay,
+    std::chrono::milliseconds maxDelay,
+    uint64_t seed)
+    : initialDelay_(std::max(initialDelay, std::chrono::milliseconds(1))),
+      maxDelay_(std::max(maxDelay, initialDelay_)),
+      rng_(seed) {}
+
+std::chrono::milliseconds ProbeScheduler::uniform(
+    int64_t minMs,
+    int64_t maxMs) {
+  return std::chrono::milliseconds(
+      std::uniform_int_distribution<int64_t>(minMs, maxMs)(rng_));
+}
+
+std::chrono::milliseconds ProbeScheduler::start(folly::StringPiece key) {
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = states_.find(key);
+  if (it == states_.end()) {
+    prune(now);
+    it = states_.emplace(key.str(), State()).first;
+  }
+  auto& state = it->second;
+  if (state.probing) {
+    // Another proxy took over probing.
+    return state.delay;
+  }
+  state.probing = true;
+  ++numProbing_;
+  if (state.delay.count() > 0 && now - state.stoppedAt < 2 * maxDelay_) {
+    // Flapping: resume the backoff.
+    return state.delay = uniform(initialDelay_.count(), state.delay.count());
+  }
+  const auto initialMs = initialDelay_.count();
+  return state.delay = uniform(std::max<int64_t>(initialMs / 2, 1),
+                               initialMs + initialMs / 2);
+}
+
+std::chrono::milliseconds ProbeScheduler::next(folly::StringPiece key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& state = states_[key];
+  auto upper = std::min<int64_t>(
+      std::max(state.delay, initialDelay_).count() * 3, maxDelay_.count());
+  state.delay = uniform(std::min(initialDelay_.count(), upper), upper);
+  return state.delay;
+}
+
+void ProbeScheduler::stop(folly::StringPiece key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = states_.find(key);
+  if (it == states_.end() || !it->second.probing) {
+    return;
+  }
+  it->second.probing = false;
+  it->second.stoppedAt = std::chrono::steady_clock::now();
+  --numProbing_;
+}
+
+size_t ProbeScheduler::numProbing() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return numProbing_;
+}
+
+void ProbeScheduler::prune(std::chrono::steady_clock::time_point now) {
+  // Amortized: only scan once the map doubled since the last scan.
+  if (states_.size() < 2 * (numProbing_ + 64)) {
+    return;
+  }
+  for (auto it = states_.begin(); it != states_.end();) {
+    if (!it->second.probing && now - it->second.stoppedAt >= 2 * maxDelay_) {
+      it = states_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
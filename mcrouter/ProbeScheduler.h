@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Decides when TKO destinations get probed, for a whole router instance.
+ *
+ * TkoTracker already makes a single proxy responsible for probing each TKO
+ * destination; this class makes sure that the probes of different router
+ * instances don't end up in lockstep after e.g. a rack outage, hitting the
+ * recovering hosts all at once:
+ *  - the first probe is sent after a random delay in
+ *    [initialDelay / 2, initialDelay * 3 / 2];
+ *  - the following ones back off exponentially with "decorrelated jitter":
+ *    each delay is random in [initialDelay, 3 * previous delay], capped at
+ *    maxDelay;
+ *  - every instance has its own randomly seeded generator.
+ *
+ * The backoff of a destination survives changes of the responsible proxy,
+ * and a destination that goes TKO again within 2 * maxDelay of recovering
+ * resumes its backoff instead of starting over, so flapping hosts are not
+ * probed at the initial rate over and over.
+ *
+ * Thread-safe; probes are rare enough for a mutex.
+ */
+class ProbeScheduler {
+ public:
+  ProbeScheduler(
+      std::chrono::milliseconds initialDelay,
+      std::chrono::milliseconds maxDelay,
+      uint64_t seed);
+
+  /**
+   * `key` was just marked TKO.
+   *
+   * @return  delay until the first probe.
+   */
+  std::chrono::milliseconds start(folly::StringPiece key);
+
+  /**
+   * @return  delay from the probe of `key` that was just sent to the next.
+   */
+  std::chrono::milliseconds next(folly::StringPiece key);
+
+  /**
+   * `key` is no longer probed (it recovered or was removed from config).
+   */
+  void stop(folly::StringPiece key);
+
+  /**
+   * Number of destinations being probed.
+   */
+  size_t numProbing() const;
+
+ private:
+  struct State {
+    std::chrono::milliseconds delay{0};
+    // When probing stopped, and whether it is stopped.
+    std::chrono::steady_clock::time_point stoppedAt;
+    bool probing{false};
+  };
+
+  const std::chrono::milliseconds initialDelay_;
+  const std::chrono::milliseconds maxDelay_;
+
+  mutable std::mutex mutex_;
+  std::mt19937_64 rng_;
+  folly::F14FastMap<std::string, State> states_;
+  size_t numProbing_{0};
+
+  std::chrono::milliseconds uniform(int64_t minMs, int64_t maxMs);
+
+  /**
+   * Forgets destinations that recovered long enough ago.
+   */
+  void prune(std::chrono::steady_clock::time_point now);
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -5,11 +5,18 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
 #include <folly/Range.h>
 #include <folly/fibers/EventBaseLoopController.h>
 
 #include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyDestinationBase.h"
+#include "mcrouter/ProxyDestinationMap.h"
 #include "mcrouter/ProxyRequestContextTyped.h"
+#include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
 #include "mcrouter/lib/MessageQueue.h"
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/carbon/Stats.h"
@@ -76,6 +83,11 @@ void Proxy<RouterInfo>::WaitingRequest<Request>::process(
       return;
     }
   }
+  if (ctx_->clientGone()) {
+    proxy->stats().increment(request_client_gone_dropped_stat);
+    ctx_->sendReply(carbon::Result::ABORTED);
+    return;
+  }
 
   proxy->processRequest(req_, std::move(ctx_));
 }
@@ -90,11 +102,37 @@ Proxy<RouterInfo>::addRouteTask(
   requestStats_.template bump<Request>(carbon::RouterStatTypes::Incoming);
 
   auto funcCtx = sharedCtx;
-
-  fiberManager().addTaskFinally(
-      [&req, ctx = std::move(funcCtx)]() FOLLY_NOINLINE_MUTABLE {
+  auto queueDelayMonitor = this->queueDelayMonitor();
+  auto queueDelayHistogram =
+      measureQueueDelay() ? &stats().queueDelayUsHistogram() : nullptr;
+  int64_t queuedAtUs =
+      (queueDelayMonitor || queueDelayHistogram) ? nowUs() : 0;
+
+  // Deep route trees get the large stacks, if enabled.
+  auto* fm = largeStackFiberManager();
+  if (!fm ||
+      sharedCtx->proxyConfig().routeTreeHeight() <
+          getRouterOptions().fibers_large_stack_route_height) {
+    fm = &fiberManager();
+  }
+  fm->addTaskFinally(
+      [&req,
+       ctx = std::move(funcCtx),
+       queueDelayMonitor,
+       queueDelayHistogram,
+       queuedAtUs]() FOLLY_NOINLINE_MUTABLE {
+        if (queuedAtUs != 0) {
+          auto now = nowUs();
+          if (queueDelayMonitor) {
+            queueDelayMonitor->onDequeue(now - queuedAtUs, now);
+          }
+          if (queueDelayHistogram) {
+            queueDelayHistogram->record(std::max<int64_t>(now - queuedAtUs, 0));
+          }
+        }
         try {
           auto& proute = ctx->proxyRoute();
+          fiber_local<RouterInfo>::traceContext() = ctx->traceContext();
           fiber_local<RouterInfo>::setSharedCtx(std::move(ctx));
           return proute.route(req);
         } catch (const std::exception& e) {
@@ -150,10 +188,16 @@ void Proxy<RouterInfo>::processRequest(
   assert(!ctx->isProcessing());
   ctx->markAsProcessing();
   ++numRequestsProcessing_;
+  ++numRequestsSinceIdleCheck_;
   stats().increment(proxy_reqs_processing_stat);
+  if (ctx->priority() == ProxyRequestPriority::kAsync) {
+    ++numAsyncRequestsProcessing_;
+    stats().increment(proxy_async_reqs_processing_stat);
+  }
   if (FOLLY_UNLIKELY(req.getCryptoAuthToken().has_value())) {
     stats().increment(request_has_crypto_auth_token_stat);
   }
+  sampleHotKey(req);
   ctx->runPreprocessFunction();
   routeHandlesProcessRequest(req, std::move(ctx));
 
@@ -166,6 +210,12 @@ template <class Request>
 void Proxy<RouterInfo>::dispatchRequest(
     const Request& req,
     std::unique_ptr<ProxyRequestContextTyped<RouterInfo, Request>> ctx) {
+  size_t bytes = carbon::getFullKey(req).size();
+  if (auto* value = carbon::valuePtrUnsafe(req)) {
+    bytes += value->computeChainDataLength();
+  }
+  ctx->addInflightBytes(bytes);
+
   if (rateLimited(ctx->priority(), req)) {
     if (getRouterOptions().proxy_max_throttled_requests > 0 &&
         numRequestsWaiting_ >=
@@ -174,6 +224,8 @@ void Proxy<RouterInfo>::dispatchRequest(
       return;
     }
     auto& queue = waitingRequests_[static_cast<int>(ctx->priority())];
+    const uint64_t queueKey =
+        getRouterOptions().proxy_fair_queueing ? ctx->clientId() : 0;
     auto w = std::make_unique<WaitingRequest<Request>>(req, std::move(ctx));
     // Only enable timeout on waitingRequests_ queue when queue throttling is
     // enabled
@@ -182,7 +234,7 @@ void Proxy<RouterInfo>::dispatchRequest(
         getRouterOptions().waiting_request_timeout_ms > 0) {
       w->setTimePushedOnQueue(nowUs());
     }
-    queue.pushBack(std::move(w));
+    queue.push(queueKey, std::move(w));
     ++numRequestsWaiting_;
     stats().increment(proxy_reqs_waiting_stat);
   } else {
@@ -205,23 +257,35 @@ Proxy<RouterInfo>::Proxy(
       router().opts().client_queue_wait_threshold_us,
       &nowUs,
       [this]() { stats().incrementSafe(client_queue_notifications_stat); },
-      [this, noFlushLoops = 0](bool last) mutable {
-        bool haveTasks = fiberManager().runQueueSize() != 0;
+      [this, noFlushLoops = 0, noFlushSinceUs = int64_t(0)](
+          bool last) mutable {
+        bool haveTasks = fiberManager().runQueueSize() != 0 ||
+            (largeStackFiberManager() &&
+             largeStackFiberManager()->runQueueSize() != 0);
         if (!last) {
           // If we have tasks in fiber manager, or we have pending flushes, then
           // we can guarantee that we won't block event loop.
           return haveTasks || !flushList().empty();
         }
-        if (!flushList().empty() &&
-            (!haveTasks ||
-             ++noFlushLoops >= router().opts().max_no_flush_event_loops)) {
+        if (flushList().empty()) {
+          return false;
+        }
+        const auto maxNoFlushUs = router().opts().max_no_flush_us;
+        if (maxNoFlushUs > 0 && noFlushSinceUs == 0) {
+          noFlushSinceUs = nowUs();
+        }
+        if (!haveTasks ||
+            ++noFlushLoops >= router().opts().max_no_flush_event_loops ||
+            (maxNoFlushUs > 0 && nowUs() - noFlushSinceUs >= maxNoFlushUs)) {
           noFlushLoops = 0;
+          noFlushSinceUs = 0;
           flushCallback_.setList(std::move(flushList()));
           eventBase().getEventBase().runInLoop(
               &flushCallback_, true /* thisIteration */);
         }
         return false;
-      });
+      },
+      router().opts().client_queue_spin_poll_us);
 }
 
 template <class RouterInfo>
@@ -238,6 +302,14 @@ Proxy<RouterInfo>* Proxy<RouterInfo>::createProxy(
     dynamic_cast<folly::fibers::EventBaseLoopController&>(
         proxyPtr->fiberManager().loopController())
         .attachEventBase(eventBase);
+    if (auto largeFm = proxyPtr->largeStackFiberManager()) {
+      dynamic_cast<folly::fibers::EventBaseLoopController&>(
+          largeFm->loopController())
+          .attachEventBase(eventBase);
+    }
+    if (proxyPtr->router().opts().fibers_prewarm_pool) {
+      proxyPtr->prewarmFiberPools();
+    }
 
     std::chrono::milliseconds connectionResetInterval{
         proxyPtr->router().opts().reset_inactive_connection_interval};
@@ -245,6 +317,12 @@ Proxy<RouterInfo>* Proxy<RouterInfo>::createProxy(
     if (connectionResetInterval.count() > 0) {
       proxyPtr->destinationMap()->setResetTimer(connectionResetInterval);
     }
+
+    std::chrono::milliseconds standbyKeepaliveInterval{
+        proxyPtr->router().opts().standby_keepalive_interval_ms};
+    if (standbyKeepaliveInterval.count() > 0) {
+      proxyPtr->destinationMap()->setStandbyTimer(standbyKeepaliveInterval);
+    }
   });
 
   // We want proxy life-time to be tied to VirtualEventBase.
@@ -285,8 +363,38 @@ std::shared_ptr<ProxyConfig<RouterInfo>> Proxy<RouterInfo>::swapConfig(
 }
 
 /** drain and delete proxy object */
+template <class RouterInfo>
+void Proxy<RouterInfo>::retireConfig(
+    std::unique_ptr<old_config_req_t<RouterInfo>> req) {
+  if (beingDestroyed_ || req->config_.use_count() > 1) {
+    // Requests in flight will release it on this thread.
+    return;
+  }
+  auto auxPool = AuxiliaryCPUThreadPoolSingleton::try_get();
+  if (!auxPool) {
+    return;
+  }
+  ++numRetiringConfigs_;
+  auxPool->getThreadPool().add(
+      [this,
+       config = std::move(req->config_),
+       destinations = destinationMap()->getAllDestinations()]() mutable {
+        config.reset();
+        sendMessage(
+            ProxyMessage::Type::OLD_CONFIG,
+            new old_config_req_t<RouterInfo>(std::move(destinations)));
+        --numRetiringConfigs_;
+      });
+}
+
 template <class RouterInfo>
 Proxy<RouterInfo>::~Proxy() {
+  // Configs destroyed off thread send their destinations back through the
+  // message queue, which is drained below.
+  while (numRetiringConfigs_.load() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
   destinationMap_.reset();
 
   beingDestroyed_ = true;
@@ -310,6 +418,14 @@ size_t Proxy<RouterInfo>::queueNotifyPeriod() const {
   return 0;
 }
 
+template <class RouterInfo>
+uint64_t Proxy<RouterInfo>::queueSpinWakeupsAvoided() const {
+  if (messageQueue_) {
+    return messageQueue_->spinWakeupsAvoided();
+  }
+  return 0;
+}
+
 template <class RouterInfo>
 void Proxy<RouterInfo>::messageReady(ProxyMessage::Type t, void* data) {
   switch (t) {
@@ -318,9 +434,21 @@ void Proxy<RouterInfo>::messageReady(ProxyMessage::Type t, void* data) {
       preq->startProcessing();
     } break;
 
+    case ProxyMessage::Type::REQUEST_BATCH: {
+      std::unique_ptr<ProxyRequestBatch> batch(
+          reinterpret_cast<ProxyRequestBatch*>(data));
+      for (auto preq : batch->requests) {
+        preq->startProcessing();
+      }
+    } break;
+
     case ProxyMessage::Type::OLD_CONFIG: {
-      auto oldConfig = reinterpret_cast<old_config_req_t<RouterInfo>*>(data);
-      delete oldConfig;
+      std::unique_ptr<old_config_req_t<RouterInfo>> oldConfig(
+          reinterpret_cast<old_config_req_t<RouterInfo>*>(data));
+      if (oldConfig->config_ &&
+          router().opts().destroy_old_configs_off_thread) {
+        retireConfig(std::move(oldConfig));
+      }
     } break;
 
     case ProxyMessage::Type::REPLACE_AP: {
@@ -342,9 +470,18 @@ template <class RouterInfo>
 void Proxy<RouterInfo>::routeHandlesProcessRequest(
     const McStatsRequest& req,
     std::unique_ptr<ProxyRequestContextTyped<RouterInfo, McStatsRequest>> ctx) {
+  const auto group = req.key_ref()->fullKey();
+  if (getRouterOptions().stats_snapshot_interval_ms != 0 &&
+      group != "version") {
+    if (auto snapshot = router().statsSnapshot().get(group)) {
+      ctx->sendReply(McStatsReply(*snapshot));
+      return;
+    }
+  }
+
   McStatsReply reply;
   try {
-    reply = stats_reply(this, req.key_ref()->fullKey());
+    reply = stats_reply(this, group);
   } catch (const std::exception& e) {
     reply.result_ref() = carbon::Result::LOCAL_ERROR;
     reply.message_ref() =
@@ -378,20 +515,40 @@ void Proxy<RouterInfo>::routeHandlesProcessRequest(
   addRouteTask(req, std::move(sharedCtx));
 }
 
+template <class RouterInfo>
+typename Proxy<RouterInfo>::WaitingRequestBase::Queue&
+Proxy<RouterInfo>::nextWaitingQueue() {
+  auto& critical =
+      waitingRequests_[static_cast<int>(ProxyRequestPriority::kCritical)];
+  auto& async = waitingRequests_[static_cast<int>(ProxyRequestPriority::kAsync)];
+  if (async.empty() || asyncLimitReached()) {
+    return critical;
+  }
+  const auto weight = router().opts().proxy_critical_priority_weight;
+  if (!critical.empty() && (weight == 0 || criticalPumpedInARow_ < weight)) {
+    ++criticalPumpedInARow_;
+    return critical;
+  }
+  criticalPumpedInARow_ = 0;
+  return async;
+}
+
 template <class RouterInfo>
 void Proxy<RouterInfo>::pump() {
-  auto numPriorities = static_cast<int>(ProxyRequestPriority::kNumPriorities);
-  for (int i = 0; i < numPriorities; ++i) {
-    auto& queue = waitingRequests_[i];
-    while (numRequestsProcessing_ <
-               router().opts().proxy_max_inflight_requests &&
-           !queue.empty()) {
-      --numRequestsWaiting_;
-      auto w = queue.popFront();
-      stats().decrement(proxy_reqs_waiting_stat);
-
-      w->process(this);
+  while (numRequestsProcessing_ <
+             router().opts().proxy_max_inflight_requests &&
+         numRequestsWaiting_ > 0) {
+    auto& queue = nextWaitingQueue();
+    if (queue.empty()) {
+      // Only async requests are waiting, and they are at their own limit.
+      assert(asyncLimitReached());
+      break;
     }
+    --numRequestsWaiting_;
+    auto w = queue.pop();
+    stats().decrement(proxy_reqs_waiting_stat);
+
+    w->process(this);
   }
 }
 
@@ -425,13 +582,20 @@ Proxy<RouterInfo>::rateLimited(ProxyRequestPriority priority, const Request&)
   }
 
   if (waitingRequests_[static_cast<int>(priority)].empty() &&
-      numRequestsProcessing_ < getRouterOptions().proxy_max_inflight_requests) {
+      numRequestsProcessing_ < getRouterOptions().proxy_max_inflight_requests &&
+      (priority != ProxyRequestPriority::kAsync || !asyncLimitReached())) {
     return false;
   }
 
   return true;
 }
 
+template <class RouterInfo>
+bool Proxy<RouterInfo>::asyncLimitReached() const {
+  const auto limit = getRouterOptions().proxy_max_inflight_async_requests;
+  return limit > 0 && numAsyncRequestsProcessing_ >= limit;
+}
+
 template <class RouterInfo>
 bool Proxy<RouterInfo>::messageQueueFull() const noexcept {
   return messageQueue_->isFull();
@@ -30,13 +30,13 @@
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyRequestPriority.h"
 #include "mcrouter/config.h"
+#include "mcrouter/lib/FairQueue.h"
 #include "mcrouter/lib/carbon/Keys.h"
 #include "mcrouter/lib/mc/msg.h"
 #include "mcrouter/lib/mc/protocol.h"
 #include "mcrouter/lib/network/AsyncMcClient.h"
 #include "mcrouter/lib/network/CarbonMessageList.h"
 #include "mcrouter/lib/network/ThriftTransport.h"
-#include "mcrouter/lib/network/UniqueIntrusiveList.h"
 #include "mcrouter/options.h"
 
 namespace folly {
@@ -59,13 +59,20 @@ class CarbonRouterInstance;
 class CarbonRouterInstanceBase;
 template <class RouterInfo>
 class ProxyConfig;
+class ProxyDestinationBase;
 class ProxyRequestContext;
 template <class RouterInfo, class Request>
 class ProxyRequestContextTyped;
 class ShardSplitter;
 
 struct ProxyMessage {
-  enum class Type { REQUEST, OLD_CONFIG, REPLACE_AP, SHUTDOWN };
+  enum class Type {
+    REQUEST,
+    REQUEST_BATCH,
+    OLD_CONFIG,
+    REPLACE_AP,
+    SHUTDOWN
+  };
 
   Type type{Type::REQUEST};
   void* data{nullptr};
@@ -75,6 +82,15 @@ struct ProxyMessage {
   ProxyMessage(Type t, void* d) noexcept : type(t), data(d) {}
 };
 
+/**
+ * Payload of a REQUEST_BATCH message: several requests sent to the same
+ * proxy with a single queue write. The proxy takes ownership of the batch
+ * and of every request in it.
+ */
+struct ProxyRequestBatch {
+  std::vector<ProxyRequestContext*> requests;
+};
+
 // struct used for replace message
 //
 struct replace_ap_t {
@@ -150,6 +166,11 @@ class Proxy : public ProxyBase {
    */
   size_t queueNotifyPeriod() const override;
 
+  /**
+   * @return Number of client queue notifications avoided by spin polling.
+   */
+  uint64_t queueSpinWakeupsAvoided() const override;
+
   bool beingDestroyed() const {
     return beingDestroyed_;
   }
@@ -199,6 +220,9 @@ class Proxy : public ProxyBase {
 
   std::unique_ptr<MessageQueue<ProxyMessage>> messageQueue_;
 
+  // Old configs being destroyed on the auxiliary CPU thread pool.
+  std::atomic<size_t> numRetiringConfigs_{0};
+
   static Proxy<RouterInfo>* createProxy(
       CarbonRouterInstanceBase& router,
       folly::VirtualEventBase& evb,
@@ -210,6 +234,14 @@ class Proxy : public ProxyBase {
 
   void messageReady(ProxyMessage::Type t, void* data);
 
+  /**
+   * Destroys the old config in `req` on the auxiliary CPU thread pool if
+   * nothing else uses it (otherwise it's destroyed here with `req`).
+   * The destinations still alive are kept until then and released back on
+   * the proxy thread, as they can only be destroyed there.
+   */
+  void retireConfig(std::unique_ptr<old_config_req_t<RouterInfo>> req);
+
   // Add task to route request through route handle tree
   template <class Request>
   typename std::enable_if_t<
@@ -252,17 +284,17 @@ class Proxy : public ProxyBase {
       std::unique_ptr<ProxyRequestContextTyped<RouterInfo, Request>> ctx);
 
   /**
-   * We use this wrapper instead of putting 'hook' inside ProxyRequestContext
-   * directly due to an include cycle:
+   * We use this wrapper instead of queueing ProxyRequestContext directly due
+   * to an include cycle:
    * proxy.h -> ProxyRequestContext.h -> ProxyRequestLogger.h ->
    * ProxyRequestLogger-inl.h -> proxy.h
    */
   class WaitingRequestBase {
-    UniqueIntrusiveListHook hook;
-
    public:
-    using Queue =
-        UniqueIntrusiveList<WaitingRequestBase, &WaitingRequestBase::hook>;
+    /**
+     * Keyed by client with proxy_fair_queueing, a single FIFO otherwise.
+     */
+    using Queue = FairQueue<std::unique_ptr<WaitingRequestBase>>;
 
     virtual ~WaitingRequestBase() = default;
 
@@ -298,6 +330,8 @@ class Proxy : public ProxyBase {
   /** Queue of requests we didn't start processing yet */
   typename WaitingRequestBase::Queue
       waitingRequests_[static_cast<int>(ProxyRequestPriority::kNumPriorities)];
+  /** Critical requests let through since the last async one */
+  size_t criticalPumpedInARow_{0};
 
   /** If true, we can't start processing this request right now */
   template <class Request>
@@ -311,6 +345,14 @@ class Proxy : public ProxyBase {
   /** Will let through requests from the above queue if we have capacity */
   void pump() final;
 
+  /**
+   * Queue to let the next waiting request through from, weighted by
+   * proxy_critical_priority_weight. At least one queue must be non-empty.
+   */
+  typename WaitingRequestBase::Queue& nextWaitingQueue();
+  // True iff async requests are at proxy_max_inflight_async_requests.
+  bool asyncLimitReached() const;
+
   friend class CarbonRouterInstance<RouterInfo>;
   friend class CarbonRouterClient<RouterInfo>;
   friend class ProxyRequestContext;
@@ -321,8 +363,19 @@ struct old_config_req_t {
   explicit old_config_req_t(std::shared_ptr<ProxyConfig<RouterInfo>> config)
       : config_(std::move(config)) {}
 
+  /**
+   * Sent back to the proxy once a config was destroyed off the proxy thread,
+   * to release the destinations on the proxy thread.
+   */
+  explicit old_config_req_t(
+      std::vector<std::shared_ptr<ProxyDestinationBase>> destinations)
+      : destinations_(std::move(destinations)) {}
+
  private:
   std::shared_ptr<ProxyConfig<RouterInfo>> config_;
+  std::vector<std::shared_ptr<ProxyDestinationBase>> destinations_;
+
+  friend class Proxy<RouterInfo>;
 };
 
 template <class RouterInfo>
@@ -12,7 +12,9 @@
 
 #include "mcrouter/CarbonRouterInstanceBase.h"
 #include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/OptionsUtil.h"
 #include "mcrouter/ProxyDestinationMap.h"
+#include "mcrouter/ThreadUtil.h"
 
 namespace facebook {
 namespace memcache {
@@ -33,13 +35,136 @@ ProxyBase::ProxyBase(
           getFiberManagerOptions(router_.opts())),
       asyncLog_(router_.opts()),
       stats_(router_.getStatsEnabledPools()),
+      requestStatsBatch_(stats_, eventBase_.getEventBase()),
       flushCallback_(*this),
       destinationMap_(std::make_unique<ProxyDestinationMap>(this)) {
   eventBase_.runInEventBaseThread([]() { isProxyThread_ = true; });
+  if (router_.opts().proxy_numa_placement) {
+    // Pinned before the arena is created, so that its pages are first
+    // touched (and allocated) on the node of the proxy.
+    eventBase_.runInEventBaseThread([this]() {
+      auto nodes = getNumaNodeCpus();
+      if (nodes.size() < 2) {
+        return;
+      }
+      auto node =
+          numaNodeForThread(id_, router_.opts().num_proxies, nodes.size());
+      if (pinThisThreadToCpus(nodes[node])) {
+        VLOG(1) << "Proxy " << id_ << " pinned to NUMA node " << node;
+      }
+    });
+  }
+  if (router_.opts().proxy_jemalloc_arena) {
+    eventBase_.runInEventBaseThread([this]() {
+      if (auto arena = bindThisThreadToNewJemallocArena(
+              router_.opts().proxy_jemalloc_arena_huge_pages)) {
+        jemallocArena_.store(
+            static_cast<int>(*arena), std::memory_order_release);
+      }
+    });
+  }
   // Setup a full random seed sequence
   folly::Random::seed(randomGenerator_);
 
   statsContainer_ = std::make_unique<ProxyStatsContainer>(*this);
+
+  if (router_.opts().fibers_large_stack_size > 0) {
+    auto fmOpts = getFiberManagerOptions(router_.opts());
+    fmOpts.stackSize = router_.opts().fibers_large_stack_size;
+    largeStackFiberManager_ = std::make_unique<folly::fibers::FiberManager>(
+        typename fiber_local<RouterInfo>::ContextTypeTag(),
+        std::make_unique<folly::fibers::EventBaseLoopController>(),
+        fmOpts);
+  }
+
+  if (router_.opts().hot_keys_sample_period > 0 &&
+      router_.opts().hot_keys_capacity > 0) {
+    hotKeys_ =
+        std::make_unique<HotKeySketch>(router_.opts().hot_keys_capacity);
+    hotKeysSampleCountdown_ = router_.opts().hot_keys_sample_period;
+  }
+
+  if (router_.opts().client_stats_sample_period > 0 &&
+      router_.opts().client_stats_capacity > 0) {
+    clientTraffic_ = std::make_unique<ClientTrafficSketch>(
+        router_.opts().client_stats_capacity);
+    clientTrafficSampleCountdown_ = router_.opts().client_stats_sample_period;
+  }
+
+  if (router_.opts().worst_destinations_count > 0) {
+    worstDestinations_ = std::make_unique<WorstDestinations>(
+        router_.opts().worst_destinations_count);
+  }
+
+  if (router_.opts().slow_request_log_threshold_us > 0) {
+    slowRequestLog_ = std::make_unique<SlowRequestLog>(
+        router_.opts().slow_request_log_threshold_us,
+        router_.opts().slow_request_log_size);
+  }
+
+  if (router_.opts().axon_batch_window_us > 0) {
+    AxonBatcher::Options axonBatcherOpts;
+    axonBatcherOpts.window =
+        std::chrono::microseconds(router_.opts().axon_batch_window_us);
+    axonBatcherOpts.maxKeys = router_.opts().axon_batch_max_keys;
+    axonBatcherOpts.maxBytes = router_.opts().axon_batch_max_bytes;
+    axonBatcherOpts.maxPendingKeys = router_.opts().axon_batch_max_pending_keys;
+    axonBatcherOpts.compress = router_.opts().axon_batch_compress;
+    axonBatcher_ =
+        std::make_unique<AxonBatcher>(*this, std::move(axonBatcherOpts));
+  }
+
+  if (router_.opts().route_profile_sample_period > 0) {
+    routeProfiler_ = std::make_unique<RouteProfiler>(
+        router_.opts().route_profile_sample_period,
+        router_.opts().debug_fifo_root.empty()
+            ? std::string()
+            : getRouteProfileDebugFifoFullPath(router_.opts()));
+    fiberManager_.addObserver(routeProfiler_.get());
+    if (largeStackFiberManager_) {
+      largeStackFiberManager_->addObserver(routeProfiler_.get());
+    }
+  }
+
+  if (router_.opts().trace_sample_period > 0 &&
+      !router_.opts().debug_fifo_root.empty()) {
+    requestTracer_ = std::make_unique<RequestTracer>(
+        router_.opts().trace_sample_period, router_.opts().trace_buffer_size);
+  }
+
+  if (router_.opts().shadow_shed_loop_time_us > 0 ||
+      router_.opts().shadow_shed_cpu_percent > 0 ||
+      router_.opts().shadow_shed_fibers_percent > 0 ||
+      router_.opts().shadow_shed_queue_delay_us > 0) {
+    shadowThrottle_ = std::make_unique<ShadowThrottle>(*this);
+  }
+
+  measureQueueDelay_ = router_.opts().proxy_scheduling_histograms ||
+      router_.opts().shadow_shed_queue_delay_us > 0;
+  if (router_.opts().proxy_scheduling_histograms) {
+    fiberRunTimeObserver_ = std::make_unique<FiberRunTimeObserver>(
+        stats_.fiberRunUsHistogram());
+    fiberManager_.addObserver(fiberRunTimeObserver_.get());
+    if (largeStackFiberManager_) {
+      largeStackFiberManager_->addObserver(fiberRunTimeObserver_.get());
+    }
+    loopTimeObserver_ =
+        std::make_shared<LoopTimeObserver>(stats_.loopTimeUsHistogramPtr());
+    // The EventBase may be shared with a server, which may have its own
+    // observer already.
+    eventBase_.runInEventBaseThread(
+        [&evb = eventBase_.getEventBase(), observer = loopTimeObserver_]() {
+          if (!evb.getObserver()) {
+            evb.setObserver(observer);
+          }
+        });
+  }
+
+  if (router_.opts().proxy_queue_delay_target_us > 0) {
+    queueDelayMonitor_ = std::make_unique<QueueDelayMonitor>(
+        router_.opts().proxy_queue_delay_target_us,
+        1000 * router_.opts().proxy_queue_delay_interval_ms);
+  }
 }
 
 } // namespace mcrouter
@@ -8,6 +8,7 @@
 #include "ProxyBase.h"
 
 #include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/ThreadUtil.h"
 #include "mcrouter/config-impl.h"
 #include "mcrouter/config.h"
 #include "mcrouter/options.h"
@@ -22,6 +23,54 @@ const McrouterOptions& ProxyBase::getRouterOptions() const {
   return router_.opts();
 }
 
+bool ProxyBase::overloaded() const {
+  const auto& opts = router_.opts();
+  if (queueDelayMonitor_ && queueDelayMonitor_->overloaded(nowUs())) {
+    return true;
+  }
+  if (opts.proxy_max_inflight_bytes > 0 &&
+      inflightBytes_ >= opts.proxy_max_inflight_bytes) {
+    return true;
+  }
+  if (opts.proxy_overload_fibers_percent == 0 ||
+      opts.fibers_max_pool_size == 0) {
+    return false;
+  }
+  auto fibersAllocated = fiberManager_.fibersAllocated();
+  if (largeStackFiberManager_) {
+    fibersAllocated += largeStackFiberManager_->fibersAllocated();
+  }
+  return 100 * fibersAllocated >=
+      opts.proxy_overload_fibers_percent * opts.fibers_max_pool_size;
+}
+
+void ProxyBase::purgeJemallocArenaIfIdle() {
+  auto arena = jemallocArena();
+  if (!arena) {
+    return;
+  }
+  if (numRequestsSinceIdleCheck_ == 0 && numRequestsProcessing_ == 0 &&
+      numRequestsWaiting_ == 0) {
+    purgeJemallocArena(*arena);
+    stats().increment(proxy_arena_purges_stat);
+  }
+  numRequestsSinceIdleCheck_ = 0;
+}
+
+void ProxyBase::prewarmFiberPools() {
+  // Every task takes a fiber (allocating its stack) right away. The tasks
+  // are empty, so all of them go back to the pool on the next loop.
+  const auto numFibers = router_.opts().fibers_max_pool_size;
+  for (auto* fm : {&fiberManager_, largeStackFiberManager_.get()}) {
+    if (!fm) {
+      continue;
+    }
+    for (size_t i = 0; i < numFibers; ++i) {
+      fm->addTask([]() {});
+    }
+  }
+}
+
 folly::fibers::FiberManager::Options ProxyBase::getFiberManagerOptions(
     const McrouterOptions& opts) {
   folly::fibers::FiberManager::Options fmOpts;
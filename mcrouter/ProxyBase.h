@@ -7,18 +7,33 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <random>
 
+#include <folly/Optional.h>
 #include <folly/Portability.h>
 #include <folly/dynamic.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/VirtualEventBase.h>
 
 #include "mcrouter/AsyncLog.h"
+#include "mcrouter/AxonBatcher.h"
+#include "mcrouter/ClientTrafficSketch.h"
+#include "mcrouter/DestinationCounters.h"
+#include "mcrouter/HotKeySketch.h"
+#include "mcrouter/ProxyRequestStatsBatch.h"
 #include "mcrouter/ProxyStats.h"
+#include "mcrouter/QueueDelayMonitor.h"
+#include "mcrouter/SchedulingObservers.h"
+#include "mcrouter/ShadowThrottle.h"
+#include "mcrouter/SlowRequestLog.h"
+#include "mcrouter/WorstDestinations.h"
 #include "mcrouter/config.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/debug/RequestTracer.h"
+#include "mcrouter/lib/debug/RouteProfiler.h"
 #include "mcrouter/lib/network/Transport.h"
 
 namespace facebook {
@@ -70,6 +85,14 @@ class ProxyBase {
     return fiberManager_;
   }
 
+  /**
+   * Fiber manager with fibers_large_stack_size stacks, for requests of configs
+   * with deep route trees. nullptr if fibers_large_stack_size is 0.
+   */
+  folly::fibers::FiberManager* largeStackFiberManager() {
+    return largeStackFiberManager_.get();
+  }
+
   ProxyDestinationMap* destinationMap() {
     return destinationMap_.get();
   }
@@ -89,10 +112,165 @@ class ProxyBase {
     return stats_;
   }
 
+  /**
+   * Reply counters of this proxy's destinations, see ProxyDestinationBase.
+   */
+  DestinationCounters& destinationCounters() {
+    return destinationCounters_;
+  }
+
+  /**
+   * Reply stats waiting to be added to stats(), see ProxyRequestLogger.
+   */
+  ProxyRequestStatsBatch& requestStatsBatch() {
+    return requestStatsBatch_;
+  }
+
   ProxyStatsContainer* statsContainer() {
     return statsContainer_.get();
   }
 
+  /**
+   * Sketch of the most frequent keys routed by this proxy, or nullptr if
+   * hot key tracking is disabled (hot_keys_sample_period == 0).
+   */
+  HotKeySketch* hotKeys() const {
+    return hotKeys_.get();
+  }
+
+  /**
+   * Traffic of the busiest clients of this proxy, or nullptr if per-client
+   * accounting is disabled (client_stats_sample_period == 0).
+   */
+  ClientTrafficSketch* clientTraffic() const {
+    return clientTraffic_.get();
+  }
+
+  /**
+   * @return  clientTraffic() if the reply being sent should be accounted
+   *          to its client, nullptr otherwise.
+   */
+  ClientTrafficSketch* sampleClientTraffic() {
+    if (FOLLY_LIKELY(clientTrafficSampleCountdown_ > 1)) {
+      --clientTrafficSampleCountdown_;
+      return nullptr;
+    }
+    if (clientTraffic_) {
+      clientTrafficSampleCountdown_ =
+          getRouterOptions().client_stats_sample_period;
+    }
+    return clientTraffic_.get();
+  }
+
+  /**
+   * The destinations of this proxy with the highest latency and error rate,
+   * or nullptr if disabled (worst_destinations_count == 0).
+   */
+  WorstDestinations* worstDestinations() const {
+    return worstDestinations_.get();
+  }
+
+  /**
+   * The last slow requests of this proxy, or nullptr if disabled
+   * (slow_request_log_threshold_us == 0).
+   */
+  SlowRequestLog* slowRequestLog() const {
+    return slowRequestLog_.get();
+  }
+
+  /**
+   * Coalesces the invalidations written to the Axon proxy service, or
+   * nullptr if disabled (axon_batch_window_us == 0).
+   */
+  AxonBatcher* axonBatcher() const {
+    return axonBatcher_.get();
+  }
+
+  /**
+   * Sampled per route handle time accounting, or nullptr if disabled
+   * (route_profile_sample_period == 0).
+   */
+  RouteProfiler* routeProfiler() const {
+    return routeProfiler_.get();
+  }
+
+  /**
+   * Sampled request tracing, or nullptr if disabled (trace_sample_period == 0
+   * or no debug_fifo_root to export the traces to).
+   */
+  RequestTracer* requestTracer() const {
+    return requestTracer_.get();
+  }
+
+  /**
+   * Load based shedding of shadow requests, or nullptr if disabled
+   * (all shadow_shed_* options are 0).
+   */
+  ShadowThrottle* shadowThrottle() const {
+    return shadowThrottle_.get();
+  }
+
+  /**
+   * Delay of requests waiting to start being routed, or nullptr if disabled
+   * (proxy_queue_delay_target_us == 0).
+   */
+  QueueDelayMonitor* queueDelayMonitor() const {
+    return queueDelayMonitor_.get();
+  }
+
+  /**
+   * Whether to measure how long requests wait before being routed, into
+   * stats().queueDelayUsHistogram().
+   */
+  bool measureQueueDelay() const {
+    return measureQueueDelay_;
+  }
+
+  /**
+   * @return  true if this proxy has more work than it keeps up with, i.e.
+   *          requests have been queueing up (see QueueDelayMonitor) or
+   *          it has more fibers than proxy_overload_fibers_percent of
+   *          fibers_max_pool_size, or more than proxy_max_inflight_bytes
+   *          of requests. Clients should stop sending new requests for a
+   *          while.
+   */
+  bool overloaded() const;
+
+  /**
+   * Bytes of the keys and values of the requests this proxy is queueing or
+   * routing. Bounded by proxy_max_inflight_bytes, see overloaded().
+   */
+  size_t inflightBytes() const {
+    return inflightBytes_;
+  }
+
+  /**
+   * @return  index of the jemalloc arena of this proxy's thread, or none if
+   *          proxy_jemalloc_arena is not set (or not bound yet).
+   *          May be called from any thread.
+   */
+  folly::Optional<unsigned> jemallocArena() const {
+    auto arena = jemallocArena_.load(std::memory_order_acquire);
+    if (arena < 0) {
+      return folly::none;
+    }
+    return static_cast<unsigned>(arena);
+  }
+
+  /**
+   * Purges the dirty pages of this proxy's jemalloc arena if the proxy got
+   * no requests since the previous call. Must be called from the proxy
+   * thread.
+   */
+  void purgeJemallocArenaIfIdle();
+
+  /**
+   * Fills the fiber pools with fibers_max_pool_size fibers, see
+   * fibers_prewarm_pool. Must be called from the proxy thread, once the
+   * fiber managers are attached to the event base.
+   */
+  void prewarmFiberPools();
+
   /** Will let through requests from the above queue if we have capacity */
   virtual void pump() = 0;
 
@@ -101,6 +279,11 @@ class ProxyBase {
    */
   virtual size_t queueNotifyPeriod() const = 0;
 
+  /**
+   * @return Number of client queue notifications avoided by spin polling.
+   */
+  virtual uint64_t queueSpinWakeupsAvoided() const = 0;
+
   virtual folly::dynamic dumpRequestStats(bool filterZeroes) const = 0;
 
   /** Advance the request stats bin. */
@@ -128,14 +311,42 @@ class ProxyBase {
 
   folly::VirtualEventBase& eventBase_;
   folly::fibers::FiberManager fiberManager_;
+  std::unique_ptr<folly::fibers::FiberManager> largeStackFiberManager_;
 
   AsyncLog asyncLog_;
 
   std::mt19937 randomGenerator_;
 
   ProxyStats stats_;
+  // Declared before destinationMap_: outlives the destinations.
+  DestinationCounters destinationCounters_;
+  ProxyRequestStatsBatch requestStatsBatch_;
   std::unique_ptr<ProxyStatsContainer> statsContainer_;
 
+  std::unique_ptr<HotKeySketch> hotKeys_;
+
+  std::unique_ptr<ClientTrafficSketch> clientTraffic_;
+
+  std::unique_ptr<WorstDestinations> worstDestinations_;
+
+  std::unique_ptr<SlowRequestLog> slowRequestLog_;
+
+  std::unique_ptr<AxonBatcher> axonBatcher_;
+
+  std::unique_ptr<RouteProfiler> routeProfiler_;
+
+  std::unique_ptr<RequestTracer> requestTracer_;
+
+  std::unique_ptr<ShadowThrottle> shadowThrottle_;
+
+  std::unique_ptr<QueueDelayMonitor> queueDelayMonitor_;
+
+  std::atomic<int> jemallocArena_{-1};
+
+  bool measureQueueDelay_{false};
+  std::shared_ptr<LoopTimeObserver> loopTimeObserver_;
+  std::unique_ptr<FiberRunTimeObserver> fiberRunTimeObserver_;
+
   static folly::fibers::FiberManager::Options getFiberManagerOptions(
       const McrouterOptions& opts);
 
@@ -173,8 +384,34 @@ class ProxyBase {
 
   /** Number of requests processing */
   size_t numRequestsProcessing_{0};
+  /** Number of async priority requests processing, out of the above */
+  size_t numAsyncRequestsProcessing_{0};
+  /** Bytes of the requests waiting or processing, see inflightBytes() */
+  size_t inflightBytes_{0};
   /** Number of waiting requests */
   size_t numRequestsWaiting_{0};
+  /** Requests started since the last purgeJemallocArenaIfIdle() */
+  size_t numRequestsSinceIdleCheck_{0};
+
+  /** Requests left until the next key is recorded in hotKeys_ */
+  size_t hotKeysSampleCountdown_{0};
+  /** Replies left until the next one is recorded in clientTraffic_ */
+  size_t clientTrafficSampleCountdown_{0};
+
+  template <class Request>
+  void sampleHotKey(const Request& req) {
+    if (FOLLY_LIKELY(hotKeysSampleCountdown_ > 1)) {
+      --hotKeysSampleCountdown_;
+      return;
+    }
+    if (hotKeys_) {
+      hotKeysSampleCountdown_ = getRouterOptions().hot_keys_sample_period;
+      auto key = carbon::getFullKey(req);
+      if (!key.empty()) {
+        hotKeys_->record(key);
+      }
+    }
+  }
 
   friend class ProxyRequestContext;
 };
@@ -99,6 +99,7 @@ ProxyConfig<RouterInfo>::ProxyConfig(
     throwLogic("No route/routes in config");
   }
 
+  routeTreeHeight_ = factory.maxTreeHeight();
   asyncLogRoutes_ = provider.releaseAsyncLogRoutes();
   tierRoutes_ = provider.releaseTierRoutes();
   pools_ = provider.releasePools();
@@ -53,6 +53,13 @@ class ProxyConfig {
     return configMd5Digest_;
   }
 
+  /**
+   * Height of the tallest route handle tree of this config.
+   */
+  size_t routeTreeHeight() const {
+    return routeTreeHeight_;
+  }
+
   std::shared_ptr<typename RouterInfo::RouteHandleIf> getRouteHandleForAsyncLog(
       folly::StringPiece asyncLogName) const;
 
@@ -131,6 +138,7 @@ class ProxyConfig {
   std::shared_ptr<ProxyRoute<RouterInfo>> proxyRoute_;
   std::shared_ptr<ServiceInfo<RouterInfo>> serviceInfo_;
   std::string configMd5Digest_;
+  size_t routeTreeHeight_{0};
   folly::StringKeyedUnorderedMap<
       std::shared_ptr<typename RouterInfo::RouteHandleIf>>
       asyncLogRoutes_;
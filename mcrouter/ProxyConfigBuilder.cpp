@@ -10,6 +10,7 @@
 #include <folly/json.h>
 
 #include "mcrouter/ConfigApi.h"
+#include "mcrouter/ConfigSnapshot.h"
 #include "mcrouter/PoolFactory.h"
 #include "mcrouter/Proxy.h"
 #include "mcrouter/ProxyConfig.h"
@@ -46,8 +47,31 @@ ProxyConfigBuilder::ProxyConfigBuilder(
   folly::json::metadata_map configMetadataMap;
 
   auto globalParams = buildGlobalParams(opts, routerInfoName);
-  json_ = ConfigPreprocessor::getConfigWithoutMacros(
-      jsonC, importResolver, std::move(globalParams), &configMetadataMap);
+  if (opts.config_snapshot) {
+    auto snapshotKey = configSnapshotKey(jsonC, globalParams);
+    auto snapshot = configApi.readConfigSnapshot();
+    if (snapshot && snapshot->key == snapshotKey &&
+        snapshot->importsUnchanged(importResolver)) {
+      // No line numbers in errors about pools, as there's no metadata map.
+      VLOG(1) << "Using preprocessed config from snapshot";
+      json_ = std::move(snapshot->config);
+    } else {
+      RecordingImportResolver recordingResolver(importResolver);
+      json_ = ConfigPreprocessor::getConfigWithoutMacros(
+          jsonC,
+          recordingResolver,
+          std::move(globalParams),
+          &configMetadataMap);
+      ConfigSnapshot newSnapshot;
+      newSnapshot.key = std::move(snapshotKey);
+      newSnapshot.imports = recordingResolver.releaseImports();
+      newSnapshot.config = json_;
+      configApi.dumpConfigSnapshot(std::move(newSnapshot));
+    }
+  } else {
+    json_ = ConfigPreprocessor::getConfigWithoutMacros(
+        jsonC, importResolver, std::move(globalParams), &configMetadataMap);
+  }
 
   poolFactory_ = std::make_unique<PoolFactory>(
       json_, configApi, std::move(configMetadataMap));
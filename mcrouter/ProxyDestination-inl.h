@@ -11,6 +11,10 @@
 
 #include <limits>
 #include <random>
+#include <type_traits>
+
+#include <folly/Random.h>
+#include <folly/tracing/StaticTracepoint.h>
 
 #include "mcrouter/OptionsUtil.h"
 #include "mcrouter/ProxyBase.h"
@@ -18,9 +22,13 @@
 #include "mcrouter/config-impl.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/Clocks.h"
+#include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/ZstdDictionaryTrainer.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/mc/protocol.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
 #include "mcrouter/lib/network/ConnectionDownReason.h"
 #include "mcrouter/lib/network/ConnectionOptions.h"
 #include "mcrouter/lib/network/RpcStatsContext.h"
@@ -41,15 +49,63 @@ ReplyT<Request> ProxyDestination<Transport>::send(
     std::chrono::milliseconds timeout,
     RpcStatsContext& rpcStatsContext) {
   markAsActive();
-  auto reply = getTransport().sendSync(request, timeout, &rpcStatsContext);
+  FOLLY_SDT(mcrouter, destination_send, this, Request::typeId);
+  ReplyT<Request> reply;
+  if constexpr (std::is_same_v<Transport, AsyncMcClient>) {
+    // Only AsyncMcClient queues requests long enough (e.g. while connecting)
+    // for them to be worth dropping once their client is gone.
+    reply = getTransport().sendSync(
+        request,
+        adaptiveTimeout(timeout),
+        &rpcStatsContext,
+        requestContext.clientGone);
+    if (rpcStatsContext.notSent) {
+      // Failed in the pending queue: says nothing about the destination.
+      proxy().stats().increment(
+          *reply.result_ref() == carbon::Result::ABORTED
+              ? destination_client_gone_dropped_stat
+              : destination_pending_expired_stat);
+      return reply;
+    }
+  } else {
+    reply = getTransport().sendSync(
+        request, adaptiveTimeout(timeout), &rpcStatsContext);
+  }
+  FOLLY_SDT(
+      mcrouter,
+      destination_reply,
+      this,
+      Request::typeId,
+      static_cast<int>(*reply.result_ref()));
   onReply(
       *reply.result_ref(),
       requestContext,
       rpcStatsContext,
       request.isBufferDirty());
+  if (accessPoint()->compressed()) {
+    sampleForDictionaryTraining(reply);
+  }
   return reply;
 }
 
+template <class Transport>
+template <class Reply>
+void ProxyDestination<Transport>::sampleForDictionaryTraining(
+    const Reply& reply) {
+  auto trainer = proxy().router().dictionaryTrainer();
+  if (FOLLY_LIKELY(trainer == nullptr) || !isHitResult(*reply.result_ref())) {
+    return;
+  }
+  const auto* value = carbon::valuePtrUnsafe(reply);
+  if (value == nullptr) {
+    return;
+  }
+  auto period = proxy().router().opts().compression_dictionary_sample_period;
+  if (period <= 1 || folly::Random::oneIn(period, proxy().randomGenerator())) {
+    trainer->addSample(*value);
+  }
+}
+
 template <class Transport>
 bool ProxyDestination<Transport>::latencyAboveThreshold(uint64_t latency) {
   const auto rxmitDeviation =
@@ -125,6 +181,44 @@ void ProxyDestination<Transport>::handleRxmittingConnection(
   }
 }
 
+template <class Transport>
+void ProxyDestination<Transport>::handleTcpInfo() {
+  // New samples on a fresh connection before its RTT is trusted.
+  constexpr uint64_t kRttReconnectMinSamples = 8;
+  if (!transport_) {
+    return;
+  }
+  const auto info = transport_->getTcpInfo();
+  if (info.numSamples == lastTcpInfoSamples_) {
+    return;
+  }
+  lastTcpInfoSamples_ = info.numSamples;
+  // Retransmits restart from 0 on reconnect.
+  const auto retrans = info.totalRetrans >= lastTcpRetrans_
+      ? info.totalRetrans - lastTcpRetrans_
+      : info.totalRetrans;
+  lastTcpRetrans_ = info.totalRetrans;
+
+  auto* poolStats = proxy().stats().getPoolStats(stats().poolStatIndex_);
+  if (poolStats == nullptr) {
+    return;
+  }
+  poolStats->addTcpInfoSample(info.rttUs, retrans);
+
+  const auto percent = proxy().router().opts().rtt_reconnect_median_percent;
+  const auto medianUs = poolStats->rttMedianUs();
+  if (percent == 0 || medianUs == 0 ||
+      info.numSamples < lastRttReconnectSamples_ + kRttReconnectMinSamples ||
+      proxy().router().isRxmitReconnectionDisabled()) {
+    return;
+  }
+  if (static_cast<uint64_t>(info.rttUs) * 100 > medianUs * percent) {
+    transport_->closeNow();
+    proxy().stats().increment(rtt_closed_connections_stat);
+    lastRttReconnectSamples_ = info.numSamples;
+  }
+}
+
 template <class Transport>
 void ProxyDestination<Transport>::updateTransportTimeoutsIfShorter(
     std::chrono::milliseconds shortestConnectTimeout,
@@ -153,18 +247,20 @@ void ProxyDestination<Transport>::onReply(
     DestinationRequestCtx& destreqCtx,
     const RpcStatsContext& rpcStatsContext,
     bool isRequestBufferDirty) {
-  handleTko(result, /* isProbeRequest */ false);
-
-  if (!stats().results) {
-    stats().results = std::make_unique<std::array<
-        uint64_t,
-        static_cast<size_t>(carbon::Result::NUM_RESULTS)>>();
+  if (!destreqCtx.timeoutClamped || !isDataTimeoutResult(result)) {
+    handleTko(result, /* isProbeRequest */ false);
   }
+
   ++(*stats().results)[static_cast<size_t>(result)];
   destreqCtx.endTime = nowUs();
 
   int64_t latency = destreqCtx.endTime - destreqCtx.startTime;
   stats().avgLatency.insertSample(latency);
+  // Timed out requests are included, so that the estimate (and the adaptive
+  // timeout) grow back when the destination gets slower.
+  stats().p99Latency.insertSample(latency);
+  updateSendFraction(result);
+  updateWorstDestinations();
 
   if (accessPoint()->compressed()) {
     if (rpcStatsContext.usedCodecId > 0) {
@@ -186,6 +282,7 @@ void ProxyDestination<Transport>::onReply(
   }
 
   handleRxmittingConnection(result, latency);
+  handleTcpInfo();
 }
 
 template <class Transport>
@@ -292,6 +389,8 @@ void ProxyDestination<Transport>::initializeTransport() {
   options.tcpKeepAliveInterval = opts.keepalive_interval_s;
   options.numConnectTimeoutRetries = opts.connect_timeout_retries;
   options.connectTimeout = shortestConnectTimeout();
+  options.alternateAddressConnectTimeout =
+      std::chrono::milliseconds(opts.alternate_address_connect_timeout_ms);
   options.writeTimeout = shortestWriteTimeout();
   options.routerInfoName = proxy().router().routerInfoName();
   if (!opts.debug_fifo_root.empty()) {
@@ -303,9 +402,26 @@ void ProxyDestination<Transport>::initializeTransport() {
     options.qosPath = qosPath();
   }
   options.useJemallocNodumpAllocator = opts.jemalloc_nodump_buffers;
+  options.useIoUring = accessPoint()->useIoUring();
+  options.writeBatchMaxBytes = opts.target_write_batch_max_bytes;
+  options.writeBatchMaxIovecs = opts.target_write_batch_max_iovecs;
+  options.writeIdleImmediately = opts.target_write_idle_immediately;
+  options.thriftShareChannel = opts.thrift_share_connections;
+  options.tcpInfoSamplePeriod = opts.tcp_info_sample_period;
+  options.sendTimeoutBudget = opts.send_timeout_budget;
+  options.compactCaretHeader = opts.caret_compact_header;
+  options.asciiMetaProtocol = opts.ascii_meta_protocol;
+  if (opts.target_max_inflight_requests > 0) {
+    options.expirePendingRequests = opts.target_expire_pending_requests;
+    options.pendingLifoThreshold = opts.target_pending_lifo_threshold;
+  }
   if (accessPoint()->compressed()) {
     if (auto codecManager = proxy().router().getCodecManager()) {
       options.compressionCodecMap = codecManager->getCodecMap();
+      options.compressionCodecManager = codecManager;
+      options.negotiateCompression = opts.negotiate_compression;
+      options.decompressionOffloadThreshold =
+          opts.decompression_offload_threshold;
       options.thriftCompression = true;
       options.thriftCompressionThreshold = opts.thrift_compression_threshold;
     }
@@ -324,7 +440,9 @@ void ProxyDestination<Transport>::initializeTransport() {
         opts.ssl_service_identity_authorization_enforce;
     options.securityOpts.tfoEnabledForSsl = opts.enable_ssl_tfo;
     options.securityOpts.tlsPreferOcbCipher = opts.tls_prefer_ocb_cipher;
+    options.securityOpts.fizzUseKtls = opts.fizz_client_use_ktls;
   }
+  options.enableTFO = opts.enable_tfo;
 
   auto client = std::unique_ptr<Transport, typename Transport::Destructor>(
       new Transport(proxy().eventBase(), std::move(options)),
@@ -359,6 +477,10 @@ void ProxyDestination<Transport>::initializeTransport() {
         proxy().stats().increment(num_socket_writes_stat);
         proxy().stats().increment(destination_batches_sum_stat);
         proxy().stats().increment(destination_requests_sum_stat, numToSend);
+        if (auto* poolStats =
+                proxy().stats().getPoolStats(stats().poolStatIndex_)) {
+          poolStats->addBatchSizeSample(numToSend);
+        }
       },
       [this]() { // onPartialWrite
         proxy().stats().increment(num_socket_partial_writes_stat);
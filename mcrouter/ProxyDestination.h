@@ -8,6 +8,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -36,6 +37,12 @@ class TkoTracker;
 struct DestinationRequestCtx {
   int64_t startTime{0};
   int64_t endTime{0};
+  // The timeout was shortened to the client's timeout budget: timing out
+  // then says nothing about the health of the destination.
+  bool timeoutClamped{false};
+  // If set, the request is dropped rather than sent once this becomes true,
+  // see ProxyRequestContext::clientGone().
+  const std::atomic<bool>* clientGone{nullptr};
 
   explicit DestinationRequestCtx(int64_t now) : startTime(now) {}
 };
@@ -104,6 +111,11 @@ class ProxyDestination : public ProxyDestinationBase {
   uint64_t rxmitsToCloseConnection_{0};
   uint64_t lastConnCloseCycles_{0}; // Cycles when connection was last closed
 
+  // TCP_INFO samples seen from the transport (see tcp_info_sample_period)
+  uint64_t lastTcpInfoSamples_{0};
+  uint32_t lastTcpRetrans_{0};
+  uint64_t lastRttReconnectSamples_{0};
+
   /**
    * Creates a new ProxyDestination.
    *
@@ -138,6 +150,14 @@ class ProxyDestination : public ProxyDestinationBase {
 
   void handleRxmittingConnection(const carbon::Result result, uint64_t latency);
   bool latencyAboveThreshold(uint64_t latency);
+  void handleTcpInfo();
+
+  /**
+   * Feeds values of hit replies to the compression dictionary trainer, if
+   * dictionary training is enabled.
+   */
+  template <class Reply>
+  void sampleForDictionaryTraining(const Reply& reply);
 
   std::weak_ptr<ProxyDestination> selfPtr_;
 
@@ -7,13 +7,19 @@
 
 #include "ProxyDestinationBase.h"
 
+#include <algorithm>
 #include <chrono>
+#include <limits>
+#include <random>
 
 #include <folly/io/async/AsyncTimeout.h>
+#include <folly/tracing/StaticTracepoint.h>
 
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyDestinationBase.h"
+#include "mcrouter/ProxyDestinationKey.h"
+#include "mcrouter/TkoEventLog.h"
 #include "mcrouter/TkoLog.h"
 #include "mcrouter/TkoTracker.h"
 
@@ -23,18 +29,26 @@ namespace mcrouter {
 
 namespace {
 
-// Probe settings.
-constexpr double kProbeExponentialFactor = 1.5;
-constexpr double kProbeJitterMin = 0.05;
-constexpr double kProbeJitterMax = 0.5;
-constexpr double kProbeJitterDelta = kProbeJitterMax - kProbeJitterMin;
-
-static_assert(
-    kProbeJitterMax >= kProbeJitterMin,
-    "ProbeJitterMax should be greater or equal tham ProbeJitterMin");
+// Samples needed before the p99 estimate is trusted for timeouts.
+constexpr uint64_t kAdaptiveTimeoutMinSamples = 100;
 
 } // anonymous namespace
 
+std::chrono::milliseconds ProxyDestinationBase::adaptiveTimeout(
+    std::chrono::milliseconds timeout) const {
+  const auto& opts = proxy().router().opts();
+  if (!opts.adaptive_timeouts ||
+      stats_.p99Latency.numSamples() < kAdaptiveTimeoutMinSamples) {
+    return timeout;
+  }
+  // Latencies are in us.
+  auto adaptiveMs = static_cast<int64_t>(
+      stats_.p99Latency.value() * opts.adaptive_timeout_p99_percent /
+      (100 * 1000));
+  adaptiveMs = std::max<int64_t>(adaptiveMs, opts.adaptive_timeout_floor_ms);
+  return std::min(timeout, std::chrono::milliseconds(adaptiveMs));
+}
+
 void ProxyDestinationBase::updateTkoStats(GlobalTkoUpdateType type) {
   switch (type) {
     case GlobalTkoUpdateType::INC_SOFT_TKOS:
@@ -79,11 +93,12 @@ ProxyDestinationBase::ProxyDestinationBase(
     uint32_t idx)
     : proxy_(proxy),
       accessPoint_(std::move(ap)),
-      shortestConnectTimeout_(timeout),
       shortestWriteTimeout_(timeout),
+      shortestConnectTimeout_(timeout),
       qosClass_(qosClass),
       qosPath_(qosPath),
       idx_(idx) {
+  stats_.results = proxy_.destinationCounters().allocate();
   proxy_.stats().increment(num_servers_new_stat);
   proxy_.stats().increment(num_servers_stat);
   if (accessPoint()->useSsl()) {
@@ -93,10 +108,14 @@ ProxyDestinationBase::ProxyDestinationBase(
 }
 
 ProxyDestinationBase::~ProxyDestinationBase() {
+  if (inWorstDestinations_) {
+    proxy_.worstDestinations()->remove(this);
+  }
   if (tracker_->removeDestination(this)) {
     onTkoEvent(TkoLogEvent::RemoveFromConfig, carbon::Result::OK);
     stopSendingProbes();
   }
+  proxy_.destinationCounters().release(stats_.results);
 }
 
 void ProxyDestinationBase::updateShortestTimeout(
@@ -124,9 +143,65 @@ bool ProxyDestinationBase::maySend(carbon::Result& tkoReason) const {
     tkoReason = tracker_->tkoReason();
     return false;
   }
+  if (stats_.sendFraction < 1.0 &&
+      std::generate_canonical<double, std::numeric_limits<double>::digits>(
+          proxy_.randomGenerator()) >= stats_.sendFraction) {
+    proxy_.stats().increment(destination_degraded_shed_stat);
+    tkoReason = carbon::Result::TKO;
+    return false;
+  }
   return true;
 }
 
+void ProxyDestinationBase::updateSendFraction(carbon::Result result) {
+  const auto& opts = proxy().router().opts();
+  const bool degradedEnabled =
+      opts.degraded_error_rate_percent != 0 || opts.degraded_latency_ms != 0;
+  if (!degradedEnabled && !proxy().worstDestinations()) {
+    return;
+  }
+  stats_.errorRate.insertSample(
+      isHardTkoErrorResult(result) || isSoftTkoErrorResult(result) ? 1.0 : 0.0);
+  if (!degradedEnabled) {
+    return;
+  }
+
+  double fraction = 1.0;
+  if (opts.degraded_error_rate_percent > 0 &&
+      opts.degraded_error_rate_percent < 100) {
+    // Linearly down to nothing at 100% errors.
+    double threshold = opts.degraded_error_rate_percent / 100.0;
+    double errorRate = stats_.errorRate.value();
+    if (errorRate > threshold) {
+      fraction = 1.0 - (errorRate - threshold) / (1.0 - threshold);
+    }
+  }
+  if (opts.degraded_latency_ms > 0) {
+    // Latencies are in us.
+    double threshold = opts.degraded_latency_ms * 1000.0;
+    double latency = stats_.avgLatency.value();
+    if (latency > threshold) {
+      fraction = std::min(fraction, threshold / latency);
+    }
+  }
+  stats_.sendFraction = std::max(
+      fraction, std::min(opts.degraded_min_send_percent, 100u) / 100.0);
+}
+
+void ProxyDestinationBase::updateWorstDestinations() {
+  auto* worstDestinations = proxy().worstDestinations();
+  if (!worstDestinations) {
+    return;
+  }
+  // Latencies are in us; an error counts as much as a timed out request.
+  const double score = stats_.avgLatency.value() +
+      stats_.errorRate.value() * shortestWriteTimeout_.count() * 1000.0;
+  inWorstDestinations_ = worstDestinations->record(
+      this, inWorstDestinations_, score, [this]() {
+        return ProxyDestinationKey(*this).str();
+      });
+}
+
 void ProxyDestinationBase::onTkoEvent(TkoLogEvent event, carbon::Result result)
     const {
   auto logUtil = [this, result](folly::StringPiece eventStr) {
@@ -136,21 +211,42 @@ void ProxyDestinationBase::onTkoEvent(TkoLogEvent event, carbon::Result result)
             << ". Reply: " << carbon::resultToString(result);
   };
 
-  switch (event) {
-    case TkoLogEvent::MarkHardTko:
-      logUtil("marked hard TKO");
-      break;
-    case TkoLogEvent::MarkSoftTko:
-      logUtil("marked soft TKO");
-      break;
-    case TkoLogEvent::UnMarkTko:
-      logUtil("unmarked TKO");
-      break;
-    case TkoLogEvent::RemoveFromConfig:
-      logUtil("was TKO, removed from config");
-      break;
+  if (auto* tkoEventLog = proxy().router().tkoEventLog()) {
+    // Logged in batches, off the proxy thread.
+    TkoEventLog::Event tkoEvent;
+    tkoEvent.event = event;
+    tkoEvent.result = result;
+    tkoEvent.poolStatIndex = stats_.poolStatIndex_;
+    tkoEvent.accessPoint = accessPoint_.load();
+    tkoEvent.hardTkos = tracker_->globalTkos().hardTkos;
+    tkoEvent.softTkos = tracker_->globalTkos().softTkos;
+    tkoEventLog->add(std::move(tkoEvent));
+  } else {
+    switch (event) {
+      case TkoLogEvent::MarkHardTko:
+        logUtil("marked hard TKO");
+        break;
+      case TkoLogEvent::MarkSoftTko:
+        logUtil("marked soft TKO");
+        break;
+      case TkoLogEvent::UnMarkTko:
+        logUtil("unmarked TKO");
+        break;
+      case TkoLogEvent::RemoveFromConfig:
+        logUtil("was TKO, removed from config");
+        break;
+    }
   }
 
+  const auto hostPort = accessPoint_.load()->toHostPortString();
+  FOLLY_SDT(
+      mcrouter,
+      destination_tko,
+      this,
+      hostPort.c_str(),
+      static_cast<int>(event),
+      static_cast<int>(result));
+
   TkoLog tkoLog(*accessPoint_.load(), tracker_->globalTkos());
   tkoLog.event = event;
   tkoLog.isHardTko = tracker_->isHardTko();
@@ -195,27 +291,12 @@ void ProxyDestinationBase::handleTko(
   tracker_->recordSuccess(this);
 }
 
-void ProxyDestinationBase::scheduleNextProbe() {
+void ProxyDestinationBase::scheduleNextProbe(
+    std::chrono::milliseconds delay) {
   assert(!proxy().router().opts().disable_tko_tracking);
+  assert(delay.count() > 0);
 
-  int delayMs = probeDelayNextMs;
-  if (probeDelayNextMs < 2) {
-    // int(1 * 1.5) == 1, so advance it to 2 first
-    probeDelayNextMs = 2;
-  } else {
-    probeDelayNextMs *= kProbeExponentialFactor;
-  }
-  if (probeDelayNextMs > proxy().router().opts().probe_delay_max_ms) {
-    probeDelayNextMs = proxy().router().opts().probe_delay_max_ms;
-  }
-
-  // Calculate random jitter
-  double r = (double)rand() / (double)RAND_MAX;
-  double tmo_jitter_pct = r * kProbeJitterDelta + kProbeJitterMin;
-  delayMs = (double)delayMs * (1.0 + tmo_jitter_pct);
-  assert(delayMs > 0);
-
-  if (!probeTimer_->scheduleTimeout(delayMs)) {
+  if (!probeTimer_->scheduleTimeout(delay)) {
     MC_LOG_FAILURE(
         proxy().router().opts(),
         failure::Category::kSystemError,
@@ -224,7 +305,6 @@ void ProxyDestinationBase::scheduleNextProbe() {
 }
 
 void ProxyDestinationBase::startSendingProbes() {
-  probeDelayNextMs = proxy().router().opts().probe_delay_initial_ms;
   probeTimer_ =
       folly::AsyncTimeout::make(proxy().eventBase(), [this]() noexcept {
         // Note that the previous probe might still be in flight
@@ -242,13 +322,18 @@ void ProxyDestinationBase::startSendingProbes() {
             pdstn->probeInflight_ = false;
           });
         }
-        scheduleNextProbe();
+        scheduleNextProbe(
+            proxy().router().probeScheduler().next(accessPoint()->toString()));
       });
-  scheduleNextProbe();
+  scheduleNextProbe(
+      proxy().router().probeScheduler().start(accessPoint()->toString()));
 }
 
 void ProxyDestinationBase::stopSendingProbes() {
   stats_.probesSent = 0;
+  if (probeTimer_) {
+    proxy().router().probeScheduler().stop(accessPoint()->toString());
+  }
   probeTimer_.reset();
 }
 
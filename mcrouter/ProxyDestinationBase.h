@@ -8,13 +8,16 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <memory>
 
 #include <folly/IntrusiveList.h>
 #include <folly/concurrency/AtomicSharedPtr.h>
 
+#include "mcrouter/DestinationCounters.h"
 #include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/StreamingQuantile.h"
 #include "mcrouter/TkoLog.h"
 #include "mcrouter/lib/carbon/Result.h"
 #include "mcrouter/lib/network/Transport.h"
@@ -56,11 +59,18 @@ class ProxyDestinationBase {
   };
 
   struct Stats {
+    // Updated on every request or reply, kept together at the front.
     State state{State::New};
+    // Fraction of requests sent while degraded (see degraded_* options).
+    double sendFraction{1.0};
+    // Reply counts by result, a row of the proxy's DestinationCounters.
+    DestinationCounters::Results* results{nullptr};
     ExponentialSmoothData<16> avgLatency;
-    std::unique_ptr<
-        std::array<uint64_t, static_cast<size_t>(carbon::Result::NUM_RESULTS)>>
-        results;
+    // Recent fraction of replies with TKO-class errors.
+    ExponentialSmoothData<64> errorRate;
+    StreamingQuantile p99Latency{0.99};
+
+    // Updated on probes, reconnects and retransmit checks only.
     size_t probesSent{0};
     double retransPerKByte{0.0};
     // If poolstats config is present, keep track of most recent
@@ -87,7 +97,8 @@ class ProxyDestinationBase {
    *                    this method returns true.
    *
    * @return  True iff it is okay to send a request using this client.
-   *          False otherwise.
+   *          False otherwise, including for the share of requests shed
+   *          while this destination is degraded.
    */
   bool maySend(carbon::Result& tkoReason) const;
 
@@ -148,6 +159,19 @@ class ProxyDestinationBase {
     return shortestConnectTimeout_;
   }
 
+  /**
+   * Standby destinations (of pools with 'standby' set) are never closed for
+   * inactivity and get keepalives while idle, see
+   * ProxyDestinationMap::sendStandbyKeepalives(). Once set, stays set for the
+   * lifetime of the destination.
+   */
+  void setStandby() {
+    standby_.store(true, std::memory_order_relaxed);
+  }
+  bool standby() const {
+    return standby_.load(std::memory_order_relaxed);
+  }
+
  protected:
   virtual void updateTransportTimeoutsIfShorter(
       std::chrono::milliseconds shortestConnectTimeout,
@@ -158,7 +182,28 @@ class ProxyDestinationBase {
   void markAsActive();
   void setState(State st);
 
+  /**
+   * With adaptive_timeouts, returns the timeout to use for a request to this
+   * destination: a multiple of the observed p99 latency, at least
+   * adaptive_timeout_floor_ms and at most `timeout`.
+   * Otherwise returns `timeout`.
+   */
+  std::chrono::milliseconds adaptiveTimeout(
+      std::chrono::milliseconds timeout) const;
+
   void handleTko(const carbon::Result result, bool isProbeRequest);
+
+  /**
+   * Updates the share of traffic this destination gets after a reply with
+   * the given result: less than all of it while its error rate or latency
+   * are above the degraded_* thresholds, ramping back up as they improve.
+   */
+  void updateSendFraction(carbon::Result result);
+  /**
+   * Updates the score of this destination in the proxy's list of worst
+   * destinations (see worst_destinations_count), if enabled.
+   */
+  void updateWorstDestinations();
   void onTransitionToState(State state);
   void onTransitionFromState(State state);
 
@@ -187,32 +232,40 @@ class ProxyDestinationBase {
   }
 
  private:
+  // Fields read or written for every request come first, so that the
+  // request path touches as few cache lines as possible. Connection
+  // management and probe state follows.
   ProxyBase& proxy_;
   std::shared_ptr<TkoTracker> tracker_;
 
   // Destination host information
   folly::atomic_shared_ptr<const AccessPoint> accessPoint_;
-  std::chrono::milliseconds shortestConnectTimeout_{0};
   std::chrono::milliseconds shortestWriteTimeout_{0};
+  bool probeInflight_{false};
+  bool inWorstDestinations_{false};
+
+  Stats stats_;
+
+  std::chrono::milliseconds shortestConnectTimeout_{0};
   const uint32_t qosClass_{0};
   const uint32_t qosPath_{0};
   const uint32_t idx_{0};
 
-  Stats stats_;
-
   // Fields related to probes (for un-TKO).
   std::unique_ptr<folly::AsyncTimeout> probeTimer_;
-  int probeDelayNextMs{0};
-  bool probeInflight_{false};
 
   void* stateList_{nullptr};
   folly::IntrusiveListHook stateListHook_;
+  // Number of reset intervals this destination has been inactive for.
+  uint32_t inactiveIntervals_{0};
+  // Set by config threads, read by the proxy thread.
+  std::atomic<bool> standby_{false};
 
   void onTkoEvent(TkoLogEvent event, carbon::Result result) const;
 
   void startSendingProbes();
   void stopSendingProbes();
-  void scheduleNextProbe();
+  void scheduleNextProbe(std::chrono::milliseconds delay);
 
   void onTransitionImpl(State state, bool to);
 
@@ -47,7 +47,7 @@ std::string ProxyDestinationKey::str() const {
 
 size_t ProxyDestinationKey::hash() const {
   auto result = folly::hash::hash_combine(
-      accessPoint.getHost(),
+      accessPoint.getHostId(),
       accessPoint.getPort(),
       static_cast<std::underlying_type_t<mc_protocol_e>>(
           accessPoint.getProtocol()),
@@ -64,7 +64,7 @@ size_t ProxyDestinationKey::hash() const {
 }
 
 bool ProxyDestinationKey::operator==(const ProxyDestinationKey& other) const {
-  if (accessPoint.getHost() != other.accessPoint.getHost() ||
+  if (accessPoint.getHostId() != other.accessPoint.getHostId() ||
       accessPoint.getPort() != other.accessPoint.getPort() ||
       accessPoint.getProtocol() != other.accessPoint.getProtocol() ||
       accessPoint.getSecurityMech() != other.accessPoint.getSecurityMech() ||
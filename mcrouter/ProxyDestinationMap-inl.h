@@ -77,6 +77,27 @@ std::shared_ptr<ProxyDestination<Transport>> ProxyDestinationMap::emplace(
   return destination;
 }
 
+template <class Transport>
+std::shared_ptr<ProxyDestination<Transport>> ProxyDestinationMap::emplaceShared(
+    const ProxyDestination<Transport>& destination) {
+  // The TkoTracker is shared by host, so it already has the pool tracker.
+  auto shared = emplace<Transport>(
+      std::make_shared<AccessPoint>(*destination.accessPoint()),
+      destination.shortestWriteTimeout(),
+      destination.qosClass(),
+      destination.qosPath(),
+      /* poolTkoTracker */ nullptr,
+      destination.idx());
+  auto it = sharedDestinations_.find(shared.get());
+  if (it == sharedDestinations_.end()) {
+    shared->updateShortestTimeout(
+        destination.shortestConnectTimeout(),
+        destination.shortestWriteTimeout());
+    sharedDestinations_.emplace(shared.get(), shared);
+  }
+  return shared;
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
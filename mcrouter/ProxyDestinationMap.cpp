@@ -7,9 +7,17 @@
 
 #include "ProxyDestinationMap.h"
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/fibers/WhenN.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 
@@ -65,6 +73,7 @@ ProxyDestinationMap::ProxyDestinationMap(ProxyBase* proxy)
     : proxy_(proxy),
       active_(std::make_unique<StateList>()),
       inactive_(std::make_unique<StateList>()),
+      closing_(std::make_unique<StateList>()),
       inactivityTimeout_(0) {}
 
 void ProxyDestinationMap::removeDestination(ProxyDestinationBase& destination) {
@@ -72,6 +81,8 @@ void ProxyDestinationMap::removeDestination(ProxyDestinationBase& destination) {
     active_->list.erase(StateList::List::s_iterator_to(destination));
   } else if (destination.stateList_ == inactive_.get()) {
     inactive_->list.erase(StateList::List::s_iterator_to(destination));
+  } else if (destination.stateList_ == closing_.get()) {
+    closing_->list.erase(StateList::List::s_iterator_to(destination));
   }
   {
     std::lock_guard<std::mutex> lck(destinationsLock_);
@@ -85,18 +96,106 @@ void ProxyDestinationMap::markAsActive(ProxyDestinationBase& destination) {
   }
   if (destination.stateList_ == inactive_.get()) {
     inactive_->list.erase(StateList::List::s_iterator_to(destination));
+  } else if (destination.stateList_ == closing_.get()) {
+    closing_->list.erase(StateList::List::s_iterator_to(destination));
   }
   active_->list.push_back(destination);
   destination.stateList_ = active_.get();
+  destination.inactiveIntervals_ = 0;
 }
 
-void ProxyDestinationMap::resetAllInactive() {
-  for (auto& it : inactive_->list) {
-    it.resetInactive();
-    it.stateList_ = nullptr;
+std::vector<std::shared_ptr<ProxyDestinationBase>>
+ProxyDestinationMap::getAllDestinations() {
+  std::vector<std::shared_ptr<ProxyDestinationBase>> result;
+  std::lock_guard<std::mutex> lock(destinationsLock_);
+  result.reserve(destinations_.size());
+  for (auto* dst : destinations_) {
+    if (auto ptr = dst->selfPtr().lock()) {
+      result.push_back(std::move(ptr));
+    }
   }
-  inactive_->list.clear();
+  return result;
+}
+
+void ProxyDestinationMap::resetAllInactive() {
+  rotateInactive();
+  closeInactive(closing_->list.size());
+}
+
+void ProxyDestinationMap::rotateInactive() {
+  const auto sslIntervals =
+      proxy_->router().opts().reset_inactive_ssl_connection_intervals;
+  // After the swap, inactive_ holds the destinations active during the
+  // interval that just ended, and active_ the ones inactive during it.
   active_.swap(inactive_);
+  while (!active_->list.empty()) {
+    auto& dst = active_->list.front();
+    active_->list.pop_front();
+    // Reconnecting with SSL costs a handshake, keep those open longer.
+    // Standby destinations are kept open for failover traffic.
+    if (dst.standby() ||
+        (dst.accessPoint()->useSsl() &&
+         ++dst.inactiveIntervals_ < sslIntervals)) {
+      inactive_->list.push_back(dst);
+      dst.stateList_ = inactive_.get();
+    } else {
+      closing_->list.push_back(dst);
+      dst.stateList_ = closing_.get();
+    }
+  }
+}
+
+void ProxyDestinationMap::closeInactive(size_t max) {
+  for (size_t i = 0; i < max && !closing_->list.empty(); ++i) {
+    auto& dst = closing_->list.front();
+    closing_->list.pop_front();
+    dst.stateList_ = nullptr;
+    dst.resetInactive();
+  }
+  releaseInactiveShared();
+}
+
+bool ProxyDestinationMap::resetInTicks() const {
+  const auto& opts = proxy_->router().opts();
+  return opts.reset_inactive_connection_spread ||
+      opts.reset_inactive_connection_max_per_sec > 0;
+}
+
+void ProxyDestinationMap::onResetTick() {
+  if (ticksLeft_ == 0) {
+    rotateInactive();
+    ticksLeft_ = kResetTicksPerInterval;
+  }
+  const auto& opts = proxy_->router().opts();
+  size_t toClose = closing_->list.size();
+  if (opts.reset_inactive_connection_spread) {
+    // Close an even share of what's left in each of the remaining ticks.
+    toClose = (toClose + ticksLeft_ - 1) / ticksLeft_;
+  }
+  if (opts.reset_inactive_connection_max_per_sec > 0) {
+    const size_t maxPerTick = std::max<size_t>(
+        1,
+        static_cast<uint64_t>(opts.reset_inactive_connection_max_per_sec) *
+            inactivityTimeout_ / kResetTicksPerInterval / 1000);
+    // What doesn't fit stays in the closing list, for the next ticks.
+    toClose = std::min(toClose, maxPerTick);
+  }
+  --ticksLeft_;
+  closeInactive(toClose);
+}
+
+void ProxyDestinationMap::releaseInactiveShared() {
+  // Destroyed after the loop, since destructors call removeDestination().
+  std::vector<std::shared_ptr<ProxyDestinationBase>> released;
+  for (auto it = sharedDestinations_.begin();
+       it != sharedDestinations_.end();) {
+    if (it->first->stateList_ == nullptr) {
+      released.push_back(std::move(it->second));
+      it = sharedDestinations_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 void ProxyDestinationMap::setResetTimer(std::chrono::milliseconds interval) {
@@ -106,14 +205,28 @@ void ProxyDestinationMap::setResetTimer(std::chrono::milliseconds interval) {
   inactivityTimeout_ = static_cast<uint32_t>(interval.count());
   resetTimer_ =
       folly::AsyncTimeout::make(proxy_->eventBase(), [this]() noexcept {
-        resetAllInactive();
+        if (resetInTicks()) {
+          onResetTick();
+        } else {
+          resetAllInactive();
+        }
         scheduleTimer(false /* initialAttempt */);
       });
+  // The first interval only collects the active destinations.
+  ticksLeft_ = kResetTicksPerInterval;
   scheduleTimer(true /* initialAttempt */);
 }
 
 void ProxyDestinationMap::scheduleTimer(bool initialAttempt) {
-  if (!resetTimer_->scheduleTimeout(inactivityTimeout_)) {
+  uint32_t timeout = inactivityTimeout_;
+  if (resetInTicks()) {
+    // +-25% of jitter, so that the proxies (and mcrouters) started at the
+    // same time don't close connections in lockstep.
+    const uint32_t tick = std::max<uint32_t>(
+        1, inactivityTimeout_ / kResetTicksPerInterval);
+    timeout = tick * 3 / 4 + folly::Random::rand32(tick / 2 + 1);
+  }
+  if (!resetTimer_->scheduleTimeout(timeout)) {
     MC_LOG_FAILURE(
         proxy_->router().opts(),
         memcache::failure::Category::kSystemError,
@@ -122,7 +235,124 @@ void ProxyDestinationMap::scheduleTimer(bool initialAttempt) {
   }
 }
 
-ProxyDestinationMap::~ProxyDestinationMap() {}
+void ProxyDestinationMap::setStandbyTimer(std::chrono::milliseconds interval) {
+  folly::RequestContextScopeGuard rctxGuard{
+      std::shared_ptr<folly::RequestContext>{}};
+  assert(interval.count() > 0);
+  standbyInterval_ = static_cast<uint32_t>(interval.count());
+  standbyTimer_ =
+      folly::AsyncTimeout::make(proxy_->eventBase(), [this]() noexcept {
+        sendStandbyKeepalives();
+        if (!standbyTimer_->scheduleTimeout(standbyInterval_)) {
+          MC_LOG_FAILURE(
+              proxy_->router().opts(),
+              memcache::failure::Category::kSystemError,
+              "failed to re-schedule standby keepalive timer");
+        }
+      });
+  if (!standbyTimer_->scheduleTimeout(standbyInterval_)) {
+    MC_LOG_FAILURE(
+        proxy_->router().opts(),
+        memcache::failure::Category::kSystemError,
+        "failed to schedule standby keepalive timer");
+  }
+}
+
+void ProxyDestinationMap::sendStandbyKeepalives() {
+  std::vector<std::weak_ptr<ProxyDestinationBase>> destinations;
+  {
+    std::lock_guard<std::mutex> lck(destinationsLock_);
+    for (auto* dst : destinations_) {
+      if (dst->standby() &&
+          (dst->stateList_ != active_.get() ||
+           dst->stats().state != ProxyDestinationBase::State::Up)) {
+        destinations.push_back(dst->selfPtr());
+      }
+    }
+  }
+  if (destinations.empty()) {
+    return;
+  }
+
+  proxy_->fiberManager().addTask(
+      [proxy = proxy_, destinations = std::move(destinations)]() {
+        std::vector<std::function<void()>> keepalives;
+        keepalives.reserve(destinations.size());
+        for (const auto& weakDst : destinations) {
+          keepalives.push_back([proxy, weakDst]() {
+            auto pdstn = weakDst.lock();
+            carbon::Result tkoReason;
+            if (!pdstn || !pdstn->maySend(tkoReason)) {
+              return;
+            }
+            proxy->stats().increment(standby_keepalives_sent_stat);
+            // Not marked as active: only real traffic counts as activity.
+            pdstn->handleTko(pdstn->sendProbe(), /* isProbeRequest */ false);
+          });
+        }
+        folly::fibers::collectAll(keepalives.begin(), keepalives.end());
+      });
+}
+
+void ProxyDestinationMap::prewarmConnections(
+    size_t connectionsPerSecond,
+    uint32_t percent,
+    folly::Function<void()> onDone) {
+  std::vector<std::weak_ptr<ProxyDestinationBase>> destinations;
+  {
+    std::lock_guard<std::mutex> lck(destinationsLock_);
+    for (auto* dst : destinations_) {
+      if (dst->stats().state == ProxyDestinationBase::State::New &&
+          (percent >= 100 || folly::Random::rand32(100) < percent)) {
+        destinations.push_back(dst->selfPtr());
+      }
+    }
+  }
+
+  proxy_->fiberManager().addTask([destinations = std::move(destinations),
+                                  batchSize = std::max<size_t>(
+                                      1, connectionsPerSecond),
+                                  onDone = std::move(onDone)]() mutable {
+    constexpr std::chrono::seconds kBatchInterval{1};
+    for (size_t begin = 0; begin < destinations.size(); begin += batchSize) {
+      const auto batchStart = std::chrono::steady_clock::now();
+      const auto end = std::min(destinations.size(), begin + batchSize);
+      std::vector<std::function<void()>> connects;
+      connects.reserve(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        connects.push_back([weakDst = destinations[i]]() {
+          auto pdstn = weakDst.lock();
+          carbon::Result tkoReason;
+          // Might have been used (or TKO'd) since the list was built.
+          if (!pdstn ||
+              pdstn->stats().state != ProxyDestinationBase::State::New ||
+              !pdstn->maySend(tkoReason)) {
+            return;
+          }
+          pdstn->markAsActive();
+          pdstn->handleTko(pdstn->sendProbe(), /* isProbeRequest */ false);
+        });
+      }
+      folly::fibers::collectAll(connects.begin(), connects.end());
+
+      const auto elapsed = std::chrono::steady_clock::now() - batchStart;
+      if (end < destinations.size() && elapsed < kBatchInterval) {
+        folly::fibers::Baton baton;
+        baton.try_wait_for(kBatchInterval - elapsed);
+      }
+    }
+    onDone();
+  });
+}
+
+ProxyDestinationMap::~ProxyDestinationMap() {
+  // Shared destinations may die here, and won't unlink themselves from the
+  // lists while the proxy is shutting down.
+  active_->list.clear();
+  inactive_->list.clear();
+  closing_->list.clear();
+  sharedDestinations_.clear();
+}
 
 } // namespace mcrouter
 } // namespace memcache
@@ -15,8 +15,10 @@
 #include <vector>
 
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
 #include <folly/container/F14Set.h>
 #include <folly/dynamic.h>
+#include <folly/Function.h>
 #include <folly/io/async/AsyncTimeout.h>
 
 namespace facebook {
@@ -46,6 +48,9 @@ class PoolTkoTracker;
  * opened connection to this destination and there were requests during last
  * reset_inactive_connection_interval ms routed to this destination.
  * 'Inactive' means there were no requests and connection may be closed.
+ * Inactive destinations go to the 'closing' list when their connection is
+ * due to be closed, which happens right away or, to avoid reconnect storms,
+ * spread over the next interval (see reset-inactive-connection-spread).
  *
  * Note: There's one ProxyDestinationMap per proxy thread.
  */
@@ -69,6 +74,18 @@ class ProxyDestinationMap {
       const std::shared_ptr<PoolTkoTracker>& poolTkoTracker,
       uint32_t idx);
 
+  /**
+   * Returns this proxy's destination with the same key as `destination`
+   * (normally owned by another proxy), creating it if needed.
+   * Destinations created this way are kept alive by the map until they become
+   * inactive, so that other proxies can share their connection without
+   * holding references to objects of this proxy.
+   * Must be called from the proxy thread.
+   */
+  template <class Transport>
+  std::shared_ptr<ProxyDestination<Transport>> emplaceShared(
+      const ProxyDestination<Transport>& destination);
+
   template <class Transport>
   std::shared_ptr<const AccessPoint> replace(
       const AccessPoint& tmpOldAccessPoint,
@@ -94,6 +111,8 @@ class ProxyDestinationMap {
   /**
    * Close all 'inactive' destinations i.e. destinations which weren't marked
    * 'active' after last removeAllInactive call.
+   * SSL destinations stay open until they were inactive for
+   * reset-inactive-ssl-connection-intervals calls.
    */
   void resetAllInactive();
 
@@ -103,6 +122,40 @@ class ProxyDestinationMap {
    */
   void setResetTimer(std::chrono::milliseconds interval);
 
+  /**
+   * Set timer which sends keepalives to standby destinations, see
+   * sendStandbyKeepalives().
+   * @param interval timer interval, should be greater than zero.
+   */
+  void setStandbyTimer(std::chrono::milliseconds interval);
+
+  /**
+   * Sends a version request to every standby destination that wasn't active
+   * during the current reset interval or isn't connected, which opens its
+   * connection if needed and keeps it from being closed by the server.
+   * TKO destinations are skipped, they are probed anyway.
+   * Must be called from the proxy thread.
+   */
+  void sendStandbyKeepalives();
+
+  /**
+   * Connects to destinations that were never connected, by sending them a
+   * version request, at most `connectionsPerSecond` at a time. Only
+   * `percent`% of them, picked at random, are connected.
+   * Must be called from the proxy thread. `onDone` is called once all
+   * connection attempts finished.
+   */
+  void prewarmConnections(
+      size_t connectionsPerSecond,
+      uint32_t percent,
+      folly::Function<void()> onDone);
+
+  /**
+   * @return  A reference to every destination stored in ProxyDestinationMap.
+   * Must be called from the proxy thread.
+   */
+  std::vector<std::shared_ptr<ProxyDestinationBase>> getAllDestinations();
+
   /**
    * Calls f(const ProxyDestination&) for each destination stored
    * in ProxyDestinationMap. The whole map is locked during the call.
@@ -142,9 +195,23 @@ class ProxyDestinationMap {
 
   std::unique_ptr<StateList> active_;
   std::unique_ptr<StateList> inactive_;
+  std::unique_ptr<StateList> closing_;
+
+  // Destinations used by other proxies, see emplaceShared().
+  folly::F14FastMap<
+      ProxyDestinationBase*,
+      std::shared_ptr<ProxyDestinationBase>>
+      sharedDestinations_;
+
+  static constexpr uint32_t kResetTicksPerInterval = 10;
 
   uint32_t inactivityTimeout_;
   std::unique_ptr<folly::AsyncTimeout> resetTimer_;
+  std::unique_ptr<folly::AsyncTimeout> standbyTimer_;
+  uint32_t standbyInterval_{0};
+  // Timer ticks left until the end of the current interval, when closing
+  // of inactive connections is spread or rate limited.
+  uint32_t ticksLeft_{0};
 
   /**
    * Schedules timeout for resetting inactive connections.
@@ -152,6 +219,29 @@ class ProxyDestinationMap {
    * @param initial  true iff this an initial attempt to schedule timer.
    */
   void scheduleTimer(bool initialAttempt);
+
+  /**
+   * Moves the destinations inactive for a whole interval to the closing
+   * list and starts a new interval.
+   */
+  void rotateInactive();
+
+  /**
+   * Closes the connections of at most `max` closing destinations.
+   */
+  void closeInactive(size_t max);
+
+  /**
+   * Whether the reset timer ticks kResetTicksPerInterval times per interval.
+   */
+  bool resetInTicks() const;
+
+  void onResetTick();
+
+  /**
+   * Drops references to shared destinations that are not active anymore.
+   */
+  void releaseInactiveShared();
 };
 
 } // namespace mcrouter
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Bump allocator for state that lives exactly as long as a single proxy
+ * request.
+ *
+ * The storage is carved out of the same allocation as the owning
+ * ProxyRequestContext (see createProxyRequestContext()), so everything
+ * allocated from the arena is released together with the context in one
+ * free. Individual deallocations of arena memory are no-ops. Once the arena
+ * is exhausted allocations fall back to the heap.
+ */
+class ProxyRequestArena {
+ public:
+  ProxyRequestArena() = default;
+
+  ProxyRequestArena(void* begin, size_t size) noexcept
+      : begin_(static_cast<char*>(begin)), cur_(begin_), end_(begin_ + size) {}
+
+  ProxyRequestArena(const ProxyRequestArena&) = delete;
+  ProxyRequestArena& operator=(const ProxyRequestArena&) = delete;
+
+  void reset(void* begin, size_t size) noexcept {
+    begin_ = cur_ = static_cast<char*>(begin);
+    end_ = begin_ + size;
+  }
+
+  /**
+   * @return  pointer to `size` bytes aligned to `align`, or nullptr if the
+   *          arena doesn't have enough space left.
+   */
+  void* tryAllocate(size_t size, size_t align) noexcept {
+    assert(align != 0 && (align & (align - 1)) == 0);
+    auto p = reinterpret_cast<uintptr_t>(cur_);
+    auto aligned = (p + align - 1) & ~(uintptr_t(align) - 1);
+    if (aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+      return nullptr;
+    }
+    cur_ = reinterpret_cast<char*>(aligned + size);
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    if (auto p = tryAllocate(size, align)) {
+      return p;
+    }
+    return ::operator new(size);
+  }
+
+  void deallocate(void* p) noexcept {
+    if (!contains(p)) {
+      ::operator delete(p);
+    }
+  }
+
+  bool contains(const void* p) const noexcept {
+    return p >= begin_ && p < end_;
+  }
+
+  const char* begin() const noexcept {
+    return begin_;
+  }
+
+  const char* end() const noexcept {
+    return end_;
+  }
+
+  size_t capacity() const noexcept {
+    return end_ - begin_;
+  }
+
+  size_t used() const noexcept {
+    return cur_ - begin_;
+  }
+
+ private:
+  char* begin_{nullptr};
+  char* cur_{nullptr};
+  char* end_{nullptr};
+};
+
+/**
+ * Standard allocator adapter over ProxyRequestArena.
+ */
+template <class T>
+class ProxyRequestArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ProxyRequestArenaAllocator(ProxyRequestArena& arena) noexcept
+      : arena_(&arena) {}
+
+  template <class U>
+  /* implicit */ ProxyRequestArenaAllocator(
+      const ProxyRequestArenaAllocator<U>& other) noexcept
+      : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    static_assert(
+        alignof(T) <= alignof(std::max_align_t),
+        "Over-aligned types are not supported");
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t /* n */) noexcept {
+    arena_->deallocate(p);
+  }
+
+  template <class U>
+  bool operator==(const ProxyRequestArenaAllocator<U>& other) const noexcept {
+    return arena_ == other.arena_;
+  }
+  template <class U>
+  bool operator!=(const ProxyRequestArenaAllocator<U>& other) const noexcept {
+    return !(*this == other);
+  }
+
+ private:
+  template <class U>
+  friend class ProxyRequestArenaAllocator;
+
+  ProxyRequestArena* arena_;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
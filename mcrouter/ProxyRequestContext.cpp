@@ -23,9 +23,20 @@ ProxyRequestContext::ProxyRequestContext(
     const void* ptr)
     : ptr_(ptr), proxyBase_(pr), priority_(priority__) {
   proxyBase_.stats().incrementSafe(proxy_request_num_outstanding_stat);
+  if (auto* tracer = proxyBase_.requestTracer()) {
+    traceContext_ = tracer->startTrace();
+    if (traceContext_.sampled()) {
+      traceStartNs_ = RequestTracer::nowNs();
+    }
+  }
 }
 
 ProxyRequestContext::~ProxyRequestContext() {
+  if (inflightBytes_ > 0) {
+    proxyBase_.inflightBytes_ -= inflightBytes_;
+    proxyBase_.stats().decrement(proxy_inflight_bytes_stat, inflightBytes_);
+  }
+
   if (recording_) {
     recordingState_.~unique_ptr<RecordingState>();
     return;
@@ -36,6 +47,10 @@ ProxyRequestContext::~ProxyRequestContext() {
   if (processing_) {
     --proxyBase_.numRequestsProcessing_;
     proxyBase_.stats().decrement(proxy_reqs_processing_stat);
+    if (priority_ == ProxyRequestPriority::kAsync) {
+      --proxyBase_.numAsyncRequestsProcessing_;
+      proxyBase_.stats().decrement(proxy_async_reqs_processing_stat);
+    }
     proxyBase_.pump();
   }
 
@@ -48,6 +63,18 @@ ProxyRequestContext::~ProxyRequestContext() {
   proxyBase_.stats().decrementSafe(proxy_request_num_outstanding_stat);
 }
 
+void ProxyRequestContext::addInflightBytes(size_t bytes) {
+  inflightBytes_ += bytes;
+  proxyBase_.inflightBytes_ += bytes;
+  proxyBase_.stats().increment(proxy_inflight_bytes_stat, bytes);
+}
+
+void ProxyRequestContext::finishTrace(folly::StringPiece requestName) {
+  if (auto* tracer = proxyBase_.requestTracer()) {
+    tracer->finishTrace(traceContext_, requestName, traceStartNs_);
+  }
+}
+
 uint64_t ProxyRequestContext::senderId() const {
   uint64_t id = 0;
   if (requester_) {
@@ -7,16 +7,19 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 
 #include <folly/Range.h>
 #include <folly/fibers/FiberManager.h>
 
+#include "mcrouter/ProxyRequestArena.h"
 #include "mcrouter/ProxyRequestPriority.h"
 #include "mcrouter/config-impl.h"
 #include "mcrouter/lib/PoolContext.h"
 #include "mcrouter/lib/carbon/Result.h"
+#include "mcrouter/lib/debug/RequestTracer.h"
 
 namespace facebook {
 namespace memcache {
@@ -30,6 +33,7 @@ class Proxy;
 template <class RouterInfo>
 class ProxyRoute;
 
+class BroadcastFanout;
 class ProxyBase;
 class CarbonRouterClientBase;
 class ShardSplitter;
@@ -55,6 +59,15 @@ class ProxyRequestContext {
 
   virtual ~ProxyRequestContext();
 
+  /**
+   * Contexts created by createProxyRequestContext() live in a single
+   * allocation together with their arena, which is larger than the object
+   * itself, so sized deallocation must not be used.
+   */
+  static void operator delete(void* ptr) noexcept {
+    ::operator delete(ptr);
+  }
+
   ProxyBase& proxy() const {
     return proxyBase_;
   }
@@ -108,6 +121,12 @@ class ProxyRequestContext {
     return priority_;
   }
 
+  /**
+   * Counts `bytes` in the proxy's inflightBytes() for the lifetime of this
+   * context.
+   */
+  void addInflightBytes(size_t bytes);
+
   /**
    * Continues processing current request.
    * Should be called only from the attached proxy thread.
@@ -137,6 +156,10 @@ class ProxyRequestContext {
     requester_ = std::move(requester);
   }
 
+  const std::shared_ptr<CarbonRouterClientBase>& requester() const {
+    return requester_;
+  }
+
   void setFinalResult(carbon::Result result) {
     finalResult_ = result;
   }
@@ -184,6 +207,112 @@ class ProxyRequestContext {
     return routingHint_;
   }
 
+  /**
+   * Set on the part of a broadcast (e.g. flush_all) that another proxy gave
+   * to this one: only the destinations of `slice` are sent the request.
+   */
+  void setBroadcastSlice(
+      std::shared_ptr<BroadcastFanout> fanout,
+      uint32_t slice) {
+    broadcastFanout_ = std::move(fanout);
+    broadcastSlice_ = slice;
+  }
+
+  /**
+   * nullptr unless setBroadcastSlice() was called.
+   */
+  const std::shared_ptr<BroadcastFanout>& broadcastFanout() const {
+    return broadcastFanout_;
+  }
+
+  uint32_t broadcastSlice() const {
+    return broadcastSlice_;
+  }
+
+  /**
+   * Time (as nowUs()) after which the client no longer waits for the reply,
+   * or 0 if it didn't tell. See CarbonRouterClient::setTimeoutBudget().
+   */
+  int64_t deadlineUs() const {
+    return deadlineUs_;
+  }
+
+  void setDeadlineUs(int64_t deadlineUs) {
+    deadlineUs_ = deadlineUs;
+  }
+
+  /**
+   * True once the client that sent this request disconnected, i.e. nobody
+   * will read the reply. See CarbonRouterClient::setClientGone().
+   */
+  bool clientGone() const {
+    return clientGone_ && clientGone_->load(std::memory_order_relaxed);
+  }
+
+  /**
+   * The flag behind clientGone(), or nullptr. Valid as long as this context.
+   */
+  const std::atomic<bool>* clientGoneFlag() const {
+    return clientGone_.get();
+  }
+
+  void setClientGone(std::shared_ptr<const std::atomic<bool>> clientGone) {
+    clientGone_ = std::move(clientGone);
+  }
+
+  /**
+   * Identity of the client that sent this request, 0 if unknown. See
+   * CarbonRouterClient::setClientId().
+   */
+  uint64_t clientId() const {
+    return clientId_;
+  }
+
+  void setClientId(uint64_t clientId) {
+    clientId_ = clientId;
+  }
+
+  /**
+   * Name of the client that sent this request, empty if unknown. See
+   * CarbonRouterClient::setClientName().
+   */
+  folly::StringPiece clientName() const {
+    return clientName_;
+  }
+
+  void setClientName(folly::StringPiece clientName) {
+    clientName_ = clientName;
+  }
+
+  /**
+   * Bytes counted by addInflightBytes().
+   */
+  size_t inflightBytes() const {
+    return inflightBytes_;
+  }
+
+  /**
+   * Arena for allocations that should live as long as this request.
+   * Empty (every allocation goes to the heap) unless the context was created
+   * by createProxyRequestContext() with a non-zero proxy_request_arena_size.
+   */
+  ProxyRequestArena& arena() noexcept {
+    return arena_;
+  }
+
+  /**
+   * Trace of this request, sampled if the proxy's RequestTracer picked it.
+   */
+  const RequestTracer::Context& traceContext() const {
+    return traceContext_;
+  }
+
+  /**
+   * Records the root span of a sampled request, from the creation of this
+   * context until now.
+   */
+  void finishTrace(folly::StringPiece requestName);
+
  protected:
   // Keep on first cacheline. Used by ProxyRequestContextTyped
   const void* ptr_{nullptr};
@@ -196,6 +325,10 @@ class ProxyRequestContext {
       ProxyRequestPriority priority__,
       const void* ptr = nullptr);
 
+  void initArena(void* begin, size_t size) noexcept {
+    arena_.reset(begin, size);
+  }
+
   enum RecordingT { Recording };
   ProxyRequestContext(
       RecordingT,
@@ -226,6 +359,8 @@ class ProxyRequestContext {
 
   ProxyRequestPriority priority_{ProxyRequestPriority::kCritical};
 
+  size_t inflightBytes_{0};
+
   bool failoverDisabled_{false};
   /** If true, this is currently being processed by a proxy and
       we want to notify we're done on destruction. */
@@ -237,6 +372,19 @@ class ProxyRequestContext {
       layer. */
   uint64_t routingHint_{0};
 
+  std::shared_ptr<BroadcastFanout> broadcastFanout_;
+  uint32_t broadcastSlice_{0};
+
+  int64_t deadlineUs_{0};
+  std::shared_ptr<const std::atomic<bool>> clientGone_;
+  uint64_t clientId_{0};
+  folly::StringPiece clientName_;
+
+  ProxyRequestArena arena_;
+
+  RequestTracer::Context traceContext_;
+  uint64_t traceStartNs_{0};
+
   /**
    * Functions to be executed before actual processing code.
    */
@@ -5,9 +5,16 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <optional>
+#include <string>
+
+#include <folly/tracing/StaticTracepoint.h>
+
 #include "mcrouter/Proxy.h"
 #include "mcrouter/lib/McKey.h"
 #include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/fbi/cpp/TypeList.h"
 #include "mcrouter/lib/network/CarbonMessageList.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
@@ -29,9 +36,16 @@ class ProxyRequestContextTypedWithCallback
       Proxy<RouterInfo>& pr,
       const Request& req,
       F&& f,
-      ProxyRequestPriority priority__)
+      ProxyRequestPriority priority__,
+      size_t arenaSize = 0)
       : ProxyRequestContextTyped<RouterInfo, Request>(pr, req, priority__),
-        f_(std::forward<F>(f)) {}
+        f_(std::forward<F>(f)) {
+    if (arenaSize > 0) {
+      // Arena storage directly follows the object in the same allocation.
+      this->initArena(
+          reinterpret_cast<char*>(this) + sizeof(*this), arenaSize);
+    }
+  }
 
  protected:
   void sendReplyImpl(ReplyT<Request>&& reply) final {
@@ -44,6 +58,59 @@ class ProxyRequestContextTypedWithCallback
   F f_;
 };
 
+/**
+ * Allocator for the shared_ptr control block of an arena allocated context.
+ * The control block is the last thing released, so freeing it also frees the
+ * whole allocation holding the (already destroyed) context and its arena.
+ */
+template <class T>
+class ProxyRequestBlockAllocator {
+ public:
+  using value_type = T;
+
+  explicit ProxyRequestBlockAllocator(ProxyRequestContext& block) noexcept
+      : block_(&block),
+        arenaBegin_(block.arena().begin()),
+        arenaEnd_(block.arena().end()) {}
+
+  template <class U>
+  /* implicit */ ProxyRequestBlockAllocator(
+      const ProxyRequestBlockAllocator<U>& other) noexcept
+      : block_(other.block_),
+        arenaBegin_(other.arenaBegin_),
+        arenaEnd_(other.arenaEnd_) {}
+
+  T* allocate(size_t n) {
+    return ProxyRequestArenaAllocator<T>(block_->arena()).allocate(n);
+  }
+
+  void deallocate(T* p, size_t /* n */) noexcept {
+    // The context is already destroyed here, so only use the saved range.
+    auto ptr = reinterpret_cast<const char*>(p);
+    if (ptr < arenaBegin_ || ptr >= arenaEnd_) {
+      ::operator delete(p);
+    }
+    ProxyRequestContext::operator delete(block_);
+  }
+
+  template <class U>
+  bool operator==(const ProxyRequestBlockAllocator<U>& other) const noexcept {
+    return block_ == other.block_;
+  }
+  template <class U>
+  bool operator!=(const ProxyRequestBlockAllocator<U>& other) const noexcept {
+    return !(*this == other);
+  }
+
+ private:
+  template <class U>
+  friend class ProxyRequestBlockAllocator;
+
+  ProxyRequestContext* block_;
+  const char* arenaBegin_;
+  const char* arenaEnd_;
+};
+
 constexpr const char* kCommandNotSupportedStr = "Command not supported";
 
 template <class RouterInfo, class Request>
@@ -135,9 +202,32 @@ void ProxyRequestContextTyped<RouterInfo, Request>::sendReply(
   }
   this->replied_ = true;
   auto result = *reply.result_ref();
+  FOLLY_SDT(
+      mcrouter,
+      route_end,
+      this,
+      Request::typeId,
+      static_cast<int>(result));
+
+  // The request may be gone once the reply is sent, but the route path of a
+  // slow request is only computed after, not to delay the reply further.
+  std::optional<Request> slowRequest;
+  const auto slowRequestDurationUs = this->slowRequestDurationUs();
+  if (FOLLY_UNLIKELY(slowRequestDurationUs > 0)) {
+    slowRequest.emplace(*typedRequest());
+  }
+  // Before sendReplyImpl(), the client name may be gone once the reply is
+  // delivered.
+  this->recordClientTraffic(reply);
 
   sendReplyImpl(std::move(reply));
   clearTypedRequest();
+  if (FOLLY_UNLIKELY(this->traceContext().sampled())) {
+    this->finishTrace(Request::name);
+  }
+  if (FOLLY_UNLIKELY(slowRequest.has_value())) {
+    recordSlowRequest(*slowRequest, result, slowRequestDurationUs);
+  }
 
   auto& stats = this->proxy().stats();
   stats.increment(request_replied_stat);
@@ -151,9 +241,38 @@ void ProxyRequestContextTyped<RouterInfo, Request>::sendReply(
   }
 }
 
+template <class RouterInfo, class Request>
+void ProxyRequestContextTyped<RouterInfo, Request>::recordSlowRequest(
+    const Request& request,
+    carbon::Result result,
+    int64_t durationUs) {
+  SlowRequestLog::Entry entry;
+  entry.request = Request::name;
+  entry.key = carbon::getFullKey(request).str();
+  entry.durationUs = durationUs;
+  entry.result = result;
+  if constexpr (ListContains<typename RouterInfo::RoutableRequests, Request>::
+                    value) {
+    // Not set if the request was replied to before being routed.
+    if (config_) {
+      size_t level = 0;
+      RouteHandleTraverser<typename RouterInfo::RouteHandleIf> t(
+          [&entry, &level](const typename RouterInfo::RouteHandleIf& rh) {
+            entry.routePath.push_back(
+                std::string(level, ' ') + rh.routeName());
+            ++level;
+          },
+          [&level]() { --level; });
+      config_->proxyRoute().traverse(request, t);
+    }
+  }
+  this->addSlowRequest(std::move(entry));
+}
+
 template <class RouterInfo, class Request>
 void ProxyRequestContextTyped<RouterInfo, Request>::startProcessing() {
   std::unique_ptr<ProxyRequestContextTyped<RouterInfo, Request>> self(this);
+  FOLLY_SDT(mcrouter, route_start, this, Request::typeId);
 
   if (!detail::precheckRequest(*this, *typedRequest())) {
     return;
@@ -177,6 +296,18 @@ ProxyRequestContextTyped<RouterInfo, Request>::process(
     std::unique_ptr<Type> preq,
     std::shared_ptr<const ProxyConfig<RouterInfo>> config) {
   preq->config_ = std::move(config);
+  if (preq->arena().capacity() > 0) {
+    // Put the control block into the context's arena, and release the whole
+    // allocation once the control block goes away.
+    auto& block = *preq;
+    return std::shared_ptr<Type>(
+        preq.release(),
+        [](ProxyRequestContext* ctx) {
+          folly::fibers::runInMainContext(
+              [ctx] { ctx->~ProxyRequestContext(); });
+        },
+        detail::ProxyRequestBlockAllocator<Type>(block));
+  }
   return std::shared_ptr<Type>(
       preq.release(),
       /* Note: we want to delete on main context here since the destructor
@@ -197,7 +328,22 @@ createProxyRequestContext(
     ProxyRequestPriority priority) {
   using Type =
       detail::ProxyRequestContextTypedWithCallback<RouterInfo, Request, F>;
-  return std::make_unique<Type>(pr, req, std::forward<F>(f), priority);
+  static_assert(
+      alignof(Type) <= alignof(std::max_align_t),
+      "Over-aligned request contexts are not supported");
+  const size_t arenaSize = pr.getRouterOptions().proxy_request_arena_size;
+  if (arenaSize == 0) {
+    return std::make_unique<Type>(pr, req, std::forward<F>(f), priority);
+  }
+  // Allocate the context and its arena in one go.
+  void* mem = ::operator new(sizeof(Type) + arenaSize);
+  try {
+    return std::unique_ptr<Type>(
+        new (mem) Type(pr, req, std::forward<F>(f), priority, arenaSize));
+  } catch (...) {
+    ::operator delete(mem);
+    throw;
+  }
 }
 
 } // namespace mcrouter
@@ -8,12 +8,18 @@
 #pragma once
 
 #include <folly/Utility.h>
+#include <chrono>
 #include <string_view>
+#include <vector>
 
 #include "mcrouter/ProxyRequestContext.h"
 #include "mcrouter/ProxyRequestLogger.h"
+#include "mcrouter/SlowRequestLog.h"
+#include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/RequestLoggerContext.h"
 #include "mcrouter/lib/carbon/NoopAdditionalLogger.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/network/MessageHelpers.h"
 
 namespace facebook {
 namespace memcache {
@@ -181,9 +187,27 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
       return;
     }
 
+    if (FOLLY_UNLIKELY(proxy_.slowRequestLog() != nullptr)) {
+      slowRequestHops_.push_back(SlowRequestLog::Hop{
+          ap.toHostPortString(),
+          poolName.str(),
+          startTimeUs - startDurationUs_,
+          endTimeUs - startTimeUs,
+          *reply.result_ref()});
+    }
+
     if (auto poolStats = proxy_.stats().getPoolStats(poolStatIndex)) {
       poolStats->incrementRequestCount(1);
       poolStats->addDurationSample(endTimeUs - startTimeUs);
+      if constexpr (HasKeyTrait<Request>::value) {
+        poolStats->addRequestSizeSample(
+            request.key_ref()->fullKey().size(),
+            carbon::valuePtrUnsafe(request));
+      }
+      if (auto* value = carbon::valuePtrUnsafe(reply);
+          value != nullptr && isHitResult(*reply.result_ref())) {
+        poolStats->addReplyValueSizeSample(value->computeChainDataLength());
+      }
     }
     RequestLoggerContext loggerContext(
         poolName,
@@ -241,6 +265,57 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
 
   Proxy<RouterInfo>& proxy_;
 
+  /**
+   * @return  How long this request has been processed for, if that's long
+   *          enough for it to be kept in the proxy's SlowRequestLog.
+   *          0 otherwise.
+   */
+  int64_t slowRequestDurationUs() const {
+    auto* log = proxy_.slowRequestLog();
+    if (FOLLY_LIKELY(log == nullptr)) {
+      return 0;
+    }
+    auto durationUs = nowUs() - startDurationUs_;
+    return durationUs >= log->thresholdUs() ? durationUs : 0;
+  }
+
+  /**
+   * Accounts this request and `reply` to the client that sent it, if the
+   * proxy samples it for per-client accounting.
+   */
+  template <class Reply>
+  void recordClientTraffic(const Reply& reply) {
+    if (this->clientName().empty()) {
+      return;
+    }
+    auto* clientTraffic = proxy_.sampleClientTraffic();
+    if (FOLLY_LIKELY(clientTraffic == nullptr)) {
+      return;
+    }
+    size_t replyBytes = 0;
+    if (auto* value = carbon::valuePtrUnsafe(reply)) {
+      replyBytes = value->computeChainDataLength();
+    }
+    clientTraffic->record(
+        this->clientName(),
+        this->inflightBytes(),
+        replyBytes,
+        nowUs() - startDurationUs_);
+  }
+
+  /**
+   * Adds `entry` to the proxy's SlowRequestLog, along with the destinations
+   * this request was sent to.
+   */
+  void addSlowRequest(SlowRequestLog::Entry entry) {
+    entry.startUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count() -
+        (nowUs() - startDurationUs_);
+    entry.hops = std::move(slowRequestHops_);
+    proxy_.slowRequestLog()->add(std::move(entry));
+  }
+
  private:
   ProxyRequestContextWithInfo(
       RecordingT,
@@ -257,6 +332,8 @@ class ProxyRequestContextWithInfo : public ProxyRequestContext {
         proxy_(pr) {}
 
   int64_t startDurationUs_{nowUs()};
+  // Only filled if the proxy has a SlowRequestLog.
+  std::vector<SlowRequestLog::Hop> slowRequestHops_;
   folly::Optional<ProxyRequestLogger<RouterInfo>> logger_;
   folly::Optional<AdditionalLogger> additionalLogger_;
 };
@@ -333,6 +410,11 @@ class ProxyRequestContextTyped
     this->ptr_ = nullptr;
   }
 
+  void recordSlowRequest(
+      const Request& request,
+      carbon::Result result,
+      int64_t durationUs);
+
   virtual void sendReplyImpl(ReplyT<Request>&& reply) = 0;
 
  private:
@@ -29,35 +29,14 @@ void ProxyRequestLogger<RouterInfo>::log(
   proxy_.requestStats().template bump<Request>(
       carbon::RouterStatTypes::AllOutgoing);
 
-  logError(loggerContext.replyResult, loggerContext.requestClass);
-
-  const auto durationUs = loggerContext.endTimeUs - loggerContext.startTimeUs;
-  proxy_.stats().durationUs().insertSample(durationUs);
-  logDurationByRequestType<Request>(durationUs);
-}
-
-template <class RouterInfo>
-template <class Request>
-void ProxyRequestLogger<RouterInfo>::logDurationByRequestType(
-    uint64_t durationUs,
-    carbon::GetLikeT<Request>) {
-  proxy_.stats().durationGetUs().insertSample(durationUs);
-}
-
-template <class RouterInfo>
-template <class Request>
-void ProxyRequestLogger<RouterInfo>::logDurationByRequestType(
-    uint64_t durationUs,
-    carbon::UpdateLikeT<Request>) {
-  proxy_.stats().durationUpdateUs().insertSample(durationUs);
+  // Error and duration stats are added once per event loop iteration.
+  proxy_.requestStatsBatch().add(
+      loggerContext.replyResult,
+      loggerContext.requestClass.isNormal(),
+      loggerContext.endTimeUs - loggerContext.startTimeUs,
+      durationKind<Request>());
 }
 
-template <class RouterInfo>
-template <class Request>
-void ProxyRequestLogger<RouterInfo>::logDurationByRequestType(
-    uint64_t /* durationUs */,
-    carbon::OtherThanT<Request, carbon::GetLike<>, carbon::UpdateLike<>>) {}
-
 #define REQUEST_CLASS_ERROR_STATS(proxy, ERROR, reqClass)     \
   do {                                                        \
     if (reqClass.isNormal()) {                                \
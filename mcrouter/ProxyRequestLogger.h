@@ -8,6 +8,7 @@
 #pragma once
 
 #include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyRequestStatsBatch.h"
 #include "mcrouter/lib/carbon/Result.h"
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 
@@ -33,18 +34,22 @@ class ProxyRequestLogger {
   void logError(carbon::Result result, RequestClass reqClass);
 
  private:
+  using DurationKind = ProxyRequestStatsBatch::DurationKind;
+
   template <class Request>
-  void logDurationByRequestType(
-      uint64_t durationUs,
-      carbon::GetLikeT<Request> = 0);
+  static DurationKind durationKind(carbon::GetLikeT<Request> = 0) {
+    return DurationKind::Get;
+  }
   template <class Request>
-  void logDurationByRequestType(
-      uint64_t durationUs,
-      carbon::UpdateLikeT<Request> = 0);
+  static DurationKind durationKind(carbon::UpdateLikeT<Request> = 0) {
+    return DurationKind::Update;
+  }
   template <class Request>
-  void logDurationByRequestType(
-      uint64_t durationUs,
-      carbon::OtherThanT<Request, carbon::GetLike<>, carbon::UpdateLike<>> = 0);
+  static DurationKind durationKind(
+      carbon::OtherThanT<Request, carbon::GetLike<>, carbon::UpdateLike<>> =
+          0) {
+    return DurationKind::Other;
+  }
 };
 } // namespace mcrouter
 } // namespace memcache
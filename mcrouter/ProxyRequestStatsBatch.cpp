@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ProxyRequestStatsBatch.h"
+
+#include "mcrouter/ProxyStats.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/stats.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+ProxyRequestStatsBatch::~ProxyRequestStatsBatch() {
+  cancelLoopCallback();
+  flush();
+}
+
+void ProxyRequestStatsBatch::flush() {
+  if (numDurations_ == 0) {
+    return;
+  }
+  flushResults();
+  flushDurations();
+}
+
+#define REQUEST_CLASS_ERROR_STATS_BATCH(stats, ERROR, normal, all)   \
+  do {                                                               \
+    if (normal > 0) {                                                \
+      stats.increment(result_##ERROR##_stat, normal);                \
+      stats.increment(result_##ERROR##_count_stat, normal);          \
+    }                                                                \
+    stats.increment(result_##ERROR##_all_stat, all);                 \
+    stats.increment(result_##ERROR##_all_count_stat, all);           \
+  } while (0)
+
+void ProxyRequestStatsBatch::flushResults() {
+  for (size_t i = 0; i < allResults_.size(); ++i) {
+    const uint32_t all = allResults_[i];
+    if (all == 0) {
+      continue;
+    }
+    const uint32_t normal = normalResults_[i];
+    allResults_[i] = 0;
+    normalResults_[i] = 0;
+
+    const auto result = static_cast<carbon::Result>(i);
+    if (isErrorResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, error, normal, all);
+    }
+    if (isConnectErrorResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, connect_error, normal, all);
+    }
+    if (isConnectTimeoutResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, connect_timeout, normal, all);
+    }
+    if (isDataTimeoutResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, data_timeout, normal, all);
+    }
+    if (isRedirectResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, busy, normal, all);
+    }
+    if (isTkoResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, tko, normal, all);
+    }
+    if (isRemoteErrorResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, remote_error, normal, all);
+    }
+    if (isLocalErrorResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, local_error, normal, all);
+    }
+    if (isClientErrorResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(stats_, client_error, normal, all);
+    }
+    if (isDeadlineExceededResult(result)) {
+      REQUEST_CLASS_ERROR_STATS_BATCH(
+          stats_, deadline_exceeded_error, normal, all);
+    }
+  }
+}
+
+#undef REQUEST_CLASS_ERROR_STATS_BATCH
+
+void ProxyRequestStatsBatch::flushDurations() {
+  std::array<double, kMaxDurations> all;
+  std::array<double, kMaxDurations> gets;
+  std::array<double, kMaxDurations> updates;
+  size_t numGets = 0;
+  size_t numUpdates = 0;
+  for (size_t i = 0; i < numDurations_; ++i) {
+    const auto& duration = durations_[i];
+    all[i] = duration.us;
+    stats_.durationUsHistogram().record(duration.us);
+    if (duration.kind == DurationKind::Get) {
+      gets[numGets++] = duration.us;
+      stats_.durationGetUsHistogram().record(duration.us);
+    } else if (duration.kind == DurationKind::Update) {
+      updates[numUpdates++] = duration.us;
+      stats_.durationUpdateUsHistogram().record(duration.us);
+    }
+  }
+  stats_.durationUs().insertSamples(all.begin(), all.begin() + numDurations_);
+  stats_.durationGetUs().insertSamples(gets.begin(), gets.begin() + numGets);
+  stats_.durationUpdateUs().insertSamples(
+      updates.begin(), updates.begin() + numUpdates);
+  numDurations_ = 0;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
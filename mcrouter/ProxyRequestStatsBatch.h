@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyStats;
+
+/**
+ * Stats of the replies a proxy got from destinations (see
+ * ProxyRequestLogger), accumulated during an event loop iteration and
+ * added to ProxyStats once at its end rather than on every reply.
+ *
+ * Replies are counted per result, so a result is classified into the error
+ * stats once per iteration instead of once per reply, and durations are
+ * buffered to be folded into the smoothed averages in one pass.
+ *
+ * Only used from the proxy thread.
+ */
+class ProxyRequestStatsBatch : public folly::EventBase::LoopCallback {
+ public:
+  enum class DurationKind : uint8_t { Other, Get, Update };
+
+  // Durations buffered at most, the batch is flushed early once full.
+  static constexpr size_t kMaxDurations = 64;
+
+  ProxyRequestStatsBatch(ProxyStats& stats, folly::EventBase& eventBase)
+      : stats_(stats), eventBase_(eventBase) {}
+
+  ~ProxyRequestStatsBatch() override;
+
+  /**
+   * Adds a reply, isNormal being whether it's for a request of the normal
+   * class (i.e. not shadow or failover).
+   */
+  void add(
+      carbon::Result result,
+      bool isNormal,
+      uint64_t durationUs,
+      DurationKind kind) {
+    if (!isLoopCallbackScheduled()) {
+      eventBase_.runInLoop(this);
+    }
+    const auto idx = static_cast<size_t>(result);
+    if (idx < allResults_.size()) {
+      ++allResults_[idx];
+      normalResults_[idx] += isNormal ? 1 : 0;
+    }
+    durations_[numDurations_++] = {durationUs, kind};
+    if (numDurations_ == kMaxDurations) {
+      flush();
+    }
+  }
+
+  /**
+   * Adds everything accumulated so far to ProxyStats.
+   */
+  void flush();
+
+  void runLoopCallback() noexcept override final {
+    flush();
+  }
+
+ private:
+  using ResultCounts = std::array<
+      uint32_t,
+      static_cast<size_t>(carbon::Result::NUM_RESULTS)>;
+
+  struct Duration {
+    uint64_t us;
+    DurationKind kind;
+  };
+
+  ProxyStats& stats_;
+  folly::EventBase& eventBase_;
+
+  ResultCounts allResults_{};
+  ResultCounts normalResults_{};
+  std::array<Duration, kMaxDurations> durations_;
+  size_t numDurations_{0};
+
+  void flushResults();
+  void flushDurations();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
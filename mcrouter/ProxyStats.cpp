@@ -40,6 +40,20 @@ void ProxyStats::aggregate(size_t statId) {
       ref.store(0, std::memory_order_relaxed);
     }
   }
+
+  durationUsHistogram_.advance();
+  durationGetUsHistogram_.advance();
+  durationUpdateUsHistogram_.advance();
+  loopTimeUsHistogram_->advance();
+  queueDelayUsHistogram_.advance();
+  fiberRunUsHistogram_.advance();
+  LatencyHistogram::Counts queueDelays{};
+  queueDelayUsHistogram_.addWindowTo(queueDelays);
+  queueDelayUsP99_.store(
+      LatencyHistogram::percentile(queueDelays, 99), std::memory_order_relaxed);
+  for (auto& poolStats : poolStats_) {
+    poolStats.advance();
+  }
 }
 
 std::unique_lock<std::mutex> ProxyStats::lock() const {
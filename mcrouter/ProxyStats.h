@@ -7,11 +7,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 
 #include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/lang/Align.h>
 
 #include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/PoolStats.h"
 #include "mcrouter/stats.h"
 
@@ -48,6 +52,60 @@ class ProxyStats {
     return durationUpdateUs_;
   }
 
+  /**
+   * Same samples as durationUs(), durationGetUs() and durationUpdateUs(),
+   * for percentiles.
+   */
+  LatencyHistogram& durationUsHistogram() {
+    return durationUsHistogram_;
+  }
+
+  LatencyHistogram& durationGetUsHistogram() {
+    return durationGetUsHistogram_;
+  }
+
+  LatencyHistogram& durationUpdateUsHistogram() {
+    return durationUpdateUsHistogram_;
+  }
+
+  /**
+   * How the proxy thread schedules work: busy time of event loop iterations,
+   * delay between a request being queued and its fiber starting, and for how
+   * long fibers run before yielding.
+   * Only recorded if proxy_scheduling_histograms is set (queue delay also if
+   * shadow_shed_queue_delay_us is).
+   */
+  LatencyHistogram& loopTimeUsHistogram() {
+    return *loopTimeUsHistogram_;
+  }
+
+  /**
+   * For observers that may outlive this object.
+   */
+  const std::shared_ptr<LatencyHistogram>& loopTimeUsHistogramPtr() const {
+    return loopTimeUsHistogram_;
+  }
+
+  LatencyHistogram& queueDelayUsHistogram() {
+    return queueDelayUsHistogram_;
+  }
+
+  LatencyHistogram& fiberRunUsHistogram() {
+    return fiberRunUsHistogram_;
+  }
+
+  /**
+   * 99th percentile of queueDelayUsHistogram() as of the last aggregate().
+   * May be called from any thread.
+   */
+  uint64_t queueDelayUsP99() const {
+    return queueDelayUsP99_.load(std::memory_order_relaxed);
+  }
+
+  size_t numPoolStats() const {
+    return poolStats_.size();
+  }
+
   /**
    * Tells the interval (in seconds) between closing a connection due to lack
    * of activity and opening it again.
@@ -187,7 +245,11 @@ class ProxyStats {
 
  private:
   mutable std::mutex mutex_;
-  stat_t stats_[num_stats]{};
+  // Written by the proxy thread on every request: keep the counters off the
+  // cache line of the mutex (and of whatever precedes this object), which
+  // the stats threads take.
+  alignas(folly::hardware_destructive_interference_size) stat_t
+      stats_[num_stats]{};
   // vector of the PoolStats
   std::vector<PoolStats> poolStats_;
 
@@ -197,6 +259,18 @@ class ProxyStats {
   // Duration microseconds, broken down by update-like request type
   ExponentialSmoothData<64> durationUpdateUs_;
 
+  LatencyHistogram durationUsHistogram_;
+  LatencyHistogram durationGetUsHistogram_;
+  LatencyHistogram durationUpdateUsHistogram_;
+
+  // Shared with the EventBase's observer, which the EventBase may keep after
+  // the proxy is gone.
+  std::shared_ptr<LatencyHistogram> loopTimeUsHistogram_{
+      std::make_shared<LatencyHistogram>()};
+  LatencyHistogram queueDelayUsHistogram_;
+  LatencyHistogram fiberRunUsHistogram_;
+  std::atomic<uint64_t> queueDelayUsP99_{0};
+
   ExponentialSmoothData<64> inactiveConnectionClosedIntervalSec_;
 
   // Time spent for asynclog spooling
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "QueueDelayMonitor.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+void QueueDelayMonitor::onDequeue(int64_t delayUs, int64_t nowUs) {
+  lastDequeueUs_ = nowUs;
+  if (delayUs < targetUs_) {
+    aboveTargetUntilUs_ = 0;
+    overloaded_ = false;
+    return;
+  }
+  if (aboveTargetUntilUs_ == 0) {
+    aboveTargetUntilUs_ = nowUs + intervalUs_;
+  } else if (nowUs >= aboveTargetUntilUs_) {
+    overloaded_ = true;
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
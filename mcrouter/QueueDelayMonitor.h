@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Tells whether a proxy has a standing request queue, CoDel style: the proxy
+ * is overloaded once every request waited longer than `targetUs` to start
+ * being routed for a whole `intervalUs`. A single request that waited less
+ * than the target ends the overload, so short bursts are never penalized.
+ *
+ * If no request got dequeued for `intervalUs` the queue is considered
+ * drained.
+ *
+ * Not thread-safe: belongs to a single proxy.
+ */
+class QueueDelayMonitor {
+ public:
+  QueueDelayMonitor(int64_t targetUs, int64_t intervalUs)
+      : targetUs_(targetUs), intervalUs_(intervalUs) {}
+
+  /**
+   * Records that a request started being routed at `nowUs`, after waiting
+   * for `delayUs`.
+   */
+  void onDequeue(int64_t delayUs, int64_t nowUs);
+
+  bool overloaded(int64_t nowUs) const {
+    return overloaded_ && nowUs - lastDequeueUs_ < intervalUs_;
+  }
+
+ private:
+  const int64_t targetUs_;
+  const int64_t intervalUs_;
+  // End of the interval the delay has to stay above target for to become
+  // overloaded; 0 if the last delay was under target.
+  int64_t aboveTargetUntilUs_{0};
+  int64_t lastDequeueUs_{0};
+  bool overloaded_{false};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RequestTraceExporter.h"
+
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/McrouterLogFailure.h"
+#include "mcrouter/OptionsUtil.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/debug/Fifo.h"
+#include "mcrouter/lib/debug/FifoManager.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+std::string exportFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-trace-export-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+} // anonymous namespace
+
+RequestTraceExporter::RequestTraceExporter(CarbonRouterInstanceBase& router)
+    : router_(router),
+      functionHandle_(exportFunctionName(router_.opts().router_name)),
+      serviceName_(getStatPrefix(router_.opts())) {}
+
+RequestTraceExporter::~RequestTraceExporter() {
+  stop();
+}
+
+bool RequestTraceExporter::start() {
+  const auto& opts = router_.opts();
+  if (opts.trace_sample_period == 0 || opts.debug_fifo_root.empty()) {
+    return false;
+  }
+
+  auto scheduler = router_.functionScheduler();
+  if (!scheduler) {
+    MC_LOG_FAILURE(
+        opts,
+        memcache::failure::Category::kSystemError,
+        "Scheduler not available, disabling request trace export");
+    return false;
+  }
+  scheduler->addFunction(
+      [this]() { exportSpans(); },
+      std::chrono::milliseconds(std::max<uint32_t>(
+          opts.trace_export_interval_ms, 1)),
+      functionHandle_);
+  return true;
+}
+
+void RequestTraceExporter::stop() noexcept {
+  if (auto scheduler = router_.functionScheduler()) {
+    scheduler->cancelFunctionAndWait(functionHandle_);
+  }
+}
+
+void RequestTraceExporter::exportSpans() {
+  spans_.clear();
+  for (size_t i = 0; i < router_.opts().num_proxies; ++i) {
+    if (auto* tracer = router_.getProxyBase(i)->requestTracer()) {
+      tracer->drain(spans_);
+    }
+  }
+  if (spans_.empty()) {
+    return;
+  }
+
+  if (!fifo_) {
+    if (auto fifoManager = FifoManager::getInstance()) {
+      fifo_ = fifoManager->fetchThreadLocal(
+          getRequestTracesDebugFifoFullPath(router_.opts()));
+    }
+  }
+  // Spans are drained even without a reader, so that the tracers' buffers
+  // don't fill up.
+  if (!fifo_ || !fifo_->isConnected()) {
+    return;
+  }
+
+  std::vector<RequestTracer::Span> chunk;
+  for (size_t begin = 0; begin < spans_.size(); begin += kMaxSpansPerLine) {
+    const size_t end = std::min(begin + kMaxSpansPerLine, spans_.size());
+    chunk.assign(
+        std::make_move_iterator(spans_.begin() + begin),
+        std::make_move_iterator(spans_.begin() + end));
+    line_.clear();
+    RequestTracer::appendOtlpJson(chunk, serviceName_, line_);
+    iovec iov{const_cast<char*>(line_.data()), line_.size()};
+    if (!fifo_->write(&iov, 1)) {
+      return;
+    }
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
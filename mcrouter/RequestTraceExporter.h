@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mcrouter/lib/debug/RequestTracer.h"
+
+namespace facebook {
+namespace memcache {
+
+class Fifo;
+
+namespace mcrouter {
+
+class CarbonRouterInstanceBase;
+
+/**
+ * Periodically collects the spans recorded by the RequestTracer of every
+ * proxy, and writes them as OTLP/JSON lines to the "request_traces" debug
+ * fifo, for a collector to pick up.
+ */
+class RequestTraceExporter {
+ public:
+  explicit RequestTraceExporter(CarbonRouterInstanceBase& router);
+
+  ~RequestTraceExporter();
+
+  /**
+   * Schedules the export every opts.trace_export_interval_ms.
+   *
+   * @return  false if tracing is disabled or the function scheduler is not
+   *          available.
+   */
+  bool start();
+
+  /**
+   * Cancels the export and waits for a running one to complete.
+   */
+  void stop() noexcept;
+
+ private:
+  // Spans per line, so that no single write to the fifo is too large.
+  static constexpr size_t kMaxSpansPerLine = 64;
+
+  CarbonRouterInstanceBase& router_;
+  // Name of the periodic function registered with the function scheduler.
+  const std::string functionHandle_;
+  const std::string serviceName_;
+
+  std::shared_ptr<Fifo> fifo_;
+  std::vector<RequestTracer::Span> spans_;
+  std::string line_;
+
+  void exportSpans();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SchedulingObservers.h"
+
+#include "mcrouter/LatencyHistogram.h"
+#include "mcrouter/config.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+void LoopTimeObserver::loopSample(
+    int64_t busyTime,
+    int64_t /* idleTime */) {
+  // Negative when the clock went backwards.
+  if (busyTime >= 0) {
+    loopTimeUs_->record(busyTime);
+  }
+}
+
+void FiberRunTimeObserver::starting(
+    uintptr_t /* id */,
+    CallbackType callbackType) noexcept {
+  if (callbackType == CallbackType::Fiber) {
+    startedAtUs_ = nowUs();
+  }
+}
+
+void FiberRunTimeObserver::stopped(
+    uintptr_t /* id */,
+    CallbackType callbackType) noexcept {
+  if (callbackType == CallbackType::Fiber && startedAtUs_ != 0) {
+    auto runTimeUs = nowUs() - startedAtUs_;
+    runTimeUs_.record(runTimeUs > 0 ? runTimeUs : 0);
+    startedAtUs_ = 0;
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
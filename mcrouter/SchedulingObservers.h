@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <folly/ExecutionObserver.h>
+#include <folly/io/async/EventBase.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class LatencyHistogram;
+
+/**
+ * Records the busy time of every iteration of an EventBase loop.
+ *
+ * Only sees anything if the EventBase measures its loop times (i.e. wasn't
+ * created with time measurement skipped).
+ */
+class LoopTimeObserver : public folly::EventBaseObserver {
+ public:
+  explicit LoopTimeObserver(std::shared_ptr<LatencyHistogram> loopTimeUs)
+      : loopTimeUs_(std::move(loopTimeUs)) {}
+
+  uint32_t getSampleRate() const override {
+    return 1;
+  }
+
+  void loopSample(int64_t busyTime, int64_t idleTime) override;
+
+ private:
+  const std::shared_ptr<LatencyHistogram> loopTimeUs_;
+};
+
+/**
+ * Records for how long fibers run each time they are switched to, i.e. how
+ * long other ready fibers of the same thread had to wait because of them.
+ *
+ * Attach to fiber managers with FiberManager::addObserver().
+ */
+class FiberRunTimeObserver : public folly::ExecutionObserver {
+ public:
+  explicit FiberRunTimeObserver(LatencyHistogram& runTimeUs)
+      : runTimeUs_(runTimeUs) {}
+
+  void starting(uintptr_t id, CallbackType callbackType) noexcept override;
+  void stopped(uintptr_t id, CallbackType callbackType) noexcept override;
+
+ private:
+  LatencyHistogram& runTimeUs_;
+  int64_t startedAtUs_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -7,6 +7,7 @@
 
 #include <signal.h>
 
+#include <algorithm>
 #include <cstdio>
 
 #include <folly/io/async/AsyncSignalHandler.h>
@@ -22,6 +23,7 @@
 #include "mcrouter/Proxy.h"
 #include "mcrouter/ServerOnRequest.h"
 #include "mcrouter/StandaloneConfig.h"
+#include "mcrouter/ThreadUtil.h"
 #include "mcrouter/ThriftAcceptor.h"
 #include "mcrouter/ThriftObserver.h"
 #include "mcrouter/config.h"
@@ -29,6 +31,7 @@
 #include "mcrouter/lib/network/AsyncMcServerWorker.h"
 #include "mcrouter/lib/network/McSSLUtil.h"
 #include "mcrouter/lib/network/Qos.h"
+#include "mcrouter/lib/network/SocketTakeover.h"
 #include "mcrouter/standalone_options.h"
 
 namespace facebook {
@@ -109,8 +112,15 @@ void serverInit(
       standaloneOpts.prefix_acl_checker_enable));
 
   worker.setOnConnectionAccepted(
-      [proxy, &aclChecker](McServerSession& session) mutable {
+      [proxy, &aclChecker, asyncPorts = standaloneOpts.async_priority_ports](
+          McServerSession& session) mutable {
         proxy->stats().increment(num_client_connections_stat);
+        if (!asyncPorts.empty()) {
+          const auto port = session.getLocalAddress().getPort();
+          session.setLowPriority(
+              std::find(asyncPorts.begin(), asyncPorts.end(), port) !=
+              asyncPorts.end());
+        }
         try {
           aclChecker(session);
         } catch (const std::exception& ex) {
@@ -130,6 +140,20 @@ void serverInit(
         }
       });
 
+  // The check reads proxy state, so it has to run on the proxy thread.
+  if (!standaloneOpts.remote_thread &&
+      (router.opts().proxy_queue_delay_target_us > 0 ||
+       router.opts().proxy_overload_fibers_percent > 0 ||
+       router.opts().proxy_max_inflight_bytes > 0)) {
+    worker.setOverloadCheck([proxy]() {
+      if (!proxy->overloaded()) {
+        return false;
+      }
+      proxy->stats().increment(client_reads_paused_overload_stat);
+      return true;
+    });
+  }
+
   // Setup compression on each worker.
   if (standaloneOpts.enable_server_compression) {
     auto codecManager = router.getCodecManager();
@@ -182,15 +206,29 @@ inline AsyncMcServer::Options createAsyncMcServerOptions(
     opts.pemKeyPath = standaloneOpts.server_pem_key_path;
     opts.pemCaPath = standaloneOpts.server_pem_ca_path;
     opts.sslRequirePeerCerts = standaloneOpts.ssl_require_peer_certs;
+    opts.tfoEnabled = mcrouterOpts.enable_tfo;
     opts.tfoEnabledForSsl = mcrouterOpts.enable_ssl_tfo;
     opts.tfoQueueSize = standaloneOpts.tfo_queue_size;
     opts.worker.useKtls12 = standaloneOpts.ssl_use_ktls12;
+    opts.worker.useKtls13 = standaloneOpts.ssl_use_ktls13;
   }
+  opts.localSockPath = standaloneOpts.local_sock;
 
   opts.numThreads = mcrouterOpts.num_proxies;
   opts.numListeningSockets = standaloneOpts.num_listening_sockets;
+  if (standaloneOpts.per_thread_listening_sockets) {
+    opts.numListeningSockets = opts.numThreads;
+    opts.perThreadListeningSockets = true;
+    // Steering pins the proxy threads to CPUs that may span NUMA nodes,
+    // proxy_numa_placement pins them to whole nodes instead.
+    opts.steerConnectionsByCpu = standaloneOpts.reuseport_cpu_steering &&
+        !mcrouterOpts.proxy_numa_placement;
+  }
   opts.worker.tcpZeroCopyThresholdBytes =
       standaloneOpts.tcp_zero_copy_threshold;
+  opts.worker.useIoUring = standaloneOpts.server_io_uring_transport;
+  opts.worker.busyPoll =
+      std::chrono::microseconds(standaloneOpts.server_busy_poll_us);
 
   size_t maxConns =
       opts.setMaxConnections(standaloneOpts.max_conns, opts.numThreads);
@@ -216,15 +254,42 @@ inline AsyncMcServer::Options createAsyncMcServerOptions(
   opts.tcpListenBacklog = standaloneOpts.tcp_listen_backlog;
   opts.worker.defaultVersionHandler = false;
   opts.worker.maxInFlight = standaloneOpts.max_client_outstanding_reqs;
+  opts.worker.asciiMultigetStreaming =
+      standaloneOpts.ascii_multiget_streaming;
+  opts.worker.releaseIdleReadBuffers =
+      standaloneOpts.release_idle_read_buffers;
+  opts.worker.largeMessageReadThreshold =
+      standaloneOpts.large_request_read_threshold;
+  opts.worker.overloadPauseInterval =
+      std::chrono::milliseconds{standaloneOpts.client_overload_pause_ms};
   opts.worker.sendTimeout =
       std::chrono::milliseconds{standaloneOpts.client_timeout_ms};
   if (!mcrouterOpts.debug_fifo_root.empty()) {
     opts.worker.debugFifoPath = getServerDebugFifoFullPath(mcrouterOpts);
   }
+  // Loop times are only measured on request; proxies run on these
+  // EventBases and need them for loop time stats and shedding.
+  if (mcrouterOpts.proxy_scheduling_histograms ||
+      mcrouterOpts.shadow_shed_loop_time_us > 0) {
+    opts.worker.enableEventBaseTimeMeasurement = true;
+  }
+
+  opts.worker.goAwayTimeout =
+      std::chrono::milliseconds(standaloneOpts.go_away_timeout_ms);
+  opts.connectionRebalancerOpts.interval =
+      std::chrono::milliseconds(standaloneOpts.connection_rebalance_interval_ms);
+  opts.connectionRebalancerOpts.minImbalance =
+      standaloneOpts.connection_rebalance_min_imbalance_pct / 100.0;
+  opts.connectionRebalancerOpts.maxConnsPerInterval =
+      standaloneOpts.connection_rebalance_max_conns;
 
   if (standaloneOpts.server_load_interval_ms > 0) {
     opts.cpuControllerOpts.dataCollectionInterval =
         std::chrono::milliseconds(standaloneOpts.server_load_interval_ms);
+    opts.cpuControllerOpts.useThreadCpu =
+        standaloneOpts.server_load_from_thread_cpu;
+    opts.cpuControllerOpts.loopLagForFullLoad =
+        std::chrono::microseconds(standaloneOpts.server_load_full_loop_lag_us);
   }
 
   /* Default to one read per event to help latency-sensitive workloads.
@@ -237,6 +302,43 @@ inline AsyncMcServer::Options createAsyncMcServerOptions(
   return opts;
 }
 
+/**
+ * Makes `opts` use the listening sockets of the previous mcrouter running
+ * with the same takeover_socket_path, if any, instead of binding the ports.
+ */
+inline void takeOverListeningSockets(
+    const McrouterOptions& mcrouterOpts,
+    const McrouterStandaloneOptions& standaloneOpts,
+    AsyncMcServer::Options& opts) {
+  auto fds = takeOverSockets(
+      standaloneOpts.takeover_socket_path,
+      std::chrono::milliseconds(standaloneOpts.takeover_timeout_ms));
+  if (fds.hasError()) {
+    MC_LOG_FAILURE(
+        mcrouterOpts,
+        failure::Category::kSystemError,
+        "Failed to take over the listening sockets: {}",
+        fds.error());
+    return;
+  }
+  if (fds->empty()) {
+    LOG(INFO) << "No mcrouter to take the listening sockets over from";
+    return;
+  }
+  LOG(INFO) << "Took over " << fds->size() << " listening sockets through "
+            << standaloneOpts.takeover_socket_path;
+  opts.existingSocketFds = std::move(fds).value();
+  opts.listenAddresses.clear();
+  opts.ports.clear();
+  opts.sslPorts.clear();
+  // Existing sockets are SSL ones iff the pem paths are set.
+  if (standaloneOpts.ssl_ports.empty()) {
+    opts.pemCertPath.clear();
+    opts.pemKeyPath.clear();
+    opts.pemCaPath.clear();
+  }
+}
+
 } // namespace detail
 
 template <class RouterInfo>
@@ -296,6 +398,10 @@ bool runServerDual(
   CarbonRouterInstance<RouterInfo>* router;
   std::shared_ptr<AsyncMcServer> asyncMcServer;
   std::shared_ptr<apache::thrift::ThriftServer> thriftServer;
+  if (!standaloneOpts.takeover_socket_path.empty()) {
+    LOG(WARNING) << "Socket takeover is not supported in dual mode, ignoring "
+                    "takeover-socket-path";
+  }
   try {
     // Create thread pool for both AsyncMcServer and ThriftServer
     auto threadPrefix =
@@ -303,7 +409,8 @@ bool runServerDual(
     ioThreadPool = std::make_shared<folly::IOThreadPoolExecutor>(
         mcrouterOpts.num_proxies,
         mcrouterOpts.num_proxies,
-        std::make_shared<folly::NamedThreadFactory>(threadPrefix));
+        std::make_shared<folly::NamedThreadFactory>(threadPrefix),
+        getProxyEventBaseManager(mcrouterOpts));
 
     // Run observer and extract event bases
     auto executorObserver = std::make_shared<ExecutorObserver>();
@@ -331,6 +438,10 @@ bool runServerDual(
     }
 
     setupRouter<RouterInfo>(mcrouterOpts, standaloneOpts, router, preRunCb);
+    if (auto cpuController = asyncMcServer->getCpuController()) {
+      router->setHostLoadProvider(
+          [cpuController]() { return cpuController->getServerLoad(); });
+    }
 
     // Create CarbonRouterClients for each worker thread
     std::vector<typename CarbonRouterClient<RouterInfo>::Pointer>
@@ -506,7 +617,10 @@ bool runServer(
     LOG(INFO) << "Spawning AsyncMcServer";
     // Create thread pool for both AsyncMcServer and CarbonRouterInstance
     ioThreadPool = std::make_shared<folly::IOThreadPoolExecutor>(
-        mcrouterOpts.num_proxies, mcrouterOpts.num_proxies);
+        mcrouterOpts.num_proxies,
+        mcrouterOpts.num_proxies,
+        std::make_shared<folly::NamedThreadFactory>("IOThreadPool"),
+        getProxyEventBaseManager(mcrouterOpts));
 
     // Run observer and extract event bases
     auto executorObserver = std::make_shared<ExecutorObserver>();
@@ -518,10 +632,6 @@ bool runServer(
     // Get EVB of main thread
     auto localEvb = ioThreadPool->getEventBaseManager()->getEventBase();
 
-    asyncMcServer =
-        std::make_shared<AsyncMcServer>(detail::createAsyncMcServerOptions(
-            mcrouterOpts, standaloneOpts, &evbs));
-
     if (standaloneOpts.remote_thread) {
       router =
           CarbonRouterInstance<RouterInfo>::init("standalone", mcrouterOpts);
@@ -536,6 +646,20 @@ bool runServer(
 
     setupRouter<RouterInfo>(mcrouterOpts, standaloneOpts, router, preRunCb);
 
+    // Only take the sockets over once the router is ready: the old process
+    // stops accepting as soon as it handed them over.
+    auto serverOpts =
+        detail::createAsyncMcServerOptions(mcrouterOpts, standaloneOpts, &evbs);
+    if (!standaloneOpts.takeover_socket_path.empty()) {
+      detail::takeOverListeningSockets(
+          mcrouterOpts, standaloneOpts, serverOpts);
+    }
+    asyncMcServer = std::make_shared<AsyncMcServer>(std::move(serverOpts));
+    if (auto cpuController = asyncMcServer->getCpuController()) {
+      router->setHostLoadProvider(
+          [cpuController]() { return cpuController->getServerLoad(); });
+    }
+
     auto shutdownStarted = std::make_shared<std::atomic<bool>>(false);
     ShutdownSignalHandler<RouterInfo> shutdownHandler(
         localEvb, nullptr, asyncMcServer, shutdownStarted);
@@ -580,7 +704,23 @@ bool runServer(
           });
           evb->terminateLoopSoon();
         });
+
+    // Hands the listening sockets over to the next mcrouter, then drains
+    // like on SIGTERM.
+    std::unique_ptr<SocketTakeoverServer> takeoverServer;
+    if (!standaloneOpts.takeover_socket_path.empty()) {
+      takeoverServer = std::make_unique<SocketTakeoverServer>(
+          standaloneOpts.takeover_socket_path,
+          [&asyncMcServer]() { return asyncMcServer->listeningSocketFds(); },
+          [evb = localEvb, &asyncMcServer, &shutdownStarted]() {
+            evb->runInEventBaseThread([&]() {
+              detail::startServerShutdown<RouterInfo>(
+                  nullptr, asyncMcServer, shutdownStarted);
+            });
+          });
+    }
     localEvb->loopForever();
+    takeoverServer.reset();
     LOG(INFO) << "Started shutdown of CarbonRouterInstance";
     router->shutdown();
     freeAllRouters();
@@ -588,6 +728,9 @@ bool runServer(
     if (!opts.unixDomainSockPath.empty()) {
       std::remove(opts.unixDomainSockPath.c_str());
     }
+    if (!opts.localSockPath.empty()) {
+      std::remove(opts.localSockPath.c_str());
+    }
     LOG(INFO) << "Completed shutdown";
   } catch (const std::exception& e) {
     LOG(ERROR) << e.what();
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
@@ -15,6 +16,7 @@
 
 #include <folly/Format.h>
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
 #include <folly/json.h>
 
 #include "mcrouter/CarbonRouterInstance.h"
@@ -23,8 +25,10 @@
 #include "mcrouter/Proxy.h"
 #include "mcrouter/ProxyConfigBuilder.h"
 #include "mcrouter/ProxyRequestContextTyped.h"
+#include "mcrouter/SlowRequestLog.h"
 #include "mcrouter/config-impl.h"
 #include "mcrouter/config.h"
+#include "mcrouter/lib/AuxiliaryIOThreadPool.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/carbon/CarbonMessageConversionUtils.h"
 #include "mcrouter/lib/fbi/cpp/globals.h"
@@ -292,8 +296,11 @@ struct ServiceInfo<RouterInfo>::ServiceInfoImpl {
       std::function<std::string(const std::vector<folly::StringPiece>& args)>>
       commands_;
 
-  detail::RouteHandlesCommandDispatcher<RouterInfo>
+  mutable detail::RouteHandlesCommandDispatcher<RouterInfo>
       routeHandlesCommandDispatcher_;
+  // route_handles results by request key. Only accessed on the proxy
+  // thread; stays valid since this object is rebuilt on every config.
+  mutable folly::F14FastMap<std::string, std::string> routeHandlesCache_;
   mutable detail::RouteCommandDispatcher<RouterInfo> routeCommandDispatcher_;
   mutable detail::GetBucketCommandDispatcher<RouterInfo>
       getBucketCommandDispatcher_;
@@ -316,8 +323,35 @@ struct ServiceInfo<RouterInfo>::ServiceInfoImpl {
       const std::shared_ptr<
           ProxyRequestContextTyped<RouterInfo, ServiceInfoRequest>>& ctx,
       const std::vector<folly::StringPiece>& args) const;
+
+  void handleRouteHandlesCommand(
+      const std::shared_ptr<
+          ProxyRequestContextTyped<RouterInfo, ServiceInfoRequest>>& ctx,
+      folly::StringPiece key,
+      const std::vector<folly::StringPiece>& args) const;
+
+  std::string routeHandles(
+      folly::StringPiece requestName,
+      folly::StringPiece key) const;
 };
 
+namespace detail {
+
+// Bounds the memory used by cached route_handles results.
+constexpr size_t kMaxCachedRouteHandles = 1024;
+
+template <class RouterInfo>
+void sendServiceInfoReply(
+    const std::shared_ptr<
+        ProxyRequestContextTyped<RouterInfo, ServiceInfoRequest>>& ctx,
+    const std::string& str) {
+  ReplyT<ServiceInfoRequest> reply(carbon::Result::FOUND);
+  reply.value_ref() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, str);
+  ctx->sendReply(std::move(reply));
+}
+
+} // namespace detail
+
 /* Must be here since unique_ptr destructor needs to know complete
    ServiceInfoImpl type */
 template <class RouterInfo>
@@ -392,32 +426,15 @@ ServiceInfo<RouterInfo>::ServiceInfoImpl::ServiceInfoImpl(
       });
 
   /*
-    This is a special case and handled separately below
+    These are special cases and handled separately below
 
   {"route", ...
   },
 
-  */
-
-  commands_.emplace(
-      "route_handles", [this](const std::vector<folly::StringPiece>& args) {
-        if (args.size() != 2) {
-          throw std::runtime_error("route_handles: 2 args expected");
-        }
-        auto requestName = args[0];
-        auto key = args[1];
-
-        auto typeId = carbon::getTypeIdByName(
-            requestName, typename RouterInfo::RoutableRequests());
+  {"route_handles", ...
+  },
 
-        std::string res;
-        if (!routeHandlesCommandDispatcher_.dispatch(
-                typeId, key, proxyRoute_, res)) {
-          throw std::runtime_error(
-              folly::sformat("route: unknown request {}", requestName));
-        }
-        return res;
-      });
+  */
 
   commands_.emplace(
       "config_md5_digest",
@@ -550,6 +567,67 @@ ServiceInfo<RouterInfo>::ServiceInfoImpl::ServiceInfoImpl(
         return toPrettySortedJson(result);
       });
 
+  commands_.emplace(
+      "slow_requests", [this](const std::vector<folly::StringPiece>& args) {
+        if (args.size() > 1) {
+          throw std::runtime_error("slow_requests: 0 or 1 args expected");
+        }
+        if (!proxy_.slowRequestLog()) {
+          throw std::runtime_error(
+              "slow_requests: disabled, see slow_request_log_threshold_us");
+        }
+        const auto& router = proxy_.router();
+        std::vector<SlowRequestLog::Entry> entries;
+        for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+          if (auto* log = router.getProxyBase(i)->slowRequestLog()) {
+            auto proxyEntries = log->snapshot();
+            entries.insert(
+                entries.end(),
+                std::make_move_iterator(proxyEntries.begin()),
+                std::make_move_iterator(proxyEntries.end()));
+          }
+        }
+        std::sort(
+            entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+              return a.startUs < b.startUs;
+            });
+        // Only the most recent ones.
+        if (args.size() == 1) {
+          auto limit = folly::to<size_t>(args[0]);
+          if (entries.size() > limit) {
+            entries.erase(entries.begin(), entries.end() - limit);
+          }
+        }
+
+        folly::dynamic result = folly::dynamic::array;
+        for (const auto& entry : entries) {
+          folly::dynamic routePath = folly::dynamic::array;
+          for (const auto& name : entry.routePath) {
+            routePath.push_back(name);
+          }
+          folly::dynamic hops = folly::dynamic::array;
+          for (const auto& hop : entry.hops) {
+            folly::dynamic hopJson = folly::dynamic::object;
+            hopJson["destination"] = hop.destination;
+            hopJson["pool"] = hop.pool;
+            hopJson["start_offset_us"] = hop.startOffsetUs;
+            hopJson["duration_us"] = hop.durationUs;
+            hopJson["result"] = carbon::resultToString(hop.result);
+            hops.push_back(std::move(hopJson));
+          }
+          folly::dynamic entryJson = folly::dynamic::object;
+          entryJson["request"] = entry.request;
+          entryJson["key"] = entry.key;
+          entryJson["start_us"] = entry.startUs;
+          entryJson["duration_us"] = entry.durationUs;
+          entryJson["result"] = carbon::resultToString(entry.result);
+          entryJson["route_path"] = std::move(routePath);
+          entryJson["hops"] = std::move(hops);
+          result.push_back(std::move(entryJson));
+        }
+        return toPrettySortedJson(result);
+      });
+
   commands_.emplace(
       "global_params",
       [this](const std::vector<folly::StringPiece>& /* args */) {
@@ -604,6 +682,11 @@ void ServiceInfo<RouterInfo>::ServiceInfoImpl::handleRequest(
       return;
     }
 
+    if (cmd == "route_handles") {
+      handleRouteHandlesCommand(ctx, key, args);
+      return;
+    }
+
     auto it = commands_.find(cmd.str());
     if (it == commands_.end()) {
       throw std::runtime_error("unknown command: " + cmd.str());
@@ -615,9 +698,7 @@ void ServiceInfo<RouterInfo>::ServiceInfoImpl::handleRequest(
   } catch (const std::exception& e) {
     replyStr = std::string("ERROR: ") + e.what();
   }
-  ReplyT<ServiceInfoRequest> reply(carbon::Result::FOUND);
-  reply.value_ref() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, replyStr);
-  ctx->sendReply(std::move(reply));
+  detail::sendServiceInfoReply(ctx, replyStr);
 }
 
 template <class RouterInfo>
@@ -663,6 +744,70 @@ void ServiceInfo<RouterInfo>::ServiceInfoImpl::handleGetBucketCommand(
   }
 }
 
+template <class RouterInfo>
+void ServiceInfo<RouterInfo>::ServiceInfoImpl::handleRouteHandlesCommand(
+    const std::shared_ptr<
+        ProxyRequestContextTyped<RouterInfo, ServiceInfoRequest>>& ctx,
+    folly::StringPiece key,
+    const std::vector<folly::StringPiece>& args) const {
+  if (args.size() != 2) {
+    throw std::runtime_error("route_handles: 2 args expected");
+  }
+  auto it = routeHandlesCache_.find(key);
+  if (it != routeHandlesCache_.end()) {
+    detail::sendServiceInfoReply(ctx, it->second);
+    return;
+  }
+
+  // Traversing the whole tree can take a while, so it's done on the
+  // auxiliary thread pool rather than on the proxy thread. The route handles
+  // are immutable, and ctx keeps the config (and this object) alive.
+  auto compute = [this, ctx, key = key.str(), args]() {
+    std::string res;
+    bool cache = true;
+    try {
+      res = routeHandles(args[0], args[1]);
+    } catch (const std::exception& e) {
+      res = std::string("ERROR: ") + e.what();
+      cache = false;
+    }
+    proxy_.eventBase().runInEventBaseThread(
+        [this, ctx, key = std::move(key), res = std::move(res), cache]() {
+          if (cache) {
+            if (routeHandlesCache_.size() >= detail::kMaxCachedRouteHandles) {
+              routeHandlesCache_.clear();
+            }
+            routeHandlesCache_.emplace(key, res);
+          }
+          detail::sendServiceInfoReply(ctx, res);
+        });
+  };
+  // args point into the request, which is alive until the reply is sent.
+  if (auto auxPool = AuxiliaryIOThreadPoolSingleton::try_get_fast()) {
+    auxPool->getThreadPool().add(std::move(compute));
+  } else {
+    compute();
+  }
+}
+
+template <class RouterInfo>
+std::string ServiceInfo<RouterInfo>::ServiceInfoImpl::routeHandles(
+    folly::StringPiece requestName,
+    folly::StringPiece key) const {
+  auto typeId = carbon::getTypeIdByName(
+      requestName, typename RouterInfo::RoutableRequests());
+
+  std::string res;
+  if (!routeHandlesCommandDispatcher_.dispatch(typeId, key, proxyRoute_, res)) {
+    throw std::runtime_error(
+        folly::sformat("route: unknown request {}", requestName));
+  }
+  if (!res.empty() && res.back() == '\n') {
+    res.pop_back();
+  }
+  return res;
+}
+
 template <class RouterInfo>
 void ServiceInfo<RouterInfo>::handleRequest(
     folly::StringPiece key,
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ShadowThrottle.h"
+
+#include <algorithm>
+#include <random>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/options.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+ShadowThrottle::ShadowThrottle(ProxyBase& proxy) : proxy_(proxy) {}
+
+double ShadowThrottle::rampFraction(double value, double start, double full) {
+  if (start <= 0.0 || value <= start) {
+    return 0.0;
+  }
+  if (full <= start || value >= full) {
+    return 1.0;
+  }
+  return (value - start) / (full - start);
+}
+
+double ShadowThrottle::shedFraction() const {
+  const auto& opts = proxy_.router().opts();
+  double shed = 0.0;
+  if (opts.shadow_shed_loop_time_us > 0) {
+    double start = opts.shadow_shed_loop_time_us;
+    shed = std::max(
+        shed,
+        rampFraction(
+            proxy_.eventBase().getEventBase().getAvgLoopTime(),
+            start,
+            2 * start));
+  }
+  if (opts.shadow_shed_cpu_percent > 0) {
+    shed = std::max(
+        shed,
+        rampFraction(
+            proxy_.router().hostLoad().percentLoad(),
+            opts.shadow_shed_cpu_percent,
+            100.0));
+  }
+  if (opts.shadow_shed_fibers_percent > 0 && opts.fibers_max_pool_size > 0) {
+    double start = opts.shadow_shed_fibers_percent;
+    shed = std::max(
+        shed,
+        rampFraction(
+            100.0 * proxy_.fiberManager().fibersAllocated() /
+                opts.fibers_max_pool_size,
+            start,
+            2 * start));
+  }
+  if (opts.shadow_shed_queue_delay_us > 0) {
+    double start = opts.shadow_shed_queue_delay_us;
+    shed = std::max(
+        shed,
+        rampFraction(proxy_.stats().queueDelayUsP99(), start, 2 * start));
+  }
+  return shed;
+}
+
+bool ShadowThrottle::admit() {
+  auto admitFraction = 1.0 - shedFraction();
+  admitFraction_.store(admitFraction, std::memory_order_relaxed);
+  if (admitFraction >= 1.0) {
+    return true;
+  }
+  if (admitFraction <= 0.0) {
+    return false;
+  }
+  return std::uniform_real_distribution<double>(0.0, 1.0)(
+             proxy_.randomGenerator()) < admitFraction;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
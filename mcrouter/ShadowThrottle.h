@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class ProxyBase;
+
+/**
+ * Sheds shadow traffic of one proxy based on how loaded the proxy is.
+ *
+ * Looks at four signals, each with its own threshold (0 disables it):
+ *  - average event loop time of the proxy thread;
+ *  - host CPU load, as reported by CarbonRouterInstanceBase::hostLoad();
+ *  - fibers allocated by the proxy, relative to the fibers pool size;
+ *  - 99th percentile of the delay before requests start being routed (see
+ *    ProxyStats::queueDelayUsP99()). Unlike the number of fibers, it only
+ *    grows when the proxy thread is saturated, not when backends are slow.
+ * Shadow requests start being dropped when any signal is over its threshold,
+ * and the fraction dropped grows linearly until all of them are dropped when
+ * the signal reaches twice the threshold (100% for CPU load).
+ *
+ * Only the proxy thread may call admit(); admitPercent() may be called from
+ * any thread.
+ */
+class ShadowThrottle {
+ public:
+  explicit ShadowThrottle(ProxyBase& proxy);
+
+  /**
+   * @return  true if a shadow request should be sent now.
+   */
+  bool admit();
+
+  /**
+   * @return  percentage of shadow requests currently let through.
+   */
+  double admitPercent() const {
+    return admitFraction_.load(std::memory_order_relaxed) * 100.0;
+  }
+
+  /**
+   * @return  fraction of traffic to drop once `value` is over `start`: 0 at
+   *          `start`, growing linearly to 1 at `full`.
+   */
+  static double rampFraction(double value, double start, double full);
+
+ private:
+  ProxyBase& proxy_;
+  std::atomic<double> admitFraction_{1.0};
+
+  double shedFraction() const;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SlowRequestLog.h"
+
+#include <algorithm>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+SlowRequestLog::SlowRequestLog(int64_t thresholdUs, size_t capacity)
+    : thresholdUs_(thresholdUs), capacity_(std::max<size_t>(capacity, 1)) {}
+
+void SlowRequestLog::add(Entry entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.size() < capacity_) {
+    entries_.push_back(std::move(entry));
+    return;
+  }
+  entries_[next_] = std::move(entry);
+  next_ = (next_ + 1) % capacity_;
+}
+
+std::vector<SlowRequestLog::Entry> SlowRequestLog::snapshot() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Entry> result;
+  result.reserve(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    result.push_back(entries_[(next_ + i) % entries_.size()]);
+  }
+  return result;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
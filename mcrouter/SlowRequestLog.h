@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * The last `capacity` requests of a proxy that took at least `thresholdUs`
+ * to be replied to, with the route handles they went through and every
+ * destination they were sent to.
+ *
+ * The owning proxy is the only writer, and only for slow requests; readers
+ * on other threads (the slow_requests service info command) take a
+ * snapshot.
+ */
+class SlowRequestLog {
+ public:
+  /**
+   * A request sent to a destination.
+   */
+  struct Hop {
+    // host:port
+    std::string destination;
+    std::string pool;
+    // Since the start of the request.
+    int64_t startOffsetUs{0};
+    int64_t durationUs{0};
+    carbon::Result result{carbon::Result::UNKNOWN};
+  };
+
+  struct Entry {
+    std::string request;
+    std::string key;
+    // Unix time, in us.
+    int64_t startUs{0};
+    int64_t durationUs{0};
+    carbon::Result result{carbon::Result::UNKNOWN};
+    // Names of the route handles the request may go through, in DFS order,
+    // indented by their depth in the tree.
+    std::vector<std::string> routePath;
+    // In the order the replies were received.
+    std::vector<Hop> hops;
+  };
+
+  SlowRequestLog(int64_t thresholdUs, size_t capacity);
+
+  SlowRequestLog(const SlowRequestLog&) = delete;
+  SlowRequestLog& operator=(const SlowRequestLog&) = delete;
+
+  int64_t thresholdUs() const {
+    return thresholdUs_;
+  }
+
+  /**
+   * Adds `entry`, replacing the oldest one if the log is full.
+   */
+  void add(Entry entry);
+
+  /**
+   * @return  The entries of the log, oldest first.
+   */
+  std::vector<Entry> snapshot() const;
+
+ private:
+  const int64_t thresholdUs_;
+  const size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::vector<Entry> entries_;
+  // Index of the oldest entry once the log is full.
+  size_t next_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -131,6 +131,24 @@ bool areOptionsValid(
     return false;
   }
 
+  if (!standaloneOpts.local_sock.empty() &&
+      !standaloneOpts.unix_domain_sock.empty()) {
+    LOG(ERROR) << "local-sock can't be used with unix-domain-sock";
+    return false;
+  }
+
+  if (!standaloneOpts.takeover_socket_path.empty() &&
+      (standaloneOpts.listen_sock_fd >= 0 ||
+       !standaloneOpts.unix_domain_sock.empty() ||
+       !standaloneOpts.local_sock.empty() ||
+       (!standaloneOpts.ports.empty() && !standaloneOpts.ssl_ports.empty()) ||
+       standaloneOpts.num_listening_sockets != 1 ||
+       standaloneOpts.per_thread_listening_sockets)) {
+    LOG(ERROR) << "takeover-socket-path requires a single listening socket on"
+                  " either plain or SSL ports";
+    return false;
+  }
+
   if (opts.keepalive_idle_s <= 0 || opts.keepalive_interval_s <= 0 ||
       opts.keepalive_cnt < 0) {
     LOG(ERROR) << "invalid keepalive options";
@@ -484,6 +502,14 @@ void setupStandaloneMcrouter(
         option);
   }
 
+  if (libmcrouterOptions.failure_log_window_ms != 0) {
+    // From now on failures are only queued where they happen, and written to
+    // stderr in batches.
+    failure::setHandler(failure::handlers::async(
+        failure::handlers::logToStdError(),
+        std::chrono::milliseconds(libmcrouterOptions.failure_log_window_ms)));
+  }
+
   // finialize standalone options
   finalizeStandaloneOptions(standaloneOptions);
 
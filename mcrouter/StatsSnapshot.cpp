@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "mcrouter/StatsSnapshot.h"
+
+#include <vector>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+std::shared_ptr<const McStatsReply> StatsSnapshot::get(
+    folly::StringPiece group) {
+  if (auto replies = replies_.load()) {
+    auto it = replies->find(group);
+    if (it != replies->end()) {
+      return it->second;
+    }
+  }
+  groups_.wlock()->emplace(group.str());
+  return nullptr;
+}
+
+void StatsSnapshot::collect(Collector& collector) {
+  std::vector<std::string> groups;
+  {
+    auto locked = groups_.rlock();
+    groups.assign(locked->begin(), locked->end());
+  }
+  for (const auto& group : groups) {
+    auto reply = std::make_shared<const McStatsReply>(collector(group));
+    // Only this thread publishes, so the copy can't miss an update.
+    auto replies = std::make_shared<Replies>();
+    if (auto current = replies_.load()) {
+      *replies = *current;
+    }
+    (*replies)[group] = std::move(reply);
+    replies_.store(std::move(replies));
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Replies to stats commands, collected in the background (see
+ * stats_snapshot_interval_ms), so that a stats request is served with a
+ * lookup instead of walking every proxy, destination and external stats
+ * callback on the proxy thread.
+ *
+ * Only the groups that were asked for are collected. The collector builds a
+ * new copy of the replies while requests keep reading the previous one, and
+ * publishes it after each group, so that a slow group doesn't hold back the
+ * others.
+ *
+ * get() is thread-safe, collect() must be called from a single thread.
+ */
+class StatsSnapshot {
+ public:
+  using Collector = folly::Function<McStatsReply(folly::StringPiece group)>;
+
+  /**
+   * @return  the last collected reply for `group`, nullptr if there is none
+   *          yet. In that case, `group` will be collected from now on.
+   */
+  std::shared_ptr<const McStatsReply> get(folly::StringPiece group);
+
+  /**
+   * Collects all the groups asked for so far, one at a time.
+   */
+  void collect(Collector& collector);
+
+ private:
+  using Replies =
+      folly::F14FastMap<std::string, std::shared_ptr<const McStatsReply>>;
+
+  folly::atomic_shared_ptr<const Replies> replies_;
+  // Groups asked for, only written on a miss.
+  folly::Synchronized<folly::F14FastSet<std::string>> groups_;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
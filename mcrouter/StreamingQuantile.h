@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Constant memory estimate of a quantile of a stream of positive samples
+ * (e.g. latencies).
+ *
+ * Every sample moves the estimate by a small factor towards it: up by
+ * rate * quantile if the sample is above the estimate, down by
+ * rate * (1 - quantile) otherwise. The estimate settles where a `quantile`
+ * fraction of samples is below it, and follows changes of the distribution
+ * within a few hundreds of samples.
+ *
+ * Only one thread may insert samples; value() may be called from any thread.
+ */
+class StreamingQuantile {
+ public:
+  explicit StreamingQuantile(double quantile, double rate = 0.05)
+      : up_(1.0 + rate * quantile), down_(1.0 - rate * (1.0 - quantile)) {}
+
+  StreamingQuantile(const StreamingQuantile& other)
+      : up_(other.up_), down_(other.down_) {
+    estimate_.store(
+        other.estimate_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    numSamples_.store(
+        other.numSamples_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+
+  void insertSample(double sample) {
+    auto estimate = estimate_.load(std::memory_order_relaxed);
+    if (std::isnan(estimate) || estimate <= 0.0) {
+      estimate = sample;
+    } else if (sample > estimate) {
+      estimate *= up_;
+    } else if (sample < estimate) {
+      estimate *= down_;
+    }
+    estimate_.store(estimate, std::memory_order_relaxed);
+    numSamples_.store(
+        numSamples_.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+  }
+
+  double value() const {
+    auto value = estimate_.load(std::memory_order_relaxed);
+    return !std::isnan(value) ? value : 0.0;
+  }
+
+  /**
+   * Number of samples inserted since construction or last reset().
+   */
+  uint64_t numSamples() const {
+    return numSamples_.load(std::memory_order_relaxed);
+  }
+
+  void reset() {
+    estimate_.store(std::nan(""), std::memory_order_relaxed);
+    numSamples_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  const double up_;
+  const double down_;
+  std::atomic<double> estimate_{std::nan("")};
+  std::atomic<uint64_t> numSamples_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
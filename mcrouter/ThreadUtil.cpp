@@ -7,15 +7,185 @@
 
 #include "ThreadUtil.h"
 
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <stdexcept>
+
 #include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/experimental/JemallocNodumpAllocator.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/memory/Malloc.h>
+#include <folly/memory/MallctlHelper.h>
 #include <folly/system/ThreadName.h>
 
+#include "mcrouter/lib/network/IoUring.h"
 #include "mcrouter/options.h"
 
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+namespace {
+
+/**
+ * Parses a sysfs list like "0-3,8-11" (cpulist, node/online).
+ */
+std::vector<size_t> parseSysfsList(folly::StringPiece list) {
+  std::vector<size_t> result;
+  std::vector<folly::StringPiece> ranges;
+  folly::split(
+      ',', folly::trimWhitespace(list), ranges, /* ignoreEmpty */ true);
+  for (auto range : ranges) {
+    folly::StringPiece first;
+    folly::StringPiece last;
+    if (!folly::split('-', range, first, last)) {
+      first = last = range;
+    }
+    auto from = folly::tryTo<size_t>(first);
+    auto to = folly::tryTo<size_t>(last);
+    if (!from.hasValue() || !to.hasValue()) {
+      return {};
+    }
+    for (size_t i = *from; i <= *to; ++i) {
+      result.push_back(i);
+    }
+  }
+  return result;
+}
+
+#ifdef FOLLY_JEMALLOC_NODUMP_ALLOCATOR_SUPPORTED
+// Same requirement as JemallocNodumpAllocator: extent hooks (jemalloc 5).
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+void* hugePageExtentAlloc(
+    extent_hooks_t* /* hooks */,
+    void* newAddr,
+    size_t size,
+    size_t alignment,
+    bool* zero,
+    bool* commit,
+    unsigned /* arenaInd */) {
+  if (newAddr != nullptr) {
+    // Can't grow an extent in place, jemalloc will ask for another one.
+    return nullptr;
+  }
+  alignment = std::max(alignment, kHugePageSize);
+  const size_t mapSize = size + alignment;
+  void* p = mmap(
+      nullptr,
+      mapSize,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  // Trim the mapping to an aligned range, so that the kernel can back it
+  // with whole huge pages.
+  const auto start = reinterpret_cast<uintptr_t>(p);
+  const auto alignedStart = (start + alignment - 1) & ~(alignment - 1);
+  const auto alignedEnd = alignedStart + size;
+  if (alignedStart > start) {
+    munmap(p, alignedStart - start);
+  }
+  if (start + mapSize > alignedEnd) {
+    munmap(reinterpret_cast<void*>(alignedEnd), start + mapSize - alignedEnd);
+  }
+  auto* addr = reinterpret_cast<void*>(alignedStart);
+  madvise(addr, size, MADV_HUGEPAGE);
+  *zero = true;
+  *commit = true;
+  return addr;
+}
+
+bool hugePageExtentDalloc(
+    extent_hooks_t* /* hooks */,
+    void* addr,
+    size_t size,
+    bool /* committed */,
+    unsigned /* arenaInd */) {
+  return munmap(addr, size) != 0;
+}
+
+void hugePageExtentDestroy(
+    extent_hooks_t* /* hooks */,
+    void* addr,
+    size_t size,
+    bool /* committed */,
+    unsigned /* arenaInd */) {
+  munmap(addr, size);
+}
+
+bool hugePageExtentPurgeForced(
+    extent_hooks_t* /* hooks */,
+    void* addr,
+    size_t /* size */,
+    size_t offset,
+    size_t length,
+    unsigned /* arenaInd */) {
+  return madvise(static_cast<char*>(addr) + offset, length, MADV_DONTNEED) !=
+      0;
+}
+
+// Extents are plain anonymous mappings, so they can be split and merged
+// freely.
+bool hugePageExtentSplit(
+    extent_hooks_t* /* hooks */,
+    void* /* addr */,
+    size_t /* size */,
+    size_t /* sizeA */,
+    size_t /* sizeB */,
+    bool /* committed */,
+    unsigned /* arenaInd */) {
+  return false;
+}
+
+bool hugePageExtentMerge(
+    extent_hooks_t* /* hooks */,
+    void* /* addrA */,
+    size_t /* sizeA */,
+    void* /* addrB */,
+    size_t /* sizeB */,
+    bool /* committed */,
+    unsigned /* arenaInd */) {
+  return false;
+}
+
+// Null hooks opt out: extents are always committed and never lazily purged.
+extent_hooks_t hugePageExtentHooks = {
+    hugePageExtentAlloc,
+    hugePageExtentDalloc,
+    hugePageExtentDestroy,
+    nullptr /* commit */,
+    nullptr /* decommit */,
+    nullptr /* purge_lazy */,
+    hugePageExtentPurgeForced,
+    hugePageExtentSplit,
+    hugePageExtentMerge,
+};
+
+unsigned createHugePageJemallocArena() {
+  unsigned arena = 0;
+  size_t len = sizeof(arena);
+  extent_hooks_t* hooks = &hugePageExtentHooks;
+  if (auto err =
+          mallctl("arenas.create", &arena, &len, &hooks, sizeof(hooks))) {
+    throw std::runtime_error(
+        folly::to<std::string>("arenas.create failed: ", folly::errnoStr(err)));
+  }
+  return arena;
+}
+#endif
+
+} // namespace
+
 void mcrouterSetThisThreadName(
     const McrouterOptions& opts,
     folly::StringPiece prefix,
@@ -28,6 +198,148 @@ void mcrouterSetThisThreadName(
     LOG(WARNING) << "Unable to set thread name to " << name;
   }
 }
+
+folly::EventBaseManager* getProxyEventBaseManager(const McrouterOptions& opts) {
+  if (opts.proxy_io_uring_backend) {
+    if (isIoUringAvailable()) {
+      return &getIoUringEventBaseManager(
+          std::chrono::milliseconds(opts.proxy_io_uring_sqpoll_idle_ms));
+    }
+    LOG(WARNING) << "io_uring is not available, proxy threads will use the "
+                    "default event base backend";
+  }
+  return folly::EventBaseManager::get();
+}
+
+folly::Optional<unsigned> bindThisThreadToNewJemallocArena(bool hugePages) {
+  if (!folly::usingJEMalloc()) {
+    return folly::none;
+  }
+  try {
+    unsigned arena = 0;
+#ifdef FOLLY_JEMALLOC_NODUMP_ALLOCATOR_SUPPORTED
+    if (hugePages) {
+      arena = createHugePageJemallocArena();
+    } else {
+      folly::mallctlRead("arenas.create", &arena);
+    }
+#else
+    if (hugePages) {
+      LOG_FIRST_N(WARNING, 1) << "jemalloc extent hooks are not supported, "
+                                 "proxy arenas won't use huge pages";
+    }
+    folly::mallctlRead("arenas.create", &arena);
+#endif
+    folly::mallctlWrite("thread.arena", arena);
+    folly::mallctlCall("thread.tcache.flush");
+    return arena;
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Unable to bind thread to a new jemalloc arena: "
+                 << e.what();
+    return folly::none;
+  }
+}
+
+void refreshJemallocStats() {
+  if (!folly::usingJEMalloc()) {
+    return;
+  }
+  try {
+    uint64_t epoch = 1;
+    folly::mallctlWrite("epoch", epoch);
+  } catch (const std::exception& e) {
+    LOG_EVERY_N(WARNING, 100) << "Unable to refresh jemalloc stats: "
+                              << e.what();
+  }
+}
+
+folly::Optional<JemallocArenaStats> getJemallocArenaStats(unsigned arena) {
+  if (!folly::usingJEMalloc()) {
+    return folly::none;
+  }
+  auto read = [arena](folly::StringPiece name) {
+    size_t value = 0;
+    folly::mallctlRead(
+        folly::to<std::string>("stats.arenas.", arena, ".", name).c_str(),
+        &value);
+    return value;
+  };
+  try {
+    size_t pageSize = 0;
+    folly::mallctlRead("arenas.page", &pageSize);
+    JemallocArenaStats stats;
+    stats.allocated = read("small.allocated") + read("large.allocated");
+    stats.active = read("pactive") * pageSize;
+    stats.resident = read("resident");
+    return stats;
+  } catch (const std::exception&) {
+    // Built without stats (--disable-stats).
+    return folly::none;
+  }
+}
+
+void purgeJemallocArena(unsigned arena) {
+  if (!folly::usingJEMalloc()) {
+    return;
+  }
+  try {
+    folly::mallctlCall(
+        folly::to<std::string>("arena.", arena, ".purge").c_str());
+  } catch (const std::exception& e) {
+    LOG_EVERY_N(WARNING, 100) << "Unable to purge jemalloc arena " << arena
+                              << ": " << e.what();
+  }
+}
+
+std::vector<std::vector<size_t>> getNumaNodeCpus() {
+  constexpr folly::StringPiece kNodeDir = "/sys/devices/system/node/";
+  std::vector<std::vector<size_t>> nodes;
+  std::string online;
+  if (!folly::readFile(
+          folly::to<std::string>(kNodeDir, "online").c_str(), online)) {
+    return nodes;
+  }
+  for (auto node : parseSysfsList(online)) {
+    std::string cpuList;
+    if (!folly::readFile(
+            folly::to<std::string>(kNodeDir, "node", node, "/cpulist").c_str(),
+            cpuList)) {
+      continue;
+    }
+    auto cpus = parseSysfsList(cpuList);
+    if (!cpus.empty()) {
+      nodes.push_back(std::move(cpus));
+    }
+  }
+  return nodes;
+}
+
+size_t numaNodeForThread(size_t threadId, size_t numThreads, size_t numNodes) {
+  if (numThreads == 0 || numNodes == 0) {
+    return 0;
+  }
+  return std::min(threadId, numThreads - 1) * numNodes / numThreads;
+}
+
+bool pinThisThreadToCpus(const std::vector<size_t>& cpus) {
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpuSet);
+    }
+  }
+  if (CPU_COUNT(&cpuSet) == 0) {
+    return false;
+  }
+  if (auto err =
+          pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet)) {
+    LOG(WARNING) << "Unable to set thread CPU affinity: "
+                 << folly::errnoStr(err);
+    return false;
+  }
+  return true;
+}
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -7,9 +7,16 @@
 
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 #include <folly/Optional.h>
 #include <folly/Range.h>
 
+namespace folly {
+class EventBaseManager;
+} // namespace folly
+
 namespace facebook {
 namespace memcache {
 
@@ -21,6 +28,79 @@ void mcrouterSetThisThreadName(
     const McrouterOptions& opts,
     folly::StringPiece prefix,
     folly::Optional<size_t> threadId = folly::none);
-}
+
+/**
+ * EventBaseManager to use for proxy threads created by mcrouter itself.
+ * Returns the io_uring backed manager if proxy_io_uring_backend is set and
+ * io_uring is available, the default manager otherwise.
+ */
+folly::EventBaseManager* getProxyEventBaseManager(const McrouterOptions& opts);
+
+/**
+ * Creates a new jemalloc arena and makes it the arena of the calling thread,
+ * so that the thread doesn't contend with others on arena locks and its
+ * memory can be accounted separately. The thread cache is flushed so that
+ * memory cached from the previous arena goes back to it.
+ *
+ * @param hugePages  If true, the arena maps its memory in 2MB aligned chunks
+ *                   advised as transparent huge pages (MADV_HUGEPAGE), to cut
+ *                   TLB misses. Falls back to a regular arena if jemalloc
+ *                   doesn't support custom extent hooks.
+ *
+ * @return  index of the new arena, or none if mcrouter doesn't run with
+ *          jemalloc or the arena couldn't be created.
+ */
+folly::Optional<unsigned> bindThisThreadToNewJemallocArena(
+    bool hugePages = false);
+
+struct JemallocArenaStats {
+  // Bytes of the live allocations in the arena.
+  size_t allocated{0};
+  // Bytes of the pages backing live allocations, including free space in
+  // partially used pages.
+  size_t active{0};
+  // Bytes of the arena memory resident in RAM, including dirty pages not
+  // returned to the OS yet.
+  size_t resident{0};
+};
+
+/**
+ * Makes jemalloc refresh the stats read by getJemallocArenaStats().
+ * Cheap enough to call once per stats request, not per arena.
+ */
+void refreshJemallocStats();
+
+/**
+ * @return  stats of the given arena as of the last refreshJemallocStats(),
+ *          or none if they aren't available.
+ */
+folly::Optional<JemallocArenaStats> getJemallocArenaStats(unsigned arena);
+
+/**
+ * Returns all the dirty pages of the given arena to the OS.
+ */
+void purgeJemallocArena(unsigned arena);
+
+/**
+ * @return  CPUs of every NUMA node of the host that has any, as listed in
+ *          /sys/devices/system/node. Empty if the host doesn't expose its
+ *          NUMA topology.
+ */
+std::vector<std::vector<size_t>> getNumaNodeCpus();
+
+/**
+ * NUMA node thread `threadId` out of `numThreads` should run on, so that
+ * the threads are spread evenly over `numNodes` nodes in contiguous blocks
+ * (threads 0..k-1 on node 0, k..2k-1 on node 1, ...).
+ */
+size_t numaNodeForThread(size_t threadId, size_t numThreads, size_t numNodes);
+
+/**
+ * Restricts the calling thread to `cpus`.
+ *
+ * @return  false if the affinity couldn't be set.
+ */
+bool pinThisThreadToCpus(const std::vector<size_t>& cpus);
+} // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "TkoEventLog.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+#include <utility>
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/McrouterLogFailure.h"
+#include "mcrouter/lib/network/AccessPoint.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+std::string tkoLogFunctionName(folly::StringPiece routerName) {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>(
+      "carbon-tko-log-fn-", routerName, "-", uniqueId.fetch_add(1));
+}
+
+folly::StringPiece eventDescription(TkoLogEvent event) {
+  switch (event) {
+    case TkoLogEvent::MarkHardTko:
+      return "marked hard TKO";
+    case TkoLogEvent::MarkSoftTko:
+      return "marked soft TKO";
+    case TkoLogEvent::UnMarkTko:
+      return "unmarked TKO";
+    case TkoLogEvent::RemoveFromConfig:
+      return "were TKO, removed from config";
+  }
+  return "unknown TKO event";
+}
+
+struct EventGroup {
+  std::unordered_set<std::string> hosts;
+  std::string hostsStr;
+  std::map<carbon::Result, size_t> results;
+  size_t hardTkos{0};
+  size_t softTkos{0};
+};
+
+} // anonymous namespace
+
+TkoEventLog::TkoEventLog(CarbonRouterInstanceBase& router)
+    : router_(router),
+      functionHandle_(tkoLogFunctionName(router_.opts().router_name)),
+      queue_(kQueueCapacity),
+      lastFlush_(std::chrono::steady_clock::now()) {}
+
+TkoEventLog::~TkoEventLog() {
+  stop();
+}
+
+bool TkoEventLog::start() {
+  auto scheduler = router_.functionScheduler();
+  if (!scheduler) {
+    MC_LOG_FAILURE(
+        router_.opts(),
+        memcache::failure::Category::kSystemError,
+        "Scheduler not available, logging TKO events where they happen");
+    return false;
+  }
+  lastFlush_ = std::chrono::steady_clock::now();
+  scheduler->addFunction(
+      [this]() { flush(); },
+      std::chrono::milliseconds(
+          std::max<uint32_t>(router_.opts().tko_log_window_ms, 1)),
+      functionHandle_);
+  running_.store(true, std::memory_order_release);
+  return true;
+}
+
+void TkoEventLog::stop() noexcept {
+  if (!running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  if (auto scheduler = router_.functionScheduler()) {
+    scheduler->cancelFunctionAndWait(functionHandle_);
+  }
+  flush();
+}
+
+void TkoEventLog::flush() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto windowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            now - lastFlush_)
+                            .count();
+  lastFlush_ = now;
+
+  // Ordered, so that lines of the same pool are next to each other.
+  std::map<std::pair<int32_t, TkoLogEvent>, EventGroup> groups;
+  Event event;
+  while (queue_.read(event)) {
+    auto& group = groups[std::make_pair(event.poolStatIndex, event.event)];
+    auto hostPort = event.accessPoint->toHostPortString();
+    if (group.hosts.size() < kMaxHostsPerLine &&
+        !group.hosts.count(hostPort)) {
+      folly::toAppend(
+          group.hosts.empty() ? "" : ", ", hostPort, &group.hostsStr);
+    }
+    group.hosts.insert(std::move(hostPort));
+    ++group.results[event.result];
+    // Events are queued roughly in order, the last one has the latest counts.
+    group.hardTkos = event.hardTkos;
+    group.softTkos = event.softTkos;
+  }
+
+  const auto& pools = router_.getStatsEnabledPools();
+  for (const auto& it : groups) {
+    const auto poolIndex = it.first.first;
+    const auto& group = it.second;
+    folly::StringPiece pool = "(unknown)";
+    if (poolIndex >= 0 && static_cast<size_t>(poolIndex) < pools.size()) {
+      pool = pools[poolIndex];
+    }
+
+    std::string results;
+    for (const auto& result : group.results) {
+      folly::toAppend(
+          results.empty() ? "" : ", ",
+          carbon::resultToString(result.first),
+          " x",
+          result.second,
+          &results);
+    }
+    const auto numHosts = group.hosts.size();
+    LOG(INFO) << folly::sformat(
+        "{} destinations in pool {} {} in the last {}ms ({}{}). "
+        "Total hard TKOs: {}; soft TKOs: {}. Replies: {}",
+        numHosts,
+        pool,
+        eventDescription(it.first.second),
+        windowMs,
+        group.hostsStr,
+        numHosts > kMaxHostsPerLine
+            ? folly::sformat(" and {} more", numHosts - kMaxHostsPerLine)
+            : "",
+        group.hardTkos,
+        group.softTkos,
+        results);
+  }
+
+  if (auto dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+    LOG(WARNING) << "Dropped " << dropped
+                 << " TKO events in the last " << windowMs
+                 << "ms, the TKO event queue is full";
+  }
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
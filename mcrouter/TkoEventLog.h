@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <folly/MPMCQueue.h>
+
+#include "mcrouter/TkoLog.h"
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+
+struct AccessPoint;
+
+namespace mcrouter {
+
+class CarbonRouterInstanceBase;
+
+/**
+ * Batches the log lines of destination TKO events: proxies only queue the
+ * events (see ProxyDestinationBase::onTkoEvent) in a lock-free queue, and
+ * they are logged every opts.tko_log_window_ms from the function scheduler,
+ * one line per pool and event, e.g.
+ *   "120 destinations in pool A marked hard TKO in the last 1000ms (...)"
+ * so that a rack going down doesn't mean thousands of log writes on the
+ * proxy threads.
+ */
+class TkoEventLog {
+ public:
+  struct Event {
+    TkoLogEvent event{TkoLogEvent::MarkHardTko};
+    carbon::Result result{carbon::Result::UNKNOWN};
+    // Index of the destination's pool in the stats enabled pools, or -1.
+    int32_t poolStatIndex{-1};
+    std::shared_ptr<const AccessPoint> accessPoint;
+    // Global TKO counts, right after the event.
+    size_t hardTkos{0};
+    size_t softTkos{0};
+  };
+
+  explicit TkoEventLog(CarbonRouterInstanceBase& router);
+
+  ~TkoEventLog();
+
+  /**
+   * Schedules logging the queued events every opts.tko_log_window_ms.
+   *
+   * @return  false if the function scheduler is not available.
+   */
+  bool start();
+
+  /**
+   * Cancels the periodic logging and logs what is still queued.
+   */
+  void stop() noexcept;
+
+  /**
+   * Whether start() succeeded and stop() wasn't called yet. Events should
+   * be logged where they happen otherwise.
+   */
+  bool running() const {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Queues an event, may be called from any thread. The event is dropped
+   * (and counted in the next log line) if the queue is full.
+   */
+  void add(Event&& event) {
+    if (!queue_.write(std::move(event))) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Logs the events queued so far.
+   */
+  void flush();
+
+ private:
+  static constexpr size_t kQueueCapacity = 16 * 1024;
+  // Destinations named in a line, the rest are only counted.
+  static constexpr size_t kMaxHostsPerLine = 5;
+
+  CarbonRouterInstanceBase& router_;
+  // Name of the periodic function registered with the function scheduler.
+  const std::string functionHandle_;
+
+  folly::MPMCQueue<Event> queue_;
+  std::atomic<size_t> dropped_{0};
+  std::atomic<bool> running_{false};
+
+  // Only accessed by flush().
+  std::chrono::steady_clock::time_point lastFlush_;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -8,7 +8,6 @@
 #include "TkoTracker.h"
 
 #include <cassert>
-#include <functional>
 #include <unordered_map>
 
 #include <folly/MapUtil.h>
@@ -143,7 +142,7 @@ bool TkoTracker::recordSoftFailure(
   // increment the count for the same destination, causing us to be overly
   // conservative. Eventually this will get corrected, as only one proxy can
   // ever mark it TKO, but we may be inconsistent for a very short time.
-  ++consecutiveFailureCount_;
+  incrementConsecutiveFailures();
 
   // If host is in any state of TKO, we just leave it alone
   if (isTko()) {
@@ -189,7 +188,7 @@ bool TkoTracker::recordSoftFailure(
 bool TkoTracker::recordHardFailure(
     ProxyDestinationBase* pdstn,
     carbon::Result result) {
-  ++consecutiveFailureCount_;
+  incrementConsecutiveFailures();
 
   if (isHardTko()) {
     return false;
@@ -238,6 +237,18 @@ bool TkoTracker::isResponsible(ProxyDestinationBase* pdstn) const {
   return (sumFailures_ & ~1) == reinterpret_cast<uintptr_t>(pdstn);
 }
 
+void TkoTracker::incrementConsecutiveFailures() {
+  if (consecutiveFailureCount_.fetch_add(1) == 0) {
+    trackerMap_.addSuspect(this);
+  }
+}
+
+void TkoTracker::resetConsecutiveFailures() {
+  if (consecutiveFailureCount_.exchange(0) != 0) {
+    trackerMap_.removeSuspect(this);
+  }
+}
+
 bool TkoTracker::recordSuccess(ProxyDestinationBase* pdstn) {
   // If we're responsible, no one else can change any state and we're
   // effectively under mutex.
@@ -250,7 +261,7 @@ bool TkoTracker::recordSuccess(ProxyDestinationBase* pdstn) {
       decrementHardTkoCount(pdstn);
     }
     sumFailures_ = 0;
-    consecutiveFailureCount_ = 0;
+    resetConsecutiveFailures();
     tkoReason_.store(carbon::Result::UNKNOWN, std::memory_order_relaxed);
     return true;
   }
@@ -263,7 +274,7 @@ bool TkoTracker::recordSuccess(ProxyDestinationBase* pdstn) {
   // If we don't skip here we end up doing CAS on a shared state
   // every single request.
   if (sumFailures_ != 0 && setSumFailures(0)) {
-    consecutiveFailureCount_ = 0;
+    resetConsecutiveFailures();
   }
   return false;
 }
@@ -277,6 +288,7 @@ bool TkoTracker::removeDestination(ProxyDestinationBase* pdstn) {
 }
 
 TkoTracker::~TkoTracker() {
+  trackerMap_.removeSuspect(this);
   trackerMap_.removeTracker(key_);
 }
 
@@ -331,56 +343,38 @@ void TkoTrackerMap::updateTracker(
 std::unordered_map<std::string, std::pair<bool, size_t>>
 TkoTrackerMap::getSuspectServers() const {
   std::unordered_map<std::string, std::pair<bool, size_t>> result;
-  foreachTkoTracker(
-      [&result](folly::StringPiece key, const TkoTracker& tracker) mutable {
-        auto failures = tracker.consecutiveFailureCount();
-        if (failures > 0) {
-          result.emplace(key.str(), std::make_pair(tracker.isTko(), failures));
-        }
-      });
+  std::lock_guard<std::mutex> lock(suspectsMx_);
+  result.reserve(suspects_.size());
+  for (const auto* tracker : suspects_) {
+    // A racing success might have just reset the counter.
+    auto failures = tracker->consecutiveFailureCount();
+    if (failures > 0) {
+      result.emplace(
+          tracker->key_.str(), std::make_pair(tracker->isTko(), failures));
+    }
+  }
   return result;
 }
 
 size_t TkoTrackerMap::getSuspectServersCount() const {
   size_t result = 0;
-  foreachTkoTracker(
-      [&result](folly::StringPiece, const TkoTracker& tracker) mutable {
-        if (tracker.consecutiveFailureCount() > 0) {
-          ++result;
-        }
-      });
+  std::lock_guard<std::mutex> lock(suspectsMx_);
+  for (const auto* tracker : suspects_) {
+    if (tracker->consecutiveFailureCount() > 0) {
+      ++result;
+    }
+  }
   return result;
 }
 
-void TkoTrackerMap::foreachTkoTracker(
-    std::function<void(folly::StringPiece, const TkoTracker&)> func) const {
-  // We allocate a vector to delay the desctruction of TkoTrackers until after
-  // we release the lock. This is done to avoid the following race:
-  // After successfully locking the weak_ptr, we might become the last
-  // holder of the shared_ptr to TkoTracker. If that's the case, it would
-  // trigger destruction of TkoTracker, which would try to grab "mx_" and
-  // remove itself from the map.
-  // If we didn't have the lock, this would case two issues:
-  //  - We would try to lock "mx_" again from the same thread (which is UB).
-  //  - We would change "trackers_" while iterating over it.
-  std::vector<std::shared_ptr<TkoTracker>> lockedTrackers;
-  // Preallocate lockedTrackers
-  decltype(lockedTrackers)::size_type trackersCount;
-  {
-    std::lock_guard<std::mutex> lock(mx_);
-    trackersCount = trackers_.size();
-  }
-  lockedTrackers.reserve(trackersCount);
+void TkoTrackerMap::addSuspect(const TkoTracker* tracker) {
+  std::lock_guard<std::mutex> lock(suspectsMx_);
+  suspects_.insert(tracker);
+}
 
-  {
-    std::lock_guard<std::mutex> lock(mx_);
-    for (const auto& it : trackers_) {
-      if (auto tracker = it.second.lock()) {
-        func(it.first, *tracker);
-        lockedTrackers.emplace_back(std::move(tracker));
-      }
-    }
-  }
+void TkoTrackerMap::removeSuspect(const TkoTracker* tracker) noexcept {
+  std::lock_guard<std::mutex> lock(suspectsMx_);
+  suspects_.erase(tracker);
 }
 
 void TkoTrackerMap::removeTracker(folly::StringPiece key) noexcept {
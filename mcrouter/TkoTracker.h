@@ -8,7 +8,6 @@
 #pragma once
 
 #include <atomic>
-#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -16,6 +15,7 @@
 #include <utility>
 
 #include <folly/Range.h>
+#include <folly/container/F14Set.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 
 #include "mcrouter/TkoCounters.h"
@@ -231,6 +231,18 @@ class TkoTracker {
   /* Return true if this thread is responsible for the TKO state */
   bool isResponsible(ProxyDestinationBase* pdstn) const;
 
+  /**
+   * Bumps consecutiveFailureCount_, registering this tracker as suspect in
+   * trackerMap_ on the first failure.
+   */
+  void incrementConsecutiveFailures();
+
+  /**
+   * Resets consecutiveFailureCount_, unregistering this tracker from the
+   * suspect set in trackerMap_ if it had any failures.
+   */
+  void resetConsecutiveFailures();
+
   /**
    * @param tkoThreshold    Require this many soft failures to mark
    *                        the destination TKO.
@@ -273,6 +285,9 @@ class TkoTrackerMap {
    *     server ip => ( is server marked as TKO?, number of failures )
    *   }
    *   Only servers with positive number of failures will be returned.
+   *
+   * Only visits the incrementally maintained set of suspect trackers and
+   * doesn't take the lock that guards tracker creation and removal.
    */
   std::unordered_map<std::string, std::pair<bool, size_t>> getSuspectServers()
       const;
@@ -289,12 +304,17 @@ class TkoTrackerMap {
   // Total number of boxes marked as TKO.
   TkoCounters globalTkos_;
 
+  // Trackers with a positive number of consecutive failures. Maintained by
+  // the trackers themselves on failure/success transitions, so that stats
+  // don't have to scan every tracker. Entries are removed before a tracker
+  // is destroyed, so pointers are valid while suspectsMx_ is held.
+  mutable std::mutex suspectsMx_;
+  folly::F14FastSet<const TkoTracker*> suspects_;
+
   void removeTracker(folly::StringPiece key) noexcept;
 
-  // Thread-safe function that iterates over all tko trackers
-  void foreachTkoTracker(
-      const std::function<void(folly::StringPiece, const TkoTracker&)> func)
-      const;
+  void addSuspect(const TkoTracker* tracker);
+  void removeSuspect(const TkoTracker* tracker) noexcept;
 
   friend class TkoTracker;
 };
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "WorstDestinations.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+void sortByScore(std::vector<WorstDestinations::Item>& items) {
+  std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+    return a.score > b.score || (a.score == b.score && a.name < b.name);
+  });
+}
+
+} // namespace
+
+WorstDestinations::WorstDestinations(size_t capacity) : capacity_(capacity) {
+  assert(capacity_ > 0);
+  entries_.reserve(capacity_);
+}
+
+bool WorstDestinations::record(
+    const void* id,
+    bool tracked,
+    double score,
+    folly::FunctionRef<std::string()> name) {
+  if (!tracked && score <= minScore_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (tracked) {
+    for (auto& entry : entries_) {
+      if (entry.id == id) {
+        entry.item.score = score;
+        updateMinScore();
+        return true;
+      }
+    }
+    // Not found (e.g. the list was emptied), add it back like a new one.
+  }
+
+  if (entries_.size() < capacity_) {
+    entries_.push_back(Entry{id, Item{name(), score}});
+  } else {
+    auto min = std::min_element(
+        entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+          return a.item.score < b.item.score;
+        });
+    if (score <= min->item.score) {
+      return false;
+    }
+    *min = Entry{id, Item{name(), score}};
+  }
+  updateMinScore();
+  return true;
+}
+
+void WorstDestinations::remove(const void* id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(entries_.begin(), entries_.end(), [id](const auto& e) {
+    return e.id == id;
+  });
+  if (it != entries_.end()) {
+    entries_.erase(it);
+    updateMinScore();
+  }
+}
+
+std::vector<WorstDestinations::Item> WorstDestinations::snapshot() const {
+  std::vector<Item> items;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    items.reserve(entries_.size());
+    for (const auto& entry : entries_) {
+      items.push_back(entry.item);
+    }
+  }
+  sortByScore(items);
+  return items;
+}
+
+/* static */ std::vector<WorstDestinations::Item> WorstDestinations::merge(
+    const std::vector<std::vector<Item>>& snapshots,
+    size_t limit) {
+  folly::F14FastMap<std::string, double> scores;
+  for (const auto& snapshot : snapshots) {
+    for (const auto& item : snapshot) {
+      auto& score = scores[item.name];
+      score = std::max(score, item.score);
+    }
+  }
+  std::vector<Item> items;
+  items.reserve(scores.size());
+  for (auto& kv : scores) {
+    items.push_back(Item{kv.first, kv.second});
+  }
+  sortByScore(items);
+  if (items.size() > limit) {
+    items.resize(limit);
+  }
+  return items;
+}
+
+void WorstDestinations::updateMinScore() {
+  double minScore = 0.0;
+  if (entries_.size() == capacity_) {
+    minScore = entries_.front().item.score;
+    for (const auto& entry : entries_) {
+      minScore = std::min(minScore, entry.item.score);
+    }
+  }
+  minScore_.store(minScore, std::memory_order_relaxed);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/Function.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * The `capacity` destinations of a proxy with the highest score (e.g.
+ * latency penalized by errors), maintained on every reply so that slow
+ * hosts can be found without enumerating all destinations.
+ *
+ * A destination enters the list when its score is above the lowest tracked
+ * one, replacing it. Tracked destinations have their score updated on
+ * every record(), untracked ones with a score at most the lowest tracked
+ * one are rejected without taking the lock. A destination that got better
+ * only leaves the list when a worse one replaces it.
+ *
+ * The owning proxy is the only writer; readers on other threads (stats
+ * commands) take a snapshot.
+ */
+class WorstDestinations {
+ public:
+  struct Item {
+    std::string name;
+    double score{0.0};
+  };
+
+  explicit WorstDestinations(size_t capacity);
+
+  WorstDestinations(const WorstDestinations&) = delete;
+  WorstDestinations& operator=(const WorstDestinations&) = delete;
+
+  /**
+   * Records the current score of destination `id`.
+   *
+   * @param tracked  Whether `id` is in the list, as returned by the
+   *                 previous record() of `id`.
+   * @param name     Called to name `id` when it enters the list.
+   *
+   * @return  Whether `id` is in the list.
+   */
+  bool record(
+      const void* id,
+      bool tracked,
+      double score,
+      folly::FunctionRef<std::string()> name);
+
+  /**
+   * Drops `id` (e.g. on destruction) from the list.
+   */
+  void remove(const void* id);
+
+  /**
+   * @return  copy of all tracked destinations, sorted by descending score.
+   */
+  std::vector<Item> snapshot() const;
+
+  /**
+   * Merges snapshots of several lists (e.g. one per proxy), keeping the
+   * highest score of destinations present in several, and returns the
+   * `limit` worst destinations, sorted by descending score.
+   */
+  static std::vector<Item> merge(
+      const std::vector<std::vector<Item>>& snapshots,
+      size_t limit);
+
+ private:
+  struct Entry {
+    const void* id;
+    Item item;
+  };
+
+  const size_t capacity_;
+
+  mutable std::mutex mutex_;
+  std::vector<Entry> entries_;
+  // Lowest score in entries_ once it's full, 0 until then.
+  std::atomic<double> minScore_{0.0};
+
+  void updateMinScore();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <folly/Bits.h>
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Approximate count of how often keys were seen recently, to only let
+ * through keys seen at least `minHits` times (TinyLFU style admission).
+ *
+ * The counts are kept in a counting Bloom filter with kNumHashes small
+ * counters per key, about 4 * `capacity` bytes in total. A key's count is
+ * the smallest of its counters, so it can only be overestimated (by hash
+ * collisions), never underestimated. Only the smallest counters of a key
+ * are bumped, which keeps the overestimation low.
+ *
+ * After `capacity` keys were recorded, all the counters are halved, so
+ * that keys that stopped being requested are eventually forgotten.
+ *
+ * Not thread safe.
+ */
+class AdmissionFilter {
+ public:
+  static constexpr size_t kNumHashes = 4;
+  static constexpr uint8_t kMaxCount = 15;
+
+  AdmissionFilter(size_t capacity, uint32_t minHits)
+      : counters_(folly::nextPowTwo(std::max<size_t>(capacity, 16) * 4)),
+        minHits_(std::min<uint32_t>(minHits, kMaxCount)),
+        samplesUntilAging_(std::max<size_t>(capacity, 16)),
+        agingPeriod_(samplesUntilAging_) {}
+
+  /**
+   * Records an occurrence of `key`.
+   *
+   * @return  true if `key` was seen at least minHits times (this one
+   *          included) since it was last forgotten.
+   */
+  bool admit(folly::StringPiece key) {
+    uint64_t h1;
+    uint64_t h2;
+    folly::hash::SpookyHashV2::Hash128(key.data(), key.size(), &h1, &h2);
+    const size_t mask = counters_.size() - 1;
+    size_t idx[kNumHashes];
+    uint8_t count = kMaxCount;
+    for (size_t i = 0; i < kNumHashes; ++i) {
+      idx[i] = (h1 + i * h2) & mask;
+      count = std::min(count, counters_[idx[i]]);
+    }
+    if (count < kMaxCount) {
+      ++count;
+      for (size_t i = 0; i < kNumHashes; ++i) {
+        counters_[idx[i]] = std::max(counters_[idx[i]], count);
+      }
+    }
+
+    if (--samplesUntilAging_ == 0) {
+      for (auto& counter : counters_) {
+        counter /= 2;
+      }
+      samplesUntilAging_ = agingPeriod_;
+    }
+    return count >= minHits_;
+  }
+
+ private:
+  std::vector<uint8_t> counters_;
+  const uint8_t minHits_;
+  size_t samplesUntilAging_;
+  const size_t agingPeriod_;
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include <folly/fibers/FiberManager.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Sends requests whose replies nobody waits for (e.g. L1 updates from L2)
+ * to `target` in the background, from at most `maxSenders` fibers.
+ *
+ * Instead of a fiber per request, every sender fiber routes queued requests
+ * one after the other; requests of concurrent senders going to the same
+ * destination are written out together on its connection. At most
+ * `maxQueued` requests wait for a sender: when the target can't keep up,
+ * new requests are dropped rather than piling up.
+ *
+ * Not thread safe, must be used from a single fiber manager.
+ */
+template <class RouteHandleIf, class Request>
+class BackgroundRequestQueue
+    : public std::enable_shared_from_this<
+          BackgroundRequestQueue<RouteHandleIf, Request>> {
+ public:
+  BackgroundRequestQueue(
+      std::shared_ptr<RouteHandleIf> target,
+      size_t maxQueued,
+      size_t maxSenders)
+      : target_(std::move(target)),
+        maxQueued_(maxQueued),
+        maxSenders_(std::max<size_t>(maxSenders, 1)) {}
+
+  /**
+   * @return  false if the request was dropped because the queue is full.
+   */
+  bool enqueue(Request req) {
+    if (queue_.size() >= maxQueued_) {
+      ++numDropped_;
+      return false;
+    }
+    queue_.push_back(std::move(req));
+    if (numSenders_ < maxSenders_) {
+      ++numSenders_;
+      folly::fibers::addTask(
+          [self = this->shared_from_this()]() { self->send(); });
+    }
+    return true;
+  }
+
+  size_t size() const {
+    return queue_.size();
+  }
+
+  uint64_t numDropped() const {
+    return numDropped_;
+  }
+
+ private:
+  // A sender keeps the fiber locals (e.g. the request context) of the
+  // request that started it, so it only routes that many requests unless
+  // no other sender is left to pick up the queue.
+  static constexpr size_t kMaxRequestsPerSender = 64;
+
+  const std::shared_ptr<RouteHandleIf> target_;
+  const size_t maxQueued_;
+  const size_t maxSenders_;
+
+  std::deque<Request> queue_;
+  size_t numSenders_{0};
+  uint64_t numDropped_{0};
+
+  void send() {
+    size_t numSent = 0;
+    while (!queue_.empty() &&
+           (numSent < kMaxRequestsPerSender || numSenders_ == 1)) {
+      auto req = std::move(queue_.front());
+      queue_.pop_front();
+      target_->route(req);
+      ++numSent;
+    }
+    --numSenders_;
+  }
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -8,9 +8,11 @@
 #include "Compression.h"
 
 #include <memory>
+#include <stdexcept>
 
 #include <folly/Format.h>
 #include <folly/Portability.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 
 #include "mcrouter/lib/IovecCursor.h"
@@ -61,6 +63,21 @@ std::unique_ptr<folly::IOBuf> CompressionCodec::uncompress(
   return uncompress(&iov, 1, uncompressedLength);
 }
 
+void CompressionCodec::uncompressInto(
+    const struct iovec* iov,
+    size_t iovcnt,
+    void* dest,
+    size_t uncompressedLength) {
+  auto data = uncompress(iov, iovcnt, uncompressedLength);
+  if (!data || data->computeChainDataLength() != uncompressedLength) {
+    throw std::runtime_error(folly::sformat(
+        "Uncompressed data doesn't have the expected size of {} bytes",
+        uncompressedLength));
+  }
+  folly::io::Cursor(data.get())
+      .pull(reinterpret_cast<uint8_t*>(dest), uncompressedLength);
+}
+
 namespace {
 
 std::unique_ptr<folly::IOBuf> wrapIovec(
@@ -122,6 +122,28 @@ class CompressionCodec {
   std::unique_ptr<folly::IOBuf>
   uncompress(const void* data, size_t len, size_t uncompressedLength = 0);
 
+  /**
+   * Uncompress data into a buffer provided by the caller.
+   *
+   * The default implementation uncompresses into a new IOBuf and copies it
+   * out; codecs that can write directly into 'dest' override it.
+   *
+   * @param iov                 Iovec array containing the data to uncompress.
+   * @param iovcnt              Size of the array.
+   * @param dest                Buffer with room for 'uncompressedLength'
+   *                            bytes.
+   * @param uncompressedLength  Exact size of the uncompressed data.
+   *
+   * @throw std::runtime_error    On uncompresion error, or if the data
+   *                              doesn't uncompress to exactly
+   *                              'uncompressedLength' bytes.
+   */
+  virtual void uncompressInto(
+      const struct iovec* iov,
+      size_t iovcnt,
+      void* dest,
+      size_t uncompressedLength);
+
   /**
    * Return the codec's type.
    */
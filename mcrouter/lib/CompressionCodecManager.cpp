@@ -10,6 +10,7 @@
 #include <algorithm>
 
 #include <folly/Format.h>
+#include <folly/Likely.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/IOBuf.h>
 
@@ -87,14 +88,86 @@ CompressionCodecManager::CompressionCodecManager(
 }
 
 const CompressionCodecMap* CompressionCodecManager::getCodecMap() const {
-  return compressionCodecMap_.get();
+  auto map = compressionCodecMap_.get();
+  map->refreshIfStale();
+  return map;
+}
+
+bool CompressionCodecManager::addCodecConfig(CodecConfigPtr config) {
+  try {
+    // createCompressionCodec throws if the dictionary is invalid.
+    folly::fibers::runInMainContext([&config]() {
+      createCompressionCodec(
+          config->codecType,
+          folly::IOBuf::wrapBuffer(
+              config->dictionary.data(), config->dictionary.size()),
+          config->id,
+          config->filteringOptions,
+          config->compressionLevel);
+    });
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Compression codec config [" << config->id
+               << "] is invalid: " << e.what();
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto id = config->id;
+  if (size_ == 0) {
+    if (id == 0) {
+      return false;
+    }
+    smallestCodecId_ = id;
+  } else if (id != smallestCodecId_ + size_) {
+    return false;
+  }
+  codecConfigs_[id] = std::move(config);
+  ++size_;
+  version_.fetch_add(1, std::memory_order_acq_rel);
+  LOG(INFO) << "Added compression codec " << id << " (range: ["
+            << smallestCodecId_ << ", " << smallestCodecId_ + size_ - 1
+            << "])";
+  return true;
+}
+
+uint32_t CompressionCodecManager::nextCodecId() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Codec id 0 means "not compressed" on the wire.
+  return size_ == 0 ? 1 : smallestCodecId_ + size_;
+}
+
+std::unique_ptr<CodecConfig> CompressionCodecManager::latestCodecConfig(
+    CompressionCodecType type) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int64_t id = int64_t(smallestCodecId_) + size_ - 1;
+       size_ > 0 && id >= smallestCodecId_;
+       --id) {
+    const auto& config = codecConfigs_.at(id);
+    if (config->codecType == type) {
+      return std::make_unique<CodecConfig>(
+          config->id,
+          config->codecType,
+          config->dictionary,
+          config->filteringOptions,
+          config->compressionLevel);
+    }
+  }
+  return nullptr;
 }
 
 CompressionCodecMap* CompressionCodecManager::buildCodecMap() {
+  std::lock_guard<std::mutex> lock(mutex_);
   if (size_ == 0) {
-    return new CompressionCodecMap();
+    return new CompressionCodecMap(*this);
   }
-  return new CompressionCodecMap(codecConfigs_, smallestCodecId_, size_);
+  return new CompressionCodecMap(
+      *this, codecConfigs_, smallestCodecId_, size_, version());
+}
+
+void CompressionCodecManager::refreshCodecMap(
+    const CompressionCodecMap& map) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  map.extend(codecConfigs_, smallestCodecId_, size_, version());
 }
 
 /****************
@@ -108,35 +181,67 @@ const CodecIdRange CodecIdRange::Empty = CodecIdRange{1, 0};
 CompressionCodecMap::CompressionCodecMap() noexcept {}
 
 CompressionCodecMap::CompressionCodecMap(
+    const CompressionCodecManager& manager) noexcept
+    : manager_(&manager) {}
+
+CompressionCodecMap::CompressionCodecMap(
+    const CompressionCodecManager& manager,
     const std::unordered_map<uint32_t, CodecConfigPtr>& codecConfigs,
     uint32_t smallestCodecId,
-    uint32_t size)
-    : firstId_(smallestCodecId) {
+    uint32_t size,
+    uint64_t version)
+    : firstId_(smallestCodecId), manager_(&manager) {
   assert(codecConfigs.size() >= size);
+  extend(codecConfigs, smallestCodecId, size, version);
+}
 
-  codecs_.resize(size);
-  size_t maxTypeId = 0;
-  for (uint32_t id = firstId_; id < (firstId_ + size); ++id) {
+void CompressionCodecMap::extend(
+    const std::unordered_map<uint32_t, CodecConfigPtr>& codecConfigs,
+    uint32_t smallestCodecId,
+    uint32_t size,
+    uint64_t version) const {
+  if (codecs_.empty()) {
+    firstId_ = smallestCodecId;
+  }
+  assert(firstId_ == smallestCodecId);
+
+  for (uint32_t id = firstId_ + codecs_.size(); id < (firstId_ + size); ++id) {
     const auto& it = codecConfigs.find(id);
     CHECK(it != codecConfigs.end()) << "Dictionary " << id << " is missing!";
     const auto& config = it->second;
-    maxTypeId = std::max(maxTypeId, config->filteringOptions.typeId);
-    codecs_[index(id)] = createCompressionCodec(
+    auto codec = createCompressionCodec(
         config->codecType,
         folly::IOBuf::wrapBuffer(
             config->dictionary.data(), config->dictionary.size()),
         id,
         config->filteringOptions,
         config->compressionLevel);
+    auto typeId = codec->filteringOptions().typeId;
+    if (typeId >= codecsIdByTypeId_.size()) {
+      codecsIdByTypeId_.resize(typeId + 1);
+    }
+    codecsIdByTypeId_[typeId].push_back(id);
+    codecs_.push_back(std::move(codec));
   }
-  codecsIdByTypeId_.resize(maxTypeId + 1);
-  for (uint32_t i = 0; i < size; ++i) {
-    codecsIdByTypeId_[codecs_[i]->filteringOptions().typeId].push_back(
-        codecs_[i]->id());
+  version_ = version;
+}
+
+void CompressionCodecMap::refreshIfStale() const noexcept {
+  if (FOLLY_LIKELY(!manager_ || manager_->version() == version_)) {
+    return;
+  }
+  try {
+    folly::fibers::runInMainContext(
+        [this]() { manager_->refreshCodecMap(*this); });
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to add new compression codecs: " << e.what();
   }
 }
 
 CompressionCodec* CompressionCodecMap::get(uint32_t id) const noexcept {
+  if (id < firstId_ || index(id) >= size()) {
+    refreshIfStale();
+  }
   if (id < firstId_ || index(id) >= size()) {
     return nullptr;
   }
@@ -168,6 +273,7 @@ CompressionCodec* CompressionCodecMap::getBest(
     const CodecIdRange& codecRange,
     const size_t bodySize,
     const size_t typeId) const noexcept {
+  refreshIfStale();
   auto codec = getBestByTypeId(codecRange, bodySize, typeId);
   if (codec == nullptr) {
     codec = getBestByTypeId(codecRange, bodySize, 0 /* generic */);
@@ -7,9 +7,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -60,7 +62,38 @@ class CompressionCodecManager {
    */
   const CompressionCodecMap* getCodecMap() const;
 
+  /**
+   * Adds a new codec at runtime (e.g. a freshly trained dictionary). Codec
+   * maps already handed out pick it up lazily, on their next lookup.
+   *
+   * Codecs are never replaced: the id must be nextCodecId(), so that peers
+   * that still use older dictionaries keep working.
+   * Note: thread-safe.
+   *
+   * @return  false if the id is not nextCodecId() or the codec is invalid.
+   */
+  bool addCodecConfig(CodecConfigPtr config);
+
+  /**
+   * Id that the next codec added with addCodecConfig() must have.
+   */
+  uint32_t nextCodecId() const;
+
+  /**
+   * Copy of the config of the newest codec of the given type, if any.
+   */
+  std::unique_ptr<CodecConfig> latestCodecConfig(
+      CompressionCodecType type) const;
+
+  /**
+   * Incremented every time a codec is added.
+   */
+  uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
  private:
+  mutable std::mutex mutex_;
   // Storage of compression codec configs (codecId -> codecConfig).
   std::unordered_map<uint32_t, CodecConfigPtr> codecConfigs_;
   // ThreadLocal of compression codec map, as codecs are not thread-safe.
@@ -68,8 +101,16 @@ class CompressionCodecManager {
   // Codec id range
   uint32_t smallestCodecId_{0};
   uint32_t size_{0};
+  std::atomic<uint64_t> version_{0};
 
   CompressionCodecMap* buildCodecMap();
+
+  /**
+   * Adds codecs created after `map` was built to it.
+   */
+  void refreshCodecMap(const CompressionCodecMap& map) const;
+
+  friend class CompressionCodecMap;
 };
 
 /**
@@ -124,19 +165,29 @@ class CompressionCodecMap {
    * Returns the range (firstId, size) of codec ids present in this map.
    */
   const CodecIdRange getIdRange() const noexcept {
+    refreshIfStale();
     return {firstId_, size()};
   }
 
  private:
-  std::vector<std::unique_ptr<CompressionCodec>> codecs_;
-  std::vector<std::vector<uint32_t>> codecsIdByTypeId_;
-  const uint32_t firstId_{0};
+  // Codecs are only ever appended (see CompressionCodecManager::
+  // addCodecConfig()), so pointers returned by get() stay valid.
+  mutable std::vector<std::unique_ptr<CompressionCodec>> codecs_;
+  mutable std::vector<std::vector<uint32_t>> codecsIdByTypeId_;
+  mutable uint32_t firstId_{0};
+  const CompressionCodecManager* manager_{nullptr};
+  mutable uint64_t version_{0};
 
   /**
    * Builds an empty codec map.
    */
   CompressionCodecMap() noexcept;
 
+  /**
+   * Builds an empty codec map that follows codecs added to `manager`.
+   */
+  explicit CompressionCodecMap(const CompressionCodecManager& manager) noexcept;
+
   /**
    * Builds a map containing codecs which the ids are within the given range.
    * Note: All codecs in the [smallestCodecId, smallestCodecIdtId + size]
@@ -144,15 +195,31 @@ class CompressionCodecMap {
    * Note: createCompressionCodec may throw exceptions when failing to load
    *       compression codecs of specific type.
    *
+   * @param manager            Manager owning the configs, used to pick up
+   *                           codecs added later.
    * @param codecConfigs       Map of (codecId -> codecConfig). Must contain all
    *                           codecs in the given range.
    * @param smallestCodecId    First id of the range of codecs.
    * @param size               Size of the range.
+   * @param version            Manager version the configs correspond to.
    */
   CompressionCodecMap(
+      const CompressionCodecManager& manager,
       const std::unordered_map<uint32_t, CodecConfigPtr>& codecConfigs,
       uint32_t smallestCodecId,
-      uint32_t size);
+      uint32_t size,
+      uint64_t version);
+
+  /**
+   * Creates the codecs in [firstId_ + size(), smallestCodecId + size).
+   */
+  void extend(
+      const std::unordered_map<uint32_t, CodecConfigPtr>& codecConfigs,
+      uint32_t smallestCodecId,
+      uint32_t size,
+      uint64_t version) const;
+
+  void refreshIfStale() const noexcept;
 
   /**
    * Get the compression codec that best matches the filters considering
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * FIFO queue of items per key (e.g. per client), popped round robin across
+ * the keys that have items waiting. This is deficit round robin with every
+ * item costing the same: a key with a burst of items only delays each of
+ * the others by one item per round, instead of by its whole burst.
+ *
+ * With a single key, a plain FIFO. Not thread safe.
+ */
+template <class T>
+class FairQueue {
+ public:
+  void push(uint64_t key, T item) {
+    auto& queue = queues_[key];
+    if (queue.empty()) {
+      active_.push_back(key);
+    }
+    queue.push_back(std::move(item));
+    ++size_;
+  }
+
+  /**
+   * Pops the oldest item of the next key in turn. Must not be empty().
+   */
+  T pop() {
+    assert(!empty());
+    const auto key = active_.front();
+    active_.pop_front();
+    auto it = queues_.find(key);
+    assert(it != queues_.end());
+    auto item = std::move(it->second.front());
+    it->second.pop_front();
+    if (it->second.empty()) {
+      queues_.erase(it);
+    } else {
+      active_.push_back(key);
+    }
+    --size_;
+    return item;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  /**
+   * Number of keys with items waiting.
+   */
+  size_t numKeys() const {
+    return active_.size();
+  }
+
+ private:
+  folly::F14FastMap<uint64_t, std::deque<T>> queues_;
+  // Keys with items waiting, in the order they get their next turn.
+  std::deque<uint64_t> active_;
+  size_t size_{0};
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <limits>
 #include <utility>
+#include <vector>
 
 #include <folly/Conv.h>
 #include <folly/Range.h>
@@ -63,9 +66,10 @@ class HashSelector : public HashSelectorBase<HashFunc> {
 
   template <class Request>
   size_t select(const Request& req, size_t size) const {
+    size_t cachedHash;
     if (!this->hasSalt() &&
-        req.key_ref()->reuseLastHash(size, HashFunc::typeId())) {
-      return req.key_ref()->getLastHash();
+        req.key_ref()->getCachedHash(size, HashFunc::typeId(), cachedHash)) {
+      return cachedHash;
     }
     // Hash functions can be stack-intensive, so jump back to the main context
     auto hash = folly::fibers::runInMainContext([this, &req, size]() {
@@ -74,7 +78,7 @@ class HashSelector : public HashSelectorBase<HashFunc> {
       return this->selectInternal(req.key_ref()->routingKey(), size);
     });
     if (!this->hasSalt()) {
-      req.key_ref()->setLastHash(hash, size, HashFunc::typeId());
+      req.key_ref()->cacheHash(hash, size, HashFunc::typeId());
     }
     return hash;
   }
@@ -83,8 +87,32 @@ class HashSelector : public HashSelectorBase<HashFunc> {
 template <class HashFunc, class RouterInfo>
 class BucketHashSelector : public HashSelectorBase<HashFunc> {
  public:
-  BucketHashSelector(std::string salt, HashFunc hashFunc)
-      : HashSelectorBase<HashFunc>(std::move(salt), std::move(hashFunc)) {}
+  // Upper bound on the size of the precomputed table (16MB).
+  static constexpr size_t kMaxPrecomputedBuckets = 1 << 22;
+
+  /**
+   * @param numPrecomputedBuckets  Destinations of buckets [0, this number)
+   *                               are computed upfront, for a `size` long
+   *                               list of destinations.
+   */
+  BucketHashSelector(
+      std::string salt,
+      HashFunc hashFunc,
+      size_t numPrecomputedBuckets = 0,
+      size_t size = 0)
+      : HashSelectorBase<HashFunc>(std::move(salt), std::move(hashFunc)),
+        size_(size) {
+    numPrecomputedBuckets =
+        std::min(numPrecomputedBuckets, kMaxPrecomputedBuckets);
+    if (size_ == 0 || size_ > std::numeric_limits<uint32_t>::max()) {
+      return;
+    }
+    bucketToIndex_.reserve(numPrecomputedBuckets);
+    for (size_t bucketId = 0; bucketId < numPrecomputedBuckets; ++bucketId) {
+      bucketToIndex_.push_back(
+          this->selectInternal(folly::to<std::string>(bucketId), size_));
+    }
+  }
 
   template <class Request>
   size_t select(const Request& /*req*/, size_t size) const {
@@ -92,12 +120,19 @@ class BucketHashSelector : public HashSelectorBase<HashFunc> {
     checkRuntime(
         bucketId.has_value(),
         "The context doesn't contain bucket id. You must use McBucketRoute in front of bucketized PoolRoute");
+    if (FOLLY_LIKELY(*bucketId < bucketToIndex_.size() && size == size_)) {
+      return bucketToIndex_[*bucketId];
+    }
     // Hash functions can be stack-intensive, so jump back to the main context
     return folly::fibers::runInMainContext(
         [this, size, bucketId = folly::to<std::string>(*bucketId)]() {
           return this->selectInternal(bucketId, size);
         });
   }
+
+ private:
+  const size_t size_;
+  std::vector<uint32_t> bucketToIndex_;
 };
 
 } // namespace memcache
@@ -485,8 +485,22 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
     const struct iovec* iov,
     size_t iovcnt,
     size_t uncompressedSize) const noexcept {
+  auto destination = folly::IOBuf::create(uncompressedSize);
+  if (!decompressInto(
+          iov, iovcnt, destination->writableTail(), uncompressedSize)) {
+    return nullptr;
+  }
+  destination->append(uncompressedSize);
+  return destination;
+}
+
+bool Lz4Immutable::decompressInto(
+    const struct iovec* iov,
+    size_t iovcnt,
+    void* dest,
+    size_t uncompressedSize) const noexcept {
   if (FOLLY_UNLIKELY(uncompressedSize == 0)) {
-    return folly::IOBuf::create(0);
+    return true;
   }
 
   // Creates a match cursor - a cursor that will keep track of matches
@@ -494,14 +508,11 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
   struct iovec dicIov = getDictionaryIovec(state_);
   const IovecCursor dicCursor(&dicIov, 1);
 
-  // Destination (uncompressed) buffer.
-  auto destination = folly::IOBuf::create(uncompressedSize);
   // Pointer to where the next uncompressed position should be written.
-  uint8_t* output = destination->writableTail();
+  uint8_t* output = reinterpret_cast<uint8_t*>(dest);
   // Lower and upper limit to where the output buffer can go.
   const uint8_t* outputStart = output;
   const uint8_t* outputLimit = output + uncompressedSize;
-  (void)outputLimit;
 
   IovecCursor source(iov, iovcnt);
   IovecCursor match = dicCursor;
@@ -522,17 +533,17 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
     }
 
     // Copy literals
-    uint8_t* cpy = output + literalLength;
-    if (cpy > outputLimit - kCopyLength) {
-      if (cpy != outputLimit) {
-        return nullptr;
+    if (literalLength > static_cast<size_t>(outputLimit - output) ||
+        output + literalLength > outputLimit - kCopyLength) {
+      if (output + literalLength != outputLimit) {
+        return false;
       }
       safeCopy(output, source, literalLength);
       output += literalLength;
       break; // Necessarily EOF, due to parsing restrictions
     }
     safeCopy(output, source, literalLength);
-    output = cpy;
+    output += literalLength;
 
     // Get match offset
     uint16_t offset = peekLE(source);
@@ -550,14 +561,19 @@ std::unique_ptr<folly::IOBuf> Lz4Immutable::decompress(
     }
     matchLength += kMinMatch;
 
+    // The output buffer may belong to the caller, so never write past it.
+    if (FOLLY_UNLIKELY(
+            matchLength > static_cast<size_t>(outputLimit - output))) {
+      return false;
+    }
+
     // Copy match
     match.seek(matchPos);
     safeCopy(output, match, matchLength);
     output += matchLength;
   }
 
-  destination->append(output - outputStart);
-  return destination;
+  return output == outputLimit;
 }
 
 } // namespace memcache
@@ -102,6 +102,26 @@ class Lz4Immutable {
       size_t iovcnt,
       size_t uncompressedSize) const noexcept;
 
+  /**
+   * Decompress the data into a buffer provided by the caller, saving the
+   * allocation of the output IOBuf.
+   *
+   * @param iov               Array of iovec describing the compressed data.
+   * @param iovcnt            Number of elements in 'iov'.
+   * @param dest              Destination buffer. Must have room for at least
+   *                          'uncompressedSize' bytes.
+   * @param uncompressedSize  Original size (i.e. size of the data
+   *                          before compression).
+   * @return                  True on success. On error, the contents of
+   *                          'dest' are unspecified, but nothing is written
+   *                          past 'dest' + 'uncompressedSize'.
+   */
+  bool decompressInto(
+      const struct iovec* iov,
+      size_t iovcnt,
+      void* dest,
+      size_t uncompressedSize) const noexcept;
+
   // Read-only access to the immutable dictionary.
   const folly::IOBuf& dictionary() const {
     return *state_.dictionary;
@@ -7,6 +7,8 @@
 
 #include "Lz4ImmutableCompressionCodec.h"
 
+#include <stdexcept>
+
 namespace facebook {
 namespace memcache {
 
@@ -35,5 +37,15 @@ std::unique_ptr<folly::IOBuf> Lz4ImmutableCompressionCodec::uncompress(
   return codec_.decompress(iov, iovcnt, uncompressedSize);
 }
 
+void Lz4ImmutableCompressionCodec::uncompressInto(
+    const struct iovec* iov,
+    size_t iovcnt,
+    void* dest,
+    size_t uncompressedSize) {
+  if (!codec_.decompressInto(iov, iovcnt, dest, uncompressedSize)) {
+    throw std::runtime_error("Lz4Immutable: failed to uncompress data");
+  }
+}
+
 } // namespace memcache
 } // namespace facebook
@@ -29,6 +29,12 @@ class Lz4ImmutableCompressionCodec : public CompressionCodec {
       size_t iovcnt,
       size_t uncompressedSize) final;
 
+  void uncompressInto(
+      const struct iovec* iov,
+      size_t iovcnt,
+      void* dest,
+      size_t uncompressedSize) final;
+
  private:
   Lz4Immutable codec_;
 };
@@ -7,6 +7,8 @@
 
 #include "MessageQueue.h"
 
+#include <folly/portability/Asm.h>
+
 namespace facebook {
 namespace memcache {
 
@@ -14,9 +16,11 @@ Notifier::Notifier(
     size_t noNotifyRate,
     int64_t waitThreshold,
     NowUsecFunc nowFunc,
-    std::function<bool(bool)> postDrainCallback) noexcept
+    std::function<bool(bool)> postDrainCallback,
+    int64_t spinPollUs) noexcept
     : noNotifyRate_(noNotifyRate),
       waitThreshold_(waitThreshold),
+      spinPollUs_(spinPollUs),
       nowFunc_(nowFunc),
       postDrainCallback_(std::move(postDrainCallback)),
       lastTimeUsec_(nowFunc_()),
@@ -35,6 +39,19 @@ bool Notifier::shouldNotifyRelaxed() noexcept {
   return false;
 }
 
+bool Notifier::spinPoll() noexcept {
+  auto start = nowFunc_();
+  do {
+    if (state_.load(std::memory_order_acquire) != State::READING) {
+      // A writer saw READING state and skipped the notification.
+      spinWakeupsAvoided_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    folly::asm_volatile_pause();
+  } while (nowFunc_() - start < spinPollUs_);
+  return false;
+}
+
 void Notifier::maybeUpdatePeriod() noexcept {
   if (noNotifyRate_ == 0) {
     return;
@@ -47,12 +47,18 @@ class Notifier {
    *   if we're out of drain loop. It should return true if it can guarantee
    *   that the current event_base_loop won't block, false otherwise. The return
    *   value is used as a hint for avoiding unnecessary notifications.
+   *
+   * @param spinPollUs  After the queue is drained, keep polling it for up to
+   *   this number of us before going idle. Writers that enqueue while we're
+   *   polling don't need to notify.
+   *   If 0, this logic is disabled.
    */
   Notifier(
       size_t noNotifyRate,
       int64_t waitThresholdUs,
       NowUsecFunc nowFunc,
-      std::function<bool(bool)> postDrainCallback = nullptr) noexcept;
+      std::function<bool(bool)> postDrainCallback = nullptr,
+      int64_t spinPollUs = 0) noexcept;
 
   void bumpMessages() noexcept {
     ++curMessages_;
@@ -83,6 +89,9 @@ class Notifier {
       state_.store(State::READING, std::memory_order_release);
       drainFunc();
       nonBlockingLoop = postDrainCallback_ ? postDrainCallback_(false) : false;
+      if (!nonBlockingLoop && spinPollUs_ > 0 && spinPoll()) {
+        continue;
+      }
     } while (state_.load(std::memory_order_acquire) != State::READING ||
              (!nonBlockingLoop &&
               !state_.compare_exchange_strong(
@@ -104,9 +113,18 @@ class Notifier {
     return noNotifyRate_;
   }
 
+  /**
+   * @return Number of times spin polling picked up a new message that would
+   *   otherwise have required an eventfd notification.
+   */
+  uint64_t spinWakeupsAvoided() const noexcept {
+    return spinWakeupsAvoided_.load(std::memory_order_relaxed);
+  }
+
  private:
   const size_t noNotifyRate_;
   const int64_t waitThreshold_;
+  const int64_t spinPollUs_;
   const NowUsecFunc nowFunc_;
   std::function<bool(bool)> postDrainCallback_;
   int64_t lastTimeUsec_;
@@ -129,6 +147,14 @@ class Notifier {
 
   alignas(
       folly::hardware_destructive_interference_size) std::atomic<State> state_;
+
+  std::atomic<uint64_t> spinWakeupsAvoided_{0};
+
+  /**
+   * Polls the state for up to spinPollUs_ while in READING state.
+   * @return true if a writer enqueued a message in the meantime.
+   */
+  bool spinPoll() noexcept;
 };
 
 template <class T>
@@ -153,6 +179,9 @@ class MessageQueue {
    *   event is posted.
    * @param postDrainCallback  Callback that will be called during the queue
    *   drain phase. See Notifier for more details.
+   * @param spinPollUs  Keep polling the queue for this number of us after
+   *   it was drained, before falling back to eventfd notifications.
+   *   If 0, this logic is disabled.
    */
   MessageQueue(
       size_t capacity,
@@ -161,14 +190,16 @@ class MessageQueue {
       int64_t waitThreshold,
       Notifier::NowUsecFunc nowFunc,
       std::function<void()> notifyCallback,
-      std::function<bool(bool)> postDrainCallback = nullptr)
+      std::function<bool(bool)> postDrainCallback = nullptr,
+      int64_t spinPollUs = 0)
       : queue_(capacity),
         onMessage_(std::move(onMessage)),
         notifier_(
             noNotifyRate,
             waitThreshold,
             nowFunc,
-            std::move(postDrainCallback)),
+            std::move(postDrainCallback),
+            spinPollUs),
         handler_(*this),
         notifyCallback_(std::move(notifyCallback)) {
     efd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
@@ -224,6 +255,10 @@ class MessageQueue {
     return notifier_.currentNotifyPeriod();
   }
 
+  uint64_t spinWakeupsAvoided() const noexcept {
+    return notifier_.spinWakeupsAvoided();
+  }
+
   /**
    * Must be called from the event base thread.
    * Manually drains the queue, calling the callback on any remaining messages.
@@ -292,6 +327,15 @@ class MessageQueue {
     return queue_.isFull();
   }
 
+  /**
+   * Approximate number of messages in the queue. Can be called from any
+   * thread.
+   */
+  size_t size() const noexcept {
+    auto size = queue_.size();
+    return size > 0 ? static_cast<size_t>(size) : 0;
+  }
+
  private:
   static constexpr int64_t kWakeupEveryMs = 2;
   folly::MPMCQueue<T> queue_;
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include <folly/Range.h>
+#include <folly/container/F14Set.h>
+#include <folly/hash/SpookyHashV2.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Remembers the keys seen during the last `window`, to drop repeated
+ * requests for the same key.
+ *
+ * Keys are kept as 64-bit hashes in two generations of half a window each,
+ * so a key is remembered for at least half a window and at most a full one.
+ * Unlike a Bloom filter there are no false positives besides hash
+ * collisions, so a request for a key not seen recently is never dropped.
+ * A generation holding `maxKeys` keys is retired early, which only makes
+ * keys be forgotten sooner.
+ *
+ * Not thread safe.
+ */
+class RecentKeyFilter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  RecentKeyFilter(std::chrono::milliseconds window, size_t maxKeys)
+      : generationLength_(window / 2), maxKeys_(maxKeys) {}
+
+  /**
+   * @return  true if `key` was seen recently; otherwise remembers it and
+   *          returns false.
+   */
+  bool seenRecently(
+      folly::StringPiece key,
+      Clock::time_point now = Clock::now()) {
+    if (now - currentStart_ >= generationLength_ ||
+        current_.size() >= maxKeys_) {
+      if (now - currentStart_ >= 2 * generationLength_) {
+        previous_.clear();
+        current_.clear();
+      } else {
+        previous_ = std::move(current_);
+        current_.clear();
+      }
+      currentStart_ = now;
+    }
+
+    const auto hash = folly::hash::SpookyHashV2::Hash64(
+        key.data(), key.size(), 0 /* seed */);
+    if (current_.count(hash) || previous_.count(hash)) {
+      return true;
+    }
+    current_.insert(hash);
+    return false;
+  }
+
+ private:
+  const Clock::duration generationLength_;
+  const size_t maxKeys_;
+
+  Clock::time_point currentStart_{Clock::now()};
+  folly::F14FastSet<uint64_t> current_;
+  folly::F14FastSet<uint64_t> previous_;
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include <folly/Optional.h>
@@ -72,5 +73,44 @@ typename RouterInfo::RouteHandlePtr createSelectionRoute(
       seed);
 }
 
+/**
+ * Constructs a SelectionRoute without shadows, like createSelectionRoute().
+ * If every child was created as a `Route` (through makeRouteHandle*()),
+ * the children are called directly rather than through the virtual
+ * RouteHandleIf interface (see TypedSelectionRoute).
+ *
+ * @param children  List of children route handles.
+ * @param selector  Selector responsible for choosing the child.
+ */
+template <class RouterInfo, class Route, class Selector>
+typename RouterInfo::RouteHandlePtr createSelectionRouteForChildType(
+    std::vector<typename RouterInfo::RouteHandlePtr> children,
+    Selector selector) {
+  using Child = typename RouterInfo::RouteHandleIf::template Impl<Route>;
+
+  std::vector<std::shared_ptr<Child>> typedChildren;
+  typedChildren.reserve(children.size());
+  for (const auto& child : children) {
+    auto typedChild = std::dynamic_pointer_cast<Child>(child);
+    if (!typedChild) {
+      return createSelectionRoute<RouterInfo, Selector>(
+          std::move(children), std::move(selector));
+    }
+    typedChildren.push_back(std::move(typedChild));
+  }
+  if (typedChildren.empty()) {
+    return createSelectionRoute<RouterInfo, Selector>(
+        std::move(children), std::move(selector));
+  }
+  return makeRouteHandleWithInfo<
+      RouterInfo,
+      TypedSelectionRoute,
+      Selector,
+      Child>(
+      std::move(typedChildren),
+      std::move(selector),
+      mcrouter::createErrorRoute<RouterInfo>("Invalid destination index."));
+}
+
 } // namespace memcache
 } // namespace facebook
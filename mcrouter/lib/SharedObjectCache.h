@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Cache of immutable objects keyed by a description of their content.
+ *
+ * Every proxy builds its own copy of the route tree, so stateless data derived
+ * from the config (e.g. hash function tables) ends up built num_proxies times.
+ * Routes can use this cache to build such data once and share the same
+ * instance between proxies.
+ *
+ * Objects are held weakly: an object is destroyed once the last route using it
+ * is gone, and the next config build will create it again. The factory runs
+ * under the cache lock, so concurrent builders of the same object wait for
+ * the first one instead of duplicating work.
+ */
+template <class T>
+class SharedObjectCache {
+ public:
+  SharedObjectCache() = default;
+  SharedObjectCache(const SharedObjectCache&) = delete;
+  SharedObjectCache& operator=(const SharedObjectCache&) = delete;
+
+  /**
+   * @param key      Must fully determine the object created by `factory`.
+   * @param factory  Called without arguments, returns T (or something
+   *                 convertible to std::shared_ptr<const T>).
+   */
+  template <class Factory>
+  std::shared_ptr<const T> getOrCreate(std::string key, Factory&& factory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = objects_[std::move(key)];
+    if (auto object = entry.lock()) {
+      return object;
+    }
+    std::shared_ptr<const T> object = makeShared(factory());
+    entry = object;
+    if (objects_.size() >= 2 * sizeAfterPrune_) {
+      pruneExpired();
+    }
+    return object;
+  }
+
+  /**
+   * Number of entries, including the ones whose object was already released.
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return objects_.size();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  folly::F14NodeMap<std::string, std::weak_ptr<const T>> objects_;
+  size_t sizeAfterPrune_{1};
+
+  static std::shared_ptr<const T> makeShared(std::shared_ptr<const T> object) {
+    return object;
+  }
+  static std::shared_ptr<const T> makeShared(T&& object) {
+    return std::make_shared<const T>(std::move(object));
+  }
+
+  void pruneExpired() {
+    for (auto it = objects_.begin(); it != objects_.end();) {
+      if (it->second.expired()) {
+        it = objects_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    sizeAfterPrune_ = std::max<size_t>(1, objects_.size());
+  }
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -7,16 +7,25 @@
 
 #include "WeightedCh4HashFunc.h"
 
-#include "mcrouter/lib/fbi/WeightedFurcHash.h"
+#include <cassert>
 
 namespace facebook {
 namespace memcache {
 
+void WeightedCh4HashFunc::operator()(
+    folly::Range<const folly::StringPiece*> keys,
+    folly::Range<size_t*> indices) const {
+  assert(indices.size() >= keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    indices[i] = hash(keys[i], table_);
+  }
+}
+
 size_t WeightedCh4HashFunc::hash(
     folly::StringPiece key,
-    folly::Range<const double*> weights,
+    const mcrouter::WeightedFurcHashTable& table,
     size_t retryCount) {
-  return mcrouter::weightedFurcHash(key, weights, retryCount);
+  return mcrouter::weightedFurcHash(key, table, retryCount);
 }
 
 } // namespace memcache
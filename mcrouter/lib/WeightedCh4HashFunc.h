@@ -9,6 +9,7 @@
 
 #include "mcrouter/lib/HashFunctionType.h"
 #include "mcrouter/lib/WeightedChHashFuncBase.h"
+#include "mcrouter/lib/fbi/WeightedFurcHash.h"
 
 namespace facebook {
 namespace memcache {
@@ -45,6 +46,9 @@ namespace memcache {
  * is too low. For instance is avg. weight is 0.25, then each iteration of the
  * algorithm will fail with probability (1 - 0.25) and it requires upto 16
  * retries to bring the chances of failure below 1%.
+ *
+ * The acceptance thresholds derived from the weights are computed once, when
+ * the function is constructed.
  */
 
 class WeightedCh4HashFunc : public WeightedChHashFuncBase {
@@ -54,7 +58,7 @@ class WeightedCh4HashFunc : public WeightedChHashFuncBase {
    *                 Pool size is taken to be weights.size()
    */
   explicit WeightedCh4HashFunc(std::vector<double> weights)
-      : WeightedChHashFuncBase(std::move(weights)) {}
+      : WeightedChHashFuncBase(std::move(weights)), table_(weights_) {}
 
   /**
    * @param json  Json object of the following format:
@@ -64,12 +68,20 @@ class WeightedCh4HashFunc : public WeightedChHashFuncBase {
    * @param n     Number of servers in the config.
    */
   WeightedCh4HashFunc(const folly::dynamic& json, size_t n)
-      : WeightedChHashFuncBase(json, n) {}
+      : WeightedChHashFuncBase(json, n), table_(weights_) {}
 
   size_t operator()(folly::StringPiece key) const {
-    return hash(key, weights_);
+    return hash(key, table_);
   }
 
+  /**
+   * Hashes keys[i] into indices[i], for all keys.
+   * `indices` must be at least as long as `keys`.
+   */
+  void operator()(
+      folly::Range<const folly::StringPiece*> keys,
+      folly::Range<size_t*> indices) const;
+
   static const char* type() {
     return "WeightedCh4";
   }
@@ -79,9 +91,11 @@ class WeightedCh4HashFunc : public WeightedChHashFuncBase {
   }
 
  private:
+  mcrouter::WeightedFurcHashTable table_;
+
   static size_t hash(
       folly::StringPiece key,
-      folly::Range<const double*> weights,
+      const mcrouter::WeightedFurcHashTable& table,
       size_t retryCount = kNumTries);
 };
 
@@ -7,18 +7,45 @@
 
 #include "WeightedRendezvousHashFunc.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
+#include <string>
+
+#include <folly/Conv.h>
 
 #include <glog/logging.h>
 
 #include "mcrouter/lib/RendezvousHashHelper.h"
+#include "mcrouter/lib/SharedObjectCache.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/fbi/hash.h"
 
 namespace facebook {
 namespace memcache {
 
+namespace {
+
+bool isPrime(size_t n) {
+  if (n < 2) {
+    return false;
+  }
+  for (size_t d = 2; d * d <= n; ++d) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SharedObjectCache<std::vector<uint32_t>>& lookupTableCache() {
+  static auto* cache = new SharedObjectCache<std::vector<uint32_t>>();
+  return *cache;
+}
+
+} // namespace
+
 WeightedRendezvousHashFunc::WeightedRendezvousHashFunc(
     const std::vector<folly::StringPiece>& endpoints,
     const folly::dynamic& json) {
@@ -45,16 +72,122 @@ WeightedRendezvousHashFunc::WeightedRendezvousHashFunc(
     endpointHashes_.push_back(hash);
     endpointWeights_.push_back(jWeights[i].asDouble());
   }
+  uniformWeights_ = std::all_of(
+      endpointWeights_.begin(), endpointWeights_.end(), [this](double w) {
+        return w == endpointWeights_[0];
+      });
+
+  if (auto jTableSize = json.get_ptr("lookup_table_size")) {
+    checkLogic(
+        jTableSize->isInt() && jTableSize->getInt() >= 0,
+        "WeightedRendezvousHashFunc: lookup_table_size is not "
+        "a non-negative integer");
+    if (auto tableSize = static_cast<size_t>(jTableSize->getInt())) {
+      checkLogic(
+          tableSize > endpoints.size() && isPrime(tableSize),
+          "WeightedRendezvousHashFunc: lookup_table_size must be a prime "
+          "larger than the number of end points");
+      checkLogic(
+          tableSize <= std::numeric_limits<uint32_t>::max(),
+          "WeightedRendezvousHashFunc: lookup_table_size is too large");
+      std::string cacheKey = folly::to<std::string>(tableSize, ':');
+      cacheKey.append(
+          reinterpret_cast<const char*>(endpointHashes_.data()),
+          endpointHashes_.size() * sizeof(uint64_t));
+      cacheKey.append(
+          reinterpret_cast<const char*>(endpointWeights_.data()),
+          endpointWeights_.size() * sizeof(double));
+      lookupTable_ = lookupTableCache().getOrCreate(
+          std::move(cacheKey), [&]() { return buildLookupTable(tableSize); });
+    }
+  }
 }
 
-size_t WeightedRendezvousHashFunc::operator()(folly::StringPiece key) const {
-  double maxScore = 0;
-  size_t maxScorePos = 0;
+std::vector<uint32_t> WeightedRendezvousHashFunc::buildLookupTable(
+    size_t tableSize) const {
+  const double maxWeight =
+      *std::max_element(endpointWeights_.begin(), endpointWeights_.end());
+  if (maxWeight <= 0) {
+    // Nothing to fill the table with; every key goes to endpoint 0 anyway.
+    return {};
+  }
+
+  // Each endpoint walks its own permutation of the table slots
+  // (offset + next * skip) and claims the first free one on its turn.
+  // Turns are handed out proportionally to weight: the heaviest endpoint
+  // gets one per round, the others accumulate credit until they reach one.
+  const size_t n = endpointHashes_.size();
+  std::vector<uint64_t> offset(n);
+  std::vector<uint64_t> skip(n);
+  std::vector<uint64_t> next(n, 0);
+  std::vector<double> credit(n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    // tableSize is prime, so any skip in [1, tableSize) visits every slot.
+    const uint64_t skipHash =
+        hash128to64(endpointHashes_[i], kRendezvousExtraHashSeed);
+    offset[i] = endpointHashes_[i] % tableSize;
+    skip[i] = skipHash % (tableSize - 1) + 1;
+  }
 
+  constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> lookupTable(tableSize, kEmpty);
+  size_t filled = 0;
+  while (filled < tableSize) {
+    for (size_t i = 0; i < n && filled < tableSize; ++i) {
+      credit[i] += endpointWeights_[i] / maxWeight;
+      while (credit[i] >= 1 && filled < tableSize) {
+        credit[i] -= 1;
+        size_t slot;
+        do {
+          slot = (offset[i] + next[i] * skip[i]) % tableSize;
+          ++next[i];
+        } while (lookupTable[slot] != kEmpty);
+        lookupTable[slot] = static_cast<uint32_t>(i);
+        ++filled;
+      }
+    }
+  }
+  return lookupTable;
+}
+
+size_t WeightedRendezvousHashFunc::operator()(folly::StringPiece key) const {
   const uint64_t keyHash =
       murmur_hash_64A(key.data(), key.size(), kRendezvousExtraHashSeed);
 
+  if (lookupTable_ && !lookupTable_->empty()) {
+    const auto& table = *lookupTable_;
+    return table[keyHash % table.size()];
+  }
+
+  if (uniformWeights_) {
+    // With equal weights the score is monotonic in the per-endpoint random
+    // number, so the endpoint with the largest one wins and we can skip the
+    // log() per endpoint, which dominates the cost of this function.
+    if (endpointWeights_.empty() || endpointWeights_[0] <= 0) {
+      return 0;
+    }
+    // Only the 53 bits used by convertInt64ToDouble01() matter.
+    constexpr uint64_t kFiftyThreeOnes = (0xFFFFFFFFFFFFFFFF >> (64 - 53));
+    uint64_t maxValue = 0;
+    size_t maxValuePos = 0;
+    for (size_t i = 0; i < endpointHashes_.size(); ++i) {
+      uint64_t value =
+          hash128to64(endpointHashes_[i], keyHash) & kFiftyThreeOnes;
+      if (value > maxValue) {
+        maxValue = value;
+        maxValuePos = i;
+      }
+    }
+    return maxValuePos;
+  }
+
+  double maxScore = 0;
+  size_t maxScorePos = 0;
   for (size_t i = 0; i < endpointHashes_.size(); ++i) {
+    // An endpoint with zero weight always scores 0 and can never win.
+    if (endpointWeights_[i] <= 0) {
+      continue;
+    }
     uint64_t scoreInt = hash128to64(endpointHashes_[i], keyHash);
     // Borrow from https://en.wikipedia.org/wiki/Rendezvous_hashing.
     double score = endpointWeights_[i] *
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include <folly/Range.h>
 #include <folly/dynamic.h>
 
@@ -19,6 +22,16 @@ namespace memcache {
 /**
  * Weighted Rendezvous hashing based on RendezvousHashFunc.
  * Each server is assigned a weight between 0.0 and 1.0 inclusive.
+ *
+ * Selection is O(number of servers) per key. For large pools, setting
+ * "lookup_table_size" (a prime, much larger than the number of servers)
+ * precomputes a Maglev-style table at construction time, so operator()
+ * becomes a single lookup. The table keeps the weights and, like Maglev,
+ * moves only about 1/N of the keys when one of N servers is removed, but
+ * it won't pick the same server as the plain rendezvous scores. The
+ * failover order from begin() is unaffected by the table.
+ * Tables built from the same endpoints and weights are shared between all
+ * proxies.
  */
 class WeightedRendezvousHashFunc {
  public:
@@ -26,7 +39,7 @@ class WeightedRendezvousHashFunc {
    * @param endpoints   The strings to be hashed, one per backend server.
    *
    * @param json A list with one weight (double) per backend server, in the same
-   * order as endpoints.
+   * order as endpoints, and optionally "lookup_table_size".
    *
    */
   WeightedRendezvousHashFunc(
@@ -65,6 +78,14 @@ class WeightedRendezvousHashFunc {
  private:
   std::vector<uint64_t> endpointHashes_;
   std::vector<double> endpointWeights_;
+  // True if all endpoints have the same weight, which allows a cheaper
+  // selection in operator().
+  bool uniformWeights_{false};
+  // Maglev-style table mapping key hash modulo its size to an endpoint
+  // index. Null unless "lookup_table_size" is configured.
+  std::shared_ptr<const std::vector<uint32_t>> lookupTable_;
+
+  std::vector<uint32_t> buildLookupTable(size_t tableSize) const;
 };
 } // namespace memcache
 } // namespace facebook
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ZstdDictionaryTrainer.h"
+
+#include <folly/Random.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+#include <zdict.h>
+#endif
+
+namespace facebook {
+namespace memcache {
+
+ZstdDictionaryTrainer::ZstdDictionaryTrainer(
+    size_t maxSampleBytes,
+    size_t maxValueSize)
+    : maxSampleBytes_(maxSampleBytes),
+      maxValueSize_(maxValueSize),
+      rng_(folly::randomNumberSeed()) {}
+
+void ZstdDictionaryTrainer::addSample(const folly::IOBuf& value) {
+  auto size = value.computeChainDataLength();
+  if (size == 0 || size > maxValueSize_ || size > maxSampleBytes_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++seen_;
+  size_t slot = samples_.size();
+  if (sampleBytes_ + size > maxSampleBytes_) {
+    // Reservoir is full: keep the new value with probability
+    // samples / seen, replacing a random one.
+    if (samples_.empty()) {
+      return;
+    }
+    auto r = std::uniform_int_distribution<uint64_t>(0, seen_ - 1)(rng_);
+    if (r >= samples_.size()) {
+      return;
+    }
+    slot = r;
+    sampleBytes_ -= samples_[slot].size();
+    if (sampleBytes_ + size > maxSampleBytes_) {
+      sampleBytes_ += samples_[slot].size();
+      return;
+    }
+  } else {
+    samples_.emplace_back();
+  }
+
+  auto& sample = samples_[slot];
+  sample.resize(size);
+  folly::io::Cursor(&value).pull(&sample[0], size);
+  sampleBytes_ += size;
+}
+
+size_t ZstdDictionaryTrainer::numSamples() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return samples_.size();
+}
+
+std::vector<std::string> ZstdDictionaryTrainer::takeSamples() {
+  std::vector<std::string> samples;
+  std::lock_guard<std::mutex> lock(mutex_);
+  samples.swap(samples_);
+  sampleBytes_ = 0;
+  seen_ = 0;
+  return samples;
+}
+
+folly::Optional<std::string> ZstdDictionaryTrainer::train(
+    const std::vector<std::string>& samples,
+    size_t dictionarySize) {
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+  if (samples.empty() || dictionarySize == 0) {
+    return folly::none;
+  }
+
+  std::string buffer;
+  std::vector<size_t> sampleSizes;
+  sampleSizes.reserve(samples.size());
+  for (const auto& sample : samples) {
+    buffer.append(sample);
+    sampleSizes.push_back(sample.size());
+  }
+
+  std::string dictionary(dictionarySize, '\0');
+  auto size = ZDICT_trainFromBuffer(
+      &dictionary[0],
+      dictionary.size(),
+      buffer.data(),
+      sampleSizes.data(),
+      static_cast<unsigned>(sampleSizes.size()));
+  if (ZDICT_isError(size)) {
+    LOG(WARNING) << "Failed to train ZSTD dictionary from " << samples.size()
+                 << " samples: " << ZDICT_getErrorName(size);
+    return folly::none;
+  }
+  dictionary.resize(size);
+  return dictionary;
+#else
+  (void)samples;
+  (void)dictionarySize;
+  return folly::none;
+#endif
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+
+namespace folly {
+class IOBuf;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Collects a uniform sample of values and trains ZSTD dictionaries from it.
+ *
+ * Samples are kept in a reservoir bounded by total size, so the memory cost
+ * doesn't depend on how much traffic is sampled between two trainings.
+ * addSample() is thread-safe.
+ */
+class ZstdDictionaryTrainer {
+ public:
+  /**
+   * @param maxSampleBytes  Total bytes of samples to keep.
+   * @param maxValueSize    Values bigger than this are not sampled (big values
+   *                        compress well without a dictionary anyway).
+   */
+  ZstdDictionaryTrainer(size_t maxSampleBytes, size_t maxValueSize);
+
+  ZstdDictionaryTrainer(const ZstdDictionaryTrainer&) = delete;
+  ZstdDictionaryTrainer& operator=(const ZstdDictionaryTrainer&) = delete;
+
+  void addSample(const folly::IOBuf& value);
+
+  size_t numSamples() const;
+
+  /**
+   * Moves out everything sampled so far and starts a new reservoir.
+   */
+  std::vector<std::string> takeSamples();
+
+  /**
+   * Trains a dictionary of at most `dictionarySize` bytes.
+   *
+   * @return  the dictionary, or none if training failed (e.g. too few
+   *          samples) or mcrouter was built without ZSTD.
+   */
+  static folly::Optional<std::string> train(
+      const std::vector<std::string>& samples,
+      size_t dictionarySize);
+
+ private:
+  const size_t maxSampleBytes_;
+  const size_t maxValueSize_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::string> samples_;
+  size_t sampleBytes_{0};
+  // Number of values offered since the last takeSamples().
+  uint64_t seen_{0};
+  std::minstd_rand rng_;
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -61,15 +61,16 @@ void CarbonProtocolReader::skip(const FieldType ft) {
       break;
     }
     case FieldType::Double: {
-      readRaw<double>();
+      cursor_.skip(sizeof(double));
       break;
     }
     case FieldType::Float: {
-      readRaw<float>();
+      cursor_.skip(sizeof(float));
       break;
     }
     case FieldType::Binary: {
-      readRaw<std::string>();
+      // Skipped fields are often big values, don't materialize them.
+      cursor_.skip(readVarint<uint32_t>());
       break;
     }
     case FieldType::List: {
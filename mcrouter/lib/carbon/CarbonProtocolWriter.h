@@ -14,6 +14,7 @@
 #include <utility>
 
 #include <folly/Optional.h>
+#include <folly/Range.h>
 #include <folly/io/IOBuf.h>
 #include <folly/small_vector.h>
 #include <thrift/lib/cpp2/FieldRef.h>
@@ -403,6 +404,10 @@ class CarbonProtocolWriterImpl {
   }
 
   void writeRaw(const std::string& s) {
+    writeRaw(folly::StringPiece(s));
+  }
+
+  void writeRaw(folly::StringPiece s) {
     const size_t len = s.size();
     facebook::memcache::checkRuntime(
         len <= std::numeric_limits<uint32_t>::max(),
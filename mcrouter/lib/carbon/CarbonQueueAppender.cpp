@@ -7,10 +7,89 @@
 
 #include "mcrouter/lib/carbon/CarbonQueueAppender.h"
 
+#include <array>
 #include <cstring>
+#include <vector>
+
+#include <folly/ThreadCachedInt.h>
+#include <folly/lang/Bits.h>
 
 namespace carbon {
 
+namespace {
+
+constexpr size_t kNumClasses = CarbonQueueAppenderStoragePool::kMaxClassShift -
+    CarbonQueueAppenderStoragePool::kMinClassShift + 1;
+
+struct StoragePoolCounters {
+  folly::ThreadCachedInt<uint64_t> hits;
+  folly::ThreadCachedInt<uint64_t> misses;
+};
+
+StoragePoolCounters& counters() {
+  static auto* c = new StoragePoolCounters();
+  return *c;
+}
+
+using FreeLists =
+    std::array<std::vector<std::unique_ptr<folly::IOBuf>>, kNumClasses>;
+
+FreeLists& freeLists() {
+  static thread_local FreeLists lists;
+  return lists;
+}
+
+// Smallest class whose buffers are all at least `size` bytes.
+size_t classForSize(size_t size) {
+  return folly::findLastSet(size - 1) -
+      CarbonQueueAppenderStoragePool::kMinClassShift;
+}
+
+} // namespace
+
+std::unique_ptr<folly::IOBuf> CarbonQueueAppenderStoragePool::get(
+    size_t size) {
+  if (size <= (size_t(1) << kMaxClassShift)) {
+    auto cls = size <= (size_t(1) << kMinClassShift) ? 0 : classForSize(size);
+    auto& list = freeLists()[cls];
+    if (!list.empty()) {
+      auto buf = std::move(list.back());
+      list.pop_back();
+      counters().hits.increment();
+      return buf;
+    }
+    size = size_t(1) << (cls + kMinClassShift);
+  }
+  counters().misses.increment();
+  return folly::IOBuf::createCombined(size);
+}
+
+void CarbonQueueAppenderStoragePool::put(
+    std::unique_ptr<folly::IOBuf> chain) {
+  while (chain) {
+    auto rest = chain->pop();
+    // Largest class this buffer fully covers.
+    const size_t shift = folly::findLastSet(chain->capacity()) - 1;
+    if (!chain->isSharedOne() && shift >= kMinClassShift &&
+        shift <= kMaxClassShift) {
+      auto& list = freeLists()[shift - kMinClassShift];
+      if (list.size() < (kMaxBytesPerClass >> shift)) {
+        chain->clear();
+        list.push_back(std::move(chain));
+      }
+    }
+    chain = std::move(rest);
+  }
+}
+
+uint64_t CarbonQueueAppenderStoragePool::hits() {
+  return counters().hits.readFull();
+}
+
+uint64_t CarbonQueueAppenderStoragePool::misses() {
+  return counters().misses.readFull();
+}
+
 void CarbonQueueAppenderStorage::coalesce() {
   VLOG(4) << "Out of iovecs, coalescing in Caret message serialization";
   assert(nIovsUsed_ == kMaxIovecs);
@@ -9,6 +9,7 @@
 
 #include <sys/uio.h>
 
+#include <memory>
 #include <type_traits>
 #include <utility>
 
@@ -23,6 +24,36 @@ class IOBuf;
 
 namespace carbon {
 
+/**
+ * Thread local, size classed cache for the buffers CarbonQueueAppenderStorage
+ * grows into once a message doesn't fit into its embedded storage. Size
+ * classes are powers of two; each class keeps at most kMaxBytesPerClass worth
+ * of idle buffers per thread, larger buffers are never cached.
+ */
+class CarbonQueueAppenderStoragePool {
+ public:
+  static constexpr size_t kMinClassShift = 10; // 1KB
+  static constexpr size_t kMaxClassShift = 17; // 128KB
+  static constexpr size_t kMaxBytesPerClass = 1 << 17;
+
+  /**
+   * @return  buffer with at least `size` bytes of (empty) capacity.
+   */
+  static std::unique_ptr<folly::IOBuf> get(size_t size);
+
+  /**
+   * Returns every buffer of the chain to the pool, or frees it if the pool is
+   * full or the buffer is still shared.
+   */
+  static void put(std::unique_ptr<folly::IOBuf> chain);
+
+  /**
+   * Process wide counters, summed over all threads.
+   */
+  static uint64_t hits();
+  static uint64_t misses();
+};
+
 class CarbonQueueAppenderStorage {
  public:
   CarbonQueueAppenderStorage() {
@@ -41,6 +72,21 @@ class CarbonQueueAppenderStorage {
       push(buf.data(), buf.length());
       return;
     }
+    // While the message still fits into the embedded storage, copy any IOBuf
+    // into it too: small messages then stay contiguous with their header and
+    // go out as a single iovec.
+    if (!iobufStorage_ && !buf.empty()) {
+      const auto len =
+          buf.isChained() ? buf.computeChainDataLength() : buf.length();
+      if (storageIdx_ + len <= sizeOfStorage()) {
+        for (const auto range : buf) {
+          if (!range.empty()) {
+            push(range.data(), range.size());
+          }
+        }
+        return;
+      }
+    }
 
     finalizeLastIovec();
 
@@ -54,8 +100,13 @@ class CarbonQueueAppenderStorage {
     const auto nFilled =
         buf.fillIov(nextIov, kMaxIovecs - nIovsUsed_).numIovecs;
 
+    // Values forwarded from upstream are often chained (e.g. a header piece
+    // plus the rest of the read buffer), so look at the whole chain rather
+    // than just the head buffer.
     if (tcpZeroCopyThreshold_ && !applyZeroCopy_ &&
-        buf.capacity() >= tcpZeroCopyThreshold_) {
+        (buf.capacity() >= tcpZeroCopyThreshold_ ||
+         (buf.isChained() &&
+          buf.computeChainDataLength() >= tcpZeroCopyThreshold_))) {
       applyZeroCopy_ = true;
     }
 
@@ -122,7 +173,9 @@ class CarbonQueueAppenderStorage {
   void reset() {
     storageIdx_ = kMaxHeaderLength;
     head_.reset();
-    iobufStorage_.reset();
+    if (iobufStorage_) {
+      CarbonQueueAppenderStoragePool::put(std::move(iobufStorage_));
+    }
     lastStorageSize_ = kInitMsgStoreLen;
     // Reserve first element of iovs_ for header, which won't be filled in
     // until after body data is serialized.
@@ -245,7 +298,7 @@ class CarbonQueueAppenderStorage {
       lastStorageSize_ = lastStorageSize_ * 2;
     } while (lastStorageSize_ < len);
 
-    auto buf = folly::IOBuf::createCombined(lastStorageSize_);
+    auto buf = CarbonQueueAppenderStoragePool::get(lastStorageSize_);
     if (!iobufStorage_) {
       iobufStorage_ = std::move(buf);
     } else {
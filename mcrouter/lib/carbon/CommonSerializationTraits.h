@@ -43,7 +43,13 @@ struct SerializationTraits<Keys<Storage>> {
 
   template <class Writer>
   static void write(const Keys<Storage>& key, Writer&& writer) {
-    writer.writeRaw(key.raw());
+    if (key.isInline()) {
+      // Copied into the message like any short IOBuf would be, without
+      // moving the key to the heap first.
+      writer.writeRaw(key.fullKey());
+    } else {
+      writer.writeRaw(key.raw());
+    }
   }
 
   static bool isEmpty(const Keys<Storage>& key) {
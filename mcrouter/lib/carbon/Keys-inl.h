@@ -11,30 +11,37 @@
 namespace carbon {
 
 template <class Storage>
-Keys<Storage>::Keys(const Keys<Storage>& other) : key_(other.key_) {
-  initStringPieces(other);
+Keys<Storage>::Keys(const Keys<Storage>& other) {
+  *this = other;
 }
 
 template <class Storage>
 Keys<Storage>& Keys<Storage>::operator=(const Keys<Storage>& other) {
   if (this != &other) {
-    key_ = other.key_;
-    initStringPieces(other);
+    if (other.isInline()) {
+      copyInlineKey(other);
+    } else {
+      key_ = other.key_;
+      initStringPieces(other);
+    }
   }
   return *this;
 }
 
 template <class Storage>
-Keys<Storage>::Keys(Keys<Storage>&& other) noexcept
-    : key_(std::move(other.key_)) {
-  initStringPieces(other);
+Keys<Storage>::Keys(Keys<Storage>&& other) noexcept {
+  *this = std::move(other);
 }
 
 template <class Storage>
 Keys<Storage>& Keys<Storage>::operator=(Keys<Storage>&& other) noexcept {
   if (this != &other) {
-    key_ = std::move(other.key_);
-    initStringPieces(other);
+    if (other.isInline()) {
+      copyInlineKey(other);
+    } else {
+      key_ = std::move(other.key_);
+      initStringPieces(other);
+    }
   }
   return *this;
 }
@@ -75,6 +82,8 @@ void Keys<Storage>::update() {
     }
   }
   routingKeyHash_ = 0;
+  cachedHashes_ = {};
+  nextCachedHash_ = 0;
 }
 
 } // namespace carbon
@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <array>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <type_traits>
 
@@ -41,6 +44,11 @@ inline folly::IOBuf makeKey<folly::IOBuf>(folly::StringPiece sp) {
  * keyWithoutRoute:                       ^^^^^^^^^^^^^
  * routingPrefix:         ^^^^^^^^^^^^^^^^
  * routingKey:                            ^^^^^^^
+ *
+ * Keys<folly::IOBuf> built from a string of at most kMaxInlineKeySize bytes
+ * keep it in a buffer inside the object instead of a heap allocated IOBuf.
+ * Since clones of such an IOBuf would point into *this, raw() and
+ * rawUnsafe() first move an inline key to the heap.
  */
 template <class Storage>
 class Keys {
@@ -53,13 +61,12 @@ class Keys {
     update();
   }
 
-  explicit Keys(folly::StringPiece sp) : key_(makeKey<Storage>(sp)) {
+  explicit Keys(folly::StringPiece sp) {
+    assign(sp);
     update();
   }
 
-  explicit Keys(const char* key) : key_(makeKey<Storage>(key)) {
-    update();
-  }
+  explicit Keys(const char* key) : Keys(folly::StringPiece(key)) {}
 
   Keys(const Keys& other);
   Keys& operator=(const Keys& other);
@@ -79,7 +86,7 @@ class Keys {
   }
 
   Keys& operator=(folly::StringPiece key) {
-    key_ = makeKey<Storage>(key);
+    assign(key);
     update();
     return *this;
   }
@@ -131,39 +138,122 @@ class Keys {
   // TODO(jmswen) Would be nice not to expose raw storage. Only needed in
   // asciiKey() in McServerSession-inl.h and SerializationTraits specialization.
   const Storage& raw() const {
+    moveInlineKeyToHeap();
     return key_;
   }
 
   // Usage of this method requires user to call `update()` manually on change of
   // the underlying storage.
   Storage& rawUnsafe() {
+    moveInlineKeyToHeap();
     return key_;
   }
   const Storage& rawUnsafe() const {
+    moveInlineKeyToHeap();
     return key_;
   }
 
+  /**
+   * @return  true if the key is stored inside *this (see kMaxInlineKeySize).
+   */
+  bool isInline() const {
+    if constexpr (kHasInlineStorage) {
+      return key_.buffer() ==
+          reinterpret_cast<const uint8_t*>(inlineKey_.data());
+    }
+    return false;
+  }
+
   void update();
 
-  bool reuseLastHash(size_t size, HashFunctionType typeId) const {
-    return (
-        lastHash_.size_ > 0 && size == lastHash_.size_ &&
-        typeId == lastHash_.typeId_);
+  /**
+   * Index the routing key was hashed to by a hash function of type `typeId`
+   * over `size` destinations, if cached by cacheHash(). Lets nested routes
+   * (e.g. a pool under failover and shadow routes) hash the key only once.
+   *
+   * @return  false if no such hash is cached.
+   */
+  bool getCachedHash(size_t size, HashFunctionType typeId, size_t& hash)
+      const {
+    for (const auto& entry : cachedHashes_) {
+      if (entry.size_ > 0 && entry.size_ == size && entry.typeId_ == typeId) {
+        hash = entry.hash_;
+        return true;
+      }
+    }
+    return false;
   }
 
-  size_t getLastHash() const {
-    return lastHash_.hash_;
+  /**
+   * Caches the result of an unsalted hash of the routing key. The oldest of
+   * the kNumCachedHashes cached results is replaced.
+   */
+  void cacheHash(size_t hash, size_t size, HashFunctionType typeId) const {
+    // The parameters of an unknown function can't be told apart.
+    if (typeId == HashFunctionType::Unknown ||
+        size > std::numeric_limits<uint32_t>::max()) {
+      return;
+    }
+    auto& entry = cachedHashes_[nextCachedHash_];
+    entry.size_ = size;
+    entry.hash_ = hash;
+    entry.typeId_ = typeId;
+    nextCachedHash_ = (nextCachedHash_ + 1) % kNumCachedHashes;
   }
 
-  void setLastHash(size_t hash, size_t size, HashFunctionType typeId) const {
-    lastHash_.hash_ = hash;
-    lastHash_.size_ = size;
-    lastHash_.typeId_ = typeId;
-  }
+  static constexpr size_t kMaxInlineKeySize = 48;
 
  private:
   static constexpr bool usingStringStorage =
       std::is_same<Storage, std::string>::value;
+  // std::string already keeps short strings inline.
+  static constexpr bool kHasInlineStorage =
+      std::is_same<Storage, folly::IOBuf>::value;
+
+  void assign(folly::StringPiece sp) {
+    if constexpr (kHasInlineStorage) {
+      if (sp.size() <= kMaxInlineKeySize) {
+        // sp may point into the current inline key.
+        std::memmove(inlineKey_.data(), sp.data(), sp.size());
+        key_ = folly::IOBuf::wrapBufferAsValue(inlineKey_.data(), sp.size());
+        return;
+      }
+    }
+    key_ = makeKey<Storage>(sp);
+  }
+
+  // An IOBuf copy of an inline key would share its buffer, so the bytes are
+  // copied into our own inline buffer instead.
+  void copyInlineKey(const Keys& other) {
+    if constexpr (kHasInlineStorage) {
+      inlineKey_ = other.inlineKey_;
+      key_ = folly::IOBuf::wrapBufferAsValue(
+          inlineKey_.data(), other.key_.capacity());
+      key_.trimStart(other.key_.headroom());
+      key_.trimEnd(other.key_.tailroom());
+      copyStringPieces(other);
+      rebaseStringPieces(other.fullKey().begin());
+    }
+  }
+
+  void moveInlineKeyToHeap() const {
+    if constexpr (kHasInlineStorage) {
+      if (isInline()) {
+        const char* oldBegin = fullKey().begin();
+        key_ = makeKey<Storage>(fullKey());
+        rebaseStringPieces(oldBegin);
+      }
+    }
+  }
+
+  // Points the StringPiece members, which point into a key starting at
+  // `oldBegin`, to the same bytes of key_.
+  void rebaseStringPieces(const char* oldBegin) const {
+    const char* newBegin = fullKey().begin();
+    for (auto* piece : {&keyWithoutRoute_, &routingPrefix_, &routingKey_}) {
+      piece->reset(newBegin + (piece->begin() - oldBegin), piece->size());
+    }
+  }
 
   // Assumes that this->key_ has been set to the desired value that StringPiece
   // members of *this should point into.
@@ -182,8 +272,8 @@ class Keys {
     routingPrefix_ = other.routingPrefix_;
     routingKey_ = other.routingKey_;
     routingKeyHash_ = other.routingKeyHash_;
-    lastHash_.size_ = other.lastHash_.size_;
-    lastHash_.hash_ = other.lastHash_.hash_;
+    cachedHashes_ = other.cachedHashes_;
+    nextCachedHash_ = other.nextCachedHash_;
   }
 
   static size_t size(const folly::IOBuf& buf) {
@@ -206,20 +296,25 @@ class Keys {
   }
 
  protected:
-  Storage key_;
+  // Mutable so that an inline key can be moved to the heap by const accessors.
+  mutable Storage key_;
 
  private:
-  folly::StringPiece keyWithoutRoute_;
-  folly::StringPiece routingPrefix_;
-  folly::StringPiece routingKey_;
+  mutable folly::StringPiece keyWithoutRoute_;
+  mutable folly::StringPiece routingPrefix_;
+  mutable folly::StringPiece routingKey_;
   mutable uint32_t routingKeyHash_{0};
 
+  static constexpr size_t kNumCachedHashes = 3;
   struct HashData {
-    size_t size_{0};
-    size_t hash_{0};
+    uint32_t size_{0};
+    uint32_t hash_{0};
     HashFunctionType typeId_{HashFunctionType::Unknown};
   };
-  mutable HashData lastHash_;
+  mutable std::array<HashData, kNumCachedHashes> cachedHashes_;
+  mutable uint8_t nextCachedHash_{0};
+
+  std::array<char, kHasInlineStorage ? kMaxInlineKeySize : 0> inlineKey_;
 };
 
 } // namespace carbon
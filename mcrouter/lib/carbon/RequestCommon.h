@@ -40,7 +40,7 @@ class RequestCommon : public MessageCommon {
    * be used.
    */
   bool isBufferDirty() const {
-    return serializedBuffer_ == nullptr;
+    return serializedBuffer_.buf == nullptr;
   }
 
   /**
@@ -54,9 +54,9 @@ class RequestCommon : public MessageCommon {
    */
   void setSerializedBuffer(const folly::IOBuf& buffer) {
     if (buffer.empty()) {
-      serializedBuffer_ = nullptr;
+      serializedBuffer_.buf = nullptr;
     } else {
-      serializedBuffer_ = &buffer;
+      serializedBuffer_.buf = &buffer;
     }
   }
 
@@ -65,7 +65,7 @@ class RequestCommon : public MessageCommon {
    * Will return nullptr if the buffer is dirty and can't be used.
    */
   const folly::IOBuf* serializedBuffer() const {
-    return serializedBuffer_;
+    return serializedBuffer_.buf;
   }
 
   // Store CAT token in an optional field.
@@ -83,11 +83,31 @@ class RequestCommon : public MessageCommon {
 
  protected:
   void markBufferAsDirty() {
-    serializedBuffer_ = nullptr;
+    serializedBuffer_.buf = nullptr;
   }
 
  private:
-  const folly::IOBuf* serializedBuffer_{nullptr};
+  // Routes that modify a request do so on a copy, so a copy never inherits
+  // the buffer (whether or not the copy constructor above is compiled in).
+  // Moves keep it.
+  struct SerializedBufferRef {
+    SerializedBufferRef() = default;
+    SerializedBufferRef(const SerializedBufferRef&) noexcept {}
+    SerializedBufferRef& operator=(const SerializedBufferRef&) noexcept {
+      buf = nullptr;
+      return *this;
+    }
+    SerializedBufferRef(SerializedBufferRef&& other) noexcept
+        : buf(std::exchange(other.buf, nullptr)) {}
+    SerializedBufferRef& operator=(SerializedBufferRef&& other) noexcept {
+      buf = std::exchange(other.buf, nullptr);
+      return *this;
+    }
+
+    const folly::IOBuf* buf{nullptr};
+  };
+
+  SerializedBufferRef serializedBuffer_;
   // cat token(s) in string serialzed format
   std::optional<std::string> cryptoAuthToken_;
 };
@@ -10,6 +10,7 @@
 #include <functional>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #include <mcrouter/lib/Reply.h>
 
@@ -30,4 +31,11 @@ class CarbonConnectionException : public std::runtime_error {
 template <class Request>
 using RequestCb =
     std::function<void(const Request&, facebook::memcache::ReplyT<Request>&&)>;
+
+/**
+ * Receives all replies of a batch at once, in the order of the requests.
+ */
+template <class Request>
+using BatchRequestCb =
+    std::function<void(std::vector<facebook::memcache::ReplyT<Request>>&&)>;
 } // namespace carbon
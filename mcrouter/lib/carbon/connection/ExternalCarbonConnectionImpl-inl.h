@@ -5,9 +5,11 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <type_traits>
 #include <utility>
 
 #include <folly/ScopeGuard.h>
@@ -399,6 +401,98 @@ class Impl {
     }
   }
 
+  template <class Request, class F>
+  void sendRequestBatch(
+      std::vector<std::reference_wrapper<const Request>>&& reqs,
+      F&& f) {
+    using Reply = facebook::memcache::ReplyT<Request>;
+
+    auto threadInfo = threadInfo_.lock();
+    if (!threadInfo) {
+      throw CarbonConnectionRecreateException(
+          "Singleton<ThreadPool> was destroyed!");
+    }
+
+    auto cl = client_.lock();
+    assert(cl);
+
+    if (reqs.empty()) {
+      f(std::vector<Reply>());
+      return;
+    }
+
+    struct BatchContext {
+      BatchContext(
+          std::vector<std::reference_wrapper<const Request>>&& r,
+          F&& cb)
+          : reqs(std::move(r)),
+            replies(reqs.size()),
+            remaining(reqs.size()),
+            f(std::forward<F>(cb)) {}
+
+      // Every slot of `replies` is written once, and only the last writer
+      // reads them all.
+      void done(size_t num) {
+        if (remaining.fetch_sub(num) == num) {
+          f(std::move(replies));
+        }
+      }
+
+      std::vector<std::reference_wrapper<const Request>> reqs;
+      std::vector<Reply> replies;
+      std::atomic<size_t> remaining;
+      std::decay_t<F> f;
+    };
+    auto ctx =
+        std::make_shared<BatchContext>(std::move(reqs), std::forward<F>(f));
+    const size_t total = ctx->reqs.size();
+
+    for (size_t i = 0; i < total;) {
+      auto num = cl->limitRequests(total - i);
+
+      if (num == 0) {
+        // Hit outstanding limit.
+        for (size_t j = i; j < total; ++j) {
+          ctx->replies[j] = Reply(carbon::Result::LOCAL_ERROR);
+        }
+        ctx->done(total - i);
+        break;
+      }
+
+      threadInfo->addTaskRemote([clientWeak = client_, ctx, i, num]() {
+        auto client = clientWeak.lock();
+        if (!client) {
+          for (size_t j = i; j < i + num; ++j) {
+            ctx->replies[j] = Reply(carbon::Result::UNKNOWN);
+          }
+          folly::fibers::runInMainContext([&ctx, num] { ctx->done(num); });
+          return;
+        }
+
+        for (size_t j = i; j + 1 < i + num; ++j) {
+          folly::fibers::addTaskFinally(
+              [clientWeak, &req = ctx->reqs[j].get()] {
+                if (auto c = clientWeak.lock()) {
+                  return c->sendRequest(req);
+                }
+                return Reply(carbon::Result::UNKNOWN);
+              },
+              [ctx, j](folly::Try<Reply>&& r) {
+                ctx->replies[j] = std::move(r.value());
+                ctx->done(1);
+              });
+        }
+
+        // Send last request in a batch on this fiber.
+        const size_t last = i + num - 1;
+        ctx->replies[last] = client->sendRequest(ctx->reqs[last].get());
+        folly::fibers::runInMainContext([&ctx] { ctx->done(1); });
+      });
+
+      i += num;
+    }
+  }
+
  private:
   std::weak_ptr<detail::ThreadInfo> threadInfo_;
   std::weak_ptr<detail::Client<Transport>> client_;
@@ -434,6 +528,36 @@ void ExternalCarbonConnectionImpl<RouterInfo>::sendRequestMulti(
   }
 }
 
+template <class RouterInfo>
+template <class Request>
+void ExternalCarbonConnectionImpl<RouterInfo>::sendRequestBatch(
+    std::vector<std::reference_wrapper<const Request>>&& reqs,
+    BatchRequestCb<Request> cb) {
+  try {
+    thriftImpl_ ? thriftImpl_->sendRequestBatch(std::move(reqs), std::move(cb))
+                : carbonImpl_->sendRequestBatch(std::move(reqs), std::move(cb));
+  } catch (const CarbonConnectionRecreateException&) {
+    makeImpl();
+    thriftImpl_ ? thriftImpl_->sendRequestBatch(std::move(reqs), std::move(cb))
+                : carbonImpl_->sendRequestBatch(std::move(reqs), std::move(cb));
+  }
+}
+
+template <class RouterInfo>
+template <class Request>
+folly::SemiFuture<std::vector<facebook::memcache::ReplyT<Request>>>
+ExternalCarbonConnectionImpl<RouterInfo>::sendRequestBatch(
+    std::vector<std::reference_wrapper<const Request>>&& reqs) {
+  using Replies = std::vector<facebook::memcache::ReplyT<Request>>;
+  auto promise = std::make_shared<folly::Promise<Replies>>();
+  auto future = promise->getSemiFuture();
+  sendRequestBatch<Request>(
+      std::move(reqs), [promise = std::move(promise)](Replies&& replies) {
+        promise->setValue(std::move(replies));
+      });
+  return future;
+}
+
 template <class RouterInfo>
 void ExternalCarbonConnectionImpl<RouterInfo>::makeImpl() {
   if (connectionOptions_.accessPoint &&
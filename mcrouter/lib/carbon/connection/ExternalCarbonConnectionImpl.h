@@ -12,6 +12,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include <folly/futures/Future.h>
+
 #include "mcrouter/lib/CacheClientStats.h"
 #include "mcrouter/lib/carbon/ExternalCarbonConnectionStats.h"
 #include "mcrouter/lib/carbon/connection/CarbonConnectionUtil.h"
@@ -65,6 +67,25 @@ class ExternalCarbonConnectionImpl {
       std::vector<std::reference_wrapper<const Request>>&& reqs,
       RequestCb<Request> cb);
 
+  /**
+   * Sends all requests with a single hop to the connection thread (unless
+   * maxOutstanding splits the batch) and calls `cb` once with all replies,
+   * in the order of `reqs`. `cb` runs on the connection thread, or on the
+   * calling thread if the last requests are rejected by maxOutstanding.
+   * Requests must stay alive until `cb` is called.
+   */
+  template <class Request>
+  void sendRequestBatch(
+      std::vector<std::reference_wrapper<const Request>>&& reqs,
+      BatchRequestCb<Request> cb);
+
+  /**
+   * Same as above, but returns the replies as a future.
+   */
+  template <class Request>
+  folly::SemiFuture<std::vector<facebook::memcache::ReplyT<Request>>>
+  sendRequestBatch(std::vector<std::reference_wrapper<const Request>>&& reqs);
+
   template <class T>
   std::unique_ptr<T> recreate() {
     LOG(FATAL)
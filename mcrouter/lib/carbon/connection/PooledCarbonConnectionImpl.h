@@ -7,7 +7,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -20,41 +24,83 @@
 
 namespace carbon {
 
+template <class If>
+struct PooledCarbonConnectionOptions {
+  using ConnectionFactory = std::function<std::unique_ptr<If>()>;
+
+  bool splitBatchedRequests{false};
+
+  /**
+   * If set, the pool adds a connection (up to maxConnections) after
+   * growAfterRequests requests in a row found even the least loaded
+   * connection with at least growOutstanding requests in flight.
+   */
+  ConnectionFactory connectionFactory{nullptr};
+  size_t maxConnections{0};
+  size_t growOutstanding{32};
+  size_t growAfterRequests{100};
+};
+
+/**
+ * Spreads requests over a pool of connections.
+ *
+ * Every request goes to the less loaded (by number of requests in flight) of
+ * two random connections, so one slow connection doesn't collect a queue.
+ */
 template <class If>
 class PooledCarbonConnectionImpl {
  public:
+  using Options = PooledCarbonConnectionOptions<If>;
+
   explicit PooledCarbonConnectionImpl(
       std::vector<std::unique_ptr<If>> connections,
       bool splitBatchedRequests = false)
-      : connections_(std::move(connections)),
-        splitBatchedRequests_(splitBatchedRequests) {}
+      : PooledCarbonConnectionImpl(
+            std::move(connections), makeOptions(splitBatchedRequests)) {}
+
+  PooledCarbonConnectionImpl(
+      std::vector<std::unique_ptr<If>> connections,
+      Options options)
+      : options_(std::move(options)),
+        capacity_(std::max(
+            connections.size(),
+            options_.connectionFactory ? options_.maxConnections : 0)),
+        connections_(std::make_unique<std::unique_ptr<If>[]>(capacity_)),
+        outstanding_(
+            std::make_shared<std::vector<std::atomic<size_t>>>(capacity_)) {
+    for (size_t i = 0; i < connections.size(); ++i) {
+      connections_[i] = std::move(connections[i]);
+    }
+    size_.store(connections.size(), std::memory_order_release);
+  }
 
   template <class Request>
   void sendRequestOne(const Request& req, RequestCb<Request> cb) {
-    connections_[folly::Random::rand32(connections_.size())]->sendRequestOne(
-        req, std::move(cb));
+    auto idx = pick();
+    connections_[idx]->sendRequestOne(
+        req, track<Request>(idx, 1, std::move(cb)));
   }
 
   template <class Request>
   void sendRequestMulti(
       std::vector<std::reference_wrapper<const Request>>&& reqs,
       RequestCb<Request> cb) {
-    if (splitBatchedRequests_) {
-      auto clientId = folly::Random::rand32(connections_.size());
+    if (options_.splitBatchedRequests) {
       for (const Request& req : reqs) {
-        connections_[clientId]->sendRequestOne(req, cb);
-        clientId = (clientId + 1) % connections_.size();
+        sendRequestOne(req, cb);
       }
     } else {
-      connections_[folly::Random::rand32(connections_.size())]
-          ->sendRequestMulti(std::move(reqs), std::move(cb));
+      auto idx = pick();
+      auto num = reqs.size();
+      connections_[idx]->sendRequestMulti(
+          std::move(reqs), track<Request>(idx, num, std::move(cb)));
     }
   }
 
   facebook::memcache::CacheClientCounters getStatCounters() const noexcept {
     facebook::memcache::CacheClientCounters ret;
-    for (auto& connection : connections_) {
-      ret += connection->getStatCounters();
+    for (size_t i = 0; i < numConnections(); ++i) {
+      ret += connections_[i]->getStatCounters();
     }
     return ret;
   }
@@ -64,8 +110,8 @@ class PooledCarbonConnectionImpl {
   }
 
   bool healthCheck() {
-    for (auto& connection : connections_) {
-      if (!connection->healthCheck()) {
+    for (size_t i = 0; i < numConnections(); ++i) {
+      if (!connections_[i]->healthCheck()) {
         return false;
       }
     }
@@ -75,15 +121,94 @@ class PooledCarbonConnectionImpl {
   template <class Impl>
   std::unique_ptr<If> recreate() {
     std::vector<std::unique_ptr<If>> newConnections;
-    for (size_t i = 0; i < connections_.size(); ++i) {
+    for (size_t i = 0; i < numConnections(); ++i) {
       newConnections.push_back(connections_[i]->recreate());
     }
-    return std::make_unique<Impl>(
-        std::move(newConnections), splitBatchedRequests_);
+    return std::make_unique<Impl>(std::move(newConnections), options_);
+  }
+
+  size_t numConnections() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Number of requests sent through the idx-th connection that haven't
+   * received a reply yet.
+   */
+  size_t outstanding(size_t idx) const {
+    return (*outstanding_)[idx].load(std::memory_order_relaxed);
   }
 
  private:
-  std::vector<std::unique_ptr<If>> connections_;
-  bool splitBatchedRequests_;
+  const Options options_;
+  // Slots are allocated upfront, so that the pool can grow while other
+  // threads send requests through the first size_ connections.
+  const size_t capacity_;
+  std::unique_ptr<std::unique_ptr<If>[]> connections_;
+  std::atomic<size_t> size_{0};
+  // Shared with the reply callbacks, which may outlive the pool.
+  std::shared_ptr<std::vector<std::atomic<size_t>>> outstanding_;
+  std::atomic<size_t> loadedInARow_{0};
+  std::mutex growMutex_;
+
+  static Options makeOptions(bool splitBatchedRequests) {
+    Options options;
+    options.splitBatchedRequests = splitBatchedRequests;
+    return options;
+  }
+
+  size_t pick() {
+    auto n = numConnections();
+    size_t idx = 0;
+    if (n > 1) {
+      // Power of two choices.
+      idx = folly::Random::rand32(n);
+      auto other = folly::Random::rand32(n - 1);
+      if (other >= idx) {
+        ++other;
+      }
+      if (outstanding(other) < outstanding(idx)) {
+        idx = other;
+      }
+    }
+    maybeGrow(outstanding(idx));
+    return idx;
+  }
+
+  void maybeGrow(size_t load) {
+    if (!options_.connectionFactory || numConnections() >= capacity_) {
+      return;
+    }
+    if (load < options_.growOutstanding) {
+      loadedInARow_.store(0, std::memory_order_relaxed);
+      return;
+    }
+    if (loadedInARow_.fetch_add(1, std::memory_order_relaxed) + 1 <
+        options_.growAfterRequests) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lck(growMutex_, std::try_to_lock);
+    auto n = numConnections();
+    if (!lck.owns_lock() || n >= capacity_) {
+      return;
+    }
+    if (auto connection = options_.connectionFactory()) {
+      connections_[n] = std::move(connection);
+      size_.store(n + 1, std::memory_order_release);
+    }
+    loadedInARow_.store(0, std::memory_order_relaxed);
+  }
+
+  template <class Request>
+  RequestCb<Request> track(size_t idx, size_t num, RequestCb<Request> cb) {
+    (*outstanding_)[idx].fetch_add(num, std::memory_order_relaxed);
+    return [outstanding = outstanding_, idx, cb = std::move(cb)](
+               const Request& req,
+               facebook::memcache::ReplyT<Request>&& reply) {
+      (*outstanding)[idx].fetch_sub(1, std::memory_order_relaxed);
+      cb(req, std::move(reply));
+    };
+  }
 };
 } // namespace carbon
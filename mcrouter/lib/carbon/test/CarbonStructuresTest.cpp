@@ -443,6 +443,25 @@ TEST(CarbonTest, serializeDeserialize) {
   expectEqTestRequest(outRequest, inRequest);
 }
 
+TEST(CarbonTest, serializedBufferNotCopied) {
+  folly::IOBuf buf(folly::IOBuf::COPY_BUFFER, "serialized");
+  TestRequest request("abc");
+  EXPECT_TRUE(request.isBufferDirty());
+  request.setSerializedBuffer(buf);
+  EXPECT_FALSE(request.isBufferDirty());
+  EXPECT_EQ(&buf, request.serializedBuffer());
+
+  // A copy may be modified by the route that made it.
+  TestRequest copy(request);
+  EXPECT_TRUE(copy.isBufferDirty());
+  copy = request;
+  EXPECT_TRUE(copy.isBufferDirty());
+  EXPECT_FALSE(request.isBufferDirty());
+
+  TestRequest moved(std::move(request));
+  EXPECT_EQ(&buf, moved.serializedBuffer());
+}
+
 TEST(CarbonTest, veryLongString) {
   constexpr uint32_t kVeryLongStringSize = 1 << 30;
   std::string veryLongString(kVeryLongStringSize, 'x');
@@ -554,6 +573,83 @@ TEST(CarbonTest, keysString) {
   }
 }
 
+TEST(CarbonTest, keysCachedHashes) {
+  carbon::Keys<std::string> key("/region/cluster/foo:bar|#|baz");
+  size_t hash = 0;
+  EXPECT_FALSE(key.getCachedHash(10, HashFunctionType::CH3, hash));
+
+  key.cacheHash(3, 10, HashFunctionType::CH3);
+  key.cacheHash(5, 20, HashFunctionType::CH3);
+  key.cacheHash(7, 10, HashFunctionType::WeightedCh3);
+  // Functions of unknown type are never cached.
+  key.cacheHash(1, 10, HashFunctionType::Unknown);
+  EXPECT_FALSE(key.getCachedHash(10, HashFunctionType::Unknown, hash));
+
+  EXPECT_TRUE(key.getCachedHash(10, HashFunctionType::CH3, hash));
+  EXPECT_EQ(3, hash);
+  EXPECT_TRUE(key.getCachedHash(20, HashFunctionType::CH3, hash));
+  EXPECT_EQ(5, hash);
+  EXPECT_TRUE(key.getCachedHash(10, HashFunctionType::WeightedCh3, hash));
+  EXPECT_EQ(7, hash);
+
+  // Copies keep the cache, the oldest entry is replaced when full.
+  auto copy = key;
+  copy.cacheHash(9, 30, HashFunctionType::CH3);
+  EXPECT_FALSE(copy.getCachedHash(10, HashFunctionType::CH3, hash));
+  EXPECT_TRUE(copy.getCachedHash(30, HashFunctionType::CH3, hash));
+  EXPECT_EQ(9, hash);
+  EXPECT_TRUE(key.getCachedHash(10, HashFunctionType::CH3, hash));
+
+  // A new key drops the cached hashes.
+  key = "other";
+  EXPECT_FALSE(key.getCachedHash(20, HashFunctionType::CH3, hash));
+}
+
+TEST(CarbonTest, keysInline) {
+  const std::string small = "/region/cluster/foo:bar|#|baz";
+  const std::string large(
+      carbon::Keys<folly::IOBuf>::kMaxInlineKeySize + 1, 'a');
+
+  carbon::Keys<folly::IOBuf> key(small);
+  EXPECT_TRUE(key.isInline());
+  EXPECT_FALSE(carbon::Keys<folly::IOBuf>(large).isInline());
+  EXPECT_FALSE(carbon::Keys<std::string>(small).isInline());
+
+  auto checkKey = [&small](const carbon::Keys<folly::IOBuf>& k) {
+    EXPECT_EQ(small, k.fullKey());
+    EXPECT_EQ("/region/cluster/", k.routingPrefix());
+    EXPECT_EQ("foo:bar", k.routingKey());
+    EXPECT_EQ("foo:bar|#|baz", k.keyWithoutRoute());
+    EXPECT_TRUE(k.routingKey().begin() >= k.fullKey().begin());
+    EXPECT_TRUE(k.routingKey().end() <= k.fullKey().end());
+  };
+
+  // Copies and moves get their own inline buffer.
+  auto copy = key;
+  EXPECT_TRUE(copy.isInline());
+  EXPECT_NE(key.fullKey().begin(), copy.fullKey().begin());
+  checkKey(copy);
+  auto moved = std::move(copy);
+  EXPECT_TRUE(moved.isInline());
+  checkKey(moved);
+
+  // A stripped routing prefix stays stripped in copies.
+  auto stripped = key;
+  stripped.stripRoutingPrefix();
+  auto strippedCopy = stripped;
+  EXPECT_EQ("foo:bar|#|baz", strippedCopy.fullKey());
+  EXPECT_EQ("foo:bar", strippedCopy.routingKey());
+  EXPECT_TRUE(strippedCopy.routingPrefix().empty());
+
+  // raw() hands out a heap allocated IOBuf that is safe to clone.
+  auto clone = key.raw().cloneAsValue();
+  EXPECT_FALSE(key.isInline());
+  checkKey(key);
+  key = "other";
+  EXPECT_TRUE(key.isInline());
+  EXPECT_EQ(small, folly::StringPiece(clone.coalesce()));
+}
+
 TEST(CarbonBasic, defaultConstructedFieldRefAPI) {
   TestRequest req;
   TestRequestStringKey req2;
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/carbon/connection/PooledCarbonConnectionImpl.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+/**
+ * Connection that holds on to all callbacks until told to reply.
+ */
+class FakeConnection {
+ public:
+  void sendRequestOne(
+      const McGetRequest& req,
+      carbon::RequestCb<McGetRequest> cb) {
+    pending_.emplace_back(&req, std::move(cb));
+  }
+
+  void sendRequestMulti(
+      std::vector<std::reference_wrapper<const McGetRequest>>&& reqs,
+      carbon::RequestCb<McGetRequest> cb) {
+    for (const McGetRequest& req : reqs) {
+      pending_.emplace_back(&req, cb);
+    }
+  }
+
+  void replyAll() {
+    auto pending = std::move(pending_);
+    for (auto& it : pending) {
+      it.second(*it.first, McGetReply(carbon::Result::FOUND));
+    }
+  }
+
+  size_t numPending() const {
+    return pending_.size();
+  }
+
+  CacheClientCounters getStatCounters() const noexcept {
+    return {};
+  }
+
+  bool healthCheck() {
+    return true;
+  }
+
+ private:
+  std::vector<std::pair<const McGetRequest*, carbon::RequestCb<McGetRequest>>>
+      pending_;
+};
+
+using Pool = carbon::PooledCarbonConnectionImpl<FakeConnection>;
+
+std::vector<std::unique_ptr<FakeConnection>> makeConnections(
+    size_t n,
+    std::vector<FakeConnection*>& raw) {
+  std::vector<std::unique_ptr<FakeConnection>> connections;
+  for (size_t i = 0; i < n; ++i) {
+    connections.push_back(std::make_unique<FakeConnection>());
+    raw.push_back(connections.back().get());
+  }
+  return connections;
+}
+
+} // namespace
+
+TEST(PooledCarbonConnectionImpl, avoidsLoadedConnection) {
+  std::vector<FakeConnection*> raw;
+  Pool pool(makeConnections(2, raw));
+  McGetRequest req("key");
+  size_t numReplies = 0;
+  auto cb = [&](const McGetRequest&, McGetReply&&) { ++numReplies; };
+
+  // With two connections the less loaded one is always picked, so requests
+  // alternate between them.
+  for (size_t i = 0; i < 10; ++i) {
+    pool.sendRequestOne(req, cb);
+  }
+  EXPECT_EQ(5, raw[0]->numPending());
+  EXPECT_EQ(5, raw[1]->numPending());
+  EXPECT_EQ(5, pool.outstanding(0));
+
+  // Connection 1 is stuck, everything goes to connection 0.
+  raw[0]->replyAll();
+  EXPECT_EQ(0, pool.outstanding(0));
+  for (size_t i = 0; i < 5; ++i) {
+    pool.sendRequestOne(req, cb);
+    raw[0]->replyAll();
+  }
+  EXPECT_EQ(5, raw[1]->numPending());
+  EXPECT_EQ(10, numReplies);
+
+  raw[1]->replyAll();
+  EXPECT_EQ(15, numReplies);
+  EXPECT_EQ(0, pool.outstanding(1));
+}
+
+TEST(PooledCarbonConnectionImpl, multiTracksOutstanding) {
+  std::vector<FakeConnection*> raw;
+  Pool pool(makeConnections(1, raw));
+  McGetRequest req1("key1");
+  McGetRequest req2("key2");
+  pool.sendRequestMulti<McGetRequest>(
+      {std::cref(req1), std::cref(req2)},
+      [](const McGetRequest&, McGetReply&&) {});
+  EXPECT_EQ(2, pool.outstanding(0));
+  raw[0]->replyAll();
+  EXPECT_EQ(0, pool.outstanding(0));
+}
+
+TEST(PooledCarbonConnectionImpl, growsUnderQueueing) {
+  std::vector<FakeConnection*> raw;
+  Pool::Options options;
+  options.maxConnections = 3;
+  options.growOutstanding = 2;
+  options.growAfterRequests = 3;
+  options.connectionFactory = [&raw]() {
+    auto connection = std::make_unique<FakeConnection>();
+    raw.push_back(connection.get());
+    return connection;
+  };
+  Pool pool(makeConnections(1, raw), options);
+  McGetRequest req("key");
+  auto cb = [](const McGetRequest&, McGetReply&&) {};
+
+  // Replied to right away: never grows.
+  for (size_t i = 0; i < 10; ++i) {
+    pool.sendRequestOne(req, cb);
+    raw[0]->replyAll();
+  }
+  EXPECT_EQ(1, pool.numConnections());
+
+  // Nothing replies: grows once every 3 requests with >= 2 in flight.
+  for (size_t i = 0; i < 100; ++i) {
+    pool.sendRequestOne(req, cb);
+  }
+  EXPECT_EQ(3, pool.numConnections());
+  EXPECT_EQ(3, raw.size());
+  for (auto* connection : raw) {
+    EXPECT_LT(0, connection->numPending());
+    connection->replyAll();
+  }
+}
@@ -11,6 +11,9 @@
 
 #include <gtest/gtest.h>
 
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/carbon/CarbonProtocolReader.h"
 #include "mcrouter/lib/carbon/Util.h"
 #include "mcrouter/lib/carbon/test/Util.h"
 
@@ -35,3 +38,30 @@ TEST(SerializedFormat, integers) {
         }
       }));
 }
+
+TEST(SerializedFormat, skipFields) {
+  // {1: binary "hello", 2: double, 3: int32 42}, with the binary field split
+  // across two buffers of the chain.
+  const uint8_t part1[] = {0x18, 0x05, 'h', 'e'};
+  const uint8_t part2[] = {'l', 'l', 'o', 0x17, 0, 0, 0, 0, 0, 0, 0, 0, 0x15,
+                           84,  0x00};
+  auto buf = folly::IOBuf::copyBuffer(part1, sizeof(part1));
+  buf->appendChain(folly::IOBuf::copyBuffer(part2, sizeof(part2)));
+
+  carbon::CarbonProtocolReader reader{carbon::CarbonCursor(buf.get())};
+  reader.readStructBegin();
+  auto field = reader.readFieldHeader();
+  EXPECT_EQ(carbon::FieldType::Binary, field.first);
+  EXPECT_EQ(1, field.second);
+  reader.skip(field.first);
+  field = reader.readFieldHeader();
+  EXPECT_EQ(carbon::FieldType::Double, field.first);
+  EXPECT_EQ(2, field.second);
+  reader.skip(field.first);
+  field = reader.readFieldHeader();
+  EXPECT_EQ(carbon::FieldType::Int32, field.first);
+  EXPECT_EQ(3, field.second);
+  EXPECT_EQ(42, reader.readRaw<int32_t>());
+  EXPECT_EQ(carbon::FieldType::Stop, reader.readFieldHeader().first);
+  reader.readStructEnd();
+}
@@ -7,6 +7,7 @@
 
 #include "ConfigPreprocessor.h"
 
+#include <cstring>
 #include <memory>
 #include <random>
 
@@ -46,6 +47,39 @@ class NestedLimitGuard {
   size_t& nestedLimit_;
 };
 
+/**
+ * Conservative check for JSONC comments: any "//" or "/*", even inside a
+ * string, counts. Much cheaper than stripComments(), which copies the input
+ * character by character.
+ */
+bool mayHaveComments(StringPiece jsonC) {
+  const char* pos = jsonC.begin();
+  const char* end = jsonC.end();
+  while (pos < end) {
+    pos = static_cast<const char*>(std::memchr(pos, '/', end - pos));
+    if (pos == nullptr || ++pos == end) {
+      return false;
+    }
+    if (*pos == '/' || *pos == '*') {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Parses a JSON string that may contain comments. Configs without comments
+ * (e.g. generated ones, usually the largest) are parsed in place.
+ */
+dynamic parseJsonC(
+    StringPiece jsonC,
+    folly::json::metadata_map* metadataMap = nullptr) {
+  if (!mayHaveComments(jsonC)) {
+    return parseJsonString(jsonC, metadataMap);
+  }
+  return parseJsonString(stripComments(jsonC), metadataMap);
+}
+
 StringPiece asStringPiece(const dynamic& obj, StringPiece objName) {
   checkLogic(
       obj.isString(), "{} is {}, string expected", objName, obj.typeName());
@@ -479,8 +513,7 @@ class ConfigPreprocessor::BuiltIns {
     try {
       auto jsonC = importResolver.import(pathStr);
       // result may contain comments, macros, etc.
-      result =
-          p.expandMacros(parseJsonString(stripComments(jsonC)), Context(p));
+      result = p.expandMacros(parseJsonC(jsonC), Context(p));
     } catch (const std::exception& e) {
       if (auto defaultVal = ctx.tryExpandRawArg("default")) {
         p.importCache_.emplace(pathStr, *defaultVal);
@@ -2096,7 +2129,7 @@ dynamic ConfigPreprocessor::getConfigWithoutMacros(
     folly::StringKeyedUnorderedMap<dynamic> globalParams,
     folly::json::metadata_map* configMetadataMap,
     size_t nestedLimit) {
-  auto config = parseJsonString(stripComments(jsonC), configMetadataMap);
+  auto config = parseJsonC(jsonC, configMetadataMap);
   checkLogic(config.isObject(), "config is not an object");
 
   ConfigPreprocessor prep(
@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+
 #include <folly/dynamic.h>
 
 #include "mcrouter/lib/config/RouteHandleProviderIf.h"
@@ -47,6 +49,18 @@ std::shared_ptr<RouteHandleIf> RouteHandleFactory<RouteHandleIf>::create(
   return std::move(result.back());
 }
 
+template <class RouteHandleIf>
+std::vector<std::shared_ptr<RouteHandleIf>>
+RouteHandleFactory<RouteHandleIf>::createFromProvider(
+    folly::StringPiece type,
+    const folly::dynamic& json) {
+  auto parentHeight = height_;
+  height_ = 0;
+  auto ret = provider_.create(*this, type, json);
+  height_ = std::max(parentHeight, height_ + 1);
+  return ret;
+}
+
 template <class RouteHandleIf>
 const std::vector<std::shared_ptr<RouteHandleIf>>&
 RouteHandleFactory<RouteHandleIf>::createNamed(
@@ -55,6 +69,7 @@ RouteHandleFactory<RouteHandleIf>::createNamed(
   auto seenIt = seen_.find(name);
   if (seenIt != seen_.end()) {
     // we had the same named handle already. Reuse it.
+    height_ = std::max(height_, seenHeights_[name]);
     return seenIt->second;
   }
 
@@ -74,15 +89,20 @@ const std::vector<std::shared_ptr<RouteHandleIf>>&
 RouteHandleFactory<RouteHandleIf>::createNamedImpl(
     folly::StringPiece name,
     const folly::dynamic& json) {
+  auto parentHeight = height_;
+  height_ = 0;
+  std::vector<RouteHandlePtr> ret;
   if (json.isObject()) {
     auto jType = json.get_ptr("type");
     checkLogic(jType, "No type field in RouteHandle json object");
     checkLogic(jType->isString(), "Type field in RouteHandle is not a string");
-    auto ret = provider_.create(*this, jType->stringPiece(), json);
-    return seen_.emplace(name, std::move(ret)).first->second;
+    ret = createFromProvider(jType->stringPiece(), json);
+  } else {
+    ret = createList(json);
   }
-
-  return seen_.emplace(name, createList(json)).first->second;
+  seenHeights_[name] = height_;
+  height_ = std::max(parentHeight, height_);
+  return seen_.emplace(name, std::move(ret)).first->second;
 }
 
 template <class RouteHandleIf>
@@ -107,7 +127,7 @@ RouteHandleFactory<RouteHandleIf>::createList(const folly::dynamic& json) {
       checkLogic(jType, "No type field in RouteHandle json object");
       checkLogic(
           jType->isString(), "Type field in RouteHandle is not a string");
-      return provider_.create(*this, jType->stringPiece(), json);
+      return createFromProvider(jType->stringPiece(), json);
     }
   } else if (json.isString()) {
     if (json.empty()) {
@@ -130,6 +150,7 @@ RouteHandleFactory<RouteHandleIf>::createList(const folly::dynamic& json) {
     auto handlePiece = json.stringPiece();
     auto seenIt = seen_.find(handlePiece);
     if (seenIt != seen_.end()) {
+      height_ = std::max(height_, seenHeights_[handlePiece]);
       return seenIt->second;
     }
 
@@ -141,17 +162,21 @@ RouteHandleFactory<RouteHandleIf>::createList(const folly::dynamic& json) {
       return createNamedImpl(handlePiece, *tmp);
     }
 
+    auto parentHeight = height_;
+    height_ = 0;
     std::vector<RouteHandlePtr> ret;
     auto pipeId = handlePiece.find("|");
     if (pipeId != std::string::npos) { // short form (e.g. HashRoute|ErrorRoute)
       auto type = handlePiece.subpiece(0, pipeId); // split by first '|'
       auto def = handlePiece.subpiece(pipeId + 1);
-      ret = provider_.create(*this, type, def);
+      ret = createFromProvider(type, def);
     } else {
       // assume it is a short form of route without children (e.g. ErrorRoute)
-      ret = provider_.create(*this, handlePiece, nullptr);
+      ret = createFromProvider(handlePiece, nullptr);
     }
 
+    seenHeights_.emplace(handlePiece, height_);
+    height_ = std::max(parentHeight, height_);
     seen_.emplace(handlePiece, ret);
     return ret;
   }
@@ -79,6 +79,14 @@ class RouteHandleFactory {
     return threadId_;
   }
 
+  /**
+   * Height (in route handles) of the tallest tree created so far, including
+   * reused named handles.
+   */
+  size_t maxTreeHeight() const noexcept {
+    return height_;
+  }
+
   /**
    * Pushes a list of route_handles that will be used the next time this class
    * sees $children_list$ in the config. The list of route handles are kept in
@@ -106,12 +114,20 @@ class RouteHandleFactory {
   folly::StringKeyedUnorderedMap<const folly::dynamic*> registered_;
   /// Named routes we've already parsed
   folly::StringKeyedUnorderedMap<std::vector<RouteHandlePtr>> seen_;
+  /// Heights of the trees in seen_
+  folly::StringKeyedUnorderedMap<size_t> seenHeights_;
   /// Thread where route handles created by this factory will be used
   size_t threadId_;
+  /// Height of the tallest tree created at the current nesting level
+  size_t height_{0};
 
   // list of servers that should be used to replace "$children_list$" in config.
   std::stack<std::vector<RouteHandlePtr>> childrenLists_;
 
+  std::vector<RouteHandlePtr> createFromProvider(
+      folly::StringPiece type,
+      const folly::dynamic& json);
+
   const std::vector<RouteHandlePtr>& createNamed(
       folly::StringPiece name,
       const folly::dynamic& json);
@@ -157,3 +157,26 @@ TEST(ConfigPreprocessorTest, comments) {
 
   EXPECT_EQ(orig, expand);
 }
+
+TEST(ConfigPreprocessorTest, slashesWithoutComments) {
+  MockImportResolver resolver;
+  folly::json::metadata_map configMetadataMap;
+
+  // Parsed in place: no sequence that could start a comment.
+  auto json = ConfigPreprocessor::getConfigWithoutMacros(
+      R"({ "route": "/region/cluster/", "a": 1 })",
+      resolver,
+      kGlobalParams,
+      &configMetadataMap);
+  EXPECT_EQ("/region/cluster/", json["route"].asString());
+  EXPECT_EQ(1, json["a"].asInt());
+
+  // Looks like a comment, but is inside a string.
+  json = ConfigPreprocessor::getConfigWithoutMacros(
+      R"({ "url": "http://host/*path*/", "b": 2 } // comment)",
+      resolver,
+      kGlobalParams,
+      &configMetadataMap);
+  EXPECT_EQ("http://host/*path*/", json["url"].asString());
+  EXPECT_EQ(2, json["b"].asInt());
+}
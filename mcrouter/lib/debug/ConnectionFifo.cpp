@@ -185,6 +185,7 @@ bool ConnectionFifo::startMessage(
   currentMessageHeader_.setTypeId(typeId);
   currentMessageHeader_.setTimeUs(timeSinceEpoch());
   nextPacketId_ = 0;
+  skipMessage_ = false;
   return true;
 }
 
@@ -246,7 +247,12 @@ bool ConnectionFifo::writeData(
   // | PACKET HEADER | PACKET BODY |
   // -------------------------------
 
-  if (!isConnected() || iovcnt == 0) {
+  if (!isConnected() || iovcnt == 0 || skipMessage_) {
+    return false;
+  }
+
+  if (nextPacketId_ == 0 && !debugFifo_->shouldWrite(iov, iovcnt)) {
+    skipMessage_ = true;
     return false;
   }
 
@@ -69,6 +69,8 @@ class ConnectionFifo {
   std::shared_ptr<Fifo> debugFifo_;
   MessageHeader currentMessageHeader_;
   uint32_t nextPacketId_{0};
+  // Current message was sampled out or filtered by the reader.
+  bool skipMessage_{false};
 };
 
 } // namespace memcache
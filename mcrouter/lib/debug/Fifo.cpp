@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <cstring>
 
 #include <boost/filesystem.hpp>
@@ -19,6 +20,7 @@
 #include <glog/logging.h>
 
 #include <folly/FileUtil.h>
+#include <folly/Range.h>
 
 #include "mcrouter/lib/fbi/cpp/util.h"
 
@@ -50,12 +52,20 @@ bool isFifo(const char* fifoPath) {
 
 } // anonymous namespace
 
-Fifo::Fifo(std::string path) : path_(std::move(path)) {
+Fifo::Fifo(std::string path, size_t ringCapacity) : path_(std::move(path)) {
   if (FOLLY_UNLIKELY(path_.empty())) {
     throw std::invalid_argument("Fifo path cannot be empty");
   }
   auto dir = boost::filesystem::path(path_).parent_path().string();
   ensureDirExistsAndWritable(dir);
+  if (ringCapacity > 0) {
+    try {
+      ring_ = std::make_unique<ShmRingWriter>(path_, ringCapacity);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Falling back to a named pipe for debug fifo: "
+                 << e.what();
+    }
+  }
 }
 
 Fifo::~Fifo() {
@@ -68,6 +78,15 @@ Fifo::~Fifo() {
 }
 
 bool Fifo::tryConnect() noexcept {
+  if (ring_) {
+    auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+    bool hasReader = ring_->hasReader(nowMs);
+    ringHasReader_.store(hasReader, std::memory_order_relaxed);
+    return hasReader;
+  }
+
   if (isConnected()) {
     return true;
   }
@@ -113,7 +132,37 @@ bool Fifo::write(void* buf, size_t len) noexcept {
   return write(iov, 1);
 }
 
+bool Fifo::shouldWrite(const struct iovec* iov, size_t iovcnt) noexcept {
+  if (!ring_) {
+    return true;
+  }
+  auto samplePeriod = ring_->samplePeriod();
+  if (samplePeriod > 1) {
+    if (sampleCountdown_ > 1 && sampleCountdown_ <= samplePeriod) {
+      --sampleCountdown_;
+      return false;
+    }
+    sampleCountdown_ = samplePeriod;
+  }
+  auto match = ring_->match();
+  if (match.empty()) {
+    return true;
+  }
+  // Keys are not split across iovecs by the serializers.
+  for (size_t i = 0; i < iovcnt; ++i) {
+    folly::StringPiece data(
+        static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    if (data.find(match) != folly::StringPiece::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool Fifo::write(const struct iovec* iov, size_t iovcnt) noexcept {
+  if (ring_) {
+    return ring_->write(iov, iovcnt);
+  }
   if (folly::writevNoInt(fd_, iov, iovcnt) == -1) {
     if (errno != EAGAIN) {
       PLOG(WARNING) << "Error writing to debug pipe.";
@@ -10,8 +10,11 @@
 #include <sys/uio.h>
 
 #include <atomic>
+#include <memory>
 #include <string>
 
+#include "mcrouter/lib/debug/ShmRing.h"
+
 namespace facebook {
 namespace memcache {
 
@@ -19,8 +22,14 @@ namespace memcache {
  * Writes data to a named pipe (fifo) for debugging purposes.
  * Instances of this file have a one-to-one mapping with actual FIFOs on disk.
  *
+ * If created with a ring capacity, data is instead appended to a shared
+ * memory ring at the same path (see ShmRingWriter), which never blocks or
+ * fails on a slow reader, and is "connected" while a reader heartbeats.
+ *
  * Notes:
  *  - Unless specified otherwise, methods of this class are thread-safe.
+ *    In ring mode, write() and shouldWrite() must only be called from the
+ *    thread the fifo belongs to (see FifoManager::fetchThreadLocal()).
  *  - Life of Fifo is managed by FifoManager.
  */
 class Fifo {
@@ -48,9 +57,16 @@ class Fifo {
    * Tells whether this fifo is connectted.
    */
   bool isConnected() const noexcept {
-    return fd_ >= 0;
+    return ring_ ? ringHasReader_.load(std::memory_order_relaxed) : fd_ >= 0;
   }
 
+  /**
+   * Whether to write a message starting with `iov`, according to the
+   * sampling and filtering asked for by the ring reader. Always true for
+   * named pipes.
+   */
+  bool shouldWrite(const struct iovec* iov, size_t iovcnt) noexcept;
+
   /**
    * Writes data to the FIFO.
    *
@@ -71,13 +87,18 @@ class Fifo {
    *
    * @throw std::invalid_argument  If path is empty.
    */
-  explicit Fifo(std::string path);
+  explicit Fifo(std::string path, size_t ringCapacity = 0);
 
   // Path of the fifo
   const std::string path_;
   // Fifo file descriptor.
   std::atomic<int> fd_{-1};
 
+  // Ring mode.
+  std::unique_ptr<ShmRingWriter> ring_;
+  std::atomic<bool> ringHasReader_{false};
+  uint32_t sampleCountdown_{0};
+
   /**
    * Disconnects the pipe.
    */
@@ -91,10 +91,17 @@ std::shared_ptr<Fifo> FifoManager::find(const std::string& fifoPath) {
 }
 
 std::shared_ptr<Fifo> FifoManager::createAndStore(const std::string& fifoPath) {
-  return fifos_.withWLock([&fifoPath](auto& fifos) {
-    auto it =
-        fifos.emplace(fifoPath, std::shared_ptr<Fifo>(new Fifo(fifoPath)));
-    return it.first->second;
+  auto ringCapacity = shmRingCapacity_.load(std::memory_order_relaxed);
+  return fifos_.withWLock([&fifoPath, ringCapacity](auto& fifos) {
+    auto it = fifos.find(fifoPath);
+    if (it == fifos.end()) {
+      it = fifos
+               .emplace(
+                   fifoPath,
+                   std::shared_ptr<Fifo>(new Fifo(fifoPath, ringCapacity)))
+               .first;
+    }
+    return it->second;
   });
 }
 
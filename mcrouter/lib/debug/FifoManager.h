@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <memory>
 #include <thread>
@@ -43,6 +44,14 @@ class FifoManager {
    */
   std::shared_ptr<Fifo> fetchThreadLocal(const std::string& fifoBasePath);
 
+  /**
+   * Fifos created from now on write to a shared memory ring of this many
+   * bytes instead of a named pipe (see Fifo). 0 for named pipes.
+   */
+  void setShmRingCapacity(size_t bytes) {
+    shmRingCapacity_.store(bytes, std::memory_order_relaxed);
+  }
+
   /**
    * Removes all elements from the fifo manager.
    */
@@ -62,6 +71,8 @@ class FifoManager {
       folly::SharedMutex>
       fifos_;
 
+  std::atomic<size_t> shmRingCapacity_{0};
+
   // Thread that connects to fifos
   std::thread thread_;
   bool running_{true};
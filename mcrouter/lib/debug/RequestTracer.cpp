@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RequestTracer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <folly/Conv.h>
+#include <folly/Random.h>
+#include <folly/hash/Hash.h>
+#include <folly/json.h>
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+void appendHex(uint64_t value, std::string& out) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    out.push_back(kDigits[(value >> shift) & 0xf]);
+  }
+}
+
+} // anonymous namespace
+
+RequestTracer::Scope::Scope(
+    RequestTracer& tracer,
+    Context& context,
+    folly::StringPiece name) {
+  if (!context.sampled()) {
+    return;
+  }
+  tracer_ = &tracer;
+  context_ = &context;
+  parentSpanId_ = context.spanId;
+  name_ = name.str();
+  startNs_ = nowNs();
+  context.spanId = tracer.newId();
+}
+
+RequestTracer::Scope::~Scope() {
+  if (tracer_ == nullptr) {
+    return;
+  }
+  Span span;
+  span.traceIdHigh = context_->traceIdHigh;
+  span.traceIdLow = context_->traceIdLow;
+  span.spanId = context_->spanId;
+  span.parentSpanId = parentSpanId_;
+  span.name = std::move(name_);
+  span.startNs = startNs_;
+  span.endNs = nowNs();
+  tracer_->record(std::move(span));
+  context_->spanId = parentSpanId_;
+}
+
+RequestTracer::RequestTracer(size_t samplePeriod, size_t capacity)
+    : samplePeriod_(std::max<size_t>(samplePeriod, 1)),
+      sampleCountdown_(samplePeriod_),
+      idSeed_(folly::Random::secureRand64()),
+      // One slot of a ProducerConsumerQueue is always left empty.
+      spans_(std::max<size_t>(capacity, 1) + 1) {}
+
+void RequestTracer::finishTrace(
+    const Context& context,
+    folly::StringPiece name,
+    uint64_t startNs) {
+  if (!context.sampled()) {
+    return;
+  }
+  Span span;
+  span.traceIdHigh = context.traceIdHigh;
+  span.traceIdLow = context.traceIdLow;
+  span.spanId = context.spanId;
+  span.name = name.str();
+  span.startNs = startNs;
+  span.endNs = nowNs();
+  record(std::move(span));
+}
+
+void RequestTracer::record(Span span) {
+  if (!spans_.write(std::move(span))) {
+    numDropped_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RequestTracer::drain(std::vector<Span>& spans) {
+  while (auto* span = spans_.frontPtr()) {
+    spans.push_back(std::move(*span));
+    spans_.popFront();
+  }
+}
+
+/* static */ uint64_t RequestTracer::nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+RequestTracer::Context RequestTracer::newTrace() {
+  Context context;
+  context.traceIdHigh = idSeed_;
+  context.traceIdLow = newId();
+  context.spanId = newId();
+  return context;
+}
+
+uint64_t RequestTracer::newId() {
+  // Distinct for every call, and never 0 (an invalid id in OpenTelemetry).
+  uint64_t id;
+  do {
+    id = folly::hash::twang_mix64(idSeed_ ^ ++nextId_);
+  } while (id == 0);
+  return id;
+}
+
+/* static */ void RequestTracer::appendOtlpJson(
+    const std::vector<Span>& spans,
+    folly::StringPiece serviceName,
+    std::string& out) {
+  out.append(
+      "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":"
+      "\"service.name\",\"value\":{\"stringValue\":");
+  const folly::json::serialization_opts opts;
+  folly::json::escapeString(serviceName, out, opts);
+  out.append(
+      "}}]},\"scopeSpans\":[{\"scope\":{\"name\":\"mcrouter\"},"
+      "\"spans\":[");
+  bool first = true;
+  for (const auto& span : spans) {
+    if (!first) {
+      out.push_back(',');
+    }
+    first = false;
+    out.append("{\"traceId\":\"");
+    appendHex(span.traceIdHigh, out);
+    appendHex(span.traceIdLow, out);
+    out.append("\",\"spanId\":\"");
+    appendHex(span.spanId, out);
+    if (span.parentSpanId != 0) {
+      out.append("\",\"parentSpanId\":\"");
+      appendHex(span.parentSpanId, out);
+    }
+    out.append("\",\"name\":");
+    folly::json::escapeString(span.name, out, opts);
+    // 64 bit integers are strings in OTLP/JSON.
+    out.append(",\"startTimeUnixNano\":\"");
+    folly::toAppend(span.startNs, &out);
+    out.append("\",\"endTimeUnixNano\":\"");
+    folly::toAppend(span.endNs, &out);
+    out.append("\"}");
+  }
+  out.append("]}]}]}\n");
+}
+
+} // namespace memcache
+} // namespace facebook
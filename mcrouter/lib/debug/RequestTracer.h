@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <folly/ProducerConsumerQueue.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Sampled tracing of requests, as OpenTelemetry style spans.
+ *
+ * One in every `samplePeriod` requests is traced: startTrace() gives it a
+ * 128 bit trace id and a root span; every Scope then records a child span of
+ * the innermost Scope alive in the same Context. Unsampled requests only pay
+ * for a counter decrement, and for checking Context::sampled() in every
+ * Scope.
+ *
+ * Finished spans are queued in a lock-free single producer single consumer
+ * buffer of `capacity` spans: only the thread the requests run on records
+ * spans, while drain() is called from another (exporter) thread. Spans are
+ * dropped when the buffer is full.
+ */
+class RequestTracer {
+ public:
+  struct Span {
+    uint64_t traceIdHigh{0};
+    uint64_t traceIdLow{0};
+    uint64_t spanId{0};
+    // 0 for the root span of a trace.
+    uint64_t parentSpanId{0};
+    std::string name;
+    // Unix time, in ns.
+    uint64_t startNs{0};
+    uint64_t endNs{0};
+  };
+
+  /**
+   * Where a request is in its trace: the span new spans are children of.
+   */
+  struct Context {
+    uint64_t traceIdHigh{0};
+    uint64_t traceIdLow{0};
+    uint64_t spanId{0};
+
+    bool sampled() const {
+      return spanId != 0;
+    }
+  };
+
+  /**
+   * Records a span for its lifetime, if `context` is sampled. The span is
+   * the current one of `context` while the Scope is alive.
+   */
+  class Scope {
+   public:
+    Scope(RequestTracer& tracer, Context& context, folly::StringPiece name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    RequestTracer* tracer_{nullptr};
+    Context* context_{nullptr};
+    uint64_t parentSpanId_{0};
+    std::string name_;
+    uint64_t startNs_{0};
+  };
+
+  RequestTracer(size_t samplePeriod, size_t capacity);
+
+  RequestTracer(const RequestTracer&) = delete;
+  RequestTracer& operator=(const RequestTracer&) = delete;
+
+  /**
+   * @return  The context of a new trace, whose root span (see finishTrace())
+   *          starts now, for one in samplePeriod calls. An unsampled context
+   *          otherwise.
+   */
+  Context startTrace() {
+    if (sampleCountdown_ > 1) {
+      --sampleCountdown_;
+      return Context();
+    }
+    sampleCountdown_ = samplePeriod_;
+    return newTrace();
+  }
+
+  /**
+   * Records the root span of a context returned by startTrace(), from the
+   * call to startTrace() until now.
+   *
+   * @param startNs  What nowNs() returned as startTrace() was called.
+   */
+  void finishTrace(
+      const Context& context,
+      folly::StringPiece name,
+      uint64_t startNs);
+
+  /**
+   * Queues a finished span for export. Thread safe with drain() only.
+   */
+  void record(Span span);
+
+  /**
+   * Moves the queued spans to `spans`. Only one thread may call it at a
+   * time.
+   */
+  void drain(std::vector<Span>& spans);
+
+  /**
+   * Spans dropped so far because the buffer was full.
+   */
+  uint64_t numDropped() const {
+    return numDropped_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Unix time, in ns.
+   */
+  static uint64_t nowNs();
+
+  /**
+   * Appends `spans` to `out` as an OTLP/JSON ExportTraceServiceRequest
+   * (OpenTelemetry protocol), on a single line.
+   */
+  static void appendOtlpJson(
+      const std::vector<Span>& spans,
+      folly::StringPiece serviceName,
+      std::string& out);
+
+ private:
+  const size_t samplePeriod_;
+  size_t sampleCountdown_;
+  // Random per tracer, so that ids of several proxies and processes don't
+  // collide.
+  const uint64_t idSeed_;
+  uint64_t nextId_{0};
+
+  folly::ProducerConsumerQueue<Span> spans_;
+  std::atomic<uint64_t> numDropped_{0};
+
+  Context newTrace();
+  uint64_t newId();
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RouteProfiler.h"
+
+#include <time.h>
+
+#include <algorithm>
+
+#include <folly/Format.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/lib/debug/Fifo.h"
+#include "mcrouter/lib/debug/FifoManager.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+uint64_t threadCpuNs() noexcept {
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void sortByCpu(std::vector<RouteProfiler::Entry>& entries) {
+  std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+    return a.cpuUs > b.cpuUs;
+  });
+}
+
+} // anonymous namespace
+
+RouteProfiler::Scope::Scope(
+    RouteProfiler& profiler,
+    folly::StringPiece name) noexcept {
+  if (profiler.currentFiber_ == 0 || !folly::fibers::onFiber()) {
+    return;
+  }
+  if (profiler.currentState_ == nullptr) {
+    // Not inside a sampled request yet: sample this one?
+    if (profiler.sampleCountdown_ > 1) {
+      --profiler.sampleCountdown_;
+      return;
+    }
+    profiler.sampleCountdown_ = profiler.samplePeriod_;
+    profiler.currentState_ = &profiler.fibers_[profiler.currentFiber_];
+    profiler.segmentStartNs_ = threadCpuNs();
+  }
+  ++profiler.currentState_->depth;
+
+  profiler_ = &profiler;
+  name_ = name;
+  wallStart_ = std::chrono::steady_clock::now();
+  cpuStartNs_ = profiler.fiberCpuNs();
+}
+
+RouteProfiler::Scope::~Scope() {
+  if (profiler_ == nullptr || profiler_->currentState_ == nullptr) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  auto wallNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - wallStart_)
+          .count();
+  profiler_->record(name_, wallNs, profiler_->fiberCpuNs() - cpuStartNs_);
+
+  if (--profiler_->currentState_->depth == 0) {
+    profiler_->fibers_.erase(profiler_->currentFiber_);
+    profiler_->currentState_ = nullptr;
+  }
+  profiler_->maybeDump(now);
+}
+
+RouteProfiler::RouteProfiler(
+    size_t samplePeriod,
+    std::string fifoBasePath,
+    std::chrono::milliseconds dumpInterval)
+    : samplePeriod_(std::max<size_t>(samplePeriod, 1)),
+      sampleCountdown_(samplePeriod_),
+      fifoBasePath_(std::move(fifoBasePath)),
+      dumpInterval_(dumpInterval) {}
+
+void RouteProfiler::starting(
+    uintptr_t id,
+    CallbackType callbackType) noexcept {
+  if (callbackType != CallbackType::Fiber) {
+    return;
+  }
+  currentFiber_ = id;
+  auto it = fibers_.find(id);
+  if (it != fibers_.end()) {
+    currentState_ = &it->second;
+    segmentStartNs_ = threadCpuNs();
+  } else {
+    currentState_ = nullptr;
+  }
+}
+
+void RouteProfiler::stopped(
+    uintptr_t /* id */,
+    CallbackType callbackType) noexcept {
+  if (callbackType != CallbackType::Fiber) {
+    return;
+  }
+  if (currentState_) {
+    currentState_->cpuNs += threadCpuNs() - segmentStartNs_;
+  }
+  currentFiber_ = 0;
+  currentState_ = nullptr;
+}
+
+uint64_t RouteProfiler::fiberCpuNs() const noexcept {
+  return currentState_->cpuNs + (threadCpuNs() - segmentStartNs_);
+}
+
+void RouteProfiler::record(
+    folly::StringPiece name,
+    uint64_t wallNs,
+    uint64_t cpuNs) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(name);
+  if (it == entries_.end()) {
+    it = entries_.emplace(name.str(), Entry{}).first;
+    it->second.name = name.str();
+  }
+  ++it->second.samples;
+  it->second.wallUs += wallNs / 1000;
+  it->second.cpuUs += cpuNs / 1000;
+}
+
+std::vector<RouteProfiler::Entry> RouteProfiler::snapshot() const {
+  std::vector<Entry> result;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.reserve(entries_.size());
+    for (const auto& it : entries_) {
+      result.push_back(it.second);
+    }
+  }
+  sortByCpu(result);
+  return result;
+}
+
+void RouteProfiler::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+std::vector<RouteProfiler::Entry> RouteProfiler::merge(
+    const std::vector<std::vector<Entry>>& snapshots) {
+  folly::F14FastMap<std::string, Entry> merged;
+  for (const auto& snapshot : snapshots) {
+    for (const auto& entry : snapshot) {
+      auto& to = merged[entry.name];
+      to.name = entry.name;
+      to.samples += entry.samples;
+      to.wallUs += entry.wallUs;
+      to.cpuUs += entry.cpuUs;
+    }
+  }
+  std::vector<Entry> result;
+  result.reserve(merged.size());
+  for (auto& it : merged) {
+    result.push_back(std::move(it.second));
+  }
+  sortByCpu(result);
+  return result;
+}
+
+void RouteProfiler::maybeDump(std::chrono::steady_clock::time_point now) {
+  if (fifoBasePath_.empty() || now < nextDump_) {
+    return;
+  }
+  nextDump_ = now + dumpInterval_;
+  if (!fifo_) {
+    // Fetched here rather than in the constructor, so that we get the fifo
+    // of the thread the profiled routes run on.
+    if (auto fifoManager = FifoManager::getInstance()) {
+      fifo_ = fifoManager->fetchThreadLocal(fifoBasePath_);
+    }
+  }
+  if (!fifo_ || !fifo_->isConnected()) {
+    return;
+  }
+
+  auto header = folly::sformat(
+      "# {} route profile: samples wall_us cpu_us wait_us\n",
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+  iovec iov{const_cast<char*>(header.data()), header.size()};
+  if (!fifo_->write(&iov, 1)) {
+    return;
+  }
+  // One write per line, so that lines are never split.
+  for (const auto& entry : snapshot()) {
+    auto line = folly::sformat(
+        "{} {} {} {} {}\n",
+        entry.name,
+        entry.samples,
+        entry.wallUs,
+        entry.cpuUs,
+        entry.waitUs());
+    iov = {const_cast<char*>(line.data()), line.size()};
+    if (!fifo_->write(&iov, 1)) {
+      return;
+    }
+  }
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <folly/ExecutionObserver.h>
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+
+class Fifo;
+
+/**
+ * Sampled accounting of the time requests spend in route handles, aggregated
+ * by route name.
+ *
+ * One in every `samplePeriod` requests is profiled: every route handle it
+ * goes through (see Scope) records its wall time and the CPU time its fiber
+ * actually ran for. The difference is time spent waiting (on the network,
+ * or for other fibers to yield). Times are inclusive of children, like the
+ * frames of a flame graph.
+ *
+ * CPU time is measured per fiber, by observing the fiber manager: attach the
+ * profiler to every fiber manager the profiled routes run on with
+ * FiberManager::addObserver().
+ *
+ * All profiled code and the observer callbacks run on a single thread; only
+ * snapshot() and clear() can be called from other threads.
+ */
+class RouteProfiler : public folly::ExecutionObserver {
+ public:
+  struct Entry {
+    std::string name;
+    uint64_t samples{0};
+    uint64_t wallUs{0};
+    uint64_t cpuUs{0};
+
+    uint64_t waitUs() const {
+      return wallUs > cpuUs ? wallUs - cpuUs : 0;
+    }
+  };
+
+  /**
+   * Times one route handle's route() call, if this request is sampled.
+   */
+  class Scope {
+   public:
+    Scope(RouteProfiler& profiler, folly::StringPiece name) noexcept;
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    RouteProfiler* profiler_{nullptr};
+    folly::StringPiece name_;
+    std::chrono::steady_clock::time_point wallStart_;
+    uint64_t cpuStartNs_{0};
+  };
+
+  /**
+   * @param samplePeriod  Profile one in every samplePeriod requests.
+   * @param fifoBasePath  If not empty, the profile is written as text to the
+   *                      thread local fifo at this path (see FifoManager)
+   *                      at most once every dumpInterval.
+   */
+  RouteProfiler(
+      size_t samplePeriod,
+      std::string fifoBasePath = "",
+      std::chrono::milliseconds dumpInterval = std::chrono::seconds(1));
+
+  RouteProfiler(const RouteProfiler&) = delete;
+  RouteProfiler& operator=(const RouteProfiler&) = delete;
+
+  void starting(uintptr_t id, CallbackType callbackType) noexcept override;
+  void stopped(uintptr_t id, CallbackType callbackType) noexcept override;
+
+  /**
+   * @return  copy of all entries, sorted by descending CPU time.
+   */
+  std::vector<Entry> snapshot() const;
+
+  void clear();
+
+  /**
+   * Sums up snapshots of several profilers (e.g. one per proxy), sorted by
+   * descending CPU time.
+   */
+  static std::vector<Entry> merge(
+      const std::vector<std::vector<Entry>>& snapshots);
+
+ private:
+  struct FiberState {
+    // Number of Scopes alive on this fiber.
+    size_t depth{0};
+    // CPU time spent running this fiber while it was tracked.
+    uint64_t cpuNs{0};
+  };
+
+  const size_t samplePeriod_;
+  size_t sampleCountdown_;
+
+  // Fibers with a sampled request in progress.
+  folly::F14FastMap<uintptr_t, FiberState> fibers_;
+  // Fiber running right now, and its state if tracked.
+  uintptr_t currentFiber_{0};
+  FiberState* currentState_{nullptr};
+  // Thread CPU time when the current fiber was switched to.
+  uint64_t segmentStartNs_{0};
+
+  mutable std::mutex mutex_;
+  folly::F14FastMap<std::string, Entry> entries_;
+
+  const std::string fifoBasePath_;
+  std::shared_ptr<Fifo> fifo_;
+  const std::chrono::milliseconds dumpInterval_;
+  std::chrono::steady_clock::time_point nextDump_;
+
+  /**
+   * CPU time the current fiber has run for while tracked, including the
+   * segment in progress.
+   */
+  uint64_t fiberCpuNs() const noexcept;
+
+  void record(folly::StringPiece name, uint64_t wallNs, uint64_t cpuNs);
+
+  void maybeDump(std::chrono::steady_clock::time_point now);
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ShmRing.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <glog/logging.h>
+
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/lang/Bits.h>
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+// The producer stops writing when the reader is silent for longer.
+constexpr uint64_t kReaderTimeoutMs = 3000;
+constexpr size_t kRecordAlignment = 8;
+constexpr size_t kRecordHeaderSize = sizeof(uint32_t);
+
+size_t alignedRecordSize(size_t len) {
+  return (kRecordHeaderSize + len + kRecordAlignment - 1) &
+      ~(kRecordAlignment - 1);
+}
+
+} // anonymous namespace
+
+ShmRingWriter::ShmRingWriter(const std::string& path, size_t capacity) {
+  capacity = folly::nextPowTwo(std::max<size_t>(capacity, 1 << 16));
+  mappedSize_ = sizeof(ShmRingHeader) + capacity;
+
+  // Readers may still have the previous ring mapped: replace the file
+  // instead of truncating it under them.
+  ::unlink(path.c_str());
+  int fd = folly::openNoInt(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+  if (fd < 0) {
+    throw std::runtime_error(folly::sformat(
+        "Failed to create ring '{}': {}", path, strerror(errno)));
+  }
+  // Readers run as other users.
+  fchmod(fd, 0666);
+  if (ftruncate(fd, mappedSize_) != 0) {
+    folly::closeNoInt(fd);
+    throw std::runtime_error(folly::sformat(
+        "Failed to resize ring '{}': {}", path, strerror(errno)));
+  }
+  void* mem =
+      mmap(nullptr, mappedSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  folly::closeNoInt(fd);
+  if (mem == MAP_FAILED) {
+    throw std::runtime_error(folly::sformat(
+        "Failed to map ring '{}': {}", path, strerror(errno)));
+  }
+
+  // The file is freshly truncated, so everything else is already zero.
+  header_ = static_cast<ShmRingHeader*>(mem);
+  header_->version = ShmRingHeader::kVersion;
+  header_->capacity = capacity;
+  data_ = static_cast<char*>(mem) + sizeof(ShmRingHeader);
+  // Published last: readers only trust rings with the magic set.
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = ShmRingHeader::kMagic;
+}
+
+ShmRingWriter::~ShmRingWriter() {
+  munmap(header_, mappedSize_);
+}
+
+bool ShmRingWriter::hasReader(uint64_t nowMs) const noexcept {
+  return header_->readerHeartbeatMs.load(std::memory_order_relaxed) +
+      kReaderTimeoutMs >=
+      nowMs;
+}
+
+folly::StringPiece ShmRingWriter::match() const noexcept {
+  auto size = std::min<size_t>(
+      header_->matchSize.load(std::memory_order_acquire),
+      ShmRingHeader::kMatchMaxSize);
+  return folly::StringPiece(header_->match, size);
+}
+
+bool ShmRingWriter::write(const struct iovec* iov, size_t iovcnt) noexcept {
+  const uint64_t capacity = header_->capacity;
+  size_t len = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    len += iov[i].iov_len;
+  }
+  const size_t recordSize = alignedRecordSize(len);
+  // Keep several records in flight, so that readers have time to copy them.
+  if (recordSize > capacity / 4) {
+    return false;
+  }
+
+  auto pos = header_->writePos.load(std::memory_order_relaxed);
+  size_t offset = pos & (capacity - 1);
+  char* marker = nullptr;
+  if (offset + recordSize > capacity) {
+    // Records are never split: skip the end of the buffer.
+    marker = data_ + offset;
+    pos += capacity - offset;
+    offset = 0;
+  }
+
+  // Readers detect overwritten records by checking reservePos after
+  // copying them, so push it forward before touching the memory.
+  header_->reservePos.store(pos + recordSize, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  if (marker) {
+    uint32_t markerLE = folly::Endian::little(kWrapMarker);
+    std::memcpy(marker, &markerLE, sizeof(markerLE));
+  }
+  uint32_t lenLE = folly::Endian::little(static_cast<uint32_t>(len));
+  std::memcpy(data_ + offset, &lenLE, sizeof(lenLE));
+  char* dest = data_ + offset + kRecordHeaderSize;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    std::memcpy(dest, iov[i].iov_base, iov[i].iov_len);
+    dest += iov[i].iov_len;
+  }
+  header_->writePos.store(pos + recordSize, std::memory_order_release);
+  return true;
+}
+
+ShmRingReader::ShmRingReader(
+    ShmRingHeader* header,
+    size_t mappedSize,
+    uint64_t inode)
+    : header_(header),
+      data_(reinterpret_cast<const char*>(header) + sizeof(ShmRingHeader)),
+      mappedSize_(mappedSize),
+      inode_(inode),
+      readPos_(header->writePos.load(std::memory_order_acquire)) {}
+
+/* static */ std::unique_ptr<ShmRingReader> ShmRingReader::open(
+    const std::string& path) {
+  int fd = folly::openNoInt(path.c_str(), O_RDWR);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+    folly::closeNoInt(fd);
+    return nullptr;
+  }
+  size_t size = st.st_size;
+  void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  folly::closeNoInt(fd);
+  if (mem == MAP_FAILED) {
+    return nullptr;
+  }
+  auto* header = static_cast<ShmRingHeader*>(mem);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != ShmRingHeader::kMagic ||
+      header->version != ShmRingHeader::kVersion ||
+      !folly::isPowTwo(header->capacity) ||
+      sizeof(ShmRingHeader) + header->capacity != size) {
+    munmap(mem, size);
+    return nullptr;
+  }
+  return std::unique_ptr<ShmRingReader>(
+      new ShmRingReader(header, size, st.st_ino));
+}
+
+ShmRingReader::~ShmRingReader() {
+  munmap(header_, mappedSize_);
+}
+
+void ShmRingReader::heartbeat(
+    uint64_t nowMs,
+    uint32_t samplePeriod,
+    folly::StringPiece match) {
+  match = match.subpiece(0, ShmRingHeader::kMatchMaxSize);
+  if (folly::StringPiece(
+          header_->match,
+          header_->matchSize.load(std::memory_order_relaxed)) != match) {
+    // Disable the filter while it is being changed.
+    header_->matchSize.store(0, std::memory_order_release);
+    std::memcpy(header_->match, match.data(), match.size());
+    header_->matchSize.store(match.size(), std::memory_order_release);
+  }
+  header_->samplePeriod.store(samplePeriod, std::memory_order_relaxed);
+  header_->readerHeartbeatMs.store(nowMs, std::memory_order_relaxed);
+}
+
+uint64_t ShmRingReader::read(
+    folly::FunctionRef<void(folly::ByteRange)> onRecord) {
+  const uint64_t capacity = header_->capacity;
+  uint64_t lost = 0;
+  auto writePos = header_->writePos.load(std::memory_order_acquire);
+  while (readPos_ < writePos) {
+    if (writePos - readPos_ > capacity) {
+      // Lapped by the producer.
+      ++lost;
+      readPos_ = writePos;
+      break;
+    }
+    size_t offset = readPos_ & (capacity - 1);
+    uint32_t len;
+    std::memcpy(&len, data_ + offset, sizeof(len));
+    len = folly::Endian::little(len);
+    if (len == ShmRingWriter::kWrapMarker) {
+      readPos_ += capacity - offset;
+      continue;
+    }
+    size_t recordSize = alignedRecordSize(len);
+    if (len > capacity || offset + recordSize > capacity) {
+      // Garbage: overwritten while we were reading the length.
+      ++lost;
+      readPos_ = writePos;
+      break;
+    }
+    record_.assign(data_ + offset + kRecordHeaderSize, len);
+
+    // Valid only if the producer didn't come back to this record meanwhile.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header_->reservePos.load(std::memory_order_relaxed) - readPos_ >
+        capacity) {
+      ++lost;
+      readPos_ = writePos;
+      break;
+    }
+    readPos_ += recordSize;
+    onRecord(folly::ByteRange(folly::StringPiece(record_)));
+  }
+  return lost;
+}
+
+} // namespace memcache
+} // namespace facebook
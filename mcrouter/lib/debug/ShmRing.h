@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Control block at the beginning of a shared memory ring file.
+ * Followed by `capacity` bytes of records.
+ */
+struct ShmRingHeader {
+  static constexpr uint32_t kMagic = 0xfaceb10c;
+  static constexpr uint32_t kVersion = 1;
+  static constexpr size_t kMatchMaxSize = 256;
+
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+
+  // Written by the producer only. Records are complete up to writePos;
+  // reservePos is past the end of the record being written, if any.
+  std::atomic<uint64_t> writePos;
+  std::atomic<uint64_t> reservePos;
+
+  // Written by readers only.
+  // Milliseconds since epoch of the last time a reader was active.
+  std::atomic<uint64_t> readerHeartbeatMs;
+  // Write only one in every samplePeriod messages (0 or 1: all of them).
+  std::atomic<uint32_t> samplePeriod;
+  // Length of `match`, 0 for no filtering.
+  std::atomic<uint32_t> matchSize;
+  // Only write messages whose first packet contains this string.
+  char match[kMatchMaxSize];
+};
+
+/**
+ * Single producer side of a lock-free ring buffer in a mmap'ed file.
+ *
+ * Records are never split, and writes never block: the producer overwrites
+ * the oldest records, and readers that fall behind by more than the capacity
+ * lose records instead of slowing down the producer.
+ *
+ * Record layout: 4 bytes of little endian length, then the data, padded to
+ * 8 bytes. A length of kWrapMarker means the rest of the buffer is unused.
+ */
+class ShmRingWriter {
+ public:
+  static constexpr uint32_t kWrapMarker = 0xffffffff;
+
+  /**
+   * Creates (or truncates) the ring file at `path`.
+   *
+   * @param capacity  Size of the data area, rounded up to a power of two.
+   * @throw std::runtime_error  On failure to create or map the file.
+   */
+  ShmRingWriter(const std::string& path, size_t capacity);
+  ~ShmRingWriter();
+
+  ShmRingWriter(const ShmRingWriter&) = delete;
+  ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+  /**
+   * Whether a reader heartbeat was seen within the last few seconds.
+   * Thread-safe.
+   */
+  bool hasReader(uint64_t nowMs) const noexcept;
+
+  /**
+   * Reader settings, see ShmRingHeader. Thread-safe.
+   */
+  uint32_t samplePeriod() const noexcept {
+    return header_->samplePeriod.load(std::memory_order_relaxed);
+  }
+  folly::StringPiece match() const noexcept;
+
+  /**
+   * Appends one record with the data of `iov`. Must only be called from one
+   * thread at a time.
+   *
+   * @return  False if the record is too large for the ring.
+   */
+  bool write(const struct iovec* iov, size_t iovcnt) noexcept;
+
+ private:
+  ShmRingHeader* header_{nullptr};
+  char* data_{nullptr};
+  size_t mappedSize_{0};
+};
+
+/**
+ * Reader side of ShmRingWriter. Several readers can follow the same ring,
+ * but the settings (sample period, match) are shared by all of them.
+ */
+class ShmRingReader {
+ public:
+  /**
+   * Maps the ring at `path`.
+   *
+   * @return  nullptr if `path` is not a ring file.
+   */
+  static std::unique_ptr<ShmRingReader> open(const std::string& path);
+  ~ShmRingReader();
+
+  ShmRingReader(const ShmRingReader&) = delete;
+  ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+  /**
+   * Tells the producer that a reader is attached, and with which settings.
+   * Must be called at least every second.
+   */
+  void
+  heartbeat(uint64_t nowMs, uint32_t samplePeriod, folly::StringPiece match);
+
+  /**
+   * Calls `onRecord` for every record written since the last call (or since
+   * the ring was opened).
+   *
+   * @return  Number of times records were lost because the reader fell
+   *          behind.
+   */
+  uint64_t read(folly::FunctionRef<void(folly::ByteRange)> onRecord);
+
+  /**
+   * Inode of the ring file, which changes when the producer restarts.
+   */
+  uint64_t inode() const {
+    return inode_;
+  }
+
+ private:
+  ShmRingReader(ShmRingHeader* header, size_t mappedSize, uint64_t inode);
+
+  ShmRingHeader* header_;
+  const char* data_;
+  const size_t mappedSize_;
+  const uint64_t inode_;
+  uint64_t readPos_;
+  std::string record_;
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -6,6 +6,9 @@
  */
 
 #include <assert.h>
+
+#include <limits>
+
 #include <folly/Bits.h>
 
 #include "mcrouter/lib/fbi/WeightedFurcHash.h"
@@ -112,13 +115,18 @@ furcGetNext32Bits(const uint32_t idx, HashCache& hash, uint32_t& old_ord) {
       0xffffffff);
 }
 
-} // namespace
+constexpr uint64_t kAlwaysAccept = 1ULL << 32;
 
-uint32_t weightedFurcHash(
+/**
+ * @param threshold  Maps a candidate index to the bound its next 32 bits must
+ *                   be below to be accepted, kAlwaysAccept to skip the check.
+ */
+template <class Threshold>
+uint32_t weightedFurcHashImpl(
     folly::StringPiece key,
-    folly::Range<const double*> weights,
-    uint32_t maxRetries) {
-  uint32_t m = weights.size();
+    uint32_t m,
+    uint32_t maxRetries,
+    const Threshold& threshold) {
   uint32_t num = m;
   uint32_t a;
   HashCache hash;
@@ -160,11 +168,10 @@ uint32_t weightedFurcHash(
         }
       }
     }
-    assert(0 <= weights[num] && weights[num] <= 1.0);
-    if (weights[num] == 1) {
+    const uint64_t weightAsInt = threshold(num);
+    if (weightAsInt == kAlwaysAccept) {
       return num;
     }
-    uint64_t weightAsInt = weights[num] * std::numeric_limits<uint32_t>::max();
     next32bits = furcGetNext32Bits(a, hash, old_ord);
 
     if (next32bits < weightAsInt) {
@@ -183,5 +190,43 @@ uint32_t weightedFurcHash(
   return next32bits % m;
 }
 
+uint64_t weightToThreshold(double weight) {
+  assert(0 <= weight && weight <= 1.0);
+  if (weight == 1) {
+    return kAlwaysAccept;
+  }
+  return weight * std::numeric_limits<uint32_t>::max();
+}
+
+} // namespace
+
+uint32_t weightedFurcHash(
+    folly::StringPiece key,
+    folly::Range<const double*> weights,
+    uint32_t maxRetries) {
+  return weightedFurcHashImpl(
+      key, weights.size(), maxRetries, [weights](uint32_t num) {
+        return weightToThreshold(weights[num]);
+      });
+}
+
+WeightedFurcHashTable::WeightedFurcHashTable(
+    folly::Range<const double*> weights) {
+  thresholds_.reserve(weights.size());
+  for (const auto weight : weights) {
+    thresholds_.push_back(weightToThreshold(weight));
+  }
+}
+
+uint32_t weightedFurcHash(
+    folly::StringPiece key,
+    const WeightedFurcHashTable& table,
+    uint32_t maxRetries) {
+  return weightedFurcHashImpl(
+      key, table.size(), maxRetries, [&table](uint32_t num) {
+        return table.threshold(num);
+      });
+}
+
 } // namespace mcrouter
 } // namespace facebook
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include <folly/Range.h>
 
 namespace facebook {
@@ -17,5 +20,37 @@ uint32_t weightedFurcHash(
     folly::Range<const double*> weights,
     uint32_t maxRetries = 32);
 
+/**
+ * The weight dependent part of weightedFurcHash(), computed once per set of
+ * weights (e.g. at config time) instead of on every call.
+ */
+class WeightedFurcHashTable {
+ public:
+  explicit WeightedFurcHashTable(folly::Range<const double*> weights);
+
+  size_t size() const {
+    return thresholds_.size();
+  }
+
+  /**
+   * A candidate `i` is accepted if the next 32 bits of the key's bitstream
+   * are below this (always for a weight of 1.0).
+   */
+  uint64_t threshold(size_t i) const {
+    return thresholds_[i];
+  }
+
+ private:
+  std::vector<uint64_t> thresholds_;
+};
+
+/**
+ * Same result as weightedFurcHash() with the weights `table` was built from.
+ */
+uint32_t weightedFurcHash(
+    folly::StringPiece key,
+    const WeightedFurcHashTable& table,
+    uint32_t maxRetries = 32);
+
 } // namespace mcrouter
 } // namespace facebook
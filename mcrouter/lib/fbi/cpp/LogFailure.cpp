@@ -9,9 +9,14 @@
 
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -19,8 +24,10 @@
 #include <boost/filesystem/path.hpp>
 
 #include <folly/Format.h>
+#include <folly/MPMCQueue.h>
 #include <folly/Singleton.h>
 #include <folly/Synchronized.h>
+#include <folly/system/ThreadName.h>
 
 #include "mcrouter/lib/fbi/cpp/util.h"
 
@@ -113,6 +120,148 @@ struct StaticContainer {
 
 folly::Singleton<folly::Synchronized<StaticContainer>> containerSingleton;
 
+/**
+ * State of a handlers::async() handler, shared by all copies of it.
+ */
+class AsyncHandler {
+ public:
+  AsyncHandler(
+      HandlerFunc handler,
+      std::chrono::milliseconds window,
+      size_t queueCapacity)
+      : handler_(std::move(handler)),
+        window_(window),
+        queue_(std::max<size_t>(queueCapacity, 1)) {
+    thread_ = std::thread([this]() { run(); });
+  }
+
+  ~AsyncHandler() {
+    // Wakes the writer thread up, so that it reports what is queued and exits.
+    Entry stop;
+    stop.line = kStopLine;
+    queue_.blockingWrite(std::move(stop));
+    thread_.join();
+  }
+
+  AsyncHandler(const AsyncHandler&) = delete;
+  AsyncHandler& operator=(const AsyncHandler&) = delete;
+
+  void add(
+      folly::StringPiece file,
+      int line,
+      folly::StringPiece service,
+      folly::StringPiece category,
+      folly::StringPiece msg) {
+    Entry entry;
+    entry.file = file.str();
+    entry.line = line;
+    entry.service = service.str();
+    entry.category = category.str();
+    entry.msg = msg.str();
+    if (!queue_.write(std::move(entry))) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  static constexpr int kStopLine = -1;
+
+  struct Entry {
+    std::string file;
+    int line{0};
+    std::string service;
+    std::string category;
+    std::string msg;
+  };
+
+  struct Aggregate {
+    Entry first;
+    size_t count{0};
+  };
+
+  using Key = std::tuple<std::string, std::string, std::string, int>;
+
+  const HandlerFunc handler_;
+  const std::chrono::milliseconds window_;
+  folly::MPMCQueue<Entry> queue_;
+  std::atomic<size_t> dropped_{0};
+  std::thread thread_;
+
+  // Only accessed by the writer thread.
+  std::vector<Aggregate> aggregates_;
+  std::map<Key, size_t> aggregateIndex_;
+
+  void run() {
+    folly::setThreadName("mc-fail-log");
+    bool stop = false;
+    while (!stop) {
+      const auto deadline = std::chrono::steady_clock::now() + window_;
+      Entry entry;
+      while (queue_.tryReadUntil(deadline, entry)) {
+        if (entry.line == kStopLine) {
+          stop = true;
+          while (queue_.read(entry)) {
+            aggregate(std::move(entry));
+          }
+          break;
+        }
+        aggregate(std::move(entry));
+      }
+      report();
+    }
+  }
+
+  void aggregate(Entry&& entry) {
+    Key key(entry.service, entry.category, entry.file, entry.line);
+    auto it = aggregateIndex_.find(key);
+    if (it != aggregateIndex_.end()) {
+      ++aggregates_[it->second].count;
+      return;
+    }
+    aggregateIndex_.emplace(std::move(key), aggregates_.size());
+    aggregates_.push_back(Aggregate{std::move(entry), 1});
+  }
+
+  void report() {
+    const auto dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (aggregates_.empty() && dropped == 0) {
+      return;
+    }
+
+    std::map<std::string, std::string> contexts;
+    if (auto container = containerSingleton.try_get()) {
+      container->withRLock([&](const auto& c) { contexts = c.contexts; });
+    }
+    for (auto& aggregate : aggregates_) {
+      auto& entry = aggregate.first;
+      if (aggregate.count > 1) {
+        entry.msg += folly::sformat(
+            " [happened {} times in the last {}ms]",
+            aggregate.count,
+            window_.count());
+      }
+      try {
+        handler_(
+            entry.file,
+            entry.line,
+            entry.service,
+            entry.category,
+            entry.msg,
+            contexts);
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Failure handler threw: " << e.what();
+      }
+    }
+    aggregates_.clear();
+    aggregateIndex_.clear();
+
+    if (dropped != 0) {
+      LOG(ERROR) << "Dropped " << dropped
+                 << " failures, the failure logging queue is full";
+    }
+  }
+};
+
 } // anonymous namespace
 
 namespace handlers {
@@ -132,6 +281,25 @@ std::pair<std::string, HandlerFunc> throwLogicError() {
       "throwLogicError", &throwErrorImpl<std::logic_error>);
 }
 
+std::pair<std::string, HandlerFunc> async(
+    std::pair<std::string, HandlerFunc> handler,
+    std::chrono::milliseconds window,
+    size_t queueCapacity) {
+  auto state = std::make_shared<AsyncHandler>(
+      std::move(handler.second), window, queueCapacity);
+  return std::make_pair<std::string, HandlerFunc>(
+      std::move(handler.first),
+      [state = std::move(state)](
+          folly::StringPiece file,
+          int line,
+          folly::StringPiece service,
+          folly::StringPiece category,
+          folly::StringPiece msg,
+          const std::map<std::string, std::string>&) {
+        state->add(file, line, service, category, msg);
+      });
+}
+
 } // namespace handlers
 
 const char* const Category::kBadEnvironment = "bad-environment";
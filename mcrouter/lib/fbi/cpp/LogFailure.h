@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <map>
 #include <string>
@@ -81,6 +82,22 @@ std::pair<std::string, HandlerFunc> logToStdError();
 
 std::pair<std::string, HandlerFunc> throwLogicError();
 
+/**
+ * Wraps `handler` so that failures are only queued where they happen (in a
+ * lock-free queue of `queueCapacity` entries, dropped when it's full) and
+ * handed to `handler` by a background thread, once every `window`.
+ * Identical failures (same service, category, file and line) within a
+ * window are reported once, with the number of times they happened.
+ *
+ * The returned handler has the same name as `handler`, so that it can
+ * replace it with setHandler(). Queued failures are reported when the
+ * last copy of it is destroyed.
+ */
+std::pair<std::string, HandlerFunc> async(
+    std::pair<std::string, HandlerFunc> handler,
+    std::chrono::milliseconds window = std::chrono::seconds(1),
+    size_t queueCapacity = 4096);
+
 } // namespace handlers
 
 namespace detail {
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/fbi/cpp/LogFailure.h"
+
+using namespace facebook::memcache::failure;
+
+namespace {
+
+struct Logged {
+  int line;
+  std::string category;
+  std::string msg;
+};
+
+std::pair<std::string, HandlerFunc> recordingHandler(
+    std::vector<Logged>& logged) {
+  return std::make_pair<std::string, HandlerFunc>(
+      "recording",
+      [&logged](
+          folly::StringPiece,
+          int line,
+          folly::StringPiece,
+          folly::StringPiece category,
+          folly::StringPiece msg,
+          const std::map<std::string, std::string>&) {
+        logged.push_back(Logged{line, category.str(), msg.str()});
+      });
+}
+
+} // anonymous namespace
+
+TEST(LogFailure, asyncAggregates) {
+  std::vector<Logged> logged;
+  {
+    auto handler = handlers::async(
+        recordingHandler(logged), std::chrono::seconds(60));
+    EXPECT_EQ("recording", handler.first);
+    for (int i = 0; i < 3; ++i) {
+      handler.second("a.cpp", 1, "svc", Category::kOther, "first", {});
+    }
+    handler.second("a.cpp", 2, "svc", Category::kBrokenLogic, "second", {});
+    // Nothing is logged where failures happen.
+    EXPECT_TRUE(logged.empty());
+  }
+
+  // Destroying the handler logs what is queued.
+  ASSERT_EQ(2, logged.size());
+  EXPECT_EQ(1, logged[0].line);
+  EXPECT_EQ("first [happened 3 times in the last 60000ms]", logged[0].msg);
+  EXPECT_EQ(2, logged[1].line);
+  EXPECT_EQ(Category::kBrokenLogic, logged[1].category);
+  EXPECT_EQ("second", logged[1].msg);
+}
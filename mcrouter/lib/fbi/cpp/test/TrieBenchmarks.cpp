@@ -12,11 +12,15 @@
 #include <gtest/gtest.h>
 
 #include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
 #include <folly/init/Init.h>
 
+#include "mcrouter/lib/fbi/cpp/LowerBoundPrefixMap.h"
 #include "mcrouter/lib/fbi/cpp/Trie.h"
 
+using facebook::memcache::LowerBoundPrefixMap;
 using facebook::memcache::Trie;
 
 namespace {
@@ -59,14 +63,39 @@ class KeyPrefixMap : public folly::StringKeyedUnorderedMap<Value> {
   std::vector<size_t> prefixLength_;
 };
 
-std::vector<std::string> keysToGet[3];
+// The last set is generated: a config with several thousand key prefix
+// policies, like the big production ones.
+constexpr size_t kNumSets = 4;
+constexpr size_t kNumGeneratedPrefixes = 2500;
 
-Trie<int> randTrie[3];
-KeyPrefixMap<int> randMap[3];
+std::vector<std::string> keysToGet[kNumSets];
+
+Trie<int> randTrie[kNumSets];
+KeyPrefixMap<int> randMap[kNumSets];
+LowerBoundPrefixMap<int> randLowerBound[kNumSets];
 int x = 0;
 
+std::vector<std::string> generatePrefixes() {
+  std::vector<std::string> prefixes;
+  prefixes.reserve(kNumGeneratedPrefixes);
+  folly::Random::DefaultGenerator rng(42);
+  for (size_t i = 0; i < kNumGeneratedPrefixes; ++i) {
+    std::string prefix;
+    // "<service>:<usecase>:" with some shorter ones to get nested prefixes.
+    const auto service = folly::Random::rand32(200, rng);
+    const auto usecase = folly::Random::rand32(1000, rng);
+    if (i % 10 == 0) {
+      prefix = folly::sformat("svc{}:", service);
+    } else {
+      prefix = folly::sformat("svc{}:uc{}:", service, usecase);
+    }
+    prefixes.push_back(std::move(prefix));
+  }
+  return prefixes;
+}
+
 void prepareRand() {
-  std::vector<std::string> keys[3] = {
+  std::vector<std::string> keys[kNumSets] = {
       {
           "abacaba",
           "abacabadabacaba",
@@ -91,15 +120,19 @@ void prepareRand() {
           "rblplmbf.abc",
           "rubajvnr.ghu",
           "rubajvnr.abc",
-      }};
+      },
+      generatePrefixes()};
 
   std::string missKeys[] = {"zahskjsdf", "aba", "", "z", "asdjl:dafnsjsdf"};
 
-  for (int i = 0; i < 3; ++i) {
+  for (size_t i = 0; i < kNumSets; ++i) {
+    LowerBoundPrefixMap<int>::Builder lowerBoundBuilder;
     for (size_t j = 0; j < keys[i].size(); ++j) {
       randTrie[i].emplace(keys[i][j], i + j + 1);
       randMap[i].emplace(keys[i][j], i + j + 1);
+      lowerBoundBuilder.insert({keys[i][j], static_cast<int>(i + j + 1)});
     }
+    randLowerBound[i] = std::move(lowerBoundBuilder).build();
 
     for (size_t j = 0; j < keys[i].size(); ++j) {
       keysToGet[i].push_back(keys[i][j] + ":hit");
@@ -131,6 +164,14 @@ void runGetPrefix(Container& c, int id) {
   }
 }
 
+void runGetPrefixLowerBound(const LowerBoundPrefixMap<int>& m, int id) {
+  auto& keys = keysToGet[id];
+  for (size_t i = 0; i < keys.size(); ++i) {
+    auto r = m.findPrefix(keys[i]);
+    x += r == m.end() ? 0 : r->value();
+  }
+}
+
 } // anonymous namespace
 
 BENCHMARK(Trie_get0) {
@@ -181,6 +222,30 @@ BENCHMARK_RELATIVE(Map_get_prefix2) {
   runGet(randMap[2], 2);
 }
 
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(Trie_get_prefix_many) {
+  runGetPrefix(randTrie[3], 3);
+}
+
+BENCHMARK_RELATIVE(Map_get_prefix_many) {
+  runGetPrefix(randMap[3], 3);
+}
+
+BENCHMARK_RELATIVE(LowerBound_get_prefix_many) {
+  runGetPrefixLowerBound(randLowerBound[3], 3);
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(Trie_get_prefix_small) {
+  runGetPrefix(randTrie[1], 1);
+}
+
+BENCHMARK_RELATIVE(LowerBound_get_prefix_small) {
+  runGetPrefixLowerBound(randLowerBound[1], 1);
+}
+
 int main(int argc, char** argv) {
   folly::init(&argc, &argv, true /* removeFlags */);
   prepareRand();
@@ -8,14 +8,85 @@
 #include "mcrouter/lib/invalidation/McInvalidationKvPairs.h"
 
 #include <cassert>
+#include <cstring>
 
+#include <folly/Bits.h>
 #include <folly/Conv.h>
 #include <folly/logging/xlog.h>
 
+#include "mcrouter/lib/Compression.h"
+
 namespace facebook::memcache::invalidation {
 
 using KeyValuePairs = McInvalidationKvPairs::KeyValuePairs;
 
+namespace {
+
+// "serialized_batch" is the concatenation of the serialized requests, each
+// preceded by its length as a little endian uint32.
+using BatchLength = uint32_t;
+
+// "serialized_batch_lz4" is the length of the uncompressed batch as a little
+// endian uint32, followed by the LZ4 compressed batch.
+using UncompressedLength = uint32_t;
+
+// Sanity limit for the uncompressed size of a batch.
+constexpr UncompressedLength kMaxUncompressedLength = 64 << 20;
+
+CompressionCodec& lz4Codec() {
+  // Codecs aren't thread safe.
+  static thread_local auto codec = createCompressionCodec(
+      CompressionCodecType::LZ4, folly::IOBuf::create(0), /* id */ 0);
+  return *codec;
+}
+
+std::optional<std::string> compressBatch(const std::string& batch) {
+  if (batch.size() > kMaxUncompressedLength) {
+    return std::nullopt;
+  }
+  auto compressed = lz4Codec().compress(batch.data(), batch.size());
+  compressed->coalesce();
+  if (sizeof(UncompressedLength) + compressed->length() >= batch.size()) {
+    return std::nullopt;
+  }
+  const auto length = folly::Endian::little<UncompressedLength>(batch.size());
+  std::string out;
+  out.reserve(sizeof(length) + compressed->length());
+  out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+  out.append(
+      reinterpret_cast<const char*>(compressed->data()), compressed->length());
+  return out;
+}
+
+std::optional<std::string> uncompressBatch(folly::StringPiece compressed) {
+  UncompressedLength length;
+  if (compressed.size() <= sizeof(length)) {
+    return std::nullopt;
+  }
+  memcpy(&length, compressed.data(), sizeof(length));
+  length = folly::Endian::little(length);
+  compressed.advance(sizeof(length));
+  if (length == 0 || length > kMaxUncompressedLength) {
+    return std::nullopt;
+  }
+  try {
+    auto batch =
+        lz4Codec().uncompress(compressed.data(), compressed.size(), length);
+    batch->coalesce();
+    if (batch->length() != length) {
+      return std::nullopt;
+    }
+    return std::string(
+        reinterpret_cast<const char*>(batch->data()), batch->length());
+  } catch (const std::exception& e) {
+    XLOG_EVERY_N(WARNING, 1000)
+        << "Failed to uncompress invalidation batch: " << e.what();
+    return std::nullopt;
+  }
+}
+
+} // namespace
+
 KeyValuePairs McInvalidationKvPairs::createAxonKvPairs(
     const std::string& serialized,
     std::optional<std::string> regionOpt,
@@ -39,10 +110,94 @@ KeyValuePairs McInvalidationKvPairs::createAxonKvPairs(
   return kvPairs;
 }
 
+KeyValuePairs McInvalidationKvPairs::createAxonBatchKvPairs(
+    const std::vector<std::string>& serialized,
+    std::optional<std::string> regionOpt,
+    std::optional<std::string> poolOpt,
+    std::optional<std::string> messageOpt,
+    bool compress) {
+  XCHECK(!serialized.empty());
+  auto kvPairs = createAxonKvPairs(
+      serialized[0],
+      std::move(regionOpt),
+      std::move(poolOpt),
+      std::move(messageOpt));
+  if (serialized.size() == 1) {
+    return kvPairs;
+  }
+
+  size_t size = 0;
+  for (const auto& request : serialized) {
+    size += sizeof(BatchLength) + request.size();
+  }
+  std::string batch;
+  batch.reserve(size);
+  for (const auto& request : serialized) {
+    XCHECK(!request.empty());
+    const auto length = folly::Endian::little<BatchLength>(request.size());
+    batch.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    batch.append(request);
+  }
+  kvPairs.erase(std::string(kSerialized));
+  if (compress) {
+    if (auto compressed = compressBatch(batch)) {
+      kvPairs.emplace(kSerializedBatchLz4, std::move(*compressed));
+      return kvPairs;
+    }
+  }
+  kvPairs.emplace(kSerializedBatch, std::move(batch));
+  return kvPairs;
+}
+
+std::vector<std::string> McInvalidationKvPairs::getSerializedRequests(
+    const KeyValuePairs& keyValues) {
+  std::vector<std::string> requests;
+  auto serializedIt = keyValues.find(kSerialized);
+  if (serializedIt != keyValues.end()) {
+    requests.push_back(serializedIt->second);
+    return requests;
+  }
+  std::optional<std::string> uncompressed;
+  folly::StringPiece batch;
+  auto batchIt = keyValues.find(kSerializedBatch);
+  if (batchIt != keyValues.end()) {
+    batch = batchIt->second;
+  } else {
+    auto lz4It = keyValues.find(kSerializedBatchLz4);
+    if (lz4It == keyValues.end()) {
+      return requests;
+    }
+    uncompressed = uncompressBatch(lz4It->second);
+    if (!uncompressed) {
+      return requests;
+    }
+    batch = *uncompressed;
+  }
+  while (!batch.empty()) {
+    BatchLength length;
+    if (batch.size() < sizeof(length)) {
+      return {};
+    }
+    memcpy(&length, batch.data(), sizeof(length));
+    length = folly::Endian::little(length);
+    batch.advance(sizeof(length));
+    if (length == 0 || batch.size() < length) {
+      return {};
+    }
+    requests.push_back(batch.subpiece(0, length).str());
+    batch.advance(length);
+  }
+  return requests;
+}
+
 bool McInvalidationKvPairs::validateAxonKvPairs(
     const KeyValuePairs& keyValues) {
   auto serializedIt = keyValues.find(kSerialized);
-  if (serializedIt == keyValues.end() || serializedIt->second.empty()) {
+  auto batchIt = keyValues.find(kSerializedBatch);
+  auto lz4It = keyValues.find(kSerializedBatchLz4);
+  if ((serializedIt == keyValues.end() || serializedIt->second.empty()) &&
+      (batchIt == keyValues.end() || batchIt->second.empty()) &&
+      (lz4It == keyValues.end() || lz4It->second.empty())) {
     XLOG_EVERY_N(WARNING, 1000) << "Missing key [serialized]";
     return false;
   }
@@ -22,10 +22,17 @@ constexpr uint32_t getMcInvalidationVersion() {
   // invalidation format, i.e. add/modify/remove key-values.
   // When the version is bumped it is essential to make sure that
   // the write/read logic supports both previous and current versions.
-  return 1;
+  //
+  // Version 2 adds "serialized_batch", sent instead of "serialized" by
+  // createAxonBatchKvPairs.
+  // Version 3 adds "serialized_batch_lz4", an LZ4 compressed
+  // "serialized_batch".
+  return 3;
 }
 
 constexpr std::string_view kSerialized("serialized");
+constexpr std::string_view kSerializedBatch("serialized_batch");
+constexpr std::string_view kSerializedBatchLz4("serialized_batch_lz4");
 constexpr std::string_view kRegion("region");
 constexpr std::string_view kVersion("version");
 constexpr std::string_view kPool("pool");
@@ -56,13 +63,44 @@ class McInvalidationKvPairs {
       std::optional<std::string> poolOpt = std::nullopt,
       std::optional<std::string> messageOpt = std::nullopt);
 
+  /**
+   * Api for invalidations writer.
+   *
+   * Same as createAxonKvPairs, for several serialized delete requests going
+   * to the same region and pool, written as a single DL record.
+   * A single request is written in the "serialized" format, so that readers
+   * of previous versions can still read it.
+   *
+   * If compress is set, the batch is written LZ4 compressed under
+   * "serialized_batch_lz4" when that makes it smaller. Only readers of
+   * version 3 and above can read those.
+   */
+  static KeyValuePairs createAxonBatchKvPairs(
+      const std::vector<std::string>& serialized,
+      std::optional<std::string> regionOpt = std::nullopt,
+      std::optional<std::string> poolOpt = std::nullopt,
+      std::optional<std::string> messageOpt = std::nullopt,
+      bool compress = false);
+
+  /**
+   * Api for invalidations reader.
+   *
+   * Returns the serialized delete requests of a validated record, either the
+   * one under "serialized" or all the ones under "serialized_batch" or
+   * "serialized_batch_lz4".
+   * Returns an empty vector if the batch is malformed.
+   */
+  static std::vector<std::string> getSerializedRequests(
+      const KeyValuePairs& keyValues);
+
   /**
    * Api for invalidations reader.
    *
    * Validate key-value pairs set coming from the DL.
    *
    * Key-values must contain:
-   * 1. "serialized" -> serialized delete request
+   * 1. "serialized", "serialized_batch" or "serialized_batch_lz4" ->
+   *    serialized delete request(s)
    * 2. "version" -> Invalidation format version
    * 3. Optional free-format message string
    *
@@ -53,4 +53,77 @@ TEST(McInvalidationKvPairsTest, createAxonKvPairsWithPoolAndRegionTest) {
   EXPECT_EQ(result.find(kRegion)->second, region);
 }
 
+TEST(McInvalidationKvPairsTest, createAxonBatchKvPairsTest) {
+  std::vector<std::string> serialized;
+  for (auto key : {"key1", "key2", "key3"}) {
+    memcache::McDeleteRequest req(key);
+    serialized.push_back(
+        apache::thrift::CompactSerializer::serialize<std::string>(req));
+  }
+  std::string region = "altoonia";
+
+  auto result = McInvalidationKvPairs::createAxonBatchKvPairs(
+      serialized, std::make_optional(region));
+
+  EXPECT_EQ(result.size(), 3);
+  EXPECT_EQ(result.count(kSerialized), 0);
+  EXPECT_EQ(result.count(kSerializedBatch), 1);
+  EXPECT_EQ(result.find(kRegion)->second, region);
+  EXPECT_TRUE(McInvalidationKvPairs::validateAxonKvPairs(result));
+  EXPECT_EQ(McInvalidationKvPairs::getSerializedRequests(result), serialized);
+
+  auto deserialized =
+      apache::thrift::CompactSerializer::deserialize<memcache::McDeleteRequest>(
+          McInvalidationKvPairs::getSerializedRequests(result)[1]);
+  EXPECT_EQ(deserialized.key_ref()->fullKey(), "key2");
+}
+
+TEST(McInvalidationKvPairsTest, createAxonBatchKvPairsSingleTest) {
+  memcache::McDeleteRequest req("key1");
+  std::vector<std::string> serialized{
+      apache::thrift::CompactSerializer::serialize<std::string>(req)};
+
+  auto result = McInvalidationKvPairs::createAxonBatchKvPairs(serialized);
+
+  EXPECT_EQ(result.size(), 2);
+  EXPECT_EQ(result.find(kSerialized)->second, serialized[0]);
+  EXPECT_EQ(result.count(kSerializedBatch), 0);
+  EXPECT_EQ(McInvalidationKvPairs::getSerializedRequests(result), serialized);
+}
+
+TEST(McInvalidationKvPairsTest, createAxonBatchKvPairsCompressedTest) {
+  std::vector<std::string> serialized;
+  for (int i = 0; i < 100; ++i) {
+    memcache::McDeleteRequest req(folly::to<std::string>("some:long:key:", i));
+    serialized.push_back(
+        apache::thrift::CompactSerializer::serialize<std::string>(req));
+  }
+
+  auto result = McInvalidationKvPairs::createAxonBatchKvPairs(
+      serialized,
+      std::nullopt,
+      std::nullopt,
+      std::nullopt,
+      /* compress */ true);
+
+  EXPECT_EQ(result.count(kSerialized), 0);
+  EXPECT_EQ(result.count(kSerializedBatch), 0);
+  ASSERT_EQ(result.count(kSerializedBatchLz4), 1);
+  EXPECT_TRUE(McInvalidationKvPairs::validateAxonKvPairs(result));
+  EXPECT_EQ(McInvalidationKvPairs::getSerializedRequests(result), serialized);
+
+  // Corrupted data
+  result[std::string(kSerializedBatchLz4)].resize(10);
+  EXPECT_TRUE(McInvalidationKvPairs::getSerializedRequests(result).empty());
+}
+
+TEST(McInvalidationKvPairsTest, getSerializedRequestsMalformedTest) {
+  McInvalidationKvPairs::KeyValuePairs kvPairs;
+  kvPairs.emplace(kVersion, "2");
+  kvPairs.emplace(kSerializedBatch, std::string("\x10\0\0\0abc", 7));
+
+  EXPECT_TRUE(McInvalidationKvPairs::validateAxonKvPairs(kvPairs));
+  EXPECT_TRUE(McInvalidationKvPairs::getSerializedRequests(kvPairs).empty());
+}
+
 } // namespace facebook::memcache::invalidation::test
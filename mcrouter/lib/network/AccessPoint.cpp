@@ -11,7 +11,9 @@
 #include <folly/IPAddress.h>
 #include <folly/IPAddressException.h>
 
+#include "mcrouter/lib/SharedObjectCache.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/HostResolver.h"
 
 namespace facebook {
 namespace memcache {
@@ -52,6 +54,15 @@ bool parseCompressed(folly::StringPiece s) {
   throw std::runtime_error("Invalid compression config");
 }
 
+/**
+ * The same hosts show up in every proxy and in every config generation,
+ * share a single copy of each.
+ */
+std::shared_ptr<const std::string> internHost(std::string host) {
+  static auto* hosts = new SharedObjectCache<std::string>();
+  return hosts->getOrCreate(host, [&host]() { return std::move(host); });
+}
+
 mc_protocol_t parseProtocol(folly::StringPiece str) {
   if (str == "ascii") {
     return mc_ascii_protocol;
@@ -86,11 +97,11 @@ AccessPoint::AccessPoint(
   auto const maybe_ip = folly::IPAddress::tryFromString(host);
   if (maybe_ip.hasError()) {
     // host is not an IP address (e.g. 'localhost')
-    host_ = host.str();
+    host_ = internHost(host.str());
     isV6_ = false;
   } else {
     auto const& ip = maybe_ip.value();
-    host_ = ip.toFullyQualified();
+    host_ = internHost(ip.toFullyQualified());
     hash_ = folly::hash_value(ip);
     isV6_ = ip.isV6();
   }
@@ -108,7 +119,7 @@ AccessPoint::AccessPoint(
       failureDomain_(failureDomain),
       taskId_(taskId),
       serviceId_(serviceIdOverride) {
-  host_ = ip.toFullyQualified();
+  host_ = internHost(ip.toFullyQualified());
   hash_ = folly::hash_value(ip);
   isV6_ = ip.isV6();
 }
@@ -169,7 +180,7 @@ std::shared_ptr<AccessPoint> AccessPoint::create(
       parseParts(apString, port, protocol, encr, comp);
     }
 
-    return std::make_shared<AccessPoint>(
+    auto ap = std::make_shared<AccessPoint>(
         host,
         portOverride != 0 ? portOverride : folly::to<uint16_t>(port),
         protocol.empty() ? defaultProtocol : parseProtocol(protocol),
@@ -179,6 +190,13 @@ std::shared_ptr<AccessPoint> AccessPoint::create(
         failureDomain,
         taskId,
         serviceIdOverride);
+    // Resolve hostnames now, so that the first connection doesn't wait.
+    if (!unixDomainSocket && !folly::IPAddress::validate(host)) {
+      if (auto resolver = HostResolver::getInstance()) {
+        resolver->prefetch(host);
+      }
+    }
+    return ap;
   } catch (const std::exception&) {
     return nullptr;
   }
@@ -190,9 +208,9 @@ void AccessPoint::disableCompression() {
 
 std::string AccessPoint::toHostPortString() const {
   if (isV6_) {
-    return folly::to<std::string>("[", host_, "]:", port_);
+    return folly::to<std::string>("[", *host_, "]:", port_);
   }
-  return folly::to<std::string>(host_, ":", port_);
+  return folly::to<std::string>(*host_, ":", port_);
 }
 
 std::string AccessPoint::toString() const {
@@ -200,7 +218,7 @@ std::string AccessPoint::toString() const {
   if (isV6_) {
     return folly::to<std::string>(
         "[",
-        host_,
+        *host_,
         "]:",
         port_,
         ":",
@@ -211,7 +229,7 @@ std::string AccessPoint::toString() const {
         compressed_ ? "compressed" : "notcompressed");
   }
   return folly::to<std::string>(
-      host_,
+      *host_,
       ":",
       port_,
       ":",
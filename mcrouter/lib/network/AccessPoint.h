@@ -92,7 +92,16 @@ struct AccessPoint {
       std::optional<std::string> serviceIdOverride = std::nullopt);
 
   const std::string& getHost() const {
-    return host_;
+    return *host_;
+  }
+
+  /**
+   * Hosts are interned process wide: two access points have the same host
+   * iff they have the same host id. Cheaper to hash and compare than the
+   * host, and only valid while the access point is alive.
+   */
+  const void* getHostId() const {
+    return host_.get();
   }
 
   uint64_t getHash() const {
@@ -159,8 +168,20 @@ struct AccessPoint {
     return serviceId_;
   }
 
+  /**
+   * Whether connections to this destination should use an io_uring backed
+   * transport where available. See ConnectionOptions::useIoUring.
+   */
+  bool useIoUring() const {
+    return useIoUring_;
+  }
+
+  void setUseIoUring(bool useIoUring) {
+    useIoUring_ = useIoUring;
+  }
+
  private:
-  std::string host_;
+  std::shared_ptr<const std::string> host_;
   uint64_t hash_{0};
   uint16_t port_;
   McProtocolT protocol_;
@@ -168,6 +189,7 @@ struct AccessPoint {
   bool compressed_{false};
   bool isV6_{false};
   bool unixDomainSocket_{false};
+  bool useIoUring_{false};
   uint32_t failureDomain_{0};
   std::optional<uint16_t> taskId_{std::nullopt};
   std::optional<std::string> serviceId_{std::nullopt};
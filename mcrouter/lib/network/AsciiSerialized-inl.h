@@ -49,7 +49,17 @@ bool AsciiSerializedRequest::prepare(
     const struct iovec*& iovOut,
     size_t& niovOut) {
   iovsCount_ = 0;
-  auto r = PrepareImplWrapper::prepare(*this, request);
+  bool r;
+  if constexpr (McAsciiMetaSupported<Request>::value) {
+    if (metaProtocol_) {
+      prepareMeta(request);
+      r = true;
+    } else {
+      r = PrepareImplWrapper::prepare(*this, request);
+    }
+  } else {
+    r = PrepareImplWrapper::prepare(*this, request);
+  }
   iovOut = iovs_;
   niovOut = iovsCount_;
   return r;
@@ -66,5 +76,19 @@ void AsciiSerializedReply::addStrings(Arg&& arg, Args&&... args) {
   addString(std::forward<Arg>(arg));
   addStrings(std::forward<Args>(args)...);
 }
+
+template <class Reply>
+void AsciiSerializedReply::prepareMeta(Reply&& reply, folly::StringPiece key) {
+  if (meta_->noop) {
+    addString("MN\r\n");
+    return;
+  }
+  if constexpr (carbon::GetLike<
+                    RequestFromReplyType<Reply, RequestReplyPairs>>::value) {
+    prepareImpl(std::move(reply), key);
+  } else {
+    prepareImpl(std::move(reply));
+  }
+}
 } // namespace memcache
 } // namespace facebook
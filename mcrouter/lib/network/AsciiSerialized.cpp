@@ -7,6 +7,8 @@
 
 #include "AsciiSerialized.h"
 
+#include <folly/Conv.h>
+
 #include "mcrouter/lib/IOBufUtil.h"
 #include "mcrouter/lib/McResUtil.h"
 
@@ -14,6 +16,30 @@ namespace facebook {
 namespace memcache {
 
 namespace {
+/**
+ * Writes the " <flags> <bytes>[ <cas unique>]\r\n" end of a VALUE line into
+ * `buf` (at least 66 chars) and returns its length. Same output as
+ * snprintf(), which is noticeably slower on big multigets.
+ */
+size_t formatValueLineSuffix(
+    char* buf,
+    uint64_t flags,
+    uint64_t valueSize,
+    const uint64_t* casToken = nullptr) {
+  char* out = buf;
+  *out++ = ' ';
+  out += folly::uint64ToBufferUnsafe(flags, out);
+  *out++ = ' ';
+  out += folly::uint64ToBufferUnsafe(valueSize, out);
+  if (casToken) {
+    *out++ = ' ';
+    out += folly::uint64ToBufferUnsafe(*casToken, out);
+  }
+  *out++ = '\r';
+  *out++ = '\n';
+  return out - buf;
+}
+
 const char* errorResultStr(const carbon::Result result) {
   switch (result) {
     case carbon::Result::OOO:
@@ -264,10 +290,117 @@ void AsciiSerializedRequest::prepareImpl(const McFlushAllRequest& request) {
   addString("\r\n");
 }
 
+// Meta commands.
+template <class Request>
+void AsciiSerializedRequest::prepareMetaGetLike(
+    const Request& request,
+    folly::StringPiece flags,
+    const int32_t* exptime) {
+  size_t len = 0;
+  if (exptime) {
+    const auto n =
+        snprintf(printBuffer_, kMaxBufferLength, " T%d\r\n", *exptime);
+    assert(n > 0 && static_cast<size_t>(n) < kMaxBufferLength);
+    len = static_cast<size_t>(n);
+  } else {
+    printBuffer_[0] = '\r';
+    printBuffer_[1] = '\n';
+    len = 2;
+  }
+  addStrings(
+      "mg ",
+      request.key_ref()->fullKey(),
+      flags,
+      folly::StringPiece(printBuffer_, len));
+}
+
+template <class Request>
+void AsciiSerializedRequest::prepareMetaSetLike(
+    const Request& request,
+    const char* mode,
+    const uint64_t* casToken) {
+  auto value = coalesceAndGetRange(request.value_ref());
+  auto len = casToken ? snprintf(
+                            printBuffer_,
+                            kMaxBufferLength,
+                            " %zd F%lu T%d C%lu%s\r\n",
+                            value.size(),
+                            *request.flags_ref(),
+                            *request.exptime_ref(),
+                            *casToken,
+                            mode)
+                      : snprintf(
+                            printBuffer_,
+                            kMaxBufferLength,
+                            " %zd F%lu T%d%s\r\n",
+                            value.size(),
+                            *request.flags_ref(),
+                            *request.exptime_ref(),
+                            mode);
+  assert(len > 0 && static_cast<size_t>(len) < kMaxBufferLength);
+  addStrings(
+      "ms ",
+      request.key_ref()->fullKey(),
+      folly::StringPiece(printBuffer_, static_cast<size_t>(len)),
+      value,
+      "\r\n");
+}
+
+void AsciiSerializedRequest::prepareMeta(const McGetRequest& request) {
+  prepareMetaGetLike(request, " v f", nullptr);
+}
+
+void AsciiSerializedRequest::prepareMeta(const McGetsRequest& request) {
+  prepareMetaGetLike(request, " v f c", nullptr);
+}
+
+void AsciiSerializedRequest::prepareMeta(const McGatRequest& request) {
+  const int32_t exptime = *request.exptime_ref();
+  prepareMetaGetLike(request, " v f", &exptime);
+}
+
+void AsciiSerializedRequest::prepareMeta(const McGatsRequest& request) {
+  const int32_t exptime = *request.exptime_ref();
+  prepareMetaGetLike(request, " v f c", &exptime);
+}
+
+void AsciiSerializedRequest::prepareMeta(const McSetRequest& request) {
+  prepareMetaSetLike(request, "");
+}
+
+void AsciiSerializedRequest::prepareMeta(const McAddRequest& request) {
+  prepareMetaSetLike(request, " ME");
+}
+
+void AsciiSerializedRequest::prepareMeta(const McReplaceRequest& request) {
+  prepareMetaSetLike(request, " MR");
+}
+
+void AsciiSerializedRequest::prepareMeta(const McAppendRequest& request) {
+  prepareMetaSetLike(request, " MA");
+}
+
+void AsciiSerializedRequest::prepareMeta(const McPrependRequest& request) {
+  prepareMetaSetLike(request, " MP");
+}
+
+void AsciiSerializedRequest::prepareMeta(const McCasRequest& request) {
+  const uint64_t casToken = *request.casToken_ref();
+  prepareMetaSetLike(request, "", &casToken);
+}
+
+void AsciiSerializedRequest::prepareMeta(const McDeleteRequest& request) {
+  // md has no equivalent of the delete exptime, which memcached rejects in
+  // classic delete commands as well.
+  addStrings("md ", request.key_ref()->fullKey(), "\r\n");
+}
+
 void AsciiSerializedReply::clear() {
   iovsCount_ = 0;
   iobuf_.reset();
   auxString_.reset();
+  applyZeroCopy_ = false;
+  meta_ = nullptr;
 }
 
 void AsciiSerializedReply::addString(folly::ByteRange range) {
@@ -344,19 +477,11 @@ void AsciiSerializedReply::prepareImpl(
     } else {
       const auto valueStr = coalesceAndGetRange(reply.value_ref());
 
-      const auto len = snprintf(
-          printBuffer_,
-          kMaxBufferLength,
-          " %lu %zu\r\n",
-          *reply.flags_ref(),
-          valueStr.size());
-      assert(len > 0);
-      assert(static_cast<size_t>(len) < kMaxBufferLength);
+      const auto len = formatValueLineSuffix(
+          printBuffer_, *reply.flags_ref(), valueStr.size());
+      assert(len < kMaxBufferLength);
 
-      addStrings(
-          "VALUE ",
-          key,
-          folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+      addStrings("VALUE ", key, folly::StringPiece(printBuffer_, len));
       assert(!iobuf_.has_value());
       // value was coalesced in coalesceAndGetRange()
       if (reply.value_ref().has_value()) {
@@ -379,20 +504,12 @@ void AsciiSerializedReply::prepareImpl(
     folly::StringPiece key) {
   if (isHitResult(*reply.result_ref())) {
     const auto valueStr = coalesceAndGetRange(reply.value_ref());
-    const auto len = snprintf(
-        printBuffer_,
-        kMaxBufferLength,
-        " %lu %zu %lu\r\n",
-        *reply.flags_ref(),
-        valueStr.size(),
-        *reply.casToken_ref());
-    assert(len > 0);
-    assert(static_cast<size_t>(len) < kMaxBufferLength);
+    const uint64_t casToken = *reply.casToken_ref();
+    const auto len = formatValueLineSuffix(
+        printBuffer_, *reply.flags_ref(), valueStr.size(), &casToken);
+    assert(len < kMaxBufferLength);
 
-    addStrings(
-        "VALUE ",
-        key,
-        folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+    addStrings("VALUE ", key, folly::StringPiece(printBuffer_, len));
     assert(!iobuf_.has_value());
     // value was coalesced in coalescedAndGetRange()
     if (reply.value_ref().has_value()) {
@@ -470,19 +587,11 @@ void AsciiSerializedReply::prepareImpl(
   const auto valueStr = coalesceAndGetRange(reply.value_ref());
 
   if (*reply.result_ref() == carbon::Result::FOUND) {
-    const auto len = snprintf(
-        printBuffer_,
-        kMaxBufferLength,
-        " %lu %zu\r\n",
-        *reply.flags_ref(),
-        valueStr.size());
-    assert(len > 0);
-    assert(static_cast<size_t>(len) < kMaxBufferLength);
+    const auto len = formatValueLineSuffix(
+        printBuffer_, *reply.flags_ref(), valueStr.size());
+    assert(len < kMaxBufferLength);
 
-    addStrings(
-        "VALUE ",
-        key,
-        folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+    addStrings("VALUE ", key, folly::StringPiece(printBuffer_, len));
     assert(!iobuf_.has_value());
     // value was coalesced in coalescedAndGetRange()
     if (reply.value_ref().has_value()) {
@@ -537,19 +646,11 @@ void AsciiSerializedReply::prepareImpl(
     } else {
       const auto valueStr = coalesceAndGetRange(reply.value_ref());
 
-      const auto len = snprintf(
-          printBuffer_,
-          kMaxBufferLength,
-          " %lu %zu\r\n",
-          *reply.flags_ref(),
-          valueStr.size());
-      assert(len > 0);
-      assert(static_cast<size_t>(len) < kMaxBufferLength);
+      const auto len = formatValueLineSuffix(
+          printBuffer_, *reply.flags_ref(), valueStr.size());
+      assert(len < kMaxBufferLength);
 
-      addStrings(
-          "VALUE ",
-          key,
-          folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+      addStrings("VALUE ", key, folly::StringPiece(printBuffer_, len));
       assert(!iobuf_.has_value());
       // value was coalesced in coalesceAndGetRange()
       if (reply.value_ref().has_value()) {
@@ -572,20 +673,12 @@ void AsciiSerializedReply::prepareImpl(
     folly::StringPiece key) {
   if (isHitResult(*reply.result_ref())) {
     const auto valueStr = coalesceAndGetRange(reply.value_ref());
-    const auto len = snprintf(
-        printBuffer_,
-        kMaxBufferLength,
-        " %lu %zu %lu\r\n",
-        *reply.flags_ref(),
-        valueStr.size(),
-        *reply.casToken_ref());
-    assert(len > 0);
-    assert(static_cast<size_t>(len) < kMaxBufferLength);
+    const uint64_t casToken = *reply.casToken_ref();
+    const auto len = formatValueLineSuffix(
+        printBuffer_, *reply.flags_ref(), valueStr.size(), &casToken);
+    assert(len < kMaxBufferLength);
 
-    addStrings(
-        "VALUE ",
-        key,
-        folly::StringPiece(printBuffer_, static_cast<size_t>(len)));
+    addStrings("VALUE ", key, folly::StringPiece(printBuffer_, len));
     assert(!iobuf_.has_value());
     // value was coalesced in coalescedAndGetRange()
     if (reply.value_ref().has_value()) {
@@ -770,6 +863,233 @@ void AsciiSerializedReply::prepareImpl(McTouchReply&& reply) {
   }
 }
 
+// Meta commands
+void AsciiSerializedReply::addMetaKeyAndOpaque(folly::StringPiece key) {
+  if (meta_->has(McAsciiMetaFlags::kKey)) {
+    addStrings(" k", key);
+  }
+  if (meta_->has(McAsciiMetaFlags::kOpaque)) {
+    addStrings(" O", meta_->opaqueToken());
+  }
+}
+
+void AsciiSerializedReply::prepareMetaGetLike(
+    carbon::Result result,
+    uint16_t errorCode,
+    std::string&& message,
+    uint64_t flags,
+    apache::thrift::optional_field_ref<folly::IOBuf&> value,
+    const uint64_t* casToken,
+    folly::StringPiece key) {
+  if (isErrorResult(result)) {
+    handleError(result, errorCode, std::move(message));
+    return;
+  }
+  if (!isHitResult(result)) {
+    addString("EN\r\n");
+    return;
+  }
+
+  // "VA <size> f<flags> c<cas> s<size>" is at most 89 chars.
+  const auto valueStr = coalesceAndGetRange(value);
+  const bool withValue = meta_->has(McAsciiMetaFlags::kValue);
+  char* out = printBuffer_;
+  if (withValue) {
+    memcpy(out, "VA ", 3);
+    out += 3;
+    out += folly::uint64ToBufferUnsafe(valueStr.size(), out);
+  } else {
+    memcpy(out, "HD", 2);
+    out += 2;
+  }
+  if (meta_->has(McAsciiMetaFlags::kClientFlags)) {
+    memcpy(out, " f", 2);
+    out += 2;
+    out += folly::uint64ToBufferUnsafe(flags, out);
+  }
+  if (casToken && meta_->has(McAsciiMetaFlags::kCas)) {
+    memcpy(out, " c", 2);
+    out += 2;
+    out += folly::uint64ToBufferUnsafe(*casToken, out);
+  }
+  if (meta_->has(McAsciiMetaFlags::kSize)) {
+    memcpy(out, " s", 2);
+    out += 2;
+    out += folly::uint64ToBufferUnsafe(valueStr.size(), out);
+  }
+  assert(static_cast<size_t>(out - printBuffer_) < kMaxBufferLength);
+
+  addString(folly::StringPiece(printBuffer_, out));
+  addMetaKeyAndOpaque(key);
+  addString("\r\n");
+  if (withValue) {
+    assert(!iobuf_.has_value());
+    // value was coalesced in coalesceAndGetRange()
+    if (value.has_value()) {
+      iobuf_ = std::move(value.value());
+    }
+    addStrings(valueStr, "\r\n");
+  }
+}
+
+void AsciiSerializedReply::prepareMetaUpdateLike(
+    carbon::Result result,
+    uint16_t errorCode,
+    std::string&& message,
+    folly::StringPiece key) {
+  if (isErrorResult(result)) {
+    handleError(result, errorCode, std::move(message));
+    return;
+  }
+
+  switch (result) {
+    case carbon::Result::OK:
+    case carbon::Result::STORED:
+    case carbon::Result::STALESTORED:
+    case carbon::Result::DELETED:
+      addString("HD");
+      break;
+    case carbon::Result::NOTSTORED:
+      addString("NS");
+      break;
+    case carbon::Result::EXISTS:
+      addString("EX");
+      break;
+    case carbon::Result::NOTFOUND:
+      addString("NF");
+      break;
+    default:
+      handleUnexpected(result, "meta command");
+      return;
+  }
+  addMetaKeyAndOpaque(key);
+  addString("\r\n");
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McGetReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaGetLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      *reply.flags_ref(),
+      reply.value_ref(),
+      nullptr,
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McGetsReply&& reply,
+    folly::StringPiece key) {
+  const uint64_t casToken = *reply.casToken_ref();
+  prepareMetaGetLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      *reply.flags_ref(),
+      reply.value_ref(),
+      &casToken,
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McGatReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaGetLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      *reply.flags_ref(),
+      reply.value_ref(),
+      nullptr,
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McGatsReply&& reply,
+    folly::StringPiece key) {
+  const uint64_t casToken = *reply.casToken_ref();
+  prepareMetaGetLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      *reply.flags_ref(),
+      reply.value_ref(),
+      &casToken,
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McSetReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McAddReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McReplaceReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McAppendReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McPrependReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McCasReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
+void AsciiSerializedReply::prepareMeta(
+    McDeleteReply&& reply,
+    folly::StringPiece key) {
+  prepareMetaUpdateLike(
+      *reply.result_ref(),
+      *reply.appSpecificErrorCode_ref(),
+      std::move(*reply.message_ref()),
+      key);
+}
+
 // Version
 void AsciiSerializedReply::prepareImpl(McVersionReply&& reply) {
   if (*reply.result_ref() == carbon::Result::OK) {
@@ -11,6 +11,7 @@
 #include <folly/Range.h>
 
 #include "mcrouter/lib/network/CarbonMessageList.h"
+#include "mcrouter/lib/network/McAsciiMeta.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/lib/network/gen/MemcacheRoutingGroups.h"
 
@@ -48,18 +49,27 @@ class AsciiSerializedRequest {
    */
   size_t getSize() const;
 
+  /**
+   * Send McAsciiMetaSupported requests as meta commands (mg, ms, md).
+   */
+  void setMetaProtocol(bool metaProtocol) {
+    metaProtocol_ = metaProtocol;
+  }
+
  private:
   // We need at most 5 iovecs (lease-set):
   //   command + key + printBuffer + value + "\r\n"
   static constexpr size_t kMaxIovs = 8;
-  // The longest print buffer we need is for lease-set/cas operations.
-  // It requires 2 uint64, 2 uint32 + 4 spaces + "\r\n" + '\0' = 67 chars.
-  static constexpr size_t kMaxBufferLength = 80;
+  // The longest print buffer we need is for a meta cas (ms with C).
+  // It requires 3 uint64, 1 int32 + 5 spaces + 5 flag chars + "\r\n" + '\0'
+  // = 84 chars.
+  static constexpr size_t kMaxBufferLength = 96;
 
   struct iovec iovs_[kMaxIovs];
   size_t iovsCount_{0};
   size_t iovsTotalLen_{0};
   char printBuffer_[kMaxBufferLength];
+  bool metaProtocol_{false};
 
   void addString(folly::ByteRange range);
   void addString(folly::StringPiece str);
@@ -103,6 +113,29 @@ class AsciiSerializedRequest {
   template <class Request>
   std::false_type prepareImpl(const Request& request);
 
+  // Meta commands.
+  template <class Request>
+  void prepareMetaGetLike(
+      const Request& request,
+      folly::StringPiece flags,
+      const int32_t* exptime);
+  template <class Request>
+  void prepareMetaSetLike(
+      const Request& request,
+      const char* mode,
+      const uint64_t* casToken = nullptr);
+  void prepareMeta(const McGetRequest& request);
+  void prepareMeta(const McGetsRequest& request);
+  void prepareMeta(const McGatRequest& request);
+  void prepareMeta(const McGatsRequest& request);
+  void prepareMeta(const McSetRequest& request);
+  void prepareMeta(const McAddRequest& request);
+  void prepareMeta(const McReplaceRequest& request);
+  void prepareMeta(const McAppendRequest& request);
+  void prepareMeta(const McPrependRequest& request);
+  void prepareMeta(const McCasRequest& request);
+  void prepareMeta(const McDeleteRequest& request);
+
   struct PrepareImplWrapper;
 };
 
@@ -121,6 +154,26 @@ class AsciiSerializedReply {
 
   void clear();
 
+  void setTCPZeroCopyThreshold(size_t threshold) {
+    tcpZeroCopyThreshold_ = threshold;
+  }
+
+  /**
+   * Flags of the meta command being replied to, nullptr for classic
+   * commands. Must stay alive until the reply is written.
+   */
+  void setMeta(const McAsciiMetaFlags* meta) {
+    meta_ = meta;
+  }
+
+  /**
+   * True if the value kept alive by this reply is large enough that it should
+   * be sent with MSG_ZEROCOPY instead of being copied into the socket buffer.
+   */
+  bool shouldApplyZeroCopy() const {
+    return applyZeroCopy_;
+  }
+
   template <class Reply>
   bool prepare(
       Reply&& reply,
@@ -132,12 +185,16 @@ class AsciiSerializedReply {
     if (key.hasValue()) {
       key->coalesce();
     }
-    prepareImpl(
-        std::move(reply),
-        key.hasValue()
-            ? folly::StringPiece(
-                  reinterpret_cast<const char*>(key->data()), key->length())
-            : folly::StringPiece());
+    const auto keyStr = key.hasValue()
+        ? folly::StringPiece(
+              reinterpret_cast<const char*>(key->data()), key->length())
+        : folly::StringPiece();
+    if (FOLLY_UNLIKELY(meta_ != nullptr)) {
+      prepareMeta(std::move(reply), keyStr);
+    } else {
+      prepareImpl(std::move(reply), keyStr);
+    }
+    checkZeroCopy();
     iovOut = iovs_;
     niovOut = iovsCount_;
     return true;
@@ -146,11 +203,23 @@ class AsciiSerializedReply {
   template <class Reply>
   bool prepare(
       Reply&& reply,
-      const folly::Optional<folly::IOBuf>& /* key */,
+      folly::Optional<folly::IOBuf>& key,
       const struct iovec*& iovOut,
       size_t& niovOut,
       carbon::OtherThanT<Reply, carbon::GetLike<>> = nullptr) {
-    prepareImpl(std::move(reply));
+    if (FOLLY_UNLIKELY(meta_ != nullptr)) {
+      if (key.hasValue()) {
+        key->coalesce();
+      }
+      prepareMeta(
+          std::move(reply),
+          key.hasValue()
+              ? folly::StringPiece(
+                    reinterpret_cast<const char*>(key->data()), key->length())
+              : folly::StringPiece());
+    } else {
+      prepareImpl(std::move(reply));
+    }
     iovOut = iovs_;
     niovOut = iovsCount_;
     return true;
@@ -171,6 +240,14 @@ class AsciiSerializedReply {
   // We also keep an auxiliary string for a similar purpose.
   folly::Optional<folly::IOBuf> iobuf_;
   folly::Optional<std::string> auxString_;
+  size_t tcpZeroCopyThreshold_{0};
+  bool applyZeroCopy_{false};
+  const McAsciiMetaFlags* meta_{nullptr};
+
+  void checkZeroCopy() {
+    applyZeroCopy_ = tcpZeroCopyThreshold_ && iobuf_.has_value() &&
+        iobuf_->computeChainDataLength() >= tcpZeroCopyThreshold_;
+  }
 
   void addString(folly::ByteRange range);
   void addString(folly::StringPiece str);
@@ -223,6 +300,35 @@ class AsciiSerializedReply {
   void prepareImpl(McExecReply&&);
   void prepareImpl(McFlushReReply&&);
   void prepareImpl(McFlushAllReply&&);
+  // Meta commands
+  void prepareMetaGetLike(
+      carbon::Result result,
+      uint16_t errorCode,
+      std::string&& message,
+      uint64_t flags,
+      apache::thrift::optional_field_ref<folly::IOBuf&> value,
+      const uint64_t* casToken,
+      folly::StringPiece key);
+  void prepareMetaUpdateLike(
+      carbon::Result result,
+      uint16_t errorCode,
+      std::string&& message,
+      folly::StringPiece key);
+  void addMetaKeyAndOpaque(folly::StringPiece key);
+  void prepareMeta(McGetReply&& reply, folly::StringPiece key);
+  void prepareMeta(McGetsReply&& reply, folly::StringPiece key);
+  void prepareMeta(McGatReply&& reply, folly::StringPiece key);
+  void prepareMeta(McGatsReply&& reply, folly::StringPiece key);
+  void prepareMeta(McSetReply&& reply, folly::StringPiece key);
+  void prepareMeta(McAddReply&& reply, folly::StringPiece key);
+  void prepareMeta(McReplaceReply&& reply, folly::StringPiece key);
+  void prepareMeta(McAppendReply&& reply, folly::StringPiece key);
+  void prepareMeta(McPrependReply&& reply, folly::StringPiece key);
+  void prepareMeta(McCasReply&& reply, folly::StringPiece key);
+  void prepareMeta(McDeleteReply&& reply, folly::StringPiece key);
+  // mn, and replies that are never sent for a meta command.
+  template <class Reply>
+  void prepareMeta(Reply&& reply, folly::StringPiece key);
   // Server and client error helper
   void
   handleError(carbon::Result result, uint16_t errorCode, std::string&& message);
@@ -41,8 +41,9 @@ template <class Request>
 ReplyT<Request> AsyncMcClient::sendSync(
     const Request& request,
     std::chrono::milliseconds timeout,
-    RpcStatsContext* rpcContext) {
-  return base_->sendSync(request, timeout, rpcContext);
+    RpcStatsContext* rpcContext,
+    const std::atomic<bool>* cancelled) {
+  return base_->sendSync(request, timeout, rpcContext, cancelled);
 }
 
 inline void AsyncMcClient::setThrottle(size_t maxInflight, size_t maxPending) {
@@ -68,6 +69,10 @@ inline double AsyncMcClient::getRetransmitsPerKb() {
   return base_->getRetransmitsPerKb();
 }
 
+inline Transport::TcpInfo AsyncMcClient::getTcpInfo() const {
+  return base_->getTcpInfo();
+}
+
 /* static */ inline constexpr bool AsyncMcClient::isCompatible(
     mc_protocol_t protocol) {
   return protocol == mc_ascii_protocol || protocol == mc_caret_protocol;
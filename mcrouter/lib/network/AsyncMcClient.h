@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <utility>
@@ -81,12 +82,16 @@ class AsyncMcClient final : public Transport {
    * @param rpcContext    Output argument that can be used to return information
    *                      about the reply received. If nullptr, it will be
    *                      ignored (i.e. no information is going be sent back up)
+   * @param cancelled     If not nullptr and true by the time the request would
+   *                      be written, the request isn't sent and is replied
+   *                      with ABORTED instead. Must outlive the call.
    */
   template <class Request>
   ReplyT<Request> sendSync(
       const Request& request,
       std::chrono::milliseconds timeout,
-      RpcStatsContext* rpcContext = nullptr);
+      RpcStatsContext* rpcContext = nullptr,
+      const std::atomic<bool>* cancelled = nullptr);
 
   /**
    * Set throttling options.
@@ -134,6 +139,8 @@ class AsyncMcClient final : public Transport {
    */
   double getRetransmitsPerKb() override final;
 
+  TcpInfo getTcpInfo() const override final;
+
   /**
    * Set external queue for managing flush callbacks. By default we'll use
    * EventBase as a manager of these callbacks.
@@ -5,6 +5,13 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <type_traits>
+
+#include <folly/Format.h>
+#include <folly/futures/Future.h>
+#include <folly/tracing/StaticTracepoint.h>
+
+#include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/network/FBTrace.h"
 #include "mcrouter/lib/network/RpcStatsContext.h"
@@ -16,7 +23,8 @@ template <class Request>
 ReplyT<Request> AsyncMcClientImpl::sendSync(
     const Request& request,
     std::chrono::milliseconds timeout,
-    RpcStatsContext* rpcContext) {
+    RpcStatsContext* rpcContext,
+    const std::atomic<bool>* cancelled) {
   DestructorGuard dg(this);
 
   assert(folly::fibers::onFiber());
@@ -37,7 +45,16 @@ ReplyT<Request> AsyncMcClientImpl::sendSync(
       queue_,
       [](ParserT& parser) { parser.expectNext<Request>(); },
       requestStatusCallbacks_.onStateChange,
-      supportedCompressionCodecs_);
+      negotiateCompression_ ? CodecIdRange::Empty
+                            : supportedCompressionCodecs_,
+      connectionOptions_.sendTimeoutBudget ? timeout
+                                           : std::chrono::milliseconds(0),
+      connectionOptions_.compactCaretHeader,
+      connectionOptions_.asciiMetaProtocol);
+  ctx.cancelled = cancelled;
+  if (connectionOptions_.expirePendingRequests && timeout.count() > 0) {
+    ctx.setDeadline(std::chrono::steady_clock::now() + timeout);
+  }
   sendCommon(ctx);
 
   // Wait for the reply.
@@ -61,9 +78,54 @@ void AsyncMcClientImpl::replyReady(
     RpcStatsContext rpcStatsContext) {
   assert(connectionState_ == ConnectionState::Up);
   DestructorGuard dg(this);
+  FOLLY_SDT(mcrouter, client_reply_received, this, reqId);
 
   queue_.reply(reqId, std::move(r), rpcStatsContext);
 }
 
+template <class ParseReply>
+void AsyncMcClientImpl::offloadReply(
+    ParseReply&& parseReply,
+    uint64_t reqId,
+    RpcStatsContext rpcStatsContext) {
+  using Reply = std::invoke_result_t<ParseReply&, const CompressionCodecMap*>;
+  const auto* codecManager = connectionOptions_.compressionCodecManager;
+  auto pool = mcrouter::AuxiliaryCPUThreadPoolSingleton::try_get();
+  // Keeps us alive until the reply is back on the event base.
+  auto self = selfPtr_.lock();
+  if (!codecManager || !pool || !self) {
+    replyReady(
+        parseReply(connectionOptions_.compressionCodecMap),
+        reqId,
+        rpcStatsContext);
+    return;
+  }
+
+  folly::via(
+      &pool->getThreadPool(),
+      [parseReply = std::forward<ParseReply>(parseReply),
+       codecManager]() mutable {
+        // Codecs aren't thread safe, use the ones of the pool thread.
+        return parseReply(codecManager->getCodecMap());
+      })
+      .via(&eventBase_)
+      .thenTry([self = std::move(self), reqId, rpcStatsContext](
+                   folly::Try<Reply>&& reply) {
+        if (self->connectionState_ != ConnectionState::Up) {
+          // The request was failed when the connection went down.
+          return;
+        }
+        if (reply.hasException()) {
+          self->parseError(
+              carbon::Result::LOCAL_ERROR,
+              folly::sformat(
+                  "Error parsing Caret message: {}",
+                  reply.exception().what()));
+          return;
+        }
+        self->replyReady(std::move(reply).value(), reqId, rpcStatsContext);
+      });
+}
+
 } // namespace memcache
 } // namespace facebook
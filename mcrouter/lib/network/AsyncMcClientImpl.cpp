@@ -9,15 +9,22 @@
 
 #include <netinet/tcp.h>
 
+#include <algorithm>
+#include <climits>
 #include <memory>
 
 #include <folly/SingletonThreadLocal.h>
 #include <folly/container/EvictingCacheMap.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/EventBase.h>
+#include <folly/small_vector.h>
+#include <folly/tracing/StaticTracepoint.h>
 
 #include "mcrouter/lib/debug/FifoManager.h"
 #include "mcrouter/lib/fbi/cpp/LogFailure.h"
+#include "mcrouter/lib/network/CaretHeader.h"
+#include "mcrouter/lib/network/CaretProtocol.h"
+#include "mcrouter/lib/network/IoUring.h"
 #include "mcrouter/lib/network/McFizzClient.h"
 #include "mcrouter/lib/network/McSSLUtil.h"
 #include "mcrouter/lib/network/SocketConnector.h"
@@ -30,7 +37,6 @@ namespace memcache {
 constexpr size_t kReadBufferSizeMin = 256;
 constexpr size_t kReadBufferSizeMax = 4096;
 constexpr size_t kStackIovecs = 128;
-constexpr size_t kMaxBatchSize = 24576 /* 24KB */;
 
 namespace {
 class OnEventBaseDestructionCallback final
@@ -65,6 +71,33 @@ struct GoAwayContext : public folly::AsyncTransportWrapper::WriteCallback {
   }
 };
 
+struct CompressionCodecsContext
+    : public folly::AsyncTransportWrapper::WriteCallback {
+  char header[kMaxHeaderLength];
+  struct iovec iov;
+  std::unique_ptr<CompressionCodecsContext> selfPtr;
+
+  explicit CompressionCodecsContext(const CodecIdRange& supportedCodecs) {
+    CaretMessageInfo info;
+    info.bodySize = 0;
+    info.typeId = kCaretCompressionCodecsTypeId;
+    info.reqId = kCaretConnectionControlReqId;
+    info.supportedCodecsFirstId = supportedCodecs.firstId;
+    info.supportedCodecsSize = supportedCodecs.size;
+    iov.iov_base = header;
+    iov.iov_len = caretPrepareHeader(info, header);
+  }
+
+  void writeSuccess() noexcept final {
+    auto self = std::move(selfPtr);
+    self.reset();
+  }
+  void writeErr(size_t, const folly::AsyncSocketException&) noexcept final {
+    auto self = std::move(selfPtr);
+    self.reset();
+  }
+};
+
 inline size_t calculateIovecsTotalSize(const struct iovec* iovecs, size_t num) {
   size_t size = 0;
   while (num) {
@@ -105,6 +138,8 @@ AsyncMcClientImpl::AsyncMcClientImpl(
   if (connectionOptions_.compressionCodecMap) {
     supportedCompressionCodecs_ =
         connectionOptions_.compressionCodecMap->getIdRange();
+    negotiateCompression_ = connectionOptions_.negotiateCompression &&
+        outOfOrder_ && !supportedCompressionCodecs_.isEmpty();
   }
 }
 
@@ -213,7 +248,12 @@ void AsyncMcClientImpl::scheduleNextWriterLoop() {
   if (connectionState_ == ConnectionState::Up &&
       !writer_.isLoopCallbackScheduled() &&
       (getNumToSend() > 0 || pendingGoAwayReply_)) {
-    if (flushList_) {
+    if (connectionOptions_.writeIdleImmediately &&
+        queue_.getInflightRequestCount() == 0) {
+      // Nothing to batch with on an idle connection, write right after the
+      // current loop callback (e.g. the fibers that queued the requests).
+      eventBase_.runInLoop(&writer_, /* thisIteration */ true);
+    } else if (flushList_) {
       flushList_->push_back(writer_);
     } else {
       eventBase_.runInLoop(&writer_);
@@ -229,22 +269,41 @@ void AsyncMcClientImpl::pushMessages() {
   DestructorGuard dg(this);
 
   assert(connectionState_ == ConnectionState::Up);
-  auto numToSend = getNumToSend();
-  // Call batch status callback
-  if (requestStatusCallbacks_.onWrite && numToSend > 0) {
-    requestStatusCallbacks_.onWrite(numToSend);
-  }
-
-  std::array<struct iovec, kStackIovecs> iovecs;
+  // Under overload the oldest requests are the likeliest to time out before
+  // their reply comes back, so send the most recent ones first.
+  const auto lifoThreshold = connectionOptions_.pendingLifoThreshold;
+  queue_.setPendingLifo(
+      lifoThreshold != 0 && queue_.getPendingRequestCount() >= lifoThreshold);
+  std::chrono::steady_clock::time_point now;
+  if (connectionOptions_.expirePendingRequests) {
+    now = std::chrono::steady_clock::now();
+    queue_.failExpiredPending(now);
+  }
+  // Neither cancelled nor expired requests are worth sending.
+  auto numToSend = queue_.failUnsendablePending(getNumToSend(), now);
+
+  // Requests queued within one loop iteration (e.g. all the keys of a
+  // multiget routed to this destination) are written with as few writev()
+  // calls as the batch limits allow.
+  const size_t maxBatchSize = connectionOptions_.writeBatchMaxBytes;
+  const size_t maxBatchIovecs = std::max<size_t>(
+      1, std::min<size_t>(connectionOptions_.writeBatchMaxIovecs, IOV_MAX));
+  folly::small_vector<struct iovec, kStackIovecs> iovecs(maxBatchIovecs);
   size_t iovsUsed = 0;
   size_t batchSize = 0;
+  size_t batchReqs = 0;
   McClientRequestContextBase* tail = nullptr;
 
   auto sendBatchFun = [this](
                           McClientRequestContextBase* tailReq,
                           const struct iovec* iov,
                           size_t iovCnt,
+                          size_t numReqs,
                           bool last) {
+    // Call batch status callback
+    if (requestStatusCallbacks_.onWrite) {
+      requestStatusCallbacks_.onWrite(numReqs);
+    }
     tailReq->isBatchTail = true;
     socket_->writev(
         this,
@@ -258,6 +317,8 @@ void AsyncMcClientImpl::pushMessages() {
          /* we might be already not UP, because of failed writev */
          connectionState_ == ConnectionState::Up) {
     auto& req = queue_.peekNextPending();
+    FOLLY_SDT(
+        mcrouter, client_request_write, this, req.id, req.reqContext.typeId());
 
     auto iov = req.reqContext.getIovs();
     auto iovcnt = req.reqContext.getIovsCount();
@@ -266,46 +327,49 @@ void AsyncMcClientImpl::pushMessages() {
       debugFifo_.writeData(iov, iovcnt);
     }
 
-    if (iovsUsed + iovcnt > kStackIovecs && iovsUsed) {
+    if (iovsUsed + iovcnt > maxBatchIovecs && iovsUsed) {
       // We're out of inline iovecs, flush what we batched.
-      if (!sendBatchFun(tail, iovecs.data(), iovsUsed, false)) {
+      if (!sendBatchFun(tail, iovecs.data(), iovsUsed, batchReqs, false)) {
         break;
       }
       iovsUsed = 0;
       batchSize = 0;
+      batchReqs = 0;
     }
 
-    if (iovcnt >= kStackIovecs || (iovsUsed == 0 && numToSend == 1)) {
+    if (iovcnt >= maxBatchIovecs || (iovsUsed == 0 && numToSend == 1)) {
       // Req is either too big to batch or it's the last one, so just send it
       // alone.
       queue_.markNextAsSending();
-      sendBatchFun(&req, iov, iovcnt, numToSend == 1);
+      sendBatchFun(&req, iov, iovcnt, 1, numToSend == 1);
     } else {
       auto size = calculateIovecsTotalSize(iov, iovcnt);
 
-      if (size + batchSize > kMaxBatchSize && iovsUsed) {
+      if (size + batchSize > maxBatchSize && iovsUsed) {
         // We already accumulated too much data, flush what we have.
-        if (!sendBatchFun(tail, iovecs.data(), iovsUsed, false)) {
+        if (!sendBatchFun(tail, iovecs.data(), iovsUsed, batchReqs, false)) {
           break;
         }
         iovsUsed = 0;
         batchSize = 0;
+        batchReqs = 0;
       }
 
       queue_.markNextAsSending();
-      if (size >= kMaxBatchSize || (iovsUsed == 0 && numToSend == 1)) {
+      if (size >= maxBatchSize || (iovsUsed == 0 && numToSend == 1)) {
         // Req is either too big to batch or it's the last one, so just send it
         // alone.
-        sendBatchFun(&req, iov, iovcnt, numToSend == 1);
+        sendBatchFun(&req, iov, iovcnt, 1, numToSend == 1);
       } else {
         memcpy(iovecs.data() + iovsUsed, iov, sizeof(struct iovec) * iovcnt);
         iovsUsed += iovcnt;
         batchSize += size;
+        ++batchReqs;
         tail = &req;
 
         if (numToSend == 1) {
           // This was the last request flush everything.
-          sendBatchFun(tail, iovecs.data(), iovsUsed, true);
+          sendBatchFun(tail, iovecs.data(), iovsUsed, batchReqs, true);
         }
       }
     }
@@ -341,6 +405,16 @@ void AsyncMcClientImpl::sendGoAwayReply() {
   }
 }
 
+void AsyncMcClientImpl::sendCompressionCodecs() {
+  auto ctxPtr =
+      std::make_unique<CompressionCodecsContext>(supportedCompressionCodecs_);
+  auto& ctx = *ctxPtr;
+  // Pass context ownership of itself, writev will call a callback that
+  // will destroy the context.
+  ctx.selfPtr = std::move(ctxPtr);
+  socket_->writev(&ctx, &ctx.iov, 1);
+}
+
 void AsyncMcClientImpl::attemptConnection() {
   // We may use a lot of stack memory (e.g. hostname resolution) or some
   // expensive SSL code. This should be always executed on main context.
@@ -349,6 +423,32 @@ void AsyncMcClientImpl::attemptConnection() {
     connectionState_ = ConnectionState::Connecting;
     pendingGoAwayReply_ = false;
 
+    if (nextConnectAddress_ == 0) {
+      auto expectedSocketAddresses = getSocketAddresses(connectionOptions_);
+      if (expectedSocketAddresses.hasError()) {
+        const auto& ex = expectedSocketAddresses.error();
+        LOG_FAILURE(
+            "AsyncMcClient",
+            failure::Category::kBadEnvironment,
+            "{}",
+            ex.what());
+        connectErr(ex);
+        return;
+      }
+      connectAddresses_ = std::move(expectedSocketAddresses).value();
+      if (connectionOptions_.alternateAddressConnectTimeout.count() == 0) {
+        connectAddresses_.resize(1);
+      }
+    }
+    folly::SocketAddress address = connectAddresses_[nextConnectAddress_++];
+    auto connectTimeout = connectionOptions_.connectTimeout;
+    if (nextConnectAddress_ < connectAddresses_.size() &&
+        (connectTimeout.count() == 0 ||
+         connectTimeout > connectionOptions_.alternateAddressConnectTimeout)) {
+      // Don't wait long on one address when others are left to try.
+      connectTimeout = connectionOptions_.alternateAddressConnectTimeout;
+    }
+
     auto expectedSocket = createSocket(eventBase_, connectionOptions_);
     if (expectedSocket.hasError()) {
       connectErr(expectedSocket.error());
@@ -356,16 +456,6 @@ void AsyncMcClientImpl::attemptConnection() {
     }
     socket_ = std::move(expectedSocket).value();
 
-    auto expectedSocketAddress = getSocketAddress(connectionOptions_);
-    if (expectedSocketAddress.hasError()) {
-      const auto& ex = expectedSocketAddress.error();
-      LOG_FAILURE(
-          "AsyncMcClient", failure::Category::kBadEnvironment, "{}", ex.what());
-      connectErr(ex);
-      return;
-    }
-    folly::SocketAddress address = std::move(expectedSocketAddress).value();
-
     socket_->setSendTimeout(connectionOptions_.writeTimeout.count());
 
     const auto mech = connectionOptions_.accessPoint->getSecurityMech();
@@ -381,7 +471,7 @@ void AsyncMcClientImpl::attemptConnection() {
       connectSSLSocketWithAuxIO(
           std::move(sslSockPtr),
           std::move(address),
-          connectionOptions_.connectTimeout.count(),
+          connectTimeout.count(),
           std::move(socketOptions))
           .thenValue([self](folly::AsyncSocket::UniquePtr socket) {
             CHECK(self->eventBase_.isInEventBaseThread());
@@ -414,14 +504,14 @@ void AsyncMcClientImpl::attemptConnection() {
         fizzClient->connect(
             this,
             address,
-            connectionOptions_.connectTimeout.count(),
+            connectTimeout.count(),
             socketOptions);
       } else {
         auto asyncSock = socket_->getUnderlyingTransport<folly::AsyncSocket>();
         asyncSock->connect(
             this,
             address,
-            connectionOptions_.connectTimeout.count(),
+            connectTimeout.count(),
             socketOptions);
       }
     }
@@ -432,6 +522,7 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
   assert(connectionState_ == ConnectionState::Connecting);
   DestructorGuard dg(this);
   connectionState_ = ConnectionState::Up;
+  nextConnectAddress_ = 0;
 
   const auto mech = connectionOptions_.accessPoint->getSecurityMech();
   if (isAsyncSSLSocketMech(mech)) {
@@ -468,6 +559,16 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
         socket_->setSendTimeout(connectionOptions_.writeTimeout.count());
       }
     }
+  } else if (
+      mech == SecurityMech::TLS13_FIZZ &&
+      connectionOptions_.securityOpts.fizzUseKtls) {
+    auto* fizzClient = socket_->getUnderlyingTransport<McFizzClient>();
+    assert(fizzClient != nullptr);
+    // same as for KTLS12: on failure we keep doing crypto in user space
+    if (auto ktlsSock = McSSLUtil::moveToKtls(*fizzClient)) {
+      socket_.reset(ktlsSock.release());
+      socket_->setSendTimeout(connectionOptions_.writeTimeout.count());
+    }
   }
 
   // Now authorize the connection
@@ -507,6 +608,15 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
     }
   }
 
+  if (connectionOptions_.useIoUring && mech == SecurityMech::NONE) {
+    // If the EventBase doesn't run on io_uring, keep using AsyncSocket.
+    if (auto ioUringSock = moveToIoUring(socket_)) {
+      socket_ = std::move(ioUringSock);
+      // Timeouts are transport state, unlike socket options on the FD.
+      socket_->setSendTimeout(connectionOptions_.writeTimeout.count());
+    }
+  }
+
   if (!connectionOptions_.debugFifoPath.empty()) {
     if (auto fifoManager = FifoManager::getInstance()) {
       if (auto fifo =
@@ -523,6 +633,10 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
 
   numConnectTimeoutRetriesLeft_ = connectionOptions_.numConnectTimeoutRetries;
 
+  if (negotiateCompression_) {
+    // Must be the first message the server reads from this connection.
+    sendCompressionCodecs();
+  }
   scheduleNextWriterLoop();
   parser_ = std::make_unique<ParserT>(
       *this,
@@ -531,6 +645,11 @@ void AsyncMcClientImpl::connectSuccess() noexcept {
       connectionOptions_.useJemallocNodumpAllocator,
       connectionOptions_.compressionCodecMap,
       &debugFifo_);
+  parser_->setAsciiMetaProtocol(connectionOptions_.asciiMetaProtocol);
+  if (connectionOptions_.compressionCodecManager) {
+    parser_->setDecompressionOffloadThreshold(
+        connectionOptions_.decompressionOffloadThreshold);
+  }
   socket_->setReadCB(this);
 }
 
@@ -570,6 +689,14 @@ void AsyncMcClientImpl::connectErr(
   // We don't need it anymore, so let it perform complete cleanup.
   socket_.reset();
 
+  if (!isAborting_ && nextConnectAddress_ > 0 &&
+      nextConnectAddress_ < connectAddresses_.size()) {
+    // Fail over to the next address of the destination.
+    attemptConnection();
+    return;
+  }
+  nextConnectAddress_ = 0;
+
   if (ex.getType() == folly::AsyncSocketException::TIMED_OUT &&
       numConnectTimeoutRetriesLeft_ > 0) {
     --numConnectTimeoutRetriesLeft_;
@@ -645,6 +772,11 @@ void AsyncMcClientImpl::getReadBuffer(void** bufReturn, size_t* lenReturn) {
 void AsyncMcClientImpl::readDataAvailable(size_t len) noexcept {
   assert(curBuffer_.first != nullptr && curBuffer_.second >= len);
   DestructorGuard dg(this);
+  if (connectionOptions_.tcpInfoSamplePeriod > 0 &&
+      readsUntilTcpInfoSample_-- == 0) {
+    readsUntilTcpInfoSample_ = connectionOptions_.tcpInfoSamplePeriod - 1;
+    sampleTcpInfo();
+  }
   parser_->readDataAvailable(len);
 }
 
@@ -832,8 +964,10 @@ double AsyncMcClientImpl::getRetransmitsPerKb() {
     struct tcp_info tcpinfo;
     socklen_t len = sizeof(struct tcp_info);
 
-    if (socket_->getUnderlyingTransport<folly::AsyncSocket>()->getSockOpt(
-            IPPROTO_TCP, TCP_INFO, &tcpinfo, &len) == 0) {
+    // Not available for io_uring backed connections.
+    auto asyncSock = socket_->getUnderlyingTransport<folly::AsyncSocket>();
+    if (asyncSock &&
+        asyncSock->getSockOpt(IPPROTO_TCP, TCP_INFO, &tcpinfo, &len) == 0) {
       const uint64_t totalKBytes = socket_->getRawBytesWritten() / 1024;
       if (totalKBytes == lastKBytes_) {
         return 0.0;
@@ -848,6 +982,23 @@ double AsyncMcClientImpl::getRetransmitsPerKb() {
   return -1.0;
 }
 
+void AsyncMcClientImpl::sampleTcpInfo() {
+  // Not available for io_uring backed connections.
+  auto asyncSock = socket_->getUnderlyingTransport<folly::AsyncSocket>();
+  if (!asyncSock) {
+    return;
+  }
+  struct tcp_info tcpinfo;
+  socklen_t len = sizeof(struct tcp_info);
+  if (asyncSock->getSockOpt(IPPROTO_TCP, TCP_INFO, &tcpinfo, &len) != 0) {
+    return;
+  }
+  tcpInfo_.rttUs = tcpinfo.tcpi_rtt;
+  tcpInfo_.rttVarUs = tcpinfo.tcpi_rttvar;
+  tcpInfo_.totalRetrans = tcpinfo.tcpi_total_retrans;
+  ++tcpInfo_.numSamples;
+}
+
 int64_t AsyncMcClientImpl::getNumConnectRetries() noexcept {
   return connectionOptions_.numConnectTimeoutRetries -
       numConnectTimeoutRetriesLeft_;
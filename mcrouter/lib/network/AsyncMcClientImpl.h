@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <string>
+#include <vector>
 
 #include <folly/fibers/Baton.h>
 #include <folly/io/IOBufQueue.h>
@@ -69,7 +71,8 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   ReplyT<Request> sendSync(
       const Request& request,
       std::chrono::milliseconds timeout,
-      RpcStatsContext* rpcContext);
+      RpcStatsContext* rpcContext,
+      const std::atomic<bool>* cancelled);
 
   void setThrottle(size_t maxInflight, size_t maxPending);
 
@@ -88,6 +91,10 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
 
   double getRetransmitsPerKb();
 
+  Transport::TcpInfo getTcpInfo() const {
+    return tcpInfo_;
+  }
+
   void setFlushList(FlushList* flushList) {
     flushList_ = flushList;
   }
@@ -109,11 +116,16 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   RequestStatusCallbacks requestStatusCallbacks_;
   AuthorizationCallbacks authorizationCallbacks_;
   int32_t numConnectTimeoutRetriesLeft_{0};
+  // Addresses of the current connection attempt, and the next one to try.
+  std::vector<folly::SocketAddress> connectAddresses_;
+  size_t nextConnectAddress_{0};
 
   // Debug pipe.
   ConnectionFifo debugFifo_;
 
   CodecIdRange supportedCompressionCodecs_ = CodecIdRange::Empty;
+  // Codecs are announced once per connection rather than in every request.
+  bool negotiateCompression_{false};
 
   McClientRequestContextQueue queue_;
 
@@ -144,6 +156,12 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   uint32_t lastRetrans_{0}; // last known value of the no. of retransmissions
   uint64_t lastKBytes_{0}; // last known number of kBs sent
 
+  // TCP_INFO sampling from the read path.
+  Transport::TcpInfo tcpInfo_;
+  uint32_t readsUntilTcpInfoSample_{0};
+
+  void sampleTcpInfo();
+
   bool isAborting_{false};
 
   ConnectionOptions connectionOptions_;
@@ -165,6 +183,7 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   void sendCommon(McClientRequestContextBase& req);
 
   void sendGoAwayReply();
+  void sendCompressionCodecs();
 
   // Write some requests from sendQueue_ to the socket, until max inflight limit
   // is reached or queue is empty.
@@ -210,6 +229,15 @@ class AsyncMcClientImpl : public folly::DelayedDestruction,
   template <class Reply>
   void
   replyReady(Reply&& reply, uint64_t reqId, RpcStatsContext rpcStatsContext);
+  /**
+   * Runs parseReply(codecMap) on the auxiliary CPU thread pool, then
+   * replyReady() with its result back on the event base.
+   */
+  template <class ParseReply>
+  void offloadReply(
+      ParseReply&& parseReply,
+      uint64_t reqId,
+      RpcStatsContext rpcStatsContext);
   void handleConnectionControlMessage(const CaretMessageInfo& headerInfo);
   void parseError(carbon::Result result, folly::StringPiece reason);
   bool nextReplyAvailable(uint64_t reqId);
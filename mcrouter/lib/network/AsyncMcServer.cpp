@@ -7,6 +7,9 @@
 
 #include "AsyncMcServer.h"
 
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
 #include <signal.h>
 #include <sys/eventfd.h>
 #include <sys/resource.h>
@@ -79,6 +82,67 @@ class ShutdownPipe : public folly::EventHandler {
   }
 };
 
+/**
+ * Pins the calling thread to the CPUs c such that c % numThreads == id,
+ * the ones whose connections are steered to the thread by
+ * attachCpuSteeringProgram().
+ */
+void pinThreadToCpus(size_t id, size_t numThreads) {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  const size_t numCpus = std::thread::hardware_concurrency();
+  for (size_t cpu = id; cpu < numCpus && cpu < CPU_SETSIZE;
+       cpu += numThreads) {
+    CPU_SET(cpu, &cpus);
+  }
+  if (CPU_COUNT(&cpus) == 0) {
+    // More threads than CPUs, no connection is steered to this one.
+    return;
+  }
+  if (auto err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+    LOG(WARNING) << "Failed to pin server thread " << id
+                 << " to its CPUs: " << folly::errnoStr(err);
+  }
+}
+
+/**
+ * Makes the SO_REUSEPORT groups of the socket hand every new connection to
+ * the socket number (cpu % numSockets), cpu being the CPU that received the
+ * connection.
+ */
+void attachCpuSteeringProgram(
+    const folly::AsyncServerSocket& socket,
+    size_t numSockets) {
+#ifdef SO_ATTACH_REUSEPORT_CBPF
+  sock_filter code[] = {
+      // A = CPU handling the packet
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU},
+      // A = A % numSockets
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(numSockets)},
+      // Index of the socket in the group
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+  for (auto fd : socket.getNetworkSockets()) {
+    checkLogic(
+        setsockopt(
+            fd.toFd(),
+            SOL_SOCKET,
+            SO_ATTACH_REUSEPORT_CBPF,
+            &prog,
+            sizeof(prog)) == 0,
+        "Failed to attach CPU steering program to listening socket: {}",
+        folly::errnoStr(errno));
+  }
+#else
+  (void)socket;
+  (void)numSockets;
+  checkLogic(false, "Steering connections by CPU is not supported");
+#endif
+}
+
 } // anonymous namespace
 
 /**
@@ -86,8 +150,17 @@ class ShutdownPipe : public folly::EventHandler {
  */
 class McServerThreadSpawnController {
  public:
-  explicit McServerThreadSpawnController(size_t numListeningSockets)
-      : numListeningSockets_(numListeningSockets) {}
+  /**
+   * @param orderedListening  If true, listening threads start accepting one
+   *                          at a time, in the order of their ids, so that
+   *                          their sockets have the same index in the
+   *                          SO_REUSEPORT group as their thread.
+   */
+  explicit McServerThreadSpawnController(
+      size_t numListeningSockets,
+      bool orderedListening = false)
+      : numListeningSockets_(numListeningSockets),
+        orderedListening_(orderedListening) {}
 
   /**
    * Blocks the current thread until it's ready to start running.
@@ -128,14 +201,23 @@ class McServerThreadSpawnController {
    * @param acceptorFn        The acceptor function. This function should throw
    *                          if something goes wrong.
    * @param isAcceptorThread  Whether or not this is the acceptor thread.
+   * @param id                Id of the thread.
    *
    * @throw  If anything was thrown when starting to accept connections.
    */
   template <class F>
-  void startAccepting(F&& acceptorFn, bool isAcceptorThread) {
+  void startAccepting(F&& acceptorFn, bool isAcceptorThread, size_t id) {
     if (isAcceptorThread) {
+      if (orderedListening_ && !waitForListeningTurn(id)) {
+        // A thread before this one failed to start accepting.
+        waitForAcceptor();
+        return;
+      }
       try {
         acceptorFn();
+        if (orderedListening_) {
+          endListeningTurn(true /* succeeded */);
+        }
         if (++listeningThreadCount == numListeningSockets_) {
           acceptorPromise_.set_value();
         } else {
@@ -143,6 +225,9 @@ class McServerThreadSpawnController {
           waitForAcceptor();
         }
       } catch (...) {
+        if (orderedListening_) {
+          endListeningTurn(false /* succeeded */);
+        }
         auto exception = std::current_exception();
         acceptorPromise_.set_exception(exception);
         std::rethrow_exception(exception);
@@ -156,6 +241,37 @@ class McServerThreadSpawnController {
   std::atomic<size_t> listeningThreadCount{0};
   size_t numListeningSockets_{1};
 
+  bool orderedListening_{false};
+  std::mutex listeningTurnMutex_;
+  std::condition_variable listeningTurnCv_;
+  // Id of the next thread to start accepting
+  size_t listeningTurn_{0};
+  bool listeningTurnFailed_{false};
+
+  /**
+   * Blocks until thread `id` may start accepting.
+   *
+   * @return  false if a previous thread failed to start accepting.
+   */
+  bool waitForListeningTurn(size_t id) {
+    std::unique_lock<std::mutex> lock(listeningTurnMutex_);
+    listeningTurnCv_.wait(
+        lock, [&] { return listeningTurnFailed_ || listeningTurn_ == id; });
+    return !listeningTurnFailed_;
+  }
+
+  void endListeningTurn(bool succeeded) {
+    {
+      std::lock_guard<std::mutex> lock(listeningTurnMutex_);
+      if (succeeded) {
+        ++listeningTurn_;
+      } else {
+        listeningTurnFailed_ = true;
+      }
+    }
+    listeningTurnCv_.notify_all();
+  }
+
   std::promise<void> runningPromise_;
   std::shared_future<void> runningFuture_{runningPromise_.get_future()};
 
@@ -233,12 +349,29 @@ class McServerThread {
     return vevb_ ? vevb_->getEventBase() : *evb_;
   }
 
+  /**
+   * File descriptors of the sockets this thread listens on, if any.
+   * Must be called from the thread's event base.
+   */
+  std::vector<int> listeningSocketFds() const {
+    std::vector<int> fds;
+    for (auto* socket : {socket_.get(), sslSocket_.get()}) {
+      if (socket != nullptr) {
+        for (auto networkSocket : socket->getNetworkSockets()) {
+          fds.push_back(networkSocket.toFd());
+        }
+      }
+    }
+    return fds;
+  }
+
   void startRemote() {
     CHECK(isVirtualEventBase());
     if (accepting_) {
       vevb_->runOnDestruction([&]() {
         socket_.reset();
         sslSocket_.reset();
+        localSocket_.reset();
         acceptorsKeepAlive_.clear();
       });
     }
@@ -247,12 +380,21 @@ class McServerThread {
         worker_.setOnShutdownOperation([&]() { server_.shutdown(); });
 
         server_.threadsSpawnController_->waitToStart();
+        if (server_.opts_.steerConnectionsByCpu) {
+          pinThreadToCpus(id_, server_.opts_.numThreads);
+        }
         server_.threadsSpawnController_->startAccepting(
-            [this]() { startAccepting(); }, accepting_);
+            [this]() { startAccepting(); }, accepting_, id_);
       } catch (...) {
         // if an exception is thrown, something went wrong before startup.
         return;
       }
+      if (auto cpuController = server_.opts_.worker.cpuController) {
+        cpuController->addThread(eventBase());
+        vevb_->runOnDestruction([cpuController, evb = &eventBase()]() {
+          cpuController->removeThread(*evb);
+        });
+      }
       initFn_(id_, *vevb_, worker_);
     });
   }
@@ -280,15 +422,24 @@ class McServerThread {
 
       try {
         server_.threadsSpawnController_->waitToStart();
+        if (server_.opts_.steerConnectionsByCpu) {
+          pinThreadToCpus(id_, server_.opts_.numThreads);
+        }
 
         server_.threadsSpawnController_->startAccepting(
-            [this]() { startAccepting(); }, accepting_);
+            [this]() { startAccepting(); }, accepting_, id_);
       } catch (...) {
         // if an exception is thrown, something went wrong before startup.
         return;
       }
 
+      if (auto& cpuController = server_.opts_.worker.cpuController) {
+        cpuController->addThread(eventBase());
+      }
       loopFn_(id_, eventBase(), worker_);
+      if (auto& cpuController = server_.opts_.worker.cpuController) {
+        cpuController->removeThread(eventBase());
+      }
 
       // Detach the server sockets from the acceptor thread.
       // If we don't do this, the TAsyncSSLServerSocket destructor
@@ -297,6 +448,7 @@ class McServerThread {
       if (accepting_) {
         socket_.reset();
         sslSocket_.reset();
+        localSocket_.reset();
         for (auto& keepAlive : acceptorsKeepAlive_) {
           auto evb = keepAlive.get();
           evb->add([ka = std::move(keepAlive)]() {});
@@ -332,6 +484,7 @@ class McServerThread {
     auto shutdownFn = [&]() {
       socket_.reset();
       sslSocket_.reset();
+      localSocket_.reset();
       for (auto& acceptorKeepAlive : acceptorsKeepAlive_) {
         auto evb = acceptorKeepAlive.get();
         evb->add([ka = std::move(acceptorKeepAlive)]() {});
@@ -462,6 +615,8 @@ class McServerThread {
 
   folly::AsyncServerSocket::UniquePtr socket_;
   folly::AsyncServerSocket::UniquePtr sslSocket_;
+  // Unix domain socket for co-located clients, next to the TCP ports.
+  folly::AsyncServerSocket::UniquePtr localSocket_;
   std::vector<folly::Executor::KeepAlive<folly::EventBase>> acceptorsKeepAlive_;
   std::unique_ptr<ShutdownPipe> shutdownPipe_;
 
@@ -540,6 +695,9 @@ class McServerThread {
         socket_->useExistingSockets(sockets);
       }
     } else if (!opts.unixDomainSockPath.empty()) {
+      checkLogic(
+          opts.localSockPath.empty(),
+          "Can't listen on a local socket next to a unix domain socket");
       checkLogic(
           opts.ports.empty() && opts.sslPorts.empty() &&
               opts.existingSocketFds.empty(),
@@ -607,8 +765,17 @@ class McServerThread {
       }
     }
 
+    // With CPU steering, the first socket of each SO_REUSEPORT group sets
+    // the program of the group.
+    const bool attachSteering = opts.steerConnectionsByCpu && id_ == 0;
     if (socket_) {
+      if (server_.opts_.tfoEnabled && opts.unixDomainSockPath.empty()) {
+        socket_->setTFOEnabled(true, server_.opts_.tfoQueueSize);
+      }
       socket_->listen(server_.opts_.tcpListenBacklog);
+      if (attachSteering) {
+        attachCpuSteeringProgram(*socket_, opts.numListeningSockets);
+      }
       socket_->startAccepting();
       socket_->attachEventBase(&eventBase());
     }
@@ -619,18 +786,43 @@ class McServerThread {
         sslSocket_->setTFOEnabled(false, 0);
       }
       sslSocket_->listen(server_.opts_.tcpListenBacklog);
+      if (attachSteering) {
+        attachCpuSteeringProgram(*sslSocket_, opts.numListeningSockets);
+      }
       sslSocket_->startAccepting();
       sslSocket_->attachEventBase(&eventBase());
     }
 
+    // Only one thread listens on the local socket, whatever the number of
+    // TCP listening sockets: a Unix socket path can't be bound twice.
+    if (!opts.localSockPath.empty() && id_ == 0) {
+      std::remove(opts.localSockPath.c_str());
+      localSocket_.reset(new folly::AsyncServerSocket());
+      folly::SocketAddress localAddress;
+      localAddress.setFromPath(opts.localSockPath);
+      localSocket_->bind(localAddress);
+      localSocket_->listen(server_.opts_.tcpListenBacklog);
+      localSocket_->startAccepting();
+      localSocket_->attachEventBase(&eventBase());
+    }
+
     for (auto& t : server_.threads_) {
-      if (socket_ != nullptr) {
+      // With per thread listening sockets every thread accepts its own TCP
+      // connections, local ones are still spread over all threads.
+      const bool ownSockets =
+          !opts.perThreadListeningSockets || t.get() == this;
+      if (ownSockets && socket_ != nullptr) {
         socket_->addAcceptCallback(&t->acceptCallback_, &t->eventBase());
       }
-      if (sslSocket_ != nullptr) {
+      if (ownSockets && sslSocket_ != nullptr) {
         sslSocket_->addAcceptCallback(&t->sslAcceptCallback_, &t->eventBase());
       }
-      if (socket_ != nullptr || sslSocket_ != nullptr || t.get() != this) {
+      if (localSocket_ != nullptr) {
+        localSocket_->addAcceptCallback(&t->acceptCallback_, &t->eventBase());
+      }
+      if ((ownSockets &&
+           (socket_ != nullptr || sslSocket_ != nullptr || t.get() != this)) ||
+          localSocket_ != nullptr) {
         acceptorsKeepAlive_.emplace_back(getKeepAliveToken(&t->eventBase()));
       }
     }
@@ -730,6 +922,13 @@ AsyncMcServer::AsyncMcServer(Options opts) : opts_(std::move(opts)) {
     opts_.worker.cpuController->start();
   }
 
+  const size_t numWorkers = opts_.eventBases.empty() ? opts_.numThreads
+                                                     : opts_.eventBases.size();
+  if (opts_.connectionRebalancerOpts.interval.count() > 0 && numWorkers > 1) {
+    opts_.worker.connectionRebalancer = std::make_shared<ConnectionRebalancer>(
+        opts_.connectionRebalancerOpts, numWorkers);
+  }
+
   if (!opts_.tlsTicketKeySeedPath.empty()) {
     if (auto initialSeeds = wangle::TLSCredProcessor::processTLSTickets(
             opts_.tlsTicketKeySeedPath)) {
@@ -744,6 +943,19 @@ AsyncMcServer::AsyncMcServer(Options opts) : opts_(std::move(opts)) {
     startPollingTicketKeySeeds();
   }
 
+  if (opts_.perThreadListeningSockets &&
+      opts_.numListeningSockets != opts_.numThreads) {
+    throw std::invalid_argument(folly::sformat(
+        "perThreadListeningSockets requires numListeningSockets={} to be "
+        "equal to numThreads={}",
+        opts_.numListeningSockets,
+        opts_.numThreads));
+  }
+  if (opts_.steerConnectionsByCpu && !opts_.perThreadListeningSockets) {
+    throw std::invalid_argument(
+        "steerConnectionsByCpu requires perThreadListeningSockets");
+  }
+
   if (opts_.eventBases.size() > 0) {
     virtualEventBaseMode_ = true;
     if (opts_.numListeningSockets == 0 ||
@@ -759,7 +971,7 @@ AsyncMcServer::AsyncMcServer(Options opts) : opts_(std::move(opts)) {
     }
 
     threadsSpawnController_ = std::make_unique<McServerThreadSpawnController>(
-        opts_.numListeningSockets);
+        opts_.numListeningSockets, opts_.steerConnectionsByCpu);
 
     // First construct the McServerThreads with listening sockets.
     size_t id;
@@ -792,7 +1004,7 @@ AsyncMcServer::AsyncMcServer(Options opts) : opts_(std::move(opts)) {
     }
 
     threadsSpawnController_ = std::make_unique<McServerThreadSpawnController>(
-        opts_.numListeningSockets);
+        opts_.numListeningSockets, opts_.steerConnectionsByCpu);
     size_t id;
     // First construct the McServerThreads with listening sockets.
     for (id = 0; id < opts_.numListeningSockets; id++) {
@@ -817,6 +1029,17 @@ std::vector<folly::EventBase*> AsyncMcServer::eventBases() const {
   return out;
 }
 
+std::vector<int> AsyncMcServer::listeningSocketFds() const {
+  std::vector<int> out;
+  for (auto& t : threads_) {
+    t->eventBase().runInEventBaseThreadAndWait([&]() {
+      auto fds = t->listeningSocketFds();
+      out.insert(out.end(), fds.begin(), fds.end());
+    });
+  }
+  return out;
+}
+
 AsyncMcServer::~AsyncMcServer() {
   /* Need to place the destructor here, since this is the only
      translation unit that knows about McServerThread */
@@ -20,6 +20,7 @@
 #include <wangle/ssl/TLSTicketKeySeeds.h>
 
 #include "mcrouter/lib/network/AsyncMcServerWorkerOptions.h"
+#include "mcrouter/lib/network/ConnectionRebalancer.h"
 #include "mcrouter/lib/network/CpuController.h"
 
 namespace folly {
@@ -62,6 +63,13 @@ class AsyncMcServer {
      */
     std::string unixDomainSockPath;
 
+    /**
+     * Unix domain socket to listen on in addition to the ports (or existing
+     * sockets), so that clients on the same host can skip the TCP stack.
+     * Connections accepted on it are plain text.
+     */
+    std::string localSockPath;
+
     /**
      * TCP listen backlog
      */
@@ -110,8 +118,9 @@ class AsyncMcServer {
     std::string tlsTicketKeySeedPath;
 
     /**
-     * TFO settings (for SSL only)
+     * TFO settings. tfoQueueSize is shared by plain and SSL ports.
      */
+    bool tfoEnabled{false};
     bool tfoEnabledForSsl{false};
     uint32_t tfoQueueSize{0};
 
@@ -133,6 +142,23 @@ class AsyncMcServer {
      */
     size_t numListeningSockets{1};
 
+    /**
+     * If true, every listening thread only accepts connections for itself,
+     * instead of spreading them over all the threads.
+     * Requires numListeningSockets == numThreads.
+     */
+    bool perThreadListeningSockets{false};
+
+    /**
+     * Requires perThreadListeningSockets. Attaches a BPF program to the
+     * SO_REUSEPORT group of the listening sockets that hands every new
+     * connection to thread (cpu % numThreads), cpu being the CPU that
+     * received it, and pins thread i to the CPUs c with c % numThreads == i.
+     * Connections are then accepted and served on the cores handling their
+     * packets, best with one RX queue per CPU. Linux only.
+     */
+    bool steerConnectionsByCpu{false};
+
     /**
      * Worker-specific options
      */
@@ -143,6 +169,12 @@ class AsyncMcServer {
      */
     CpuControllerOptions cpuControllerOpts;
 
+    /**
+     * Moves connections from busy threads to the others.
+     * Requires more than one thread.
+     */
+    ConnectionRebalancerOptions connectionRebalancerOpts;
+
     /**
      * Sets the maximum number of connections allowed.
      * Once that number is reached, AsyncMcServer will start closing connections
@@ -200,6 +232,15 @@ class AsyncMcServer {
    */
   std::vector<folly::EventBase*> eventBases() const;
 
+  /**
+   * @return  File descriptors of all the sockets the server listens on, e.g.
+   *          to hand them over to another process (they can then be passed
+   *          in its existingSocketFds). They stay owned by the server.
+   *          Must be called after the server started, not from one of its
+   *          threads.
+   */
+  std::vector<int> listeningSocketFds() const;
+
   /**
    * Spawn the required number of threads, and run the loop function in each
    * of them.
@@ -280,6 +321,14 @@ class AsyncMcServer {
     return virtualEventBaseMode_;
   }
 
+  /**
+   * @return  controller measuring the load on this host, or nullptr if
+   *          cpuControllerOpts are not enabled.
+   */
+  const std::shared_ptr<CpuController>& getCpuController() const {
+    return opts_.worker.cpuController;
+  }
+
  private:
   std::unique_ptr<folly::ScopedEventBaseThread> auxiliaryEvbThread_;
   Options opts_;
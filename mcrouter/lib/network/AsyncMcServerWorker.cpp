@@ -7,6 +7,8 @@
 
 #include "AsyncMcServerWorker.h"
 
+#include <time.h>
+
 #include <memory>
 
 #include <folly/io/async/AsyncSSLSocket.h>
@@ -16,12 +18,26 @@
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/VirtualEventBase.h>
 
+#include "mcrouter/lib/network/ConnectionRebalancer.h"
+#include "mcrouter/lib/network/IoUring.h"
 #include "mcrouter/lib/network/McFizzServer.h"
 #include "mcrouter/lib/network/McServerSession.h"
 
 namespace facebook {
 namespace memcache {
 
+namespace {
+
+std::chrono::nanoseconds threadCpuTime() {
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+} // namespace
+
 AsyncMcServerWorker::AsyncMcServerWorker(
     AsyncMcServerWorkerOptions opts,
     folly::EventBase& eventBase)
@@ -62,6 +78,13 @@ bool AsyncMcServerWorker::addClientSocket(
   auto socket = transport->getUnderlyingTransport<folly::AsyncSocket>();
   CHECK(socket) << "Underlying transport expected to be AsyncSocket";
   McServerSession::applySocketOptions(*socket, opts_);
+  if (opts_.useIoUring && opts_.tcpZeroCopyThresholdBytes == 0 &&
+      !transport->getUnderlyingTransport<McFizzServer>() &&
+      !transport->getUnderlyingTransport<folly::AsyncSSLSocket>()) {
+    if (auto ioUringTransport = moveToIoUring(transport)) {
+      transport = std::move(ioUringTransport);
+    }
+  }
   return addClientTransport(std::move(transport), userCtxt);
 }
 
@@ -71,6 +94,9 @@ McServerSession* AsyncMcServerWorker::addClientTransport(
   if (!onRequest_) {
     throw std::logic_error("can't add a transport without onRequest callback");
   }
+  if (opts_.connectionRebalancer && !rebalanceTimeout_ && isAlive_) {
+    startRebalancing();
+  }
 
   try {
     return std::addressof(tracker_.add(
@@ -92,9 +118,43 @@ void AsyncMcServerWorker::shutdown() {
   }
 
   isAlive_ = false;
+  rebalanceTimeout_.reset();
   tracker_.closeAll();
 }
 
+void AsyncMcServerWorker::startRebalancing() {
+  // Called from the thread of the worker, whose CPU time is measured.
+  rebalancerWorkerId_ = opts_.connectionRebalancer->addWorker();
+  lastCpuTime_ = threadCpuTime();
+  lastRebalanceTime_ = std::chrono::steady_clock::now();
+  rebalanceTimeout_ = folly::AsyncTimeout::make(
+      *getEventBase(), [this]() noexcept { rebalance(); });
+  rebalanceTimeout_->scheduleTimeout(
+      opts_.connectionRebalancer->options().interval);
+}
+
+void AsyncMcServerWorker::rebalance() {
+  const auto cpuTime = threadCpuTime();
+  const auto now = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> busy = cpuTime - lastCpuTime_;
+  const std::chrono::duration<double> elapsed = now - lastRebalanceTime_;
+  lastCpuTime_ = cpuTime;
+  lastRebalanceTime_ = now;
+
+  if (elapsed.count() > 0) {
+    auto numToMove = opts_.connectionRebalancer->update(
+        rebalancerWorkerId_, busy / elapsed);
+    if (numToMove > 0) {
+      auto numMoved =
+          tracker_.closeIdle(numToMove, "Rebalancing connections");
+      VLOG(2) << "Worker " << rebalancerWorkerId_ << " is busier than the"
+              << " others, moving " << numMoved << " connections away";
+    }
+  }
+  rebalanceTimeout_->scheduleTimeout(
+      opts_.connectionRebalancer->options().interval);
+}
+
 bool AsyncMcServerWorker::writesPending() const {
   return tracker_.writesPending();
 }
@@ -13,6 +13,7 @@
 
 #include <folly/Optional.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/AsyncTransport.h>
 
 #include "mcrouter/lib/network/AsyncMcServerWorkerOptions.h"
@@ -187,6 +188,15 @@ class AsyncMcServerWorker {
     compressionCodecMap_ = codecMap;
   }
 
+  /**
+   * See AsyncMcServerWorkerOptions::overloadCheck.
+   *
+   * Note: this applies to already open connections too.
+   */
+  void setOverloadCheck(std::function<bool()> check) {
+    opts_.overloadCheck = std::move(check);
+  }
+
   /**
    * Start closing all connections.
    * All incoming requests must still be replied by the application,
@@ -228,6 +238,15 @@ class AsyncMcServerWorker {
   /* Open sessions and closing sessions that still have pending writes */
   ConnectionTracker tracker_;
 
+  /* Load measurement for opts_.connectionRebalancer */
+  std::unique_ptr<folly::AsyncTimeout> rebalanceTimeout_;
+  size_t rebalancerWorkerId_{0};
+  std::chrono::nanoseconds lastCpuTime_{0};
+  std::chrono::steady_clock::time_point lastRebalanceTime_;
+
+  void startRebalancing();
+  void rebalance();
+
   AsyncMcServerWorker(const AsyncMcServerWorker&) = delete;
   AsyncMcServerWorker& operator=(const AsyncMcServerWorker&) = delete;
 
@@ -8,12 +8,14 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 
 namespace facebook {
 namespace memcache {
 
+class ConnectionRebalancer;
 class CpuController;
 class MemoryController;
 
@@ -49,6 +51,16 @@ struct AsyncMcServerWorkerOptions {
    */
   uint16_t maxReadsPerEvent{0};
 
+  /**
+   * If true, plaintext client connections are moved to an io_uring backed
+   * transport when the event base of the worker runs on the io_uring
+   * backend (see IoUring.h). The writes of all the connections of the worker
+   * flushed in one loop iteration are then submitted to the kernel together,
+   * instead of one writev() per connection.
+   * Ignored for TLS connections and when tcpZeroCopyThresholdBytes is set.
+   */
+  bool useIoUring{false};
+
   /**
    * Timeout for writes (i.e. replies to the clients).
    * If 0, no timeout.
@@ -62,6 +74,26 @@ struct AsyncMcServerWorkerOptions {
    */
   size_t maxInFlight{0};
 
+  /**
+   * If set, checked after every read from a client socket. While it returns
+   * true the session stops reading, so that new requests stay in the kernel
+   * buffers (pushing back on the client) instead of being parsed only to be
+   * rejected. The check is retried every overloadPauseInterval.
+   */
+  std::function<bool()> overloadCheck;
+
+  std::chrono::milliseconds overloadPauseInterval{5};
+
+  /**
+   * If true, the hits of an ascii multi-get are written as soon as they are
+   * ready instead of in the order of the keys; the END line still comes
+   * last. Only for clients that match values by key. An error replaces END
+   * as usual, but may then follow some hits.
+   * Can be changed per connection with
+   * McServerSession::setAsciiMultigetStreaming().
+   */
+  bool asciiMultigetStreaming{false};
+
   /**
    * Max connections used at any moment.
    */
@@ -83,6 +115,20 @@ struct AsyncMcServerWorkerOptions {
    */
   size_t maxBufferSize{4096};
 
+  /**
+   * If true, a connection only holds a read buffer while it has data that
+   * isn't fully parsed; the buffers are shared by the connections of the
+   * worker otherwise. Saves memory with many mostly idle connections.
+   */
+  bool releaseIdleReadBuffers{false};
+
+  /**
+   * Caret requests of at least this many bytes are read into a buffer of
+   * their own instead of the connection's read buffer, see
+   * McParser::setLargeMessageThreshold(). 0 to disable.
+   */
+  size_t largeMessageReadThreshold{0};
+
   /**
    * String that will be returned for 'VERSION' commands.
    */
@@ -99,6 +145,12 @@ struct AsyncMcServerWorkerOptions {
    */
   std::shared_ptr<CpuController> cpuController;
 
+  /**
+   * If set, the worker moves connections away when its thread is busier
+   * than the other workers' (see ConnectionRebalancer).
+   */
+  std::shared_ptr<ConnectionRebalancer> connectionRebalancer;
+
   /**
    * Payloads >= tcpZeroCopyThresholdBytes will undergo copy avoidance and
    * the kernel will queue a completion notification once transmission is
@@ -128,6 +180,11 @@ struct AsyncMcServerWorkerOptions {
    */
   bool useKtls12{false};
 
+  /**
+   * Whether to try KTLS for accepted TLS 1.3 (fizz) connections
+   */
+  bool useKtls13{false};
+
   /**
    * Whether to enable tos reflection
    */
@@ -138,6 +195,14 @@ struct AsyncMcServerWorkerOptions {
    * that packets will be unmarked.
    */
   int trafficClass{0};
+
+  /**
+   * If non-zero, SO_BUSY_POLL is set on accepted TCP sockets: reads with
+   * nothing to read busy-poll the device queue for up to this long before
+   * sleeping, trading CPU for wakeup latency. Values above the
+   * net.core.busy_read sysctl require CAP_NET_ADMIN.
+   */
+  std::chrono::microseconds busyPoll{0};
 };
 } // namespace memcache
 } // namespace facebook
@@ -17,6 +17,11 @@ namespace facebook {
 namespace memcache {
 
 constexpr char kCaretMagicByte = '^';
+// Compact header: instead of the number of additional fields, the header
+// carries a bitmask of the additional fields present (bit i is
+// CaretAdditionalFieldType i), followed only by their values, in field type
+// order.
+constexpr char kCaretCompactMagicByte = '%';
 constexpr size_t kMaxAdditionalFields = 6;
 constexpr size_t kMaxHeaderLength = 1 /* magic byte */ +
     1 /* GroupVarint header (lengths of 4 ints) */ +
@@ -26,12 +31,21 @@ constexpr size_t kMaxHeaderLength = 1 /* magic byte */ +
 
 constexpr uint32_t kCaretConnectionControlReqId = 0;
 
+// Type id of the (header only) connection control message a client sends
+// to announce the compression codecs it supports (SUPPORTED_CODECS_*
+// fields) for the whole connection, instead of in every request. Outside
+// of the range of carbon type ids.
+constexpr uint32_t kCaretCompressionCodecsTypeId = 0x10000;
+
 struct CaretMessageInfo {
   uint32_t headerSize;
   uint32_t bodySize;
   uint32_t typeId;
   uint32_t reqId;
 
+  // Parsed from / serialized as a compact header (kCaretCompactMagicByte).
+  bool compactHeader{false};
+
   // Additional fields
   std::pair<uint64_t, uint64_t> traceId{0, 0};
   uint64_t supportedCodecsFirstId{0};
@@ -40,6 +54,7 @@ struct CaretMessageInfo {
   uint64_t uncompressedBodySize{0};
   uint64_t dropProbability{0}; // Deprecated in version 37
   ServerLoad serverLoad{0};
+  uint64_t timeoutBudgetMs{0};
 };
 
 enum class CaretAdditionalFieldType {
@@ -64,6 +79,10 @@ enum class CaretAdditionalFieldType {
 
   // Load on the server
   SERVER_LOAD = 7,
+
+  // Time the sender will wait for the reply to this request, in ms. Lets
+  // the next tier stop working on it once the sender gave up.
+  TIMEOUT_BUDGET_MS = 8,
 };
 
 } // namespace memcache
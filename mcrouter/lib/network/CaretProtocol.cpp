@@ -7,6 +7,8 @@
 
 #include "mcrouter/lib/network/CaretProtocol.h"
 
+#include <array>
+
 #include <folly/GroupVarint.h>
 #include <folly/Range.h>
 #include <folly/Varint.h>
@@ -19,6 +21,9 @@ namespace memcache {
 
 namespace {
 
+constexpr uint64_t kLastAdditionalFieldType =
+    static_cast<uint64_t>(CaretAdditionalFieldType::TIMEOUT_BUDGET_MS);
+
 void resetAdditionalFields(CaretMessageInfo& info) {
   info.traceId = {0, 0};
   info.supportedCodecsFirstId = 0;
@@ -27,6 +32,7 @@ void resetAdditionalFields(CaretMessageInfo& info) {
   info.uncompressedBodySize = 0;
   info.dropProbability = 0;
   info.serverLoad = ServerLoad::zero();
+  info.timeoutBudgetMs = 0;
 }
 
 size_t getNumAdditionalFields(const CaretMessageInfo& info) {
@@ -55,6 +61,9 @@ size_t getNumAdditionalFields(const CaretMessageInfo& info) {
   if (!info.serverLoad.isZero()) {
     ++nAdditionalFields;
   }
+  if (info.timeoutBudgetMs != 0) {
+    ++nAdditionalFields;
+  }
   return nAdditionalFields;
 }
 
@@ -101,10 +110,106 @@ size_t serializeAdditionalFields(
       buf, CaretAdditionalFieldType::DROP_PROBABILITY, info.dropProbability);
   buf += serializeAdditionalFieldIfNonZero(
       buf, CaretAdditionalFieldType::SERVER_LOAD, info.serverLoad.raw());
+  buf += serializeAdditionalFieldIfNonZero(
+      buf,
+      CaretAdditionalFieldType::TIMEOUT_BUDGET_MS,
+      info.timeoutBudgetMs);
 
   return buf - destination;
 }
 
+/**
+ * Sets the additional field of the given type, unknown types are ignored.
+ */
+void setAdditionalField(
+    CaretMessageInfo& headerInfo,
+    uint64_t fieldType,
+    uint64_t fieldValue) {
+  if (fieldType > kLastAdditionalFieldType) {
+    // Additional Field Type not recognized, ignore.
+    return;
+  }
+
+  switch (static_cast<CaretAdditionalFieldType>(fieldType)) {
+    case CaretAdditionalFieldType::TRACE_ID:
+      headerInfo.traceId.first = fieldValue;
+      break;
+    case CaretAdditionalFieldType::TRACE_NODE_ID:
+      headerInfo.traceId.second = fieldValue;
+      break;
+    case CaretAdditionalFieldType::SUPPORTED_CODECS_FIRST_ID:
+      headerInfo.supportedCodecsFirstId = fieldValue;
+      break;
+    case CaretAdditionalFieldType::SUPPORTED_CODECS_SIZE:
+      headerInfo.supportedCodecsSize = fieldValue;
+      break;
+    case CaretAdditionalFieldType::USED_CODEC_ID:
+      headerInfo.usedCodecId = fieldValue;
+      break;
+    case CaretAdditionalFieldType::UNCOMPRESSED_BODY_SIZE:
+      headerInfo.uncompressedBodySize = fieldValue;
+      break;
+    case CaretAdditionalFieldType::DROP_PROBABILITY:
+      headerInfo.dropProbability = fieldValue;
+      break;
+    case CaretAdditionalFieldType::SERVER_LOAD:
+      headerInfo.serverLoad = ServerLoad(fieldValue);
+      break;
+    case CaretAdditionalFieldType::TIMEOUT_BUDGET_MS:
+      headerInfo.timeoutBudgetMs = fieldValue;
+      break;
+  }
+}
+
+/**
+ * Values of the additional fields, indexed by CaretAdditionalFieldType.
+ */
+std::array<uint64_t, kLastAdditionalFieldType + 1> getAdditionalFieldValues(
+    const CaretMessageInfo& info) {
+  std::array<uint64_t, kLastAdditionalFieldType + 1> values;
+  auto set = [&values](CaretAdditionalFieldType type, uint64_t value) {
+    values[static_cast<size_t>(type)] = value;
+  };
+  set(CaretAdditionalFieldType::TRACE_ID, info.traceId.first);
+  set(
+      CaretAdditionalFieldType::SUPPORTED_CODECS_FIRST_ID,
+      info.supportedCodecsFirstId);
+  set(
+      CaretAdditionalFieldType::SUPPORTED_CODECS_SIZE,
+      info.supportedCodecsSize);
+  set(CaretAdditionalFieldType::USED_CODEC_ID, info.usedCodecId);
+  set(
+      CaretAdditionalFieldType::UNCOMPRESSED_BODY_SIZE,
+      info.uncompressedBodySize);
+  set(CaretAdditionalFieldType::DROP_PROBABILITY, info.dropProbability);
+  set(CaretAdditionalFieldType::TRACE_NODE_ID, info.traceId.second);
+  set(CaretAdditionalFieldType::SERVER_LOAD, info.serverLoad.raw());
+  set(CaretAdditionalFieldType::TIMEOUT_BUDGET_MS, info.timeoutBudgetMs);
+  return values;
+}
+
+size_t caretPrepareCompactHeader(
+    const CaretMessageInfo& info,
+    char* headerBuf) {
+  const auto values = getAdditionalFieldValues(info);
+  uint32_t fieldMask = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (values[i] != 0) {
+      fieldMask |= 1u << i;
+    }
+  }
+
+  headerBuf[0] = kCaretCompactMagicByte;
+  char* buf = folly::GroupVarint32::encode(
+      headerBuf + 1, info.bodySize, info.typeId, info.reqId, fieldMask);
+  for (auto value : values) {
+    if (value != 0) {
+      buf += folly::encodeVarint(value, reinterpret_cast<uint8_t*>(buf));
+    }
+  }
+  return buf - headerBuf;
+}
+
 } // anonymous namespace
 
 ParseStatus caretParseHeader(
@@ -118,9 +223,10 @@ ParseStatus caretParseHeader(
     return ParseStatus::NotEnoughData;
   }
 
-  if (buff[0] != kCaretMagicByte) {
+  if (buff[0] != kCaretMagicByte && buff[0] != kCaretCompactMagicByte) {
     return ParseStatus::MessageParseError;
   }
+  headerInfo.compactHeader = buff[0] == kCaretCompactMagicByte;
 
   const char* buf = reinterpret_cast<const char*>(buff);
   size_t encodedLength = folly::GroupVarint32::encodedSize(buf + 1);
@@ -140,8 +246,25 @@ ParseStatus caretParseHeader(
   folly::StringPiece range(buf, nbuf);
   range.advance(encodedLength + 1);
 
-  // Additional fields are sequence of (key,value) pairs
   resetAdditionalFields(headerInfo);
+  if (headerInfo.compactHeader) {
+    // Additional fields are the values of the fields set in the bitmask
+    for (uint32_t fieldType = 0; additionalFields != 0; ++fieldType) {
+      if (!(additionalFields & (1u << fieldType))) {
+        continue;
+      }
+      additionalFields &= ~(1u << fieldType);
+      if (auto maybeFieldValue = folly::tryDecodeVarint(range)) {
+        setAdditionalField(headerInfo, fieldType, *maybeFieldValue);
+      } else {
+        return ParseStatus::NotEnoughData;
+      }
+    }
+    headerInfo.headerSize = range.cbegin() - buf;
+    return ParseStatus::Ok;
+  }
+
+  // Additional fields are sequence of (key,value) pairs
   for (uint32_t i = 0; i < additionalFields; i++) {
     size_t fieldType;
     if (auto maybeFieldType = folly::tryDecodeVarint(range)) {
@@ -157,38 +280,7 @@ ParseStatus caretParseHeader(
       return ParseStatus::NotEnoughData;
     }
 
-    if (fieldType >
-        static_cast<uint64_t>(CaretAdditionalFieldType::SERVER_LOAD)) {
-      // Additional Field Type not recognized, ignore.
-      continue;
-    }
-
-    switch (static_cast<CaretAdditionalFieldType>(fieldType)) {
-      case CaretAdditionalFieldType::TRACE_ID:
-        headerInfo.traceId.first = fieldValue;
-        break;
-      case CaretAdditionalFieldType::TRACE_NODE_ID:
-        headerInfo.traceId.second = fieldValue;
-        break;
-      case CaretAdditionalFieldType::SUPPORTED_CODECS_FIRST_ID:
-        headerInfo.supportedCodecsFirstId = fieldValue;
-        break;
-      case CaretAdditionalFieldType::SUPPORTED_CODECS_SIZE:
-        headerInfo.supportedCodecsSize = fieldValue;
-        break;
-      case CaretAdditionalFieldType::USED_CODEC_ID:
-        headerInfo.usedCodecId = fieldValue;
-        break;
-      case CaretAdditionalFieldType::UNCOMPRESSED_BODY_SIZE:
-        headerInfo.uncompressedBodySize = fieldValue;
-        break;
-      case CaretAdditionalFieldType::DROP_PROBABILITY:
-        headerInfo.dropProbability = fieldValue;
-        break;
-      case CaretAdditionalFieldType::SERVER_LOAD:
-        headerInfo.serverLoad = ServerLoad(fieldValue);
-        break;
-    }
+    setAdditionalField(headerInfo, fieldType, fieldValue);
   }
 
   headerInfo.headerSize = range.cbegin() - buf;
@@ -198,6 +290,9 @@ ParseStatus caretParseHeader(
 
 size_t caretPrepareHeader(const CaretMessageInfo& info, char* headerBuf) {
   // Header is at most kMaxHeaderLength without extra fields.
+  if (info.compactHeader) {
+    return caretPrepareCompactHeader(info, headerBuf);
+  }
 
   uint32_t bodySize = info.bodySize;
   uint32_t typeId = info.typeId;
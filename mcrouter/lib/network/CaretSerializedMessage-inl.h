@@ -33,6 +33,7 @@ bool CaretSerializedMessage::prepare(
     const Request& req,
     size_t reqId,
     const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeoutBudget,
     const struct iovec*& iovOut,
     size_t& niovOut) noexcept {
   return fill(
@@ -41,6 +42,7 @@ bool CaretSerializedMessage::prepare(
       Request::typeId,
       detail::getRequestTraceId(req),
       supportedCodecs,
+      timeoutBudget,
       iovOut,
       niovOut);
 }
@@ -73,6 +75,7 @@ bool CaretSerializedMessage::fill(
     size_t typeId,
     std::pair<uint64_t, uint64_t> traceId,
     const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeoutBudget,
     const struct iovec*& iovOut,
     size_t& niovOut) {
   // Serialize body into storage_. Note we must defer serialization of header.
@@ -88,6 +91,9 @@ bool CaretSerializedMessage::fill(
     info.supportedCodecsFirstId = supportedCodecs.firstId;
     info.supportedCodecsSize = supportedCodecs.size;
   }
+  if (timeoutBudget.count() > 0) {
+    info.timeoutBudgetMs = timeoutBudget.count();
+  }
   fillImpl(info, reqId, typeId, traceId, ServerLoad::zero(), iovOut, niovOut);
   return true;
 }
@@ -170,6 +176,7 @@ inline void CaretSerializedMessage::fillImpl(
   info.reqId = reqId;
   info.traceId = traceId;
   info.serverLoad = serverLoad;
+  info.compactHeader = compactHeader_;
 
   size_t headerSize = caretPrepareHeader(
       info, reinterpret_cast<char*>(storage_.getHeaderBuf()));
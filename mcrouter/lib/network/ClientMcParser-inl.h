@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <type_traits>
+
 #include <folly/Format.h>
 #include <folly/io/Cursor.h>
 
@@ -105,36 +107,63 @@ void ClientMcParser<Callback>::forwardCaretReply(
     const CaretMessageInfo& headerInfo,
     const folly::IOBuf& buffer,
     uint64_t reqId) {
+  if constexpr (std::is_same_v<Callback, AsyncMcClientImpl>) {
+    if (headerInfo.usedCodecId > 0 && decompressionOffloadThreshold_ > 0 &&
+        headerInfo.uncompressedBodySize >= decompressionOffloadThreshold_) {
+      // The clone keeps the read buffer alive, the parser copies the data
+      // it still needs to a new one before reading again.
+      callback_.offloadReply(
+          [headerInfo, buf = buffer.cloneOneAsValue()](
+              const CompressionCodecMap* codecMap) {
+            return parseCaretReply<ReplyT<Request>>(headerInfo, buf, codecMap);
+          },
+          reqId,
+          getReplyStats(headerInfo));
+      return;
+    }
+  }
+
+  callback_.replyReady(
+      parseCaretReply<ReplyT<Request>>(
+          headerInfo, buffer, compressionCodecMap_),
+      reqId,
+      getReplyStats(headerInfo));
+}
+
+template <class Callback>
+template <class Reply>
+Reply ClientMcParser<Callback>::parseCaretReply(
+    const CaretMessageInfo& headerInfo,
+    const folly::IOBuf& buffer,
+    const CompressionCodecMap* codecMap) {
   const folly::IOBuf* finalBuffer = &buffer;
   size_t offset = headerInfo.headerSize;
 
   // Uncompress if compressed
   std::unique_ptr<folly::IOBuf> uncompressedBuf;
   if (headerInfo.usedCodecId > 0) {
-    uncompressedBuf = decompress(headerInfo, buffer);
+    uncompressedBuf = decompress(headerInfo, buffer, codecMap);
     finalBuffer = uncompressedBuf.get();
     offset = 0;
   }
 
-  ReplyT<Request> reply;
+  Reply reply;
   folly::io::Cursor cur(finalBuffer);
   cur += offset;
   carbon::CarbonProtocolReader reader(cur);
   reply.deserialize(reader);
   reply.setTraceContext(
       carbon::tracing::deserializeTraceContext(headerInfo.traceId));
-
-  callback_.replyReady(std::move(reply), reqId, getReplyStats(headerInfo));
+  return reply;
 }
 
 template <class Callback>
 std::unique_ptr<folly::IOBuf> ClientMcParser<Callback>::decompress(
     const CaretMessageInfo& headerInfo,
-    const folly::IOBuf& buffer) {
+    const folly::IOBuf& buffer,
+    const CompressionCodecMap* codecMap) {
   assert(!buffer.isChained());
-  auto* codec = compressionCodecMap_
-      ? compressionCodecMap_->get(headerInfo.usedCodecId)
-      : nullptr;
+  auto* codec = codecMap ? codecMap->get(headerInfo.usedCodecId) : nullptr;
   if (!codec) {
     throw std::runtime_error(folly::sformat(
         "Failed to get compression codec id {}. Reply is likely corrupted!",
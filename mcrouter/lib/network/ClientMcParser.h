@@ -22,6 +22,8 @@
 namespace facebook {
 namespace memcache {
 
+class AsyncMcClientImpl;
+
 template <class Callback>
 class ClientMcParser : private McParser::ParserCallback {
  public:
@@ -68,6 +70,33 @@ class ClientMcParser : private McParser::ParserCallback {
     parser_.setProtocol(protocol);
   }
 
+  /**
+   * Expect replies to meta commands, see ConnectionOptions::asciiMetaProtocol.
+   */
+  void setAsciiMetaProtocol(bool metaProtocol) {
+    asciiParser_.setMetaProtocol(metaProtocol);
+  }
+
+  /**
+   * Compressed caret replies whose uncompressed size is at least `threshold`
+   * are handed to Callback::offloadReply() instead of being decompressed
+   * inline. 0 (the default) disables it. Only supported by AsyncMcClientImpl.
+   */
+  void setDecompressionOffloadThreshold(size_t threshold) {
+    decompressionOffloadThreshold_ = threshold;
+  }
+
+  /**
+   * Decompresses (with a codec of `codecMap`) and deserializes a caret reply.
+   *
+   * @param buffer  Holds the entire message, header included.
+   */
+  template <class Reply>
+  static Reply parseCaretReply(
+      const CaretMessageInfo& headerInfo,
+      const folly::IOBuf& buffer,
+      const CompressionCodecMap* codecMap);
+
  private:
   McParser parser_;
   McClientAsciiParser asciiParser_;
@@ -82,6 +111,7 @@ class ClientMcParser : private McParser::ParserCallback {
   ConnectionFifo* debugFifo_{nullptr};
 
   const CompressionCodecMap* compressionCodecMap_{nullptr};
+  size_t decompressionOffloadThreshold_{0};
 
   template <class Request>
   void forwardAsciiReply();
@@ -92,9 +122,10 @@ class ClientMcParser : private McParser::ParserCallback {
       const folly::IOBuf& buffer,
       uint64_t reqId);
 
-  std::unique_ptr<folly::IOBuf> decompress(
+  static std::unique_ptr<folly::IOBuf> decompress(
       const CaretMessageInfo& headerInfo,
-      const folly::IOBuf& buffer);
+      const folly::IOBuf& buffer,
+      const CompressionCodecMap* codecMap);
 
   // McParser callbacks
   bool caretMessageReady(
@@ -83,11 +83,26 @@ struct ConnectionOptions {
    */
   std::chrono::milliseconds connectTimeout{0};
 
+  /**
+   * If non-zero, a destination with several addresses (a hostname with
+   * several A/AAAA records) has them tried one after the other, address
+   * families alternating, each but the last one with this connect timeout.
+   * Otherwise only its first address is used.
+   */
+  std::chrono::milliseconds alternateAddressConnectTimeout{0};
+
   /**
    * Write timeout in ms.
    */
   std::chrono::milliseconds writeTimeout{0};
 
+  /**
+   * Whether to use TCP Fast Open for plaintext connections. The connection
+   * is reported as established right away and the first write goes out
+   * with the SYN, so connect errors show up as write errors.
+   */
+  bool enableTFO{false};
+
   /**
    * Informs whether QoS is enabled.
    */
@@ -126,12 +141,39 @@ struct ConnectionOptions {
    */
   bool useJemallocNodumpAllocator{false};
 
+  /**
+   * Move plaintext connections to an io_uring backed transport once
+   * connected. Only takes effect if the client's EventBase runs on the
+   * io_uring backend, otherwise regular AsyncSocket is used.
+   */
+  bool useIoUring{false};
+
   /**
    * Map of codecs to use for compression.
    * If nullptr, compression will be disabled.
    */
   const CompressionCodecMap* compressionCodecMap{nullptr};
 
+  /**
+   * If true, a caret connection announces the codecs of compressionCodecMap
+   * once, with a connection control message (kCaretCompressionCodecsTypeId),
+   * instead of in the header of every request. The server must support it.
+   */
+  bool negotiateCompression{false};
+
+  /**
+   * Manager of compressionCodecMap, used to get the codecs of other threads.
+   */
+  const CompressionCodecManager* compressionCodecManager{nullptr};
+
+  /**
+   * If non-zero, compressed caret replies whose uncompressed size is at
+   * least this are decompressed on the auxiliary CPU thread pool, so that
+   * large values don't stall the other requests of the event base.
+   * Requires compressionCodecManager.
+   */
+  size_t decompressionOffloadThreshold{0};
+
   /**
    * True to enable thrift compression.
    */
@@ -142,6 +184,66 @@ struct ConnectionOptions {
    * iff thriftCompression is enabled.
    */
   size_t thriftCompressionThreshold{0};
+
+  /**
+   * If true, thrift transports to the same destination on the same event base
+   * share a single Rocket channel, which multiplexes their requests.
+   */
+  bool thriftShareChannel{false};
+
+  /**
+   * Limits of a single writev() when flushing queued requests. Requests
+   * queued during one event base loop iteration are batched together until
+   * either limit is reached. The number of iovecs is capped to IOV_MAX.
+   */
+  size_t writeBatchMaxBytes{24576};
+  size_t writeBatchMaxIovecs{128};
+
+  /**
+   * If true, requests queued on a connection with no request in flight are
+   * written at the end of the current loop callback, instead of being
+   * batched with other connections' writes (see Transport::setFlushList()).
+   */
+  bool writeIdleImmediately{false};
+
+  /**
+   * If non-zero, TCP_INFO is sampled from the read path once every this many
+   * reads (see Transport::getTcpInfo()).
+   */
+  uint32_t tcpInfoSamplePeriod{0};
+
+  /**
+   * If true, caret requests tell the server how long their reply is waited
+   * for (CaretAdditionalFieldType::TIMEOUT_BUDGET_MS).
+   */
+  bool sendTimeoutBudget{false};
+
+  /**
+   * If true, caret requests are sent with the compact header
+   * (kCaretCompactMagicByte). The server must understand it.
+   */
+  bool compactCaretHeader{false};
+
+  /**
+   * If true, get, gets, gat, gats, storage and delete requests to ascii
+   * destinations are sent as meta commands (mg, ms, md), which have shorter
+   * replies. The server must be a memcached that speaks the meta protocol.
+   */
+  bool asciiMetaProtocol{false};
+
+  /**
+   * If true, the time requests spend in the pending queue (e.g. because of
+   * the max inflight throttle) counts against their timeout: the ones whose
+   * timeout elapsed before they could be written are failed with TIMEOUT
+   * instead of being sent.
+   */
+  bool expirePendingRequests{false};
+
+  /**
+   * If non-zero, once this many requests are pending, the most recent ones
+   * are sent first (adaptive LIFO).
+   */
+  size_t pendingLifoThreshold{0};
 };
 } // namespace memcache
 } // namespace facebook
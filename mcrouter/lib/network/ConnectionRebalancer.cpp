@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ConnectionRebalancer.h"
+
+#include <algorithm>
+
+namespace facebook {
+namespace memcache {
+
+ConnectionRebalancer::ConnectionRebalancer(
+    ConnectionRebalancerOptions opts,
+    size_t maxWorkers)
+    : opts_(std::move(opts)),
+      maxWorkers_(maxWorkers),
+      workers_(std::make_unique<Worker[]>(maxWorkers)) {}
+
+size_t ConnectionRebalancer::addWorker() {
+  auto id = numWorkers_.fetch_add(1);
+  if (id >= maxWorkers_) {
+    numWorkers_ = maxWorkers_;
+    return static_cast<size_t>(-1);
+  }
+  return id;
+}
+
+size_t ConnectionRebalancer::update(size_t worker, double load) {
+  if (worker >= maxWorkers_) {
+    return 0;
+  }
+  auto& self = workers_[worker];
+  self.load.store(load, std::memory_order_relaxed);
+
+  double total = 0;
+  size_t numReported = 0;
+  const auto numWorkers = std::min(numWorkers_.load(), maxWorkers_);
+  for (size_t i = 0; i < numWorkers; ++i) {
+    auto workerLoad = workers_[i].load.load(std::memory_order_relaxed);
+    if (workerLoad >= 0) {
+      total += workerLoad;
+      ++numReported;
+    }
+  }
+  if (numReported < 2 || load - total / numReported < opts_.minImbalance) {
+    self.hotStreak = 0;
+    return 0;
+  }
+  if (++self.hotStreak < opts_.hotIntervals) {
+    return 0;
+  }
+  return opts_.maxConnsPerInterval;
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+namespace facebook {
+namespace memcache {
+
+struct ConnectionRebalancerOptions {
+  /**
+   * How often every worker measures its load. 0 disables rebalancing.
+   */
+  std::chrono::milliseconds interval{0};
+
+  /**
+   * A worker is hot when the CPU usage of its thread is at least this much
+   * above the average of all the workers (0.2 is 20% of a core).
+   */
+  double minImbalance{0.2};
+
+  /**
+   * Number of consecutive intervals a worker must be hot before it starts
+   * moving connections away.
+   */
+  size_t hotIntervals{3};
+
+  /**
+   * Max number of connections a hot worker closes per interval.
+   */
+  size_t maxConnsPerInterval{4};
+};
+
+/**
+ * Balances the load of the workers of an AsyncMcServer by moving
+ * connections away from the ones that stay busier than the others.
+ *
+ * Every worker periodically reports the CPU usage of its thread with
+ * update(). A worker that stays hot closes some of its idle connections,
+ * asking caret clients to reconnect with a GoAway message (see
+ * McServerSession::beginClose()); the new connections are accepted by any
+ * worker, so hot workers drain toward cooler ones.
+ *
+ * Thread safe.
+ */
+class ConnectionRebalancer {
+ public:
+  ConnectionRebalancer(ConnectionRebalancerOptions opts, size_t maxWorkers);
+
+  const ConnectionRebalancerOptions& options() const {
+    return opts_;
+  }
+
+  /**
+   * @return  id of a new worker, to pass to update(), or -1 if there are
+   *          already maxWorkers workers.
+   */
+  size_t addWorker();
+
+  /**
+   * Records the load of a worker. Must only be called by that worker.
+   *
+   * @param load  CPU usage of the worker's thread since its previous update,
+   *              as a fraction of a core.
+   *
+   * @return  number of connections the worker should move away now.
+   */
+  size_t update(size_t worker, double load);
+
+ private:
+  struct Worker {
+    // Negative until the first update
+    std::atomic<double> load{-1.0};
+    size_t hotStreak{0};
+  };
+
+  const ConnectionRebalancerOptions opts_;
+  const size_t maxWorkers_;
+  std::unique_ptr<Worker[]> workers_;
+  std::atomic<size_t> numWorkers_{0};
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -56,6 +56,20 @@ bool ConnectionTracker::writesPending() const {
   return false;
 }
 
+size_t ConnectionTracker::closeIdle(size_t max, folly::StringPiece reason) {
+  size_t numClosed = 0;
+  auto it = sessions_.begin();
+  while (it != sessions_.end() && numClosed < max) {
+    auto& session = *it;
+    ++it;
+    if (!session.writesPending()) {
+      ++numClosed;
+      session.beginClose(reason);
+    }
+  }
+  return numClosed;
+}
+
 void ConnectionTracker::touch(McServerSession& session) {
   // Find the connection and bring it to the front of the LRU.
   // Do it only once in 16 requests because it's still expensive.
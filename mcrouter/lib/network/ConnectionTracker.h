@@ -76,6 +76,15 @@ class ConnectionTracker : public McServerSession::StateCallback {
    */
   bool writesPending() const;
 
+  /**
+   * Starts closing up to `max` connections with no request in flight, most
+   * recently used first, asking the clients to reconnect (see
+   * McServerSession::beginClose()).
+   *
+   * @return  number of connections being closed.
+   */
+  size_t closeIdle(size_t max, folly::StringPiece reason);
+
  private:
   McServerSession::Queue sessions_;
   std::function<void(McServerSession&)> onAccepted_;
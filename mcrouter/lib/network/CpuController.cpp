@@ -7,10 +7,14 @@
 
 #include "CpuController.h"
 
+#include <pthread.h>
+
+#include <algorithm>
 #include <cassert>
 
 #include <folly/File.h>
 #include <folly/FileUtil.h>
+#include <glog/logging.h>
 
 namespace facebook {
 namespace memcache {
@@ -43,12 +47,24 @@ bool readProcStat(std::vector<uint64_t>& curArray) {
   return true;
 }
 
+bool readThreadCpu(clockid_t clock, std::chrono::nanoseconds& cpu) {
+  timespec ts;
+  if (clock_gettime(clock, &ts) != 0) {
+    return false;
+  }
+  cpu = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+  return true;
+}
+
 } // namespace
 
 CpuController::CpuController(
     const CpuControllerOptions& opts,
     folly::EventBase& evb)
-    : evb_(evb), dataCollectionInterval_(opts.dataCollectionInterval) {
+    : evb_(evb),
+      dataCollectionInterval_(opts.dataCollectionInterval),
+      useThreadCpu_(opts.useThreadCpu),
+      loopLagForFullLoad_(opts.loopLagForFullLoad) {
   assert(opts.shouldEnable());
 }
 
@@ -62,8 +78,47 @@ void CpuController::stop() {
   stopController_ = true;
 }
 
-// Compute the cpu utilization
+void CpuController::addThread(folly::EventBase& evb) {
+  Thread thread;
+  thread.evb = &evb;
+  if (pthread_getcpuclockid(pthread_self(), &thread.clock) != 0 ||
+      !readThreadCpu(thread.clock, thread.lastCpu)) {
+    LOG(WARNING) << "Can't read the CPU time of the thread, not measuring it";
+    return;
+  }
+  thread.lastSample = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(threadsMutex_);
+  threads_.push_back(std::move(thread));
+}
+
+void CpuController::removeThread(folly::EventBase& evb) {
+  std::lock_guard<std::mutex> lock(threadsMutex_);
+  threads_.erase(
+      std::remove_if(
+          threads_.begin(),
+          threads_.end(),
+          [&evb](const Thread& thread) { return thread.evb == &evb; }),
+      threads_.end());
+}
+
 void CpuController::cpuLoggingFn() {
+  double cpuUtil = useThreadCpu_ ? threadCpuUtil() : procStatUtil();
+  if (loopLagForFullLoad_.count() > 0) {
+    cpuUtil = std::max(cpuUtil, loopLagUtil());
+  }
+  if (stopController_) {
+    update(0.0);
+    return;
+  }
+  update(cpuUtil);
+  auto self = shared_from_this();
+  evb_.runAfterDelay(
+      [this, self]() { cpuLoggingFn(); }, dataCollectionInterval_.count());
+}
+
+// Compute the cpu utilization of the host
+double CpuController::procStatUtil() {
   double cpuUtil = 0.0;
 
   // Corner case: When parsing /proc/stat fails, set the cpuUtil to 0.
@@ -100,14 +155,66 @@ void CpuController::cpuLoggingFn() {
       prev_ = std::move(cur);
     }
   }
-  if (stopController_) {
-    update(0.0);
-    return;
+  return cpuUtil;
+}
+
+double CpuController::threadCpuUtil() {
+  std::chrono::nanoseconds used{0};
+  std::chrono::nanoseconds elapsed{0};
+  const auto now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(threadsMutex_);
+  for (auto& thread : threads_) {
+    std::chrono::nanoseconds cpu;
+    if (!readThreadCpu(thread.clock, cpu)) {
+      continue;
+    }
+    used += cpu - thread.lastCpu;
+    elapsed += now - thread.lastSample;
+    thread.lastCpu = cpu;
+    thread.lastSample = now;
   }
-  update(cpuUtil);
-  auto self = shared_from_this();
-  evb_.runAfterDelay(
-      [this, self]() { cpuLoggingFn(); }, dataCollectionInterval_.count());
+  if (elapsed.count() <= 0) {
+    return 0.0;
+  }
+  return std::min(
+      static_cast<double>(used.count()) / elapsed.count() * 100, 100.0);
+}
+
+double CpuController::loopLagUtil() {
+  int64_t maxLagUs = 0;
+  const auto now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(threadsMutex_);
+  for (auto& thread : threads_) {
+    if (thread.probe) {
+      auto lagUs = thread.probe->lagUs.load(std::memory_order_relaxed);
+      if (lagUs < 0) {
+        // Still not run: the loop is at least this late, keep waiting.
+        maxLagUs = std::max<int64_t>(
+            maxLagUs,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                now - thread.probe->posted)
+                .count());
+        continue;
+      }
+      maxLagUs = std::max(maxLagUs, lagUs);
+    }
+    // The lag measured by this probe is used by the next sample.
+    auto probe = std::make_shared<LagProbe>();
+    probe->posted = now;
+    thread.probe = probe;
+    thread.evb->runInEventBaseThread([probe = std::move(probe)]() {
+      probe->lagUs.store(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - probe->posted)
+              .count(),
+          std::memory_order_relaxed);
+    });
+  }
+  return std::min(
+      static_cast<double>(maxLagUs) / loopLagForFullLoad_.count() * 100,
+      100.0);
 }
 
 void CpuController::update(double cpuUtil) {
@@ -7,7 +7,13 @@
 
 #pragma once
 
+#include <time.h>
+
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <folly/io/async/EventBase.h>
 
@@ -23,6 +29,21 @@ struct CpuControllerOptions {
    */
   std::chrono::milliseconds dataCollectionInterval{0};
 
+  /**
+   * If true, the load is the CPU time used by the threads added with
+   * CpuController::addThread() (the server threads), relative to the time
+   * they could have used, instead of the CPU use of the whole host read from
+   * /proc/stat.
+   */
+  bool useThreadCpu{false};
+
+  /**
+   * If non-zero, every sample also measures how long the event bases of the
+   * added threads take to run a callback, and the load is at least
+   * lag / loopLagForFullLoad (capped at 100%).
+   */
+  std::chrono::microseconds loopLagForFullLoad{0};
+
   bool shouldEnable() const noexcept {
     return dataCollectionInterval.count() > 0;
   }
@@ -42,16 +63,49 @@ class CpuController : public std::enable_shared_from_this<CpuController> {
   void start();
   void stop();
 
+  /**
+   * Adds the calling thread, running `evb`, to the threads measured with
+   * useThreadCpu and loopLagForFullLoad. Must be called from that thread.
+   */
+  void addThread(folly::EventBase& evb);
+
+  /**
+   * Stops measuring the thread running `evb`. Must be called before `evb` is
+   * destroyed.
+   */
+  void removeThread(folly::EventBase& evb);
+
  private:
+  struct LagProbe {
+    std::chrono::steady_clock::time_point posted;
+    std::atomic<int64_t> lagUs{-1};
+  };
+
+  struct Thread {
+    folly::EventBase* evb;
+    clockid_t clock;
+    std::chrono::nanoseconds lastCpu;
+    std::chrono::steady_clock::time_point lastSample;
+    std::shared_ptr<LagProbe> probe;
+  };
+
   // The function responsible for logging the CPU utilization.
   void cpuLoggingFn();
 
+  double procStatUtil();
+  double threadCpuUtil();
+  double loopLagUtil();
+
   // Updates cpu utilization value.
   void update(double cpuUtil);
 
   folly::EventBase& evb_;
   std::vector<uint64_t> prev_{8};
   std::chrono::milliseconds dataCollectionInterval_;
+  const bool useThreadCpu_;
+  const std::chrono::microseconds loopLagForFullLoad_;
+  std::mutex threadsMutex_;
+  std::vector<Thread> threads_;
   std::atomic<double> percentLoad_{0.0};
   std::atomic<bool> stopController_{false};
   bool firstLoop_{true};
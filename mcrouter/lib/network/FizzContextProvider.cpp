@@ -7,6 +7,8 @@
 
 #include "FizzContextProvider.h"
 
+#include <atomic>
+
 #include <fizz/client/FizzClientContext.h>
 #include <fizz/client/SynchronizedLruPskCache.h>
 #include <fizz/protocol/DefaultCertificateVerifier.h>
@@ -31,8 +33,14 @@ void initSSL() {
 constexpr size_t kSessionLifeTime = 86400;
 /* Handshakes are valid for up to 1 week */
 constexpr size_t kHandshakeValidity = 604800;
+
+std::atomic<size_t> pskCacheCapacity{100};
 } // namespace
 
+void setClientPskCacheCapacity(size_t capacity) {
+  pskCacheCapacity = capacity;
+}
+
 FizzContextAndVerifier createClientFizzContextAndVerifier(
     std::string certData,
     std::string keyData,
@@ -40,7 +48,8 @@ FizzContextAndVerifier createClientFizzContextAndVerifier(
     bool preferOcbCipher) {
   // global session cache
   static auto SESSION_CACHE =
-      std::make_shared<fizz::client::SynchronizedLruPskCache>(100);
+      std::make_shared<fizz::client::SynchronizedLruPskCache>(
+          pskCacheCapacity.load());
   initSSL();
   auto ctx = std::make_shared<fizz::client::FizzClientContext>();
   ctx->setSupportedVersions({fizz::ProtocolVersion::tls_1_3});
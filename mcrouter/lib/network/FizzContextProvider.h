@@ -29,6 +29,12 @@ using FizzContextAndVerifier = std::pair<
     std::shared_ptr<const fizz::client::FizzClientContext>,
     std::shared_ptr<const fizz::CertificateVerifier>>;
 
+/**
+ * Sets the capacity of the process-wide PSK cache shared by all client
+ * contexts. Has no effect once the first client context was created.
+ */
+void setClientPskCacheCapacity(size_t capacity);
+
 FizzContextAndVerifier createClientFizzContextAndVerifier(
     std::string certData,
     std::string keyData,
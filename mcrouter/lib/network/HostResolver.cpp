@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "mcrouter/lib/network/HostResolver.h"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <folly/Format.h>
+#include <folly/Singleton.h>
+#include <folly/SocketAddress.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+
+#include "mcrouter/lib/AuxiliaryIOThreadPool.h"
+#include "mcrouter/lib/fbi/cpp/LogFailure.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+folly::Singleton<HostResolver> gHostResolver;
+} // namespace
+
+/* static */ std::shared_ptr<HostResolver> HostResolver::getInstance() {
+  return gHostResolver.try_get();
+}
+
+/* static */ folly::Expected<HostResolver::Addresses, std::string>
+HostResolver::resolve(folly::StringPiece host) {
+  // Same hints as folly::SocketAddress uses for name lookups, so the first
+  // address is the one a plain SocketAddress(host, port, true) would pick.
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_ADDRCONFIG;
+
+  const auto hostStr = host.str();
+  struct addrinfo* results = nullptr;
+  if (int rc = getaddrinfo(hostStr.c_str(), nullptr, &hints, &results)) {
+    return folly::makeUnexpected(folly::sformat(
+        "Failed to resolve address for '{}': {}", host, gai_strerror(rc)));
+  }
+
+  Addresses addresses;
+  for (auto* ai = results; ai != nullptr; ai = ai->ai_next) {
+    if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6) {
+      continue;
+    }
+    folly::SocketAddress address;
+    address.setFromSockaddr(ai->ai_addr, ai->ai_addrlen);
+    auto ip = address.getIPAddress();
+    if (std::find(addresses.begin(), addresses.end(), ip) == addresses.end()) {
+      addresses.push_back(std::move(ip));
+    }
+  }
+  freeaddrinfo(results);
+
+  if (addresses.empty()) {
+    return folly::makeUnexpected(
+        folly::sformat("No IP address found for '{}'", host));
+  }
+  return addresses;
+}
+
+void HostResolver::prefetch(folly::StringPiece host) {
+  if (ttlMs_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  {
+    auto entries = entries_.wlock();
+    if (entries->find(host) != entries->end()) {
+      return;
+    }
+    (*entries)[host.str()];
+  }
+  refreshAsync(host.str());
+}
+
+folly::Expected<HostResolver::Addresses, std::string> HostResolver::lookup(
+    folly::StringPiece host) {
+  const std::chrono::milliseconds ttl(ttlMs_.load(std::memory_order_relaxed));
+  if (ttl.count() == 0) {
+    return resolve(host);
+  }
+
+  Addresses stale;
+  {
+    auto entries = entries_.rlock();
+    auto it = entries->find(host);
+    if (it != entries->end() && !it->second.addresses.empty()) {
+      const auto& entry = it->second;
+      if (entry.refreshing ||
+          std::chrono::steady_clock::now() - entry.resolvedAt < ttl) {
+        return entry.addresses;
+      }
+      stale = entry.addresses;
+    }
+  }
+  if (!stale.empty()) {
+    refreshAsync(host.str());
+    return stale;
+  }
+
+  // Never resolved: either not seen at config load or the resolution
+  // started there is still in flight or failed.
+  auto resolved = resolve(host);
+  if (resolved.hasValue()) {
+    store(host.str(), resolved.value());
+  }
+  return resolved;
+}
+
+void HostResolver::refreshAsync(std::string host) {
+  {
+    auto entries = entries_.wlock();
+    auto& entry = (*entries)[host];
+    if (entry.refreshing) {
+      return;
+    }
+    entry.refreshing = true;
+  }
+  auto auxPool = mcrouter::AuxiliaryIOThreadPoolSingleton::try_get_fast();
+  if (!auxPool) {
+    refresh(host);
+    return;
+  }
+  auxPool->getThreadPool().add([host = std::move(host)]() {
+    if (auto resolver = HostResolver::getInstance()) {
+      resolver->refresh(host);
+    }
+  });
+}
+
+void HostResolver::refresh(const std::string& host) {
+  auto resolved = resolve(host);
+  if (resolved.hasValue()) {
+    store(host, std::move(resolved).value());
+    return;
+  }
+
+  LOG_FAILURE(
+      "HostResolver",
+      failure::Category::kBadEnvironment,
+      "{}. Keeping the previous addresses.",
+      resolved.error());
+  auto entries = entries_.wlock();
+  auto& entry = (*entries)[host];
+  // Try again after another TTL, the old addresses are still better than
+  // none.
+  entry.resolvedAt = std::chrono::steady_clock::now();
+  entry.refreshing = false;
+}
+
+void HostResolver::store(const std::string& host, Addresses addresses) {
+  auto entries = entries_.wlock();
+  auto& entry = (*entries)[host];
+  entry.addresses = std::move(addresses);
+  entry.resolvedAt = std::chrono::steady_clock::now();
+  entry.refreshing = false;
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Expected.h>
+#include <folly/IPAddress.h>
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Process wide cache of the addresses of destinations configured by
+ * hostname rather than by IP address, so that connecting to them doesn't
+ * block the proxy thread on DNS.
+ *
+ * Hostnames are resolved on the auxiliary IO thread pool: first when they
+ * show up in a config (see AccessPoint::create), then again in the
+ * background once their entry is older than the TTL. Until a refresh
+ * completes, or if it fails, the previous addresses keep being used.
+ */
+class HostResolver {
+ public:
+  using Addresses = std::vector<folly::IPAddress>;
+
+  /**
+   * Starts resolving `host` in the background, unless it's already cached.
+   */
+  void prefetch(folly::StringPiece host);
+
+  /**
+   * @return  The addresses of `host`, in the order given by the resolver.
+   *          A stale entry is returned as is and refreshed in the
+   *          background. A host that was never resolved (or any host when
+   *          the cache is disabled) is resolved on the calling thread.
+   */
+  folly::Expected<Addresses, std::string> lookup(folly::StringPiece host);
+
+  /**
+   * How long resolved addresses are used before being refreshed.
+   * 0 disables the cache.
+   */
+  void setTtl(std::chrono::milliseconds ttl) {
+    ttlMs_.store(ttl.count(), std::memory_order_relaxed);
+  }
+
+  /**
+   * Resolves `host` with getaddrinfo() on the calling thread.
+   */
+  static folly::Expected<Addresses, std::string> resolve(
+      folly::StringPiece host);
+
+  /**
+   * Returns the singleton instance of HostResolver, or nullptr during
+   * shutdown.
+   */
+  static std::shared_ptr<HostResolver> getInstance();
+
+ private:
+  struct Entry {
+    Addresses addresses;
+    std::chrono::steady_clock::time_point resolvedAt;
+    bool refreshing{false};
+  };
+
+  folly::Synchronized<folly::F14FastMap<std::string, Entry>, folly::SharedMutex>
+      entries_;
+  std::atomic<int64_t> ttlMs_{60000};
+
+  void refreshAsync(std::string host);
+  void refresh(const std::string& host);
+  void store(const std::string& host, Addresses addresses);
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "mcrouter/lib/network/IoUring.h"
+
+#include <map>
+
+#include <folly/Synchronized.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/Liburing.h>
+
+#if FOLLY_HAS_LIBURING
+#include <folly/experimental/io/AsyncIoUringSocket.h>
+#include <folly/experimental/io/IoUringBackend.h>
+#endif
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+#if FOLLY_HAS_LIBURING
+// Large enough for a read and a write per destination of a busy proxy.
+constexpr size_t kIoUringCapacity = 16 * 1024;
+constexpr size_t kIoUringMaxSubmit = 256;
+
+std::unique_ptr<folly::EventBaseBackendBase> makeIoUringBackend(
+    std::chrono::milliseconds sqPollIdle) {
+  folly::IoUringBackend::Options options;
+  options.setCapacity(kIoUringCapacity)
+      .setMaxSubmit(kIoUringMaxSubmit)
+      .setRegisterRingFd(true);
+  if (sqPollIdle.count() > 0) {
+    options.setFlags(folly::IoUringBackend::Options::Flags::POLL_SQ)
+        .setSQIdle(sqPollIdle);
+  }
+  return std::make_unique<folly::IoUringBackend>(std::move(options));
+}
+#endif
+} // namespace
+
+bool isIoUringAvailable() noexcept {
+#if FOLLY_HAS_LIBURING
+  static const bool available = folly::IoUringBackend::isAvailable();
+  return available;
+#else
+  return false;
+#endif
+}
+
+folly::EventBaseManager& getIoUringEventBaseManager(
+    std::chrono::milliseconds sqPollIdle) {
+#if FOLLY_HAS_LIBURING
+  // One manager per idle time: every router of the process shares them.
+  static folly::Synchronized<
+      std::map<std::chrono::milliseconds, folly::EventBaseManager*>>
+      managers;
+  auto locked = managers.wlock();
+  auto& manager = (*locked)[sqPollIdle];
+  if (manager == nullptr) {
+    manager = new folly::EventBaseManager(
+        folly::EventBase::Options().setBackendFactory(
+            [sqPollIdle]() { return makeIoUringBackend(sqPollIdle); }));
+  }
+  return *manager;
+#else
+  (void)sqPollIdle;
+  LOG(FATAL) << "mcrouter was built without io_uring support";
+  return *folly::EventBaseManager::get();
+#endif
+}
+
+bool supportsIoUringSocket(folly::EventBase& evb) noexcept {
+#if FOLLY_HAS_LIBURING
+  return folly::AsyncIoUringSocket::supports(&evb);
+#else
+  (void)evb;
+  return false;
+#endif
+}
+
+folly::AsyncTransportWrapper::UniquePtr moveToIoUring(
+    folly::AsyncTransportWrapper::UniquePtr& sock) {
+#if FOLLY_HAS_LIBURING
+  if (!sock || !sock->getUnderlyingTransport<folly::AsyncSocket>() ||
+      !supportsIoUringSocket(*sock->getEventBase())) {
+    return nullptr;
+  }
+  return folly::AsyncTransportWrapper::UniquePtr(
+      new folly::AsyncIoUringSocket(std::move(sock)));
+#else
+  (void)sock;
+  return nullptr;
+#endif
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include <folly/io/async/AsyncTransport.h>
+
+namespace folly {
+class EventBase;
+class EventBaseManager;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * @return true iff this binary was built with liburing and the running kernel
+ *         supports io_uring.
+ */
+bool isIoUringAvailable() noexcept;
+
+/**
+ * EventBaseManager whose event bases run on the io_uring backend. All
+ * submissions issued within one loop iteration of such an event base are
+ * handed to the kernel in a single io_uring_enter() call.
+ *
+ * If `sqPollIdle` is non-zero, the rings are polled by a kernel thread
+ * (SQPOLL) instead: submissions don't need a syscall while the thread is
+ * awake, and it only sleeps after being idle for `sqPollIdle`.
+ *
+ * Must only be called if isIoUringAvailable() is true.
+ */
+folly::EventBaseManager& getIoUringEventBaseManager(
+    std::chrono::milliseconds sqPollIdle = std::chrono::milliseconds(0));
+
+/**
+ * @return true iff sockets on this event base can be moved to io_uring, i.e.
+ *         the event base runs on the io_uring backend.
+ */
+bool supportsIoUringSocket(folly::EventBase& evb) noexcept;
+
+/**
+ * Moves a connected plaintext AsyncSocket over to an io_uring backed
+ * transport.
+ *
+ * @return  the new transport (taking ownership of `sock`), or nullptr if the
+ *          socket can't be moved, in which case `sock` is left untouched.
+ */
+folly::AsyncTransportWrapper::UniquePtr moveToIoUring(
+    folly::AsyncTransportWrapper::UniquePtr& sock);
+
+} // namespace memcache
+} // namespace facebook
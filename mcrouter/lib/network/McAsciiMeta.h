@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <folly/Range.h>
+
+#include "mcrouter/lib/carbon/Result.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Flags of a memcached meta protocol command (mg, ms, md, mn) that affect
+ * how its reply is written. Everything that maps onto the carbon request
+ * (key, value, ttl, client flags, cas, mode) is parsed straight into it.
+ */
+struct McAsciiMetaFlags {
+  // Return flags, echoed back in the reply when set.
+  static constexpr uint16_t kValue = 1 << 0; // v
+  static constexpr uint16_t kClientFlags = 1 << 1; // f
+  static constexpr uint16_t kCas = 1 << 2; // c
+  static constexpr uint16_t kKey = 1 << 3; // k
+  static constexpr uint16_t kSize = 1 << 4; // s
+  static constexpr uint16_t kOpaque = 1 << 5; // O
+
+  // Longest opaque token memcached accepts.
+  static constexpr size_t kMaxOpaqueLength = 32;
+
+  uint16_t returnFlags{0};
+  // q: suppress the "nothing to report" reply (EN for mg, HD for ms/md).
+  bool quiet{false};
+  // mn: the reply is "MN", which ends a batch of quiet commands.
+  bool noop{false};
+  uint8_t opaqueLength{0};
+  char opaque[kMaxOpaqueLength];
+
+  bool has(uint16_t flag) const {
+    return (returnFlags & flag) != 0;
+  }
+
+  folly::StringPiece opaqueToken() const {
+    return folly::StringPiece(opaque, opaqueLength);
+  }
+
+  void reset() {
+    returnFlags = 0;
+    quiet = false;
+    noop = false;
+    opaqueLength = 0;
+  }
+};
+
+/**
+ * Requests that are sent to ascii destinations as meta commands when
+ * ConnectionOptions::asciiMetaProtocol is set. Everything else is sent as a
+ * classic command on the same connection.
+ */
+template <class Request>
+struct McAsciiMetaSupported
+    : std::integral_constant<
+          bool,
+          std::is_same<Request, McGetRequest>::value ||
+              std::is_same<Request, McGetsRequest>::value ||
+              std::is_same<Request, McGatRequest>::value ||
+              std::is_same<Request, McGatsRequest>::value ||
+              std::is_same<Request, McSetRequest>::value ||
+              std::is_same<Request, McAddRequest>::value ||
+              std::is_same<Request, McReplaceRequest>::value ||
+              std::is_same<Request, McAppendRequest>::value ||
+              std::is_same<Request, McPrependRequest>::value ||
+              std::is_same<Request, McCasRequest>::value ||
+              std::is_same<Request, McDeleteRequest>::value> {};
+
+/**
+ * Whether a reply with the given result is dropped for a quiet (q) meta
+ * command: misses for mg, successes for ms, and both for md.
+ */
+template <class Reply>
+bool mcAsciiMetaQuietDrops(const Reply& reply) {
+  switch (*reply.result_ref()) {
+    case carbon::Result::NOTFOUND:
+      return !std::is_same<Reply, McSetReply>::value &&
+          !std::is_same<Reply, McAddReply>::value &&
+          !std::is_same<Reply, McReplaceReply>::value &&
+          !std::is_same<Reply, McAppendReply>::value &&
+          !std::is_same<Reply, McPrependReply>::value &&
+          !std::is_same<Reply, McCasReply>::value;
+    case carbon::Result::OK:
+    case carbon::Result::STORED:
+    case carbon::Result::STALESTORED:
+    case carbon::Result::DELETED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace memcache
+} // namespace facebook
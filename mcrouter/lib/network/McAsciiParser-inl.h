@@ -18,7 +18,11 @@ class CallbackBase<List<Request>> {
  public:
   virtual ~CallbackBase() = default;
   virtual void multiOpEnd() noexcept = 0;
+  virtual void metaNoop() noexcept = 0;
   virtual void onRequest(Request&& req, bool noreply = false) noexcept = 0;
+  virtual void onMetaRequest(
+      Request&& req,
+      const McAsciiMetaFlags& meta) noexcept = 0;
 };
 
 template <class Request, class... Requests>
@@ -26,8 +30,12 @@ class CallbackBase<List<Request, Requests...>>
     : public CallbackBase<List<Requests...>> {
  public:
   using CallbackBase<List<Requests...>>::onRequest;
+  using CallbackBase<List<Requests...>>::onMetaRequest;
 
   virtual void onRequest(Request&& req, bool noreply = false) noexcept = 0;
+  virtual void onMetaRequest(
+      Request&& req,
+      const McAsciiMetaFlags& meta) noexcept = 0;
 };
 
 template <class Callback, class Requests>
@@ -43,14 +51,40 @@ class CallbackWrapper<Callback, List<Request>>
     callback_.multiOpEnd();
   }
 
+  void metaNoop() noexcept final {
+    callback_.metaNoop();
+  }
+
   using CallbackBase<McRequestList>::onRequest;
+  using CallbackBase<McRequestList>::onMetaRequest;
 
   void onRequest(Request&& req, bool noreply = false) noexcept final {
     callback_.onRequest(std::move(req), noreply);
   }
 
+  void onMetaRequest(Request&& req, const McAsciiMetaFlags& meta) noexcept
+      final {
+    onMetaRequestImpl(callback_, std::move(req), meta);
+  }
+
  protected:
   Callback& callback_;
+
+  /**
+   * Meta commands are only ever parsed into McAsciiMetaSupported requests,
+   * so callbacks only need to handle those.
+   */
+  template <class Req>
+  static void onMetaRequestImpl(
+      Callback& callback,
+      Req&& req,
+      const McAsciiMetaFlags& meta) {
+    if constexpr (McAsciiMetaSupported<Req>::value) {
+      callback.onMetaRequest(std::move(req), meta);
+    } else {
+      callback.onRequest(std::move(req), false /* noreply */);
+    }
+  }
 };
 
 template <class Callback, class Request, class... Requests>
@@ -61,10 +95,16 @@ class CallbackWrapper<Callback, List<Request, Requests...>>
       : CallbackWrapper<Callback, List<Requests...>>(callback) {}
 
   using CallbackWrapper<Callback, List<Requests...>>::onRequest;
+  using CallbackWrapper<Callback, List<Requests...>>::onMetaRequest;
 
   void onRequest(Request&& req, bool noreply = false) noexcept final {
     this->callback_.onRequest(std::move(req), noreply);
   }
+
+  void onMetaRequest(Request&& req, const McAsciiMetaFlags& meta) noexcept
+      final {
+    this->onMetaRequestImpl(this->callback_, std::move(req), meta);
+  }
 };
 
 } // namespace detail
@@ -17,6 +17,7 @@
 #include "mcrouter/lib/carbon/Variant.h"
 #include "mcrouter/lib/fbi/cpp/TypeList.h"
 #include "mcrouter/lib/network/CarbonMessageList.h"
+#include "mcrouter/lib/network/McAsciiMeta.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 
 namespace facebook {
@@ -119,6 +120,14 @@ class McClientAsciiParser : public McAsciiParserBase {
   template <class Request>
   void initializeReplyParser();
 
+  /**
+   * Parse replies to meta commands (mg, ms, md) for the requests that
+   * AsciiSerializedRequest sends as meta commands, see McAsciiMetaSupported.
+   */
+  void setMetaProtocol(bool metaProtocol) {
+    metaProtocol_ = metaProtocol;
+  }
+
   /**
    * Obtain the message that was parsed.
    *
@@ -144,6 +153,21 @@ class McClientAsciiParser : public McAsciiParserBase {
   template <class Reply>
   void consumeStorageReplyCommon(folly::IOBuf& buffer);
 
+  template <class Reply>
+  void initializeMetaGetReplyCommon();
+  template <class Reply>
+  void initializeMetaGetsReplyCommon();
+  template <class Reply>
+  void initializeMetaStorageReplyCommon();
+
+  template <class Reply>
+  void consumeMetaGetReplyCommon(folly::IOBuf& buffer);
+  template <class Reply>
+  void consumeMetaGetsReplyCommon(folly::IOBuf& buffer);
+  template <class Reply>
+  void consumeMetaStorageReplyCommon(folly::IOBuf& buffer);
+  void consumeMetaDeleteReply(folly::IOBuf& buffer);
+
   template <class Request>
   void consumeMessage(folly::IOBuf& buffer);
 
@@ -175,6 +199,8 @@ class McClientAsciiParser : public McAsciiParserBase {
 
   using ConsumerFunPtr = void (McClientAsciiParser::*)(folly::IOBuf&);
   ConsumerFunPtr consumer_{nullptr};
+
+  bool metaProtocol_{false};
 };
 
 namespace detail {
@@ -205,6 +231,15 @@ class McServerAsciiParser : public McAsciiParserBase {
   void initGetLike();
   template <class Request>
   void consumeGetLike(folly::IOBuf& buffer);
+  /**
+   * Parses a complete get-like key list without going through the state
+   * machine, slicing keys with a vectorized delimiter scan.
+   *
+   * @return  false if the line is not complete in the buffer or is not a
+   *          plain space separated key list; nothing is consumed then.
+   */
+  template <class Request>
+  bool consumeGetLikeFast(folly::IOBuf& buffer);
   template <class Request>
   void initGatLike();
   template <class Request>
@@ -236,6 +271,18 @@ class McServerAsciiParser : public McAsciiParserBase {
   void consumeFlushRe(folly::IOBuf& buffer);
   void consumeFlushAll(folly::IOBuf& buffer);
 
+  // Meta commands.
+  void consumeMetaGet(folly::IOBuf& buffer);
+  void consumeMetaSet(folly::IOBuf& buffer);
+  void consumeMetaDelete(folly::IOBuf& buffer);
+  void finishMetaGet();
+  void finishMetaSet();
+  void finishMetaDelete();
+  template <class Request>
+  void metaSetReady(Request&& req);
+  template <class Request>
+  void metaRequestReady(Request&& req);
+
   void finishReq();
 
   std::unique_ptr<detail::CallbackBase<McRequestList>> callback_;
@@ -244,6 +291,30 @@ class McServerAsciiParser : public McAsciiParserBase {
   folly::IOBuf currentKey_;
   bool noreply_{false};
 
+  // Fields of the meta command being parsed.
+  struct MetaCommand {
+    McAsciiMetaFlags flags;
+    folly::IOBuf value;
+    uint64_t clientFlags{0};
+    uint64_t cas{0};
+    int32_t exptime{0};
+    bool hasExptime{false};
+    bool hasCas{false};
+    char mode{'S'};
+
+    void reset() {
+      flags.reset();
+      value = folly::IOBuf();
+      clientFlags = 0;
+      cas = 0;
+      exptime = 0;
+      hasExptime = false;
+      hasCas = false;
+      mode = 'S';
+    }
+  };
+  MetaCommand meta_;
+
   using RequestVariant = carbon::makeVariantFromList<McRequestList>;
   RequestVariant currentMessage_;
 
@@ -8,6 +8,8 @@
 #include "mcrouter/lib/network/McAsciiParser.h"
 
 #include "mcrouter/lib/mc/msg.h"
+#include "mcrouter/lib/network/McAsciiMeta.h"
+#include "mcrouter/lib/network/McAsciiScan.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/lib/network/gen/MemcacheRoutingGroups.h"
 
@@ -495,8 +497,118 @@ void McClientAsciiParser::consumeMessage<McFlushAllRequest>(
   }%%
 }
 
+// Meta protocol replies (mg, ms, md), see McAsciiMeta.h.
+
+// Meta get reply, for get and gat.
+%%{
+machine mc_ascii_meta_get_reply;
+include mc_ascii_common;
+
+meta_ret_flag = ('f' flags) | ((graph - 'f') graph*);
+meta_hit = 'VA' ' '+ value_bytes (' '+ meta_ret_flag)* ' '* new_line
+           @reply_value_data new_line;
+meta_miss = 'EN' @{ message.result_ref() = carbon::Result::NOTFOUND; } ' '*;
+
+meta_get = meta_hit >{ message.result_ref() = carbon::Result::FOUND; } |
+           meta_miss;
+meta_get_reply := (meta_get | error) msg_end;
+
+write data;
+}%%
+
+template <class Reply>
+void McClientAsciiParser::consumeMetaGetReplyCommon(folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<Reply>();
+  %%{
+    machine mc_ascii_meta_get_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+// Meta gets reply, for gets and gats.
+%%{
+machine mc_ascii_meta_gets_reply;
+include mc_ascii_common;
+
+meta_ret_flag = ('f' flags) | ('c' cas_id) | ((graph - [fc]) graph*);
+meta_hit = 'VA' ' '+ value_bytes (' '+ meta_ret_flag)* ' '* new_line
+           @reply_value_data new_line;
+meta_miss = 'EN' @{ message.result_ref() = carbon::Result::NOTFOUND; } ' '*;
+
+meta_gets = meta_hit >{ message.result_ref() = carbon::Result::FOUND; } |
+            meta_miss;
+meta_gets_reply := (meta_gets | error) msg_end;
+
+write data;
+}%%
+
+template <class Reply>
+void McClientAsciiParser::consumeMetaGetsReplyCommon(folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<Reply>();
+  %%{
+    machine mc_ascii_meta_gets_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+// Meta storage reply.
+%%{
+machine mc_ascii_meta_storage_reply;
+include mc_ascii_common;
+
+meta_stored = 'HD' @{ message.result_ref() = carbon::Result::STORED; };
+meta_not_stored = 'NS' @{ message.result_ref() = carbon::Result::NOTSTORED; };
+meta_exists = 'EX' @{ message.result_ref() = carbon::Result::EXISTS; };
+meta_not_found = 'NF' @{ message.result_ref() = carbon::Result::NOTFOUND; };
+
+meta_storage = (meta_stored | meta_not_stored | meta_exists | meta_not_found)
+               (' '+ graph+)* ' '*;
+meta_storage_reply := (meta_storage | error) msg_end;
+
+write data;
+}%%
+
+template <class Reply>
+void McClientAsciiParser::consumeMetaStorageReplyCommon(folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<Reply>();
+  %%{
+    machine mc_ascii_meta_storage_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+// Meta delete reply.
+%%{
+machine mc_ascii_meta_delete_reply;
+include mc_ascii_common;
+
+meta_deleted = 'HD' @{ message.result_ref() = carbon::Result::DELETED; };
+meta_not_found = 'NF' @{ message.result_ref() = carbon::Result::NOTFOUND; };
+
+meta_delete = (meta_deleted | meta_not_found) (' '+ graph+)* ' '*;
+meta_delete_reply := (meta_delete | error) msg_end;
+
+write data;
+}%%
+
+void McClientAsciiParser::consumeMetaDeleteReply(folly::IOBuf& buffer) {
+  auto& message = currentMessage_.get<McDeleteReply>();
+  %%{
+    machine mc_ascii_meta_delete_reply;
+    write init nocs;
+    write exec;
+  }%%
+}
+
 template <>
 void McClientAsciiParser::initializeReplyParser<McGetRequest>() {
+  if (metaProtocol_) {
+    initializeMetaGetReplyCommon<McGetReply>();
+    return;
+  }
   initializeCommon<McGetReply>();
   savedCs_ = mc_ascii_get_reply_en_get_reply;
   errorCs_ = mc_ascii_get_reply_error;
@@ -505,6 +617,10 @@ void McClientAsciiParser::initializeReplyParser<McGetRequest>() {
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McGetsRequest>() {
+  if (metaProtocol_) {
+    initializeMetaGetsReplyCommon<McGetsReply>();
+    return;
+  }
   initializeCommon<McGetsReply>();
   savedCs_ = mc_ascii_gets_reply_en_gets_reply;
   errorCs_ = mc_ascii_gets_reply_error;
@@ -513,6 +629,10 @@ void McClientAsciiParser::initializeReplyParser<McGetsRequest>() {
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McGatRequest>() {
+  if (metaProtocol_) {
+    initializeMetaGetReplyCommon<McGatReply>();
+    return;
+  }
   initializeCommon<McGatReply>();
   savedCs_ = mc_ascii_gat_reply_en_gat_reply;
   errorCs_ = mc_ascii_gat_reply_error;
@@ -521,6 +641,10 @@ void McClientAsciiParser::initializeReplyParser<McGatRequest>() {
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McGatsRequest>() {
+  if (metaProtocol_) {
+    initializeMetaGetsReplyCommon<McGatsReply>();
+    return;
+  }
   initializeCommon<McGatsReply>();
   savedCs_ = mc_ascii_gats_reply_en_gats_reply;
   errorCs_ = mc_ascii_gats_reply_error;
@@ -537,16 +661,28 @@ void McClientAsciiParser::initializeReplyParser<McLeaseGetRequest>() {
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McSetRequest>() {
+  if (metaProtocol_) {
+    initializeMetaStorageReplyCommon<McSetReply>();
+    return;
+  }
   initializeStorageReplyCommon<McSetReply>();
 }
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McAddRequest>() {
+  if (metaProtocol_) {
+    initializeMetaStorageReplyCommon<McAddReply>();
+    return;
+  }
   initializeStorageReplyCommon<McAddReply>();
 }
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McReplaceRequest>() {
+  if (metaProtocol_) {
+    initializeMetaStorageReplyCommon<McReplaceReply>();
+    return;
+  }
   initializeStorageReplyCommon<McReplaceReply>();
 }
 
@@ -557,16 +693,28 @@ void McClientAsciiParser::initializeReplyParser<McLeaseSetRequest>() {
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McCasRequest>() {
+  if (metaProtocol_) {
+    initializeMetaStorageReplyCommon<McCasReply>();
+    return;
+  }
   initializeStorageReplyCommon<McCasReply>();
 }
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McAppendRequest>() {
+  if (metaProtocol_) {
+    initializeMetaStorageReplyCommon<McAppendReply>();
+    return;
+  }
   initializeStorageReplyCommon<McAppendReply>();
 }
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McPrependRequest>() {
+  if (metaProtocol_) {
+    initializeMetaStorageReplyCommon<McPrependReply>();
+    return;
+  }
   initializeStorageReplyCommon<McPrependReply>();
 }
 
@@ -590,6 +738,13 @@ void McClientAsciiParser::initializeReplyParser<McVersionRequest>() {
 
 template <>
 void McClientAsciiParser::initializeReplyParser<McDeleteRequest>() {
+  if (metaProtocol_) {
+    initializeCommon<McDeleteReply>();
+    savedCs_ = mc_ascii_meta_delete_reply_en_meta_delete_reply;
+    errorCs_ = mc_ascii_meta_delete_reply_error;
+    consumer_ = &McClientAsciiParser::consumeMetaDeleteReply;
+    return;
+  }
   initializeCommon<McDeleteReply>();
   savedCs_ = mc_ascii_delete_reply_en_delete_reply;
   errorCs_ = mc_ascii_delete_reply_error;
@@ -637,6 +792,30 @@ void McClientAsciiParser::initializeStorageReplyCommon() {
   consumer_ = &McClientAsciiParser::consumeStorageReplyCommon<Reply>;
 }
 
+template <class Reply>
+void McClientAsciiParser::initializeMetaGetReplyCommon() {
+  initializeCommon<Reply>();
+  savedCs_ = mc_ascii_meta_get_reply_en_meta_get_reply;
+  errorCs_ = mc_ascii_meta_get_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaGetReplyCommon<Reply>;
+}
+
+template <class Reply>
+void McClientAsciiParser::initializeMetaGetsReplyCommon() {
+  initializeCommon<Reply>();
+  savedCs_ = mc_ascii_meta_gets_reply_en_meta_gets_reply;
+  errorCs_ = mc_ascii_meta_gets_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaGetsReplyCommon<Reply>;
+}
+
+template <class Reply>
+void McClientAsciiParser::initializeMetaStorageReplyCommon() {
+  initializeCommon<Reply>();
+  savedCs_ = mc_ascii_meta_storage_reply_en_meta_storage_reply;
+  errorCs_ = mc_ascii_meta_storage_reply_error;
+  consumer_ = &McClientAsciiParser::consumeMetaStorageReplyCommon<Reply>;
+}
+
 template <class Reply>
 void McClientAsciiParser::initializeCommon() {
   assert(state_ == State::UNINIT);
@@ -666,8 +845,63 @@ req_body := ' '* key % on_full_key (' '+ key % on_full_key)* ' '* multi_op_end;
 write data;
 }%%
 
+template <class Request>
+bool McServerAsciiParser::consumeGetLikeFast(folly::IOBuf& buffer) {
+  // Validate the whole line first: keys may only be separated by spaces and
+  // the line must be terminated within this buffer. Anything else is left to
+  // the state machine, which also takes care of error reporting.
+  const char* lineEnd = nullptr;
+  bool haveKey = false;
+  for (auto p = p_; p != pe_;) {
+    auto delim = findAsciiKeyDelimiter(p, pe_);
+    haveKey |= delim != p;
+    if (delim == pe_) {
+      return false;
+    }
+    if (*delim == '\n') {
+      lineEnd = delim;
+      break;
+    }
+    if (*delim == '\r') {
+      if (delim + 1 == pe_ || *(delim + 1) != '\n') {
+        return false;
+      }
+      lineEnd = delim + 1;
+      break;
+    }
+    if (*delim != ' ') {
+      return false;
+    }
+    p = delim + 1;
+  }
+  if (lineEnd == nullptr || !haveKey) {
+    return false;
+  }
+
+  auto& message = currentMessage_.get<Request>();
+  for (auto p = p_; p < lineEnd;) {
+    auto delim = findAsciiKeyDelimiter(p, lineEnd + 1);
+    if (delim != p) {
+      currentKey_.clear();
+      appendKeyPiece(buffer, currentKey_, p, delim);
+      message.key_ref() = std::move(currentKey_);
+      callback_->onRequest(std::move(message));
+    }
+    p = delim + 1;
+  }
+  callback_->multiOpEnd();
+  finishReq();
+  p_ = lineEnd + 1;
+  return true;
+}
+
 template <class Request>
 void McServerAsciiParser::consumeGetLike(folly::IOBuf& buffer) {
+  if (savedCs_ == mc_ascii_get_like_req_body_en_req_body &&
+      consumeGetLikeFast<Request>(buffer)) {
+    return;
+  }
+
   auto& message = currentMessage_.get<Request>();
   %%{
     machine mc_ascii_get_like_req_body;
@@ -1016,6 +1250,192 @@ void McServerAsciiParser::consumeFlushAll(folly::IOBuf&) {
   }%%
 }
 
+// Meta commands (mg, ms, md), see McAsciiMeta.h.
+
+%%{
+machine mc_ascii_meta_req_common;
+include mc_ascii_common;
+
+# The key is kept in currentKey_ until we know which request to build.
+meta_key = (any+ -- (cntrl | space)) >key_start %key_end;
+
+meta_return_flag =
+  'v' @{ meta_.flags.returnFlags |= McAsciiMetaFlags::kValue; } |
+  'f' @{ meta_.flags.returnFlags |= McAsciiMetaFlags::kClientFlags; } |
+  'c' @{ meta_.flags.returnFlags |= McAsciiMetaFlags::kCas; } |
+  'k' @{ meta_.flags.returnFlags |= McAsciiMetaFlags::kKey; } |
+  's' @{ meta_.flags.returnFlags |= McAsciiMetaFlags::kSize; } |
+  'q' @{ meta_.flags.quiet = true; };
+
+meta_ttl = 'T' negative? uint %{
+  auto value = static_cast<int32_t>(currentUInt_);
+  meta_.exptime = negative_ ? -value : value;
+  meta_.hasExptime = true;
+  negative_ = false;
+};
+
+meta_client_flags = 'F' uint %{
+  meta_.clientFlags = currentUInt_;
+};
+
+meta_cas = 'C' uint %{
+  meta_.cas = currentUInt_;
+  meta_.hasCas = true;
+};
+
+meta_mode = 'M' [EeAaPpRrSs] @{
+  meta_.mode = fc;
+};
+
+meta_opaque = 'O' @{
+  meta_.flags.returnFlags |= McAsciiMetaFlags::kOpaque;
+  meta_.flags.opaqueLength = 0;
+} graph{1,32} ${
+  meta_.flags.opaque[meta_.flags.opaqueLength++] = fc;
+};
+
+# Flags we accept but don't act on (N, R, I, h, l, t, ...).
+meta_ignored_flag = (graph - [vfcksqTFCMO]) graph*;
+
+meta_flag = meta_return_flag | meta_ttl | meta_client_flags | meta_cas |
+            meta_mode | meta_opaque | meta_ignored_flag;
+meta_flags = (' '+ meta_flag)* ' '*;
+
+action meta_value_data {
+  if (!readValue(buffer, meta_.value)) {
+    fbreak;
+  }
+}
+}%%
+
+%%{
+machine mc_ascii_meta_get_req_body;
+include mc_ascii_meta_req_common;
+
+req_body := ' '* meta_key meta_flags new_line @{
+              finishMetaGet();
+              fbreak;
+            };
+
+write data;
+}%%
+
+void McServerAsciiParser::consumeMetaGet(folly::IOBuf& buffer) {
+  %%{
+    machine mc_ascii_meta_get_req_body;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+%%{
+machine mc_ascii_meta_set_req_body;
+include mc_ascii_meta_req_common;
+
+req_body := ' '* meta_key ' '+ value_bytes meta_flags new_line
+            @meta_value_data new_line @{
+              finishMetaSet();
+              fbreak;
+            };
+
+write data;
+}%%
+
+void McServerAsciiParser::consumeMetaSet(folly::IOBuf& buffer) {
+  %%{
+    machine mc_ascii_meta_set_req_body;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+%%{
+machine mc_ascii_meta_delete_req_body;
+include mc_ascii_meta_req_common;
+
+req_body := ' '* meta_key meta_flags new_line @{
+              finishMetaDelete();
+              fbreak;
+            };
+
+write data;
+}%%
+
+void McServerAsciiParser::consumeMetaDelete(folly::IOBuf& buffer) {
+  %%{
+    machine mc_ascii_meta_delete_req_body;
+    write init nocs;
+    write exec;
+  }%%
+}
+
+template <class Request>
+void McServerAsciiParser::metaRequestReady(Request&& req) {
+  req.key_ref() = std::move(currentKey_);
+  callback_->onMetaRequest(std::move(req), meta_.flags);
+  finishReq();
+}
+
+template <class Request>
+void McServerAsciiParser::metaSetReady(Request&& req) {
+  req.value_ref() = std::move(meta_.value);
+  req.flags_ref() = meta_.clientFlags;
+  req.exptime_ref() = meta_.exptime;
+  metaRequestReady(std::move(req));
+}
+
+void McServerAsciiParser::finishMetaGet() {
+  const bool withCas = meta_.flags.has(McAsciiMetaFlags::kCas);
+  if (meta_.hasExptime) {
+    if (withCas) {
+      McGatsRequest req;
+      req.exptime_ref() = meta_.exptime;
+      metaRequestReady(std::move(req));
+    } else {
+      McGatRequest req;
+      req.exptime_ref() = meta_.exptime;
+      metaRequestReady(std::move(req));
+    }
+  } else if (withCas) {
+    metaRequestReady(McGetsRequest());
+  } else {
+    metaRequestReady(McGetRequest());
+  }
+}
+
+void McServerAsciiParser::finishMetaSet() {
+  switch (meta_.mode) {
+    case 'E':
+    case 'e':
+      metaSetReady(McAddRequest());
+      break;
+    case 'A':
+    case 'a':
+      metaSetReady(McAppendRequest());
+      break;
+    case 'P':
+    case 'p':
+      metaSetReady(McPrependRequest());
+      break;
+    case 'R':
+    case 'r':
+      metaSetReady(McReplaceRequest());
+      break;
+    default:
+      if (meta_.hasCas) {
+        McCasRequest req;
+        req.casToken_ref() = meta_.cas;
+        metaSetReady(std::move(req));
+      } else {
+        metaSetReady(McSetRequest());
+      }
+  }
+}
+
+void McServerAsciiParser::finishMetaDelete() {
+  metaRequestReady(McDeleteRequest());
+}
+
 // Operation keyword parser.
 
 %%{
@@ -1178,6 +1598,36 @@ flush_re = 'flush_regex ' @{
   fbreak;
 };
 
+mg = 'mg ' @{
+  savedCs_ = mc_ascii_meta_get_req_body_en_req_body;
+  errorCs_ = mc_ascii_meta_get_req_body_error;
+  state_ = State::PARTIAL;
+  consumer_ = &McServerAsciiParser::consumeMetaGet;
+  fbreak;
+};
+
+ms = 'ms ' @{
+  savedCs_ = mc_ascii_meta_set_req_body_en_req_body;
+  errorCs_ = mc_ascii_meta_set_req_body_error;
+  state_ = State::PARTIAL;
+  consumer_ = &McServerAsciiParser::consumeMetaSet;
+  fbreak;
+};
+
+md = 'md ' @{
+  savedCs_ = mc_ascii_meta_delete_req_body_en_req_body;
+  errorCs_ = mc_ascii_meta_delete_req_body_error;
+  state_ = State::PARTIAL;
+  consumer_ = &McServerAsciiParser::consumeMetaDelete;
+  fbreak;
+};
+
+mn = 'mn' ' '* new_line @{
+  callback_->metaNoop();
+  finishReq();
+  fbreak;
+};
+
 flush_all = 'flush_all' @{
   savedCs_ = mc_ascii_flush_all_req_body_en_req_body;
   errorCs_ = mc_ascii_flush_all_req_body_error;
@@ -1189,7 +1639,8 @@ flush_all = 'flush_all' @{
 
 command := get | gets | lease_get | metaget | set | add | replace | append |
            prepend | cas | lease_set | delete | shutdown | incr | decr |
-           version | quit | stats | exec | flush_re | flush_all | touch | gat | gats;
+           version | quit | stats | exec | flush_re | flush_all | touch | gat | gats |
+           mg | ms | md | mn;
 
 write data;
 }%%
@@ -1226,6 +1677,7 @@ McAsciiParserBase::State McServerAsciiParser::consume(folly::IOBuf& buffer) {
       currentKey_.clear();
       noreply_ = false;
       negative_ = false;
+      meta_.reset();
 
       state_ = State::PARTIAL;
 
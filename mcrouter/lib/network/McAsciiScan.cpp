@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "McAsciiScan.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+inline bool isKeyDelimiter(char c) {
+  // Matches ragel's (cntrl | space) for a signed char alphabet.
+  auto uc = static_cast<unsigned char>(c);
+  return uc <= ' ' || uc == 0x7f;
+}
+
+#if defined(__AVX2__)
+
+inline uint32_t delimiterMask(const char* p) {
+  auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  // Bytes >= 0x80 are negative as signed chars and are valid key characters.
+  auto nonNegative = _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(-1));
+  auto lowOrSpace = _mm256_cmpgt_epi8(_mm256_set1_epi8(' ' + 1), chunk);
+  auto del = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(0x7f));
+  auto mask = _mm256_or_si256(_mm256_and_si256(nonNegative, lowOrSpace), del);
+  return static_cast<uint32_t>(_mm256_movemask_epi8(mask));
+}
+constexpr size_t kChunkSize = 32;
+
+#elif defined(__SSE2__)
+
+inline uint32_t delimiterMask(const char* p) {
+  auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  // Bytes >= 0x80 are negative as signed chars and are valid key characters.
+  auto nonNegative = _mm_cmpgt_epi8(chunk, _mm_set1_epi8(-1));
+  auto lowOrSpace = _mm_cmplt_epi8(chunk, _mm_set1_epi8(' ' + 1));
+  auto del = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(0x7f));
+  auto mask = _mm_or_si128(_mm_and_si128(nonNegative, lowOrSpace), del);
+  return static_cast<uint32_t>(_mm_movemask_epi8(mask));
+}
+constexpr size_t kChunkSize = 16;
+
+#endif
+
+} // namespace
+
+const char* findAsciiKeyDelimiterScalar(
+    const char* begin,
+    const char* end) noexcept {
+  while (begin != end && !isKeyDelimiter(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+const char* findAsciiKeyDelimiter(const char* begin, const char* end) noexcept {
+#if defined(__AVX2__) || defined(__SSE2__)
+  while (static_cast<size_t>(end - begin) >= kChunkSize) {
+    if (auto mask = delimiterMask(begin)) {
+      return begin + __builtin_ctz(mask);
+    }
+    begin += kChunkSize;
+  }
+#endif
+  return findAsciiKeyDelimiterScalar(begin, end);
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Finds the first character in range [begin, end) that can't be a part of
+ * an ascii protocol key, i.e. a space or a control character.
+ *
+ * Uses SIMD instructions when available, with a scalar fallback.
+ *
+ * @return  pointer to the found character, or end if there is none.
+ */
+const char* findAsciiKeyDelimiter(const char* begin, const char* end) noexcept;
+
+/**
+ * Scalar version of findAsciiKeyDelimiter, exposed for testing.
+ */
+const char* findAsciiKeyDelimiterScalar(
+    const char* begin,
+    const char* end) noexcept;
+
+} // namespace memcache
+} // namespace facebook
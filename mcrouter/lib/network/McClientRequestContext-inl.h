@@ -47,8 +47,18 @@ McClientRequestContextBase::McClientRequestContextBase(
     McClientRequestContextQueue& queue,
     InitializerFuncPtr initializer,
     const std::function<void(int pendingDiff, int inflightDiff)>& onStateChange,
-    const CodecIdRange& supportedCodecs)
-    : reqContext(request, reqid, protocol, supportedCodecs),
+    const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeoutBudget,
+    bool compactCaretHeader,
+    bool asciiMetaProtocol)
+    : reqContext(
+          request,
+          reqid,
+          protocol,
+          supportedCodecs,
+          timeoutBudget,
+          compactCaretHeader,
+          asciiMetaProtocol),
       id(reqid),
       queue_(queue),
       replyType_(typeid(ReplyT<Request>)),
@@ -118,7 +128,10 @@ McClientRequestContext<Request>::McClientRequestContext(
     McClientRequestContextQueue& queue,
     McClientRequestContextBase::InitializerFuncPtr func,
     const std::function<void(int pendingDiff, int inflightDiff)>& onStateChange,
-    const CodecIdRange& supportedCodecs)
+    const CodecIdRange& supportedCodecs,
+    std::chrono::milliseconds timeoutBudget,
+    bool compactCaretHeader,
+    bool asciiMetaProtocol)
     : McClientRequestContextBase(
           request,
           reqid,
@@ -127,7 +140,10 @@ McClientRequestContext<Request>::McClientRequestContext(
           queue,
           std::move(func),
           onStateChange,
-          supportedCodecs),
+          supportedCodecs,
+          timeoutBudget,
+          compactCaretHeader,
+          asciiMetaProtocol),
       requestTraceContext_(request.traceContext()) {}
 
 template <class Reply>
@@ -7,6 +7,9 @@
 
 #include "McClientRequestContext.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace facebook {
 namespace memcache {
 
@@ -63,7 +66,15 @@ void McClientRequestContextBase::fireStateChangeCallbacks(
 
 void McClientRequestContextBase::scheduleTimeout() {
   if (state() != ReqState::COMPLETE) {
-    batonTimeoutHandler_.scheduleTimeout(batonWaitTimeout_);
+    auto timeout = batonWaitTimeout_;
+    if (deadline_ != std::chrono::steady_clock::time_point()) {
+      // The time spent in the pending queue already counts.
+      const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+          deadline_ - std::chrono::steady_clock::now());
+      timeout = std::max(
+          std::chrono::milliseconds(1), std::min(timeout, left));
+    }
+    batonTimeoutHandler_.scheduleTimeout(timeout);
   }
 }
 
@@ -140,18 +151,62 @@ void McClientRequestContextQueue::markAsPending(
 }
 
 McClientRequestContextBase& McClientRequestContextQueue::peekNextPending() {
-  return pendingQueue_.front();
+  return pendingLifo_ ? pendingQueue_.back() : pendingQueue_.front();
 }
 
 McClientRequestContextBase& McClientRequestContextQueue::markNextAsSending() {
-  auto& req = pendingQueue_.front();
-  pendingQueue_.pop_front();
+  auto& req = peekNextPending();
+  pendingQueue_.erase(pendingQueue_.iterator_to(req));
   assert(req.state() == State::PENDING_QUEUE);
   req.setState(State::WRITE_QUEUE);
   writeQueue_.push_back(req);
   return req;
 }
 
+size_t McClientRequestContextQueue::failUnsendablePending(
+    size_t count,
+    std::chrono::steady_clock::time_point now) {
+  auto failIfUnsendable = [&](McClientRequestContextBase& req) {
+    if (req.isCancelled()) {
+      failPending(
+          req, carbon::Result::ABORTED, "Request cancelled before being sent");
+      return true;
+    }
+    if (req.isExpired(now)) {
+      failPending(req, carbon::Result::TIMEOUT, "Client queue timeout");
+      return true;
+    }
+    return false;
+  };
+
+  size_t numSendable = 0;
+  if (pendingLifo_) {
+    auto it = pendingQueue_.end();
+    while (numSendable < count && it != pendingQueue_.begin()) {
+      if (!failIfUnsendable(*std::prev(it))) {
+        --it;
+        ++numSendable;
+      }
+    }
+  } else {
+    auto it = pendingQueue_.begin();
+    while (numSendable < count && it != pendingQueue_.end()) {
+      if (!failIfUnsendable(*it++)) {
+        ++numSendable;
+      }
+    }
+  }
+  return numSendable;
+}
+
+void McClientRequestContextQueue::failExpiredPending(
+    std::chrono::steady_clock::time_point now) {
+  while (!pendingQueue_.empty() && pendingQueue_.front().isExpired(now)) {
+    failPending(
+        pendingQueue_.front(), carbon::Result::TIMEOUT, "Client queue timeout");
+  }
+}
+
 McClientRequestContextBase& McClientRequestContextQueue::markNextAsSent() {
   if (!repliedQueue_.empty()) {
     auto& req = repliedQueue_.front();
@@ -186,6 +241,15 @@ void McClientRequestContextQueue::failQueue(
   }
 }
 
+void McClientRequestContextQueue::failPending(
+    McClientRequestContextBase& req,
+    carbon::Result error,
+    folly::StringPiece errorMessage) {
+  removePending(req);
+  req.rpcStatsContext_.notSent = true;
+  req.replyError(error, errorMessage);
+}
+
 McClientRequestContextBase::UnorderedSet::iterator
 McClientRequestContextQueue::getContextById(uint64_t id) {
   return set_.find(
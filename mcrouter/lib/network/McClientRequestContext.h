@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <typeindex>
 
@@ -39,6 +40,9 @@ class McClientRequestContextBase
   McSerializedRequest reqContext;
   uint64_t id;
   bool isBatchTail{false};
+  // If set, the request is failed instead of being sent once this becomes
+  // true (e.g. the client it was sent for disconnected).
+  const std::atomic<bool>* cancelled{nullptr};
 
   McClientRequestContextBase(const McClientRequestContextBase&) = delete;
   McClientRequestContextBase& operator=(
@@ -66,6 +70,24 @@ class McClientRequestContextBase
    */
   void scheduleTimeout();
 
+  bool isCancelled() const {
+    return cancelled && cancelled->load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Makes the time spent in the pending queue count against the timeout:
+   * the request expires at `deadline` and, once sent, only waits for the
+   * reply until then.
+   */
+  void setDeadline(std::chrono::steady_clock::time_point deadline) {
+    deadline_ = deadline;
+  }
+
+  bool isExpired(std::chrono::steady_clock::time_point now) const {
+    return deadline_ != std::chrono::steady_clock::time_point() &&
+        now >= deadline_;
+  }
+
   void setRpcStatsContext(RpcStatsContext value) {
     rpcStatsContext_ = value;
     rpcStatsContext_.requestBodySize = reqContext.getBodySize();
@@ -97,7 +119,10 @@ class McClientRequestContextBase
       InitializerFuncPtr initializer,
       const std::function<void(int pendingDiff, int inflightDiff)>&
           onStateChange,
-      const CodecIdRange& supportedCodecs);
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeoutBudget,
+      bool compactCaretHeader,
+      bool asciiMetaProtocol);
 
   virtual void replyErrorImpl(
       carbon::Result result,
@@ -130,6 +155,8 @@ class McClientRequestContextBase
 
   RpcStatsContext rpcStatsContext_;
 
+  std::chrono::steady_clock::time_point deadline_;
+
   const std::function<void(int pendingDiff, int inflightDiff)>& onStateChange_;
 
   /**
@@ -184,7 +211,10 @@ class McClientRequestContext : public McClientRequestContextBase {
       McClientRequestContextBase::InitializerFuncPtr,
       const std::function<void(int pendingDiff, int inflightDiff)>&
           onStateChange,
-      const CodecIdRange& supportedCodecs);
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeoutBudget = std::chrono::milliseconds(0),
+      bool compactCaretHeader = false,
+      bool asciiMetaProtocol = false);
 
   std::string getContextTypeStr() const final;
 
@@ -242,17 +272,42 @@ class McClientRequestContextQueue {
   /**
    * Peek next request that we're about to send.
    *
-   * @return a reference to the next request in the pending queue.
+   * @return a reference to the next request in the pending queue (the oldest
+   *         one, unless setPendingLifo(true) was called).
    */
   McClientRequestContextBase& peekNextPending();
 
   /**
-   * Moves the first request from pending queue into sending queue.
+   * Moves the next request from pending queue into sending queue.
    *
    * @return a reference to the request that was marked as sending.
    */
   McClientRequestContextBase& markNextAsSending();
 
+  /**
+   * Walks the pending requests in the order they would be sent, failing the
+   * cancelled ones and the ones expired at `now` without sending them, until
+   * `count` requests that can be sent are found.
+   *
+   * @return  The number of requests that can be sent next, at most `count`.
+   */
+  size_t failUnsendablePending(
+      size_t count,
+      std::chrono::steady_clock::time_point now);
+
+  /**
+   * Fails the oldest pending requests, as long as they are expired at `now`.
+   */
+  void failExpiredPending(std::chrono::steady_clock::time_point now);
+
+  /**
+   * If true, peekNextPending() and co. work on the most recent pending
+   * request rather than on the oldest one.
+   */
+  void setPendingLifo(bool lifo) {
+    pendingLifo_ = lifo;
+  }
+
   /**
    * Marks the first request from sending queue as sent.
    *
@@ -301,6 +356,7 @@ class McClientRequestContextQueue {
   using State = McClientRequestContextBase::ReqState;
 
   bool outOfOrder_{false};
+  bool pendingLifo_{false};
   // Queue of requests, that are queued to be sent.
   McClientRequestContextBase::Queue pendingQueue_;
   // Queue of requests, that are currently being written to the socket.
@@ -324,6 +380,14 @@ class McClientRequestContextQueue {
       carbon::Result error,
       folly::StringPiece errorMessage);
 
+  /**
+   * Removes given request from pending queue and fails it as not sent.
+   */
+  void failPending(
+      McClientRequestContextBase& req,
+      carbon::Result error,
+      folly::StringPiece errorMessage);
+
   McClientRequestContextBase::UnorderedSet::iterator getContextById(
       uint64_t id);
   void removeFromSet(McClientRequestContextBase& req);
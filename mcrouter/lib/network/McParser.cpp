@@ -8,25 +8,27 @@
 #include "McParser.h"
 
 #include <algorithm>
+#include <cstring>
 #include <new>
 #include <utility>
+#include <vector>
 
 #include <folly/Format.h>
+#include <folly/ThreadCachedInt.h>
 #include <folly/ThreadLocal.h>
 #include <folly/experimental/JemallocNodumpAllocator.h>
 #include <folly/io/Cursor.h>
 #include <folly/lang/Bits.h>
 #include <glog/logging.h>
 
-#include "mcrouter/lib/Clocks.h"
 #include "mcrouter/lib/network/CaretProtocol.h"
 
 namespace facebook {
 namespace memcache {
 
 namespace {
-// Adjust buffer size after this many CPU cycles (~2 billion)
-constexpr uint64_t kAdjustBufferSizeCpuCycles = 1UL << 31;
+// Weight of the latest message size in the average of a connection.
+constexpr double kMessageSizeSmoothing = 1.0 / 8;
 // Max allowed body size is 1GB.
 constexpr size_t kMaxBodySize = 1UL << 30;
 
@@ -65,6 +67,27 @@ folly::IOBuf copyToNodumpBuffer(
 }
 #endif
 
+// Released read buffers kept per thread, and the max size of those kept.
+constexpr size_t kMaxPooledReadBuffers = 64;
+constexpr size_t kMaxPooledReadBufferSize = 64 * 1024;
+
+struct ReadBufferCounters {
+  folly::ThreadCachedInt<int64_t> bytes;
+  folly::ThreadCachedInt<uint64_t> hits;
+  folly::ThreadCachedInt<uint64_t> misses;
+};
+
+ReadBufferCounters& readBufferCounters() {
+  static auto* counters = new ReadBufferCounters();
+  return *counters;
+}
+
+// Indexed by whether the buffers come from the nodump allocator.
+std::vector<folly::IOBuf>& readBufferPool(bool nodump) {
+  static thread_local std::vector<folly::IOBuf> pools[2];
+  return pools[nodump ? 1 : 0];
+}
+
 } // namespace
 
 McParser::McParser(
@@ -87,14 +110,90 @@ McParser::McParser(
 #else
   useJemallocNodumpAllocator_ = false;
 #endif
+  accountBufferBytes();
+}
+
+McParser::~McParser() {
+  readBufferCounters().bytes.increment(-static_cast<int64_t>(accountedBytes_));
 }
 
 void McParser::reset() {
   readBuffer_.clear();
+  largeMessage_ = folly::IOBuf();
+  largeMessageSize_ = 0;
+}
+
+void McParser::setReleaseIdleBuffer(bool release) {
+  releaseIdleBuffer_ = release;
+  if (releaseIdleBuffer_ && readBuffer_.length() == 0) {
+    releaseBuffer();
+  }
+}
+
+void McParser::acquireBuffer() {
+  auto& pool = readBufferPool(useJemallocNodumpAllocator_);
+  if (pool.empty()) {
+    readBufferCounters().misses.increment();
+#ifdef FOLLY_JEMALLOC_NODUMP_ALLOCATOR_SUPPORTED
+    if (useJemallocNodumpAllocator_) {
+      readBuffer_ = copyToNodumpBuffer(folly::IOBuf(), bufferSize_);
+      return;
+    }
+#endif
+    readBuffer_ = folly::IOBuf(folly::IOBuf::CREATE, bufferSize_);
+    return;
+  }
+  readBufferCounters().hits.increment();
+  readBuffer_ = std::move(pool.back());
+  pool.pop_back();
+}
+
+void McParser::releaseBuffer() {
+  assert(readBuffer_.length() == 0);
+  auto& pool = readBufferPool(useJemallocNodumpAllocator_);
+  // A shared buffer still backs parsed values, it can't be reused.
+  if (readBuffer_.capacity() > 0 && !readBuffer_.isSharedOne() &&
+      readBuffer_.capacity() <= kMaxPooledReadBufferSize &&
+      pool.size() < kMaxPooledReadBuffers) {
+    readBuffer_.clear();
+    pool.push_back(std::move(readBuffer_));
+  }
+  readBuffer_ = folly::IOBuf();
+  accountBufferBytes();
+}
+
+void McParser::accountBufferBytes() {
+  const size_t bytes = readBuffer_.capacity();
+  if (bytes != accountedBytes_) {
+    readBufferCounters().bytes.increment(
+        static_cast<int64_t>(bytes) - static_cast<int64_t>(accountedBytes_));
+    accountedBytes_ = bytes;
+  }
+}
+
+int64_t McParser::readBufferBytes() {
+  return readBufferCounters().bytes.readFull();
+}
+
+uint64_t McParser::readBufferPoolHits() {
+  return readBufferCounters().hits.readFull();
+}
+
+uint64_t McParser::readBufferPoolMisses() {
+  return readBufferCounters().misses.readFull();
 }
 
 std::pair<void*, size_t> McParser::getReadBuffer() {
+  if (largeMessageSize_ > 0) {
+    // Only read up to the end of the message, the rest goes to readBuffer_.
+    return std::make_pair(
+        largeMessage_.writableTail(),
+        largeMessageSize_ - largeMessage_.length());
+  }
   assert(!readBuffer_.isChained());
+  if (readBuffer_.capacity() == 0) {
+    acquireBuffer();
+  }
   readBuffer_.unshareOne();
   if (!readBuffer_.length()) {
     assert(readBuffer_.capacity() > 0);
@@ -105,8 +204,12 @@ std::pair<void*, size_t> McParser::getReadBuffer() {
     readBuffer_.retreat(readBuffer_.headroom());
   } else {
     /* Reallocate more space if necessary */
-    readBuffReserve(minBufferSize_);
+    const size_t target = targetBufferSize();
+    readBuffReserve(std::max(
+        minBufferSize_,
+        target > readBuffer_.length() ? target - readBuffer_.length() : 0));
   }
+  accountBufferBytes();
   return std::make_pair(readBuffer_.writableTail(), readBuffer_.tailroom());
 }
 
@@ -160,6 +263,7 @@ bool McParser::readCaretData() {
         debugFifo_->writeData(readBuffer_.writableData(), messageSize);
       }
 
+      recordMessageSize(messageSize);
       bool cbStatus;
       cbStatus = callback_.caretMessageReady(msgInfo_, readBuffer_);
 
@@ -176,16 +280,25 @@ bool McParser::readCaretData() {
       return true;
     }
 
-    // Case 3: We have the full header, but not the full body. If needed,
+    if (messageSize > kMaxBodySize) {
+      LOG(ERROR) << "Body size was " << messageSize
+                 << ", but max size allowed is " << kMaxBodySize;
+      return false;
+    }
+
+    // Case 3: We have the full header, but not the full body of a large
+    // message. Read the rest of it into a buffer of its own.
+    if (largeMessageThreshold_ > 0 && messageSize >= largeMessageThreshold_ &&
+        !useJemallocNodumpAllocator_) {
+      startLargeMessage(messageSize);
+      return true;
+    }
+
+    // Case 4: We have the full header, but not the full body. If needed,
     // reallocate into a buffer large enough for full header and body. Then
     // return to wait for remaining data.
     if (readBuffer_.length() + readBuffer_.tailroom() < messageSize) {
       assert(!readBuffer_.isChained());
-      if (messageSize > kMaxBodySize) {
-        LOG(ERROR) << "Body size was " << messageSize
-                   << ", but max size allowed is " << kMaxBodySize;
-        return false;
-      }
       readBuffer_.unshareOne();
       bufferSize_ = std::max<size_t>(bufferSize_, messageSize);
       readBuffReserve(bufferSize_ - readBuffer_.length());
@@ -204,26 +317,76 @@ bool McParser::readCaretData() {
   }
 
   // We parsed everything, read buffer is empty.
-  // Try to shrink it to reduce memory footprint
-  // TODO: should compare the readbuffer capacity not bufferSize
-  if (bufferSize_ > maxBufferSize_) {
-    auto curCycles = cycles::getCpuCycles();
-    if (curCycles > lastShrinkCycles_ + kAdjustBufferSizeCpuCycles) {
-      lastShrinkCycles_ = curCycles;
-      bufferSize_ = maxBufferSize_;
+  maybeShrinkBuffer();
+  return true;
+}
+
+void McParser::recordMessageSize(size_t size) {
+  avgMessageSize_ += (static_cast<double>(size) - avgMessageSize_) *
+      kMessageSizeSmoothing;
+}
+
+size_t McParser::targetBufferSize() const {
+  // Room for a couple of messages of the average size, so that one read
+  // usually gets whole messages.
+  const auto avg = static_cast<size_t>(avgMessageSize_);
+  return std::max(
+      minBufferSize_,
+      avg > 0 ? folly::nextPowTwo(2 * avg) : static_cast<size_t>(0));
+}
+
+void McParser::maybeShrinkBuffer() {
+  assert(readBuffer_.length() == 0);
+  // Buffers up to maxBufferSize_ are kept. A larger one is kept as long as
+  // the average message needs about as much, so connections alternating
+  // small and huge messages don't reallocate it every time.
+  const size_t target = targetBufferSize();
+  if (readBuffer_.capacity() <= std::max(maxBufferSize_, 2 * target)) {
+    return;
+  }
+  bufferSize_ = target;
 #ifdef FOLLY_JEMALLOC_NODUMP_ALLOCATOR_SUPPORTED
-      if (useJemallocNodumpAllocator_) {
-        readBuffer_ = copyToNodumpBuffer(readBuffer_, bufferSize_);
-        return true;
-      }
+  if (useJemallocNodumpAllocator_) {
+    readBuffer_ = copyToNodumpBuffer(folly::IOBuf(), bufferSize_);
+    return;
+  }
 #endif
-      readBuffer_ = folly::IOBuf(folly::IOBuf::CREATE, bufferSize_);
-    }
+  readBuffer_ = folly::IOBuf(folly::IOBuf::CREATE, bufferSize_);
+}
+
+void McParser::startLargeMessage(size_t messageSize) {
+  // Everything in readBuffer_ is part of this message.
+  assert(readBuffer_.length() < messageSize);
+  largeMessage_ = folly::IOBuf(folly::IOBuf::CREATE, messageSize);
+  std::memcpy(
+      largeMessage_.writableTail(), readBuffer_.data(), readBuffer_.length());
+  largeMessage_.append(readBuffer_.length());
+  largeMessageSize_ = messageSize;
+  readBuffer_.clear();
+}
+
+bool McParser::readLargeMessage(size_t len) {
+  largeMessage_.append(len);
+  if (largeMessage_.length() < largeMessageSize_) {
+    return true;
   }
-  return true;
+  largeMessageSize_ = 0;
+  recordMessageSize(largeMessage_.length());
+  auto message = std::move(largeMessage_);
+  largeMessage_ = folly::IOBuf();
+
+  if (FOLLY_UNLIKELY(debugFifo_ && debugFifo_->isConnected())) {
+    debugFifo_->startMessage(MessageDirection::Received, msgInfo_.typeId);
+    debugFifo_->writeData(message.writableData(), message.length());
+  }
+  return callback_.caretMessageReady(msgInfo_, message);
 }
 
 bool McParser::readDataAvailable(size_t len) {
+  if (largeMessageSize_ > 0) {
+    return readLargeMessage(len);
+  }
+
   // Caller is responsible for ensuring the read buffer has enough tailroom
   readBuffer_.append(len);
   if (FOLLY_UNLIKELY(readBuffer_.length() == 0)) {
@@ -241,11 +404,24 @@ bool McParser::readDataAvailable(size_t len) {
     }
   }
 
+  bool ok = true;
   if (protocol_ == mc_ascii_protocol) {
+    // Ascii messages aren't framed, the data available at once is what
+    // the buffer has to hold.
+    recordMessageSize(readBuffer_.length());
     callback_.handleAscii(readBuffer_);
-    return true;
+    if (readBuffer_.length() == 0) {
+      maybeShrinkBuffer();
+    }
+  } else {
+    ok = readCaretData();
+  }
+  if (releaseIdleBuffer_ && readBuffer_.length() == 0) {
+    releaseBuffer();
+  } else {
+    accountBufferBytes();
   }
-  return readCaretData();
+  return ok;
 }
 
 } // namespace memcache
@@ -24,6 +24,7 @@ namespace memcache {
 inline mc_protocol_t determineProtocol(uint8_t firstByte) {
   switch (firstByte) {
     case kCaretMagicByte:
+    case kCaretCompactMagicByte:
       return mc_caret_protocol;
     default:
       return mc_ascii_protocol;
@@ -72,7 +73,7 @@ class McParser {
       const bool useJemallocNodumpAllocator = false,
       ConnectionFifo* debugFifo = nullptr);
 
-  ~McParser() = default;
+  ~McParser();
 
   mc_protocol_t protocol() const {
     return protocol_;
@@ -109,6 +110,34 @@ class McParser {
     debugFifo_ = fifo;
   }
 
+  /**
+   * If true, the read buffer is given back to a pool of the thread as soon
+   * as all the data read has been parsed, and taken again on the next read,
+   * so that idle connections don't pin a buffer each.
+   */
+  void setReleaseIdleBuffer(bool release);
+
+  /**
+   * Caret messages of at least `threshold` bytes that aren't fully read yet
+   * are read into a buffer of their own, of the exact size of the message,
+   * and passed to caretMessageReady() as is. The read buffer then neither
+   * grows to fit them nor ends up shared with their values, which would
+   * cost a copy of its data on the next read. 0 (the default) to read every
+   * message into the read buffer.
+   */
+  void setLargeMessageThreshold(size_t threshold) {
+    largeMessageThreshold_ = threshold;
+  }
+
+  /**
+   * Process wide counters, summed over all threads: bytes held by the read
+   * buffers of all the parsers, and reuse of the buffers released with
+   * setReleaseIdleBuffer().
+   */
+  static int64_t readBufferBytes();
+  static uint64_t readBufferPoolHits();
+  static uint64_t readBufferPoolMisses();
+
  private:
   bool seenFirstByte_{false};
   bool outOfOrder_{false};
@@ -122,9 +151,20 @@ class McParser {
 
   ConnectionFifo* debugFifo_{nullptr};
 
-  uint64_t lastShrinkCycles_{0};
+  // Moving average of the sizes of the messages of this connection, which
+  // sizes the read buffer.
+  double avgMessageSize_{0};
 
   folly::IOBuf readBuffer_;
+  // Capacity of readBuffer_ last accounted in readBufferBytes().
+  size_t accountedBytes_{0};
+  bool releaseIdleBuffer_{false};
+
+  size_t largeMessageThreshold_{0};
+  // The message being read, if it is over largeMessageThreshold_. Its size
+  // is in largeMessageSize_, 0 if there is none.
+  folly::IOBuf largeMessage_;
+  size_t largeMessageSize_{0};
 
   /**
    * If we've read a caret header, this will contain header/body sizes.
@@ -137,7 +177,15 @@ class McParser {
   bool useJemallocNodumpAllocator_{false};
 
   bool readCaretData();
+  void startLargeMessage(size_t messageSize);
+  bool readLargeMessage(size_t len);
   void readBuffReserve(size_t bufSize);
+  void recordMessageSize(size_t size);
+  size_t targetBufferSize() const;
+  void maybeShrinkBuffer();
+  void acquireBuffer();
+  void releaseBuffer();
+  void accountBufferBytes();
 };
 
 inline McParser::ParserCallback::~ParserCallback() {}
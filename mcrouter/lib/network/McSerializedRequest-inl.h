@@ -34,7 +34,10 @@ McSerializedRequest::McSerializedRequest(
     const Request& req,
     size_t reqId,
     mc_protocol_t protocol,
-    const CodecIdRange& compressionCodecs)
+    const CodecIdRange& compressionCodecs,
+    std::chrono::milliseconds timeoutBudget,
+    bool compactHeader,
+    bool asciiMeta)
     : protocol_(protocol), typeId_(Request::typeId) {
   folly::fibers::runInMainContext([&] {
     switch (protocol_) {
@@ -44,6 +47,7 @@ McSerializedRequest::McSerializedRequest(
           result_ = Result::BAD_KEY;
           return;
         }
+        asciiRequest_.setMetaProtocol(asciiMeta);
         if (!asciiRequest_.prepare(req, iovsBegin_, iovsCount_)) {
           result_ = Result::ERROR;
         }
@@ -54,8 +58,14 @@ McSerializedRequest::McSerializedRequest(
           result_ = Result::BAD_KEY;
           return;
         }
+        caretRequest_.setCompactHeader(compactHeader);
         if (!caretRequest_.prepare(
-                req, reqId, compressionCodecs, iovsBegin_, iovsCount_)) {
+                req,
+                reqId,
+                compressionCodecs,
+                timeoutBudget,
+                iovsBegin_,
+                iovsCount_)) {
           result_ = Result::ERROR;
         }
         break;
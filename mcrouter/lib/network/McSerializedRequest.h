@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "mcrouter/lib/mc/protocol.h"
@@ -35,13 +36,22 @@ class McSerializedRequest {
    * @param protocol          Protocol to serialize the request.
    * @param supportedCodecs   Range of supported compression codecs.
    *                          Only used for caret.
+   * @param timeoutBudget     How long the reply will be waited for, sent to
+   *                          the server if non-zero. Only used for caret.
+   * @param compactHeader     Use the compact caret header. Only used for
+   *                          caret.
+   * @param asciiMeta         Send the request as a meta command if it has
+   *                          one. Only used for ascii.
    */
   template <class Request>
   McSerializedRequest(
       const Request& req,
       size_t reqId,
       mc_protocol_t protocol,
-      const CodecIdRange& supportedCodecs);
+      const CodecIdRange& supportedCodecs,
+      std::chrono::milliseconds timeoutBudget = std::chrono::milliseconds(0),
+      bool compactHeader = false,
+      bool asciiMeta = false);
 
   ~McSerializedRequest();
 
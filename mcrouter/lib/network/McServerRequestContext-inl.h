@@ -106,7 +106,8 @@ void McServerRequestContext::replyImpl2(
           std::move(destructorContainer),
           session->compressionCodecMap_,
           session->codecIdRange_,
-          session->options_.tcpZeroCopyThresholdBytes)) {
+          session->options_.tcpZeroCopyThresholdBytes,
+          session->compactCaretHeader_)) {
     session->transport_->close();
     return;
   }
@@ -121,6 +122,7 @@ void McServerRequestContext::replyImpl2(
  *  1) We saw an error (the error will be printed out by the end context),
  *  2) This is a miss, except for lease-get (lease-get misses still have
  *     'LVALUE' replies with the token).
+ *  3) This is a quiet meta command with nothing to report.
  * Lease-gets are handled in a separate overload below.
  */
 template <class Reply>
@@ -129,7 +131,9 @@ bool McServerRequestContext::noReply(const Reply& r) const {
     return true;
   }
   if (!hasParent()) {
-    return false;
+    auto meta = asciiMetaFlags();
+    return FOLLY_UNLIKELY(meta != nullptr) && meta->quiet &&
+        mcAsciiMetaQuietDrops(r);
   }
   return isParentError() || *r.result_ref() != carbon::Result::FOUND;
 }
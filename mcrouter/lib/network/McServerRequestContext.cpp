@@ -7,12 +7,78 @@
 
 #include "McServerRequestContext.h"
 
+#include <vector>
+
 #include "mcrouter/lib/network/McServerSession.h"
 #include "mcrouter/lib/network/MultiOpParent.h"
 
 namespace facebook {
 namespace memcache {
 
+namespace {
+
+constexpr size_t kMaxFreeAsciiStates = 4096;
+
+// Set once the free list of the thread is destroyed, for the contexts
+// destroyed after it on thread exit.
+thread_local bool asciiStateFreeListDestroyed = false;
+
+} // namespace
+
+// Contexts are created and destroyed on the thread of their session, so the
+// free list needs no locking.
+template <class State>
+struct AsciiStateFreeList {
+  std::vector<State*> states;
+
+  AsciiStateFreeList() {
+    states.reserve(kMaxFreeAsciiStates);
+  }
+
+  ~AsciiStateFreeList() {
+    asciiStateFreeListDestroyed = true;
+    for (auto state : states) {
+      delete state;
+    }
+  }
+
+  static AsciiStateFreeList& get() {
+    static thread_local AsciiStateFreeList freeList;
+    return freeList;
+  }
+};
+
+McServerRequestContext::AsciiStatePtr McServerRequestContext::makeAsciiState() {
+  if (asciiStateFreeListDestroyed) {
+    return AsciiStatePtr(new AsciiState());
+  }
+  auto& freeList = AsciiStateFreeList<AsciiState>::get();
+  if (freeList.states.empty()) {
+    return AsciiStatePtr(new AsciiState());
+  }
+  AsciiStatePtr state(freeList.states.back());
+  freeList.states.pop_back();
+  return state;
+}
+
+void McServerRequestContext::AsciiStateDeleter::operator()(
+    AsciiState* state) const noexcept {
+  // Might destroy the parent, which doesn't use the free list.
+  state->parent_.reset();
+  state->key_.reset();
+  state->meta_.reset();
+  if (asciiStateFreeListDestroyed) {
+    delete state;
+    return;
+  }
+  auto& freeList = AsciiStateFreeList<AsciiState>::get();
+  if (freeList.states.size() < kMaxFreeAsciiStates) {
+    freeList.states.push_back(state);
+  } else {
+    delete state;
+  }
+}
+
 McServerSession& McServerRequestContext::session() {
   assert(session_ != nullptr);
   return *session_;
@@ -26,7 +92,7 @@ McServerRequestContext::McServerRequestContext(
     bool isEndContext)
     : session_(&s), isEndContext_(isEndContext), noReply_(nr), reqid_(r) {
   if (parent) {
-    asciiState_ = std::make_unique<AsciiState>();
+    asciiState_ = makeAsciiState();
     asciiState_->parent_ = std::move(parent);
     asciiState_->parent_->recordRequest();
   }
@@ -20,6 +20,7 @@
 #include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/network/CarbonMessageList.h"
+#include "mcrouter/lib/network/McAsciiMeta.h"
 #include "mcrouter/lib/network/ServerLoad.h"
 
 namespace facebook {
@@ -89,8 +90,20 @@ class McServerRequestContext {
   struct AsciiState {
     std::shared_ptr<MultiOpParent> parent_;
     folly::Optional<folly::IOBuf> key_;
+    // Set iff the request came in as a meta command.
+    folly::Optional<McAsciiMetaFlags> meta_;
   };
-  std::unique_ptr<AsciiState> asciiState_;
+  /**
+   * Multigets need an AsciiState for every key; they are recycled through a
+   * per thread free list instead of being allocated for every key.
+   */
+  struct AsciiStateDeleter {
+    void operator()(AsciiState* state) const noexcept;
+  };
+  using AsciiStatePtr = std::unique_ptr<AsciiState, AsciiStateDeleter>;
+  AsciiStatePtr asciiState_;
+
+  static AsciiStatePtr makeAsciiState();
 
   template <class Reply>
   bool noReply(const Reply& r) const;
@@ -117,10 +130,20 @@ class McServerRequestContext {
 
   folly::Optional<folly::IOBuf>& asciiKey() {
     if (!asciiState_) {
-      asciiState_ = std::make_unique<AsciiState>();
+      asciiState_ = makeAsciiState();
     }
     return asciiState_->key_;
   }
+  folly::Optional<McAsciiMetaFlags>& asciiMeta() {
+    if (!asciiState_) {
+      asciiState_ = makeAsciiState();
+    }
+    return asciiState_->meta_;
+  }
+  const McAsciiMetaFlags* asciiMetaFlags() const {
+    return asciiState_ && asciiState_->meta_ ? asciiState_->meta_.get_pointer()
+                                             : nullptr;
+  }
   bool hasParent() const {
     return asciiState_ && asciiState_->parent_;
   }
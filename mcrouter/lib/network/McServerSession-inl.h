@@ -9,6 +9,8 @@
 
 #include <memory>
 
+#include <folly/tracing/StaticTracepoint.h>
+
 #include "mcrouter/lib/network/CarbonMessageList.h"
 #include "mcrouter/lib/network/McServerRequestContext.h"
 #include "mcrouter/lib/network/MultiOpParent.h"
@@ -20,7 +22,8 @@ template <class Request>
 void McServerSession::asciiRequestReady(
     Request&& req,
     carbon::Result result,
-    bool noreply) {
+    bool noreply,
+    const McAsciiMetaFlags* meta) {
   DestructorGuard dg(this);
 
   using Reply = ReplyT<Request>;
@@ -32,15 +35,21 @@ void McServerSession::asciiRequestReady(
     return;
   }
 
-  if (carbon::GetLike<Request>::value && !currentMultiop_) {
-    currentMultiop_ = std::make_shared<MultiOpParent>(*this, tailReqid_++);
+  if (carbon::GetLike<Request>::value && !currentMultiop_ && !meta) {
+    currentMultiop_ = std::make_shared<MultiOpParent>(
+        *this, tailReqid_++, asciiMultigetStreaming_);
   }
   uint64_t reqid;
   reqid = tailReqid_++;
+  FOLLY_SDT(mcrouter, server_request_accepted, this, reqid, Request::typeId);
 
-  McServerRequestContext ctx(*this, reqid, noreply, currentMultiop_);
+  McServerRequestContext ctx(
+      *this, reqid, noreply, meta ? nullptr : currentMultiop_);
 
   ctx.asciiKey().emplace(req.key_ref()->raw().cloneOneAsValue());
+  if (meta) {
+    ctx.asciiMeta().emplace(*meta);
+  }
 
   if (result == carbon::Result::BAD_KEY) {
     McServerRequestContext::reply(
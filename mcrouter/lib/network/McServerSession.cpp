@@ -10,9 +10,11 @@
 #include <memory>
 
 #include <folly/Executor.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/VirtualEventBase.h>
 #include <folly/small_vector.h>
+#include <folly/tracing/StaticTracepoint.h>
 #include <thrift/lib/cpp2/server/Cpp2Worker.h>
 
 #include "mcrouter/lib/debug/FifoManager.h"
@@ -110,11 +112,24 @@ void McServerSession::applySocketOptions(
     folly::AsyncSocket& socket,
     const AsyncMcServerWorkerOptions& opts) {
   socket.setMaxReadsPerEvent(opts.maxReadsPerEvent);
+  socket.setSendTimeout(opts.sendTimeout.count());
+  folly::SocketAddress localAddress;
+  socket.getLocalAddress(&localAddress);
+  if (localAddress.getFamily() == AF_UNIX) {
+    // TCP socket options are not supported by a Unix domain socket transport.
+    return;
+  }
   socket.setNoDelay(true);
   if (opts.tcpZeroCopyThresholdBytes > 0) {
     socket.setZeroCopy(true);
   }
-  socket.setSendTimeout(opts.sendTimeout.count());
+  if (opts.busyPoll.count() > 0) {
+    int busyPoll = opts.busyPoll.count();
+    if (socket.setSockOpt(SOL_SOCKET, SO_BUSY_POLL, &busyPoll) != 0) {
+      LOG_EVERY_N(ERROR, 1000) << "Failed to set SO_BUSY_POLL = " << busyPoll
+                               << " on socket. errno: " << errno;
+    }
+  }
   if (opts.trafficClass > 0) {
     if (socket.setSockOpt(IPPROTO_IPV6, IPV6_TCLASS, &opts.trafficClass) != 0) {
       LOG_EVERY_N(ERROR, 1000) << "Failed to set TCLASS = " << opts.trafficClass
@@ -140,6 +155,7 @@ McServerSession::McServerSession(
       sendWritesCallback_(*this),
       compressionCodecMap_(codecMap),
       parser_(*this, options_.minBufferSize, options_.maxBufferSize),
+      asciiMultigetStreaming_(options.asciiMultigetStreaming),
       userCtxt_(userCtxt),
       zeroCopySessionCB_(*this) {
   try {
@@ -149,6 +165,9 @@ McServerSession::McServerSession(
     LOG(WARNING) << "Failed to get socket address: " << e.what();
   }
 
+  parser_.setReleaseIdleBuffer(options_.releaseIdleReadBuffers);
+  parser_.setLargeMessageThreshold(options_.largeMessageReadThreshold);
+
   if (auto socket = transport_->getUnderlyingTransport<McFizzServer>()) {
     socket->accept(this);
   }
@@ -163,6 +182,30 @@ McServerSession::getConnectionLevelThriftRequestContext() const noexcept {
   return thriftRequestContext_->getRequestContext();
 }
 
+const std::string& McServerSession::clientName() const {
+  if (clientName_.empty()) {
+    if (!clientCommonName_.empty()) {
+      clientName_ = clientCommonName_;
+    } else if (socketAddress_.isFamilyInet()) {
+      clientName_ = socketAddress_.getAddressStr();
+    } else {
+      clientName_ = socketAddress_.describe();
+    }
+  }
+  return clientName_;
+}
+
+uint64_t McServerSession::clientId() const {
+  if (clientId_ == 0) {
+    const auto& name = clientName();
+    clientId_ = folly::hash::SpookyHashV2::Hash64(name.data(), name.size(), 0);
+    if (clientId_ == 0) {
+      clientId_ = 1;
+    }
+  }
+  return clientId_;
+}
+
 void McServerSession::pause(PauseReason reason) {
   pauseState_ |= static_cast<uint64_t>(reason);
 
@@ -227,6 +270,7 @@ void McServerSession::onTransactionCompleted(bool isSubRequest) {
 
 void McServerSession::reply(std::unique_ptr<WriteBuffer> wb, uint64_t reqid) {
   DestructorGuard dg(this);
+  FOLLY_SDT(mcrouter, server_reply, this, reqid);
 
   if (parser_.outOfOrder()) {
     queueWrite(std::move(wb));
@@ -240,6 +284,10 @@ void McServerSession::reply(std::unique_ptr<WriteBuffer> wb, uint64_t reqid) {
         blockedReplies_.erase(it);
         it = blockedReplies_.find(++headReqid_);
       }
+    } else if (wb && wb->isStreamedSubReply(headReqid_)) {
+      /* hit of the multi-get being written, see asciiMultigetStreaming */
+      queueWrite(std::move(wb));
+      blockedReplies_.emplace(reqid, nullptr);
     } else {
       /* can't write this reply now, save for later */
       blockedReplies_.emplace(reqid, std::move(wb));
@@ -271,6 +319,7 @@ void McServerSession::close() {
 
   // Reset timeout if set, since we're shutting down anyway.
   goAwayTimeout_ = nullptr;
+  overloadTimeout_ = nullptr;
 
   // Regardless of the reason we're closing, we should immediately stop reading
   // from the socket or we may get into invalid state.
@@ -302,14 +351,40 @@ void McServerSession::readDataAvailable(size_t len) noexcept {
   DestructorGuard dg(this);
   if (!parser_.readDataAvailable(len)) {
     close();
+    return;
+  }
+  if (options_.overloadCheck) {
+    checkOverload();
   }
 }
 
+void McServerSession::checkOverload() {
+  if (state_ != STREAMING || (pauseState_ & PAUSE_OVERLOAD) ||
+      !options_.overloadCheck()) {
+    return;
+  }
+
+  pause(PAUSE_OVERLOAD);
+  if (!overloadTimeout_) {
+    overloadTimeout_ = folly::AsyncTimeout::make(eventBase_, [this]() noexcept {
+      DestructorGuard dg(this);
+      if (options_.overloadCheck && options_.overloadCheck()) {
+        overloadTimeout_->scheduleTimeout(options_.overloadPauseInterval);
+      } else {
+        resume(PAUSE_OVERLOAD);
+      }
+    });
+  }
+  overloadTimeout_->scheduleTimeout(options_.overloadPauseInterval);
+}
+
 void McServerSession::readEOF() noexcept {
+  clientGone_->store(true, std::memory_order_relaxed);
   close();
 }
 
 void McServerSession::readErr(const folly::AsyncSocketException&) noexcept {
+  clientGone_->store(true, std::memory_order_relaxed);
   close();
 }
 
@@ -323,6 +398,21 @@ void McServerSession::multiOpEnd() {
   processMultiOpEnd();
 }
 
+void McServerSession::metaNoop() {
+  DestructorGuard dg(this);
+
+  if (state_ != STREAMING) {
+    return;
+  }
+
+  // Replied in order with the commands before it, which is what lets
+  // clients tell that all of their preceding quiet commands completed.
+  McServerRequestContext ctx(*this, tailReqid_++);
+  ctx.asciiMeta().emplace().noop = true;
+  McServerRequestContext::reply(
+      std::move(ctx), McVersionReply(carbon::Result::OK));
+}
+
 void McServerSession::onRequest(
     McVersionRequest&& req,
     bool /* noreply = false */) {
@@ -383,12 +473,19 @@ void McServerSession::caretRequestReady(
   }
 
   updateCompressionCodecIdRange(headerInfo);
+  compactCaretHeader_ = headerInfo.compactHeader;
 
   if (headerInfo.reqId == kCaretConnectionControlReqId) {
     processConnectionControlMessage(headerInfo);
     return;
   }
 
+  FOLLY_SDT(
+      mcrouter,
+      server_request_accepted,
+      this,
+      headerInfo.reqId,
+      headerInfo.typeId);
   McServerRequestContext ctx(*this, headerInfo.reqId);
 
   if (McVersionRequest::typeId == headerInfo.typeId &&
@@ -419,6 +516,11 @@ void McServerSession::processConnectionControlMessage(
       close();
       break;
     }
+    case kCaretCompressionCodecsTypeId: {
+      // codecIdRange_ was already updated from this header.
+      negotiatedCodecIdRange_ = codecIdRange_;
+      break;
+    }
     default:
       // Unknown connection controll message, ignore it.
       break;
@@ -427,8 +529,10 @@ void McServerSession::processConnectionControlMessage(
 
 void McServerSession::updateCompressionCodecIdRange(
     const CaretMessageInfo& headerInfo) noexcept {
-  if (headerInfo.supportedCodecsSize == 0 || !compressionCodecMap_) {
+  if (!compressionCodecMap_) {
     codecIdRange_ = CodecIdRange::Empty;
+  } else if (headerInfo.supportedCodecsSize == 0) {
+    codecIdRange_ = negotiatedCodecIdRange_;
   } else {
     codecIdRange_ = {
         headerInfo.supportedCodecsFirstId, headerInfo.supportedCodecsSize};
@@ -630,6 +734,7 @@ void McServerSession::writeErr(
     size_t /* bytesWritten */,
     const folly::AsyncSocketException&) noexcept {
   DestructorGuard dg(this);
+  clientGone_->store(true, std::memory_order_relaxed);
   completeWrite();
   close();
 }
@@ -699,6 +804,19 @@ void McServerSession::fizzHandshakeSuccess(
   if (maybeCN.hasValue()) {
     clientCommonName_.assign(*maybeCN);
   }
+
+  if (options_.useKtls13) {
+    // try to flip to using ktls, transport is detached if it succeeds
+    if (auto ktlsTransport = McSSLUtil::moveToKtls(*transport)) {
+      auto asyncSock =
+          ktlsTransport->getUnderlyingTransport<folly::AsyncSocket>();
+      CHECK(asyncSock);
+      applySocketOptions(*asyncSock, options_);
+      transport_.reset(ktlsTransport.release());
+      transport_->setReadCB(this);
+    }
+  }
+
   onAccepted();
 }
 
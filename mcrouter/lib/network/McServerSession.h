@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include <fizz/server/AsyncFizzServer.h>
 #include <folly/IntrusiveList.h>
 #include <folly/io/async/AsyncSSLSocket.h>
@@ -187,6 +190,34 @@ class McServerSession
     return inFlight_ > 0;
   }
 
+  /**
+   * See AsyncMcServerWorkerOptions::asciiMultigetStreaming.
+   * Applies to the multi-gets parsed from now on.
+   */
+  void setAsciiMultigetStreaming(bool streaming) {
+    asciiMultigetStreaming_ = streaming;
+  }
+
+  /**
+   * Hint for the application to schedule the requests of this connection
+   * behind the others. Not used by the session itself.
+   */
+  void setLowPriority(bool lowPriority) {
+    lowPriority_ = lowPriority;
+  }
+  bool lowPriority() const {
+    return lowPriority_;
+  }
+
+  /**
+   * Set once the client went away (EOF or a socket error): replies to the
+   * requests still in flight can't be delivered anymore. May be read from
+   * any thread, e.g. to skip sending those requests further.
+   */
+  std::shared_ptr<const std::atomic<bool>> clientGone() const {
+    return clientGone_;
+  }
+
   /**
    * Allow clients to pause and resume reading form the sockets.
    * See pause(PauseReason) and resume(PauseReason) below.
@@ -242,6 +273,18 @@ class McServerSession
     return clientCommonName_;
   }
 
+  /**
+   * @return  Name identifying the client: its common name if this is an SSL
+   *          session with a client cert, else its IP address (without port,
+   *          all connections from a host are the same client).
+   */
+  const std::string& clientName() const;
+
+  /**
+   * @return  Non-zero hash of clientName().
+   */
+  uint64_t clientId() const;
+
   /**
    * @return the EventBase for this thread
    */
@@ -370,6 +413,7 @@ class McServerSession
     PAUSE_THROTTLED = 1 << 0,
     PAUSE_WRITE = 1 << 1,
     PAUSE_USER = 1 << 2,
+    PAUSE_OVERLOAD = 1 << 3,
   };
 
   /* Reads are enabled iff pauseState_ == 0 */
@@ -378,6 +422,12 @@ class McServerSession
   // Compression
   const CompressionCodecMap* compressionCodecMap_{nullptr};
   CodecIdRange codecIdRange_ = CodecIdRange::Empty;
+  // Announced by the client for the whole connection (see
+  // kCaretCompressionCodecsTypeId), used for requests that carry no range.
+  CodecIdRange negotiatedCodecIdRange_ = CodecIdRange::Empty;
+
+  // Replies use the caret header format of the last request.
+  bool compactCaretHeader_{false};
 
   ServerMcParser<McServerSession> parser_;
 
@@ -392,6 +442,10 @@ class McServerSession
 
   /* If non-null, a multi-op operation is being parsed.*/
   std::shared_ptr<MultiOpParent> currentMultiop_;
+  bool asciiMultigetStreaming_{false};
+  bool lowPriority_{false};
+  const std::shared_ptr<std::atomic<bool>> clientGone_{
+      std::make_shared<std::atomic<bool>>(false)};
 
   folly::SocketAddress socketAddress_;
 
@@ -400,11 +454,18 @@ class McServerSession
    * this is set to the common name from client cert
    */
   std::string clientCommonName_;
+  // Computed by clientName() and clientId() on first use, once the
+  // handshake is done.
+  mutable std::string clientName_;
+  mutable uint64_t clientId_{0};
 
   void* userCtxt_{nullptr};
 
   std::unique_ptr<folly::AsyncTimeout> goAwayTimeout_;
 
+  // Resumes reads paused by options_.overloadCheck.
+  std::unique_ptr<folly::AsyncTimeout> overloadTimeout_;
+
   ZeroCopySessionCB zeroCopySessionCB_;
   SecurityMech negotiatedMech_{SecurityMech::NONE};
 
@@ -418,6 +479,11 @@ class McServerSession
   void pause(PauseReason reason);
   void resume(PauseReason reason);
 
+  /**
+   * Pauses reads while options_.overloadCheck returns true.
+   */
+  void checkOverload();
+
   /**
    * Flush pending writes to the transport.
    */
@@ -445,7 +511,11 @@ class McServerSession
 
   /* McParser's callback if ASCII request is read into a typed request */
   template <class Request>
-  void asciiRequestReady(Request&& req, carbon::Result result, bool noreply);
+  void asciiRequestReady(
+      Request&& req,
+      carbon::Result result,
+      bool noreply,
+      const McAsciiMetaFlags* meta = nullptr);
 
   void caretRequestReady(
       const CaretMessageInfo& headerInfo,
@@ -465,6 +535,16 @@ class McServerSession
     asciiRequestReady(std::move(req), result, noreply);
   }
 
+  /* Meta commands are never part of a multi-op, and reply as per `meta` */
+  template <class Request>
+  void onMetaRequest(Request&& req, const McAsciiMetaFlags& meta) {
+    carbon::Result result = carbon::Result::UNKNOWN;
+    if (req.key_ref()->fullKey().size() > MC_KEY_MAX_LEN_ASCII) {
+      result = carbon::Result::BAD_KEY;
+    }
+    asciiRequestReady(std::move(req), result, false /* noreply */, &meta);
+  }
+
   /* ASCII parser callbacks for special commands */
   void onRequest(McVersionRequest&& req, bool noreply);
 
@@ -474,6 +554,8 @@ class McServerSession
 
   void multiOpEnd();
 
+  void metaNoop();
+
   void queueWrite(std::unique_ptr<WriteBuffer> wb);
 
   void completeWrite();
@@ -10,8 +10,20 @@
 namespace facebook {
 namespace memcache {
 
-MultiOpParent::MultiOpParent(McServerSession& session, uint64_t blockReqid)
-    : session_(session), block_(session, blockReqid, true /* noReply */) {}
+MultiOpParent::MultiOpParent(
+    McServerSession& session,
+    uint64_t blockReqid,
+    bool streaming)
+    : streaming_(streaming),
+      blockReqid_(blockReqid),
+      session_(session),
+      block_(session, blockReqid, true /* noReply */) {
+  if (streaming_) {
+    // Nothing to hold: the replies to the keys are written as they come,
+    // and the end context is still written after all of them.
+    McServerRequestContext::reply(std::move(block_), McGetReply());
+  }
+}
 
 bool MultiOpParent::reply(
     carbon::Result result,
@@ -57,9 +69,11 @@ void MultiOpParent::release() {
     reply_.emplace(carbon::Result::FOUND);
   }
   McServerRequestContext::reply(std::move(*end_), std::move(*reply_));
-  // It doesn't really matter what reply type we use for the multi-op
-  // blocking context
-  McServerRequestContext::reply(std::move(block_), McGetReply());
+  if (!streaming_) {
+    // It doesn't really matter what reply type we use for the multi-op
+    // blocking context
+    McServerRequestContext::reply(std::move(block_), McGetReply());
+  }
 }
 } // namespace memcache
 } // namespace facebook
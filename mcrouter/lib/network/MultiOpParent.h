@@ -46,7 +46,15 @@ class McServerSession;
  */
 class MultiOpParent {
  public:
-  MultiOpParent(McServerSession& session, uint64_t blockReqid);
+  /**
+   * @param streaming  If true, the replies to the keys don't wait for each
+   *                   other (see
+   *                   AsyncMcServerWorkerOptions::asciiMultigetStreaming).
+   */
+  MultiOpParent(
+      McServerSession& session,
+      uint64_t blockReqid,
+      bool streaming = false);
 
   /**
    * Examine the reply result of one of the sub-requests. If it's an error
@@ -79,10 +87,24 @@ class MultiOpParent {
     return error_;
   }
 
+  bool streaming() const {
+    return streaming_;
+  }
+
+  /**
+   * Id of the context holding the replies to the keys until the end, the
+   * one before the replies to the keys.
+   */
+  uint64_t blockReqid() const {
+    return blockReqid_;
+  }
+
  private:
   size_t waiting_{0};
   folly::Optional<McGetReply> reply_;
   bool error_{false};
+  const bool streaming_;
+  const uint64_t blockReqid_;
 
   McServerSession& session_;
   McServerRequestContext block_;
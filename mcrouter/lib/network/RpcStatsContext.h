@@ -37,6 +37,9 @@ struct RpcStatsContext {
   uint32_t replySizeAfterCompression{0};
   ServerLoad serverLoad{0};
   uint32_t requestBodySize{0};
+  // The request was failed by the client before being written to the
+  // network (e.g. it expired in the pending queue).
+  bool notSent{false};
 };
 
 } // namespace memcache
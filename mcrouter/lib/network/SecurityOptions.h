@@ -88,6 +88,14 @@ struct SecurityOptions {
    * Client side to prefer AES-OCB cipher suite if supported.
    */
   bool tlsPreferOcbCipher{false};
+
+  /**
+   * Try to move TLS 1.3 (fizz) connections to kTLS once the handshake is
+   * done. Uses the function installed with
+   * McSSLUtil::setApplicationKtlsFunctions(); if it's missing or fails, the
+   * connection keeps doing encryption in user space.
+   */
+  bool fizzUseKtls{false};
 };
 
 } // namespace memcache
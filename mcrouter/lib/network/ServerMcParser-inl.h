@@ -104,11 +104,27 @@ void ServerMcParser<Callback>::onRequest(Request&& req, bool noreply) {
   callback_.onRequest(std::move(req), noreply);
 }
 
+template <class Callback>
+template <class Request>
+void ServerMcParser<Callback>::onMetaRequest(
+    Request&& req,
+    const McAsciiMetaFlags& meta) {
+  if (FOLLY_UNLIKELY(debugFifo_ && debugFifo_->isConnected())) {
+    writeToPipe(req);
+  }
+  callback_.onMetaRequest(std::move(req), meta);
+}
+
 template <class Callback>
 void ServerMcParser<Callback>::multiOpEnd() {
   callback_.multiOpEnd();
 }
 
+template <class Callback>
+void ServerMcParser<Callback>::metaNoop() {
+  callback_.metaNoop();
+}
+
 template <class Callback>
 template <class Request>
 void ServerMcParser<Callback>::writeToPipe(const Request& req) {
@@ -60,6 +60,20 @@ class ServerMcParser : private McParser::ParserCallback {
     parser_.setDebugFifo(fifo);
   }
 
+  /**
+   * See McParser::setReleaseIdleBuffer().
+   */
+  void setReleaseIdleBuffer(bool release) {
+    parser_.setReleaseIdleBuffer(release);
+  }
+
+  /**
+   * See McParser::setLargeMessageThreshold().
+   */
+  void setLargeMessageThreshold(size_t threshold) {
+    parser_.setLargeMessageThreshold(threshold);
+  }
+
  private:
   McParser parser_;
   McServerAsciiParser asciiParser_;
@@ -82,7 +96,10 @@ class ServerMcParser : private McParser::ParserCallback {
   // McServerAsciiParser callbacks
   template <class Request>
   void onRequest(Request&&, bool noreply);
+  template <class Request>
+  void onMetaRequest(Request&&, const McAsciiMetaFlags& meta);
   void multiOpEnd();
+  void metaNoop();
 
   // McServerAsciiParser callback wrapper.
   template <class C, class ReqsList>
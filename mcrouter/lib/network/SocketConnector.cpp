@@ -7,6 +7,8 @@
 
 #include "SocketConnector.h"
 
+#include <atomic>
+
 #include <folly/io/SocketOptionMap.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/DelayedDestruction.h>
@@ -17,6 +19,10 @@ namespace facebook {
 namespace memcache {
 
 namespace {
+
+std::atomic<uint64_t> gOffloadQueueDepth{0};
+std::atomic<uint64_t> gOffloaded{0};
+
 class ConnectHelper : public folly::AsyncSocket::ConnectCallback,
                       public folly::DelayedDestruction {
  public:
@@ -67,6 +73,8 @@ folly::Future<folly::AsyncSocket::UniquePtr> connectSSLSocketWithAuxIO(
     auto* socketEvb = helper->getSocket()->getEventBase();
     auto* poolEvb = auxPool->getThreadPool().getEventBase();
     helper->getSocket()->detachEventBase();
+    gOffloadQueueDepth.fetch_add(1, std::memory_order_relaxed);
+    gOffloaded.fetch_add(1, std::memory_order_relaxed);
     return via(poolEvb)
         .thenValue([opts = std::move(options),
                     addr = std::move(address),
@@ -76,6 +84,9 @@ folly::Future<folly::AsyncSocket::UniquePtr> connectSSLSocketWithAuxIO(
           helper->getSocket()->attachEventBase(poolEvb);
           return helper->connect(addr, timeout, opts);
         })
+        .ensure([]() {
+          gOffloadQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+        })
         .thenValue([](folly::AsyncSocket::UniquePtr sock) {
           sock->detachEventBase();
           return sock;
@@ -91,5 +102,13 @@ folly::Future<folly::AsyncSocket::UniquePtr> connectSSLSocketWithAuxIO(
   }
 }
 
+uint64_t sslHandshakeOffloadQueueDepth() {
+  return gOffloadQueueDepth.load(std::memory_order_relaxed);
+}
+
+uint64_t sslHandshakesOffloaded() {
+  return gOffloaded.load(std::memory_order_relaxed);
+}
+
 } // namespace memcache
 } // namespace facebook
@@ -25,5 +25,17 @@ folly::Future<folly::AsyncSocket::UniquePtr> connectSSLSocketWithAuxIO(
     int timeout,
     folly::SocketOptionMap options);
 
+/**
+ * Number of handshakes passed to connectSSLSocketWithAuxIO() that are queued
+ * on or running in the auxiliary IO thread pool. A depth that keeps growing
+ * means the pool can't keep up (e.g. a reconnect storm).
+ */
+uint64_t sslHandshakeOffloadQueueDepth();
+
+/**
+ * Total number of handshakes run on the auxiliary IO thread pool.
+ */
+uint64_t sslHandshakesOffloaded();
+
 } // namespace memcache
 } // namespace facebook
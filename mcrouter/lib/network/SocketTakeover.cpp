@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SocketTakeover.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include <folly/Format.h>
+#include <folly/ScopeGuard.h>
+#include <folly/String.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+// How long either side waits for the other one during a takeover.
+constexpr std::chrono::seconds kHandOverTimeout{5};
+// Sent with the sockets, so that anything else listening on the path isn't
+// mistaken for an old mcrouter.
+constexpr uint32_t kMagic = 0x6d637274; // "mcrt"
+constexpr char kAck = 'A';
+// Less than SCM_MAX_FD.
+constexpr size_t kMaxSockets = 128;
+
+struct Header {
+  uint32_t magic;
+  uint32_t numSockets;
+};
+
+bool makeUnixAddress(const std::string& path, sockaddr_un& addr) {
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.data(), path.size());
+  return true;
+}
+
+void setTimeouts(int fd, std::chrono::milliseconds timeout) {
+  timeval tv;
+  tv.tv_sec = timeout.count() / 1000;
+  tv.tv_usec = (timeout.count() % 1000) * 1000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+void closeAll(const std::vector<int>& fds) {
+  for (auto fd : fds) {
+    ::close(fd);
+  }
+}
+
+} // namespace
+
+SocketTakeoverServer::SocketTakeoverServer(
+    std::string path,
+    std::function<std::vector<int>()> getSocketFds,
+    std::function<void()> onTakenOver)
+    : path_(std::move(path)),
+      getSocketFds_(std::move(getSocketFds)),
+      onTakenOver_(std::move(onTakenOver)) {
+  sockaddr_un addr;
+  checkLogic(
+      makeUnixAddress(path_, addr), "Takeover path too long: {}", path_);
+  listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  checkLogic(
+      listenFd_ >= 0,
+      "Failed to create takeover socket: {}",
+      folly::errnoStr(errno));
+  // Either left by a previous process whose sockets were taken over before
+  // we started, or by one that didn't shut down cleanly.
+  std::remove(path_.c_str());
+  if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) ||
+      ::listen(listenFd_, 1)) {
+    auto err = errno;
+    ::close(listenFd_);
+    checkLogic(
+        false,
+        "Failed to listen on takeover path {}: {}",
+        path_,
+        folly::errnoStr(err));
+  }
+  thread_ = std::thread([this]() { run(); });
+}
+
+SocketTakeoverServer::~SocketTakeoverServer() {
+  stop();
+}
+
+void SocketTakeoverServer::stop() {
+  if (stopped_.exchange(true)) {
+    return;
+  }
+  // Wakes up the accept() of the takeover thread.
+  ::shutdown(listenFd_, SHUT_RDWR);
+  thread_.join();
+  ::close(listenFd_);
+}
+
+void SocketTakeoverServer::run() {
+  while (!stopped_.load()) {
+    int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (!stopped_.load()) {
+        LOG(ERROR) << "Takeover socket accept failed: "
+                   << folly::errnoStr(errno);
+      }
+      return;
+    }
+    const bool takenOver = handOver(fd);
+    ::close(fd);
+    if (takenOver) {
+      LOG(INFO) << "Listening sockets taken over through " << path_;
+      onTakenOver_();
+      return;
+    }
+  }
+}
+
+bool SocketTakeoverServer::handOver(int fd) {
+  setTimeouts(fd, kHandOverTimeout);
+  auto fds = getSocketFds_();
+  if (fds.empty() || fds.size() > kMaxSockets) {
+    LOG(ERROR) << "Can't hand over " << fds.size() << " listening sockets";
+    return false;
+  }
+
+  Header header{kMagic, static_cast<uint32_t>(fds.size())};
+  iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+  msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+  auto* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+  std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+  if (::sendmsg(fd, &msg, MSG_NOSIGNAL) != sizeof(header)) {
+    LOG(ERROR) << "Failed to send listening sockets for takeover: "
+               << folly::errnoStr(errno);
+    return false;
+  }
+  // Without the ack the new process may have died before using the
+  // sockets, keep serving.
+  char ack = 0;
+  if (::recv(fd, &ack, 1, 0) != 1 || ack != kAck) {
+    LOG(ERROR) << "Takeover of listening sockets not acknowledged";
+    return false;
+  }
+  return true;
+}
+
+folly::Expected<std::vector<int>, std::string> takeOverSockets(
+    const std::string& path,
+    std::chrono::milliseconds timeout) {
+  sockaddr_un addr;
+  if (!makeUnixAddress(path, addr)) {
+    return folly::makeUnexpected(
+        folly::sformat("Takeover path too long: {}", path));
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return folly::makeUnexpected(folly::sformat(
+        "Failed to create takeover socket: {}", folly::errnoStr(errno)));
+  }
+  SCOPE_EXIT {
+    ::close(fd);
+  };
+  setTimeouts(fd, timeout);
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+    if (errno == ENOENT || errno == ECONNREFUSED) {
+      // No process to take over from.
+      return std::vector<int>();
+    }
+    return folly::makeUnexpected(folly::sformat(
+        "Failed to connect to takeover path {}: {}",
+        path,
+        folly::errnoStr(errno)));
+  }
+
+  Header header;
+  iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * kMaxSockets));
+  msghdr msg;
+  std::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+  const auto received = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  if (received < 0) {
+    return folly::makeUnexpected(folly::sformat(
+        "Failed to receive listening sockets: {}", folly::errnoStr(errno)));
+  }
+
+  std::vector<int> fds;
+  for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const auto* data = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+      fds.insert(fds.end(), data, data + n);
+    }
+  }
+  if (received != sizeof(header) || header.magic != kMagic ||
+      (msg.msg_flags & MSG_CTRUNC) || fds.size() != header.numSockets ||
+      fds.empty()) {
+    closeAll(fds);
+    return folly::makeUnexpected(folly::sformat(
+        "Invalid takeover message from {} ({} sockets)", path, fds.size()));
+  }
+
+  if (::send(fd, &kAck, 1, MSG_NOSIGNAL) != 1) {
+    closeAll(fds);
+    return folly::makeUnexpected(folly::sformat(
+        "Failed to acknowledge the takeover: {}", folly::errnoStr(errno)));
+  }
+  return fds;
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Expected.h>
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Hands the listening sockets of a running server over to the process
+ * replacing it, through a Unix domain socket, so that a restart neither
+ * closes the sockets nor drops the connections waiting in their accept
+ * queues.
+ *
+ * The old process runs a SocketTakeoverServer on `path`. The new process
+ * calls takeOverSockets(path) before it starts listening: it receives
+ * duplicates of the listening sockets (SCM_RIGHTS) and acknowledges them.
+ * Once acknowledged, `onTakenOver` is called in the old process, which
+ * should then stop accepting and drain. After that the server stops handing
+ * out sockets.
+ */
+class SocketTakeoverServer {
+ public:
+  /**
+   * @param getSocketFds  called for every takeover request, returns the
+   *                      sockets to hand over. They stay owned by the caller.
+   * @param onTakenOver   called (from the takeover thread) once a new process
+   *                      acknowledged the sockets.
+   *
+   * @throws std::runtime_error  if `path` can't be listened on.
+   */
+  SocketTakeoverServer(
+      std::string path,
+      std::function<std::vector<int>()> getSocketFds,
+      std::function<void()> onTakenOver);
+
+  ~SocketTakeoverServer();
+
+  /**
+   * Stops listening for takeover requests. The Unix socket path is left in
+   * place: once the sockets were taken over it belongs to the new process,
+   * and a stale one is just ignored by takeOverSockets().
+   *
+   * Must not be called from `onTakenOver`.
+   */
+  void stop();
+
+ private:
+  const std::string path_;
+  const std::function<std::vector<int>()> getSocketFds_;
+  const std::function<void()> onTakenOver_;
+  int listenFd_{-1};
+  std::atomic<bool> stopped_{false};
+  std::thread thread_;
+
+  void run();
+  bool handOver(int fd);
+
+  SocketTakeoverServer(const SocketTakeoverServer&) = delete;
+  SocketTakeoverServer& operator=(const SocketTakeoverServer&) = delete;
+};
+
+/**
+ * Takes over the listening sockets of the process running a
+ * SocketTakeoverServer on `path`.
+ *
+ * @return  The received sockets, now owned by the caller. Empty if nobody
+ *          listens on `path` (e.g. first start); an error if the takeover
+ *          was started but failed.
+ */
+folly::Expected<std::vector<int>, std::string> takeOverSockets(
+    const std::string& path,
+    std::chrono::milliseconds timeout);
+
+} // namespace memcache
+} // namespace facebook
@@ -7,9 +7,11 @@
 
 #include "mcrouter/lib/network/SocketUtil.h"
 
+#include <algorithm>
 #include <type_traits>
 
 #include <folly/Expected.h>
+#include <folly/IPAddress.h>
 #include <folly/io/SocketOptionMap.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
@@ -23,6 +25,7 @@
 #include "mcrouter/lib/fbi/cpp/LogFailure.h"
 #include "mcrouter/lib/network/AsyncTlsToPlaintextSocket.h"
 #include "mcrouter/lib/network/ConnectionOptions.h"
+#include "mcrouter/lib/network/HostResolver.h"
 #include "mcrouter/lib/network/McFizzClient.h"
 #include "mcrouter/lib/network/Qos.h"
 #include "mcrouter/lib/network/ThreadLocalSSLContextProvider.h"
@@ -131,7 +134,12 @@ createSocketCommon(
 
   const auto mech = connectionOptions.accessPoint->getSecurityMech();
   if (mech == SecurityMech::NONE) {
-    socket.reset(new AsyncSocketT(&eventBase));
+    auto* asyncSocket = new AsyncSocketT(&eventBase);
+    if (connectionOptions.enableTFO &&
+        !connectionOptions.accessPoint->isUnixDomainSocket()) {
+      asyncSocket->enableTFO();
+    }
+    socket.reset(asyncSocket);
     return socket;
   }
 
@@ -226,17 +234,54 @@ createAsyncSocket(
 
 folly::Expected<folly::SocketAddress, folly::AsyncSocketException>
 getSocketAddress(const ConnectionOptions& connectionOptions) {
+  auto addresses = getSocketAddresses(connectionOptions);
+  if (addresses.hasError()) {
+    return folly::makeUnexpected(std::move(addresses).error());
+  }
+  return std::move(addresses.value().front());
+}
+
+folly::Expected<std::vector<folly::SocketAddress>, folly::AsyncSocketException>
+getSocketAddresses(const ConnectionOptions& connectionOptions) {
   try {
-    folly::SocketAddress address;
+    std::vector<folly::SocketAddress> addresses;
+    const auto& host = connectionOptions.accessPoint->getHost();
+    const auto port = connectionOptions.accessPoint->getPort();
+    // Hostnames are looked up in the resolver cache, not to block on DNS.
+    std::shared_ptr<HostResolver> resolver;
+    if (!connectionOptions.accessPoint->isUnixDomainSocket() &&
+        !folly::IPAddress::validate(host)) {
+      resolver = HostResolver::getInstance();
+    }
     if (connectionOptions.accessPoint->isUnixDomainSocket()) {
-      address.setFromPath(connectionOptions.accessPoint->getHost());
+      addresses.emplace_back();
+      addresses.back().setFromPath(host);
+    } else if (resolver) {
+      auto ips = resolver->lookup(host);
+      if (ips.hasError()) {
+        return folly::makeUnexpected(folly::AsyncSocketException(
+            folly::AsyncSocketException::NOT_OPEN, ips.error()));
+      }
+      // Alternate address families, starting with the preferred one (the
+      // family of the first address), as in RFC 8305 section 4.
+      const auto preferredV6 = ips.value().front().isV6();
+      std::vector<folly::IPAddress> preferred;
+      std::vector<folly::IPAddress> other;
+      for (auto& ip : ips.value()) {
+        (ip.isV6() == preferredV6 ? preferred : other).push_back(ip);
+      }
+      for (size_t i = 0; i < std::max(preferred.size(), other.size()); ++i) {
+        if (i < preferred.size()) {
+          addresses.emplace_back(preferred[i], port);
+        }
+        if (i < other.size()) {
+          addresses.emplace_back(other[i], port);
+        }
+      }
     } else {
-      address = folly::SocketAddress(
-          connectionOptions.accessPoint->getHost(),
-          connectionOptions.accessPoint->getPort(),
-          /* allowNameLookup */ true);
+      addresses.emplace_back(host, port, /* allowNameLookup */ true);
     }
-    return address;
+    return addresses;
   } catch (const std::system_error& e) {
     return folly::makeUnexpected(folly::AsyncSocketException(
         folly::AsyncSocketException::NOT_OPEN,
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <folly/Expected.h>
 #include <folly/Range.h>
 #include <folly/io/SocketOptionMap.h>
@@ -58,6 +60,14 @@ createAsyncSocket(
 folly::Expected<folly::SocketAddress, folly::AsyncSocketException>
 getSocketAddress(const ConnectionOptions& connectionOptions);
 
+/**
+ * Get all the socket addresses of the destination of the given options,
+ * in the order they should be tried. Only destinations configured by
+ * hostname can have more than one.
+ */
+folly::Expected<std::vector<folly::SocketAddress>, folly::AsyncSocketException>
+getSocketAddresses(const ConnectionOptions& connectionOptions);
+
 /**
  * Create the socket options map based on the given ConnectionOptions and
  * SocketAddress.
@@ -7,14 +7,18 @@
 
 #include "ThreadLocalSSLContextProvider.h"
 
+#include <chrono>
+#include <mutex>
 #include <unordered_map>
 
+#include <folly/Indestructible.h>
 #include <folly/Singleton.h>
 #include <folly/hash/Hash.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/io/async/SSLOptions.h>
 #include <folly/portability/OpenSSL.h>
 #include <folly/ssl/Init.h>
+#include <wangle/client/persistence/FilePersistenceLayer.h>
 #include <wangle/client/persistence/SharedMutexCacheLockGuard.h>
 #include <wangle/client/ssl/SSLSessionCacheData.h>
 #include <wangle/client/ssl/SSLSessionPersistentCache.h>
@@ -218,13 +222,42 @@ class SSLTicketCache
   }
 };
 
+struct TicketCacheConfig {
+  std::mutex mutex;
+  size_t capacity{100};
+  std::string persistenceFile;
+  bool created{false};
+};
+
+TicketCacheConfig& ticketCacheConfig() {
+  static folly::Indestructible<TicketCacheConfig> config;
+  return *config;
+}
+
+// Sessions are written to the persistence file at most this often.
+constexpr std::chrono::seconds kTicketCacheSyncInterval{5};
+
 // global thread safe ticket cache
 // TODO(jmswen) Try to come up with a cleaner approach here that doesn't require
 // leaking.
 folly::LeakySingleton<SSLTicketCache> ticketCache([] {
-  // create cache layer of max size 100;
+  auto& config = ticketCacheConfig();
+  std::lock_guard<std::mutex> lock(config.mutex);
+  config.created = true;
+  std::unique_ptr<
+      wangle::CachePersistence<std::string, wangle::SSLSessionCacheData>>
+      persistence;
+  if (!config.persistenceFile.empty()) {
+    persistence = std::make_unique<wangle::FilePersistenceLayer<
+        std::string,
+        wangle::SSLSessionCacheData>>(config.persistenceFile);
+  }
   auto cacheLayer = std::make_shared<TicketCacheLayer>(
-      wangle::PersistentCacheConfig::Builder().setCapacity(100).build());
+      wangle::PersistentCacheConfig::Builder()
+          .setCapacity(config.capacity)
+          .setSyncInterval(kTicketCacheSyncInterval)
+          .build(),
+      std::move(persistence));
   cacheLayer->init();
   return new SSLTicketCache(std::move(cacheLayer));
 });
@@ -438,6 +471,20 @@ ServerContextInfo& getServerContextInfo(
 
 } // namespace
 
+bool configureClientSessionCaches(
+    size_t capacity,
+    std::string persistenceFile) {
+  auto& config = ticketCacheConfig();
+  std::lock_guard<std::mutex> lock(config.mutex);
+  if (config.created) {
+    return false;
+  }
+  config.capacity = capacity;
+  config.persistenceFile = std::move(persistenceFile);
+  setClientPskCacheCapacity(capacity);
+  return true;
+}
+
 bool isAsyncSSLSocketMech(SecurityMech mech) {
   return mech == SecurityMech::TLS || mech == SecurityMech::TLS_TO_PLAINTEXT ||
       mech == SecurityMech::KTLS12;
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 #include <folly/Optional.h>
 #include <folly/Range.h>
@@ -48,6 +49,18 @@ class ClientSSLContext : public folly::SSLContext {
   wangle::SSLSessionCallbacks& cache_;
 };
 
+/**
+ * Configures the session caches shared by all client contexts in the process
+ * (TLS 1.2 tickets and TLS 1.3 PSKs): at most `capacity` entries each.
+ * If `persistenceFile` is not empty, TLS 1.2 sessions are loaded from it when
+ * the cache is created and written back to it periodically, so that they
+ * survive restarts.
+ * Must be called before the first client context is created.
+ *
+ * @return  false if the caches were already created (nothing is changed).
+ */
+bool configureClientSessionCaches(size_t capacity, std::string persistenceFile);
+
 /**
  * The following methods return thread local managed SSL Contexts.  Contexts are
  * reloaded on demand if they are 30 minutes old on a per thread basis.
@@ -26,6 +26,7 @@ std::optional<ThriftClient> ThriftTransportBase::createThriftClient() {
   if (!channel_) {
     return std::nullopt;
   }
+  onChannelCreated();
   client = ThriftClient(channel_);
   // Avoid any static default-registered event handlers.
   client->clearEventHandlers();
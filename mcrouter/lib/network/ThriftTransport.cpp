@@ -7,6 +7,11 @@
 
 #include "mcrouter/lib/network/ThriftTransport.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <folly/container/F14Map.h>
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
@@ -30,13 +35,166 @@ using folly::AsyncSocket;
 namespace facebook {
 namespace memcache {
 
+class ThriftTransportBase::SharedChannel
+    : public folly::AsyncSocket::ConnectCallback,
+      public apache::thrift::CloseCallback {
+ public:
+  /**
+   * @return  The live shared channel for transport's destination, creating
+   *          one if needed. nullptr if the channel couldn't be created.
+   */
+  static std::shared_ptr<SharedChannel> get(ThriftTransportBase& transport) {
+    auto key = folly::to<std::string>(
+        reinterpret_cast<uintptr_t>(&transport.eventBase_),
+        "|",
+        transport.connectionOptions_.accessPoint->toString(),
+        "|",
+        transport.connectionOptions_.connectTimeout.count(),
+        "|",
+        transport.connectionOptions_.thriftCompression,
+        "|",
+        transport.connectionOptions_.thriftCompressionThreshold);
+    auto& channels = registry();
+    auto it = channels.find(key);
+    if (it != channels.end()) {
+      if (auto shared = it->second.lock()) {
+        return shared;
+      }
+      channels.erase(it);
+    }
+
+    auto shared = std::make_shared<SharedChannel>(key);
+    shared->channel_ = transport.createOwnChannel(*shared, *shared);
+    if (!shared->channel_) {
+      return nullptr;
+    }
+    channels.emplace(std::move(key), shared);
+    return shared;
+  }
+
+  explicit SharedChannel(std::string key) : key_(std::move(key)) {}
+
+  ~SharedChannel() override {
+    if (channel_) {
+      channel_->setCloseCallback(nullptr);
+    }
+  }
+
+  const std::shared_ptr<apache::thrift::RocketClientChannel>& channel() const {
+    return channel_;
+  }
+
+  bool connected() const {
+    return connected_;
+  }
+
+  void subscribe(ThriftTransportBase& transport) {
+    if (std::find(users_.begin(), users_.end(), &transport) == users_.end()) {
+      users_.push_back(&transport);
+    }
+  }
+
+  void unsubscribe(ThriftTransportBase& transport) {
+    users_.erase(
+        std::remove(users_.begin(), users_.end(), &transport), users_.end());
+    // resetClient() of the leaving transport clears the close callback.
+    if (channel_ && !closed_) {
+      channel_->setCloseCallback(this);
+    }
+  }
+
+ private:
+  const std::string key_;
+  std::shared_ptr<apache::thrift::RocketClientChannel> channel_;
+  std::vector<ThriftTransportBase*> users_;
+  bool connected_{false};
+  bool closed_{false};
+
+  static folly::F14FastMap<std::string, std::weak_ptr<SharedChannel>>&
+  registry() {
+    static thread_local folly::
+        F14FastMap<std::string, std::weak_ptr<SharedChannel>>
+            channels;
+    return channels;
+  }
+
+  void connectSuccess() noexcept override {
+    connected_ = true;
+    auto users = users_;
+    for (auto* transport : users) {
+      if (transport->connectionState_ == ConnectionState::Connecting) {
+        transport->connectSuccess();
+      }
+    }
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    forget();
+    auto users = users_;
+    for (auto* transport : users) {
+      if (transport->connectionState_ == ConnectionState::Connecting) {
+        transport->connectErr(ex);
+      }
+    }
+  }
+
+  void channelClosed() override {
+    forget();
+    auto users = users_;
+    for (auto* transport : users) {
+      transport->channelClosed();
+    }
+  }
+
+  // New transports have to open a new channel from now on.
+  void forget() {
+    closed_ = true;
+    auto& channels = registry();
+    auto it = channels.find(key_);
+    if (it != channels.end() && it->second.lock().get() == this) {
+      channels.erase(it);
+    }
+  }
+};
+
 ThriftTransportBase::ThriftTransportBase(
     folly::EventBase& eventBase,
     ConnectionOptions options)
     : eventBase_(eventBase), connectionOptions_(std::move(options)) {}
 
+ThriftTransportBase::~ThriftTransportBase() {
+  leaveSharedChannel();
+}
+
 void ThriftTransportBase::closeNow() {
   resetClient();
+  if (sharedChannel_) {
+    // Other transports may still use the channel.
+    leaveSharedChannel();
+    channel_.reset();
+    connectionState_ = ConnectionState::Down;
+  }
+}
+
+void ThriftTransportBase::leaveSharedChannel() {
+  if (auto shared = std::move(sharedChannel_)) {
+    shared->unsubscribe(*this);
+  }
+}
+
+void ThriftTransportBase::onChannelCreated() {
+  if (!sharedChannel_ || !sharedChannel_->connected()) {
+    return;
+  }
+  // Report the connection as up from the event loop, like for a channel
+  // of our own, once the client is fully set up.
+  eventBase_.runInLoop(
+      [this, dg = DestructorGuard(this), shared = sharedChannel_]() {
+        if (sharedChannel_ == shared &&
+            connectionState_ == ConnectionState::Connecting) {
+          connectSuccess();
+        }
+      });
 }
 
 void ThriftTransportBase::setConnectionStatusCallbacks(
@@ -81,9 +239,10 @@ double ThriftTransportBase::getRetransmitsPerKb() {
 }
 
 folly::AsyncTransportWrapper::UniquePtr
-ThriftTransportBase::getConnectingSocket() {
+ThriftTransportBase::getConnectingSocket(
+    folly::AsyncSocket::ConnectCallback& connectCallback) {
   return folly::fibers::runInMainContext(
-      [this]() -> folly::AsyncTransportWrapper::UniquePtr {
+      [this, &connectCallback]() -> folly::AsyncTransportWrapper::UniquePtr {
         auto expectedSocket = createAsyncSocket(eventBase_, connectionOptions_);
         if (expectedSocket.hasError()) {
           LOG_FAILURE(
@@ -114,14 +273,14 @@ ThriftTransportBase::getConnectingSocket() {
         if (securityMech == SecurityMech::TLS_TO_PLAINTEXT) {
           socket->setSendTimeout(connectionOptions_.writeTimeout.count());
           socket->getUnderlyingTransport<AsyncTlsToPlaintextSocket>()->connect(
-              this,
+              &connectCallback,
               address,
               connectionOptions_.connectTimeout,
               std::move(socketOptions));
         } else if (securityMech == SecurityMech::TLS) {
           socket->setSendTimeout(connectionOptions_.writeTimeout.count());
           socket->getUnderlyingTransport<folly::AsyncSSLSocket>()->connect(
-              this,
+              &connectCallback,
               address,
               connectionOptions_.connectTimeout.count(),
               socketOptions);
@@ -129,7 +288,7 @@ ThriftTransportBase::getConnectingSocket() {
           auto fizzClient = socket->getUnderlyingTransport<McFizzClient>();
           fizzClient->setSendTimeout(connectionOptions_.writeTimeout.count());
           fizzClient->connect(
-              this,
+              &connectCallback,
               address,
               connectionOptions_.connectTimeout.count(),
               socketOptions);
@@ -137,7 +296,7 @@ ThriftTransportBase::getConnectingSocket() {
           DCHECK(securityMech == SecurityMech::NONE);
           socket->setSendTimeout(connectionOptions_.writeTimeout.count());
           socket->getUnderlyingTransport<folly::AsyncSocket>()->connect(
-              this,
+              &connectCallback,
               address,
               connectionOptions_.connectTimeout.count(),
               socketOptions);
@@ -146,7 +305,28 @@ ThriftTransportBase::getConnectingSocket() {
       });
 }
 
-apache::thrift::RocketClientChannel::Ptr ThriftTransportBase::createChannel() {
+std::shared_ptr<apache::thrift::RocketClientChannel>
+ThriftTransportBase::createChannel() {
+  if (!connectionOptions_.thriftShareChannel) {
+    return createOwnChannel(*this, *this);
+  }
+
+  auto shared = SharedChannel::get(*this);
+  if (!shared) {
+    return nullptr;
+  }
+  if (shared != sharedChannel_) {
+    leaveSharedChannel();
+    sharedChannel_ = shared;
+  }
+  shared->subscribe(*this);
+  connectionState_ = ConnectionState::Connecting;
+  return shared->channel();
+}
+
+apache::thrift::RocketClientChannel::Ptr ThriftTransportBase::createOwnChannel(
+    folly::AsyncSocket::ConnectCallback& connectCallback,
+    apache::thrift::CloseCallback& closeCallback) {
   // HHVM supports Debian 8 (EOL 2020-06-30), which includes OpenSSL 1.0.1;
   // Rocket/RSocket require ALPN, which requiers 1.0.2.
   //
@@ -154,13 +334,13 @@ apache::thrift::RocketClientChannel::Ptr ThriftTransportBase::createChannel() {
   // Thrift transport, but continue to permit use as an async Memcache client
   // library for Hack
 #ifndef MCROUTER_NOOP_THRIFT_CLIENT
-  auto socket = getConnectingSocket();
+  auto socket = getConnectingSocket(connectCallback);
   if (!socket) {
     return nullptr;
   }
   auto channel =
       apache::thrift::RocketClientChannel::newChannel(std::move(socket));
-  channel->setCloseCallback(this);
+  channel->setCloseCallback(&closeCallback);
   if (connectionOptions_.thriftCompression) {
     apache::thrift::CodecConfig codec;
     codec.zstdConfig_ref() = apache::thrift::ZstdCompressionCodecConfig();
@@ -175,6 +355,8 @@ apache::thrift::RocketClientChannel::Ptr ThriftTransportBase::createChannel() {
 
   return channel;
 #else
+  (void)connectCallback;
+  (void)closeCallback;
   return nullptr;
 #endif
 }
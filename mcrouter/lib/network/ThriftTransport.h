@@ -39,7 +39,7 @@ class ThriftTransportBase : public Transport,
                             private apache::thrift::CloseCallback {
  public:
   ThriftTransportBase(folly::EventBase& eventBase, ConnectionOptions options);
-  virtual ~ThriftTransportBase() override = default;
+  virtual ~ThriftTransportBase() override;
 
   static constexpr folly::StringPiece name() {
     return "ThriftTransport";
@@ -108,6 +108,15 @@ class ThriftTransportBase : public Transport,
       const folly::exception_wrapper& ew);
 
  private:
+  /**
+   * Rocket channel shared by all transports to the same destination on the
+   * same event base (ConnectionOptions::thriftShareChannel). Forwards
+   * connection events to every transport using it.
+   */
+  class SharedChannel;
+
+  std::shared_ptr<SharedChannel> sharedChannel_;
+
   // AsyncSocket::ConnectCallback overrides
   void connectSuccess() noexcept final;
   void connectErr(const folly::AsyncSocketException& ex) noexcept final;
@@ -116,17 +125,37 @@ class ThriftTransportBase : public Transport,
   void channelClosed() override final;
 
   /**
-   * Create a channel and trigger connection opening.
+   * Create a channel and trigger connection opening, or join the shared
+   * channel of this destination.
    * Returns either a valid RocketClientChannel, or nullptr in case of error.
    */
-  apache::thrift::RocketClientChannel::Ptr createChannel();
+  std::shared_ptr<apache::thrift::RocketClientChannel> createChannel();
+
+  /**
+   * Create a channel of our own and trigger connection opening.
+   */
+  apache::thrift::RocketClientChannel::Ptr createOwnChannel(
+      folly::AsyncSocket::ConnectCallback& connectCallback,
+      apache::thrift::CloseCallback& closeCallback);
+
+  /**
+   * Called once channel_ is set. If we joined a shared channel that is
+   * already connected, there won't be a connectSuccess() for us.
+   */
+  void onChannelCreated();
+
+  /**
+   * Stops using the shared channel (if any), without closing it.
+   */
+  void leaveSharedChannel();
 
   /**
    * Creates a new socket and initiates a connection.
    * Returns either valid connection (or possibly connected) socket, or nullptr
    * in case of error.
    */
-  folly::AsyncTransportWrapper::UniquePtr getConnectingSocket();
+  folly::AsyncTransportWrapper::UniquePtr getConnectingSocket(
+      folly::AsyncSocket::ConnectCallback& connectCallback);
 };
 
 template <class RouterInfo>
@@ -63,6 +63,19 @@ class Transport : public folly::DelayedDestruction {
       folly::EventBase::LoopCallback,
       boost::intrusive::constant_time_size<false>>;
 
+  /**
+   * Kernel view of the connection, sampled from TCP_INFO.
+   */
+  struct TcpInfo {
+    // Smoothed round trip time and its mean deviation, in us.
+    uint32_t rttUs{0};
+    uint32_t rttVarUs{0};
+    // Retransmits over the lifetime of the connection.
+    uint32_t totalRetrans{0};
+    // Incremented on every sample; 0 if the connection was never sampled.
+    uint64_t numSamples{0};
+  };
+
   using SvcIdentAuthCallbackFunc = std::function<
       bool(const folly::AsyncTransport&, const ConnectionOptions&)>;
 
@@ -101,7 +114,7 @@ class Transport : public folly::DelayedDestruction {
     /**
      * Will be called everytime AsyncMcClient is about to write data to network.
      * The numToSend argument holds the number of requests that will be sent in
-     * a single batch.
+     * a single batch (i.e. a single writev()).
      */
     std::function<void(size_t numToSend)> onWrite;
 
@@ -222,6 +235,14 @@ class Transport : public folly::DelayedDestruction {
    */
   virtual double getRetransmitsPerKb() = 0;
 
+  /**
+   * Latest TCP_INFO sample of this connection, if the transport samples it
+   * (see ConnectionOptions::tcpInfoSamplePeriod).
+   */
+  virtual TcpInfo getTcpInfo() const {
+    return TcpInfo();
+  }
+
   /**
    * Set external queue for managing flush callbacks.
    * By default we'll use EventBase as a manager of these callbacks.
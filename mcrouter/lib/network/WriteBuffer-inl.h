@@ -26,7 +26,8 @@ WriteBuffer::prepareTyped(
     Destructor destructor,
     const CompressionCodecMap* compressionCodecMap,
     const CodecIdRange& codecIdRange,
-    size_t tcpZeroCopyThreshold) {
+    size_t tcpZeroCopyThreshold,
+    bool compactCaretHeader) {
   ctx_.emplace(std::move(ctx));
   assert(!destructor_.hasValue());
   if (destructor) {
@@ -35,15 +36,16 @@ WriteBuffer::prepareTyped(
 
   typeId_ = static_cast<uint32_t>(Reply::typeId);
 
-  // The current congestion control only supports mc_caret_protocol.
-  // May extend to other protocals in the future.
   switch (protocol_) {
     case mc_ascii_protocol:
+      asciiReply_.setTCPZeroCopyThreshold(tcpZeroCopyThreshold);
+      asciiReply_.setMeta(ctx_->asciiMetaFlags());
       return asciiReply_.prepare(
           std::move(reply), ctx_->asciiKey(), iovsBegin_, iovsCount_);
 
     case mc_caret_protocol:
       caretReply_.setTCPZeroCopyThreshold(tcpZeroCopyThreshold);
+      caretReply_.setCompactHeader(compactCaretHeader);
       return caretReply_.prepare(
           std::move(reply),
           ctx_->reqid_,
@@ -71,7 +73,8 @@ WriteBuffer::prepareTyped(
     Destructor destructor,
     const CompressionCodecMap* compressionCodecMap,
     const CodecIdRange& codecIdRange,
-    size_t tcpZeroCopyThreshold) {
+    size_t tcpZeroCopyThreshold,
+    bool compactCaretHeader) {
   assert(protocol_ == mc_caret_protocol);
   ctx_.emplace(std::move(ctx));
   assert(!destructor_.hasValue());
@@ -82,6 +85,7 @@ WriteBuffer::prepareTyped(
   typeId_ = static_cast<uint32_t>(Reply::typeId);
 
   caretReply_.setTCPZeroCopyThreshold(tcpZeroCopyThreshold);
+  caretReply_.setCompactHeader(compactCaretHeader);
 
   return caretReply_.prepare(
       std::move(reply),
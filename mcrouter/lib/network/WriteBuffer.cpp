@@ -5,8 +5,11 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+
 #include <folly/Conv.h>
 #include <folly/String.h>
+#include <folly/ThreadCachedInt.h>
 
 #include "mcrouter/lib/IOBufUtil.h"
 #include "mcrouter/lib/mc/protocol.h"
@@ -75,17 +78,85 @@ bool WriteBuffer::isSubRequest() const {
   return ctx_.has_value() && (ctx_->hasParent() || ctx_->isEndContext());
 }
 
+bool WriteBuffer::isStreamedSubReply(uint64_t headReqid) const {
+  return ctx_.has_value() && ctx_->hasParent() &&
+      ctx_->parent().streaming() && ctx_->parent().blockReqid() < headReqid;
+}
+
 bool WriteBuffer::isEndContext() const {
   return ctx_.has_value() ? ctx_->isEndContext() : false;
 }
 
-WriteBuffer::List& WriteBufferQueue::initFreeStack(
+namespace {
+
+struct PoolCounters {
+  folly::ThreadCachedInt<uint64_t> hits;
+  folly::ThreadCachedInt<uint64_t> misses;
+  folly::ThreadCachedInt<uint64_t> trimmed;
+};
+
+PoolCounters& poolCounters() {
+  static auto* counters = new PoolCounters();
+  return *counters;
+}
+
+} // namespace
+
+std::unique_ptr<WriteBuffer> WriteBufferQueue::FreeStack::get(
+    mc_protocol_t protocol) {
+  if (buffers_.empty()) {
+    poolCounters().misses.increment();
+    lowWater_ = 0;
+    return std::make_unique<WriteBuffer>(protocol);
+  }
+  poolCounters().hits.increment();
+  auto wb = buffers_.popFront();
+  lowWater_ = std::min(lowWater_, buffers_.size());
+  return wb;
+}
+
+bool WriteBufferQueue::FreeStack::recycle(std::unique_ptr<WriteBuffer> wb) {
+  const bool endOfBatch = wb->isEndOfBatch();
+  if (buffers_.size() < kMaxFreeQueueSz) {
+    buffers_.pushFront(std::move(wb)).clear();
+  }
+  if (++sinceTrim_ >= kTrimInterval) {
+    trim();
+  }
+  return endOfBatch;
+}
+
+void WriteBufferQueue::FreeStack::trim() {
+  const size_t excess = lowWater_ / 2;
+  for (size_t i = 0; i < excess; ++i) {
+    buffers_.popBack();
+  }
+  if (excess > 0) {
+    poolCounters().trimmed.increment(excess);
+  }
+  lowWater_ = buffers_.size();
+  sinceTrim_ = 0;
+}
+
+WriteBufferQueue::FreeStack& WriteBufferQueue::initFreeStack(
     mc_protocol_t protocol) noexcept {
   assert(protocol == mc_ascii_protocol || protocol == mc_caret_protocol);
 
-  static thread_local WriteBuffer::List freeBuffers[mc_nprotocols];
+  static thread_local FreeStack freeBuffers[mc_nprotocols];
   return freeBuffers[static_cast<size_t>(protocol)];
 }
 
+uint64_t WriteBufferQueue::poolHits() {
+  return poolCounters().hits.readFull();
+}
+
+uint64_t WriteBufferQueue::poolMisses() {
+  return poolCounters().misses.readFull();
+}
+
+uint64_t WriteBufferQueue::poolTrimmed() {
+  return poolCounters().trimmed.readFull();
+}
+
 } // namespace memcache
 } // namespace facebook
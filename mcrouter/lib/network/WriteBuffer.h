@@ -49,6 +49,8 @@ class WriteBuffer {
    * @param destructor  Callback to destruct data used by this reply, called
    *                    when this WriteBuffer is cleared for reuse, or is
    *                    destroyed
+   * @param compactCaretHeader  Serialize caret replies with the compact
+   *                            header.
    *
    * @return true On success
    */
@@ -64,7 +66,8 @@ class WriteBuffer {
       Destructor destructor,
       const CompressionCodecMap* compressionCodecMap,
       const CodecIdRange& codecIdRange,
-      size_t tcpZeroCopyThreshold = 0);
+      size_t tcpZeroCopyThreshold = 0,
+      bool compactCaretHeader = false);
 
   template <class Reply>
   typename std::enable_if<
@@ -78,7 +81,8 @@ class WriteBuffer {
       Destructor destructor,
       const CompressionCodecMap* compressionCodecMap,
       const CodecIdRange& codecIdRange,
-      size_t tcpZeroCopyThreshold = 0);
+      size_t tcpZeroCopyThreshold = 0,
+      bool compactCaretHeader = false);
 
   const struct iovec* getIovsBegin() const {
     return iovsBegin_;
@@ -101,6 +105,15 @@ class WriteBuffer {
   bool isSubRequest() const;
   bool isEndContext() const;
 
+  /**
+   * @return true  iff this is the reply to a key of a streaming multi-get
+   *               (see AsyncMcServerWorkerOptions::asciiMultigetStreaming)
+   *               whose replies may be written now, i.e. all the replies
+   *               before the multi-get were written (the next one to write
+   *               is headReqid).
+   */
+  bool isStreamedSubReply(uint64_t headReqid) const;
+
   bool isEndOfBatch() const {
     return isEndOfBatch_;
   }
@@ -113,12 +126,15 @@ class WriteBuffer {
     return typeId_;
   }
 
-  /* TCP Zero copy only supported for caret */
   bool shouldApplyZeroCopy() {
-    if (protocol_ == mc_caret_protocol) {
-      return caretReply_.shouldApplyZeroCopy();
+    switch (protocol_) {
+      case mc_ascii_protocol:
+        return asciiReply_.shouldApplyZeroCopy();
+      case mc_caret_protocol:
+        return caretReply_.shouldApplyZeroCopy();
+      default:
+        return false;
     }
-    return false;
   }
 
   void setZeroCopyPendingNotifications(size_t num) {
@@ -161,11 +177,7 @@ class WriteBufferQueue {
     assert(
         tlFreeStack_ == &initFreeStack(protocol) &&
         "protocol changed or called from a different thread");
-    if (tlFreeStack_->empty()) {
-      return std::make_unique<WriteBuffer>(protocol);
-    } else {
-      return tlFreeStack_->popFront();
-    }
+    return tlFreeStack_->get(protocol);
   }
 
   void push(std::unique_ptr<WriteBuffer> wb) {
@@ -178,13 +190,7 @@ class WriteBufferQueue {
     bool done = false;
     do {
       assert(!empty());
-      if (tlFreeStack_->size() < kMaxFreeQueueSz) {
-        auto& wb = tlFreeStack_->pushFront(queue_.popFront());
-        done = wb.isEndOfBatch();
-        wb.clear();
-      } else {
-        done = queue_.popFront()->isEndOfBatch();
-      }
+      done = tlFreeStack_->recycle(queue_.popFront());
     } while (!done && popBatch);
   }
 
@@ -198,14 +204,8 @@ class WriteBufferQueue {
     bool done = false;
     do {
       assert(!zeroCopyQueue_.empty());
-      if (tlFreeStack_->size() < kMaxFreeQueueSz) {
-        auto& wb = tlFreeStack_->pushFront(
-            zeroCopyQueue_.extractAndAdvanceIterator(it));
-        done = wb.isEndOfBatch();
-        wb.clear();
-      } else {
-        done = zeroCopyQueue_.extractAndAdvanceIterator(it)->isEndOfBatch();
-      }
+      done =
+          tlFreeStack_->recycle(zeroCopyQueue_.extractAndAdvanceIterator(it));
     } while (!done && batch);
   }
 
@@ -217,14 +217,46 @@ class WriteBufferQueue {
     return zeroCopyQueue_.size();
   }
 
+  /**
+   * Process wide WriteBuffer recycling counters, summed over all threads.
+   */
+  static uint64_t poolHits();
+  static uint64_t poolMisses();
+  static uint64_t poolTrimmed();
+
  private:
   constexpr static size_t kMaxFreeQueueSz = 50;
+  // Number of recycled buffers between two trims of a free stack.
+  constexpr static size_t kTrimInterval = 1024;
+
+  /**
+   * Thread local stack of idle WriteBuffers for one protocol.
+   *
+   * Tracks the lowest size the stack reached since the last trim: that many
+   * buffers sat idle for the whole interval, so half of them are released
+   * on each trim. This makes the pool follow the high-water mark of buffers
+   * actually in flight instead of staying at kMaxFreeQueueSz forever.
+   */
+  class FreeStack {
+   public:
+    std::unique_ptr<WriteBuffer> get(mc_protocol_t protocol);
+
+    // Returns true if the buffer was the end of a batch.
+    bool recycle(std::unique_ptr<WriteBuffer> wb);
+
+   private:
+    WriteBuffer::List buffers_;
+    size_t lowWater_{0};
+    size_t sinceTrim_{0};
+
+    void trim();
+  };
 
-  WriteBuffer::List* tlFreeStack_{nullptr};
+  FreeStack* tlFreeStack_{nullptr};
   WriteBuffer::List queue_;
   WriteBuffer::List zeroCopyQueue_;
 
-  static WriteBuffer::List& initFreeStack(mc_protocol_t protocol) noexcept;
+  static FreeStack& initFreeStack(mc_protocol_t protocol) noexcept;
 
   WriteBufferQueue(const WriteBufferQueue&) = delete;
   WriteBufferQueue& operator=(const WriteBufferQueue&) = delete;
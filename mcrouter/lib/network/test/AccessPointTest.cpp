@@ -172,4 +172,24 @@ TEST(AccessPoint, port_override) {
   EXPECT_TRUE(ap->useSsl());
 }
 
+TEST(AccessPoint, HostId) {
+  auto ap1 = AccessPoint::create("127.0.0.1:12345", mc_caret_protocol);
+  auto ap2 = AccessPoint::create("127.0.0.1:11111:ascii", mc_caret_protocol);
+  auto ap3 = AccessPoint::create("127.0.0.2:12345", mc_caret_protocol);
+  auto ap4 = AccessPoint::create("[::1]:12345", mc_caret_protocol);
+  auto ap5 = AccessPoint::create(
+      "[0000:0000:0000:0000:0000:0000:0000:0001]:1", mc_caret_protocol);
+
+  EXPECT_EQ(ap1->getHostId(), ap2->getHostId());
+  EXPECT_EQ(&ap1->getHost(), &ap2->getHost());
+  EXPECT_NE(ap1->getHostId(), ap3->getHostId());
+  EXPECT_NE(ap1->getHostId(), ap4->getHostId());
+  // Same address, written differently.
+  EXPECT_EQ(ap4->getHostId(), ap5->getHostId());
+
+  AccessPoint copy = *ap3;
+  EXPECT_EQ(ap3->getHostId(), copy.getHostId());
+  EXPECT_EQ("127.0.0.2", copy.getHost());
+}
+
 } // namespace
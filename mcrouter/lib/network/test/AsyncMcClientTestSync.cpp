@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -903,6 +904,95 @@ TEST(AsyncMcClient, caretGoAway) {
   server->join();
 }
 
+TEST(AsyncMcClient, cancelledPendingRequests) {
+  TestServer::Config config;
+  config.useSsl = false;
+  auto server = TestServer::create(std::move(config));
+  folly::EventBase evb;
+  auto lc = std::make_unique<folly::fibers::EventBaseLoopController>();
+  lc->attachEventBase(evb);
+  folly::fibers::FiberManager fm(std::move(lc));
+  ConnectionOptions opts("::1", server->getListenPort(), mc_caret_protocol);
+  auto client = std::make_unique<AsyncMcClient>(evb, opts);
+
+  std::atomic<bool> cancelled{false};
+  carbon::Result sentResult = carbon::Result::UNKNOWN;
+  carbon::Result cancelledResult = carbon::Result::UNKNOWN;
+  int numDone = 0;
+  auto onDone = [&]() {
+    if (++numDone == 2) {
+      client->closeNow();
+    }
+  };
+  fm.addTask([&]() {
+    McGetRequest req("test");
+    auto reply = client->sendSync(req, std::chrono::milliseconds(200));
+    sentResult = *reply.result_ref();
+    onDone();
+  });
+  fm.addTask([&]() {
+    McGetRequest req("test");
+    auto reply = client->sendSync(
+        req, std::chrono::milliseconds(200), nullptr, &cancelled);
+    cancelledResult = *reply.result_ref();
+    onDone();
+  });
+  // Both requests wait in the pending queue until the client is connected.
+  evb.loopOnce();
+  cancelled = true;
+  evb.loop();
+
+  EXPECT_EQ(carbon::Result::FOUND, sentResult);
+  EXPECT_EQ(carbon::Result::ABORTED, cancelledResult);
+  server->shutdown();
+  server->join();
+}
+
+TEST(AsyncMcClient, expirePendingRequests) {
+  TestServer::Config config;
+  config.useSsl = false;
+  auto server = TestServer::create(std::move(config));
+  folly::EventBase evb;
+  auto lc = std::make_unique<folly::fibers::EventBaseLoopController>();
+  lc->attachEventBase(evb);
+  folly::fibers::FiberManager fm(std::move(lc));
+  ConnectionOptions opts("::1", server->getListenPort(), mc_caret_protocol);
+  opts.expirePendingRequests = true;
+  auto client = std::make_unique<AsyncMcClient>(evb, opts);
+  client->setThrottle(1, 10);
+
+  carbon::Result sleepResult = carbon::Result::UNKNOWN;
+  carbon::Result queuedResult = carbon::Result::UNKNOWN;
+  RpcStatsContext queuedRpcContext;
+  int numDone = 0;
+  auto onDone = [&]() {
+    if (++numDone == 2) {
+      client->closeNow();
+    }
+  };
+  fm.addTask([&]() {
+    // Keeps the only inflight slot busy for a second.
+    McGetRequest req("sleep");
+    auto reply = client->sendSync(req, std::chrono::milliseconds(2000));
+    sleepResult = *reply.result_ref();
+    onDone();
+  });
+  fm.addTask([&]() {
+    McGetRequest req("test");
+    auto reply = client->sendSync(
+        req, std::chrono::milliseconds(100), &queuedRpcContext);
+    queuedResult = *reply.result_ref();
+    onDone();
+  });
+  evb.loop();
+
+  EXPECT_EQ(carbon::Result::NOTFOUND, sleepResult);
+  EXPECT_EQ(carbon::Result::TIMEOUT, queuedResult);
+  EXPECT_TRUE(queuedRpcContext.notSent);
+  server->shutdown();
+  server->join();
+}
+
 TEST(AsyncMcClient, contextProviders) {
   auto clientCtxPaths = validClientSsl();
   auto serverCtxPaths = validSsl();
@@ -238,6 +238,25 @@ TEST(AsyncMcServer, tcpZeroCopyEnabled) {
   EXPECT_EQ(1, server->getAcceptedConns());
 }
 
+TEST(AsyncMcServer, tcpZeroCopyAsciiEnabled) {
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.tcpZeroCopyThresholdBytes = 12000;
+  config.useSsl = false;
+  auto server = TestServer::create(std::move(config));
+  TestClient client(
+      "localhost", server->getListenPort(), 10000, mc_ascii_protocol);
+  // Below and above the zero copy threshold.
+  client.sendGet("value_size:100", carbon::Result::FOUND);
+  client.sendGet("value_size:65536", carbon::Result::FOUND, 1000);
+  client.sendGet("value_size:1048576", carbon::Result::FOUND, 1000);
+  client.waitForReplies();
+  client.sendGet("shutdown", carbon::Result::NOTFOUND);
+  client.waitForReplies();
+  server->join();
+  EXPECT_EQ(1, server->getAcceptedConns());
+}
+
 TEST(AsyncMcServer, tcpZeroCopySSLEnabled) {
   McSSLUtil::setApplicationSSLVerifier(
       [](folly::AsyncSSLSocket*, bool, X509_STORE_CTX*) noexcept {
@@ -16,6 +16,7 @@
 #include <folly/io/IOBuf.h>
 
 #include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/network/CaretProtocol.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/lib/network/test/gen/CarbonTestMessages.h"
@@ -248,3 +249,64 @@ TEST(CarbonQueueAppender, manyFields) {
   EXPECT_STREQ(
       str2, reinterpret_cast<const char*>(manyFields2.buf40_ref()->data()));
 }
+
+TEST(CarbonQueueAppender, smallMessageSingleIovec) {
+  carbon::CarbonQueueAppenderStorage storage;
+  McSetRequest req("some:key");
+  // Bigger than the 128B always copied, but the message fits into the 512B
+  // embedded storage.
+  const std::string value(300, 'v');
+  auto valueBuf = folly::IOBuf::copyBuffer(value.data(), 100);
+  valueBuf->appendChain(
+      folly::IOBuf::copyBuffer(value.data() + 100, value.size() - 100));
+  req.value_ref() = std::move(*valueBuf);
+
+  carbon::CarbonProtocolWriter writer(storage);
+  req.serialize(writer);
+
+  CaretMessageInfo info;
+  info.bodySize = storage.computeBodySize();
+  info.typeId = McSetRequest::typeId;
+  info.reqId = 1;
+  size_t headerSize =
+      caretPrepareHeader(info, reinterpret_cast<char*>(storage.getHeaderBuf()));
+  storage.reportHeaderSize(headerSize);
+
+  const auto iovs = storage.getIovecs();
+  ASSERT_EQ(1, iovs.second);
+  EXPECT_EQ(headerSize + info.bodySize, iovs.first[0].iov_len);
+
+  auto input = folly::IOBuf::wrapBuffer(
+      static_cast<const uint8_t*>(iovs.first[0].iov_base) + headerSize,
+      info.bodySize);
+  carbon::CarbonProtocolReader reader(folly::io::Cursor(input.get()));
+  McSetRequest inputReq;
+  inputReq.deserialize(reader);
+  EXPECT_EQ("some:key", inputReq.key_ref()->fullKey());
+  EXPECT_EQ(value, carbon::valueRangeSlow(inputReq));
+}
+
+TEST(CarbonQueueAppenderStoragePool, reuse) {
+  using Pool = carbon::CarbonQueueAppenderStoragePool;
+
+  auto buf = Pool::get(2000);
+  EXPECT_GE(buf->capacity(), 2048);
+  auto data = buf->data();
+  buf->append(100);
+  Pool::put(std::move(buf));
+
+  // Same size class, should get the cached buffer back, emptied.
+  const auto hits = Pool::hits();
+  auto reused = Pool::get(1500);
+  EXPECT_EQ(hits + 1, Pool::hits());
+  EXPECT_EQ(data, reused->data());
+  EXPECT_EQ(0, reused->length());
+
+  // Shared buffers must not be recycled.
+  auto clone = reused->clone();
+  Pool::put(std::move(reused));
+  const auto misses = Pool::misses();
+  auto fresh = Pool::get(1500);
+  EXPECT_EQ(misses + 1, Pool::misses());
+  EXPECT_NE(clone->data(), fresh->data());
+}
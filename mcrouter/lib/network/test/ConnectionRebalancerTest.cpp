@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/ConnectionRebalancer.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+ConnectionRebalancerOptions testOptions() {
+  ConnectionRebalancerOptions opts;
+  opts.interval = std::chrono::milliseconds(100);
+  opts.minImbalance = 0.2;
+  opts.hotIntervals = 2;
+  opts.maxConnsPerInterval = 3;
+  return opts;
+}
+
+} // namespace
+
+TEST(ConnectionRebalancer, movesConnectionsFromPersistentlyHotWorker) {
+  ConnectionRebalancer rebalancer(testOptions(), 2);
+  auto hot = rebalancer.addWorker();
+  auto cool = rebalancer.addWorker();
+
+  // The only worker that reported so far has nothing to compare with.
+  EXPECT_EQ(0, rebalancer.update(hot, 0.9));
+  EXPECT_EQ(0, rebalancer.update(cool, 0.4));
+  // Hot for one interval only.
+  EXPECT_EQ(0, rebalancer.update(hot, 0.9));
+  EXPECT_EQ(3, rebalancer.update(hot, 0.9));
+  EXPECT_EQ(3, rebalancer.update(hot, 0.9));
+  EXPECT_EQ(0, rebalancer.update(cool, 0.4));
+
+  // Balanced again: the streak starts over.
+  EXPECT_EQ(0, rebalancer.update(hot, 0.5));
+  EXPECT_EQ(0, rebalancer.update(hot, 0.9));
+  EXPECT_EQ(3, rebalancer.update(hot, 0.9));
+}
+
+TEST(ConnectionRebalancer, tooManyWorkers) {
+  ConnectionRebalancer rebalancer(testOptions(), 1);
+  EXPECT_EQ(0, rebalancer.addWorker());
+  auto extra = rebalancer.addWorker();
+  EXPECT_EQ(static_cast<size_t>(-1), extra);
+  EXPECT_EQ(0, rebalancer.update(extra, 1.0));
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/init/Init.h>
+#include <folly/synchronization/Baton.h>
+
+#include "mcrouter/lib/carbon/connection/ExternalCarbonConnectionImpl.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+#include "mcrouter/lib/network/test/TestClientServerUtil.h"
+
+using namespace facebook::memcache;
+
+/**
+ * Cost of handing requests from a non-EventBase thread to
+ * ExternalCarbonConnectionImpl: one cross-thread task per request
+ * (sendRequestOne) vs one per batch (sendRequestBatch).
+ */
+
+namespace {
+
+using ExternalConnection =
+    carbon::ExternalCarbonConnectionImpl<MemcacheRouterInfo>;
+
+struct BenchEnv {
+  BenchEnv() {
+    test::TestServer::Config config;
+    config.outOfOrder = true;
+    config.useSsl = false;
+    config.maxInflight = 1000;
+    server = test::TestServer::create(std::move(config));
+    conn = std::make_unique<ExternalConnection>(
+        ConnectionOptions(
+            "localhost", server->getListenPort(), mc_caret_protocol));
+  }
+
+  ~BenchEnv() {
+    conn.reset();
+    server->shutdown();
+    server->join();
+  }
+
+  std::unique_ptr<test::TestServer> server;
+  std::unique_ptr<ExternalConnection> conn;
+};
+
+BenchEnv& env() {
+  static BenchEnv env;
+  return env;
+}
+
+std::vector<McGetRequest> makeRequests(size_t n) {
+  std::vector<McGetRequest> requests;
+  requests.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    requests.emplace_back(folly::to<std::string>("key:", i));
+  }
+  return requests;
+}
+
+void sendOne(size_t iters, size_t batchSize) {
+  std::vector<McGetRequest> requests;
+  BENCHMARK_SUSPEND {
+    env();
+    requests = makeRequests(batchSize);
+  }
+  for (size_t iter = 0; iter < iters; ++iter) {
+    folly::Baton<> baton;
+    std::atomic<size_t> remaining{batchSize};
+    for (const auto& req : requests) {
+      env().conn->sendRequestOne(
+          req, [&](const McGetRequest&, McGetReply&& reply) {
+            folly::doNotOptimizeAway(reply);
+            if (--remaining == 0) {
+              baton.post();
+            }
+          });
+    }
+    baton.wait();
+  }
+}
+
+void sendBatch(size_t iters, size_t batchSize) {
+  std::vector<McGetRequest> requests;
+  BENCHMARK_SUSPEND {
+    env();
+    requests = makeRequests(batchSize);
+  }
+  for (size_t iter = 0; iter < iters; ++iter) {
+    folly::Baton<> baton;
+    env().conn->sendRequestBatch<McGetRequest>(
+        std::vector<std::reference_wrapper<const McGetRequest>>(
+            requests.begin(), requests.end()),
+        [&](std::vector<McGetReply>&& replies) {
+          folly::doNotOptimizeAway(replies);
+          baton.post();
+        });
+    baton.wait();
+  }
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(sendOne, 1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(sendBatch, 1, 1)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(sendOne, 16, 16)
+BENCHMARK_RELATIVE_NAMED_PARAM(sendBatch, 16, 16)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(sendOne, 128, 128)
+BENCHMARK_RELATIVE_NAMED_PARAM(sendBatch, 128, 128)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  folly::runBenchmarks();
+  return 0;
+}
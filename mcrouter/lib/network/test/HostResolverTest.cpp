@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/HostResolver.h"
+
+using namespace facebook::memcache;
+
+TEST(HostResolver, resolve) {
+  auto addresses = HostResolver::resolve("127.0.0.1");
+  ASSERT_TRUE(addresses.hasValue());
+  ASSERT_EQ(1, addresses->size());
+  EXPECT_EQ(folly::IPAddress("127.0.0.1"), addresses->front());
+
+  EXPECT_TRUE(HostResolver::resolve("").hasError());
+}
+
+TEST(HostResolver, lookup) {
+  HostResolver resolver;
+  for (auto ttl : {std::chrono::milliseconds(0), std::chrono::seconds(60)}) {
+    resolver.setTtl(ttl);
+    // Twice, the second time from the cache when it's enabled.
+    for (int i = 0; i < 2; ++i) {
+      auto addresses = resolver.lookup("127.0.0.1");
+      ASSERT_TRUE(addresses.hasValue()) << addresses.error();
+      ASSERT_EQ(1, addresses->size());
+      EXPECT_EQ(folly::IPAddress("127.0.0.1"), addresses->front());
+    }
+  }
+}
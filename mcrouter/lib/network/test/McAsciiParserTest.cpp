@@ -44,6 +44,11 @@ class McAsciiParserHarness {
 
   void runTest(int maxPieceSize);
 
+  // Parse replies to meta commands, see ConnectionOptions::asciiMetaProtocol.
+  void setMetaProtocol(bool metaProtocol) {
+    metaProtocol_ = metaProtocol;
+  }
+
  private:
   using ParserT = ClientMcParser<McAsciiParserHarness>;
   friend ParserT;
@@ -88,6 +93,7 @@ class McAsciiParserHarness {
   size_t currentId_{0};
   folly::IOBuf data_;
   bool errorState_{false};
+  bool metaProtocol_{false};
 
   template <class Reply>
   void replyReady(
@@ -126,6 +132,7 @@ class McAsciiParserHarness {
     currentId_ = 0;
     errorState_ = false;
     parser_ = std::make_unique<ParserT>(*this, 1024, 4096);
+    parser_->setAsciiMetaProtocol(metaProtocol_);
     for (auto range : data_) {
       while (range.size() > 0 && !errorState_) {
         auto buffer = parser_->getReadBuffer();
@@ -814,3 +821,43 @@ TEST(McAsciiParserHarness, AllAtOnce) {
   h.expectNext<McTouchRequest>(McTouchReply(carbon::Result::TOUCHED));
   h.runTest(1);
 }
+
+TEST(McAsciiParserHarness, MetaProtocol) {
+  McAsciiParserHarness h(
+      "VA 2 f10\r\nte\r\n"
+      "EN\r\n"
+      "VA 0 f5 c123 s0\r\n\r\n"
+      "VA 3 f1 t-1\r\nabc\r\n"
+      "EN\r\n"
+      "HD\r\n"
+      "NS\r\n"
+      "HD\r\n"
+      "EX\r\n"
+      "NF\r\n"
+      "HD\r\n"
+      "NF\r\n"
+      "VERSION HarnessTest\r\n"
+      "SERVER_ERROR what\r\n");
+  h.setMetaProtocol(true);
+  h.expectNext<McGetRequest>(
+      setFlags(setValue(McGetReply(carbon::Result::FOUND), "te"), 10));
+  h.expectNext<McGetRequest>(McGetReply(carbon::Result::NOTFOUND));
+  h.expectNext<McGetsRequest>(setCas(
+      setFlags(setValue(McGetsReply(carbon::Result::FOUND), ""), 5), 123));
+  h.expectNext<McGatRequest>(
+      setFlags(setValue(McGatReply(carbon::Result::FOUND), "abc"), 1));
+  h.expectNext<McGatsRequest>(McGatsReply(carbon::Result::NOTFOUND));
+  h.expectNext<McSetRequest>(McSetReply(carbon::Result::STORED));
+  h.expectNext<McAddRequest>(McAddReply(carbon::Result::NOTSTORED));
+  h.expectNext<McAppendRequest>(McAppendReply(carbon::Result::STORED));
+  h.expectNext<McCasRequest>(McCasReply(carbon::Result::EXISTS));
+  h.expectNext<McCasRequest>(McCasReply(carbon::Result::NOTFOUND));
+  h.expectNext<McDeleteRequest>(McDeleteReply(carbon::Result::DELETED));
+  h.expectNext<McDeleteRequest>(McDeleteReply(carbon::Result::NOTFOUND));
+  // Requests without a meta command still get classic replies.
+  h.expectNext<McVersionRequest>(
+      setVersion(McVersionReply(carbon::Result::OK), "HarnessTest"));
+  h.expectNext<McSetRequest>(replyWithMessage<McSetReply>(
+      carbon::Result::REMOTE_ERROR, "what"));
+  h.runTest(1);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/McAsciiScan.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+void expectDelimiterAt(const std::string& s, size_t pos) {
+  const char* begin = s.data();
+  const char* end = s.data() + s.size();
+  EXPECT_EQ(begin + pos, findAsciiKeyDelimiter(begin, end)) << s;
+  EXPECT_EQ(begin + pos, findAsciiKeyDelimiterScalar(begin, end)) << s;
+}
+
+} // namespace
+
+TEST(McAsciiScan, noDelimiter) {
+  expectDelimiterAt("", 0);
+  expectDelimiterAt("abc", 3);
+  expectDelimiterAt(std::string(100, 'k'), 100);
+  // Non-ascii bytes are valid key characters.
+  expectDelimiterAt(std::string(50, '\xe9'), 50);
+}
+
+TEST(McAsciiScan, delimiters) {
+  for (size_t len : {0, 1, 15, 16, 17, 31, 32, 33, 64, 100}) {
+    std::string key(len, 'k');
+    expectDelimiterAt(key + ' ', len);
+    expectDelimiterAt(key + "\r\n", len);
+    expectDelimiterAt(key + '\n', len);
+    expectDelimiterAt(key + '\t' + key, len);
+    expectDelimiterAt(key + '\x7f', len);
+    expectDelimiterAt(key + std::string(1, '\0') + key, len);
+  }
+}
@@ -5,6 +5,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "mcrouter/lib/network/CaretProtocol.h"
@@ -26,6 +32,45 @@ class NoOpCallback : public McParser::ParserCallback {
   void parseError(carbon::Result, folly::StringPiece) override {}
 };
 
+class ConsumeAllCallback : public NoOpCallback {
+ public:
+  void handleAscii(folly::IOBuf& readBuffer) override {
+    readBuffer.clear();
+  }
+};
+
+class SaveMessageCallback : public NoOpCallback {
+ public:
+  bool caretMessageReady(const CaretMessageInfo&, const folly::IOBuf& buffer)
+      override {
+    messages.push_back(buffer.cloneOne());
+    return true;
+  }
+
+  std::vector<std::unique_ptr<folly::IOBuf>> messages;
+};
+
+// Reads a caret message with a body of `bodySize` bytes into `parser`.
+void feedCaretMessage(McParser& parser, size_t bodySize) {
+  CaretMessageInfo msgInfo;
+  msgInfo.bodySize = bodySize;
+  char header[kMaxHeaderLength];
+  const size_t headerSize = caretPrepareHeader(msgInfo, header);
+  std::string message(header, headerSize);
+  message.append(bodySize, 'v');
+
+  size_t offset = 0;
+  while (offset < message.size()) {
+    void* buf;
+    size_t bufLen;
+    std::tie(buf, bufLen) = parser.getReadBuffer();
+    const size_t len = std::min(bufLen, message.size() - offset);
+    memcpy(buf, message.data() + offset, len);
+    offset += len;
+    EXPECT_TRUE(parser.readDataAvailable(len));
+  }
+}
+
 } // namespace
 
 TEST(McParserTest, ReadZeroLengthMessage) {
@@ -49,3 +94,144 @@ TEST(McParserTest, ReadZeroLengthMessage) {
 
   EXPECT_FALSE(parser.readDataAvailable(bytesWritten));
 }
+
+TEST(McParserTest, ReleaseIdleBuffer) {
+  ConsumeAllCallback cb;
+  const auto bytesBefore = McParser::readBufferBytes();
+  McParser parser{cb, 1024, 1024};
+  EXPECT_LE(bytesBefore + 1024, McParser::readBufferBytes());
+
+  // Nothing pending: the buffer goes back to the pool right away.
+  parser.setReleaseIdleBuffer(true);
+  EXPECT_EQ(bytesBefore, McParser::readBufferBytes());
+
+  const auto hitsBefore = McParser::readBufferPoolHits();
+  void* buf;
+  size_t bufLen;
+  std::tie(buf, bufLen) = parser.getReadBuffer();
+  EXPECT_GE(bufLen, 1024);
+  EXPECT_EQ(hitsBefore + 1, McParser::readBufferPoolHits());
+  EXPECT_LE(bytesBefore + 1024, McParser::readBufferBytes());
+
+  memcpy(buf, "get a\r\n", 7);
+  EXPECT_TRUE(parser.readDataAvailable(7));
+  EXPECT_EQ(bytesBefore, McParser::readBufferBytes());
+}
+
+TEST(McParserTest, CompactCaretHeader) {
+  CaretMessageInfo info;
+  info.bodySize = 1000;
+  info.typeId = 123;
+  info.reqId = 456;
+  info.traceId = {17, 18};
+  info.usedCodecId = 2;
+  info.uncompressedBodySize = 5000;
+  info.timeoutBudgetMs = 250;
+
+  char legacyBuf[kMaxHeaderLength];
+  const auto legacySize = caretPrepareHeader(info, legacyBuf);
+  info.compactHeader = true;
+  char compactBuf[kMaxHeaderLength];
+  const auto compactSize = caretPrepareHeader(info, compactBuf);
+  EXPECT_EQ(kCaretCompactMagicByte, compactBuf[0]);
+  // The types of the 5 fields aren't sent, but the bitmask (0x159) takes a
+  // byte more than the number of fields.
+  EXPECT_EQ(legacySize - 4, compactSize);
+
+  CaretMessageInfo parsed;
+  ASSERT_EQ(
+      ParseStatus::Ok,
+      caretParseHeader(
+          reinterpret_cast<const uint8_t*>(compactBuf), compactSize, parsed));
+  EXPECT_TRUE(parsed.compactHeader);
+  EXPECT_EQ(compactSize, parsed.headerSize);
+  EXPECT_EQ(1000, parsed.bodySize);
+  EXPECT_EQ(123, parsed.typeId);
+  EXPECT_EQ(456, parsed.reqId);
+  EXPECT_EQ(17, parsed.traceId.first);
+  EXPECT_EQ(18, parsed.traceId.second);
+  EXPECT_EQ(2, parsed.usedCodecId);
+  EXPECT_EQ(5000, parsed.uncompressedBodySize);
+  EXPECT_EQ(250, parsed.timeoutBudgetMs);
+  EXPECT_EQ(0, parsed.supportedCodecsSize);
+
+  EXPECT_EQ(
+      ParseStatus::NotEnoughData,
+      caretParseHeader(
+          reinterpret_cast<const uint8_t*>(compactBuf),
+          compactSize - 1,
+          parsed));
+  EXPECT_EQ(mc_caret_protocol, determineProtocol(kCaretCompactMagicByte));
+}
+
+TEST(McParserTest, LargeMessageReadIntoOwnBuffer) {
+  SaveMessageCallback cb;
+  McParser parser{cb, 1024, 1024};
+  parser.setLargeMessageThreshold(2048);
+  const auto bytesBefore = McParser::readBufferBytes();
+
+  CaretMessageInfo msgInfo;
+  msgInfo.bodySize = 5000;
+  char header[kMaxHeaderLength];
+  const size_t headerSize = caretPrepareHeader(msgInfo, header);
+  const size_t messageSize = headerSize + msgInfo.bodySize;
+  std::string body(msgInfo.bodySize, 'v');
+
+  void* buf;
+  size_t bufLen;
+  std::tie(buf, bufLen) = parser.getReadBuffer();
+  ASSERT_GE(bufLen, headerSize + 100);
+  memcpy(buf, header, headerSize);
+  memcpy(static_cast<char*>(buf) + headerSize, body.data(), 100);
+  EXPECT_TRUE(parser.readDataAvailable(headerSize + 100));
+
+  // The rest of the message is read into its own buffer, nothing past it.
+  size_t offset = 100;
+  while (offset < body.size()) {
+    std::tie(buf, bufLen) = parser.getReadBuffer();
+    EXPECT_EQ(body.size() - offset, bufLen);
+    const size_t len = std::min<size_t>(bufLen, 1500);
+    memcpy(buf, body.data() + offset, len);
+    offset += len;
+    EXPECT_TRUE(parser.readDataAvailable(len));
+  }
+
+  ASSERT_EQ(1, cb.messages.size());
+  EXPECT_FALSE(cb.messages[0]->isChained());
+  EXPECT_EQ(messageSize, cb.messages[0]->length());
+  EXPECT_EQ(
+      body,
+      folly::StringPiece(cb.messages[0]->coalesce())
+          .subpiece(headerSize)
+          .str());
+  // The read buffer didn't grow to fit the message.
+  std::tie(buf, bufLen) = parser.getReadBuffer();
+  EXPECT_LT(bufLen, messageSize);
+  EXPECT_EQ(bytesBefore, McParser::readBufferBytes());
+}
+
+TEST(McParserTest, AdaptiveBufferSize) {
+  NoOpCallback cb;
+  const auto bytesBefore = McParser::readBufferBytes();
+  McParser parser{cb, 256, 1024};
+
+  // Alternating small and huge messages: once the average has caught up,
+  // the buffer fits both and is no longer reallocated.
+  for (int i = 0; i < 20; ++i) {
+    feedCaretMessage(parser, 100);
+    feedCaretMessage(parser, 16000);
+  }
+  const auto bytesWarm = McParser::readBufferBytes();
+  EXPECT_LT(bytesBefore + 16000, bytesWarm);
+  for (int i = 0; i < 5; ++i) {
+    feedCaretMessage(parser, 100);
+    feedCaretMessage(parser, 16000);
+    EXPECT_EQ(bytesWarm, McParser::readBufferBytes());
+  }
+
+  // After the burst, the buffer shrinks back.
+  for (int i = 0; i < 50; ++i) {
+    feedCaretMessage(parser, 100);
+  }
+  EXPECT_GE(bytesBefore + 1024, McParser::readBufferBytes());
+}
@@ -19,6 +19,7 @@ struct CaretMessageInfo;
 } // namespace facebook
 
 struct DummyMultiOpEnd {};
+struct DummyMetaNoop {};
 
 namespace {
 
@@ -26,6 +27,10 @@ bool compareRequests(const DummyMultiOpEnd&, const DummyMultiOpEnd&) {
   return true;
 }
 
+bool compareRequests(const DummyMetaNoop&, const DummyMetaNoop&) {
+  return true;
+}
+
 template <class Request>
 bool compareRequests(const Request& expected, const Request& actual) {
   const auto expectedSp =
@@ -53,6 +58,13 @@ class TestRunner {
     return *this;
   }
 
+  TestRunner& expectMetaNoop() {
+    callbacks_.emplace_back(
+        std::make_unique<ExpectedRequestCallback<DummyMetaNoop>>(
+            DummyMetaNoop()));
+    return *this;
+  }
+
   TestRunner& expectError() {
     isError_ = true;
     return *this;
@@ -226,6 +238,16 @@ class TestRunner {
       checkNext(DummyMultiOpEnd(), false);
     }
 
+    // Meta commands are checked like classic ones, with quiet as noreply.
+    template <class Request>
+    void onMetaRequest(Request&& req, const McAsciiMetaFlags& meta) {
+      checkNext(std::move(req), meta.quiet);
+    }
+
+    void metaNoop() {
+      checkNext(DummyMetaNoop(), false);
+    }
+
     friend class ServerMcParser<ParserOnRequest>;
   };
 
@@ -331,8 +353,25 @@ void getLikeTest(std::string opCmd) {
           opCmd + " test:stepan:1 test:stepan:2\r\n" + opCmd +
           " test:stepan:3\r\n");
 
+  // Keys longer than a SIMD scan chunk, with non-ascii characters.
+  std::string longKey1(70, 'a');
+  std::string longKey2 = std::string(40, 'b') + "\xc3\xa9" + "c";
+  TestRunner()
+      .expectNext(Request(longKey1))
+      .expectNext(Request(longKey2))
+      .expectMultiOpEnd()
+      .run(opCmd + " " + longKey1 + " " + longKey2 + "\r\n")
+      .run(opCmd + "  " + longKey1 + "    " + longKey2 + " \n");
+
   TestRunner().expectError().run(opCmd + "no:space:before:key\r\n");
 
+  // Control characters in the key list.
+  TestRunner()
+      .expectError()
+      .run(opCmd + " test:stepan:1\ttest:stepan:2\r\n")
+      .run(opCmd + " test:stepan:1\rtest:stepan:2\r\n")
+      .run(opCmd + " test:stepan:1 test\x7fstepan:2\r\n");
+
   // Missing key.
   TestRunner().expectError().run(opCmd + "\r\n").run(opCmd + "   \r\n");
 }
@@ -752,3 +791,71 @@ TEST(McServerAsciiParserHarness, allOps) {
           "flush_all\r\n"
           "flush_regex ^reGex$\r\n");
 }
+
+TEST(McServerAsciiParserHarness, metaGet) {
+  McGetsRequest getsRequest("test:meta:2");
+  McGatRequest gatRequest("test:meta:3");
+  gatRequest.exptime_ref() = 100;
+  McGatsRequest gatsRequest("test:meta:4");
+  gatsRequest.exptime_ref() = -1;
+
+  TestRunner()
+      .expectNext(McGetRequest("test:meta:1"))
+      .expectNext(getsRequest)
+      .expectNext(gatRequest)
+      .expectNext(gatsRequest, true /* quiet */)
+      .expectMetaNoop()
+      .run(
+          "mg test:meta:1 v f\r\n"
+          "mg test:meta:2 v c k Oabc\r\n"
+          "mg test:meta:3 T100 v s\r\n"
+          "mg test:meta:4 v c T-1 q\r\n"
+          "mn\r\n");
+
+  // Unknown flags are ignored.
+  TestRunner()
+      .expectNext(McGetRequest("test:meta:1"))
+      .run("mg test:meta:1 v N30 R10\r\n")
+      .run("mg test:meta:1   v  \n");
+
+  TestRunner().expectError().run("mg\r\n").run("mg \r\n");
+  // Opaque token longer than 32 characters.
+  TestRunner().expectError().run(
+      "mg test:meta:1 O" + std::string(33, 'o') + "\r\n");
+}
+
+TEST(McServerAsciiParserHarness, metaSet) {
+  auto casRequest =
+      createUpdateLike<McCasRequest>("test:meta:6", "Facebook", 5, 0);
+  casRequest.casToken_ref() = 893;
+
+  TestRunner()
+      .expectNext(createUpdateLike<McSetRequest>("test:meta:1", "Abc", 1, 2))
+      .expectNext(createUpdateLike<McAddRequest>("test:meta:2", "", 0, 0))
+      .expectNext(createUpdateLike<McAppendRequest>("test:meta:3", "x", 0, 0))
+      .expectNext(
+          createUpdateLike<McPrependRequest>("test:meta:4", "yZ", 0, -1),
+          true /* quiet */)
+      .expectNext(createUpdateLike<McReplaceRequest>("test:meta:5", "A", 3, 4))
+      .expectNext(casRequest)
+      .run(
+          "ms test:meta:1 3 F1 T2\r\nAbc\r\n"
+          "ms test:meta:2 0 ME\r\n\r\n"
+          "ms test:meta:3 1 MA\r\nx\r\n"
+          "ms test:meta:4 2 MP T-1 q\r\nyZ\r\n"
+          "ms test:meta:5 1 T4 MR F3\r\nA\r\n"
+          "ms test:meta:6 8 F5 C893\r\nFacebook\r\n");
+
+  // Value is longer than the declared size.
+  TestRunner().expectError().run("ms test:meta:1 2 F1\r\nAbc\r\n");
+  // Missing size.
+  TestRunner().expectError().run("ms test:meta:1\r\nAbc\r\n");
+}
+
+TEST(McServerAsciiParserHarness, metaDelete) {
+  TestRunner()
+      .expectNext(McDeleteRequest("test:meta:1"))
+      .expectNext(McDeleteRequest("test:meta:2"), true /* quiet */)
+      .expectMetaNoop()
+      .run("md test:meta:1\r\nmd test:meta:2 q Oxyz\r\nmn\r\n");
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <sys/uio.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/CompressionCodecManager.h"
+#include "mcrouter/lib/carbon/CarbonProtocolReader.h"
+#include "mcrouter/lib/network/AsciiSerialized.h"
+#include "mcrouter/lib/network/CaretSerializedMessage.h"
+#include "mcrouter/lib/network/ServerMcParser.h"
+#include "mcrouter/lib/network/WriteBuffer.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+// Typical key is a few tens of bytes with a routing prefix.
+std::string makeKey(size_t i) {
+  return folly::sformat("/region/cluster/some:prefix:key:{:08d}", i);
+}
+
+folly::IOBuf makeValue(size_t size) {
+  auto buf = folly::IOBuf::create(size);
+  std::memset(buf->writableData(), 'v', size);
+  buf->append(size);
+  return std::move(*buf);
+}
+
+/**
+ * Flattens the iovecs produced by a serializer into a single string, the way
+ * they would look on the wire.
+ */
+std::string flatten(const struct iovec* iov, size_t niov) {
+  std::string out;
+  for (size_t i = 0; i < niov; ++i) {
+    out.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+  return out;
+}
+
+class ParserBenchCallback {
+ public:
+  template <class Request>
+  void onRequest(Request&& req, bool /* noreply */) {
+    folly::doNotOptimizeAway(req);
+    ++requests;
+  }
+
+  template <class Request>
+  void onMetaRequest(Request&& req, const McAsciiMetaFlags& /* meta */) {
+    onRequest(std::move(req), false);
+  }
+
+  void multiOpEnd() {}
+  void metaNoop() {}
+
+  void caretRequestReady(
+      const CaretMessageInfo& headerInfo,
+      const folly::IOBuf& buffer) {
+    folly::io::Cursor cur(&buffer);
+    cur += headerInfo.headerSize;
+    carbon::CarbonProtocolReader reader(cur);
+    if (headerInfo.typeId == McGetRequest::typeId) {
+      McGetRequest req;
+      req.deserialize(reader);
+      onRequest(std::move(req), false);
+    } else {
+      McSetRequest req;
+      req.deserialize(reader);
+      onRequest(std::move(req), false);
+    }
+  }
+
+  void parseError(carbon::Result, folly::StringPiece reason) {
+    LOG(FATAL) << "Unexpected parse error: " << reason;
+  }
+
+  size_t requests{0};
+};
+
+/**
+ * Feeds data to the parser in reads of at most readSize bytes, the way
+ * McServerSession does.
+ */
+void feedParser(
+    ServerMcParser<ParserBenchCallback>& parser,
+    const std::string& data,
+    size_t readSize) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    auto buf = parser.getReadBuffer();
+    auto len = std::min({buf.second, readSize, data.size() - offset});
+    std::memcpy(buf.first, data.data() + offset, len);
+    CHECK(parser.readDataAvailable(len));
+    offset += len;
+  }
+}
+
+std::string asciiGetData(size_t nkeys) {
+  std::string data = "get";
+  for (size_t i = 0; i < nkeys; ++i) {
+    data += ' ';
+    data += makeKey(i);
+  }
+  data += "\r\n";
+  return data;
+}
+
+std::string asciiSetData(size_t valueSize) {
+  return folly::sformat(
+      "set {} 0 0 {}\r\n{}\r\n",
+      makeKey(0),
+      valueSize,
+      std::string(valueSize, 'v'));
+}
+
+template <class Request>
+std::string caretRequestData(const Request& req) {
+  CaretSerializedMessage serialized;
+  const struct iovec* iov;
+  size_t niov;
+  CHECK(serialized.prepare(req, 1, CodecIdRange::Empty, iov, niov));
+  return flatten(iov, niov);
+}
+
+void runParser(size_t iters, const std::string& data, size_t perIter) {
+  ParserBenchCallback cb;
+  ServerMcParser<ParserBenchCallback> parser(cb, 4096, 65536);
+  for (size_t i = 0; i < iters; ++i) {
+    feedParser(parser, data, 65536);
+  }
+  CHECK_EQ(iters * perIter, cb.requests);
+}
+
+} // namespace
+
+void asciiParseGet(size_t iters, size_t nkeys) {
+  std::string data;
+  BENCHMARK_SUSPEND {
+    data = asciiGetData(nkeys);
+  }
+  runParser(iters, data, nkeys);
+}
+
+void asciiParseSet(size_t iters, size_t valueSize) {
+  std::string data;
+  BENCHMARK_SUSPEND {
+    data = asciiSetData(valueSize);
+  }
+  runParser(iters, data, 1);
+}
+
+void caretParseGet(size_t iters, size_t nkeys) {
+  std::string data;
+  BENCHMARK_SUSPEND {
+    for (size_t i = 0; i < nkeys; ++i) {
+      data += caretRequestData(McGetRequest(makeKey(i)));
+    }
+  }
+  runParser(iters, data, nkeys);
+}
+
+void caretParseSet(size_t iters, size_t valueSize) {
+  std::string data;
+  BENCHMARK_SUSPEND {
+    McSetRequest req(makeKey(0));
+    req.value_ref() = makeValue(valueSize);
+    data = caretRequestData(req);
+  }
+  runParser(iters, data, 1);
+}
+
+void caretSerializeSetRequest(size_t iters, size_t valueSize) {
+  McSetRequest req;
+  BENCHMARK_SUSPEND {
+    req.key_ref() = makeKey(0);
+    req.value_ref() = makeValue(valueSize);
+  }
+  CaretSerializedMessage serialized;
+  const struct iovec* iov;
+  size_t niov;
+  for (size_t i = 0; i < iters; ++i) {
+    serialized.clear();
+    serialized.prepare(req, i, CodecIdRange::Empty, iov, niov);
+    folly::doNotOptimizeAway(niov);
+  }
+}
+
+void caretSerializeGetReply(size_t iters, size_t valueSize) {
+  folly::IOBuf value;
+  BENCHMARK_SUSPEND {
+    value = makeValue(valueSize);
+  }
+  CaretSerializedMessage serialized;
+  const struct iovec* iov;
+  size_t niov;
+  for (size_t i = 0; i < iters; ++i) {
+    McGetReply reply(carbon::Result::FOUND);
+    reply.value_ref() = value;
+    serialized.clear();
+    serialized.prepare(
+        std::move(reply),
+        i,
+        CodecIdRange::Empty,
+        nullptr /* compressionCodecMap */,
+        ServerLoad::zero(),
+        iov,
+        niov);
+    folly::doNotOptimizeAway(niov);
+  }
+}
+
+void asciiSerializeGetReply(size_t iters, size_t valueSize) {
+  folly::IOBuf value;
+  folly::Optional<folly::IOBuf> key;
+  BENCHMARK_SUSPEND {
+    value = makeValue(valueSize);
+    key = folly::IOBuf(folly::IOBuf::COPY_BUFFER, makeKey(0));
+  }
+  AsciiSerializedReply serialized;
+  const struct iovec* iov;
+  size_t niov;
+  for (size_t i = 0; i < iters; ++i) {
+    McGetReply reply(carbon::Result::FOUND);
+    reply.value_ref() = value;
+    serialized.clear();
+    serialized.prepare(std::move(reply), key, iov, niov);
+    folly::doNotOptimizeAway(niov);
+  }
+}
+
+void writeBufferQueueCycle(size_t iters, mc_protocol_t protocol) {
+  WriteBufferQueue queue;
+  for (size_t i = 0; i < iters; ++i) {
+    auto wb = queue.get(protocol);
+    wb->markEndOfBatch();
+    queue.push(std::move(wb));
+    queue.pop(/* popBatch */ false);
+  }
+}
+
+BENCHMARK_NAMED_PARAM(asciiParseGet, 1_key, 1)
+BENCHMARK_NAMED_PARAM(asciiParseGet, 10_keys, 10)
+BENCHMARK_NAMED_PARAM(asciiParseGet, 100_keys, 100)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretParseGet, 1_key, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretParseGet, 10_keys, 10)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretParseGet, 100_keys, 100)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(asciiParseSet, 100B, 100)
+BENCHMARK_NAMED_PARAM(asciiParseSet, 4KB, 4096)
+BENCHMARK_NAMED_PARAM(asciiParseSet, 100KB, 100 * 1024)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretParseSet, 100B, 100)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretParseSet, 4KB, 4096)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretParseSet, 100KB, 100 * 1024)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(caretSerializeSetRequest, 100B, 100)
+BENCHMARK_NAMED_PARAM(caretSerializeSetRequest, 400B, 400)
+BENCHMARK_NAMED_PARAM(caretSerializeSetRequest, 4KB, 4096)
+BENCHMARK_NAMED_PARAM(caretSerializeSetRequest, 100KB, 100 * 1024)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(asciiSerializeGetReply, 100B, 100)
+BENCHMARK_NAMED_PARAM(asciiSerializeGetReply, 400B, 400)
+BENCHMARK_NAMED_PARAM(asciiSerializeGetReply, 4KB, 4096)
+BENCHMARK_NAMED_PARAM(asciiSerializeGetReply, 100KB, 100 * 1024)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretSerializeGetReply, 100B, 100)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretSerializeGetReply, 400B, 400)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretSerializeGetReply, 4KB, 4096)
+BENCHMARK_RELATIVE_NAMED_PARAM(caretSerializeGetReply, 100KB, 100 * 1024)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(writeBufferQueueCycle, ascii, mc_ascii_protocol)
+BENCHMARK_NAMED_PARAM(writeBufferQueueCycle, caret, mc_caret_protocol)
+
+BENCHMARK_DRAW_LINE();
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  folly::runBenchmarks();
+  return 0;
+}
@@ -18,6 +18,7 @@
 
 #include <mcrouter/lib/network/AsyncMcClient.h>
 #include <mcrouter/options.h>
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/network/gen/MemcacheConnection.h"
 #include "mcrouter/lib/network/test/ListenSocket.h"
 #include "mcrouter/lib/network/test/MockMcThriftServerHandler.h"
@@ -174,6 +175,57 @@ TEST(MemcachePooledConnectionTest, PooledExternalConnection) {
   server->join();
 }
 
+TEST(MemcacheExternalConnectionTest, sendRequestBatch) {
+  TestServer::Config config;
+  config.outOfOrder = false;
+  config.useSsl = false;
+  auto server = TestServer::create(std::move(config));
+  using ExternalConnection = carbon::ExternalCarbonConnectionImpl<
+      facebook::memcache::MemcacheRouterInfo>;
+  auto conn = std::make_unique<ExternalConnection>(
+      facebook::memcache::ConnectionOptions(
+          "localhost", server->getListenPort(), mc_caret_protocol));
+
+  std::vector<facebook::memcache::McGetRequest> requests;
+  for (size_t i = 0; i < 10; ++i) {
+    requests.emplace_back(folly::to<std::string>("batch", i));
+  }
+
+  auto makeBatch = [&requests]() {
+    return std::vector<
+        std::reference_wrapper<const facebook::memcache::McGetRequest>>(
+        requests.begin(), requests.end());
+  };
+  auto checkReplies =
+      [&requests](const std::vector<facebook::memcache::McGetReply>& replies) {
+        ASSERT_EQ(requests.size(), replies.size());
+        for (size_t i = 0; i < replies.size(); ++i) {
+          EXPECT_EQ(carbon::Result::FOUND, *replies[i].result_ref());
+          EXPECT_EQ(
+              requests[i].key_ref()->fullKey(),
+              carbon::valueRangeSlow(replies[i]));
+        }
+      };
+
+  folly::fibers::Baton baton;
+  size_t numCalls = 0;
+  conn->sendRequestBatch<facebook::memcache::McGetRequest>(
+      makeBatch(),
+      [&](std::vector<facebook::memcache::McGetReply>&& replies) {
+        ++numCalls;
+        checkReplies(replies);
+        baton.post();
+      });
+  baton.wait();
+  EXPECT_EQ(1, numCalls);
+
+  checkReplies(conn->sendRequestBatch(makeBatch()).get());
+
+  conn.reset();
+  server->shutdown();
+  server->join();
+}
+
 TEST(MemcacheInternalConnectionTest, simpleInternalConnection) {
   folly::SingletonVault::singleton()->destroyInstances();
   folly::SingletonVault::singleton()->reenableInstances();
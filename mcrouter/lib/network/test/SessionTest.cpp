@@ -74,6 +74,32 @@ TEST(Session, throttle) {
   t.closeSession();
 }
 
+TEST(Session, asciiMultigetStreaming) {
+  AsyncMcServerWorkerOptions opts;
+  opts.asciiMultigetStreaming = true;
+  SessionTestHarness t(opts);
+
+  t.pause();
+  t.inputPackets("get a b c\r\n");
+  EXPECT_EQ(vector<string>({"a", "b", "c"}), t.pausedKeys());
+
+  /* The hit for the last key doesn't wait for the others */
+  t.replyKey("c");
+  EXPECT_EQ(
+      vector<string>({"VALUE c 0 7\r\nc_value\r\n"}), t.flushWrites());
+
+  /* END still comes last */
+  t.resume();
+  string out;
+  for (const auto& write : t.flushWrites()) {
+    out += write;
+  }
+  EXPECT_EQ(
+      "VALUE a 0 7\r\na_value\r\nVALUE b 0 7\r\nb_value\r\nEND\r\n", out);
+
+  t.closeSession();
+}
+
 TEST(Session, throttleBigPacket) {
   AsyncMcServerWorkerOptions opts;
   opts.maxInFlight = 2;
@@ -110,6 +110,20 @@ class SessionTestHarness {
     flushSavedInputs();
   }
 
+  /**
+   * Reply to the accumulated request with the given key, out of order.
+   */
+  void replyKey(folly::StringPiece key) {
+    for (auto it = transactions_.begin(); it != transactions_.end(); ++it) {
+      if ((*it)->key() == key) {
+        (*it)->reply();
+        transactions_.erase(it);
+        break;
+      }
+    }
+    eventBase_.loopOnce();
+  }
+
   /**
    * Initiate session close
    */
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include <folly/synchronization/Baton.h>
+#include <folly/testing/TestUtil.h>
+
+#include "mcrouter/lib/network/SocketTakeover.h"
+
+using namespace facebook::memcache;
+
+TEST(SocketTakeover, nobodyToTakeOverFrom) {
+  folly::test::TemporaryDirectory dir;
+  auto fds = takeOverSockets(
+      (dir.path() / "takeover").string(), std::chrono::seconds(1));
+  ASSERT_TRUE(fds.hasValue()) << fds.error();
+  EXPECT_TRUE(fds->empty());
+}
+
+TEST(SocketTakeover, takeOver) {
+  folly::test::TemporaryDirectory dir;
+  const auto path = (dir.path() / "takeover").string();
+  int pipeFds[2];
+  ASSERT_EQ(0, ::pipe(pipeFds));
+
+  folly::Baton<> takenOver;
+  SocketTakeoverServer server(
+      path,
+      [&]() { return std::vector<int>{pipeFds[1]}; },
+      [&]() { takenOver.post(); });
+
+  auto fds = takeOverSockets(path, std::chrono::seconds(1));
+  ASSERT_TRUE(fds.hasValue()) << fds.error();
+  ASSERT_EQ(1, fds->size());
+  EXPECT_TRUE(takenOver.try_wait_for(std::chrono::seconds(1)));
+
+  // The received descriptor is a duplicate of the handed over one.
+  ::close(pipeFds[1]);
+  ASSERT_EQ(1, ::write(fds->front(), "x", 1));
+  char c = 0;
+  ASSERT_EQ(1, ::read(pipeFds[0], &c, 1));
+  EXPECT_EQ('x', c);
+  ::close(fds->front());
+  ::close(pipeFds[0]);
+}
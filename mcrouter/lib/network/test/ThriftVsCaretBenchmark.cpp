@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/init/Init.h>
+#include <folly/synchronization/Baton.h>
+#include <thrift/lib/cpp2/server/ThriftServer.h>
+
+#include "mcrouter/lib/network/gen/MemcacheConnection.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/network/test/ListenSocket.h"
+#include "mcrouter/lib/network/test/MockMcOnRequest.h"
+#include "mcrouter/lib/network/test/MockMcThriftServerHandler.h"
+#include "mcrouter/lib/network/test/TestClientServerUtil.h"
+
+using namespace facebook::memcache;
+
+/**
+ * Cost per request of the thrift server path vs the caret one, on the same
+ * workload: both servers run MockMcOnRequest on one IO thread, and are sent
+ * `batchSize` pipelined gets (or sets) of 100 byte values over one
+ * connection.
+ */
+
+namespace {
+
+constexpr size_t kValueSize = 100;
+
+struct BenchEnv {
+  BenchEnv() {
+    test::TestServer::Config config;
+    config.outOfOrder = true;
+    config.useSsl = false;
+    config.maxInflight = 1000;
+    caretServer = test::TestServer::create<MockMcOnRequest>(
+        std::move(config), [](folly::fibers::Baton&, bool) {
+          return MemcacheRequestHandler<MockMcOnRequest>();
+        });
+    caretConn = std::make_unique<MemcacheExternalConnection>(ConnectionOptions(
+        "localhost", caretServer->getListenPort(), mc_caret_protocol));
+
+    thriftServer = std::make_shared<apache::thrift::ThriftServer>();
+    thriftServer->setInterface(
+        std::make_shared<test::MockMcThriftServerHandler>());
+    thriftServer->setNumIOWorkerThreads(1);
+    thriftServer->useExistingSocket(thriftSocket.getSocketFd());
+    thriftThread = std::thread([server = thriftServer]() { server->serve(); });
+    thriftConn = std::make_unique<MemcacheExternalConnection>(
+        ConnectionOptions(
+            "localhost", thriftSocket.getPort(), mc_thrift_protocol));
+    for (int i = 0; i < 50 && !thriftConn->healthCheck(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  ~BenchEnv() {
+    caretConn.reset();
+    caretServer->shutdown();
+    caretServer->join();
+
+    thriftConn.reset();
+    thriftServer->stop();
+    thriftThread.join();
+  }
+
+  std::unique_ptr<test::TestServer> caretServer;
+  std::unique_ptr<MemcacheExternalConnection> caretConn;
+
+  ListenSocket thriftSocket;
+  std::shared_ptr<apache::thrift::ThriftServer> thriftServer;
+  std::thread thriftThread;
+  std::unique_ptr<MemcacheExternalConnection> thriftConn;
+};
+
+BenchEnv& env() {
+  static BenchEnv env;
+  return env;
+}
+
+template <class Request>
+std::vector<Request> makeRequests(size_t n) {
+  std::vector<Request> requests;
+  requests.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    requests.emplace_back(folly::to<std::string>("key:", i));
+    if constexpr (std::is_same<Request, McSetRequest>::value) {
+      requests.back().value_ref() =
+          folly::IOBuf(folly::IOBuf::COPY_BUFFER, std::string(kValueSize, 'v'));
+    }
+  }
+  return requests;
+}
+
+template <class Request>
+void run(MemcacheExternalConnection& conn, size_t iters, size_t batchSize) {
+  std::vector<Request> requests;
+  BENCHMARK_SUSPEND {
+    requests = makeRequests<Request>(batchSize);
+    // Gets hit: the values are there.
+    for (const auto& set : makeRequests<McSetRequest>(batchSize)) {
+      folly::Baton<> baton;
+      conn.sendRequestOne(
+          set, [&baton](const McSetRequest&, McSetReply&&) { baton.post(); });
+      baton.wait();
+    }
+  }
+  for (size_t iter = 0; iter < iters; ++iter) {
+    folly::Baton<> baton;
+    std::atomic<size_t> remaining{batchSize};
+    for (const auto& req : requests) {
+      conn.sendRequestOne(
+          req, [&](const Request&, ReplyT<Request>&& reply) {
+            folly::doNotOptimizeAway(reply);
+            if (--remaining == 0) {
+              baton.post();
+            }
+          });
+    }
+    baton.wait();
+  }
+}
+
+void caretGet(size_t iters, size_t batchSize) {
+  run<McGetRequest>(*env().caretConn, iters, batchSize);
+}
+
+void thriftGet(size_t iters, size_t batchSize) {
+  run<McGetRequest>(*env().thriftConn, iters, batchSize);
+}
+
+void caretSet(size_t iters, size_t batchSize) {
+  run<McSetRequest>(*env().caretConn, iters, batchSize);
+}
+
+void thriftSet(size_t iters, size_t batchSize) {
+  run<McSetRequest>(*env().thriftConn, iters, batchSize);
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(caretGet, 1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(thriftGet, 1, 1)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(caretGet, 64, 64)
+BENCHMARK_RELATIVE_NAMED_PARAM(thriftGet, 64, 64)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(caretSet, 1, 1)
+BENCHMARK_RELATIVE_NAMED_PARAM(thriftSet, 1, 1)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(caretSet, 64, 64)
+BENCHMARK_RELATIVE_NAMED_PARAM(thriftSet, 64, 64)
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  folly::runBenchmarks();
+  return 0;
+}
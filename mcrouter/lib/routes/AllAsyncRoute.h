@@ -13,7 +13,9 @@
 
 #include <folly/fibers/FiberManager.h>
 
+#include "mcrouter/lib/RecentKeyFilter.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 
 namespace facebook {
@@ -22,6 +24,11 @@ namespace memcache {
 /**
  * Sends the same request to all child route handles.
  * Does not wait for response.
+ *
+ * If created with a dedup filter, deletes for a key already deleted within
+ * the filter's window are not sent again: the first delete is still on its
+ * way to every child, and sending the same invalidation twice in a few
+ * milliseconds buys nothing.
  */
 template <class RouteHandleIf>
 class AllAsyncRoute {
@@ -30,8 +37,10 @@ class AllAsyncRoute {
     return "all-async";
   }
 
-  explicit AllAsyncRoute(std::vector<std::shared_ptr<RouteHandleIf>> rh)
-      : children_(std::move(rh)) {
+  explicit AllAsyncRoute(
+      std::vector<std::shared_ptr<RouteHandleIf>> rh,
+      std::unique_ptr<RecentKeyFilter> deleteFilter = nullptr)
+      : children_(std::move(rh)), deleteFilter_(std::move(deleteFilter)) {
     assert(!children_.empty());
   }
 
@@ -44,6 +53,12 @@ class AllAsyncRoute {
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
+    if constexpr (carbon::DeleteLike<Request>::value) {
+      if (deleteFilter_ &&
+          deleteFilter_->seenRecently(req.key_ref()->fullKey())) {
+        return NullRoute<RouteHandleIf>::route(req);
+      }
+    }
     auto reqCopy = std::make_shared<Request>(req);
     for (auto& rh : children_) {
       folly::fibers::addTask([rh, reqCopy]() { rh->route(*reqCopy); });
@@ -53,6 +68,8 @@ class AllAsyncRoute {
 
  private:
   const std::vector<std::shared_ptr<RouteHandleIf>> children_;
+  // Route handles are only used by the thread of their proxy.
+  const std::unique_ptr<RecentKeyFilter> deleteFilter_;
 };
 } // namespace memcache
 } // namespace facebook
@@ -15,6 +15,7 @@
 
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/routes/AllAsyncRoute.h"
 
 namespace facebook {
@@ -24,6 +25,11 @@ namespace memcache {
  * Sends the same request to all child route handles.
  * Returns the reply from the first route handle in the list;
  * all other requests complete asynchronously.
+ *
+ * With cancelStragglers, get-like requests are only sent to the first child:
+ * nothing ever looks at the replies of the other children, so sending them
+ * copies just keeps fibers and outstanding requests busy. Everything else is
+ * still sent to all children.
  */
 template <class RouteHandleIf>
 class AllInitialRoute {
@@ -39,24 +45,33 @@ class AllInitialRoute {
     if (t(*firstChild_, req)) {
       return true;
     }
+    if (carbon::GetLike<Request>::value && cancelStragglers_) {
+      return false;
+    }
     return asyncRoute_.traverse(req, t);
   }
 
-  explicit AllInitialRoute(std::vector<std::shared_ptr<RouteHandleIf>> rh)
+  explicit AllInitialRoute(
+      std::vector<std::shared_ptr<RouteHandleIf>> rh,
+      bool cancelStragglers = false)
       : firstChild_(getFirstAndCheck(rh)),
         asyncRoute_(std::vector<std::shared_ptr<RouteHandleIf>>(
             rh.begin() + 1,
-            rh.end())) {}
+            rh.end())),
+        cancelStragglers_(cancelStragglers) {}
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    asyncRoute_.route(req);
+    if (!(carbon::GetLike<Request>::value && cancelStragglers_)) {
+      asyncRoute_.route(req);
+    }
     return firstChild_->route(req);
   }
 
  private:
   const std::shared_ptr<RouteHandleIf> firstChild_;
   const AllAsyncRoute<RouteHandleIf> asyncRoute_;
+  const bool cancelStragglers_;
 
   static std::shared_ptr<RouteHandleIf> getFirstAndCheck(
       std::vector<std::shared_ptr<RouteHandleIf>>& rh) {
@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include <folly/fibers/AddTasks.h>
+#include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Reply.h"
@@ -27,6 +30,14 @@ namespace memcache {
  * (or all results if that never happens).
  * Responds with one of the replies with the most common result.
  * Ties are broken using Reply::reduce().
+ *
+ * With cancelStragglers, children are not all sent the request up front:
+ * only as many as could still make a majority are in flight (half + 1 at
+ * first, more for every reply that doesn't agree with the leading result),
+ * so the children left once a majority is reached are never sent the
+ * request and don't keep fibers alive. Requests already sent can't be
+ * cancelled and complete in the background. The price is an extra round
+ * trip for every disagreeing reply.
  */
 template <class RouteHandleIf>
 class AllMajorityRoute {
@@ -42,13 +53,19 @@ class AllMajorityRoute {
     return t(children_, req);
   }
 
-  explicit AllMajorityRoute(std::vector<std::shared_ptr<RouteHandleIf>> rh)
-      : children_(std::move(rh)) {
+  explicit AllMajorityRoute(
+      std::vector<std::shared_ptr<RouteHandleIf>> rh,
+      bool cancelStragglers = false)
+      : children_(std::move(rh)), cancelStragglers_(cancelStragglers) {
     assert(!children_.empty());
   }
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
+    if (cancelStragglers_) {
+      return routeInWaves(req);
+    }
+
     using Reply = ReplyT<Request>;
 
     std::vector<std::function<Reply()>> funcs;
@@ -83,6 +100,73 @@ class AllMajorityRoute {
 
  private:
   const std::vector<std::shared_ptr<RouteHandleIf>> children_;
+  const bool cancelStragglers_;
+
+  template <class Request>
+  struct WaveState {
+    explicit WaveState(const Request& request) : req(request) {}
+
+    const Request req;
+    std::deque<ReplyT<Request>> replies;
+    std::optional<folly::fibers::Promise<void>> waiter;
+  };
+
+  template <class Request>
+  ReplyT<Request> routeInWaves(const Request& req) const {
+    using Reply = ReplyT<Request>;
+
+    // Outlives the route() call if stragglers are still in flight.
+    auto state = std::make_shared<WaveState<Request>>(req);
+    auto send = [&state](const std::shared_ptr<RouteHandleIf>& rh) {
+      folly::fibers::addTask([state, rh]() {
+        state->replies.push_back(rh->route(state->req));
+        if (state->waiter) {
+          auto waiter = std::move(*state->waiter);
+          state->waiter.reset();
+          waiter.setValue();
+        }
+      });
+    };
+
+    std::array<size_t, static_cast<size_t>(mc_nres)> counts;
+    counts.fill(0);
+    const size_t needed = children_.size() / 2 + 1;
+    size_t majorityCount = 0;
+    size_t numSent = 0;
+    size_t numReplies = 0;
+    Reply majorityReply = createReply(DefaultReply, req);
+
+    while (majorityCount < needed) {
+      // Enough requests in flight for the leading result to win if all of
+      // them agree with it.
+      while (numSent < children_.size() &&
+             numSent - numReplies < needed - majorityCount) {
+        send(children_[numSent++]);
+      }
+      if (numReplies == numSent) {
+        break;
+      }
+      if (state->replies.empty()) {
+        folly::fibers::await([&state](folly::fibers::Promise<void> promise) {
+          state->waiter = std::move(promise);
+        });
+      }
+      auto reply = std::move(state->replies.front());
+      state->replies.pop_front();
+      ++numReplies;
+      auto result = static_cast<size_t>(*reply.result_ref());
+
+      ++counts[result];
+      if ((counts[result] == majorityCount &&
+           worseThan(*reply.result_ref(), *majorityReply.result_ref())) ||
+          (counts[result] > majorityCount)) {
+        majorityReply = std::move(reply);
+        majorityCount = counts[result];
+      }
+    }
+
+    return majorityReply;
+  }
 };
 } // namespace memcache
 } // namespace facebook
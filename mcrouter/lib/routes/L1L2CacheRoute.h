@@ -7,12 +7,15 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
 #include <folly/fibers/FiberManager.h>
 #include <folly/io/IOBuf.h>
 
+#include "mcrouter/lib/AdmissionFilter.h"
+#include "mcrouter/lib/BackgroundRequestQueue.h"
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
@@ -25,6 +28,15 @@
 namespace facebook {
 namespace memcache {
 
+enum class L1UpgradeResult {
+  // L1 was sent an update.
+  Upgraded,
+  // The key wasn't seen often enough yet.
+  Filtered,
+  // The upgrade queue was full.
+  Dropped,
+};
+
 /**
  * This route handle is intended to be used for two level caching.
  * For 'get' tries to find value in L1 cache, in case of a miss fetches value
@@ -36,6 +48,16 @@ namespace memcache {
  * If we try to fetch "ncache" value from L1 we'll return a miss and refill
  * L1 from L2 every ncacheUpdatePeriod "ncache" requests.
  *
+ * If created with an upgrade filter, an L2 hit only updates L1 once the
+ * filter has seen its key often enough, so that keys read once don't take
+ * L1 space and background requests.
+ *
+ * With upgradeQueueSize > 0, the L1 updates are queued and sent by at most
+ * upgradeSenders fibers (see BackgroundRequestQueue) rather than by a fiber
+ * each; updates that don't fit in the queue are dropped.
+ *
+ * onUpgrade, if set, is told for every L2 hit what came of the L1 update.
+ *
  * NOTE: Doesn't work with lease get, gets and metaget.
  * Always overrides expiration time for L2 -> L1 update request.
  * Client is responsible for L2 consistency, sets and deletes are forwarded
@@ -63,13 +85,25 @@ class L1L2CacheRoute {
       std::shared_ptr<RouteHandleIf> l2,
       uint32_t upgradingL1Exptime,
       size_t ncacheExptime,
-      size_t ncacheUpdatePeriod)
+      size_t ncacheUpdatePeriod,
+      std::unique_ptr<AdmissionFilter> upgradeFilter = nullptr,
+      size_t upgradeQueueSize = 0,
+      size_t upgradeSenders = 0,
+      std::function<void(L1UpgradeResult)> onUpgrade = nullptr)
       : l1_(std::move(l1)),
         l2_(std::move(l2)),
         upgradingL1Exptime_(upgradingL1Exptime),
         ncacheExptime_(ncacheExptime),
         ncacheUpdatePeriod_(ncacheUpdatePeriod),
-        ncacheUpdateCounter_(ncacheUpdatePeriod) {
+        ncacheUpdateCounter_(ncacheUpdatePeriod),
+        upgradeFilter_(std::move(upgradeFilter)),
+        upgradeQueue_(
+            upgradeQueueSize > 0
+                ? std::make_shared<
+                      BackgroundRequestQueue<RouteHandleIf, McAddRequest>>(
+                      l1_, upgradeQueueSize, upgradeSenders)
+                : nullptr),
+        onUpgrade_(std::move(onUpgrade)) {
     assert(l1_ != nullptr);
     assert(l2_ != nullptr);
   }
@@ -97,15 +131,18 @@ class L1L2CacheRoute {
     /* else */
     auto l2Reply = l2_->route(req);
     if (isHitResult(*l2Reply.result_ref())) {
-      folly::fibers::addTask(
-          [l1 = l1_,
-           addReq = l1UpdateFromL2<McAddRequest>(
-               req, l2Reply, upgradingL1Exptime_)]() { l1->route(addReq); });
+      auto result = L1UpgradeResult::Filtered;
+      if (!upgradeFilter_ || upgradeFilter_->admit(req.key_ref()->fullKey())) {
+        result = upgradeL1(l1UpdateFromL2<McAddRequest>(
+                     req, l2Reply, upgradingL1Exptime_))
+            ? L1UpgradeResult::Upgraded
+            : L1UpgradeResult::Dropped;
+      }
+      if (onUpgrade_) {
+        onUpgrade_(result);
+      }
     } else if (isMissResult(*l2Reply.result_ref()) && ncacheUpdatePeriod_) {
-      folly::fibers::addTask(
-          [l1 = l1_, addReq = l1Ncache<McAddRequest>(req, ncacheExptime_)]() {
-            l1->route(addReq);
-          });
+      upgradeL1(l1Ncache<McAddRequest>(req, ncacheExptime_));
     }
     return l2Reply;
   }
@@ -124,6 +161,21 @@ class L1L2CacheRoute {
   size_t ncacheExptime_{0};
   size_t ncacheUpdatePeriod_{0};
   size_t ncacheUpdateCounter_{0};
+  // Route handles are only used by the thread of their proxy.
+  const std::unique_ptr<AdmissionFilter> upgradeFilter_;
+  const std::shared_ptr<BackgroundRequestQueue<RouteHandleIf, McAddRequest>>
+      upgradeQueue_;
+  const std::function<void(L1UpgradeResult)> onUpgrade_;
+
+  // @return  false if the update was dropped.
+  bool upgradeL1(McAddRequest addReq) {
+    if (upgradeQueue_) {
+      return upgradeQueue_->enqueue(std::move(addReq));
+    }
+    folly::fibers::addTask(
+        [l1 = l1_, addReq = std::move(addReq)]() { l1->route(addReq); });
+    return true;
+  }
 
   template <class ToRequest, class Request, class Reply>
   static ToRequest l1UpdateFromL2(
@@ -30,18 +30,21 @@ namespace memcache {
  * This route handle changes behavior based on Migration mode. Each request is
  * assigned a migration time based on the hash of its key in order to migrate
  * smoothly over time. A key's migration time is calculated as start_time +
- * hash(key) % (2 * interval).
+ * interval + hash(key) % ramp_interval, so the share of keys served by to_
+ * grows linearly over ramp_interval (by default as long as interval) and the
+ * new pool warms up gradually instead of taking all the misses at once.
  * 1. Before the migration starts, sends all requests to from_ route
  * handle.
  * 2. Between start time and the key's migration time, sends all requests except
  * for deletes to from_ route handle and sends all delete requests to both from_
  * and to_ route handle. For delete requests, returns reply from
  * worst among two replies.
- * 3. Between the key's migration time and (start_time + 2*interval), sends all
- * requests except for deletes to to_ route handle and sends all delete requests
- * to both from_ and to_ route handle. For delete requests, returns
- * reply from worst among two replies.
- * 4. After (start_time + 2*interval), sends all requests to to_ route handle.
+ * 3. Between the key's migration time and (start_time + interval +
+ * ramp_interval), sends all requests except for deletes to to_ route handle
+ * and sends all delete requests to both from_ and to_ route handle. For
+ * delete requests, returns reply from worst among two replies.
+ * 4. After (start_time + interval + ramp_interval), sends all requests to to_
+ * route handle.
  */
 template <class RouteHandleIf, typename TimeProvider>
 class MigrateRoute {
@@ -74,10 +77,26 @@ class MigrateRoute {
       time_t start_time_sec,
       time_t interval_sec,
       TimeProvider tp)
+      : MigrateRoute(
+            std::move(fh),
+            std::move(th),
+            start_time_sec,
+            interval_sec,
+            interval_sec,
+            std::move(tp)) {}
+
+  MigrateRoute(
+      std::shared_ptr<RouteHandleIf> fh,
+      std::shared_ptr<RouteHandleIf> th,
+      time_t start_time_sec,
+      time_t interval_sec,
+      time_t ramp_interval_sec,
+      TimeProvider tp)
       : from_(std::move(fh)),
         to_(std::move(th)),
         startTimeSec_(start_time_sec),
         intervalSec_(interval_sec),
+        rampIntervalSec_(ramp_interval_sec),
         tp_(tp) {
     assert(from_ != nullptr);
     assert(to_ != nullptr);
@@ -150,6 +169,7 @@ class MigrateRoute {
   const std::shared_ptr<RouteHandleIf> to_;
   time_t startTimeSec_;
   time_t intervalSec_;
+  time_t rampIntervalSec_;
   const TimeProvider tp_;
 
   template <class Request>
@@ -159,7 +179,7 @@ class MigrateRoute {
       return kFromMask;
     }
 
-    if (now < (startTimeSec_ + 2 * intervalSec_)) {
+    if (now < (startTimeSec_ + intervalSec_ + rampIntervalSec_)) {
       return kFromMask | kToMask;
     }
 
@@ -182,8 +202,11 @@ class MigrateRoute {
   // Returns the timestamp when traffic switches between from_ and to_.
   template <class Request>
   time_t migrationTime(const Request& req) const {
+    if (rampIntervalSec_ <= 0) {
+      return startTimeSec_ + intervalSec_;
+    }
     return startTimeSec_ + intervalSec_ +
-        req.key_ref()->routingKeyHash() % intervalSec_;
+        req.key_ref()->routingKeyHash() % rampIntervalSec_;
   }
 };
 } // namespace memcache
@@ -8,8 +8,10 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 #include <random>
 #include <utility>
+#include <vector>
 
 #include <folly/Conv.h>
 #include <folly/Optional.h>
@@ -104,6 +106,69 @@ class SelectionRoute {
   }
 };
 
+/**
+ * Same as SelectionRoute, but all children are known to be of the concrete
+ * route handle type `Child` (e.g. RouteHandleIf::Impl<DestinationRoute<...>>).
+ *
+ * The route handle wrappers implement RouteHandleIf with final methods, so
+ * routing to a child this way is a direct (inlinable) call instead of a
+ * virtual one. This matters for pools, where it's the last hop before the
+ * network.
+ *
+ * @tparam Child  Final implementation of RouterInfo::RouteHandleIf.
+ */
+template <class RouterInfo, typename Selector, class Child>
+class TypedSelectionRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+ public:
+  std::string routeName() const {
+    return folly::to<std::string>("selection|", selector_.type());
+  }
+
+  /**
+   * See SelectionRoute.
+   */
+  TypedSelectionRoute(
+      std::vector<std::shared_ptr<Child>> children,
+      Selector selector,
+      RouteHandlePtr outOfRangeDestination)
+      : children_(std::move(children)),
+        selector_(std::move(selector)),
+        outOfRangeDestination_(std::move(outOfRangeDestination)) {
+    assert(outOfRangeDestination_);
+  }
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    size_t idx = selector_.select(req, children_.size());
+    if (idx >= children_.size()) {
+      return t(*outOfRangeDestination_, req);
+    }
+    mcrouter::fiber_local<RouterInfo>::setSelectedIndex(idx);
+    return t(*children_[idx], req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) {
+    size_t idx = selector_.select(req, children_.size());
+    if (idx >= children_.size()) {
+      return outOfRangeDestination_->route(req);
+    }
+    mcrouter::fiber_local<RouterInfo>::setSelectedIndex(idx);
+    return children_[idx]->route(req);
+  }
+
+ private:
+  const std::vector<std::shared_ptr<Child>> children_;
+  const Selector selector_;
+  const RouteHandlePtr outOfRangeDestination_;
+};
+
 template <
     class RouterInfo,
     typename Selector,
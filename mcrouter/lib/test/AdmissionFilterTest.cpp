@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/lib/AdmissionFilter.h"
+
+using namespace facebook::memcache;
+
+TEST(AdmissionFilter, admitsAfterMinHits) {
+  AdmissionFilter filter(1000, 3);
+
+  EXPECT_FALSE(filter.admit("a"));
+  EXPECT_FALSE(filter.admit("a"));
+  EXPECT_FALSE(filter.admit("b"));
+  EXPECT_TRUE(filter.admit("a"));
+  EXPECT_TRUE(filter.admit("a"));
+  EXPECT_FALSE(filter.admit("b"));
+  EXPECT_TRUE(filter.admit("b"));
+}
+
+TEST(AdmissionFilter, forgetsColdKeys) {
+  AdmissionFilter filter(100, 2);
+
+  EXPECT_FALSE(filter.admit("a"));
+  // Enough other keys for the counters to be halved a couple of times.
+  for (size_t i = 0; i < 300; ++i) {
+    filter.admit(folly::to<std::string>("other", i));
+  }
+  EXPECT_FALSE(filter.admit("a"));
+  EXPECT_TRUE(filter.admit("a"));
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/Compression.h"
+
+using facebook::memcache::CompressionCodec;
+using facebook::memcache::CompressionCodecType;
+using facebook::memcache::createCompressionCodec;
+
+namespace {
+
+constexpr size_t kDictionarySize = 16 * 1024;
+
+const std::string& dictionary() {
+  static const std::string dic = [] {
+    std::string d;
+    d.reserve(kDictionarySize);
+    while (d.size() < kDictionarySize) {
+      d.append(folly::sformat(
+          "{{\"id\":{},\"name\":\"user_{}\",\"active\":{},\"score\":{}}}",
+          folly::Random::rand32(),
+          folly::Random::rand32(1000),
+          folly::Random::oneIn(2) ? "true" : "false",
+          folly::Random::rand32(100)));
+    }
+    d.resize(kDictionarySize);
+    return d;
+  }();
+  return dic;
+}
+
+// Values that look like the dictionary (so they compress), with some noise.
+std::string makeValue(size_t size) {
+  const auto& dic = dictionary();
+  std::string value;
+  value.reserve(size);
+  while (value.size() < size) {
+    if (folly::Random::oneIn(4)) {
+      value.push_back(static_cast<char>(folly::Random::rand32(256)));
+    } else {
+      size_t len = folly::Random::rand32(8, 64);
+      size_t offset = folly::Random::rand32(dic.size() - len);
+      value.append(dic, offset, len);
+    }
+  }
+  value.resize(size);
+  return value;
+}
+
+std::unique_ptr<CompressionCodec> makeCodec(CompressionCodecType type) {
+  return createCompressionCodec(
+      type, folly::IOBuf::copyBuffer(dictionary()), 1 /* id */);
+}
+
+void compressBench(size_t iters, CompressionCodecType type, size_t size) {
+  std::unique_ptr<CompressionCodec> codec;
+  std::string value;
+  BENCHMARK_SUSPEND {
+    codec = makeCodec(type);
+    value = makeValue(size);
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    auto compressed = codec->compress(value.data(), value.size());
+    folly::doNotOptimizeAway(compressed);
+  }
+}
+
+void uncompressBench(size_t iters, CompressionCodecType type, size_t size) {
+  std::unique_ptr<CompressionCodec> codec;
+  std::unique_ptr<folly::IOBuf> compressed;
+  BENCHMARK_SUSPEND {
+    codec = makeCodec(type);
+    auto value = makeValue(size);
+    compressed = codec->compress(value.data(), value.size());
+    compressed->coalesce();
+  }
+  for (size_t i = 0; i < iters; ++i) {
+    auto uncompressed = codec->uncompress(*compressed, size);
+    folly::doNotOptimizeAway(uncompressed);
+  }
+}
+
+void uncompressIntoBench(size_t iters, CompressionCodecType type, size_t size) {
+  std::unique_ptr<CompressionCodec> codec;
+  std::unique_ptr<folly::IOBuf> compressed;
+  std::vector<uint8_t> buffer;
+  BENCHMARK_SUSPEND {
+    codec = makeCodec(type);
+    auto value = makeValue(size);
+    compressed = codec->compress(value.data(), value.size());
+    compressed->coalesce();
+    buffer.resize(size);
+  }
+  auto iovs = compressed->getIov();
+  for (size_t i = 0; i < iters; ++i) {
+    codec->uncompressInto(iovs.data(), iovs.size(), buffer.data(), size);
+    folly::doNotOptimizeAway(buffer.data());
+  }
+}
+
+} // namespace
+
+#define COMPRESSION_BENCHMARKS(fn, name, size)                               \
+  BENCHMARK_NAMED_PARAM(fn, LZ4_##name, CompressionCodecType::LZ4, size)     \
+  BENCHMARK_RELATIVE_NAMED_PARAM(                                            \
+      fn, LZ4Immutable_##name, CompressionCodecType::LZ4Immutable, size)     \
+  BENCHMARK_RELATIVE_NAMED_PARAM(                                            \
+      fn, ZSTD_##name, CompressionCodecType::ZSTD, size)
+
+COMPRESSION_BENCHMARKS(compressBench, 128, 128)
+COMPRESSION_BENCHMARKS(compressBench, 1K, 1024)
+COMPRESSION_BENCHMARKS(compressBench, 16K, 16 * 1024)
+COMPRESSION_BENCHMARKS(compressBench, 256K, 256 * 1024)
+
+BENCHMARK_DRAW_LINE();
+
+COMPRESSION_BENCHMARKS(uncompressBench, 128, 128)
+COMPRESSION_BENCHMARKS(uncompressBench, 1K, 1024)
+COMPRESSION_BENCHMARKS(uncompressBench, 16K, 16 * 1024)
+COMPRESSION_BENCHMARKS(uncompressBench, 256K, 256 * 1024)
+
+BENCHMARK_DRAW_LINE();
+
+COMPRESSION_BENCHMARKS(uncompressIntoBench, 128, 128)
+COMPRESSION_BENCHMARKS(uncompressIntoBench, 1K, 1024)
+COMPRESSION_BENCHMARKS(uncompressIntoBench, 16K, 16 * 1024)
+COMPRESSION_BENCHMARKS(uncompressIntoBench, 256K, 256 * 1024)
+
+#undef COMPRESSION_BENCHMARKS
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  folly::runBenchmarks();
+  return 0;
+}
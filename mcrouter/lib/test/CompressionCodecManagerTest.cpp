@@ -335,6 +335,55 @@ TEST(CompressionCodecManager, getBest_serverWithoutCodecs) {
           CodecIdRange{1, 6}, 1234 /* body size */, 0 /* reply type id */));
 }
 
+TEST(CompressionCodecManager, addCodecConfig) {
+  std::unordered_map<uint32_t, CodecConfigPtr> codecConfigs;
+  for (uint32_t i = 1; i <= 4; ++i) {
+    codecConfigs.emplace(
+        i,
+        std::make_unique<CodecConfig>(
+            i, CompressionCodecType::LZ4, createBinaryData(i * 1024)));
+  }
+  CompressionCodecManager codecManager(std::move(codecConfigs));
+  auto codecMap = codecManager.getCodecMap();
+  auto codec1 = codecMap->get(1);
+  EXPECT_EQ(nullptr, codecMap->get(5));
+  EXPECT_EQ(5, codecManager.nextCodecId());
+
+  // Ids must stay contiguous.
+  EXPECT_FALSE(codecManager.addCodecConfig(std::make_unique<CodecConfig>(
+      7, CompressionCodecType::LZ4, createBinaryData(1024))));
+  auto version = codecManager.version();
+  EXPECT_TRUE(codecManager.addCodecConfig(std::make_unique<CodecConfig>(
+      5, CompressionCodecType::LZ4, createBinaryData(1024))));
+  EXPECT_NE(version, codecManager.version());
+  EXPECT_EQ(6, codecManager.nextCodecId());
+
+  // The existing map picks the new codec up, and old codecs stay put.
+  validateCodec(codecMap->get(5));
+  EXPECT_EQ(codec1, codecMap->get(1));
+  EXPECT_EQ(1, codecMap->getIdRange().firstId);
+  EXPECT_EQ(5, codecMap->getIdRange().size);
+
+  auto latest = codecManager.latestCodecConfig(CompressionCodecType::LZ4);
+  ASSERT_TRUE(latest);
+  EXPECT_EQ(5, latest->id);
+  EXPECT_FALSE(codecManager.latestCodecConfig(CompressionCodecType::ZSTD));
+}
+
+TEST(CompressionCodecManager, addCodecConfigToEmpty) {
+  CompressionCodecManager codecManager(
+      std::unordered_map<uint32_t, CodecConfigPtr>{});
+  auto codecMap = codecManager.getCodecMap();
+  EXPECT_EQ(0, codecMap->size());
+  EXPECT_EQ(1, codecManager.nextCodecId());
+
+  EXPECT_TRUE(codecManager.addCodecConfig(std::make_unique<CodecConfig>(
+      1, CompressionCodecType::LZ4, createBinaryData(1024))));
+  validateCodec(codecMap->get(1));
+  EXPECT_EQ(1, codecMap->getIdRange().firstId);
+  EXPECT_EQ(1, codecMap->getIdRange().size);
+}
+
 } // namespace test
 } // namespace memcache
 } // namespace facebook
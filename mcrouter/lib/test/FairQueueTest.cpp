@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/FairQueue.h"
+
+using namespace facebook::memcache;
+
+TEST(FairQueue, singleKeyIsFifo) {
+  FairQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 5; ++i) {
+    queue.push(7, i);
+  }
+  EXPECT_EQ(5, queue.size());
+  EXPECT_EQ(1, queue.numKeys());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, queue.pop());
+  }
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(0, queue.numKeys());
+}
+
+TEST(FairQueue, roundRobinAcrossKeys) {
+  FairQueue<int> queue;
+  // A burst from key 1, then a few items of keys 2 and 3.
+  for (int i = 0; i < 4; ++i) {
+    queue.push(1, 10 + i);
+  }
+  queue.push(2, 20);
+  queue.push(3, 30);
+  queue.push(2, 21);
+  EXPECT_EQ(3, queue.numKeys());
+
+  std::vector<int> popped;
+  while (!queue.empty()) {
+    popped.push_back(queue.pop());
+  }
+  EXPECT_EQ((std::vector<int>{10, 20, 30, 11, 21, 12, 13}), popped);
+}
+
+TEST(FairQueue, keyRejoinsAtTheBack) {
+  FairQueue<std::unique_ptr<int>> queue;
+  queue.push(1, std::make_unique<int>(1));
+  queue.push(2, std::make_unique<int>(2));
+  EXPECT_EQ(1, *queue.pop());
+  // Key 1 had nothing left, so it waits behind key 2 now.
+  queue.push(1, std::make_unique<int>(3));
+  EXPECT_EQ(2, *queue.pop());
+  EXPECT_EQ(3, *queue.pop());
+  EXPECT_TRUE(queue.empty());
+}
@@ -5,6 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <folly/Format.h>
@@ -391,3 +394,32 @@ TEST(Lz4Immutable, compress_into) {
   decompressed = compressor.decompress(&iov, 1, source->length());
   checkEqual(source, decompressed);
 }
+
+TEST(Lz4Immutable, decompressInto) {
+  auto dictionary = getAsciiDictionary();
+  Lz4Immutable compressor(dictionary->clone());
+
+  auto source = getRandomAsciiData();
+  const size_t sourceSize = source->computeChainDataLength();
+  auto compressed = compressor.compress(*source);
+  auto iovs = compressed->getIov();
+
+  // Leave some guard bytes past the end to make sure they are never touched.
+  constexpr size_t kGuard = 16;
+  std::vector<uint8_t> buffer(sourceSize + kGuard, 0xAB);
+  EXPECT_TRUE(compressor.decompressInto(
+      iovs.data(), iovs.size(), buffer.data(), sourceSize));
+  auto decompressed = folly::IOBuf::wrapBuffer(buffer.data(), sourceSize);
+  checkEqual(source, decompressed);
+  for (size_t i = sourceSize; i < buffer.size(); ++i) {
+    EXPECT_EQ(0xAB, buffer[i]);
+  }
+
+  // Wrong uncompressed size must fail without overrunning the buffer.
+  std::fill(buffer.begin(), buffer.end(), 0xAB);
+  EXPECT_FALSE(compressor.decompressInto(
+      iovs.data(), iovs.size(), buffer.data(), sourceSize / 2));
+  for (size_t i = sourceSize / 2; i < buffer.size(); ++i) {
+    EXPECT_EQ(0xAB, buffer[i]);
+  }
+}
@@ -12,6 +12,8 @@
 
 #include <gtest/gtest.h>
 
+#include <folly/Conv.h>
+
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/lib/routes/MigrateRoute.h"
@@ -312,3 +314,65 @@ TEST(migrateRouteTest, leases) {
     }
   });
 }
+
+TEST(migrateRouteTest, rampInterval) {
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::FOUND, "a"),
+          UpdateRouteTestData(),
+          DeleteRouteTestData(carbon::Result::DELETED)),
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::FOUND, "b"),
+          UpdateRouteTestData(),
+          DeleteRouteTestData(carbon::Result::DELETED)),
+  };
+  auto route_handles = get_route_handles(test_handles);
+
+  TestFiberManager<TestRouterInfo> fm;
+  fm.run([&]() {
+    const time_t start_time = 100;
+    const time_t interval = 10;
+    const time_t ramp_interval = 1000;
+    time_t now = start_time;
+    auto tp_func = [&]() { return now; };
+    TestRouteHandle<MigrateRoute<TestRouteHandleIf, decltype(tp_func)>> rh(
+        route_handles[0],
+        route_handles[1],
+        start_time,
+        interval,
+        ramp_interval,
+        tp_func);
+
+    auto numFromTo = [&]() {
+      int n = 0;
+      for (int i = 0; i < 1000; ++i) {
+        auto reply = rh.route(McGetRequest(folly::to<string>("key", i)));
+        n += carbon::valueRangeSlow(reply) == "b";
+      }
+      return n;
+    };
+
+    now = start_time + interval - 1;
+    EXPECT_EQ(0, numFromTo());
+
+    // Half way through the ramp about half of the keys are migrated.
+    now = start_time + interval + ramp_interval / 2;
+    auto numMigrated = numFromTo();
+    EXPECT_GT(numMigrated, 400);
+    EXPECT_LT(numMigrated, 600);
+
+    // Deletes go to both until the end of the ramp.
+    now = start_time + interval + ramp_interval - 1;
+    int cnt = 0;
+    RouteHandleTraverser<TestRouteHandleIf> t{
+        [&cnt](const TestRouteHandleIf&) { ++cnt; }};
+    rh.traverse(McDeleteRequest("key"), t);
+    EXPECT_EQ(2, cnt);
+
+    now = start_time + interval + ramp_interval;
+    EXPECT_EQ(1000, numFromTo());
+    cnt = 0;
+    rh.traverse(McDeleteRequest("key"), t);
+    EXPECT_EQ(1, cnt);
+  });
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/RecentKeyFilter.h"
+
+using namespace facebook::memcache;
+
+using Clock = RecentKeyFilter::Clock;
+
+TEST(RecentKeyFilter, forgetsKeysAfterWindow) {
+  RecentKeyFilter filter(std::chrono::milliseconds(100), 1000);
+  auto now = Clock::now();
+
+  EXPECT_FALSE(filter.seenRecently("a", now));
+  EXPECT_TRUE(filter.seenRecently("a", now));
+  EXPECT_FALSE(filter.seenRecently("b", now));
+
+  // Still remembered in the previous generation.
+  now += std::chrono::milliseconds(60);
+  EXPECT_TRUE(filter.seenRecently("a", now));
+
+  now += std::chrono::milliseconds(60);
+  EXPECT_FALSE(filter.seenRecently("b", now));
+
+  now += std::chrono::milliseconds(200);
+  EXPECT_FALSE(filter.seenRecently("a", now));
+}
+
+TEST(RecentKeyFilter, boundedNumberOfKeys) {
+  RecentKeyFilter filter(std::chrono::hours(1), 2);
+  auto now = Clock::now();
+
+  EXPECT_FALSE(filter.seenRecently("a", now));
+  EXPECT_FALSE(filter.seenRecently("b", now));
+  EXPECT_FALSE(filter.seenRecently("c", now));
+  EXPECT_FALSE(filter.seenRecently("d", now));
+  EXPECT_FALSE(filter.seenRecently("e", now));
+  // Two generations of two keys each: "a" and "b" are forgotten.
+  EXPECT_FALSE(filter.seenRecently("a", now));
+  EXPECT_TRUE(filter.seenRecently("e", now));
+}
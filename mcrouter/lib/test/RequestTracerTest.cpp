@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/json.h>
+
+#include "mcrouter/lib/debug/RequestTracer.h"
+
+using namespace facebook::memcache;
+
+TEST(RequestTracer, samplePeriod) {
+  RequestTracer tracer(3, 16);
+
+  size_t numSampled = 0;
+  for (size_t i = 0; i < 9; ++i) {
+    if (tracer.startTrace().sampled()) {
+      ++numSampled;
+    }
+  }
+  EXPECT_EQ(3, numSampled);
+}
+
+TEST(RequestTracer, spans) {
+  RequestTracer tracer(1, 16);
+  const auto startNs = RequestTracer::nowNs();
+  auto context = tracer.startTrace();
+  ASSERT_TRUE(context.sampled());
+  const auto rootSpanId = context.spanId;
+
+  {
+    RequestTracer::Scope outer(tracer, context, "outer");
+    const auto outerSpanId = context.spanId;
+    EXPECT_NE(rootSpanId, outerSpanId);
+    {
+      RequestTracer::Scope inner(tracer, context, "inner");
+      EXPECT_NE(outerSpanId, context.spanId);
+    }
+    EXPECT_EQ(outerSpanId, context.spanId);
+  }
+  EXPECT_EQ(rootSpanId, context.spanId);
+  tracer.finishTrace(context, "get", startNs);
+
+  std::vector<RequestTracer::Span> spans;
+  tracer.drain(spans);
+  ASSERT_EQ(3, spans.size());
+  const auto& inner = spans[0];
+  const auto& outer = spans[1];
+  const auto& root = spans[2];
+  EXPECT_EQ("inner", inner.name);
+  EXPECT_EQ("outer", outer.name);
+  EXPECT_EQ("get", root.name);
+  EXPECT_EQ(outer.spanId, inner.parentSpanId);
+  EXPECT_EQ(root.spanId, outer.parentSpanId);
+  EXPECT_EQ(0, root.parentSpanId);
+  for (const auto& span : spans) {
+    EXPECT_EQ(context.traceIdHigh, span.traceIdHigh);
+    EXPECT_EQ(context.traceIdLow, span.traceIdLow);
+    EXPECT_LE(span.startNs, span.endNs);
+  }
+  EXPECT_LE(root.startNs, outer.startNs);
+  EXPECT_GE(root.endNs, outer.endNs);
+
+  spans.clear();
+  tracer.drain(spans);
+  EXPECT_TRUE(spans.empty());
+}
+
+TEST(RequestTracer, unsampled) {
+  RequestTracer tracer(2, 16);
+  auto context = tracer.startTrace();
+  ASSERT_FALSE(context.sampled());
+  {
+    RequestTracer::Scope scope(tracer, context, "route");
+    EXPECT_FALSE(context.sampled());
+  }
+  tracer.finishTrace(context, "get", RequestTracer::nowNs());
+
+  std::vector<RequestTracer::Span> spans;
+  tracer.drain(spans);
+  EXPECT_TRUE(spans.empty());
+}
+
+TEST(RequestTracer, dropsWhenFull) {
+  RequestTracer tracer(1, 2);
+  for (size_t i = 0; i < 5; ++i) {
+    auto context = tracer.startTrace();
+    tracer.finishTrace(context, "get", RequestTracer::nowNs());
+  }
+  EXPECT_EQ(3, tracer.numDropped());
+
+  std::vector<RequestTracer::Span> spans;
+  tracer.drain(spans);
+  EXPECT_EQ(2, spans.size());
+}
+
+TEST(RequestTracer, otlpJson) {
+  RequestTracer::Span span;
+  span.traceIdHigh = 0x0123456789abcdef;
+  span.traceIdLow = 0xfedcba9876543210;
+  span.spanId = 0x2a;
+  span.parentSpanId = 0x10;
+  span.name = "destination|\"host\":11211";
+  span.startNs = 1000;
+  span.endNs = 2500;
+
+  std::string out;
+  RequestTracer::appendOtlpJson({span}, "libmcrouter.svc.router", out);
+  ASSERT_FALSE(out.empty());
+  EXPECT_EQ('\n', out.back());
+
+  auto json = folly::parseJson(out);
+  const auto& resourceSpans = json["resourceSpans"][0];
+  EXPECT_EQ(
+      "libmcrouter.svc.router",
+      resourceSpans["resource"]["attributes"][0]["value"]["stringValue"]
+          .asString());
+  const auto& parsed = resourceSpans["scopeSpans"][0]["spans"][0];
+  EXPECT_EQ("0123456789abcdeffedcba9876543210", parsed["traceId"].asString());
+  EXPECT_EQ("000000000000002a", parsed["spanId"].asString());
+  EXPECT_EQ("0000000000000010", parsed["parentSpanId"].asString());
+  EXPECT_EQ(span.name, parsed["name"].asString());
+  EXPECT_EQ("1000", parsed["startTimeUnixNano"].asString());
+  EXPECT_EQ("2500", parsed["endTimeUnixNano"].asString());
+}
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -12,8 +13,10 @@
 
 #include <gtest/gtest.h>
 
+#include "mcrouter/lib/BackgroundRequestQueue.h"
 #include "mcrouter/lib/HashFunctionType.h"
 #include "mcrouter/lib/HashSelector.h"
+#include "mcrouter/lib/SelectionRouteFactory.h"
 #include "mcrouter/lib/mc/msg.h"
 #include "mcrouter/lib/routes/AllAsyncRoute.h"
 #include "mcrouter/lib/routes/AllFastestRoute.h"
@@ -166,6 +169,54 @@ TEST(routeHandleTest, allAsync) {
   }
 }
 
+TEST(routeHandleTest, allAsyncDedupDeletes) {
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(DeleteRouteTestData(carbon::Result::DELETED)),
+      make_shared<TestHandle>(DeleteRouteTestData(carbon::Result::DELETED))};
+
+  TestFiberManager<TestRouterInfo> fm;
+
+  TestRouteHandle<AllAsyncRoute<TestRouteHandleIf>> rh(
+      get_route_handles(test_handles),
+      std::make_unique<RecentKeyFilter>(std::chrono::hours(1), 1000));
+
+  fm.runAll({[&]() {
+    rh.route(McDeleteRequest("key1"));
+    rh.route(McDeleteRequest("key1"));
+    rh.route(McDeleteRequest("key2"));
+    // Only deletes are deduplicated.
+    rh.route(McGetRequest("key1"));
+  }});
+
+  for (auto& h : test_handles) {
+    EXPECT_EQ((vector<string>{"key1", "key2", "key1"}), h->saw_keys);
+  }
+}
+
+TEST(routeHandleTest, backgroundRequestQueue) {
+  auto handle =
+      make_shared<TestHandle>(UpdateRouteTestData(carbon::Result::STORED));
+
+  TestFiberManager<TestRouterInfo> fm;
+
+  auto queue =
+      make_shared<BackgroundRequestQueue<TestRouteHandleIf, McAddRequest>>(
+          handle->rh, 2 /* maxQueued */, 1 /* maxSenders */);
+
+  fm.runAll({[&]() {
+    // Nothing is sent before this fiber yields, so only two fit.
+    EXPECT_TRUE(queue->enqueue(McAddRequest("key1")));
+    EXPECT_TRUE(queue->enqueue(McAddRequest("key2")));
+    EXPECT_FALSE(queue->enqueue(McAddRequest("key3")));
+  }});
+  EXPECT_EQ((vector<string>{"key1", "key2"}), handle->saw_keys);
+  EXPECT_EQ(1, queue->numDropped());
+  EXPECT_EQ(0, queue->size());
+
+  fm.runAll({[&]() { EXPECT_TRUE(queue->enqueue(McAddRequest("key4"))); }});
+  EXPECT_EQ((vector<string>{"key1", "key2", "key4"}), handle->saw_keys);
+}
+
 TEST(routeHandleTest, allInitial) {
   vector<std::shared_ptr<TestHandle>> test_handles{
       make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
@@ -261,6 +312,82 @@ TEST(routeHandleTest, allMajorityTie) {
   }
 }
 
+TEST(routeHandleTest, allInitialCancelStragglers) {
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::NOTFOUND, "b")),
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::REMOTE_ERROR, "c")),
+  };
+
+  TestFiberManager<TestRouterInfo> fm;
+  TestRouteHandle<AllInitialRoute<TestRouteHandleIf>> rh(
+      get_route_handles(test_handles), /* cancelStragglers */ true);
+
+  fm.runAll({[&]() {
+    auto reply = rh.route(McGetRequest("key"));
+    EXPECT_EQ(carbon::Result::FOUND, *reply.result_ref());
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+
+    rh.route(McDeleteRequest("key2"));
+  }});
+
+  /* Gets only went to the first child, deletes to all of them */
+  EXPECT_EQ((vector<string>{"key", "key2"}), test_handles[0]->saw_keys);
+  EXPECT_EQ(vector<string>{"key2"}, test_handles[1]->saw_keys);
+  EXPECT_EQ(vector<string>{"key2"}, test_handles[2]->saw_keys);
+}
+
+TEST(routeHandleTest, allMajorityCancelStragglers) {
+  TestFiberManager<TestRouterInfo> fm;
+
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::NOTFOUND, "b")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "c")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "d")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "e"))};
+
+  TestRouteHandle<AllMajorityRoute<TestRouteHandleIf>> rh(
+      get_route_handles(test_handles), /* cancelStragglers */ true);
+
+  fm.runAll({[&]() {
+    auto reply = rh.route(McGetRequest("key"));
+
+    /* "b" disagreed, so one more child was needed for the majority */
+    EXPECT_EQ(carbon::Result::FOUND, *reply.result_ref());
+  }});
+
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(vector<string>{"key"}, test_handles[i]->saw_keys);
+  }
+  /* The last child was never sent the request */
+  EXPECT_EQ(vector<string>{}, test_handles[4]->saw_keys);
+}
+
+TEST(routeHandleTest, allMajorityCancelStragglersNoMajority) {
+  TestFiberManager<TestRouterInfo> fm;
+
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::NOTFOUND, "b")),
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::REMOTE_ERROR, "c")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::NOTFOUND, "d"))};
+
+  TestRouteHandle<AllMajorityRoute<TestRouteHandleIf>> rh(
+      get_route_handles(test_handles), /* cancelStragglers */ true);
+
+  fm.runAll({[&]() {
+    auto reply = rh.route(McGetRequest("key"));
+    EXPECT_EQ(carbon::Result::NOTFOUND, *reply.result_ref());
+  }});
+
+  for (auto& h : test_handles) {
+    EXPECT_EQ(vector<string>{"key"}, h->saw_keys);
+  }
+}
+
 TEST(routeHandleTest, allFastest) {
   TestFiberManager<TestRouterInfo> fm;
 
@@ -381,6 +508,47 @@ TEST(routeHandleTest, hashSalt) {
   });
 }
 
+TEST(routeHandleTest, hashTypedChildren) {
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "b")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "c")),
+  };
+  using Recording = RecordingRoute<TestRouteHandleIf>;
+  using TypedRoute = TestRouteHandleIf::Impl<TypedSelectionRoute<
+      TestRouterInfo,
+      HashSelector<HashFunc>,
+      TestRouteHandleIf::Impl<Recording>>>;
+
+  auto rh = createSelectionRouteForChildType<TestRouterInfo, Recording>(
+      get_route_handles(test_handles),
+      HashSelector<HashFunc>(/* salt= */ "", HashFunc(test_handles.size())));
+  ASSERT_TRUE(std::dynamic_pointer_cast<TypedRoute>(rh));
+
+  TestFiberManager<TestRouterInfo> fm;
+  fm.run([&]() {
+    EXPECT_EQ("a", carbon::valueRangeSlow(rh->route(McGetRequest("0"))).str());
+    EXPECT_EQ("b", carbon::valueRangeSlow(rh->route(McGetRequest("1"))).str());
+    EXPECT_EQ("c", carbon::valueRangeSlow(rh->route(McGetRequest("2"))).str());
+  });
+
+  // A child of another type falls back to the regular SelectionRoute.
+  auto children = get_route_handles(test_handles);
+  children.push_back(createNullRoute<TestRouteHandleIf>());
+  auto mixed = createSelectionRouteForChildType<TestRouterInfo, Recording>(
+      std::move(children),
+      HashSelector<HashFunc>(
+          /* salt= */ "", HashFunc(test_handles.size() + 1)));
+  EXPECT_FALSE(std::dynamic_pointer_cast<TypedRoute>(mixed));
+  fm.run([&]() {
+    auto reply = mixed->route(McGetRequest("1"));
+    EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+    EXPECT_EQ(
+        carbon::Result::NOTFOUND,
+        *mixed->route(McGetRequest("3")).result_ref());
+  });
+}
+
 TEST(routeHandleTest, allSyncCollector) {
   vector<std::shared_ptr<TestHandle>> test_handles{
       make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManagerMap.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/debug/RouteProfiler.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+void spin(std::chrono::milliseconds duration) {
+  auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+RouteProfiler::Entry findEntry(
+    const RouteProfiler& profiler,
+    folly::StringPiece name) {
+  for (auto& entry : profiler.snapshot()) {
+    if (entry.name == name) {
+      return entry;
+    }
+  }
+  return RouteProfiler::Entry();
+}
+
+} // namespace
+
+TEST(RouteProfiler, separatesCpuAndWait) {
+  RouteProfiler profiler(1);
+  folly::EventBase evb;
+  auto& fm = folly::fibers::getFiberManager(evb);
+  fm.addObserver(&profiler);
+
+  fm.addTask([&] {
+    RouteProfiler::Scope outer(profiler, "outer");
+    spin(std::chrono::milliseconds(20));
+    RouteProfiler::Scope inner(profiler, "inner");
+    folly::fibers::Baton baton;
+    baton.try_wait_for(std::chrono::milliseconds(50));
+  });
+  // Runs while the first fiber waits; must not be accounted to it.
+  fm.addTask([] { spin(std::chrono::milliseconds(30)); });
+  evb.loop();
+
+  auto outer = findEntry(profiler, "outer");
+  EXPECT_EQ(1, outer.samples);
+  EXPECT_LE(70000, outer.wallUs);
+  EXPECT_LE(10000, outer.cpuUs);
+  EXPECT_GT(45000, outer.cpuUs);
+
+  auto inner = findEntry(profiler, "inner");
+  EXPECT_EQ(1, inner.samples);
+  EXPECT_GT(10000, inner.cpuUs);
+  EXPECT_LE(40000, inner.waitUs());
+}
+
+TEST(RouteProfiler, samplesWholeRequests) {
+  RouteProfiler profiler(3);
+  folly::EventBase evb;
+  auto& fm = folly::fibers::getFiberManager(evb);
+  fm.addObserver(&profiler);
+
+  for (size_t i = 0; i < 6; ++i) {
+    fm.addTask([&] {
+      RouteProfiler::Scope outer(profiler, "outer");
+      RouteProfiler::Scope inner(profiler, "inner");
+    });
+  }
+  evb.loop();
+
+  // Nested scopes belong to the request that is already sampled.
+  EXPECT_EQ(2, findEntry(profiler, "outer").samples);
+  EXPECT_EQ(2, findEntry(profiler, "inner").samples);
+
+  // Not on a fiber: never sampled.
+  { RouteProfiler::Scope scope(profiler, "main"); }
+  EXPECT_EQ(0, findEntry(profiler, "main").samples);
+
+  auto merged =
+      RouteProfiler::merge({profiler.snapshot(), profiler.snapshot()});
+  ASSERT_EQ(2, merged.size());
+  EXPECT_EQ(4, merged[0].samples);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/lib/SharedObjectCache.h"
+
+using namespace facebook::memcache;
+
+TEST(SharedObjectCache, sharesEqualKeys) {
+  SharedObjectCache<std::vector<int>> cache;
+  size_t built = 0;
+  auto factory = [&built]() {
+    ++built;
+    return std::vector<int>{1, 2, 3};
+  };
+
+  auto a = cache.getOrCreate("a", factory);
+  auto b = cache.getOrCreate("a", factory);
+  auto c = cache.getOrCreate("c", factory);
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_NE(a.get(), c.get());
+  EXPECT_EQ(2, built);
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), *c);
+}
+
+TEST(SharedObjectCache, releasesUnusedObjects) {
+  SharedObjectCache<std::string> cache;
+  size_t built = 0;
+  auto factory = [&built]() {
+    ++built;
+    return std::string("value");
+  };
+
+  cache.getOrCreate("key", factory);
+  auto value = cache.getOrCreate("key", factory);
+  // The first object was released right away, so it was built again.
+  EXPECT_EQ(2, built);
+  EXPECT_EQ("value", *value);
+
+  // Expired entries don't accumulate.
+  for (size_t i = 0; i < 1000; ++i) {
+    cache.getOrCreate(folly::to<std::string>(i), factory);
+  }
+  EXPECT_LT(cache.size(), 10);
+  EXPECT_EQ(value.get(), cache.getOrCreate("key", factory).get());
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/experimental/TestUtil.h>
+
+#include "mcrouter/lib/debug/ShmRing.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+bool writeString(ShmRingWriter& writer, const std::string& str) {
+  iovec iov{const_cast<char*>(str.data()), str.size()};
+  return writer.write(&iov, 1);
+}
+
+std::vector<std::string> readAll(ShmRingReader& reader, uint64_t& lost) {
+  std::vector<std::string> records;
+  lost += reader.read([&records](folly::ByteRange record) {
+    records.emplace_back(folly::StringPiece(record).str());
+  });
+  return records;
+}
+
+} // namespace
+
+TEST(ShmRing, readsWhatWasWritten) {
+  folly::test::TemporaryDirectory dir;
+  auto path = (dir.path() / "ring").string();
+  ShmRingWriter writer(path, 1 << 16);
+  auto reader = ShmRingReader::open(path);
+  ASSERT_NE(nullptr, reader);
+
+  EXPECT_FALSE(writer.hasReader(10000));
+  reader->heartbeat(10000, 3, "key");
+  EXPECT_TRUE(writer.hasReader(10000));
+  EXPECT_EQ(3u, writer.samplePeriod());
+  EXPECT_EQ("key", writer.match());
+
+  uint64_t lost = 0;
+  // Records go around the end of the ring several times.
+  for (size_t i = 0; i < 1000; ++i) {
+    auto str = std::string(i % 300, 'a' + i % 26);
+    ASSERT_TRUE(writeString(writer, str));
+    auto records = readAll(*reader, lost);
+    ASSERT_EQ(1, records.size());
+    EXPECT_EQ(str, records[0]);
+  }
+  EXPECT_EQ(0, lost);
+
+  // Too large to be written without splitting it.
+  EXPECT_FALSE(writeString(writer, std::string(1 << 15, 'x')));
+}
+
+TEST(ShmRing, slowReaderLosesRecords) {
+  folly::test::TemporaryDirectory dir;
+  auto path = (dir.path() / "ring").string();
+  ShmRingWriter writer(path, 1 << 16);
+  auto reader = ShmRingReader::open(path);
+  ASSERT_NE(nullptr, reader);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(writeString(writer, std::string(1000, 'x')));
+  }
+  uint64_t lost = 0;
+  EXPECT_TRUE(readAll(*reader, lost).empty());
+  EXPECT_EQ(1, lost);
+
+  // Back in sync.
+  ASSERT_TRUE(writeString(writer, "abc"));
+  auto records = readAll(*reader, lost);
+  ASSERT_EQ(1, records.size());
+  EXPECT_EQ("abc", records[0]);
+}
+
+TEST(ShmRing, rejectsOtherFiles) {
+  folly::test::TemporaryDirectory dir;
+  EXPECT_EQ(nullptr, ShmRingReader::open((dir.path() / "none").string()));
+}
@@ -6,6 +6,7 @@
  */
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -14,6 +15,7 @@
 
 #include "mcrouter/lib/Ch3HashFunc.h"
 #include "mcrouter/lib/WeightedCh4HashFunc.h"
+#include "mcrouter/lib/fbi/WeightedFurcHash.h"
 
 using namespace facebook::memcache;
 
@@ -110,3 +112,26 @@ TEST(WeightedCh4HashFunc, randomWeights) {
           {963, 1226, 305, 2371, 700, 162, 250, 105, 1615, 2303}),
       wch4_counts);
 }
+
+/* The precomputed table and the batch API give the same indices */
+TEST(WeightedCh4HashFunc, batch) {
+  std::vector<double> weights;
+  for (size_t i = 0; i < 100; ++i) {
+    weights.push_back(i % 3 ? 1.0 : 0.25 * (i % 4));
+  }
+  WeightedCh4HashFunc func(weights);
+
+  std::vector<std::string> keyStrs;
+  for (size_t i = 0; i < 1000; ++i) {
+    keyStrs.push_back(folly::to<std::string>("key", i));
+  }
+  std::vector<folly::StringPiece> keys(keyStrs.begin(), keyStrs.end());
+  std::vector<size_t> indices(keys.size());
+  func(keys, folly::range(indices));
+
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(
+        facebook::mcrouter::weightedFurcHash(keys[i], weights), indices[i]);
+    EXPECT_EQ(func(keys[i]), indices[i]);
+  }
+}
@@ -5,19 +5,26 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <string>
+#include <vector>
+
 #include <folly/Benchmark.h>
+#include <folly/Conv.h>
 #include <folly/Random.h>
 #include <folly/Range.h>
+#include <folly/dynamic.h>
 #include <folly/init/Init.h>
 
 #include "mcrouter/lib/WeightedCh3HashFunc.h"
 #include "mcrouter/lib/WeightedCh4HashFunc.h"
+#include "mcrouter/lib/WeightedRendezvousHashFunc.h"
 
 constexpr folly::StringPiece kKey =
     "someKey_ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+_sdkfjsdfksjdfasdfaksxxx";
 
 using facebook::memcache::WeightedCh3HashFunc;
 using facebook::memcache::WeightedCh4HashFunc;
+using facebook::memcache::WeightedRendezvousHashFunc;
 
 void weightedCh3Bench(size_t iters, size_t size, double weight, size_t keyLen) {
   std::vector<double> weights;
@@ -45,6 +52,74 @@ void weightedCh4Bench(size_t iters, size_t size, double weight, size_t keyLen) {
   }
 }
 
+// Hashes `kBatchSize` different keys per iteration, one at a time or with
+// the batch API.
+constexpr size_t kBatchSize = 64;
+
+void weightedCh4BatchBench(
+    size_t iters,
+    size_t size,
+    double weight,
+    bool batch) {
+  std::vector<double> weights;
+  std::vector<std::string> keyStrs;
+  std::vector<folly::StringPiece> keys;
+  std::vector<size_t> indices(kBatchSize);
+  BENCHMARK_SUSPEND {
+    // Every other endpoint gets `weight`, so both the accepted and the
+    // rejected paths get exercised.
+    for (size_t i = 0; i < size; ++i) {
+      weights.push_back(i % 2 ? weight : 1.0);
+    }
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      keyStrs.push_back(folly::to<std::string>(kKey, i));
+    }
+    keys.assign(keyStrs.begin(), keyStrs.end());
+  }
+  WeightedCh4HashFunc func(std::move(weights));
+  for (size_t i = 0; i < iters; ++i) {
+    if (batch) {
+      func(keys, folly::range(indices));
+    } else {
+      for (size_t j = 0; j < keys.size(); ++j) {
+        indices[j] = func(keys[j]);
+      }
+    }
+    folly::doNotOptimizeAway(indices);
+  }
+}
+
+// Half of the endpoints get `weight`, the other half 1.0.
+void weightedRendezvousBench(
+    size_t iters,
+    size_t size,
+    double weight,
+    size_t keyLen,
+    size_t lookupTableSize = 0) {
+  std::vector<std::string> names;
+  std::vector<folly::StringPiece> endpoints;
+  folly::dynamic json = folly::dynamic::object;
+  BENCHMARK_SUSPEND {
+    folly::dynamic weights = folly::dynamic::array;
+    for (size_t i = 0; i < size; ++i) {
+      names.push_back(folly::to<std::string>("10.0.0.", i, ":11211"));
+      weights.push_back(i % 2 ? weight : 1.0);
+    }
+    endpoints.assign(names.begin(), names.end());
+    json["weights"] = std::move(weights);
+    json["lookup_table_size"] = lookupTableSize;
+  }
+  folly::StringPiece key =
+      kKey.subpiece(0, keyLen ? keyLen : folly::StringPiece::npos);
+  WeightedRendezvousHashFunc func(endpoints, json);
+  for (size_t i = 0; i < iters; ++i) {
+    func(key);
+  }
+}
+
+BENCHMARK_NAMED_PARAM(weightedCh3Bench, size_10, 10, 1.0, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(weightedCh4Bench, size_10, 10, 1.0, 0)
+
 BENCHMARK_NAMED_PARAM(weightedCh3Bench, size_100, 100, 1.0, 0)
 BENCHMARK_RELATIVE_NAMED_PARAM(weightedCh4Bench, size_100, 100, 1.0, 0)
 
@@ -56,6 +131,9 @@ BENCHMARK_RELATIVE_NAMED_PARAM(weightedCh4Bench, size_10000, 10000, 1.0, 0)
 
 BENCHMARK_DRAW_LINE();
 
+BENCHMARK_NAMED_PARAM(weightedCh3Bench, size_10_05, 10, 0.5, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(weightedCh4Bench, size_10_05, 10, 0.5, 0)
+
 BENCHMARK_NAMED_PARAM(weightedCh3Bench, size_100_05, 100, 0.5, 0)
 BENCHMARK_RELATIVE_NAMED_PARAM(weightedCh4Bench, size_100_05, 100, 0.5, 0)
 
@@ -120,6 +198,80 @@ BENCHMARK_RELATIVE_NAMED_PARAM(
 
 BENCHMARK_DRAW_LINE();
 
+BENCHMARK_NAMED_PARAM(weightedCh4BatchBench, size_10, 10, 0.5, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedCh4BatchBench,
+    size_10_batch,
+    10,
+    0.5,
+    true)
+
+BENCHMARK_NAMED_PARAM(weightedCh4BatchBench, size_100, 100, 0.5, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedCh4BatchBench,
+    size_100_batch,
+    100,
+    0.5,
+    true)
+
+BENCHMARK_NAMED_PARAM(weightedCh4BatchBench, size_1000, 1000, 0.5, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedCh4BatchBench,
+    size_1000_batch,
+    1000,
+    0.5,
+    true)
+
+BENCHMARK_NAMED_PARAM(weightedCh4BatchBench, size_10000, 10000, 0.5, false)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedCh4BatchBench,
+    size_10000_batch,
+    10000,
+    0.5,
+    true)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(weightedCh3Bench, rv_size_100, 100, 1.0, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(weightedRendezvousBench, size_100, 100, 1.0, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedRendezvousBench,
+    size_100_05,
+    100,
+    0.5,
+    0)
+
+BENCHMARK_NAMED_PARAM(weightedCh3Bench, rv_size_1000, 1000, 1.0, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(weightedRendezvousBench, size_1000, 1000, 1.0, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedRendezvousBench,
+    size_1000_05,
+    1000,
+    0.5,
+    0)
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK_NAMED_PARAM(weightedRendezvousBench, size_500, 500, 0.5, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedRendezvousBench,
+    size_500_table,
+    500,
+    0.5,
+    0,
+    65537)
+
+BENCHMARK_NAMED_PARAM(weightedRendezvousBench, size_5000, 5000, 0.5, 0)
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    weightedRendezvousBench,
+    size_5000_table,
+    5000,
+    0.5,
+    0,
+    655373)
+
+BENCHMARK_DRAW_LINE();
+
 int main(int argc, char** argv) {
   folly::init(&argc, &argv, true);
 
@@ -87,6 +87,22 @@ TEST(WeightedRendezvousHashFunc, rendezvous_3) {
   EXPECT_EQ(rendezvousCounts, std::vector<size_t>({6737, 0, 3263}));
 }
 
+TEST(WeightedRendezvousHashFunc, uniformWeights) {
+  // Any equal non-zero weight must select exactly like weight 1.
+  auto endpoints = genEndpoints(343);
+  auto func1 = WeightedRendezvousHashFunc(
+      endpoints.second, genWeights(std::vector<double>(343, 1)));
+  auto func05 = WeightedRendezvousHashFunc(
+      endpoints.second, genWeights(std::vector<double>(343, 0.5)));
+  auto func0 = WeightedRendezvousHashFunc(
+      endpoints.second, genWeights(std::vector<double>(343, 0)));
+  for (size_t i = 0; i < 10000; ++i) {
+    auto key = "mykey:" + folly::to<std::string>(i);
+    EXPECT_EQ(func1(key), func05(key));
+    EXPECT_EQ(0, func0(key));
+  }
+}
+
 TEST(WeightedRendezvousHashFunc, rendezvous_10) {
   // 10 endpoints with different weights.
   auto endpoints10 = genEndpoints(10);
@@ -143,6 +159,59 @@ TEST(WeightedRendezvousHashFunc, rendezvous_rehash) {
   EXPECT_EQ(removeCompare(midRemoved, midRemoved.begin() + n / 2), 21);
 }
 
+TEST(WeightedRendezvousHashFunc, lookupTable) {
+  auto endpoints10 = genEndpoints(10);
+  std::vector<double> weights10{1, 1, 1, 1, 1, 0.5, 0.5, 0.5, 0.5, 0};
+  auto jWeight10 = genWeights(weights10);
+  jWeight10["lookup_table_size"] = 65537;
+  auto rendezvous10 = WeightedRendezvousHashFunc(endpoints10.second, jWeight10);
+
+  std::vector<size_t> rendezvousCounts(10, 0);
+  for (size_t i = 0; i < 10000; ++i) {
+    auto key = "mykey:" + folly::to<std::string>(i);
+    ++rendezvousCounts[rendezvous10(key)];
+  }
+  // 10000 keys over a total weight of 7.
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_NEAR(10000 * weights10[i] / 7, rendezvousCounts[i], 200);
+  }
+  EXPECT_EQ(0, rendezvousCounts[9]);
+}
+
+TEST(WeightedRendezvousHashFunc, lookupTable_rehash) {
+  const uint32_t n = 499;
+  auto combined = genEndpoints(n);
+  const auto& endpoints = combined.second;
+  auto jWeights = genWeights(std::vector<double>(n, 1));
+  jWeights["lookup_table_size"] = 65537;
+  auto rendezvous = WeightedRendezvousHashFunc(endpoints, jWeights);
+
+  auto newEndpoints = endpoints;
+  newEndpoints.erase(newEndpoints.begin() + n / 2);
+  auto newJWeights = genWeights(std::vector<double>(n - 1, 1));
+  newJWeights["lookup_table_size"] = 65537;
+  auto newRendezvous = WeightedRendezvousHashFunc(newEndpoints, newJWeights);
+
+  int numDiff = 0;
+  for (size_t i = 0; i < 10000; ++i) {
+    auto key = "mykey:" + folly::to<std::string>(i);
+    if (endpoints[rendezvous(key)] != newEndpoints[newRendezvous(key)]) {
+      ++numDiff;
+    }
+  }
+  // Ideally 10000 / 499 keys move; Maglev adds some churn on top of that.
+  EXPECT_LT(numDiff, 300);
+}
+
+TEST(WeightedRendezvousHashFunc, lookupTable_invalidSize) {
+  auto endpoints = genEndpoints(10);
+  auto jWeights = genWeights(std::vector<double>(10, 1));
+  jWeights["lookup_table_size"] = 65536;
+  EXPECT_ANY_THROW(WeightedRendezvousHashFunc(endpoints.second, jWeights));
+  jWeights["lookup_table_size"] = 7;
+  EXPECT_ANY_THROW(WeightedRendezvousHashFunc(endpoints.second, jWeights));
+}
+
 } // namespace test
 } // namespace memcache
 } // namespace facebook
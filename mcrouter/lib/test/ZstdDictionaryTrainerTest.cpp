@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Format.h>
+#include <folly/io/IOBuf.h>
+
+#include "mcrouter/lib/ZstdDictionaryTrainer.h"
+
+using namespace facebook::memcache;
+
+namespace {
+
+folly::IOBuf makeValue(size_t i) {
+  return folly::IOBuf(
+      folly::IOBuf::COPY_BUFFER,
+      folly::sformat(
+          "{{\"id\":{},\"name\":\"user{}\",\"active\":true,"
+          "\"tags\":[\"a\",\"b\"]}}",
+          i,
+          i % 97));
+}
+
+} // namespace
+
+TEST(ZstdDictionaryTrainer, reservoirIsBounded) {
+  ZstdDictionaryTrainer trainer(4096, 1024);
+  for (size_t i = 0; i < 10000; ++i) {
+    trainer.addSample(makeValue(i));
+  }
+  trainer.addSample(folly::IOBuf(
+      folly::IOBuf::COPY_BUFFER, std::string(2048, 'x'))); // too big
+
+  auto samples = trainer.takeSamples();
+  size_t bytes = 0;
+  for (const auto& sample : samples) {
+    EXPECT_LE(sample.size(), 1024);
+    bytes += sample.size();
+  }
+  EXPECT_FALSE(samples.empty());
+  EXPECT_LE(bytes, 4096);
+  EXPECT_EQ(0, trainer.numSamples());
+}
+
+TEST(ZstdDictionaryTrainer, train) {
+  ZstdDictionaryTrainer trainer(1024 * 1024, 1024);
+  for (size_t i = 0; i < 5000; ++i) {
+    trainer.addSample(makeValue(i));
+  }
+  auto dictionary = ZstdDictionaryTrainer::train(trainer.takeSamples(), 4096);
+#if FOLLY_HAVE_LIBZSTD && !defined(DISABLE_COMPRESSION)
+  ASSERT_TRUE(dictionary.has_value());
+  EXPECT_FALSE(dictionary->empty());
+  EXPECT_LE(dictionary->size(), 4096);
+#else
+  EXPECT_FALSE(dictionary.has_value());
+#endif
+
+  EXPECT_FALSE(ZstdDictionaryTrainer::train({}, 4096).has_value());
+}
@@ -76,6 +76,31 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Enable using the asynclog version 2.0")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    asynclog_batch_size,
+    128,
+    "asynclog-batch-size",
+    no_short,
+    "Maximum number of asynclog entries appended with a single write. Entries"
+    " queued while the previous write is in progress are batched together."
+    " 1 writes every entry on its own.")
+
+MCROUTER_OPTION_TOGGLE(
+    asynclog_binary,
+    false,
+    "asynclog-binary",
+    no_short,
+    "Write asynclog files in the checksummed binary format read by"
+    " AsyncLogSpoolReader (files get a .bin suffix) instead of json lines.")
+
+MCROUTER_OPTION_TOGGLE(
+    asynclog_binary_compression,
+    false,
+    "asynclog-binary-compression",
+    no_short,
+    "Compress blocks of binary asynclog files with LZ4.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     num_proxies,
@@ -112,6 +137,125 @@ MCROUTER_OPTION_INTEGER(
     "Force client queue notification if last drain was at least this long ago."
     "  If 0, this logic is disabled.")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    client_queue_backpressure_watermark,
+    0,
+    no_long,
+    no_short,
+    "CarbonRouterClient::trySend() doesn't send requests to a proxy with at"
+    " least this many requests in its client queue, and signals backpressure"
+    " instead. If 0, 3/4 of client_queue_size is used.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    client_queue_spin_poll_us,
+    0,
+    "client-queue-spin-poll-us",
+    no_short,
+    "After draining the client queue, keep polling it from the proxy event"
+    " loop for this many us before going idle. Clients don't need to send"
+    " eventfd notifications while the proxy is polling."
+    "  If 0, this logic is disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_request_arena_size,
+    512,
+    "proxy-request-arena-size",
+    no_short,
+    "Bytes of per-request arena allocated together with each proxy request"
+    " context. Request-scoped state (e.g. the context's reference count) is"
+    " placed there and freed in one step with the context."
+    "  If 0, request contexts are allocated the regular way.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    hot_keys_sample_period,
+    0,
+    "hot-keys-sample-period",
+    no_short,
+    "Record the key of one out of every N requests in the per-proxy hot key"
+    " sketch, which is reported by 'stats hotkeys'. If 0, hot key tracking"
+    " is disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    hot_keys_capacity,
+    128,
+    "hot-keys-capacity",
+    no_short,
+    "Number of keys tracked by each proxy's hot key sketch.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    client_stats_sample_period,
+    0,
+    "client-stats-sample-period",
+    no_short,
+    "Account one out of every N replies to the client that sent the request"
+    " (SSL common name, else IP address): requests, bytes in and out and"
+    " time spent in the proxy, reported by 'stats clients'. If 0, per-client"
+    " accounting is disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    client_stats_capacity,
+    64,
+    "client-stats-capacity",
+    no_short,
+    "Number of clients tracked by each proxy for 'stats clients'.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    worst_destinations_count,
+    0,
+    "worst-destinations-count",
+    no_short,
+    "Number of destinations with the highest latency (errors counted as"
+    " timeouts) tracked by each proxy, which are reported by"
+    " 'stats worst_servers'. If 0, worst destination tracking is disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    route_profile_sample_period,
+    0,
+    "route-profile-sample-period",
+    no_short,
+    "Profile one out of every N requests: record the wall and CPU time spent"
+    " in every route handle they go through, aggregated by route name and"
+    " reported by 'stats route_profile' (and written to the route_profile"
+    " debug fifo if debug-fifo-root is set). If 0, profiling is disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    trace_sample_period,
+    0,
+    "trace-sample-period",
+    no_short,
+    "Trace one out of every N requests: record spans for the request, every"
+    " route handle it goes through and every destination it is sent to, and"
+    " write them in the OTLP/JSON format to the request_traces debug fifo"
+    " (requires debug-fifo-root). If 0, tracing is disabled.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    trace_buffer_size,
+    8192,
+    "trace-buffer-size",
+    no_short,
+    "Number of finished spans each proxy buffers until they are exported."
+    " Spans are dropped when the buffer is full.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    trace_export_interval_ms,
+    1000,
+    "trace-export-interval-ms",
+    no_short,
+    "Time in ms between exports of the buffered spans, see"
+    " trace-sample-period.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     big_value_split_threshold,
@@ -130,6 +274,26 @@ MCROUTER_OPTION_INTEGER(
     "If nonzero, big value chunks are written/read in batches of at most"
     " this size.  Used to prevent queue build up with really large values")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    big_value_max_window,
+    0,
+    "big-value-max-window",
+    no_short,
+    "If nonzero, big value chunks are sent through a sliding window instead"
+    " of in batches: a new chunk is sent as soon as one completes. The window"
+    " adapts to chunk latency, from 1 up to this many chunks in flight.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    big_value_compression_level,
+    0,
+    "big-value-compression-level",
+    no_short,
+    "If nonzero, big values are compressed with ZSTD at this level before"
+    " being split into chunks, and uncompressed after reassembly. Values"
+    " written this way can only be read by mcrouters that support it.")
+
 MCROUTER_OPTION_TOGGLE(
     big_value_hide_reply_flag,
     false,
@@ -138,6 +302,16 @@ MCROUTER_OPTION_TOGGLE(
     "If enabled, the reply flags will not contain MC_MSG_FLAG_BIG_VALUE in"
     " case of a big value.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    big_value_retry_budget_percent,
+    0,
+    "big-value-retry-budget-percent",
+    no_short,
+    "If non-zero, lease-get retries of big values are limited to this"
+    " percentage of successful lease-gets over the last 10 seconds, shared by"
+    " all proxies. 0 means no limit.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     fibers_max_pool_size,
@@ -155,6 +329,26 @@ MCROUTER_OPTION_INTEGER(
     "Size of stack in bytes to allocate per fiber."
     " 0 means use fibers library default.")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    fibers_large_stack_size,
+    0,
+    "fibers-large-stack-size",
+    no_short,
+    "If non-zero, every proxy runs a second fiber pool with stacks of this"
+    " size, used for requests of configs whose route tree is at least"
+    " fibers-large-stack-route-height deep. Allows a smaller"
+    " fibers-stack-size for everything else.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    fibers_large_stack_route_height,
+    12,
+    "fibers-large-stack-route-height",
+    no_short,
+    "Route tree height (number of nested route handles) from which requests"
+    " are routed on fibers-large-stack-size stacks.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     fibers_record_stack_size_every,
@@ -171,6 +365,16 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "If enabled, protect limited amount of fiber stacks with guard pages")
 
+MCROUTER_OPTION_TOGGLE(
+    fibers_prewarm_pool,
+    false,
+    "fibers-prewarm-pool",
+    no_short,
+    "Create fibers-max-pool-size fibers (with their stacks) on every proxy at"
+    " startup, so that the first burst of traffic doesn't pay for creating"
+    " them. Fibers still unused after fibers-pool-resize-period-ms are freed"
+    " by the periodic pool resizing.")
+
 MCROUTER_OPTION_STRING(
     runtime_vars_file,
     MCROUTER_RUNTIME_VARS_DEFAULT,
@@ -240,6 +444,24 @@ MCROUTER_OPTION_INTEGER(
     "Maximum number of non-blocking event loops before we flush batched "
     "requests")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    max_no_flush_us,
+    0,
+    "max-no-flush-us",
+    no_short,
+    "If nonzero, batched requests are also flushed once the oldest of them"
+    " waited this long, whatever max-no-flush-event-loops says.")
+
+MCROUTER_OPTION_TOGGLE(
+    target_write_idle_immediately,
+    false,
+    "target-write-idle-immediately",
+    no_short,
+    "Write requests to a target with no request in flight right away, instead"
+    " of batching them with the writes to other targets. Lowers latency at low"
+    " load, when there is little to batch anyway.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     reset_inactive_connection_interval,
@@ -249,6 +471,126 @@ MCROUTER_OPTION_INTEGER(
     "Will close open connections without any activity after at most 2 * interval"
     " ms. If value is 0, connections won't be closed.")
 
+MCROUTER_OPTION_TOGGLE(
+    reset_inactive_connection_spread,
+    false,
+    "reset-inactive-connection-spread",
+    no_short,
+    "Instead of closing all the inactive connections at once every"
+    " reset-inactive-connection-interval, spread closing them over the next"
+    " interval, at jittered times. Connections are then closed after at most"
+    " 3 * interval ms without activity.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    reset_inactive_ssl_connection_intervals,
+    1,
+    "reset-inactive-ssl-connection-intervals",
+    no_short,
+    "SSL connections, which are more expensive to reestablish, are only"
+    " closed once inactive for this many reset-inactive-connection-interval.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    reset_inactive_connection_max_per_sec,
+    0,
+    "reset-inactive-connection-max-per-sec",
+    no_short,
+    "Maximum number of inactive connections each proxy closes per second,"
+    " to bound the reconnects that follow. If 0, there is no limit.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    host_resolution_ttl_ms,
+    60000,
+    "host-resolution-ttl-ms",
+    no_short,
+    "Destinations configured by hostname are resolved in the background when"
+    " the config is loaded, and their addresses are refreshed in the"
+    " background once older than this many ms. Shared by all the router"
+    " instances of the process. If 0, hostnames are resolved on every"
+    " connect.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    connections_per_destination,
+    1,
+    "connections-per-destination",
+    no_short,
+    "Maximum number of connections each proxy opens to a single destination."
+    " Requests go to the connection with the fewest outstanding requests;"
+    " extra connections are only opened under load and are closed when"
+    " inactive (see reset-inactive-connection-interval). Can be overridden"
+    " per pool with 'connections_per_server'.")
+
+MCROUTER_OPTION_TOGGLE(
+    shared_cold_connections,
+    false,
+    "shared-cold-connections",
+    no_short,
+    "Serve low-traffic destinations through a single connection owned by one"
+    " proxy (picked by hashing the destination) instead of one connection per"
+    " proxy. Other proxies hand their requests over to the owner's event loop."
+    " A destination gets its own connection in a proxy once that proxy sends"
+    " it more than shared-connection-promote-rps requests per second.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    shared_connection_promote_rps,
+    100,
+    "shared-connection-promote-rps",
+    no_short,
+    "With shared-cold-connections, requests per second from a single proxy"
+    " above which a destination stops using the shared connection.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    standby_keepalive_interval_ms,
+    10000,
+    "standby-keepalive-interval-ms",
+    no_short,
+    "Destinations of pools with 'standby' set (e.g. failover targets) keep"
+    " their connections open even when inactive. Every this many ms, each"
+    " proxy sends a version request to those that had no traffic during the"
+    " current reset-inactive-connection-interval or are not connected, so"
+    " that connections are opened ahead of time and kept alive. If 0, no"
+    " keepalives are sent, and connections are only opened on demand.")
+
+MCROUTER_OPTION_TOGGLE(
+    prewarm_connections,
+    false,
+    "prewarm-connections",
+    no_short,
+    "Open connections (including TLS handshakes) to destinations in the config"
+    " in the background after startup and after every reconfiguration, instead"
+    " of on the first request.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    prewarm_connections_percent,
+    100,
+    "prewarm-connections-percent",
+    no_short,
+    "Percentage of new destinations to pre-warm, picked at random.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    prewarm_connections_per_second,
+    100,
+    "prewarm-connections-per-second",
+    no_short,
+    "Maximum number of connections each proxy opens per second when"
+    " pre-warming.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    prewarm_connections_timeout_ms,
+    5000,
+    "prewarm-connections-timeout-ms",
+    no_short,
+    "On startup, wait at most this long for pre-warming to finish before"
+    " mcrouter is ready to serve requests. 0 to not wait.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     tcp_rto_min,
@@ -277,6 +619,44 @@ MCROUTER_OPTION_INTEGER(
     " per target per thread.  Requests that would exceed this limit are dropped"
     " immediately.")
 
+MCROUTER_OPTION_TOGGLE(
+    target_expire_pending_requests,
+    false,
+    "target-expire-pending-requests",
+    no_short,
+    "Only active if target-max-inflight-requests is nonzero. Time spent in"
+    " the queue of a target counts against the request timeout: requests"
+    " whose timeout elapsed while queued are failed without being sent.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    target_pending_lifo_threshold,
+    0,
+    "target-pending-lifo-threshold",
+    no_short,
+    "Only active if target-max-inflight-requests is nonzero. Once this many"
+    " requests are queued for a target, the most recent ones are sent first,"
+    " since the oldest are the likeliest to time out anyway (0 to disable).")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    target_write_batch_max_bytes,
+    24576,
+    "target-write-batch-max-bytes",
+    no_short,
+    "Requests queued to the same target within one event loop iteration"
+    " (e.g. the keys of a multiget) are written to the socket together, up to"
+    " this many bytes per write.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    target_write_batch_max_iovecs,
+    128,
+    "target-write-batch-max-iovecs",
+    no_short,
+    "Maximum number of iovecs per write when batching requests to the same"
+    " target, see target-write-batch-max-bytes. Capped to IOV_MAX.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     target_max_shadow_requests,
@@ -297,6 +677,39 @@ MCROUTER_OPTION_INTEGER(
     " in parallel by each proxy thread.  Requests over limit will be queued up"
     " until the number of inflight requests drops.")
 
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_critical_priority_weight,
+    0,
+    "proxy-critical-priority-weight",
+    no_short,
+    "Only active if proxy-max-inflight-requests is non-zero. When requests of"
+    " both priorities are queued, this many critical requests are let through"
+    " for every async (e.g. batch) one. 0 means async requests wait until no"
+    " critical request is queued.")
+
+MCROUTER_OPTION_TOGGLE(
+    proxy_fair_queueing,
+    false,
+    "proxy-fair-queueing",
+    no_short,
+    "Only active if proxy-max-inflight-requests is non-zero. Requests waiting"
+    " for the inflight limit are let through round robin across clients"
+    " (identified by SSL common name, or by address without SSL) instead of"
+    " in arrival order, so that a burst from one client doesn't delay all the"
+    " others.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_max_inflight_async_requests,
+    0,
+    "proxy-max-inflight-async-requests",
+    no_short,
+    "Only active if proxy-max-inflight-requests is non-zero. Max number of"
+    " async priority requests routed in parallel by each proxy, so that the"
+    " rest of proxy-max-inflight-requests is kept for critical requests."
+    " 0 means async requests share the whole limit.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     proxy_max_inflight_shadow_requests,
@@ -307,6 +720,98 @@ MCROUTER_OPTION_INTEGER(
     " on each proxy thread.  Shadow requests over the limit will be dropped and"
     " an error reply sent.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    shadow_shed_loop_time_us,
+    0,
+    "shadow-shed-loop-time-us",
+    no_short,
+    "If non-zero, shadow requests start being dropped when the average event"
+    " loop time of a proxy thread goes over this many microseconds, and are all"
+    " dropped at twice that.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    shadow_shed_cpu_percent,
+    0,
+    "shadow-shed-cpu-percent",
+    no_short,
+    "If non-zero, shadow requests start being dropped when the host CPU load"
+    " goes over this percentage, and are all dropped at 100%. Requires a source"
+    " of host load (e.g. --server-load-interval-ms in standalone mode).")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    shadow_shed_fibers_percent,
+    0,
+    "shadow-shed-fibers-percent",
+    no_short,
+    "If non-zero, shadow requests start being dropped when the number of fibers"
+    " allocated by a proxy goes over this percentage of fibers-max-pool-size,"
+    " and are all dropped at twice that.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    shadow_shed_queue_delay_us,
+    0,
+    "shadow-shed-queue-delay-us",
+    no_short,
+    "If non-zero, shadow requests start being dropped when the 99th percentile"
+    " of the time requests wait for a proxy to start routing them goes over"
+    " this many microseconds, and are all dropped at twice that. Unlike loop"
+    " time, this only grows when the proxy thread itself can't keep up.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_queue_delay_target_us,
+    0,
+    "proxy-queue-delay-target-us",
+    no_short,
+    "If non-zero, a proxy is considered overloaded once all requests waited"
+    " longer than this to start being routed for proxy-queue-delay-interval-ms"
+    " (CoDel target delay). In standalone mode an overloaded proxy stops"
+    " reading from client connections.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_queue_delay_interval_ms,
+    100,
+    "proxy-queue-delay-interval-ms",
+    no_short,
+    "See proxy-queue-delay-target-us.")
+
+MCROUTER_OPTION_TOGGLE(
+    proxy_scheduling_histograms,
+    false,
+    "proxy-scheduling-histograms",
+    no_short,
+    "Record histograms of event loop iteration time, request queue delay"
+    " (from being queued to its fiber starting) and fiber run time of every"
+    " proxy, exported as proxy_loop_time_us_*, proxy_queue_delay_us_* and"
+    " proxy_fiber_run_us_* percentile stats.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_overload_fibers_percent,
+    0,
+    "proxy-overload-fibers-percent",
+    no_short,
+    "If non-zero, a proxy is considered overloaded while the number of fibers"
+    " it allocated is over this percentage of fibers-max-pool-size. In"
+    " standalone mode an overloaded proxy stops reading from client"
+    " connections.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    proxy_max_inflight_bytes,
+    0,
+    "proxy-max-inflight-bytes",
+    no_short,
+    "If non-zero, a proxy is considered overloaded while the keys and values"
+    " of the requests it is queueing or routing add up to more than this many"
+    " bytes (see the proxy_inflight_bytes stat). In standalone mode an"
+    " overloaded proxy stops reading from client connections.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     proxy_max_throttled_requests,
@@ -409,6 +914,25 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "If enabled, limited number of SSL sessions will be cached")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    ssl_connection_cache_size,
+    100,
+    "ssl-connection-cache-size",
+    no_short,
+    "Maximum number of SSL sessions cached with ssl-connection-cache. The"
+    " cache is shared by all proxies.")
+
+MCROUTER_OPTION_STRING(
+    ssl_connection_cache_file,
+    "",
+    "ssl-connection-cache-file",
+    no_short,
+    "If not empty, SSL sessions cached with ssl-connection-cache are saved to"
+    " this file every few seconds and loaded from it on startup, so that"
+    " connections opened after a restart can resume their sessions. Only TLS"
+    " 1.2 sessions are saved.")
+
 MCROUTER_OPTION_TOGGLE(
     ssl_handshake_offload,
     false,
@@ -432,6 +956,79 @@ MCROUTER_OPTION_TOGGLE(
     "compression algorithms/dictionaries supported by the client. Only "
     "compresses caret protocol replies.")
 
+MCROUTER_OPTION_TOGGLE(
+    negotiate_compression,
+    false,
+    "negotiate-compression",
+    no_short,
+    "If enabled (and compression is enabled), the compression codecs"
+    " supported by mcrouter are announced once per caret connection to"
+    " compressed destinations, instead of in every request. Destinations"
+    " must support it.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    decompression_offload_threshold,
+    0,
+    "decompression-offload-threshold",
+    no_short,
+    "If non-zero (and compression is enabled), compressed replies from"
+    " destinations that are at least this many bytes once uncompressed are"
+    " decompressed on the auxiliary CPU thread pool, so that they don't stall"
+    " the other requests of the proxy.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    compression_dictionary_training_interval_s,
+    0,
+    "compression-dictionary-training-interval-s",
+    no_short,
+    "If non-zero (and compression is enabled), values of replies from"
+    " compressed pools are sampled and a new ZSTD dictionary is trained from"
+    " them this often. Each dictionary is added as a new codec id, so peers"
+    " using older dictionaries keep working.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    compression_dictionary_sample_period,
+    100,
+    "compression-dictionary-sample-period",
+    no_short,
+    "Sample one out of this many replies for dictionary training.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    compression_dictionary_sample_bytes,
+    4 * 1024 * 1024,
+    "compression-dictionary-sample-bytes",
+    no_short,
+    "Maximum total size of the values kept for dictionary training.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    compression_dictionary_max_value_size,
+    16 * 1024,
+    "compression-dictionary-max-value-size",
+    no_short,
+    "Values bigger than this are not sampled for dictionary training.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    compression_dictionary_size,
+    64 * 1024,
+    "compression-dictionary-size",
+    no_short,
+    "Maximum size of trained compression dictionaries.")
+
+MCROUTER_OPTION_STRING(
+    compression_dictionary_dir,
+    "",
+    "compression-dictionary-dir",
+    no_short,
+    "If set, trained compression dictionaries are also written to this"
+    " directory as <router_name>.<codec_id>.dict, so that they can be"
+    " distributed to other tiers.")
+
 MCROUTER_OPTION_GROUP("Routing configuration")
 
 MCROUTER_OPTION_TOGGLE(
@@ -465,6 +1062,15 @@ MCROUTER_OPTION_STRING(
     "Directory where the last valid config will be saved. "
     "Empty string to disable.")
 
+MCROUTER_OPTION_TOGGLE(
+    config_snapshot,
+    false,
+    "config-snapshot",
+    no_short,
+    "Save a binary snapshot of the preprocessed config under config-dump-root,"
+    " and use it on startup instead of expanding macros again if the config,"
+    " its imports and the preprocessor params haven't changed.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     max_dumped_config_age,
@@ -542,6 +1148,24 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Enable flush_all command")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    broadcast_max_outstanding,
+    0,
+    "broadcast-max-outstanding",
+    no_short,
+    "Most destinations a proxy waits on at once for a request sent to every"
+    " destination of the config (flush_all). 0 sends to all of them at once.")
+
+MCROUTER_OPTION_TOGGLE(
+    broadcast_spread_proxies,
+    false,
+    "broadcast-spread-proxies",
+    no_short,
+    "Split the destinations of a request sent to every destination of the"
+    " config (flush_all) across all proxies, instead of sending it from the"
+    " proxy that received it.")
+
 MCROUTER_OPTION_TOGGLE(
     disable_request_deadline_check,
     false,
@@ -549,6 +1173,35 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Disable request deadline functionality")
 
+MCROUTER_OPTION_TOGGLE(
+    send_timeout_budget,
+    false,
+    "send-timeout-budget",
+    no_short,
+    "Tell caret destinations how long the reply of each request is waited"
+    " for, so that a downstream mcrouter drops requests once their client"
+    " gave up and clamps its own timeouts to what is left. Budgets received"
+    " from clients are honored unless disable-request-deadline-check is set.")
+
+MCROUTER_OPTION_TOGGLE(
+    caret_compact_header,
+    false,
+    "caret-compact-header",
+    no_short,
+    "Send caret requests with the compact header, which carries a bitmask of"
+    " the additional fields present instead of a (type, value) pair for each"
+    " of them. Servers reply in the header format of the request. Only enable"
+    " once all caret destinations understand it.")
+
+MCROUTER_OPTION_TOGGLE(
+    ascii_meta_protocol,
+    false,
+    "ascii-meta-protocol",
+    no_short,
+    "Send get, gets, gat, gats, storage and delete requests to ascii"
+    " destinations as meta commands (mg, ms, md). Only enable if all ascii"
+    " destinations are memcached servers that support the meta protocol.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     reconfiguration_delay_ms,
@@ -557,6 +1210,24 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Delay between config files change and mcrouter reconfiguration.")
 
+MCROUTER_OPTION_INTEGER(
+    int,
+    reconfiguration_debounce_max_ms,
+    0,
+    "reconfiguration-debounce-max-ms",
+    no_short,
+    "If the config files keep changing during reconfiguration-delay-ms, wait"
+    " for another reconfiguration-delay-ms until they stop changing, for at"
+    " most this many ms, so that a push of several files reconfigures once.")
+
+MCROUTER_OPTION_TOGGLE(
+    skip_unchanged_config_reloads,
+    false,
+    "skip-unchanged-config-reloads",
+    no_short,
+    "Don't reconfigure when the config files were updated but their contents"
+    " are the same as the ones of the current config.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     reconfiguration_jitter_ms,
@@ -574,6 +1245,23 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Delay after a reconfiguration is complete.")
 
+MCROUTER_OPTION_TOGGLE(
+    parallel_config_build,
+    false,
+    "parallel-config-build",
+    no_short,
+    "Build the configs of all proxies but the first one in parallel on the"
+    " auxiliary CPU thread pool when reconfiguring.")
+
+MCROUTER_OPTION_TOGGLE(
+    destroy_old_configs_off_thread,
+    false,
+    "destroy-old-configs-off-thread",
+    no_short,
+    "Destroy the route trees of replaced configs on the auxiliary CPU thread"
+    " pool instead of the proxy threads. Destinations no longer in the"
+    " config are still destroyed on their proxy thread.")
+
 MCROUTER_OPTION_STRING_MAP(
     config_params,
     "config-params",
@@ -616,6 +1304,37 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Mark as TKO after this many failures")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    degraded_error_rate_percent,
+    0,
+    "degraded-error-rate-percent",
+    no_short,
+    "If non-zero, a destination whose recent rate of TKO-class errors"
+    " (timeouts, connect errors, ...) is above this percentage is degraded:"
+    " it gets proportionally less traffic, the rest is answered with a TKO"
+    " reply (and fails over where configured), until it recovers or is"
+    " marked TKO.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    degraded_latency_ms,
+    0,
+    "degraded-latency-ms",
+    no_short,
+    "If non-zero, a destination whose average latency is above this many ms"
+    " is degraded, getting a share of traffic inversely proportional to its"
+    " latency.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    degraded_min_send_percent,
+    10,
+    "degraded-min-send-percent",
+    no_short,
+    "Percentage of requests still sent to a degraded destination however bad"
+    " it looks, so that its recovery is noticed.")
+
 MCROUTER_OPTION_TOGGLE(
     allow_only_gets,
     false,
@@ -635,6 +1354,33 @@ MCROUTER_OPTION_INTEGER(
     "Timeout for talking to destination servers (e.g. memcached), "
     "in milliseconds. Must be greater than 0.")
 
+MCROUTER_OPTION_TOGGLE(
+    adaptive_timeouts,
+    false,
+    "adaptive-timeouts",
+    no_short,
+    "If enabled, requests to a destination use a timeout of"
+    " adaptive-timeout-p99-percent% of the p99 latency observed for that"
+    " destination (at least adaptive-timeout-floor-ms), but never more than"
+    " the configured timeout.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    adaptive_timeout_p99_percent,
+    300,
+    "adaptive-timeout-p99-percent",
+    no_short,
+    "With adaptive-timeouts, timeout as a percentage of the observed p99"
+    " latency.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    adaptive_timeout_floor_ms,
+    10,
+    "adaptive-timeout-floor-ms",
+    no_short,
+    "With adaptive-timeouts, minimum timeout in ms.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     cross_region_timeout_ms,
@@ -682,8 +1428,47 @@ MCROUTER_OPTION_INTEGER(
     " connect timeout. We will just return the result back to the client after"
     " either the connection is esblished, or we exhausted all retries.")
 
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    alternate_address_connect_timeout_ms,
+    0,
+    "alternate-address-connect-timeout-ms",
+    no_short,
+    "If non-zero, destinations configured by a hostname with several"
+    " addresses have them tried in turn when connecting, alternating IPv6 and"
+    " IPv4 (RFC 8305), each but the last one with this connect timeout."
+    " If 0, only the first address is used.")
+
 MCROUTER_OPTION_GROUP("Custom Memory Allocation")
 
+MCROUTER_OPTION_TOGGLE(
+    proxy_io_uring_backend,
+    false,
+    "proxy-io-uring-backend",
+    no_short,
+    "Run proxy event bases created by mcrouter on the io_uring backend, if"
+    " the kernel supports it. Required for io_uring upstream connections.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    proxy_io_uring_sqpoll_idle_ms,
+    0,
+    "proxy-io-uring-sqpoll-idle-ms",
+    no_short,
+    "If non-zero, io_uring proxy event bases (--proxy-io-uring-backend) use"
+    " a kernel thread polling their submission queue (SQPOLL), which only"
+    " goes to sleep after being idle for this many milliseconds. Saves the"
+    " submission syscalls at the cost of a busy CPU per proxy thread.")
+
+MCROUTER_OPTION_TOGGLE(
+    io_uring_transport,
+    false,
+    "io-uring-transport",
+    no_short,
+    "Use io_uring backed transport for plaintext upstream connections by"
+    " default. Can be overridden per pool with 'use_io_uring'. Has no effect"
+    " unless proxy event bases run on the io_uring backend.")
+
 MCROUTER_OPTION_TOGGLE(
     jemalloc_nodump_buffers,
     false,
@@ -694,6 +1479,49 @@ MCROUTER_OPTION_TOGGLE(
     " part of any core dump. This is achieved by setting MADV_DONTDUMP on"
     " explicitly created jemalloc arenas. The default value is false.")
 
+MCROUTER_OPTION_TOGGLE(
+    proxy_jemalloc_arena,
+    false,
+    "proxy-jemalloc-arena",
+    no_short,
+    "Bind every proxy thread (which also runs the server workers in"
+    " standalone mode) to a jemalloc arena of its own. Cuts arena lock"
+    " contention between threads and exports the memory of the proxy arenas"
+    " in the proxy_arena_* stats. No effect unless running with jemalloc.")
+
+MCROUTER_OPTION_TOGGLE(
+    proxy_jemalloc_arena_huge_pages,
+    false,
+    "proxy-jemalloc-arena-huge-pages",
+    no_short,
+    "Back the proxy arenas (see proxy-jemalloc-arena) with 2MB aligned"
+    " mappings advised for transparent huge pages. Request and reply buffers"
+    " come from these arenas, and so do fiber stacks unless"
+    " fibers-use-guard-pages is enabled (guarded stacks are mapped"
+    " separately). Needs transparent huge pages in 'madvise' mode or above.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    proxy_jemalloc_arena_idle_purge_ms,
+    0,
+    "proxy-jemalloc-arena-idle-purge-ms",
+    no_short,
+    "If non-zero (and proxy-jemalloc-arena is set), every this many ms the"
+    " arena of a proxy that received no requests since the last check has its"
+    " dirty pages returned to the OS.")
+
+MCROUTER_OPTION_TOGGLE(
+    proxy_numa_placement,
+    false,
+    "proxy-numa-placement",
+    no_short,
+    "Spread the proxy threads (which also run the server workers in"
+    " standalone mode) evenly over the NUMA nodes of the host and pin each to"
+    " the CPUs of its node, so that a worker, its proxy and their upstream"
+    " connections share a node. With proxy-jemalloc-arena, the arena of a"
+    " proxy is then backed by memory local to its node. Disables"
+    " reuseport-cpu-steering, whose CPUs may span nodes. Linux only.")
+
 MCROUTER_OPTION_GROUP("Logging")
 
 MCROUTER_OPTION_STRING(
@@ -710,6 +1538,17 @@ MCROUTER_OPTION_STRING(
     no_short,
     "Root directory for debug fifos. If empty, debug fifos are disabled.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    debug_fifo_shm_ring_kb,
+    0,
+    "debug-fifo-shm-ring-kb",
+    no_short,
+    "If non-zero, debug fifos are shared memory rings of this many KB (per"
+    " thread) instead of named pipes. Writing to a ring never blocks, and"
+    " the reader (mcpiper) can ask for sampling and filtering at the"
+    " source, so capture can be left on under production load.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     stats_logging_interval,
@@ -718,6 +1557,27 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Time in ms between stats reports, or 0 for no logging")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    stats_snapshot_interval_ms,
+    0,
+    "stats-snapshot-interval-ms",
+    no_short,
+    "If non-zero, replies to stats commands are collected in the background"
+    " every this many ms, and stats requests are answered from the last"
+    " collected reply instead of gathering stats on the proxy thread. Only"
+    " the groups asked for are collected; the first request for a group is"
+    " answered synchronously. Stats are then up to this many ms old.")
+
+MCROUTER_OPTION_TOGGLE(
+    stats_logging_prometheus,
+    false,
+    "stats-logging-prometheus",
+    no_short,
+    "Along with the json stats file, write the same stats in the Prometheus"
+    " text format to <stats_root>/<prefix>.prom on every stats report, e.g."
+    " for the textfile collector of node_exporter")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     logging_rtt_outlier_threshold_us,
@@ -727,6 +1587,26 @@ MCROUTER_OPTION_INTEGER(
     "surpassing this threshold rtt time means we will log it as an outlier. "
     "0 (the default) means that we will do no logging of outliers.")
 
+MCROUTER_OPTION_INTEGER(
+    unsigned int,
+    slow_request_log_threshold_us,
+    0,
+    "slow-request-log-threshold-us",
+    no_short,
+    "Requests that take at least this long to be replied to are kept, with"
+    " their route path and the destinations they were sent to, in a log"
+    " returned by the __mcrouter__.slow_requests service info command."
+    " 0 (the default) disables the log.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    slow_request_log_size,
+    100,
+    "slow-request-log-size",
+    no_short,
+    "Number of slow requests each proxy keeps, see"
+    " slow-request-log-threshold-us.")
+
 MCROUTER_OPTION_INTEGER(
     unsigned int,
     stats_async_queue_length,
@@ -742,6 +1622,27 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Disable failure logging.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    failure_log_window_ms,
+    0,
+    "failure-log-window-ms",
+    no_short,
+    "If non-zero, failures are queued where they happen and logged by a"
+    " background thread every this many ms, with identical failures logged"
+    " once per window along with how many times they happened.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    tko_log_window_ms,
+    1000,
+    "tko-log-window-ms",
+    no_short,
+    "If non-zero, destination TKO events are queued where they happen and"
+    " logged every this many ms, one line per pool and event (e.g. 'N"
+    " destinations in pool X marked hard TKO'). 0 logs every event on the"
+    " proxy thread.")
+
 MCROUTER_OPTION_TOGGLE(
     test_mode,
     false,
@@ -800,6 +1701,28 @@ MCROUTER_OPTION_INTEGER(
     " threshold is always at most max-rxmit-reconnect-threshold rxmits/kb."
     " If max-rxmit-reconnect-threshold is 0, the dynamic threshold is unbounded.")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    tcp_info_sample_period,
+    0,
+    "tcp-info-sample-period",
+    no_short,
+    "If non-zero, TCP_INFO of ascii/caret destination connections is sampled"
+    " once every this many socket reads. The RTT and retransmits seen are"
+    " exported as percentiles per pool (for pools with stats enabled).")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    rtt_reconnect_median_percent,
+    0,
+    "rtt-reconnect-median-percent",
+    no_short,
+    "If non-zero, and tcp-info-sample-period is set, mcrouter reconnects to a"
+    " target whose connection RTT is above this percentage of the median RTT"
+    " of its pool, which usually moves it to a different network path. Has no"
+    " effect for pools without stats, and is disabled together with rxmit"
+    " reconnections by the disable_rxmit_reconnection runtime variable.")
+
 MCROUTER_OPTION_INTEGER(
     int,
     asynclog_port_override,
@@ -832,6 +1755,15 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "enable TFO when connecting/accepting via SSL")
 
+MCROUTER_OPTION_TOGGLE(
+    enable_tfo,
+    false,
+    "enable-tfo",
+    no_short,
+    "enable TFO when connecting/accepting plaintext connections. The first"
+    " requests written to a new connection then go out with the SYN once"
+    " the kernel has a TFO cookie for the destination, e.g. on reconnects.")
+
 MCROUTER_OPTION_TOGGLE(
     tls_prefer_ocb_cipher,
     false,
@@ -839,6 +1771,15 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Prefer AES-OCB cipher for TLSv1.3 connections if available")
 
+MCROUTER_OPTION_TOGGLE(
+    fizz_client_use_ktls,
+    false,
+    "fizz-client-use-ktls",
+    no_short,
+    "If enabled, TLS 1.3 (fizz) connections to destinations are moved to"
+    " kernel TLS after the handshake, when the kernel and the negotiated cipher"
+    " support it. Requires an application kTLS function to be installed.")
+
 MCROUTER_OPTION_TOGGLE(
     force_same_thread,
     false,
@@ -854,6 +1795,15 @@ MCROUTER_OPTION_TOGGLE(
     "Enable deterministic selection of the proxy thread to lower the number of"
     "connections between client and server.")
 
+MCROUTER_OPTION_TOGGLE(
+    key_affinity,
+    false,
+    "key-affinity",
+    no_short,
+    "Route every request in the proxy thread owning the hash range of its"
+    " routing key, so that per-proxy state (near cache, request coalescing,"
+    " connections) isn't split across all proxies.")
+
 MCROUTER_OPTION_TOGGLE(
     disable_shard_split_route,
     false,
@@ -886,6 +1836,15 @@ MCROUTER_OPTION_INTEGER(
     "Payloads >= thriftCompressionTreshold will be compressed "
     "iff thriftCompression is enabled.")
 
+MCROUTER_OPTION_TOGGLE(
+    thrift_share_connections,
+    false,
+    "thrift-share-connections",
+    no_short,
+    "If enabled, thrift destinations of a proxy that point to the same"
+    " server (e.g. with different timeouts) share one Rocket connection"
+    " instead of opening one each.")
+
 MCROUTER_OPTION_TOGGLE(
     enable_axonlog,
     false,
@@ -893,6 +1852,55 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Enable Axon log features")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    axon_batch_window_us,
+    0,
+    "axon-batch-window-us",
+    no_short,
+    "If non-zero, invalidations written to the Axon proxy service within this"
+    " many microseconds of each other, for the same bucket, region and pool,"
+    " are coalesced into a single record, each key only once.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    axon_batch_max_keys,
+    100,
+    "axon-batch-max-keys",
+    no_short,
+    "Max number of keys in a coalesced Axon invalidation record"
+    " (see --axon-batch-window-us).")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    axon_batch_max_bytes,
+    0,
+    "axon-batch-max-bytes",
+    no_short,
+    "If non-zero, a coalesced Axon invalidation record is written as soon as"
+    " its serialized deletes add up to this many bytes"
+    " (see --axon-batch-window-us).")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    axon_batch_max_pending_keys,
+    0,
+    "axon-batch-max-pending-keys",
+    no_short,
+    "If non-zero, max number of keys a proxy may have waiting for their"
+    " coalesced Axon invalidation record to be written. Further deletes"
+    " fail the Axon write right away, and fall back to asynclog if enabled"
+    " (see --axon-batch-window-us).")
+
+MCROUTER_OPTION_TOGGLE(
+    axon_batch_compress,
+    false,
+    "axon-batch-compress",
+    no_short,
+    "If enabled, coalesced Axon invalidation records are LZ4 compressed when"
+    " that makes them smaller. Requires readers that support invalidation"
+    " format version 3 (see --axon-batch-window-us).")
+
 MCROUTER_OPTION_TOGGLE(
     external_carbon_connection_logging_enabled,
     false,
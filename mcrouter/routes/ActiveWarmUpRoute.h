@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Optional.h>
+#include <folly/String.h>
+#include <folly/container/F14Set.h>
+#include <folly/dynamic.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/hash/Hash.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/HotKeySketch.h"
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/RoutingUtils.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Routes all requests to "warm", and in the background copies the keys most
+ * likely to be read from "warm" into "cold", so that a new cold cluster has
+ * a good hit rate by the time traffic is shifted to it.
+ *
+ * The keys warmed are the ones listed in "keys_file" (one per line, split
+ * among proxies), then the "hot_keys_limit" hottest keys of each proxy's hot
+ * key sketch (see --hot-keys-capacity), refreshed every "interval_sec". The
+ * "exptime" of the copies defaults to the one in warm. A key found in warm
+ * is copied with an 'add', so newer data in cold is never overwritten, the
+ * same way WarmUpRoute and McRefillRoute fill the cold side.
+ *
+ * Warming runs on a fiber of each proxy, started by the first request, and
+ * is paced to "rate" keys per second for the whole router.
+ */
+template <class RouterInfo>
+class ActiveWarmUpRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+ public:
+  struct Settings {
+    std::vector<std::string> keys;
+    double keysPerSec{1000};
+    // Number of the hottest keys of the sketch warmed on every pass; 0 to
+    // only warm the listed keys.
+    size_t hotKeysLimit{1000};
+    std::chrono::seconds interval{60};
+    folly::Optional<uint32_t> exptime;
+  };
+
+  std::string routeName() const {
+    return "active-warm-up";
+  }
+
+  ActiveWarmUpRoute(RouteHandlePtr warm, RouteHandlePtr cold, Settings settings)
+      : warm_(warm),
+        state_(std::make_shared<State>(
+            std::move(warm),
+            std::move(cold),
+            std::move(settings))) {}
+
+  ~ActiveWarmUpRoute() {
+    state_->stopped = true;
+  }
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(*warm_, req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    if (FOLLY_UNLIKELY(!state_->started)) {
+      start();
+    }
+    return warm_->route(req);
+  }
+
+ private:
+  struct State {
+    State(RouteHandlePtr w, RouteHandlePtr c, Settings s)
+        : warm(std::move(w)), cold(std::move(c)), settings(std::move(s)) {}
+
+    const RouteHandlePtr warm;
+    const RouteHandlePtr cold;
+    const Settings settings;
+
+    bool started{false};
+    // Set when the route goes away (e.g. on reconfiguration), possibly from
+    // another thread.
+    std::atomic<bool> stopped{false};
+    // Hot keys already warmed, not to warm them again on every pass.
+    folly::F14FastSet<std::string> warmed;
+  };
+
+  static constexpr size_t kMaxWarmedKeys = 1000000;
+
+  const RouteHandlePtr warm_;
+  const std::shared_ptr<State> state_;
+
+  void start() const {
+    state_->started = true;
+    auto& proxy = fiber_local<RouterInfo>::getSharedCtx()->proxy();
+    folly::fibers::addTask([state = state_, proxy = &proxy]() {
+      warmLoop(*state, *proxy);
+    });
+  }
+
+  template <class Proxy>
+  static void warmLoop(State& state, Proxy& proxy) {
+    const size_t numProxies = proxy.router().opts().num_proxies;
+    const size_t proxyId = proxy.getId();
+    // Every proxy warms its share of the keys, at its share of the rate.
+    const auto perKey = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::duration<double>(numProxies / state.settings.keysPerSec));
+    auto next = std::chrono::steady_clock::now();
+    auto pace = [&]() {
+      next += perKey;
+      auto now = std::chrono::steady_clock::now();
+      if (next > now) {
+        folly::fibers::Baton baton;
+        baton.try_wait_for(next - now);
+      } else {
+        // Don't make up for the time spent waiting on warm and cold.
+        next = now;
+      }
+    };
+
+    for (const auto& key : state.settings.keys) {
+      if (state.stopped) {
+        return;
+      }
+      if (numProxies > 1 && folly::hash::fnv64(key) % numProxies != proxyId) {
+        continue;
+      }
+      warmKey(state, proxy, key);
+      pace();
+    }
+
+    auto hotKeys = proxy.hotKeys();
+    if (hotKeys == nullptr || state.settings.hotKeysLimit == 0) {
+      return;
+    }
+    while (!state.stopped) {
+      auto items = hotKeys->snapshot();
+      if (items.size() > state.settings.hotKeysLimit) {
+        items.resize(state.settings.hotKeysLimit);
+      }
+      if (state.warmed.size() > kMaxWarmedKeys) {
+        state.warmed.clear();
+      }
+      for (const auto& item : items) {
+        if (state.stopped) {
+          return;
+        }
+        if (!state.warmed.insert(item.key).second) {
+          continue;
+        }
+        warmKey(state, proxy, item.key);
+        pace();
+      }
+      // Sleep in short steps, so that a removed route exits soon.
+      auto wakeUp = std::chrono::steady_clock::now() + state.settings.interval;
+      while (!state.stopped && std::chrono::steady_clock::now() < wakeUp) {
+        folly::fibers::Baton baton;
+        baton.try_wait_for(std::chrono::seconds(1));
+      }
+    }
+  }
+
+  template <class Proxy>
+  static void warmKey(State& state, Proxy& proxy, folly::StringPiece key) {
+    McGetRequest getReq(key);
+    auto warmReply = state.warm->route(getReq);
+    if (!isHitResult(*warmReply.result_ref())) {
+      proxy.stats().increment(active_warmup_misses_stat);
+      return;
+    }
+    uint32_t exptime = 0;
+    if (state.settings.exptime.hasValue()) {
+      exptime = *state.settings.exptime;
+    } else if (!getExptimeFromRoute<RouteHandleIf>(state.warm, key, exptime)) {
+      return;
+    }
+    state.cold->route(
+        createRequestFromMessage<McAddRequest>(key, warmReply, exptime));
+    proxy.stats().increment(active_warmup_fills_stat);
+  }
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeActiveWarmUpRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "ActiveWarmUpRoute should be object");
+  checkLogic(json.count("warm"), "ActiveWarmUpRoute: no warm route");
+  checkLogic(json.count("cold"), "ActiveWarmUpRoute: no cold route");
+
+  typename ActiveWarmUpRoute<RouterInfo>::Settings settings;
+  if (auto jkeysFile = json.get_ptr("keys_file")) {
+    checkLogic(
+        jkeysFile->isString(), "ActiveWarmUpRoute: keys_file is not a string");
+    std::ifstream keysFile(jkeysFile->getString());
+    checkLogic(
+        keysFile.good(),
+        "ActiveWarmUpRoute: can't open keys_file '{}'",
+        jkeysFile->getString());
+    std::string line;
+    while (std::getline(keysFile, line)) {
+      auto key = folly::trimWhitespace(line);
+      if (!key.empty()) {
+        settings.keys.push_back(key.str());
+      }
+    }
+  }
+  if (auto jrate = json.get_ptr("rate")) {
+    checkLogic(
+        jrate->isNumber() && jrate->asDouble() > 0,
+        "ActiveWarmUpRoute: rate is not a positive number");
+    settings.keysPerSec = jrate->asDouble();
+  }
+  if (auto jlimit = json.get_ptr("hot_keys_limit")) {
+    checkLogic(
+        jlimit->isInt() && jlimit->getInt() >= 0,
+        "ActiveWarmUpRoute: hot_keys_limit is not a non-negative integer");
+    settings.hotKeysLimit = jlimit->getInt();
+  }
+  if (auto jinterval = json.get_ptr("interval_sec")) {
+    checkLogic(
+        jinterval->isInt() && jinterval->getInt() > 0,
+        "ActiveWarmUpRoute: interval_sec is not a positive integer");
+    settings.interval = std::chrono::seconds(jinterval->getInt());
+  }
+  if (auto jexptime = json.get_ptr("exptime")) {
+    checkLogic(
+        jexptime->isInt(), "ActiveWarmUpRoute: exptime is not an integer");
+    settings.exptime = jexptime->getInt();
+  }
+
+  return makeRouteHandleWithInfo<RouterInfo, ActiveWarmUpRoute>(
+      factory.create(json["warm"]),
+      factory.create(json["cold"]),
+      std::move(settings));
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
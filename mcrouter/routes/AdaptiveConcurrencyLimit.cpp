@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "AdaptiveConcurrencyLimit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+// Number of samples averaged by the short term RTT.
+constexpr double kShortWindow = 10;
+// Number of unloaded samples the minimum RTT is measured from.
+constexpr size_t kProbeSamples = 25;
+
+} // namespace
+
+AdaptiveConcurrencyLimit::Options::Options(const folly::dynamic& json) {
+  checkLogic(
+      json.isObject(), "AdaptiveConcurrencyLimit: config is not an object");
+  if (auto jMin = json.get_ptr("min_limit")) {
+    minLimit = parseInt(*jMin, "min_limit", 1, 1000000);
+  }
+  if (auto jMax = json.get_ptr("max_limit")) {
+    maxLimit = parseInt(*jMax, "max_limit", 1, 1000000);
+  }
+  checkLogic(
+      minLimit <= maxLimit,
+      "AdaptiveConcurrencyLimit: min_limit is greater than max_limit");
+  initialLimit = std::min(std::max(initialLimit, minLimit), maxLimit);
+  if (auto jInitial = json.get_ptr("initial_limit")) {
+    initialLimit = parseInt(*jInitial, "initial_limit", minLimit, maxLimit);
+  }
+  if (auto jTolerance = json.get_ptr("tolerance_percent")) {
+    tolerance = parseInt(*jTolerance, "tolerance_percent", 100, 1000) / 100.0;
+  }
+  if (auto jSmoothing = json.get_ptr("smoothing_percent")) {
+    smoothing = parseInt(*jSmoothing, "smoothing_percent", 1, 100) / 100.0;
+  }
+  if (auto jProbe = json.get_ptr("probe_interval")) {
+    probeInterval = parseInt(*jProbe, "probe_interval", 100, 100000000);
+  }
+  if (auto jLifo = json.get_ptr("lifo")) {
+    lifo = parseBool(*jLifo, "lifo");
+  }
+}
+
+AdaptiveConcurrencyLimit::AdaptiveConcurrencyLimit(Options opts)
+    : opts_(opts), estimate_(opts_.initialLimit) {
+  startProbe();
+}
+
+void AdaptiveConcurrencyLimit::startProbe() {
+  probing_ = true;
+  probeSamples_ = 0;
+  probeMinRttUs_ = std::numeric_limits<double>::max();
+  limit_ = opts_.minLimit;
+}
+
+void AdaptiveConcurrencyLimit::onSample(int64_t rttUs, size_t inflight) {
+  double rtt = std::max<int64_t>(rttUs, 1);
+  if (probing_) {
+    // Requests sent before the probe started were queued behind others.
+    if (inflight <= opts_.minLimit) {
+      probeMinRttUs_ = std::min(probeMinRttUs_, rtt);
+      ++probeSamples_;
+    }
+    if (probeSamples_ >= kProbeSamples) {
+      probing_ = false;
+      samplesSinceProbe_ = 0;
+      minRttUs_ = shortRttUs_ = probeMinRttUs_;
+      limit_ = static_cast<size_t>(estimate_);
+    }
+    return;
+  }
+
+  shortRttUs_ += (rtt - shortRttUs_) / kShortWindow;
+  if (++samplesSinceProbe_ >= opts_.probeInterval) {
+    startProbe();
+    return;
+  }
+
+  // The backend was not the bottleneck, latency says nothing about capacity.
+  if (inflight < estimate_ / 2) {
+    return;
+  }
+
+  auto gradient =
+      std::max(0.5, std::min(1.0, opts_.tolerance * minRttUs_ / shortRttUs_));
+  // Headroom to probe for more capacity while latency is low.
+  auto newEstimate = estimate_ * gradient + std::sqrt(estimate_);
+  estimate_ = estimate_ * (1 - opts_.smoothing) + newEstimate * opts_.smoothing;
+  estimate_ = std::min<double>(
+      std::max<double>(estimate_, opts_.minLimit), opts_.maxLimit);
+  limit_ = static_cast<size_t>(estimate_);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
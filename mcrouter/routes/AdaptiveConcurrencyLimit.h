@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace folly {
+struct dynamic;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Concurrency limit that follows the capacity of the backend, TCP Vegas /
+ * Gradient style: it compares the latency of recent requests (short RTT) to
+ * the unloaded latency (minimum RTT). While latency stays within `tolerance`
+ * of the minimum the limit grows; once requests start queueing on the
+ * backend, latency goes up and the limit shrinks proportionally.
+ *
+ * The minimum RTT can't be learned from regular traffic once the backend is
+ * saturated, so it is measured by periodic probes: every `probeInterval`
+ * samples the limit drops to `minLimit` until a few requests went through.
+ *
+ * Not thread-safe: belongs to a single proxy.
+ */
+class AdaptiveConcurrencyLimit {
+ public:
+  struct Options {
+    Options() = default;
+
+    /**
+     * @param json  Object, all fields are optional:
+     *                {
+     *                  "initial_limit": int (default 20),
+     *                  "min_limit": int (default 1),
+     *                  "max_limit": int (default 1000),
+     *                  "tolerance_percent": int (default 150),
+     *                  "smoothing_percent": int (default 20),
+     *                  "probe_interval": int (default 10000),
+     *                  "lifo": bool (default true)
+     *                }
+     *              tolerance_percent is the latency increase over the
+     *              minimum RTT that is tolerated before shrinking the
+     *              limit, smoothing_percent is how fast the limit moves
+     *              towards a new estimate, probe_interval is the number of
+     *              requests between two measurements of the minimum RTT.
+     *
+     * @throws std::logic_error if `json` is invalid.
+     */
+    explicit Options(const folly::dynamic& json);
+
+    size_t initialLimit{20};
+    size_t minLimit{1};
+    size_t maxLimit{1000};
+    double tolerance{1.5};
+    double smoothing{0.2};
+    size_t probeInterval{10000};
+    // Serve the most recently queued requests first once the queue is longer
+    // than the limit: older requests are likely to time out anyway.
+    bool lifo{true};
+  };
+
+  explicit AdaptiveConcurrencyLimit(Options opts);
+
+  size_t limit() const {
+    return limit_;
+  }
+
+  const Options& options() const {
+    return opts_;
+  }
+
+  /**
+   * Records the latency of one request.
+   *
+   * @param inflight  Number of requests in flight when the request was sent.
+   */
+  void onSample(int64_t rttUs, size_t inflight);
+
+ private:
+  const Options opts_;
+  double estimate_;
+  size_t limit_;
+  double shortRttUs_{0};
+  double minRttUs_{0};
+  size_t samplesSinceProbe_{0};
+  bool probing_{false};
+  size_t probeSamples_{0};
+  double probeMinRttUs_{0};
+
+  void startProbe();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
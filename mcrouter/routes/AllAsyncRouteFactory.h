@@ -7,10 +7,14 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
+
 #include <folly/dynamic.h>
 
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/routes/AllAsyncRoute.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 
@@ -22,13 +26,14 @@ namespace detail {
 
 template <class RouterInfo>
 typename RouterInfo::RouteHandlePtr makeAllAsyncRoute(
-    std::vector<typename RouterInfo::RouteHandlePtr> rh) {
+    std::vector<typename RouterInfo::RouteHandlePtr> rh,
+    std::unique_ptr<RecentKeyFilter> deleteFilter = nullptr) {
   if (rh.empty()) {
     return createNullRoute<typename RouterInfo::RouteHandleIf>();
   }
 
   return makeRouteHandle<typename RouterInfo::RouteHandleIf, AllAsyncRoute>(
-      std::move(rh));
+      std::move(rh), std::move(deleteFilter));
 }
 
 } // namespace detail
@@ -38,14 +43,33 @@ typename RouterInfo::RouteHandlePtr makeAllAsyncRoute(
     RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
     const folly::dynamic& json) {
   std::vector<typename RouterInfo::RouteHandlePtr> children;
+  std::unique_ptr<RecentKeyFilter> deleteFilter;
   if (json.isObject()) {
     if (auto jchildren = json.get_ptr("children")) {
       children = factory.createList(*jchildren);
     }
+    if (auto jwindow = json.get_ptr("dedup_deletes_window_ms")) {
+      checkLogic(
+          jwindow->isInt() && jwindow->getInt() >= 0,
+          "AllAsyncRoute: dedup_deletes_window_ms is not a non-negative "
+          "integer");
+      size_t maxKeys = 100000;
+      if (auto jmaxKeys = json.get_ptr("dedup_deletes_max_keys")) {
+        checkLogic(
+            jmaxKeys->isInt() && jmaxKeys->getInt() > 0,
+            "AllAsyncRoute: dedup_deletes_max_keys is not a positive integer");
+        maxKeys = jmaxKeys->getInt();
+      }
+      if (jwindow->getInt() > 0) {
+        deleteFilter = std::make_unique<RecentKeyFilter>(
+            std::chrono::milliseconds(jwindow->getInt()), maxKeys);
+      }
+    }
   } else {
     children = factory.createList(json);
   }
-  return detail::makeAllAsyncRoute<RouterInfo>(std::move(children));
+  return detail::makeAllAsyncRoute<RouterInfo>(
+      std::move(children), std::move(deleteFilter));
 }
 } // namespace mcrouter
 } // namespace memcache
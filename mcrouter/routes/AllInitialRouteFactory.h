@@ -11,6 +11,7 @@
 
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
 #include "mcrouter/lib/routes/AllInitialRoute.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 
@@ -22,7 +23,8 @@ namespace detail {
 
 template <class RouterInfo>
 typename RouterInfo::RouteHandlePtr makeAllInitialRoute(
-    std::vector<typename RouterInfo::RouteHandlePtr> rh) {
+    std::vector<typename RouterInfo::RouteHandlePtr> rh,
+    bool cancelStragglers = false) {
   if (rh.empty()) {
     return createNullRoute<typename RouterInfo::RouteHandleIf>();
   }
@@ -32,7 +34,7 @@ typename RouterInfo::RouteHandlePtr makeAllInitialRoute(
   }
 
   return makeRouteHandle<typename RouterInfo::RouteHandleIf, AllInitialRoute>(
-      std::move(rh));
+      std::move(rh), cancelStragglers);
 }
 
 } // namespace detail
@@ -42,14 +44,19 @@ typename RouterInfo::RouteHandlePtr makeAllInitialRoute(
     RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
     const folly::dynamic& json) {
   std::vector<typename RouterInfo::RouteHandlePtr> children;
+  bool cancelStragglers = false;
   if (json.isObject()) {
     if (auto jchildren = json.get_ptr("children")) {
       children = factory.createList(*jchildren);
     }
+    if (auto jcancel = json.get_ptr("cancel_stragglers")) {
+      cancelStragglers = parseBool(*jcancel, "cancel_stragglers");
+    }
   } else {
     children = factory.createList(json);
   }
-  return detail::makeAllInitialRoute<RouterInfo>(std::move(children));
+  return detail::makeAllInitialRoute<RouterInfo>(
+      std::move(children), cancelStragglers);
 }
 } // namespace mcrouter
 } // namespace memcache
@@ -11,6 +11,7 @@
 
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
 #include "mcrouter/lib/routes/AllMajorityRoute.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 
@@ -20,7 +21,8 @@ namespace mcrouter {
 
 template <class RouterInfo>
 typename RouterInfo::RouteHandlePtr createAllMajorityRoute(
-    std::vector<typename RouterInfo::RouteHandlePtr> rh) {
+    std::vector<typename RouterInfo::RouteHandlePtr> rh,
+    bool cancelStragglers = false) {
   if (rh.empty()) {
     return createNullRoute<typename RouterInfo::RouteHandleIf>();
   }
@@ -30,7 +32,7 @@ typename RouterInfo::RouteHandlePtr createAllMajorityRoute(
   }
 
   return makeRouteHandle<typename RouterInfo::RouteHandleIf, AllMajorityRoute>(
-      std::move(rh));
+      std::move(rh), cancelStragglers);
 }
 
 template <class RouterInfo>
@@ -38,14 +40,19 @@ typename RouterInfo::RouteHandlePtr makeAllMajorityRoute(
     RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
     const folly::dynamic& json) {
   std::vector<typename RouterInfo::RouteHandlePtr> children;
+  bool cancelStragglers = false;
   if (json.isObject()) {
     if (auto jchildren = json.get_ptr("children")) {
       children = factory.createList(*jchildren);
     }
+    if (auto jcancel = json.get_ptr("cancel_stragglers")) {
+      cancelStragglers = parseBool(*jcancel, "cancel_stragglers");
+    }
   } else {
     children = factory.createList(json);
   }
-  return createAllMajorityRoute<RouterInfo>(std::move(children));
+  return createAllMajorityRoute<RouterInfo>(
+      std::move(children), cancelStragglers);
 }
 } // namespace mcrouter
 } // namespace memcache
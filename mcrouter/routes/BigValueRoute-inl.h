@@ -16,7 +16,9 @@
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 
+#include "mcrouter/config.h"
 #include "mcrouter/lib/AuxiliaryCPUThreadPool.h"
+#include "mcrouter/lib/Compression.h"
 #include "mcrouter/lib/IOBufUtil.h"
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Reply.h"
@@ -48,6 +50,17 @@ InputIterator reduce(InputIterator begin, InputIterator end) {
 // complete.
 uint64_t hashBigValue(const folly::IOBuf& value);
 
+// ZSTD compresses value on the same CPU thread pool. Returns nullptr if
+// compression is not available or doesn't make value smaller.
+std::unique_ptr<folly::IOBuf> compressBigValue(
+    const folly::IOBuf& value,
+    uint32_t level);
+
+// Reverse of compressBigValue(). Returns nullptr if data is corrupted.
+std::unique_ptr<folly::IOBuf> uncompressBigValue(
+    const folly::IOBuf& data,
+    size_t uncompressedSize);
+
 } // namespace detail
 
 template <class RouterInfo>
@@ -59,6 +72,10 @@ BigValueRoute<RouterInfo>::collectAllByBatches(FuncIt beginF, FuncIt endF)
   using Reply = typename std::result_of<
       typename std::iterator_traits<FuncIt>::value_type()>::type;
 
+  if (options_.maxWindow != 0) {
+    return collectAllPipelined(beginF, endF);
+  }
+
   auto batchSize = options_.batchSize;
   const size_t rangeSize = std::distance(beginF, endF);
   if (batchSize == 0) {
@@ -79,6 +96,54 @@ BigValueRoute<RouterInfo>::collectAllByBatches(FuncIt beginF, FuncIt endF)
   return allReplies;
 }
 
+template <class RouterInfo>
+template <class FuncIt>
+std::vector<typename std::result_of<
+    typename std::iterator_traits<FuncIt>::value_type()>::type>
+BigValueRoute<RouterInfo>::collectAllPipelined(FuncIt beginF, FuncIt endF)
+    const {
+  using Reply = typename std::result_of<
+      typename std::iterator_traits<FuncIt>::value_type()>::type;
+
+  const size_t rangeSize = std::distance(beginF, endF);
+  std::vector<Reply> allReplies(rangeSize);
+  size_t next = 0;
+  int64_t totalLatencyUs = 0;
+
+  std::vector<std::function<void()>> workers(
+      std::min(window_, rangeSize), [&]() {
+        while (next < rangeSize) {
+          auto i = next++;
+          auto start = nowUs();
+          allReplies[i] = (*(beginF + i))();
+          totalLatencyUs += nowUs() - start;
+        }
+      });
+  folly::fibers::collectAll(workers.begin(), workers.end());
+
+  if (rangeSize > 0) {
+    updateWindow(static_cast<double>(totalLatencyUs) / rangeSize);
+  }
+  return allReplies;
+}
+
+template <class RouterInfo>
+void BigValueRoute<RouterInfo>::updateWindow(double avgChunkLatencyUs) const {
+  // The baseline slowly forgets old minimums, so that a permanent latency
+  // change doesn't pin the window to 1.
+  if (baseChunkLatencyUs_ <= 0.0 || avgChunkLatencyUs < baseChunkLatencyUs_) {
+    baseChunkLatencyUs_ = avgChunkLatencyUs;
+  } else {
+    baseChunkLatencyUs_ += (avgChunkLatencyUs - baseChunkLatencyUs_) / 64;
+  }
+
+  if (avgChunkLatencyUs <= 2 * baseChunkLatencyUs_) {
+    window_ = std::min(window_ + 1, options_.maxWindow);
+  } else {
+    window_ = std::max<size_t>(1, window_ * 3 / 4);
+  }
+}
+
 template <class RouterInfo>
 template <class Request>
 bool BigValueRoute<RouterInfo>::traverse(
@@ -99,6 +164,9 @@ typename std::enable_if<
     ReplyT<Request>>::type
 BigValueRoute<RouterInfo>::route(const Request& req) const {
   auto initialReply = ch_->route(req);
+  if (retryBudget_ && !isErrorResult(*initialReply.result_ref())) {
+    retryBudget_->recordSuccess();
+  }
   bool isBigValue = ((*initialReply.flags_ref() & MC_MSG_FLAG_BIG_VALUE) != 0);
   if (!isBigValue) {
     return initialReply;
@@ -132,7 +200,7 @@ BigValueRoute<RouterInfo>::route(const Request& req) const {
 
   auto replies = collectAllByBatches(fs.begin(), fs.end());
   return mergeChunkGetReplies(
-      replies.begin(), replies.end(), std::move(initialReply));
+      replies.begin(), replies.end(), std::move(initialReply), chunksInfo);
 }
 
 template <class RouterInfo>
@@ -143,15 +211,33 @@ BigValueRoute<RouterInfo>::route(const Request& req) const {
     return ch_->route(req);
   }
 
-  auto reqsInfoPair = chunkUpdateRequests<Request>(
-      req.key_ref()->fullKey(), *req.value_ref(), *req.exptime_ref());
+  const auto& origValue = *req.value_ref();
+  std::unique_ptr<folly::IOBuf> compressed;
+  if (options_.compressionLevel != 0) {
+    compressed = detail::compressBigValue(origValue, options_.compressionLevel);
+  }
+  const auto& value = compressed ? *compressed : origValue;
+  const uint32_t numChunks =
+      (value.computeChainDataLength() + options_.threshold - 1) /
+      options_.threshold;
+  // Only compressed values use the new info format, so that hosts that don't
+  // know about it can still read values written without compression.
+  const auto suffix = detail::hashBigValue(origValue);
+  const auto info = compressed
+      ? ChunksInfo(numChunks, suffix, origValue.computeChainDataLength())
+      : ChunksInfo(numChunks, suffix);
+
+  // Chunk requests are only created once their batch is sent, so at most a
+  // batch worth of them is alive at any time. Chunk values share the buffers
+  // of the original value.
   std::vector<std::function<McSetReply()>> fs;
-  auto& chunkReqs = reqsInfoPair.first;
-  fs.reserve(chunkReqs.size());
-
-  auto& target = *ch_;
-  for (const auto& chunkReq : chunkReqs) {
-    fs.push_back([&target, &chunkReq]() { return target.route(chunkReq); });
+  fs.reserve(numChunks);
+  const auto baseKey = req.key_ref()->fullKey();
+  const auto exptime = *req.exptime_ref();
+  for (uint32_t i = 0; i < numChunks; ++i) {
+    fs.push_back([this, &value, &info, baseKey, exptime, i]() {
+      return ch_->route(chunkUpdateRequest(baseKey, value, exptime, info, i));
+    });
   }
 
   auto replies = collectAllByBatches(fs.begin(), fs.end());
@@ -162,7 +248,7 @@ BigValueRoute<RouterInfo>::route(const Request& req) const {
     // original key with modified value stored at the back
     auto newReq = req;
     newReq.flags_ref() = *req.flags_ref() | MC_MSG_FLAG_BIG_VALUE;
-    newReq.value_ref() = reqsInfoPair.second.toStringType();
+    newReq.value_ref() = info.toStringType();
     return ch_->route(newReq);
   } else {
     return ReplyT<Request>(*reducedReply->result_ref());
@@ -199,7 +285,8 @@ template <typename InputIterator, class Reply>
 Reply BigValueRoute<RouterInfo>::mergeChunkGetReplies(
     InputIterator begin,
     InputIterator end,
-    Reply&& initialReply) const {
+    Reply&& initialReply,
+    const ChunksInfo& info) const {
   auto reducedReplyIt = detail::reduce(begin, end);
   if (!isHitResult(*reducedReplyIt->result_ref())) {
     return Reply(*reducedReplyIt->result_ref());
@@ -207,46 +294,53 @@ Reply BigValueRoute<RouterInfo>::mergeChunkGetReplies(
 
   initialReply.result_ref() = *reducedReplyIt->result_ref();
 
-  std::vector<std::unique_ptr<folly::IOBuf>> dataVec;
-  while (begin != end) {
-    if (begin->value_ref().has_value()) {
-      dataVec.push_back(begin->value_ref()->clone());
+  // Chain the chunk buffers into the reply as they are, without copying or
+  // coalescing them.
+  folly::IOBuf value;
+  bool empty = true;
+  for (; begin != end; ++begin) {
+    auto& chunk = begin->value_ref();
+    if (!chunk.has_value()) {
+      continue;
+    }
+    if (empty) {
+      value = std::move(*chunk);
+      empty = false;
+    } else {
+      value.prependChain(std::make_unique<folly::IOBuf>(std::move(*chunk)));
+    }
+    chunk.reset();
+  }
+
+  if (info.compressed()) {
+    auto uncompressed =
+        detail::uncompressBigValue(value, info.uncompressedSize());
+    if (!uncompressed) {
+      return Reply(carbon::Result::NOTFOUND);
     }
-    ++begin;
+    initialReply.value_ref() = std::move(*uncompressed);
+    return std::move(initialReply);
   }
 
-  initialReply.value_ref() = concatAll(dataVec.begin(), dataVec.end());
+  initialReply.value_ref() = std::move(value);
   return std::move(initialReply);
 }
 
 template <class RouterInfo>
-template <class Request>
-typename std::enable_if_t<
-    MemcacheUpdateLike<Request>::value,
-    std::pair<
-        std::vector<McSetRequest>,
-        typename BigValueRoute<RouterInfo>::ChunksInfo>>
-BigValueRoute<RouterInfo>::chunkUpdateRequests(
+McSetRequest BigValueRoute<RouterInfo>::chunkUpdateRequest(
     folly::StringPiece baseKey,
     const folly::IOBuf& value,
-    int32_t exptime) const {
-  int numChunks = (value.computeChainDataLength() + options_.threshold - 1) /
-      options_.threshold;
-  ChunksInfo info(numChunks, detail::hashBigValue(value));
-
-  std::vector<McSetRequest> chunkReqs;
-  chunkReqs.reserve(numChunks);
-
+    int32_t exptime,
+    const ChunksInfo& info,
+    uint32_t chunkIndex) const {
+  McSetRequest chunkReq(createChunkKey(baseKey, chunkIndex, info.suffix()));
   folly::IOBuf chunkValue;
   folly::io::Cursor cursor(&value);
-  for (int i = 0; i < numChunks; ++i) {
-    cursor.cloneAtMost(chunkValue, options_.threshold);
-    chunkReqs.emplace_back(createChunkKey(baseKey, i, info.suffix()));
-    chunkReqs.back().value_ref() = std::move(chunkValue);
-    chunkReqs.back().exptime_ref() = exptime;
-  }
-
-  return std::make_pair(std::move(chunkReqs), info);
+  cursor.skip(static_cast<size_t>(chunkIndex) * options_.threshold);
+  cursor.cloneAtMost(chunkValue, options_.threshold);
+  chunkReq.value_ref() = std::move(chunkValue);
+  chunkReq.exptime_ref() = exptime;
+  return chunkReq;
 }
 
 template <class RouterInfo>
@@ -322,7 +416,7 @@ McLeaseGetReply BigValueRoute<RouterInfo>::doLeaseGetRoute(
 
   folly::fibers::collectAll(tasks.begin(), tasks.end());
   const auto reducedReply = mergeChunkGetReplies(
-      replies.begin(), replies.end(), std::move(initialReply));
+      replies.begin(), replies.end(), std::move(initialReply), chunksInfo);
 
   // Return reducedReply on hit or error
   if (!isMissResult(*reducedReply.result_ref())) {
@@ -330,7 +424,7 @@ McLeaseGetReply BigValueRoute<RouterInfo>::doLeaseGetRoute(
   }
 
   if (isErrorResult(*getsMetadataReply.result_ref())) {
-    if (retriesLeft > 0) {
+    if (retriesLeft > 0 && retryAllowed()) {
       return doLeaseGetRoute(req, --retriesLeft);
     }
     McLeaseGetReply errorReply(*getsMetadataReply.result_ref());
@@ -356,7 +450,7 @@ McLeaseGetReply BigValueRoute<RouterInfo>::doLeaseGetRoute(
     }
   }
 
-  if (retriesLeft > 0) {
+  if (retriesLeft > 0 && retryAllowed()) {
     return doLeaseGetRoute(req, --retriesLeft);
   }
 
@@ -366,13 +460,24 @@ McLeaseGetReply BigValueRoute<RouterInfo>::doLeaseGetRoute(
   return reply;
 }
 
+template <class RouterInfo>
+bool BigValueRoute<RouterInfo>::retryAllowed() const {
+  if (!retryBudget_ || retryBudget_->tryRetry()) {
+    return true;
+  }
+  if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+    ctx->proxy().stats().increment(retry_budget_exhausted_stat);
+  }
+  return false;
+}
+
 template <class RouterInfo>
 BigValueRoute<RouterInfo>::ChunksInfo::ChunksInfo(folly::StringPiece replyValue)
     : infoVersion_(1), valid_(true) {
   // Verify that replyValue is of the form version-numChunks-suffix,
   // where version, numChunks and suffix should be numeric
-  uint32_t version;
-  int charsRead;
+  uint32_t version = 0;
+  int charsRead = 0;
   valid_ &=
       (sscanf(
            replyValue.data(),
@@ -381,8 +486,24 @@ BigValueRoute<RouterInfo>::ChunksInfo::ChunksInfo(folly::StringPiece replyValue)
            &numChunks_,
            &suffix_,
            &charsRead) == 3);
+  if (valid_ && version == 2) {
+    // followed by -codec-uncompressedSize
+    uint32_t codec = 0;
+    int moreCharsRead = 0;
+    valid_ &=
+        (sscanf(
+             replyValue.data() + charsRead,
+             "-%u-%lu%n",
+             &codec,
+             &uncompressedSize_,
+             &moreCharsRead) == 2);
+    valid_ &= (codec == static_cast<uint32_t>(CompressionCodecType::ZSTD));
+    valid_ &= (uncompressedSize_ != 0);
+    charsRead += moreCharsRead;
+  }
   valid_ &= (static_cast<size_t>(charsRead) == replyValue.size());
-  valid_ &= (version == infoVersion_);
+  valid_ &= (version == 1 || version == 2);
+  infoVersion_ = version;
 }
 
 template <class RouterInfo>
@@ -391,8 +512,30 @@ BigValueRoute<RouterInfo>::ChunksInfo::ChunksInfo(
     uint64_t suffix__)
     : infoVersion_(1), numChunks_(chunks), suffix_(suffix__), valid_(true) {}
 
+template <class RouterInfo>
+BigValueRoute<RouterInfo>::ChunksInfo::ChunksInfo(
+    uint32_t chunks,
+    uint64_t suffix__,
+    size_t uncompressedSize)
+    : infoVersion_(2),
+      numChunks_(chunks),
+      suffix_(suffix__),
+      uncompressedSize_(uncompressedSize),
+      valid_(true) {}
+
 template <class RouterInfo>
 folly::IOBuf BigValueRoute<RouterInfo>::ChunksInfo::toStringType() const {
+  if (compressed()) {
+    return folly::IOBuf(
+        folly::IOBuf::COPY_BUFFER,
+        folly::sformat(
+            "{}-{}-{}-{}-{}",
+            infoVersion_,
+            numChunks_,
+            suffix_,
+            static_cast<uint32_t>(CompressionCodecType::ZSTD),
+            uncompressedSize_));
+  }
   return folly::IOBuf(
       folly::IOBuf::COPY_BUFFER,
       folly::sformat("{}-{}-{}", infoVersion_, numChunks_, suffix_));
@@ -416,8 +559,16 @@ bool BigValueRoute<RouterInfo>::ChunksInfo::valid() const {
 template <class RouterInfo>
 BigValueRoute<RouterInfo>::BigValueRoute(
     RouteHandlePtr ch,
-    BigValueRouteOptions options)
-    : ch_(std::move(ch)), options_(options) {
+    BigValueRouteOptions options,
+    std::shared_ptr<const RetryBudget> retryBudget)
+    : ch_(std::move(ch)),
+      options_(options),
+      retryBudget_(std::move(retryBudget)),
+      window_(
+          options_.batchSize != 0
+              ? std::min(options_.batchSize, options_.maxWindow)
+              : options_.maxWindow) {
+  window_ = std::max<size_t>(window_, 1);
   assert(ch_ != nullptr);
 }
 
@@ -434,9 +585,10 @@ folly::IOBuf BigValueRoute<RouterInfo>::createChunkKey(
 template <class RouterInfo>
 typename RouterInfo::RouteHandlePtr makeBigValueRoute(
     typename RouterInfo::RouteHandlePtr rh,
-    BigValueRouteOptions options) {
+    BigValueRouteOptions options,
+    std::shared_ptr<const RetryBudget> retryBudget = nullptr) {
   return makeRouteHandleWithInfo<RouterInfo, BigValueRoute>(
-      std::move(rh), std::move(options));
+      std::move(rh), std::move(options), std::move(retryBudget));
 }
 
 } // namespace mcrouter
@@ -9,6 +9,9 @@
 
 #include <folly/Format.h>
 #include <folly/fibers/WhenN.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/Compression.h"
 
 namespace facebook {
 namespace memcache {
@@ -35,6 +38,87 @@ uint64_t hashBigValue(const folly::IOBuf& value) {
       "value!");
 }
 
+namespace {
+
+// Codecs are not thread-safe, so every pool thread has its own.
+CompressionCodec* getZstdCodec(uint32_t level) {
+  thread_local std::unique_ptr<CompressionCodec> codec;
+  thread_local uint32_t codecLevel = 0;
+  if (!codec || codecLevel != level) {
+    try {
+      codec = createCompressionCodec(
+          CompressionCodecType::ZSTD,
+          folly::IOBuf::create(0),
+          /* id */ 0,
+          FilteringOptions(),
+          level);
+    } catch (const std::exception& e) {
+      LOG_EVERY_N(ERROR, 1000) << "Failed to create ZSTD codec: " << e.what();
+      codec.reset();
+    }
+    codecLevel = level;
+  }
+  return codec.get();
+}
+
+template <class F>
+std::unique_ptr<folly::IOBuf> runOnCPUPool(F&& func) {
+  if (auto singleton = AuxiliaryCPUThreadPoolSingleton::try_get_fast()) {
+    auto& threadPool = singleton->getThreadPool();
+    return folly::fibers::await(
+        [&](folly::fibers::Promise<std::unique_ptr<folly::IOBuf>> promise) {
+          threadPool.add([promise = std::move(promise), &func]() mutable {
+            std::unique_ptr<folly::IOBuf> result;
+            try {
+              result = func();
+            } catch (const std::exception& e) {
+              LOG_EVERY_N(ERROR, 1000)
+                  << "Big value compression failed: " << e.what();
+            }
+            promise.setValue(std::move(result));
+          });
+        });
+  }
+  throwRuntime(
+      "Mcrouter CPU Thread pool is not running, cannot compress big value!");
+}
+
+} // namespace
+
+std::unique_ptr<folly::IOBuf> compressBigValue(
+    const folly::IOBuf& value,
+    uint32_t level) {
+  return runOnCPUPool([&]() -> std::unique_ptr<folly::IOBuf> {
+    auto codec = getZstdCodec(level);
+    if (!codec) {
+      return nullptr;
+    }
+    auto compressed = codec->compress(value);
+    if (compressed->computeChainDataLength() >=
+        value.computeChainDataLength()) {
+      return nullptr;
+    }
+    return compressed;
+  });
+}
+
+std::unique_ptr<folly::IOBuf> uncompressBigValue(
+    const folly::IOBuf& data,
+    size_t uncompressedSize) {
+  return runOnCPUPool([&]() -> std::unique_ptr<folly::IOBuf> {
+    // The compression level doesn't matter for decompression.
+    auto codec = getZstdCodec(1);
+    if (!codec) {
+      return nullptr;
+    }
+    auto uncompressed = codec->uncompress(data, uncompressedSize);
+    if (uncompressed->computeChainDataLength() != uncompressedSize) {
+      return nullptr;
+    }
+    return uncompressed;
+  });
+}
+
 } // namespace detail
 
 } // namespace mcrouter
@@ -19,6 +19,7 @@
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/routes/BigValueRouteIf.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/routes/RetryBudget.h"
 
 namespace folly {
 class IOBuf;
@@ -67,7 +68,14 @@ class BigValueRoute {
       const Request& req,
       const RouteHandleTraverser<RouteHandleIf>& t) const;
 
-  BigValueRoute(RouteHandlePtr ch, BigValueRouteOptions options);
+  /**
+   * @param retryBudget  If set, lease-get retries are only sent when the
+   *                     budget allows them.
+   */
+  BigValueRoute(
+      RouteHandlePtr ch,
+      BigValueRouteOptions options,
+      std::shared_ptr<const RetryBudget> retryBudget = nullptr);
 
   template <class Request>
   typename std::enable_if<
@@ -96,21 +104,40 @@ class BigValueRoute {
  private:
   const RouteHandlePtr ch_;
   const BigValueRouteOptions options_;
+  const std::shared_ptr<const RetryBudget> retryBudget_;
+
+  // Current chunk window, between 1 and options_.maxWindow.
+  mutable size_t window_;
+  // Lowest average chunk latency seen recently.
+  mutable double baseChunkLatencyUs_{0.0};
 
   class ChunksInfo {
    public:
     explicit ChunksInfo(folly::StringPiece replyValue);
     explicit ChunksInfo(uint32_t numChunks, uint64_t suffix__);
+    /**
+     * Info of a value that was compressed before being split into chunks.
+     */
+    ChunksInfo(uint32_t numChunks, uint64_t suffix__, size_t uncompressedSize);
 
     folly::IOBuf toStringType() const;
     uint32_t numChunks() const;
     uint64_t suffix() const;
     bool valid() const;
+    bool compressed() const {
+      return uncompressedSize_ != 0;
+    }
+    size_t uncompressedSize() const {
+      return uncompressedSize_;
+    }
 
    private:
-    const uint32_t infoVersion_;
+    // 1: version-numChunks-suffix
+    // 2: version-numChunks-suffix-codec-uncompressedSize
+    uint32_t infoVersion_;
     uint32_t numChunks_;
     uint64_t suffix_;
+    uint64_t uncompressedSize_{0};
     bool valid_;
   };
 
@@ -118,19 +145,38 @@ class BigValueRoute {
       const McLeaseGetRequest& req,
       size_t retriesLeft) const;
 
+  bool retryAllowed() const;
+
   template <class FuncIt>
   std::vector<typename std::result_of<
       typename std::iterator_traits<FuncIt>::value_type()>::type>
   collectAllByBatches(FuncIt beginF, FuncIt endF) const;
 
-  template <class Request>
-  typename std::enable_if_t<
-      MemcacheUpdateLike<Request>::value,
-      std::pair<std::vector<McSetRequest>, ChunksInfo>>
-  chunkUpdateRequests(
+  /**
+   * Keeps window_ chunks in flight, sending the next chunk as soon as any of
+   * them completes.
+   */
+  template <class FuncIt>
+  std::vector<typename std::result_of<
+      typename std::iterator_traits<FuncIt>::value_type()>::type>
+  collectAllPipelined(FuncIt beginF, FuncIt endF) const;
+
+  /**
+   * Grows the window while chunks are as fast as they've recently been, and
+   * shrinks it when they slow down (i.e. the window is queueing on servers).
+   */
+  void updateWindow(double avgChunkLatencyUs) const;
+
+  /**
+   * Creates the update request for chunk `chunkIndex` of `value`. The chunk
+   * value is a view into `value`'s buffers.
+   */
+  McSetRequest chunkUpdateRequest(
       folly::StringPiece baseKey,
       const folly::IOBuf& value,
-      int32_t exptime) const;
+      int32_t exptime,
+      const ChunksInfo& info,
+      uint32_t chunkIndex) const;
 
   template <class FromRequest>
   std::vector<McGetRequest> chunkGetRequests(
@@ -141,7 +187,8 @@ class BigValueRoute {
   Reply mergeChunkGetReplies(
       InputIterator begin,
       InputIterator end,
-      Reply&& initReply) const;
+      Reply&& initReply,
+      const ChunksInfo& info) const;
 
   folly::IOBuf
   createChunkKey(folly::StringPiece key, uint32_t index, uint64_t suffix) const;
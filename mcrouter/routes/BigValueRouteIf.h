@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
@@ -15,13 +18,23 @@ struct BigValueRouteOptions {
   constexpr explicit BigValueRouteOptions(
       size_t threshold_,
       size_t batchSize_,
-      bool hideReplyFlags_)
+      bool hideReplyFlags_,
+      size_t maxWindow_ = 0,
+      uint32_t compressionLevel_ = 0)
       : threshold(threshold_),
         batchSize(batchSize_),
-        hideReplyFlags(hideReplyFlags_) {}
+        hideReplyFlags(hideReplyFlags_),
+        maxWindow(maxWindow_),
+        compressionLevel(compressionLevel_) {}
   const size_t threshold;
   const size_t batchSize;
   const bool hideReplyFlags;
+  // If nonzero, chunks are sent through a sliding window of at most this many
+  // chunks in flight instead of in batches of batchSize.
+  const size_t maxWindow;
+  // If nonzero, big values are ZSTD compressed with this level before being
+  // split into chunks.
+  const uint32_t compressionLevel;
 };
 
 } // namespace mcrouter
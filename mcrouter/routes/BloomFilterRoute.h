@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <folly/Format.h>
+#include <folly/dynamic.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/TypeList.h"
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/routes/KeyBloomFilter.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Answers get, gets and metaget requests for keys that are definitely not in
+ * the Bloom filter "filter_file" with a miss, without sending them to
+ * "child". Everything else goes to "child".
+ *
+ * The filter is built offline (see KeyBloomFilter for the format) from the
+ * keys that exist, so it's only correct for key spaces that aren't written
+ * to outside of the filter builds. The file is checked for changes every
+ * "reload_interval_sec" (default 60) and memory mapped, once for all the
+ * routes using it.
+ */
+template <class RouterInfo>
+class BloomFilterRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+  template <class Request>
+  using IsFiltered = carbon::ListContains<
+      carbon::List<McGetRequest, McGetsRequest, McMetagetRequest>,
+      Request>;
+
+ public:
+  std::string routeName() const {
+    return folly::sformat("bloom-filter|{}", file_->path());
+  }
+
+  BloomFilterRoute(
+      RouteHandlePtr child,
+      std::shared_ptr<const KeyBloomFilterFile> file)
+      : child_(std::move(child)), file_(std::move(file)) {}
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(*child_, req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    if constexpr (IsFiltered<Request>::value) {
+      if (!filter().mayContain(req.key_ref()->fullKey())) {
+        if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+          ctx->proxy().stats().increment(bloom_filter_misses_stat);
+        }
+        return createReply(DefaultReply, req);
+      }
+    }
+    return child_->route(req);
+  }
+
+ private:
+  const RouteHandlePtr child_;
+  const std::shared_ptr<const KeyBloomFilterFile> file_;
+  // Every proxy has its own copy of the route, so these are only used from
+  // one thread.
+  mutable std::shared_ptr<const KeyBloomFilter> filter_;
+  mutable uint64_t filterVersion_{0};
+
+  const KeyBloomFilter& filter() const {
+    const auto version = file_->version();
+    if (FOLLY_UNLIKELY(version != filterVersion_)) {
+      filter_ = file_->get();
+      filterVersion_ = version;
+    }
+    return *filter_;
+  }
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeBloomFilterRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json,
+    CarbonRouterInstanceBase& router) {
+  checkLogic(json.isObject(), "BloomFilterRoute should be an object");
+  auto jchild = json.get_ptr("child");
+  checkLogic(jchild != nullptr, "BloomFilterRoute: no child");
+  auto jfile = json.get_ptr("filter_file");
+  checkLogic(
+      jfile != nullptr && jfile->isString(),
+      "BloomFilterRoute: filter_file is not a string");
+  std::chrono::seconds reloadInterval(60);
+  if (auto jinterval = json.get_ptr("reload_interval_sec")) {
+    checkLogic(
+        jinterval->isInt() && jinterval->getInt() > 0,
+        "BloomFilterRoute: reload_interval_sec is not a positive integer");
+    reloadInterval = std::chrono::seconds(jinterval->getInt());
+  }
+
+  auto file = KeyBloomFilterFile::getShared(
+      jfile->getString(), reloadInterval, router.functionScheduler());
+  return makeRouteHandleWithInfo<RouterInfo, BloomFilterRoute>(
+      factory.create(*jchild), std::move(file));
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
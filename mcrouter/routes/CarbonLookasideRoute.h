@@ -37,6 +37,15 @@ struct LeaseSettings {
   int32_t numRetries{10}; // Number of retries on a hot miss.
 };
 
+struct StalenessSettings {
+  // If non-zero, entries older than this many seconds (but younger than the
+  // ttl) are still returned, while one request refreshes them in the
+  // background.
+  int32_t softTtl{0};
+  // If non-zero, error and miss replies are cached for this many seconds.
+  int32_t negativeTtl{0};
+};
+
 std::shared_ptr<CarbonRouterInstance<MemcacheRouterInfo>>
 createCarbonLookasideRouter(
     const std::string& persistenceId,
@@ -72,7 +81,8 @@ LeaseSettings parseLeaseSettings(const folly::dynamic& json);
  *    // Whether or not we should cache the reply we received.
  *    // Note:
  *    //  - Just called for cache candidates.
- *    //  - Just called if non-error. Errors are not considered for caching.
+ *    //  - Just called if non-error. Errors are only cached with a
+ *    //    negative ttl (see StalenessSettings).
  *    template <typename Reply>
  *    bool shouldCacheReply(const Reply& reply);
  *
@@ -123,6 +133,7 @@ class CarbonLookasideRoute {
    *                      cache a given request. This helper is use-case
    *                      specific.
    * @param leaseSettings The lease settings for memcache leases.
+   * @param stalenessSettings  Soft ttl and negative caching settings.
    */
   CarbonLookasideRoute(
       RouteHandlePtr child,
@@ -133,7 +144,8 @@ class CarbonLookasideRoute {
       int32_t ttl,
       bool subSecTTL,
       CarbonLookasideHelper helper,
-      LeaseSettings leaseSettings)
+      LeaseSettings leaseSettings,
+      StalenessSettings stalenessSettings = StalenessSettings())
       : child_(std::move(child)),
         router_(std::move(router)),
         client_(std::move(client)),
@@ -142,7 +154,8 @@ class CarbonLookasideRoute {
         ttl_(ttl),
         subSecTTL_(subSecTTL),
         carbonLookasideHelper_(std::move(helper)),
-        leaseSettings_(std::move(leaseSettings)) {
+        leaseSettings_(std::move(leaseSettings)),
+        stalenessSettings_(stalenessSettings) {
     assert(router_);
     assert(client_);
   }
@@ -161,7 +174,11 @@ class CarbonLookasideRoute {
     bool cacheCandidate = carbonLookasideHelper_.cacheCandidate(req);
     if (cacheCandidate) {
       key = buildKey(req);
-      if (auto optReply = carbonLookasideGet<Request>(key, leaseToken)) {
+      bool stale = false;
+      if (auto optReply = carbonLookasideGet<Request>(key, leaseToken, stale)) {
+        if (stale) {
+          refreshInBackground(req, key);
+        }
         carbonLookasideHelper_.postProcessCachedReply(optReply.value());
         return optReply.value();
       }
@@ -169,9 +186,8 @@ class CarbonLookasideRoute {
 
     auto reply = child_->route(req);
 
-    if (cacheCandidate && !isErrorResult(*reply.result_ref()) &&
-        carbonLookasideHelper_.shouldCacheReply(reply)) {
-      carbonLookasideSet(key, reply, leaseToken);
+    if (cacheCandidate) {
+      cacheReply(key, reply, leaseToken);
     }
     return reply;
   }
@@ -186,29 +202,87 @@ class CarbonLookasideRoute {
   const bool subSecTTL_;
   CarbonLookasideHelper carbonLookasideHelper_;
   const LeaseSettings leaseSettings_;
+  const StalenessSettings stalenessSettings_;
+
+  // How long the request refreshing a stale entry keeps the others from
+  // refreshing it too.
+  static constexpr int32_t kRefreshLockTtlSeconds = 3;
 
   template <typename Request>
-  folly::Optional<ReplyT<Request>> carbonLookasideGet(
-      folly::StringPiece key,
-      int64_t& leaseToken) {
+  folly::Optional<ReplyT<Request>>
+  carbonLookasideGet(folly::StringPiece key, int64_t& leaseToken, bool& stale) {
     if (leaseSettings_.enableLeases) {
-      return carbonLookasideLeaseGet<Request>(key, leaseToken);
+      return carbonLookasideLeaseGet<Request>(key, leaseToken, stale);
+    }
+    return carbonLookasideGet<Request>(key, stale);
+  }
+
+  // Entries stored with a soft ttl carry the time (in seconds since epoch)
+  // they become stale in their flags.
+  bool isStale(uint64_t flags) const {
+    return stalenessSettings_.softTtl > 0 && flags != 0 &&
+        flags <= static_cast<uint64_t>(nowUs() / 1000000);
+  }
+
+  template <typename Reply>
+  void
+  cacheReply(folly::StringPiece key, const Reply& reply, int64_t leaseToken) {
+    const int32_t negativeTtl = stalenessSettings_.negativeTtl;
+    if (isErrorResult(*reply.result_ref())) {
+      if (negativeTtl > 0) {
+        carbonLookasideSet(key, reply, leaseToken, negativeTtl, 0);
+      }
+      return;
     }
-    return carbonLookasideGet<Request>(key);
+    if (!carbonLookasideHelper_.shouldCacheReply(reply)) {
+      return;
+    }
+    if (negativeTtl > 0 && isMissResult(*reply.result_ref())) {
+      carbonLookasideSet(key, reply, leaseToken, negativeTtl, 0);
+    } else {
+      carbonLookasideSet(key, reply, leaseToken, ttl_, softExpiryFlags());
+    }
+  }
+
+  // Routes `req` to the child in the background and caches the reply, unless
+  // another request (possibly on another host) is already refreshing `key`.
+  template <typename Request>
+  void refreshInBackground(const Request& req, const std::string& key) {
+    folly::fibers::addTask([this, req, key]() {
+      McAddRequest lockReq(folly::to<std::string>(key, ":refresh"));
+      lockReq.exptime_ref() = kRefreshLockTtlSeconds;
+      bool locked = false;
+      folly::fibers::Baton baton;
+      client_->send(
+          lockReq, [&baton, &locked](const McAddRequest&, McAddReply&& reply) {
+            locked = isStoredResult(*reply.result_ref());
+            baton.post();
+          });
+      baton.wait();
+      if (!locked) {
+        return;
+      }
+      const auto reply = child_->route(req);
+      cacheReply(key, reply, 0 /* leaseToken */);
+    });
   }
 
   // Build a request to CarbonLookaside to query for key. Successful replies
   // are deserialized.
   template <typename Request>
-  folly::Optional<ReplyT<Request>> carbonLookasideGet(folly::StringPiece key) {
+  folly::Optional<ReplyT<Request>> carbonLookasideGet(
+      folly::StringPiece key,
+      bool& stale) {
     McGetRequest cacheRequest(key);
     folly::Optional<ReplyT<Request>> ret;
     folly::fibers::Baton baton;
     client_->send(
         cacheRequest,
-        [&baton, &ret](const McGetRequest&, McGetReply&& cacheReply) {
+        [this, &baton, &ret, &stale](
+            const McGetRequest&, McGetReply&& cacheReply) {
           if (isHitResult(*cacheReply.result_ref()) &&
               cacheReply.value_ref().has_value()) {
+            stale = isStale(*cacheReply.flags_ref());
             folly::io::Cursor cur(&cacheReply.value_ref().value());
             carbon::CarbonProtocolReader reader(cur);
             ReplyT<Request> reply;
@@ -226,7 +300,8 @@ class CarbonLookasideRoute {
   template <typename Request>
   folly::Optional<ReplyT<Request>> carbonLookasideLeaseGet(
       folly::StringPiece key,
-      int64_t& leaseToken) {
+      int64_t& leaseToken,
+      bool& stale) {
     leaseToken = 0;
     McLeaseGetRequest cacheRequest(key);
     folly::Optional<ReplyT<Request>> ret;
@@ -241,11 +316,12 @@ class CarbonLookasideRoute {
       bool retry = false;
       client_->send(
           cacheRequest,
-          [this, &key, &baton, &ret, &retry, &leaseToken](
+          [this, &key, &baton, &ret, &retry, &leaseToken, &stale](
               const McLeaseGetRequest&, McLeaseGetReply&& cacheReply) {
             retry = false;
             if (isHitResult(*cacheReply.result_ref()) &&
                 cacheReply.value_ref().has_value()) {
+              stale = isStale(*cacheReply.flags_ref());
               folly::io::Cursor cur(&cacheReply.value_ref().value());
               carbon::CarbonProtocolReader reader(cur);
               ReplyT<Request> reply;
@@ -308,25 +384,40 @@ class CarbonLookasideRoute {
   void carbonLookasideSet(
       folly::StringPiece key,
       const Reply& reply,
-      int64_t leaseToken) {
+      int64_t leaseToken,
+      int32_t ttl,
+      uint64_t flags) {
     if (leaseSettings_.enableLeases && leaseToken) {
-      return carbonLookasideLeaseSet(key, reply, leaseToken);
+      return carbonLookasideLeaseSet(key, reply, leaseToken, ttl, flags);
     }
-    return carbonLookasideSet(key, reply);
+    return carbonLookasideSet(key, reply, ttl, flags);
+  }
+
+  int32_t exptime(int32_t ttl) const {
+    // ms ttl translates to a 1 second ttl on the server. Sub-second
+    // ttl is acheived by appending a time based suffix to the key.
+    return subSecTTL_ ? 1 : ttl;
+  }
+
+  // Flags of an entry stored now with the regular ttl, see isStale().
+  uint64_t softExpiryFlags() const {
+    if (stalenessSettings_.softTtl == 0) {
+      return 0;
+    }
+    return nowUs() / 1000000 + stalenessSettings_.softTtl;
   }
 
   // Build a request to memcache to store the serialized reply with the
   // provided key.
   template <typename Reply>
-  void carbonLookasideSet(folly::StringPiece key, const Reply& reply) {
+  void carbonLookasideSet(
+      folly::StringPiece key,
+      const Reply& reply,
+      int32_t ttl,
+      uint64_t flags) {
     McSetRequest req(key);
-    if (subSecTTL_) {
-      // ms ttl translates to a 1 second ttl on the server. Sub-second
-      // ttl is acheived by appending a time based suffix to the key.
-      req.exptime_ref() = 1;
-    } else {
-      req.exptime_ref() = ttl_;
-    }
+    req.exptime_ref() = exptime(ttl);
+    req.flags_ref() = flags;
     req.value_ref() = serializeOffFiber(reply);
     folly::fibers::addTask([this, req = std::move(req)]() {
       folly::fibers::Baton baton;
@@ -342,15 +433,12 @@ class CarbonLookasideRoute {
   void carbonLookasideLeaseSet(
       folly::StringPiece key,
       const Reply& reply,
-      const int64_t leaseToken) {
+      const int64_t leaseToken,
+      int32_t ttl,
+      uint64_t flags) {
     McLeaseSetRequest req(key);
-    if (subSecTTL_) {
-      // ms ttl translates to a 1 second ttl on the server. Sub-second
-      // ttl is acheived by appending a time based suffix to the key.
-      req.exptime_ref() = 1;
-    } else {
-      req.exptime_ref() = ttl_;
-    }
+    req.exptime_ref() = exptime(ttl);
+    req.flags_ref() = flags;
     req.leaseToken_ref() = leaseToken;
     req.value_ref() = serializeOffFiber(reply);
     folly::fibers::addTask([this, req = std::move(req)]() {
@@ -418,6 +506,8 @@ class CarbonLookasideRoute {
  *   "ttl": 10, // 10 seconds
  *   "key_split_size": 3, // we will have 3 different keys for the same request
  *   "prefix": "reg",
+ *   "soft_ttl": 8, // optional, stale entries are served while refreshed
+ *   "negative_ttl": 1, // optional, errors and misses are cached
  *   "flavor": "web",
  *   "helper_config": {
  *     // configs specific to the helper class.
@@ -493,6 +583,25 @@ typename RouterInfo::RouteHandlePtr createCarbonLookasideRoute(
 
   LeaseSettings leaseSettings = parseLeaseSettings(json);
 
+  StalenessSettings stalenessSettings;
+  if (auto jSoftTtl = json.get_ptr("soft_ttl")) {
+    checkLogic(
+        jSoftTtl->isInt() && jSoftTtl->getInt() > 0 &&
+            jSoftTtl->getInt() < ttl,
+        "CarbonLookasideRoute: 'soft_ttl' must be a positive integer smaller "
+        "than 'ttl'");
+    checkLogic(
+        !subSecTTL,
+        "CarbonLookasideRoute: 'soft_ttl' can't be used with sub-second ttl");
+    stalenessSettings.softTtl = jSoftTtl->getInt();
+  }
+  if (auto jNegativeTtl = json.get_ptr("negative_ttl")) {
+    checkLogic(
+        jNegativeTtl->isInt() && jNegativeTtl->getInt() > 0,
+        "CarbonLookasideRoute: 'negative_ttl' must be a positive integer");
+    stalenessSettings.negativeTtl = jNegativeTtl->getInt();
+  }
+
   auto helperConfig = json.get_ptr("helper_config");
   if (helperConfig) {
     checkLogic(
@@ -537,7 +646,8 @@ typename RouterInfo::RouteHandlePtr createCarbonLookasideRoute(
       ttl,
       subSecTTL,
       std::move(helper),
-      std::move(leaseSettings));
+      std::move(leaseSettings),
+      stalenessSettings);
 }
 
 } // namespace mcrouter
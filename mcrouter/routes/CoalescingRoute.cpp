@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "CoalescingRoute.h"
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr int64_t kDefaultMaxWaiters = 64;
+constexpr int64_t kDefaultTimeoutMs = 200;
+
+int64_t parsePositiveInt(
+    const folly::dynamic& json,
+    folly::StringPiece name,
+    int64_t defaultValue) {
+  auto jvalue = json.get_ptr(name);
+  if (!jvalue) {
+    return defaultValue;
+  }
+  checkLogic(jvalue->isInt(), "CoalescingRoute: {} is not an integer", name);
+  checkLogic(
+      jvalue->getInt() > 0, "CoalescingRoute: {} must be positive", name);
+  return jvalue->getInt();
+}
+
+} // namespace
+
+McrouterRouteHandlePtr makeCoalescingRoute(
+    RouteHandleFactory<McrouterRouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "CoalescingRoute should be object");
+  auto jchild = json.get_ptr("child");
+  checkLogic(jchild != nullptr, "CoalescingRoute: no child route");
+
+  auto maxWaiters = parsePositiveInt(json, "max_waiters", kDefaultMaxWaiters);
+  auto timeoutMs = parsePositiveInt(json, "timeout_ms", kDefaultTimeoutMs);
+
+  return makeMcrouterRouteHandleWithInfo<CoalescingRoute>(
+      factory.create(*jchild),
+      static_cast<size_t>(maxWaiters),
+      std::chrono::milliseconds(timeoutMs));
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
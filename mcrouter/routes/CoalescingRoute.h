@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Format.h>
+#include <folly/Optional.h>
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/container/F14Map.h>
+#include <folly/fibers/Baton.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/stats.h"
+
+namespace folly {
+struct dynamic;
+}
+
+namespace facebook {
+namespace memcache {
+
+template <class RouteHandleIf>
+class RouteHandleFactory;
+
+namespace mcrouter {
+
+/**
+ * Collapses concurrent identical gets ("singleflight").
+ *
+ * While a get for a key is in flight to "child", further gets for the same
+ * key wait for its reply instead of being sent upstream, and all of them get
+ * a copy of it. At most "max_waiters" requests wait on the same key; a
+ * waiter that doesn't get the reply within "timeout_ms" is sent to "child"
+ * on its own.
+ *
+ * A waiter may get a reply that was read from the server before the waiter
+ * itself arrived. That's no worse than any cache in front of the server, but
+ * don't use this route where gets must observe sets that completed right
+ * before them.
+ *
+ * Only plain gets are coalesced: the replies to gets/lease-get/gat carry
+ * per-request state (cas, lease tokens). All other requests are passed
+ * through. Each proxy has its own set of in-flight keys.
+ */
+template <class RouterInfo>
+class CoalescingRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+ public:
+  std::string routeName() const {
+    return folly::sformat(
+        "coalescing|max_waiters={}|timeout_ms={}",
+        maxWaiters_,
+        timeout_.count());
+  }
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(*child_, req);
+  }
+
+  CoalescingRoute(
+      RouteHandlePtr child,
+      size_t maxWaiters,
+      std::chrono::milliseconds timeout)
+      : child_(std::move(child)), maxWaiters_(maxWaiters), timeout_(timeout) {
+    assert(child_ != nullptr);
+  }
+
+  McGetReply route(const McGetRequest& req) {
+    auto key = req.key_ref()->fullKey();
+    auto it = inFlight_.find(key);
+    if (it != inFlight_.end()) {
+      // Keep the flight alive even if the leader is done before we wake up.
+      auto flight = it->second;
+      if (flight->waiters.size() >= maxWaiters_) {
+        return child_->route(req);
+      }
+      return waitFor(*flight, req);
+    }
+
+    auto flight = std::make_shared<Flight>();
+    // `key` points into `req`, which outlives the entry.
+    inFlight_.emplace(key, flight);
+    SCOPE_EXIT {
+      inFlight_.erase(key);
+      // Wake up the waiters even if the child threw; without a reply they
+      // will fall back to sending their own request.
+      for (auto* waiter : flight->waiters) {
+        waiter->post();
+      }
+      flight->waiters.clear();
+    };
+
+    auto reply = child_->route(req);
+    flight->reply = reply;
+    return reply;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    return child_->route(req);
+  }
+
+ private:
+  struct Flight {
+    folly::Optional<McGetReply> reply;
+    std::vector<folly::fibers::Baton*> waiters;
+  };
+
+  const RouteHandlePtr child_;
+  const size_t maxWaiters_;
+  const std::chrono::milliseconds timeout_;
+  folly::F14FastMap<folly::StringPiece, std::shared_ptr<Flight>> inFlight_;
+
+  McGetReply waitFor(Flight& flight, const McGetRequest& req) {
+    folly::fibers::Baton baton;
+    flight.waiters.push_back(&baton);
+    if (!baton.try_wait_for(timeout_)) {
+      auto& waiters = flight.waiters;
+      waiters.erase(std::remove(waiters.begin(), waiters.end(), &baton));
+      bumpStat(coalesced_requests_timeout_stat);
+      return child_->route(req);
+    }
+    if (!flight.reply) {
+      return child_->route(req);
+    }
+    bumpStat(coalesced_requests_stat);
+    return *flight.reply;
+  }
+
+  static void bumpStat(stat_name_t stat) {
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      ctx->proxy().stats().increment(stat);
+    }
+  }
+};
+
+McrouterRouteHandlePtr makeCoalescingRoute(
+    RouteHandleFactory<McrouterRouteHandleIf>& factory,
+    const folly::dynamic& json);
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -35,12 +35,19 @@ class DefaultShadowPolicy {
     return true;
   }
 
+  /**
+   * The copy is shallow: key and value IOBufs are cloned, so they share the
+   * buffers of `req` instead of copying the data.
+   */
   template <class Request>
   std::shared_ptr<const Request> makeAdjustedNormalRequest(
       const Request& req) const {
     return std::make_shared<Request>(req);
   }
 
+  /**
+   * Every shadow destination gets the very same request object.
+   */
   template <class Request>
   std::shared_ptr<const Request> makeShadowRequest(
       const std::shared_ptr<const Request>& normalReq) const {
@@ -7,11 +7,15 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
+#include <vector>
 
+#include <folly/Conv.h>
 #include <folly/Format.h>
 #include <folly/Optional.h>
 #include <folly/ScopeGuard.h>
+#include <folly/fibers/Baton.h>
 #include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/AsyncLog.h"
@@ -22,6 +26,7 @@
 #include "mcrouter/McrouterFiberContext.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/ProxyDestination.h"
+#include "mcrouter/ProxyDestinationMap.h"
 #include "mcrouter/ProxyRequestContext.h"
 #include "mcrouter/config-impl.h"
 #include "mcrouter/config.h"
@@ -30,6 +35,7 @@
 #include "mcrouter/lib/carbon/FailoverUtil.h"
 #include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/debug/RequestTracer.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
@@ -49,6 +55,17 @@ namespace mcrouter {
 /**
  * Routes a request to a single ProxyDestination.
  * This is the lowest level in Mcrouter's RouteHandle tree.
+ *
+ * Optionally, the same server can be reached through several connections
+ * (extra ProxyDestinations for the same AccessPoint). Each request then goes
+ * to the connection with the fewest outstanding requests, preferring the
+ * primary one on ties, so that extra connections are only opened under load
+ * and get closed by the inactive connection reset once the load goes away.
+ *
+ * With a shared owner, requests are handed over to the owner proxy, which
+ * sends them through its own connection to the same server, until this
+ * proxy sends more than `sharedPromoteRps` requests in a second. From then on
+ * the route uses its own connection (for the lifetime of the config).
  */
 template <class RouterInfo, class Transport>
 class DestinationRoute {
@@ -66,6 +83,7 @@ class DestinationRoute {
 
   /**
    * @param destination The destination where the request is to be sent
+   * @param extraDestinations Additional connections to the same server
    */
   DestinationRoute(
       std::shared_ptr<ProxyDestination<Transport>> destination,
@@ -74,8 +92,15 @@ class DestinationRoute {
       int32_t poolStatIdx,
       std::chrono::milliseconds timeout,
       bool disableRequestDeadlineCheck,
-      bool keepRoutingPrefix)
+      bool keepRoutingPrefix,
+      std::vector<std::shared_ptr<ProxyDestination<Transport>>>
+          extraDestinations = {},
+      ProxyBase* sharedOwner = nullptr,
+      uint32_t sharedPromoteRps = 0)
       : destination_(std::move(destination)),
+        extraDestinations_(std::move(extraDestinations)),
+        sharedOwner_(sharedOwner),
+        sharedPromoteRps_(sharedPromoteRps),
         poolName_(poolName),
         indexInPool_(indexInPool),
         poolStatIndex_(poolStatIdx),
@@ -83,6 +108,9 @@ class DestinationRoute {
         disableRequestDeadlineCheck_(disableRequestDeadlineCheck),
         keepRoutingPrefix_(keepRoutingPrefix) {
     destination_->setPoolStatsIndex(poolStatIdx);
+    for (auto& extraDestination : extraDestinations_) {
+      extraDestination->setPoolStatsIndex(poolStatIdx);
+    }
   }
 
   template <class Request>
@@ -131,6 +159,13 @@ class DestinationRoute {
 
  private:
   const std::shared_ptr<ProxyDestination<Transport>> destination_;
+  const std::vector<std::shared_ptr<ProxyDestination<Transport>>>
+      extraDestinations_;
+  // Proxy owning the shared connection, nullptr if not shared (or promoted).
+  mutable ProxyBase* sharedOwner_{nullptr};
+  const uint32_t sharedPromoteRps_{0};
+  mutable int64_t sharedWindowStartUs_{0};
+  mutable uint32_t sharedWindowRequests_{0};
   const folly::StringPiece poolName_;
   const size_t indexInPool_;
   const int32_t poolStatIndex_{-1};
@@ -139,6 +174,73 @@ class DestinationRoute {
   const bool disableRequestDeadlineCheck_;
   const bool keepRoutingPrefix_;
 
+  ProxyDestination<Transport>& pickDestination() const {
+    if (FOLLY_LIKELY(extraDestinations_.empty())) {
+      return *destination_;
+    }
+    auto* best = destination_.get();
+    auto bestStats = best->getRequestStats();
+    auto bestOutstanding = bestStats.numPending + bestStats.numInflight;
+    for (const auto& extraDestination : extraDestinations_) {
+      if (bestOutstanding == 0) {
+        break;
+      }
+      auto stats = extraDestination->getRequestStats();
+      auto outstanding = stats.numPending + stats.numInflight;
+      if (outstanding < bestOutstanding) {
+        best = extraDestination.get();
+        bestOutstanding = outstanding;
+      }
+    }
+    return *best;
+  }
+
+  /**
+   * @return  true if the request should go through the owner's connection.
+   */
+  bool useSharedConnection(ProxyBase& proxy) const {
+    if (FOLLY_LIKELY(sharedOwner_ == nullptr)) {
+      return false;
+    }
+    auto now = nowUs();
+    if (now - sharedWindowStartUs_ >= 1000000) {
+      sharedWindowStartUs_ = now;
+      sharedWindowRequests_ = 0;
+    }
+    if (++sharedWindowRequests_ > sharedPromoteRps_) {
+      sharedOwner_ = nullptr;
+      proxy.stats().increment(shared_connection_promotions_stat);
+      return false;
+    }
+    return true;
+  }
+
+  template <class Request>
+  ReplyT<Request> send(
+      ProxyDestination<Transport>& destination,
+      const Request& req,
+      DestinationRequestCtx& dctx,
+      RpcStatsContext& rpcContext,
+      ProxyBase& proxy,
+      std::chrono::milliseconds timeout) const {
+    if (!useSharedConnection(proxy)) {
+      return destination.send(req, dctx, timeout, rpcContext);
+    }
+    proxy.stats().increment(shared_connection_forwarded_reqs_stat);
+    // The request, contexts and reply outlive the remote task, since this
+    // fiber is blocked on the baton until it's done.
+    auto& owner = *sharedOwner_;
+    folly::Optional<ReplyT<Request>> reply;
+    folly::fibers::Baton baton;
+    owner.fiberManager().addTaskRemote([&]() {
+      auto shared = owner.destinationMap()->emplaceShared(destination);
+      reply = shared->send(req, dctx, timeout, rpcContext);
+      baton.post();
+    });
+    baton.wait();
+    return std::move(*reply);
+  }
+
   template <class Request>
   ReplyT<Request> routeWithDestination(const Request& req) const {
     auto reply = checkAndRoute(req);
@@ -165,9 +267,28 @@ class DestinationRoute {
           RemoteErrorReply,
           std::string("Failed to send request - deadline exceeded"));
     }
+    if (!isShadow && !disableRequestDeadlineCheck_ && ctx->deadlineUs() != 0 &&
+        nowUs() >= ctx->deadlineUs()) {
+      proxy->stats().increment(request_timeout_budget_exceeded_stat);
+      return constructAndLog(
+          req,
+          *ctx,
+          RemoteErrorReply,
+          std::string("Failed to send request - client timeout budget spent"));
+    }
+    if (!isShadow && ctx->clientGone()) {
+      proxy->stats().increment(request_client_gone_dropped_stat);
+      return constructAndLog(
+          req,
+          *ctx,
+          ErrorReply,
+          carbon::Result::ABORTED,
+          std::string("Request not sent - client disconnected"));
+    }
 
+    auto& destination = pickDestination();
     carbon::Result tkoReason;
-    if (!destination_->maySend(tkoReason)) {
+    if (!destination.maySend(tkoReason)) {
       return constructAndLog(
           req,
           *ctx,
@@ -215,7 +336,7 @@ class DestinationRoute {
       }
     };
 
-    return doRoute(req, *ctx);
+    return doRoute(req, *ctx, destination);
   }
 
   template <class Request, class... Args>
@@ -260,8 +381,21 @@ class DestinationRoute {
   template <class Request>
   ReplyT<Request> doRoute(
       const Request& req,
-      ProxyRequestContextWithInfo<RouterInfo>& ctx) const {
+      ProxyRequestContextWithInfo<RouterInfo>& ctx,
+      ProxyDestination<Transport>& destination) const {
     DestinationRequestCtx dctx(nowUs());
+    std::optional<RequestTracer::Scope> traceScope;
+    if (auto* tracer = ctx.proxy().requestTracer()) {
+      auto& traceContext = fiber_local<RouterInfo>::traceContext();
+      if (traceContext.sampled()) {
+        traceScope.emplace(
+            *tracer,
+            traceContext,
+            folly::to<std::string>(
+                "destination|",
+                destination_->accessPoint()->toHostPortString()));
+      }
+    }
     std::optional<Request> newReq;
     folly::StringPiece strippedRoutingPrefix;
     if (!keepRoutingPrefix_ && !req.key_ref()->routingPrefix().empty()) {
@@ -275,6 +409,21 @@ class DestinationRoute {
     uint64_t totalDestTimeout = 0;
     auto requestClass = fiber_local<RouterInfo>::getRequestClass();
     bool isShadow = requestClass.is(RequestClass::kShadow);
+    if (!isShadow) {
+      dctx.clientGone = ctx.clientGoneFlag();
+    }
+
+    // Don't wait (nor make the destination work) longer than the client.
+    auto timeout = timeout_;
+    if (!isShadow && !disableRequestDeadlineCheck_ && ctx.deadlineUs() != 0) {
+      const std::chrono::milliseconds budget(
+          std::max<int64_t>((ctx.deadlineUs() - nowUs() + 999) / 1000, 1));
+      if (budget < timeout) {
+        timeout = budget;
+        dctx.timeoutClamped = true;
+        ctx.proxy().stats().increment(request_timeout_budget_clamped_stat);
+      }
+    }
 
     if (!isShadow && !disableRequestDeadlineCheck_) {
       auto remainingTime = getRemainingTime(req);
@@ -284,7 +433,7 @@ class DestinationRoute {
       if (remainingTime.first) {
         remainingDeadlineTime = remainingTime.second;
         totalDestTimeout =
-            timeout_.count() + destination_->shortestConnectTimeout().count();
+            timeout.count() + destination.shortestConnectTimeout().count();
       }
     }
 
@@ -323,7 +472,8 @@ class DestinationRoute {
         dctx.startTime,
         bucketId);
     RpcStatsContext rpcContext;
-    auto reply = destination_->send(reqToSend, dctx, timeout_, rpcContext);
+    auto reply =
+        send(destination, reqToSend, dctx, rpcContext, ctx.proxy(), timeout);
     ctx.onReplyReceived(
         poolName_,
         std::optional<size_t>(indexInPool_),
@@ -414,7 +564,11 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> makeDestinationRoute(
     int32_t poolStatsIndex,
     std::chrono::milliseconds timeout,
     bool disableRequestDeadlineCheck,
-    bool keepRoutingPrefix) {
+    bool keepRoutingPrefix,
+    std::vector<std::shared_ptr<ProxyDestination<Transport>>>
+        extraDestinations = {},
+    ProxyBase* sharedOwner = nullptr,
+    uint32_t sharedPromoteRps = 0) {
   return makeRouteHandleWithInfo<RouterInfo, DestinationRoute, Transport>(
       std::move(destination),
       poolName,
@@ -422,7 +576,10 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> makeDestinationRoute(
       poolStatsIndex,
       timeout,
       disableRequestDeadlineCheck,
-      keepRoutingPrefix);
+      keepRoutingPrefix,
+      std::move(extraDestinations),
+      sharedOwner,
+      sharedPromoteRps);
 }
 
 } // namespace mcrouter
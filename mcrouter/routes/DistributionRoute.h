@@ -8,6 +8,10 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <string>
+
+#include <folly/fibers/WhenN.h>
 
 #include "mcrouter/McSpoolUtils.h"
 #include "mcrouter/McrouterFiberContext.h"
@@ -93,14 +97,53 @@ class DistributionRoute {
     auto bucketId = fiber_local<RouterInfo>::getBucketId();
     assert(axonCtx && bucketId);
 
-    bool spoolSucceeded = false;
     auto source = distributionRegion.value().empty()
         ? memcache::McDeleteRequestSource::CROSS_REGION_BROADCAST_INVALIDATION
         : memcache::McDeleteRequestSource::CROSS_REGION_DIRECTED_INVALIDATION;
     auto finalReq = addDeleteRequestSource(req, source);
     finalReq.bucketId_ref() = *bucketId;
-    auto axonLogRes = spoolAxonProxy(
+
+    if (distributedDeleteRpcEnabled_ && proxy.axonBatcher()) {
+      // A batched write waits for the batch window, don't make the rpc wait
+      // for it as well.
+      McDeleteReply reply;
+      std::function<void()> fs[2]{
+          [&]() {
+            distribute(
+                proxy, finalReq, axonCtx, *bucketId, *distributionRegion);
+          },
+          [&]() { reply = rh_->route(req); }};
+      folly::fibers::collectAll(fs, fs + 2);
+      return reply;
+    }
+
+    bool spoolSucceeded = distribute(
         proxy, finalReq, axonCtx, *bucketId, std::move(*distributionRegion));
+    // if spool to Axon or Asynclog succeeded and rpc is disabled, we return
+    // default reply to the client:
+    if (!distributedDeleteRpcEnabled_) {
+      return spoolSucceeded ? createReply(DefaultReply, finalReq)
+                            : McDeleteReply(carbon::Result::LOCAL_ERROR);
+    }
+    return rh_->route(req);
+  }
+
+ private:
+  const RouteHandlePtr rh_;
+  const bool distributedDeleteRpcEnabled_;
+  const bool replay_;
+
+  // Writes the delete to Axon, or to asynclog if that fails.
+  // @return  true if either succeeded.
+  bool distribute(
+      ProxyBase& proxy,
+      const McDeleteRequest& finalReq,
+      const std::shared_ptr<AxonContext>& axonCtx,
+      uint64_t bucketId,
+      std::string distributionRegion) const {
+    bool spoolSucceeded = false;
+    auto axonLogRes = spoolAxonProxy(
+        proxy, finalReq, axonCtx, bucketId, std::move(distributionRegion));
     if (axonLogRes) {
       proxy.stats().increment(distribution_axon_write_success_stat);
     }
@@ -119,20 +162,9 @@ class DistributionRoute {
     if (!spoolSucceeded) {
       proxy.stats().increment(distribution_async_spool_failed_stat);
     }
-    // if spool to Axon or Asynclog succeeded and rpc is disabled, we return
-    // default reply to the client:
-    if (!distributedDeleteRpcEnabled_) {
-      return spoolSucceeded ? createReply(DefaultReply, finalReq)
-                            : McDeleteReply(carbon::Result::LOCAL_ERROR);
-    }
-    return rh_->route(req);
+    return spoolSucceeded;
   }
 
- private:
-  const RouteHandlePtr rh_;
-  const bool distributedDeleteRpcEnabled_;
-  const bool replay_;
-
   std::optional<std::string> inferDistributionRegionForReplay(
       const McDeleteRequest& req,
       ProxyBase& proxy) const {
@@ -8,17 +8,20 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include <boost/dynamic_bitset.hpp>
 #include <boost/iterator/iterator_facade.hpp>
 
-#include <folly/container/F14Map.h>
+#include <folly/Conv.h>
 #include <folly/container/F14Set.h>
 #include <folly/dynamic.h>
+#include <folly/fibers/FiberManager.h>
 
 #include "mcrouter/lib/Ch3HashFunc.h"
 #include "mcrouter/lib/HashSelector.h"
+#include "mcrouter/lib/HashUtil.h"
 #include "mcrouter/lib/RendezvousHashFunc.h"
 #include "mcrouter/lib/RendezvousHashHelper.h"
 #include "mcrouter/lib/Reply.h"
@@ -303,6 +306,29 @@ class FailoverDeterministicOrderPolicy {
          funcType_ == WeightedCh3HashFunc::type()),
         "Unknown hash function {}",
         funcType_);
+    // Built once, not on every failover attempt.
+    if (funcType_ == WeightedCh3HashFunc::type()) {
+      weightedCh3Func_.emplace(config_, children_.size());
+    }
+    failureDomains_.resize(children_.size(), 0);
+  }
+
+  /**
+   * Index of the child tried by the failover attempt with the given salt.
+   */
+  template <class Request>
+  size_t selectIndex(const Request& req, uint32_t salt) const {
+    char saltBuf[20];
+    folly::StringPiece saltStr(
+        saltBuf, folly::uint64ToBufferUnsafe(salt, saltBuf));
+    const auto nChildren = children_.size();
+    return folly::fibers::runInMainContext([&]() {
+      return hashWithSalt(
+          req.key_ref()->routingKey(), saltStr, [&](folly::StringPiece key) {
+            return weightedCh3Func_ ? (*weightedCh3Func_)(key)
+                                    : Ch3HashFunc(nChildren)(key);
+          });
+    });
   }
 
   class ChildProxy {
@@ -443,16 +469,7 @@ class FailoverDeterministicOrderPolicy {
       bool failedDomain = false;
       do {
         salt_++;
-        if (funcType_ == Ch3HashFunc::type()) {
-          Ch3HashFunc ch3Func(nChildren);
-          index_ = HashSelector<Ch3HashFunc>(std::to_string(salt_), ch3Func)
-                       .select(req_, nChildren);
-        } else {
-          WeightedCh3HashFunc wCh3Func{config_, nChildren};
-          index_ =
-              HashSelector<WeightedCh3HashFunc>(std::to_string(salt_), wCh3Func)
-                  .select(req_, nChildren);
-        }
+        index_ = policy_.selectIndex(req_, salt_);
 
         // Use failure domains only in case of non-const iterators
         if constexpr (!std::is_const<Policy>{}) {
@@ -566,19 +583,15 @@ class FailoverDeterministicOrderPolicy {
   }
 
   uint32_t getMemoizedFailureDomain(uint32_t index) const {
-    auto it = failureDomainMap_.find(index);
-    if (it != failureDomainMap_.end()) {
-      return it->second;
-    }
-    return 0;
+    return index < failureDomains_.size() ? failureDomains_[index] : 0;
   }
 
   void memoizeFailureDomain(uint32_t index, uint32_t failureDomain) {
     auto existingFD = getMemoizedFailureDomain(index);
     if (existingFD != 0) {
       assert(existingFD == failureDomain);
-    } else {
-      failureDomainMap_[index] = failureDomain;
+    } else if (index < failureDomains_.size()) {
+      failureDomains_[index] = failureDomain;
     }
   }
 
@@ -596,8 +609,9 @@ class FailoverDeterministicOrderPolicy {
   uint32_t salt_{1};
   bool enableFailureDomains_{false};
   bool ignore_normal_reply_index_{false};
-  // map of index in children_ to it's failure Domain
-  folly::F14FastMap<uint32_t, uint32_t> failureDomainMap_;
+  std::optional<WeightedCh3HashFunc> weightedCh3Func_;
+  // failure domain of each child, 0 until it is known
+  std::vector<uint32_t> failureDomains_;
 };
 
 template <typename RouteHandleIf, typename RouterInfo, typename HashFunc>
@@ -7,8 +7,11 @@
 
 #include "FailoverRateLimiter.h"
 
+#include <folly/Conv.h>
 #include <folly/dynamic.h>
+#include <folly/json.h>
 
+#include "mcrouter/lib/SharedObjectCache.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 
 namespace facebook {
@@ -39,8 +42,31 @@ folly::TokenBucket tbFromJson(const folly::dynamic& json) {
 
 } // namespace
 
-FailoverRateLimiter::FailoverRateLimiter(const folly::dynamic& json)
-    : tb_(tbFromJson(json)) {}
+FailoverRateLimiter::FailoverRateLimiter(
+    const folly::dynamic& json,
+    const folly::dynamic& routeJson)
+    : tb_(tbFromJson(json)) {
+  auto jShared = json.get_ptr("shared");
+  if (!jShared) {
+    return;
+  }
+  checkLogic(jShared->isBool(), "FailoverRateLimiter: shared is not a bool");
+  if (!jShared->getBool()) {
+    return;
+  }
+  // Leaked on purpose, so that routes may be destroyed at any time.
+  static auto* buckets = new SharedObjectCache<SharedBucket>();
+  folly::json::serialization_opts opts;
+  opts.sort_keys = true;
+  auto key = folly::to<std::string>(
+      folly::json::serialize(routeJson, opts),
+      '\0',
+      folly::json::serialize(json, opts));
+  shared_ = buckets->getOrCreate(std::move(key), [this]() {
+    return std::make_shared<const SharedBucket>(tb_);
+  });
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include <folly/TokenBucket.h>
 
 namespace folly {
@@ -22,6 +25,11 @@ namespace mcrouter {
  * We rate limit failover requests over normal requests: rate 0.5 means
  * we'll failover at most 50% of all requests, doesn't matter how many
  * requests we send per second.
+ *
+ * By default every proxy has its own limiter, so the effective budget grows
+ * with the number of proxies and is split unevenly between them. A shared
+ * limiter has a single bucket for all proxies instead: both the request
+ * count and the bucket are updated atomically, without locks.
  */
 class FailoverRateLimiter {
  public:
@@ -32,19 +40,30 @@ class FailoverRateLimiter {
    * @param json  Rate limiting configuration; must be an object. Format:
    *                {
    *                  "rate": [0..1],
-   *                  "burst": [1..INF]
+   *                  "burst": [1..INF],
+   *                  "shared": bool
    *                }
    *              Where rate and burst parameters are passed to
    *              the corresponding TokenBucket's constructor.
    *              If burst key is missing, burst is set to default (see .cpp).
+   *              If shared is true, all limiters created with the same json
+   *              and `routeJson` use one bucket.
+   * @param routeJson  Config of the route owning this limiter, so that
+   *                   identical limits of different routes are not shared.
    */
-  explicit FailoverRateLimiter(const folly::dynamic& json);
+  FailoverRateLimiter(
+      const folly::dynamic& json,
+      const folly::dynamic& routeJson);
 
   /**
    * Bumps total number of requests (both failed and successful)
    */
   void bumpTotalReqs() {
-    ++totalReqs_;
+    if (shared_) {
+      shared_->totalReqs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      ++totalReqs_;
+    }
   }
 
   /**
@@ -53,12 +72,29 @@ class FailoverRateLimiter {
    * @return true  if we didn't hit the failover limit, false otherwise
    */
   bool failoverAllowed() {
+    if (shared_) {
+      return shared_->tb.consume(
+          1, shared_->totalReqs.load(std::memory_order_relaxed));
+    }
     return tb_.consume(1, totalReqs_);
   }
 
+  bool isShared() const {
+    return shared_ != nullptr;
+  }
+
  private:
+  // Shared by all proxies, only touched through atomic operations.
+  struct SharedBucket {
+    explicit SharedBucket(folly::TokenBucket tb) : tb(std::move(tb)) {}
+
+    mutable folly::TokenBucket tb;
+    mutable std::atomic<size_t> totalReqs{0};
+  };
+
   folly::TokenBucket tb_;
   size_t totalReqs_{0};
+  std::shared_ptr<const SharedBucket> shared_;
 };
 } // namespace mcrouter
 } // namespace memcache
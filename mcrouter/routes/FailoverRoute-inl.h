@@ -90,6 +90,7 @@ makeFailoverRouteWithPolicyAndFailoverError(
   }
 
   std::unique_ptr<FailoverRateLimiter> rateLimiter;
+  std::shared_ptr<const RetryBudget> retryBudget;
   bool failoverTagging = false;
   bool enableLeasePairing = false;
   std::string name;
@@ -113,7 +114,11 @@ makeFailoverRouteWithPolicyAndFailoverError(
       failoverTagging = jFailoverTag->getBool();
     }
     if (auto jFailoverLimit = json.get_ptr("failover_limit")) {
-      rateLimiter = std::make_unique<FailoverRateLimiter>(*jFailoverLimit);
+      rateLimiter =
+          std::make_unique<FailoverRateLimiter>(*jFailoverLimit, json);
+    }
+    if (auto jRetryBudget = json.get_ptr("retry_budget")) {
+      retryBudget = RetryBudget::getShared(*jRetryBudget, json);
     }
   }
 
@@ -129,6 +134,7 @@ makeFailoverRouteWithPolicyAndFailoverError(
       enableLeasePairing,
       std::move(name),
       policyConfig,
+      std::move(retryBudget),
       std::forward<Args>(args)...);
 }
 
@@ -24,6 +24,7 @@
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/routes/FailoverPolicy.h"
 #include "mcrouter/routes/FailoverRateLimiter.h"
+#include "mcrouter/routes/RetryBudget.h"
 
 namespace folly {
 struct dynamic;
@@ -105,11 +106,13 @@ class FailoverRoute {
       bool failoverTagging,
       bool enableLeasePairing,
       std::string name,
-      const folly::dynamic& policyConfig)
+      const folly::dynamic& policyConfig,
+      std::shared_ptr<const RetryBudget> retryBudget = nullptr)
       : name_(detail::getFailoverRouteName(std::move(name), targets.size())),
         targets_(std::move(targets)),
         failoverErrors_(std::move(failoverErrors)),
         rateLimiter_(std::move(rateLimiter)),
+        retryBudget_(std::move(retryBudget)),
         failoverTagging_(failoverTagging),
         failoverPolicy_(targets_, policyConfig),
         enableLeasePairing_(enableLeasePairing) {
@@ -182,6 +185,7 @@ class FailoverRoute {
   const std::vector<std::shared_ptr<RouteHandleIf>> targets_;
   const FailoverErrorsSettingsT failoverErrors_;
   std::unique_ptr<FailoverRateLimiter> rateLimiter_;
+  const std::shared_ptr<const RetryBudget> retryBudget_;
   const bool failoverTagging_{false};
   FailoverPolicyT failoverPolicy_;
   const bool enableLeasePairing_{false};
@@ -199,6 +203,9 @@ class FailoverRoute {
       bool& conditionalFailover,
       Iterator& iter,
       FailoverPolicyContext& ctx) {
+    if (retryBudget_ && !isErrorResult(*reply.result_ref())) {
+      retryBudget_->recordSuccess();
+    }
     auto res = shouldFailover(reply, req);
     if (FOLLY_LIKELY(res == FailoverErrorsSettingsBase::FailoverType::NONE)) {
       return true;
@@ -225,6 +232,10 @@ class FailoverRoute {
         proxy.stats().increment(failover_rate_limited_stat);
         return true;
       }
+      if (retryBudget_ && !retryBudget_->tryRetry()) {
+        proxy.stats().increment(retry_budget_exhausted_stat);
+        return true;
+      }
       // We didn't do any work for TKO or hard TKO. Don't count it as a try.
       if (!failoverPolicy_.excludeError(*reply.result_ref())) {
         ++ctx.numTries_;
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Immutable-after-build map from shard id to destination index, laid out as
+ * one contiguous array indexed by shard id plus a bitset of present shards.
+ *
+ * Shard ids are dense in practice, so this takes ~4 bytes per possible shard
+ * id instead of the ~40 bytes per entry (plus pointer chasing) of an
+ * unordered_map, and a lookup is a bit test and one array load.
+ * Can be used as the MapType of the (Eager)ShardSelectionRoute factories.
+ */
+class FlatShardMap {
+ public:
+  static constexpr uint32_t kNotFound = std::numeric_limits<uint32_t>::max();
+
+  FlatShardMap() = default;
+  explicit FlatShardMap(size_t maxShardId)
+      : indexes_(maxShardId + 1, kNotFound), present_(maxShardId / 64 + 1) {}
+
+  /**
+   * Same semantics as unordered_map::operator[]: marks the shard as present
+   * and returns a reference to its destination index.
+   */
+  uint32_t& operator[](size_t shard) {
+    if (shard >= indexes_.size()) {
+      indexes_.resize(shard + 1, kNotFound);
+      present_.resize(shard / 64 + 1);
+    }
+    auto& word = present_[shard / 64];
+    auto bit = uint64_t(1) << (shard % 64);
+    if (!(word & bit)) {
+      word |= bit;
+      ++size_;
+    }
+    return indexes_[shard];
+  }
+
+  bool contains(size_t shard) const noexcept {
+    return shard < indexes_.size() &&
+        (present_[shard / 64] >> (shard % 64)) & 1;
+  }
+
+  /**
+   * @return  Destination index of the shard, or kNotFound.
+   */
+  uint32_t find(size_t shard) const noexcept {
+    return contains(shard) ? indexes_[shard] : kNotFound;
+  }
+
+  /**
+   * Number of present shards.
+   */
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  bool empty() const noexcept {
+    return size_ == 0;
+  }
+
+  /**
+   * Number of shard ids (starting at 0) the map holds without growing.
+   */
+  size_t capacity() const noexcept {
+    return indexes_.size();
+  }
+
+ private:
+  std::vector<uint32_t> indexes_;
+  std::vector<uint64_t> present_;
+  size_t size_{0};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <limits>
+
 #include <folly/dynamic.h>
 
 #include "mcrouter/lib/Ch3HashFunc.h"
@@ -18,8 +20,11 @@
 #include "mcrouter/lib/WeightedCh4HashFunc.h"
 #include "mcrouter/lib/WeightedRendezvousHashFunc.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 #include "mcrouter/lib/routes/SelectionRoute.h"
+#include "mcrouter/routes/DestinationRoute.h"
 #include "mcrouter/routes/LatestRoute.h"
 #include "mcrouter/routes/LoadBalancerRoute.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
@@ -38,9 +43,25 @@ HashSelector<HashFunc> createHashSelector(std::string salt, HashFunc func) {
 template <class HashFunc, class RouterInfo>
 BucketHashSelector<HashFunc, RouterInfo> createBucketHashSelector(
     std::string salt,
-    HashFunc func) {
+    HashFunc func,
+    size_t numPrecomputedBuckets = 0,
+    size_t size = 0) {
   return BucketHashSelector<HashFunc, RouterInfo>(
-      std::move(salt), std::move(func));
+      std::move(salt), std::move(func), numPrecomputedBuckets, size);
+}
+
+/**
+ * Pools are mostly hash routes directly over memcache destinations, so
+ * dispatch to those without a virtual call per request.
+ */
+template <class RouterInfo, class Selector>
+typename RouterInfo::RouteHandlePtr createPoolSelectionRoute(
+    std::vector<typename RouterInfo::RouteHandlePtr> children,
+    Selector selector) {
+  return createSelectionRouteForChildType<
+      RouterInfo,
+      DestinationRoute<RouterInfo, AsyncMcClient>>(
+      std::move(children), std::move(selector));
 }
 
 template <class RouterInfo, class HashFunc>
@@ -50,13 +71,14 @@ typename std::
         std::vector<typename RouterInfo::RouteHandlePtr> rh,
         std::string salt,
         HashFunc func,
-        bool bucketized = false) {
+        bool bucketized = false,
+        size_t /* numPrecomputedBuckets */ = 0) {
   checkLogic(
       !bucketized,
       "Bucketization not implemented for router info: {}",
       RouterInfo::name);
 
-  return createSelectionRoute<RouterInfo, HashSelector<HashFunc>>(
+  return createPoolSelectionRoute<RouterInfo, HashSelector<HashFunc>>(
       std::move(rh),
       createHashSelector<HashFunc>(std::move(salt), std::move(func)));
 }
@@ -68,22 +90,24 @@ typename std::
         std::vector<typename RouterInfo::RouteHandlePtr> rh,
         std::string salt,
         HashFunc func,
-        bool bucketized = false) {
+        bool bucketized = false,
+        size_t numPrecomputedBuckets = 0) {
   if (folly::IsOneOf<HashFunc, WeightedCh3HashFunc>::value) {
     if (bucketized) {
-      return createSelectionRoute<
+      auto size = rh.size();
+      return createPoolSelectionRoute<
           RouterInfo,
           BucketHashSelector<HashFunc, RouterInfo>>(
           std::move(rh),
           createBucketHashSelector<HashFunc, RouterInfo>(
-              std::move(salt), std::move(func)));
+              std::move(salt), std::move(func), numPrecomputedBuckets, size));
     }
   }
   checkLogic(
       !bucketized,
       "Bucketization not implemented for this ch type: {}",
       HashFunc::type());
-  return createSelectionRoute<RouterInfo, HashSelector<HashFunc>>(
+  return createPoolSelectionRoute<RouterInfo, HashSelector<HashFunc>>(
       std::move(rh),
       createHashSelector<HashFunc>(std::move(salt), std::move(func)));
 }
@@ -96,6 +120,8 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
   std::string salt;
   folly::StringPiece funcType = Ch3HashFunc::type();
   auto bucketize = false;
+  // Buckets whose destination is computed at config time.
+  size_t numPrecomputedBuckets = 0;
   if (json.isObject()) {
     if (auto jsalt = json.get_ptr("salt")) {
       checkLogic(jsalt->isString(), "HashRoute: salt is not a string");
@@ -108,6 +134,13 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
     if (auto* jNeedBucketization = json.get_ptr("bucketize")) {
       bucketize = parseBool(*jNeedBucketization, "bucketize");
     }
+    if (auto* jBucketizeUntil = json.get_ptr("bucketize_until")) {
+      numPrecomputedBuckets = parseInt(
+          *jBucketizeUntil,
+          "bucketize_until",
+          0,
+          std::numeric_limits<int64_t>::max());
+    }
   }
 
   auto n = rh.size();
@@ -139,7 +172,11 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> createHashRoute(
   } else if (funcType == WeightedCh3HashFunc::type()) {
     WeightedCh3HashFunc func{json, n};
     return createHashRoute<RouterInfo, WeightedCh3HashFunc>(
-        std::move(rh), std::move(salt), std::move(func), bucketize);
+        std::move(rh),
+        std::move(salt),
+        std::move(func),
+        bucketize,
+        numPrecomputedBuckets);
   } else if (funcType == WeightedCh4HashFunc::type()) {
     WeightedCh4HashFunc func{json, n};
     return createHashRoute<RouterInfo, WeightedCh4HashFunc>(
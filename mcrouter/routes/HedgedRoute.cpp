@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "HedgedRoute.h"
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/routes/NullRoute.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr int64_t kDefaultMinDelayMs = 1;
+constexpr int64_t kDefaultMaxDelayMs = 50;
+
+int64_t parseDelay(
+    const folly::dynamic& json,
+    folly::StringPiece name,
+    int64_t defaultValue) {
+  auto jvalue = json.get_ptr(name);
+  if (!jvalue) {
+    return defaultValue;
+  }
+  checkLogic(
+      jvalue->isInt() && jvalue->getInt() >= 0,
+      "HedgedRoute: {} is not a non-negative integer",
+      name);
+  return jvalue->getInt();
+}
+
+} // namespace
+
+McrouterRouteHandlePtr makeHedgedRoute(
+    RouteHandleFactory<McrouterRouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "HedgedRoute should be object");
+  std::vector<McrouterRouteHandlePtr> children;
+  if (auto jchildren = json.get_ptr("children")) {
+    children = factory.createList(*jchildren);
+  }
+  if (children.empty()) {
+    return createNullRoute<McrouterRouteHandleIf>();
+  }
+  if (children.size() == 1) {
+    return std::move(children[0]);
+  }
+
+  auto minDelayMs = parseDelay(json, "min_delay_ms", kDefaultMinDelayMs);
+  auto maxDelayMs = parseDelay(json, "max_delay_ms", kDefaultMaxDelayMs);
+  checkLogic(
+      minDelayMs <= maxDelayMs,
+      "HedgedRoute: min_delay_ms is larger than max_delay_ms");
+
+  return makeMcrouterRouteHandleWithInfo<HedgedRoute>(
+      std::move(children),
+      std::chrono::milliseconds(minDelayMs),
+      std::chrono::milliseconds(maxDelayMs));
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/Format.h>
+#include <folly/Optional.h>
+#include <folly/fibers/AddTasks.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+
+#include "mcrouter/ExponentialSmoothData.h"
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/stats.h"
+
+namespace folly {
+struct dynamic;
+}
+
+namespace facebook {
+namespace memcache {
+
+template <class RouteHandleIf>
+class RouteHandleFactory;
+
+namespace mcrouter {
+
+/**
+ * Hedged alternative to AllFastestRoute for get-like requests.
+ *
+ * The request is sent to the child with the lowest observed latency first.
+ * If no reply arrives within that child's hedge delay (roughly its p95
+ * latency, clamped to ["min_delay_ms", "max_delay_ms"]), or it replies with
+ * an error, the request is also sent to the next fastest child, and so on.
+ * Returns the first non-error reply, or the last error reply if all children
+ * failed. Requests still in flight complete asynchronously and their replies
+ * are dropped; mcrouter can't cancel a request once it was sent.
+ *
+ * All other requests are sent to all children, exactly like AllFastestRoute,
+ * so that replicas stay in sync.
+ */
+template <class RouterInfo>
+class HedgedRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+ public:
+  std::string routeName() const {
+    return folly::sformat(
+        "hedged|min_delay_ms={}|max_delay_ms={}",
+        minDelay_.count(),
+        maxDelay_.count());
+  }
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(children_, req);
+  }
+
+  HedgedRoute(
+      std::vector<RouteHandlePtr> children,
+      std::chrono::milliseconds minDelay,
+      std::chrono::milliseconds maxDelay)
+      : children_(std::move(children)),
+        minDelay_(minDelay),
+        maxDelay_(maxDelay) {
+    assert(!children_.empty());
+    assert(minDelay_ <= maxDelay_);
+    latencies_.reserve(children_.size());
+    for (size_t i = 0; i < children_.size(); ++i) {
+      latencies_.push_back(std::make_shared<Latency>());
+    }
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::GetLikeT<Request> = 0) const {
+    using Reply = ReplyT<Request>;
+
+    auto order = childrenByLatency();
+    auto state = std::make_shared<HedgeState<Reply>>();
+    auto reqCopy = std::make_shared<const Request>(req);
+    size_t launched = 0;
+    auto launchNext = [&]() {
+      const auto idx = order[launched];
+      folly::fibers::addTask([state,
+                              reqCopy,
+                              position = launched,
+                              rh = children_[idx],
+                              latency = latencies_[idx],
+                              maxDelay = maxDelay_]() {
+        const auto start = std::chrono::steady_clock::now();
+        auto reply = rh->route(*reqCopy);
+        const bool isError = isFailoverErrorResult(*reply.result_ref());
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        // Count errors as slow replies, so that failing children are
+        // ordered last even if they fail fast.
+        if (isError) {
+          elapsed = std::max<decltype(elapsed)>(elapsed, maxDelay);
+        }
+        latency->insertSample(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+                .count());
+        state->complete(std::move(reply), isError, position);
+      });
+      ++launched;
+    };
+
+    launchNext();
+    while (!state->done &&
+           (launched < children_.size() || state->completed < launched)) {
+      folly::fibers::Baton baton;
+      state->waiter = &baton;
+      bool woken = true;
+      if (launched < children_.size()) {
+        woken = baton.try_wait_for(hedgeDelay(order[launched - 1]));
+      } else {
+        baton.wait();
+      }
+      state->waiter = nullptr;
+
+      if (!state->done && launched < children_.size()) {
+        // Woken up early means the last child failed: fail over right away.
+        if (!woken) {
+          bumpStat(hedged_requests_stat);
+        }
+        launchNext();
+      }
+    }
+
+    if (state->done && state->winner > 0) {
+      bumpStat(hedged_requests_won_stat);
+    }
+    return std::move(*state->reply);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::OtherThanT<Request, carbon::GetLike<>> = 0) const {
+    using Reply = ReplyT<Request>;
+
+    std::vector<std::function<Reply()>> funcs;
+    funcs.reserve(children_.size());
+    auto reqCopy = std::make_shared<Request>(req);
+    for (auto& rh : children_) {
+      funcs.push_back([reqCopy, rh]() { return rh->route(*reqCopy); });
+    }
+
+    auto taskIt = folly::fibers::addTasks(funcs.begin(), funcs.end());
+    while (true) {
+      auto reply = taskIt.awaitNext();
+      if (!isFailoverErrorResult(*reply.result_ref()) || !taskIt.hasNext()) {
+        return reply;
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kLatencyWindow = 64;
+
+  struct Latency {
+    // Both in microseconds.
+    ExponentialSmoothData<kLatencyWindow> mean;
+    ExponentialSmoothData<kLatencyWindow> deviation;
+
+    void insertSample(double sample) {
+      if (mean.hasValue()) {
+        deviation.insertSample(std::abs(sample - mean.value()));
+      }
+      mean.insertSample(sample);
+    }
+  };
+
+  template <class Reply>
+  struct HedgeState {
+    folly::Optional<Reply> reply;
+    // Set once a non-error reply was received.
+    bool done{false};
+    // Launch position (0 = first child tried) of the child that replied.
+    size_t winner{0};
+    size_t completed{0};
+    folly::fibers::Baton* waiter{nullptr};
+
+    void complete(Reply&& r, bool isError, size_t position) {
+      ++completed;
+      if (done) {
+        return;
+      }
+      reply = std::move(r);
+      done = !isError;
+      winner = position;
+      if (waiter) {
+        std::exchange(waiter, nullptr)->post();
+      }
+    }
+  };
+
+  const std::vector<RouteHandlePtr> children_;
+  const std::chrono::milliseconds minDelay_;
+  const std::chrono::milliseconds maxDelay_;
+  // shared_ptr, since hedged requests may outlive the route on reconfigure.
+  std::vector<std::shared_ptr<Latency>> latencies_;
+
+  /**
+   * Children that haven't replied yet (no samples) come first, so every
+   * child gets measured.
+   */
+  std::vector<size_t> childrenByLatency() const {
+    std::vector<size_t> order(children_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return latencies_[a]->mean.value() < latencies_[b]->mean.value();
+    });
+    return order;
+  }
+
+  /**
+   * Mean plus twice the mean absolute deviation, which is about the p95 for
+   * normally distributed latencies.
+   */
+  std::chrono::milliseconds hedgeDelay(size_t idx) const {
+    const auto& latency = *latencies_[idx];
+    if (!latency.mean.hasValue()) {
+      return maxDelay_;
+    }
+    const auto delayUs = latency.mean.value() + 2 * latency.deviation.value();
+    const auto delay = std::chrono::milliseconds(
+        static_cast<int64_t>(std::ceil(delayUs / 1000)));
+    return std::min(maxDelay_, std::max(minDelay_, delay));
+  }
+
+  static void bumpStat(stat_name_t stat) {
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      ctx->proxy().stats().increment(stat);
+    }
+  }
+};
+
+McrouterRouteHandlePtr makeHedgedRoute(
+    RouteHandleFactory<McrouterRouteHandleIf>& factory,
+    const folly::dynamic& json);
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
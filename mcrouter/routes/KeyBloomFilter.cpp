@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "mcrouter/routes/KeyBloomFilter.h"
+
+#include <sys/stat.h>
+
+#include <cstring>
+
+#include <folly/Conv.h>
+#include <folly/experimental/FunctionScheduler.h>
+#include <folly/hash/SpookyHashV2.h>
+
+#include "mcrouter/lib/SharedObjectCache.h"
+#include "mcrouter/lib/fbi/cpp/LogFailure.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x6662636d; // "mcbf"
+constexpr uint32_t kMaxHashes = 64;
+
+struct Header {
+  uint32_t magic;
+  uint32_t numHashes;
+  uint64_t numBits;
+};
+static_assert(sizeof(Header) == 16, "Unexpected Bloom filter header size");
+
+struct KeyHashes {
+  uint32_t h1;
+  uint32_t h2;
+};
+
+KeyHashes keyHashes(folly::StringPiece key) {
+  const auto hash =
+      folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+  return {static_cast<uint32_t>(hash), static_cast<uint32_t>(hash >> 32) | 1};
+}
+
+std::string functionName() {
+  static std::atomic<uint64_t> uniqueId(0);
+  return folly::to<std::string>("key-bloom-filter-", uniqueId.fetch_add(1));
+}
+
+} // namespace
+
+KeyBloomFilter::KeyBloomFilter(const std::string& path)
+    : mapping_(path.c_str()) {
+  const auto data = mapping_.range();
+  checkLogic(
+      data.size() >= sizeof(Header), "Bloom filter {} is too short", path);
+  Header header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  checkLogic(header.magic == kMagic, "{} is not a Bloom filter file", path);
+  checkLogic(
+      header.numHashes > 0 && header.numHashes <= kMaxHashes,
+      "Bloom filter {}: invalid number of hashes {}",
+      path,
+      header.numHashes);
+  checkLogic(header.numBits > 0, "Bloom filter {} has no bits", path);
+  checkLogic(
+      (data.size() - sizeof(Header)) * 8 >= header.numBits,
+      "Bloom filter {} is truncated",
+      path);
+  bits_ = data.data() + sizeof(Header);
+  numBits_ = header.numBits;
+  numHashes_ = header.numHashes;
+}
+
+bool KeyBloomFilter::mayContain(folly::StringPiece key) const {
+  const auto hashes = keyHashes(key);
+  uint64_t bit = hashes.h1 % numBits_;
+  const uint64_t step = hashes.h2 % numBits_;
+  for (uint32_t i = 0; i < numHashes_; ++i) {
+    if (!(bits_[bit >> 3] & (1 << (bit & 7)))) {
+      return false;
+    }
+    bit += step;
+    if (bit >= numBits_) {
+      bit -= numBits_;
+    }
+  }
+  return true;
+}
+
+/* static */ std::string KeyBloomFilter::build(
+    const std::vector<std::string>& keys,
+    uint64_t numBits,
+    uint32_t numHashes) {
+  checkLogic(numBits > 0, "Bloom filter needs at least one bit");
+  checkLogic(
+      numHashes > 0 && numHashes <= kMaxHashes,
+      "Bloom filter: invalid number of hashes {}",
+      numHashes);
+  std::string result(sizeof(Header) + (numBits + 7) / 8, '\0');
+  const Header header{kMagic, numHashes, numBits};
+  std::memcpy(&result[0], &header, sizeof(header));
+  auto* bits = reinterpret_cast<uint8_t*>(&result[sizeof(Header)]);
+  for (const auto& key : keys) {
+    const auto hashes = keyHashes(key);
+    for (uint32_t i = 0; i < numHashes; ++i) {
+      const uint64_t bit =
+          (hashes.h1 + static_cast<uint64_t>(i) * hashes.h2) % numBits;
+      bits[bit >> 3] |= 1 << (bit & 7);
+    }
+  }
+  return result;
+}
+
+KeyBloomFilterFile::KeyBloomFilterFile(
+    std::string path,
+    std::chrono::milliseconds reloadInterval,
+    const std::shared_ptr<folly::FunctionScheduler>& scheduler)
+    : path_(std::move(path)),
+      functionName_(functionName()),
+      scheduler_(scheduler) {
+  // The first version is loaded right away, so that a bad file fails the
+  // config instead of silently letting everything through.
+  reloadIfChanged();
+  checkLogic(
+      filter_.copy() != nullptr, "Failed to load Bloom filter {}", path_);
+  if (scheduler) {
+    scheduler->addFunction(
+        [this]() { reloadIfChanged(); },
+        reloadInterval,
+        functionName_,
+        reloadInterval);
+  }
+}
+
+KeyBloomFilterFile::~KeyBloomFilterFile() {
+  if (auto scheduler = scheduler_.lock()) {
+    scheduler->cancelFunctionAndWait(functionName_);
+  }
+}
+
+void KeyBloomFilterFile::reloadIfChanged() {
+  struct stat st;
+  if (::stat(path_.c_str(), &st) != 0) {
+    LOG_FAILURE(
+        "KeyBloomFilter",
+        failure::Category::kBadEnvironment,
+        "Can't stat Bloom filter {}, keeping the loaded one",
+        path_);
+    return;
+  }
+  const int64_t mtimeNs =
+      static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+      st.st_mtim.tv_nsec;
+  if (mtimeNs == loadedMtimeNs_ && st.st_size == loadedSize_) {
+    return;
+  }
+  try {
+    auto filter = std::make_shared<const KeyBloomFilter>(path_);
+    filter_.wlock()->swap(filter);
+    loadedMtimeNs_ = mtimeNs;
+    loadedSize_ = st.st_size;
+    version_.fetch_add(1, std::memory_order_acq_rel);
+  } catch (const std::exception& e) {
+    LOG_FAILURE(
+        "KeyBloomFilter",
+        failure::Category::kInvalidConfig,
+        "Failed to load Bloom filter {}: {}. Keeping the loaded one.",
+        path_,
+        e.what());
+  }
+}
+
+/* static */ std::shared_ptr<const KeyBloomFilterFile>
+KeyBloomFilterFile::getShared(
+    const std::string& path,
+    std::chrono::milliseconds reloadInterval,
+    const std::shared_ptr<folly::FunctionScheduler>& scheduler) {
+  // Leaked on purpose, so that routes may be destroyed at any time.
+  static auto* files = new SharedObjectCache<KeyBloomFilterFile>();
+  return files->getOrCreate(
+      folly::to<std::string>(path, '\0', reloadInterval.count()),
+      [&]() {
+        return std::make_shared<const KeyBloomFilterFile>(
+            path, reloadInterval, scheduler);
+      });
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/system/MemoryMapping.h>
+
+namespace folly {
+class FunctionScheduler;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Read only Bloom filter of keys, memory mapped from a file.
+ *
+ * File format (little endian):
+ *   uint32_t magic       "mcbf" (0x6662636d)
+ *   uint32_t numHashes   number of bits set per key, 1 to 64
+ *   uint64_t numBits     size of the bit array, > 0
+ *   uint8_t  bits[(numBits + 7) / 8]
+ * Bit i is (bits[i / 8] >> (i % 8)) & 1. The bits of a key are
+ *   (h1 + j * h2) % numBits  for j in [0, numHashes)
+ * where h1 and h2 are the low and high 32 bits of
+ * SpookyHashV2::Hash64(key, 0), h2 forced odd. build() produces such files.
+ */
+class KeyBloomFilter {
+ public:
+  /**
+   * @throws std::runtime_error  if the file can't be mapped or is invalid.
+   */
+  explicit KeyBloomFilter(const std::string& path);
+
+  /**
+   * @return  false iff `key` was definitely not added to the filter.
+   */
+  bool mayContain(folly::StringPiece key) const;
+
+  uint64_t numBits() const {
+    return numBits_;
+  }
+
+  /**
+   * @return  The content of a filter file holding `keys`.
+   */
+  static std::string build(
+      const std::vector<std::string>& keys,
+      uint64_t numBits,
+      uint32_t numHashes);
+
+ private:
+  folly::MemoryMapping mapping_;
+  const uint8_t* bits_{nullptr};
+  uint64_t numBits_{0};
+  uint32_t numHashes_{0};
+};
+
+/**
+ * The latest valid version of a Bloom filter file. The file is checked for
+ * changes every `reloadInterval` on the global function scheduler and mapped
+ * again when its modification time or size changed. A file that fails to
+ * load keeps the previous filter in use.
+ *
+ * Shared by every route using the same file, see getShared().
+ */
+class KeyBloomFilterFile {
+ public:
+  KeyBloomFilterFile(
+      std::string path,
+      std::chrono::milliseconds reloadInterval,
+      const std::shared_ptr<folly::FunctionScheduler>& scheduler);
+  ~KeyBloomFilterFile();
+
+  /**
+   * @return  The current filter, nullptr if the file was never loaded.
+   */
+  std::shared_ptr<const KeyBloomFilter> get() const {
+    return filter_.copy();
+  }
+
+  /**
+   * Incremented whenever get() returns a new filter, so that users can keep
+   * their own copy and only pay for get() when it changes.
+   */
+  uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  const std::string& path() const {
+    return path_;
+  }
+
+  static std::shared_ptr<const KeyBloomFilterFile> getShared(
+      const std::string& path,
+      std::chrono::milliseconds reloadInterval,
+      const std::shared_ptr<folly::FunctionScheduler>& scheduler);
+
+ private:
+  const std::string path_;
+  const std::string functionName_;
+  std::weak_ptr<folly::FunctionScheduler> scheduler_;
+
+  folly::Synchronized<std::shared_ptr<const KeyBloomFilter>, folly::SharedMutex>
+      filter_;
+  std::atomic<uint64_t> version_{0};
+  // Identity of the loaded file, only used by the scheduler thread.
+  int64_t loadedMtimeNs_{-1};
+  int64_t loadedSize_{-1};
+
+  void reloadIfChanged();
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
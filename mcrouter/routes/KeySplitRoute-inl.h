@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <string>
 
 #include "mcrouter/lib/IOBufUtil.h"
@@ -40,8 +41,19 @@ typename RouterInfo::RouteHandlePtr makeKeySplitRoute(
         isFirstHit->isBool(), "KeySplitRoute: first_hit is not a boolean");
   }
 
+  bool leastLoaded = false;
+  if (auto jLeastLoaded = json.get_ptr("least_loaded")) {
+    checkLogic(
+        jLeastLoaded->isBool(), "KeySplitRoute: least_loaded is not a boolean");
+    leastLoaded = jLeastLoaded->getBool();
+  }
+
   size_t replicas = json["replicas"].getInt();
   bool all_sync = json["all_sync"].getBool();
+  checkLogic(
+      !leastLoaded || all_sync,
+      "KeySplitRoute: least_loaded requires all_sync, gets may then read any"
+      " replica");
   checkLogic(
       replicas >= KeySplitRoute<RouterInfo>::kMinReplicaCount,
       "KeySplitRoute: there should at least be 2 replicas");
@@ -49,11 +61,53 @@ typename RouterInfo::RouteHandlePtr makeKeySplitRoute(
       replicas <= KeySplitRoute<RouterInfo>::kMaxReplicaCount,
       "KeySplitRoute: there should no more than 1000 replicas");
 
+  folly::Optional<KeySplitAutoOptions> autoSplit;
+  if (auto jAutoSplit = json.get_ptr("auto_split")) {
+    checkLogic(
+        jAutoSplit->isObject(), "KeySplitRoute: auto_split is not an object");
+    checkLogic(
+        all_sync,
+        "KeySplitRoute: auto_split requires all_sync, gets may then read any"
+        " replica");
+    checkLogic(
+        !leastLoaded && !(isFirstHit && isFirstHit->asBool()),
+        "KeySplitRoute: auto_split can't be combined with first_hit or"
+        " least_loaded");
+    KeySplitAutoOptions opts;
+    auto jThreshold = jAutoSplit->get_ptr("threshold");
+    checkLogic(
+        jThreshold && jThreshold->isInt() && jThreshold->getInt() > 0,
+        "KeySplitRoute: auto_split.threshold should be a positive integer");
+    opts.threshold = jThreshold->getInt();
+    if (auto jWindow = jAutoSplit->get_ptr("window_ms")) {
+      checkLogic(
+          jWindow->isInt() && jWindow->getInt() > 0,
+          "KeySplitRoute: auto_split.window_ms should be a positive integer");
+      opts.window = std::chrono::milliseconds(jWindow->getInt());
+    }
+    if (auto jCapacity = jAutoSplit->get_ptr("capacity")) {
+      checkLogic(
+          jCapacity->isInt() && jCapacity->getInt() > 0,
+          "KeySplitRoute: auto_split.capacity should be a positive integer");
+      opts.capacity = jCapacity->getInt();
+    }
+    if (auto jTtl = jAutoSplit->get_ptr("replica_ttl_s")) {
+      checkLogic(
+          jTtl->isInt() && jTtl->getInt() > 0,
+          "KeySplitRoute: auto_split.replica_ttl_s should be a positive"
+          " integer");
+      opts.replicaTtlSec = jTtl->getInt();
+    }
+    autoSplit = std::move(opts);
+  }
+
   return makeRouteHandleWithInfo<RouterInfo, KeySplitRoute>(
       factory.create(json["destination"]),
       replicas,
       all_sync,
-      isFirstHit ? isFirstHit->asBool() : false);
+      isFirstHit ? isFirstHit->asBool() : false,
+      leastLoaded,
+      std::move(autoSplit));
 }
 
 } // namespace mcrouter
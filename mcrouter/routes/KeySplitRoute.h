@@ -7,14 +7,28 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #include <folly/Optional.h>
+#include <folly/Random.h>
+#include <folly/ScopeGuard.h>
+#include <folly/container/F14Set.h>
 #include <folly/fibers/AddTasks.h>
 #include <folly/fibers/FiberManager.h>
 
+#include "mcrouter/HotKeySketch.h"
+#include "mcrouter/config.h"
 #include "mcrouter/lib/McKey.h"
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/fbi/cpp/FuncGenerator.h"
 #include "mcrouter/lib/fbi/cpp/globals.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
@@ -27,6 +41,24 @@ class RouteHandleFactory;
 
 namespace mcrouter {
 
+/**
+ * Automatic mode of KeySplitRoute: only keys that are currently hot are
+ * split.
+ */
+struct KeySplitAutoOptions {
+  // A key becomes hot once requested at least this many times (through this
+  // proxy) during a window, and cools down once requested less than half as
+  // many times.
+  uint64_t threshold{0};
+  std::chrono::milliseconds window{1000};
+  // Number of keys tracked per window, see HotKeySketch.
+  size_t capacity{128};
+  // Max ttl of the replica copies of a hot key, in seconds. Other proxies may
+  // not see the key as hot and only update or delete the original key, so
+  // this bounds how long a replica copy can be stale.
+  uint32_t replicaTtlSec{10};
+};
+
 /**
  * This route handle will allow a particular key to live on more than one
  * host in a destination pool. This is to primarily mitigate hot keys
@@ -40,6 +72,18 @@ namespace mcrouter {
  * @param   allSync   Sync sets and deletes amongst all children
  * @param   firstHit  returns the result of the first hit. NOTE: This should NOT
  *                    be used for hot key routing
+ * @param   leastLoaded  gets go to the replica of this host or to another
+ *                    random one, whichever has less requests in flight from
+ *                    this proxy. Requires allSync, since gets may then read
+ *                    any replica.
+ * @param   autoSplit  if set, keys are only split while they are hot (see
+ *                    KeySplitAutoOptions), everything else goes to the
+ *                    original key. Gets of a hot key go to a random replica,
+ *                    falling back to the original key (and filling the
+ *                    replica) on a miss. Sets and deletes go to all replicas,
+ *                    other updates to the original key and invalidate the
+ *                    replicas. A key that cools down has its replicas
+ *                    deleted.
  */
 template <class RouterInfo>
 class KeySplitRoute {
@@ -52,18 +96,52 @@ class KeySplitRoute {
       RouteHandlePtr child,
       size_t replicas,
       bool allSync,
-      bool firstHit = false)
+      bool firstHit = false,
+      bool leastLoaded = false,
+      folly::Optional<KeySplitAutoOptions> autoSplit = folly::none)
       : child_(std::move(child)),
         replicas_(replicas),
         allSync_(allSync),
-        firstHit_(firstHit) {
+        firstHit_(firstHit),
+        leastLoaded_(leastLoaded) {
     assert(child_ != nullptr);
     assert(replicas_ >= kMinReplicaCount);
     assert(replicas_ <= kMaxReplicaCount);
+    assert(!leastLoaded_ || allSync_);
+    replicaSuffixes_.reserve(replicas_);
+    for (size_t id = 0; id < replicas_; ++id) {
+      replicaSuffixes_.push_back(
+          folly::to<std::string>(kMemcacheReplicaSeparator, id));
+    }
+    if (leastLoaded_) {
+      outstanding_.resize(replicas_, 0);
+    }
+    if (autoSplit) {
+      autoSplit_ = std::make_unique<AutoSplitState>(std::move(*autoSplit));
+    }
   }
 
   std::string routeName() const {
     uint64_t replicaId = getReplicaId();
+    if (autoSplit_) {
+      return folly::sformat(
+          "keysplit|replicas={}|all-sync={}|first-hit={}|replicaId={}"
+          "|auto-split-threshold={}",
+          replicas_,
+          allSync_,
+          firstHit_,
+          replicaId,
+          autoSplit_->opts.threshold);
+    }
+    if (leastLoaded_) {
+      return folly::sformat(
+          "keysplit|replicas={}|all-sync={}|first-hit={}|replicaId={}"
+          "|least-loaded=true",
+          replicas_,
+          allSync_,
+          firstHit_,
+          replicaId);
+    }
     return folly::sformat(
         "keysplit|replicas={}|all-sync={}|first-hit={}|replicaId={}",
         replicas_,
@@ -80,7 +158,7 @@ class KeySplitRoute {
       const Request& req,
       const RouteHandleTraverser<RouteHandleIf>& t) const {
     uint64_t replicaId = getReplicaId();
-    if (shouldAugmentRequest(replicaId)) {
+    if (!autoSplit_ && shouldAugmentRequest(replicaId)) {
       return t(*child_, copyAndAugment(req, replicaId));
     }
     return t(*child_, req);
@@ -95,6 +173,9 @@ class KeySplitRoute {
               value,
       ReplyT<Request>>::type
   route(const Request& req) const {
+    if (autoSplit_) {
+      return routeAutoSplit(req);
+    }
     if (!canAugmentRequest(req)) {
       return child_->route(req);
     }
@@ -102,6 +183,9 @@ class KeySplitRoute {
     if (firstHit_) {
       return routeAllFastest(req);
     }
+    if (leastLoaded_ && std::is_same<Request, McGetRequest>::value) {
+      return routeLeastLoaded(req);
+    }
     // always retrieve from 1 replica
     uint64_t replicaId = getReplicaId();
     return routeOne(req, replicaId);
@@ -113,6 +197,9 @@ class KeySplitRoute {
       folly::IsOneOf<Request, McSetRequest>::value,
       ReplyT<Request>>::type
   route(const Request& req) const {
+    if (autoSplit_) {
+      return routeAutoSplit(req);
+    }
     if (!canAugmentRequest(req)) {
       return child_->route(req);
     }
@@ -132,6 +219,9 @@ class KeySplitRoute {
       folly::IsOneOf<Request, McDeleteRequest>::value,
       ReplyT<Request>>::type
   route(const Request& req) const {
+    if (autoSplit_) {
+      return routeAutoSplit(req);
+    }
     if (!canAugmentRequest(req)) {
       return child_->route(req);
     }
@@ -153,6 +243,9 @@ class KeySplitRoute {
           McDeleteRequest>::value,
       ReplyT<Request>>::type
   route(const Request& req) const {
+    if (autoSplit_) {
+      return routeAutoSplit(req);
+    }
     uint64_t replicaId = getReplicaId();
     return routeOne(req, replicaId);
   }
@@ -169,6 +262,25 @@ class KeySplitRoute {
   const size_t replicas_{2};
   const bool allSync_{false};
   const bool firstHit_{false};
+  const bool leastLoaded_{false};
+  // "::<replica id>" for every replica, so that keys are built with a copy.
+  std::vector<std::string> replicaSuffixes_;
+  // Requests in flight to each replica, only if leastLoaded_.
+  mutable std::vector<uint32_t> outstanding_;
+
+  struct AutoSplitState {
+    explicit AutoSplitState(KeySplitAutoOptions opts_)
+        : opts(std::move(opts_)), sketch(opts.capacity) {}
+
+    const KeySplitAutoOptions opts;
+    // Keys requested during the current window.
+    HotKeySketch sketch;
+    // Keys found hot at the end of the previous window.
+    folly::F14FastSet<std::string> hotKeys;
+    int64_t windowEndUs{0};
+  };
+  // Only in automatic mode. Route handles are per proxy, so no locking.
+  std::unique_ptr<AutoSplitState> autoSplit_;
 
   template <class Request>
   bool canAugmentRequest(const Request& req) const {
@@ -185,11 +297,147 @@ class KeySplitRoute {
   template <class Request>
   Request copyAndAugment(Request& originalReq, uint64_t replicaId) const {
     auto req = originalReq;
-    req.key_ref() = folly::to<std::string>(
-        req.key_ref()->fullKey(), kMemcacheReplicaSeparator, replicaId);
+    auto key = originalReq.key_ref()->fullKey();
+    folly::StringPiece suffix = replicaSuffixes_[replicaId];
+    // Build the key on the stack, the key storage is the only allocation.
+    char buf[kMaxMcKeyLength + kExtraKeySpaceNeeded];
+    if (key.size() + suffix.size() <= sizeof(buf)) {
+      std::memcpy(buf, key.data(), key.size());
+      std::memcpy(buf + key.size(), suffix.data(), suffix.size());
+      req.key_ref() = folly::StringPiece(buf, key.size() + suffix.size());
+    } else {
+      req.key_ref() = folly::to<std::string>(key, suffix);
+    }
     return req;
   }
 
+  /**
+   * Records the key and tells if it's currently hot, starting a new window
+   * first if the current one is over.
+   */
+  bool recordAndCheckHot(folly::StringPiece key) const {
+    auto& state = *autoSplit_;
+    const auto now = nowUs();
+    if (now >= state.windowEndUs) {
+      startWindow(now);
+    }
+    state.sketch.record(key);
+    return state.hotKeys.count(key) != 0;
+  }
+
+  void startWindow(int64_t now) const {
+    auto& state = *autoSplit_;
+    const uint64_t coolThreshold =
+        std::max<uint64_t>(state.opts.threshold / 2, 1);
+    folly::F14FastSet<std::string> hotKeys;
+    for (auto& item : state.sketch.snapshot()) {
+      const auto count = item.count - item.error;
+      if (count >= state.opts.threshold ||
+          (count >= coolThreshold && state.hotKeys.count(item.key))) {
+        hotKeys.insert(std::move(item.key));
+      }
+    }
+    for (const auto& key : state.hotKeys) {
+      if (!hotKeys.count(key)) {
+        deleteReplicas(key);
+      }
+    }
+    state.hotKeys = std::move(hotKeys);
+    state.sketch.clear();
+    state.windowEndUs = now +
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            state.opts.window)
+            .count();
+  }
+
+  template <class Request>
+  ReplyT<Request> routeAutoSplit(const Request& req) const {
+    if (!canAugmentRequest(req) ||
+        !recordAndCheckHot(req.key_ref()->fullKey())) {
+      return child_->route(req);
+    }
+
+    if constexpr (std::is_same<Request, McGetRequest>::value) {
+      return routeHotGet(req);
+    } else if constexpr (std::is_same<Request, McSetRequest>::value) {
+      // Copies must not outlive the hot period by much, see replicaTtlSec.
+      const auto ttl = static_cast<int32_t>(autoSplit_->opts.replicaTtlSec);
+      for (size_t id = 1; id < replicas_; ++id) {
+        auto reqCopy = copyAndAugment(req, id);
+        if (*reqCopy.exptime_ref() == 0 || *reqCopy.exptime_ref() > ttl) {
+          reqCopy.exptime_ref() = ttl;
+        }
+        folly::fibers::addTask(
+            [child = child_, reqReplica = std::move(reqCopy)]() {
+              return child->route(reqReplica);
+            });
+      }
+      return child_->route(req);
+    } else if constexpr (std::is_same<Request, McDeleteRequest>::value) {
+      return routeAll(req, /* replicaId */ 0);
+    } else if constexpr (carbon::GetLike<Request>::value) {
+      return child_->route(req);
+    } else {
+      // Other updates aren't replayed on the replicas, drop the copies.
+      deleteReplicas(req.key_ref()->fullKey());
+      return child_->route(req);
+    }
+  }
+
+  ReplyT<McGetRequest> routeHotGet(const McGetRequest& req) const {
+    const uint64_t replicaId = folly::Random::rand32(replicas_);
+    if (replicaId == 0) {
+      return child_->route(req);
+    }
+    auto replicaReq = copyAndAugment(req, replicaId);
+    auto reply = child_->route(replicaReq);
+    if (!isMissResult(*reply.result_ref())) {
+      return reply;
+    }
+
+    // The replica wasn't filled yet (or expired), read the original key and
+    // fill the replica with it.
+    reply = child_->route(req);
+    if (isHitResult(*reply.result_ref())) {
+      McSetRequest fill(replicaReq.key_ref()->fullKey());
+      fill.value_ref() = *reply.value_ref();
+      fill.flags_ref() = *reply.flags_ref();
+      fill.exptime_ref() =
+          static_cast<int32_t>(autoSplit_->opts.replicaTtlSec);
+      folly::fibers::addTask([child = child_, fill = std::move(fill)]() {
+        return child->route(fill);
+      });
+    }
+    return reply;
+  }
+
+  void deleteReplicas(folly::StringPiece key) const {
+    const McDeleteRequest original(key);
+    for (size_t id = 1; id < replicas_; ++id) {
+      auto req = copyAndAugment(original, id);
+      folly::fibers::addTask([child = child_, req = std::move(req)]() {
+        return child->route(req);
+      });
+    }
+  }
+
+  template <class Request>
+  ReplyT<Request> routeLeastLoaded(const Request& req) const {
+    // Power of two choices: compare the replica of this host with a random
+    // other one, prefer the former on ties to keep some locality.
+    uint64_t replicaId = getReplicaId();
+    uint64_t other = (replicaId + 1 + folly::Random::rand32(replicas_ - 1)) %
+        replicas_;
+    if (outstanding_[other] < outstanding_[replicaId]) {
+      replicaId = other;
+    }
+    ++outstanding_[replicaId];
+    SCOPE_EXIT {
+      --outstanding_[replicaId];
+    };
+    return routeOne(req, replicaId);
+  }
+
   template <class Request>
   ReplyT<Request> routeOne(const Request& req, uint64_t replicaId) const {
     if (shouldAugmentRequest(replicaId)) {
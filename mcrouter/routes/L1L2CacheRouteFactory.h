@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <memory>
+
 #include <folly/dynamic.h>
 
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
@@ -26,13 +30,36 @@ typename RouterInfo::RouteHandlePtr makeL1L2CacheRoute(
     typename RouterInfo::RouteHandlePtr l2,
     uint32_t upgradingL1Exptime,
     size_t ncacheExptime,
-    size_t ncacheUpdatePeriod) {
+    size_t ncacheUpdatePeriod,
+    std::unique_ptr<AdmissionFilter> upgradeFilter = nullptr,
+    size_t upgradeQueueSize = 0,
+    size_t upgradeSenders = 0) {
   return makeRouteHandle<typename RouterInfo::RouteHandleIf, L1L2CacheRoute>(
       std::move(l1),
       std::move(l2),
       upgradingL1Exptime,
       ncacheExptime,
-      ncacheUpdatePeriod);
+      ncacheUpdatePeriod,
+      std::move(upgradeFilter),
+      upgradeQueueSize,
+      upgradeSenders,
+      [](L1UpgradeResult result) {
+        auto& ctx = fiber_local<RouterInfo>::getSharedCtx();
+        if (!ctx) {
+          return;
+        }
+        switch (result) {
+          case L1UpgradeResult::Upgraded:
+            ctx->proxy().stats().increment(l1_upgrades_stat);
+            break;
+          case L1UpgradeResult::Filtered:
+            ctx->proxy().stats().increment(l1_upgrades_filtered_stat);
+            break;
+          case L1UpgradeResult::Dropped:
+            ctx->proxy().stats().increment(l1_upgrades_dropped_stat);
+            break;
+        }
+      });
 }
 
 } // namespace detail
@@ -68,12 +95,51 @@ typename RouterInfo::RouteHandlePtr makeL1L2CacheRoute(
     ncacheUpdatePeriod = json["ncacheUpdatePeriod"].getInt();
   }
 
+  std::unique_ptr<AdmissionFilter> upgradeFilter;
+  if (auto jminHits = json.get_ptr("upgradeMinHits")) {
+    checkLogic(
+        jminHits->isInt() && jminHits->getInt() > 0 &&
+            jminHits->getInt() <= AdmissionFilter::kMaxCount,
+        "L1L2CacheRoute: upgradeMinHits is not an integer in [1, {}]",
+        static_cast<int>(AdmissionFilter::kMaxCount));
+    size_t filterCapacity = 100000;
+    if (auto jcapacity = json.get_ptr("upgradeFilterCapacity")) {
+      checkLogic(
+          jcapacity->isInt() && jcapacity->getInt() > 0,
+          "L1L2CacheRoute: upgradeFilterCapacity is not a positive integer");
+      filterCapacity = jcapacity->getInt();
+    }
+    if (jminHits->getInt() > 1) {
+      upgradeFilter = std::make_unique<AdmissionFilter>(
+          filterCapacity, jminHits->getInt());
+    }
+  }
+
+  size_t upgradeQueueSize = 0;
+  if (auto jqueueSize = json.get_ptr("upgradeQueueSize")) {
+    checkLogic(
+        jqueueSize->isInt() && jqueueSize->getInt() >= 0,
+        "L1L2CacheRoute: upgradeQueueSize is not a non-negative integer");
+    upgradeQueueSize = jqueueSize->getInt();
+  }
+
+  size_t upgradeSenders = 8;
+  if (auto jsenders = json.get_ptr("upgradeSenders")) {
+    checkLogic(
+        jsenders->isInt() && jsenders->getInt() > 0,
+        "L1L2CacheRoute: upgradeSenders is not a positive integer");
+    upgradeSenders = jsenders->getInt();
+  }
+
   return detail::makeL1L2CacheRoute<RouterInfo>(
       factory.create(json["l1"]),
       factory.create(json["l2"]),
       upgradingL1Exptime,
       ncacheExptime,
-      ncacheUpdatePeriod);
+      ncacheUpdatePeriod,
+      std::move(upgradeFilter),
+      upgradeQueueSize,
+      upgradeSenders);
 }
 } // namespace mcrouter
 } // namespace memcache
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "mcrouter/routes/LatencyInjectionProfile.h"
+
+#include <folly/Format.h>
+
+#include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/RuntimeVarsData.h"
+#include "mcrouter/lib/fbi/cpp/LogFailure.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+double positiveNumber(const folly::dynamic& json, folly::StringPiece name) {
+  auto jValue = json.get_ptr(name);
+  checkLogic(
+      jValue != nullptr && jValue->isNumber() && jValue->asDouble() > 0,
+      "latency_distribution: {} is not a positive number",
+      name);
+  return jValue->asDouble();
+}
+
+double fraction(const folly::dynamic& value, folly::StringPiece name) {
+  checkLogic(
+      value.isNumber() && value.asDouble() >= 0 && value.asDouble() <= 1,
+      "{} is not a number between 0 and 1",
+      name);
+  return value.asDouble();
+}
+
+} // namespace
+
+/* static */ LatencyDistribution LatencyDistribution::fromJson(
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "latency_distribution is not an object");
+  auto jType = json.get_ptr("type");
+  checkLogic(
+      jType != nullptr && jType->isString(),
+      "latency_distribution: type is not a string");
+
+  LatencyDistribution result;
+  if (jType->getString() == "lognormal") {
+    result.type_ = Type::Lognormal;
+    result.logMedianUs_ = std::log(positiveNumber(json, "median_ms") * 1000);
+    result.param_ = positiveNumber(json, "sigma");
+  } else if (jType->getString() == "pareto") {
+    result.type_ = Type::Pareto;
+    result.scaleUs_ = positiveNumber(json, "scale_ms") * 1000;
+    result.param_ = positiveNumber(json, "shape");
+  } else {
+    throwLogic(
+        "latency_distribution: unknown type {}, expected lognormal or pareto",
+        jType->getString());
+  }
+  result.maxUs_ = 10000 * 1000;
+  if (json.get_ptr("max_ms")) {
+    result.maxUs_ = positiveNumber(json, "max_ms") * 1000;
+  }
+  return result;
+}
+
+std::string LatencyDistribution::toString() const {
+  if (type_ == Type::Lognormal) {
+    return folly::sformat(
+        "lognormal:{}ms:{}", std::exp(logMedianUs_) / 1000, param_);
+  }
+  return folly::sformat("pareto:{}ms:{}", scaleUs_ / 1000, param_);
+}
+
+/* static */ LatencyInjectionProfile LatencyInjectionProfile::fromJson(
+    const folly::dynamic& json,
+    const LatencyInjectionProfile& base) {
+  checkLogic(json.isObject(), "latency injection profile is not an object");
+  auto result = base;
+  if (auto jDistribution = json.get_ptr("latency_distribution")) {
+    result.distribution = LatencyDistribution::fromJson(*jDistribution);
+  }
+  if (auto jScale = json.get_ptr("latency_scale")) {
+    checkLogic(
+        jScale->isNumber() && jScale->asDouble() >= 0,
+        "latency_scale is not a non-negative number");
+    result.latencyScale = jScale->asDouble();
+  }
+  if (auto jSpread = json.get_ptr("destination_spread")) {
+    checkLogic(
+        jSpread->isNumber() && jSpread->asDouble() >= 0,
+        "destination_spread is not a non-negative number");
+    result.destinationSpread = jSpread->asDouble();
+  }
+  if (auto jErrorRate = json.get_ptr("error_rate")) {
+    result.errorRate = fraction(*jErrorRate, "error_rate");
+  }
+  if (auto jErrorResult = json.get_ptr("error_result")) {
+    checkLogic(jErrorResult->isString(), "error_result is not a string");
+    result.errorResult =
+        carbon::resultFromString(jErrorResult->getString().c_str());
+    checkLogic(
+        result.errorResult != carbon::Result::UNKNOWN,
+        "error_result: unknown result {}",
+        jErrorResult->getString());
+  }
+  return result;
+}
+
+LatencyInjectionProfileSource::LatencyInjectionProfileSource(
+    LatencyInjectionProfile base,
+    std::string runtimeVarsKey,
+    CarbonRouterInstanceBase* router)
+    : base_(std::make_shared<const LatencyInjectionProfile>(std::move(base))),
+      runtimeVarsKey_(std::move(runtimeVarsKey)),
+      profile_(base_) {
+  if (!runtimeVarsKey_.empty()) {
+    checkLogic(
+        router != nullptr,
+        "runtime_vars_key {}: runtime vars are not available",
+        runtimeVarsKey_);
+    handle_ = router->rtVarsData().subscribeAndCall(
+        [this](
+            std::shared_ptr<const RuntimeVarsData> /* oldVars */,
+            std::shared_ptr<const RuntimeVarsData> newVars) {
+          onRuntimeVars(newVars);
+        });
+  }
+}
+
+LatencyInjectionProfileSource::~LatencyInjectionProfileSource() {
+  // Unsubscribe before the rest of the members are destroyed.
+  handle_.reset();
+}
+
+void LatencyInjectionProfileSource::onRuntimeVars(
+    const std::shared_ptr<const RuntimeVarsData>& vars) {
+  if (!vars) {
+    return;
+  }
+  auto profile = base_;
+  auto val = vars->getVariableByName(runtimeVarsKey_);
+  if (val != nullptr) {
+    try {
+      profile = std::make_shared<const LatencyInjectionProfile>(
+          LatencyInjectionProfile::fromJson(val, *base_));
+    } catch (const std::exception& e) {
+      LOG_FAILURE(
+          "LatencyInjectionRoute",
+          failure::Category::kInvalidConfig,
+          "runtime vars: invalid {}: {}. Keeping the current profile.",
+          runtimeVarsKey_,
+          e.what());
+      return;
+    }
+  }
+  profile_.wlock()->swap(profile);
+  version_.fetch_add(1, std::memory_order_acq_rel);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
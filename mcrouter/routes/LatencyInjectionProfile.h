@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/dynamic.h>
+
+#include "mcrouter/Observable.h"
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+class CarbonRouterInstanceBase;
+class RuntimeVarsData;
+using ObservableRuntimeVars =
+    Observable<std::shared_ptr<const RuntimeVarsData>>;
+
+/**
+ * Random latency, either
+ *   {"type": "lognormal", "median_ms": M, "sigma": S}
+ * or a Pareto tail
+ *   {"type": "pareto", "scale_ms": M, "shape": A}
+ * (every sample is at least M, and heavier tailed the smaller A is).
+ * Samples are capped at "max_ms" (default 10000).
+ */
+class LatencyDistribution {
+ public:
+  static LatencyDistribution fromJson(const folly::dynamic& json);
+
+  template <class RNG>
+  std::chrono::microseconds sample(RNG& rng, double scale) const {
+    double us;
+    if (type_ == Type::Lognormal) {
+      us = std::lognormal_distribution<double>(logMedianUs_, param_)(rng);
+    } else {
+      // Inverse CDF, with u in (0, 1].
+      const double u =
+          1.0 - std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+      us = scaleUs_ / std::pow(u, 1.0 / param_);
+    }
+    us *= scale;
+    return std::chrono::microseconds(
+        static_cast<int64_t>(us < maxUs_ ? us : maxUs_));
+  }
+
+  std::string toString() const;
+
+ private:
+  enum class Type { Lognormal, Pareto };
+
+  Type type_{Type::Lognormal};
+  double logMedianUs_{0};
+  double scaleUs_{0};
+  // sigma for lognormal, shape for Pareto.
+  double param_{1};
+  double maxUs_{0};
+};
+
+/**
+ * What LatencyInjectionRoute injects on top of its fixed latencies:
+ *   "latency_distribution"  LatencyDistribution, before the request is sent
+ *   "latency_scale"         multiplier of the samples (default 1)
+ *   "destination_spread"    sigma of a lognormal multiplier fixed for every
+ *                           child (default 0), so that routes around
+ *                           different destinations aren't equally slow
+ *   "error_rate"            fraction of requests answered with
+ *                           "error_result" (default "mc_res_timeout") instead
+ *                           of being sent
+ */
+struct LatencyInjectionProfile {
+  std::optional<LatencyDistribution> distribution;
+  double latencyScale{1.0};
+  double destinationSpread{0.0};
+  double errorRate{0.0};
+  carbon::Result errorResult{carbon::Result::TIMEOUT};
+
+  /**
+   * Fields missing from `json` keep their value in `base`.
+   *
+   * @throws std::logic_error  on an invalid field.
+   */
+  static LatencyInjectionProfile fromJson(
+      const folly::dynamic& json,
+      const LatencyInjectionProfile& base);
+
+  bool empty() const {
+    return !distribution && errorRate <= 0;
+  }
+
+  double destinationMultiplier(double destinationSample) const {
+    return destinationSpread > 0
+        ? std::exp(destinationSample * destinationSpread)
+        : 1.0;
+  }
+};
+
+/**
+ * The profile currently in effect for a route. If "runtime_vars_key" is
+ * set, the runtime variable of that name is an object with any of the
+ * LatencyInjectionProfile fields, overriding the ones of the config while
+ * it exists. Invalid values are logged and ignored.
+ */
+class LatencyInjectionProfileSource {
+ public:
+  /**
+   * @param router  May be null if runtimeVarsKey is empty.
+   */
+  LatencyInjectionProfileSource(
+      LatencyInjectionProfile base,
+      std::string runtimeVarsKey,
+      CarbonRouterInstanceBase* router);
+  ~LatencyInjectionProfileSource();
+
+  std::shared_ptr<const LatencyInjectionProfile> get() const {
+    return profile_.copy();
+  }
+
+  /**
+   * Incremented whenever get() returns a new profile.
+   */
+  uint64_t version() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  const std::string& runtimeVarsKey() const {
+    return runtimeVarsKey_;
+  }
+
+ private:
+  const std::shared_ptr<const LatencyInjectionProfile> base_;
+  const std::string runtimeVarsKey_;
+  folly::Synchronized<
+      std::shared_ptr<const LatencyInjectionProfile>,
+      folly::SharedMutex>
+      profile_;
+  std::atomic<uint64_t> version_{1};
+  ObservableRuntimeVars::CallbackHandle handle_;
+
+  void onRuntimeVars(const std::shared_ptr<const RuntimeVarsData>& vars);
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -9,15 +9,21 @@
 
 #include <cassert>
 #include <chrono>
+#include <memory>
+#include <random>
 
 #include <folly/Format.h>
+#include <folly/Random.h>
 #include <folly/fibers/Baton.h>
+#include <folly/hash/SpookyHashV2.h>
 
 #include <folly/experimental/ReadMostlySharedPtr.h>
 
 #include "mcrouter/config.h"
+#include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/routes/LatencyInjectionProfile.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
 #include "mcrouter/stats.h"
 
@@ -44,11 +50,16 @@ class HasAfterLatencyUsTrait<
         decltype(std::declval<std::decay_t<Message>&>().afterLatencyUs_ref())>>
     : public std::true_type {};
 
+class CarbonRouterInstanceBase;
+
 namespace detail {
 folly::ReadMostlySharedPtr<folly::Timekeeper> getTimekeeperHighResSingleton();
 }
 /**
  * Injects latency before and/or after sending the request down to it's child.
+ *
+ * With a LatencyInjectionProfile, also injects random latency and errors
+ * (see LatencyInjectionProfile.h), optionally driven by runtime vars.
  */
 template <class RouterInfo>
 class LatencyInjectionRoute {
@@ -69,6 +80,7 @@ class LatencyInjectionRoute {
    * request using values from the request payload
    * @param maxRequestLatency  if not 0, the max amount of "requestLatency"
    * that is allowed to inject before or after sending the request
+   * @param profile         Random latency and errors to inject, may be null
    */
   LatencyInjectionRoute(
       RouteHandlePtr rh,
@@ -76,21 +88,24 @@ class LatencyInjectionRoute {
       std::chrono::milliseconds afterLatency,
       std::chrono::milliseconds totalLatency,
       bool requestLatency,
-      std::chrono::microseconds maxRequestLatency)
+      std::chrono::microseconds maxRequestLatency,
+      std::shared_ptr<const LatencyInjectionProfileSource> profile = nullptr)
       : rh_(std::move(rh)),
         beforeLatency_(beforeLatency),
         afterLatency_(afterLatency),
         totalLatency_(totalLatency),
         requestLatency_(requestLatency),
-        maxRequestLatency_(maxRequestLatency) {
+        maxRequestLatency_(maxRequestLatency),
+        profileSource_(std::move(profile)),
+        destinationSample_(destinationSample(*rh_)) {
     assert(rh_);
     assert(
         beforeLatency_.count() > 0 || afterLatency_.count() > 0 ||
-        totalLatency_.count() > 0 || requestLatency_);
+        totalLatency_.count() > 0 || requestLatency_ || profileSource_);
   }
 
   std::string routeName() const {
-    return folly::sformat(
+    auto name = folly::sformat(
         "latency-injection|before:{}ms|after:{}ms|total:{}ms|"
         "request_payload:{}|max_request_latency_us:{}",
         beforeLatency_.count(),
@@ -98,6 +113,17 @@ class LatencyInjectionRoute {
         totalLatency_.count(),
         requestLatency_ ? "true" : "false",
         maxRequestLatency_.count());
+    if (profileSource_) {
+      const auto profile = profileSource_->get();
+      name += folly::sformat(
+          "|distribution:{}|error_rate:{}",
+          profile->distribution ? profile->distribution->toString() : "none",
+          profile->errorRate);
+      if (!profileSource_->runtimeVarsKey().empty()) {
+        name += "|runtime_vars_key:" + profileSource_->runtimeVarsKey();
+      }
+    }
+    return name;
   }
 
   template <class Request>
@@ -132,6 +158,30 @@ class LatencyInjectionRoute {
       beforeBaton.try_wait_for(beforeLatency_);
     }
 
+    if (profileSource_) {
+      const auto& profile = this->profile();
+      auto& rng = proxy.randomGenerator();
+      if (profile.distribution) {
+        const auto latency = profile.distribution->sample(
+            rng,
+            profile.latencyScale *
+                profile.destinationMultiplier(destinationSample_));
+        if (latency.count() > 0) {
+          proxy.stats().increment(
+              mcrouter::distribution_latency_injected_stat);
+          folly::futures::sleep(
+              latency, detail::getTimekeeperHighResSingleton().get())
+              .get();
+        }
+      }
+      if (profile.errorRate > 0 &&
+          folly::Random::randDouble01(rng) < profile.errorRate) {
+        proxy.stats().increment(mcrouter::error_injected_stat);
+        return createReply<Request>(
+            ErrorReply, profile.errorResult, "injected error");
+      }
+    }
+
     std::chrono::microseconds beforeReqLatency{0};
     std::chrono::microseconds afterReqLatency{0};
     std::optional<Request> newReq;
@@ -205,6 +255,29 @@ class LatencyInjectionRoute {
   const std::chrono::milliseconds totalLatency_;
   bool requestLatency_;
   const std::chrono::microseconds maxRequestLatency_;
+  const std::shared_ptr<const LatencyInjectionProfileSource> profileSource_;
+  // Standard normal sample fixed for the child, see destination_spread.
+  const double destinationSample_;
+  // Every proxy has its own copy of the route, so these are only used from
+  // one thread.
+  mutable std::shared_ptr<const LatencyInjectionProfile> profile_;
+  mutable uint64_t profileVersion_{0};
+
+  const LatencyInjectionProfile& profile() const {
+    const auto version = profileSource_->version();
+    if (FOLLY_UNLIKELY(version != profileVersion_)) {
+      profile_ = profileSource_->get();
+      profileVersion_ = version;
+    }
+    return *profile_;
+  }
+
+  static double destinationSample(const RouteHandleIf& rh) {
+    const auto name = rh.routeName();
+    std::mt19937_64 gen(
+        folly::hash::SpookyHashV2::Hash64(name.data(), name.size(), 0));
+    return std::normal_distribution<double>(0.0, 1.0)(gen);
+  }
 };
 
 /**
@@ -217,11 +290,24 @@ class LatencyInjectionRoute {
  *   "before_latency_ms": 10,
  *   "after_latency_ms": 20
  * }
+ *
+ * Random latency and errors (see LatencyInjectionProfile):
+ * {
+ *   "type": "LatencyInjectionRoute",
+ *   "child": "PoolRoute|pool_name",
+ *   "latency_distribution": {"type": "pareto", "scale_ms": 1, "shape": 2},
+ *   "destination_spread": 0.5,
+ *   "error_rate": 0.001,
+ *   "runtime_vars_key": "pool_name_latency_injection"
+ * }
+ *
+ * @param router  Needed for "runtime_vars_key", may be null otherwise.
  */
 template <class RouterInfo>
-typename RouterInfo::RouteHandlePtr makeLatencyInjectionRoute(
+typename RouterInfo::RouteHandlePtr createLatencyInjectionRoute(
     RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
-    const folly::dynamic& json) {
+    const folly::dynamic& json,
+    CarbonRouterInstanceBase* router) {
   checkLogic(json.isObject(), "LoadBalancerRoute: config is not an object.");
 
   auto jChild = json.get_ptr("child");
@@ -233,11 +319,17 @@ typename RouterInfo::RouteHandlePtr makeLatencyInjectionRoute(
   auto jAfterLatency = json.get_ptr("after_latency_ms");
   auto jTotalLatency = json.get_ptr("total_latency_ms");
   auto jRequestLatency = json.get_ptr("request_payload_latency");
+  auto jDistribution = json.get_ptr("latency_distribution");
+  auto jErrorRate = json.get_ptr("error_rate");
+  auto jRuntimeVarsKey = json.get_ptr("runtime_vars_key");
   checkLogic(
       jBeforeLatency != nullptr || jAfterLatency != nullptr ||
-          jTotalLatency != nullptr || jRequestLatency != nullptr,
+          jTotalLatency != nullptr || jRequestLatency != nullptr ||
+          jDistribution != nullptr || jErrorRate != nullptr ||
+          jRuntimeVarsKey != nullptr,
       "LatencyInjectionRoute must specify either 'before_latency_ms', "
-      "'after_latency_ms', 'total_latency_ms' or 'request_payload_latency'");
+      "'after_latency_ms', 'total_latency_ms', 'request_payload_latency', "
+      "'latency_distribution', 'error_rate' or 'runtime_vars_key'");
 
   std::chrono::milliseconds beforeLatency{0};
   std::chrono::milliseconds afterLatency{0};
@@ -281,8 +373,26 @@ typename RouterInfo::RouteHandlePtr makeLatencyInjectionRoute(
     maxRequestLatency = std::chrono::microseconds(jMaxRequestLatency->asInt());
   }
 
+  std::shared_ptr<const LatencyInjectionProfileSource> profile;
+  std::string runtimeVarsKey;
+  if (jRuntimeVarsKey) {
+    checkLogic(
+        jRuntimeVarsKey->isString(),
+        "LatencyInjectionRoute: 'runtime_vars_key' is not a string");
+    runtimeVarsKey = jRuntimeVarsKey->getString();
+  }
+  try {
+    auto base = LatencyInjectionProfile::fromJson(json, {});
+    if (!base.empty() || !runtimeVarsKey.empty()) {
+      profile = std::make_shared<const LatencyInjectionProfileSource>(
+          std::move(base), std::move(runtimeVarsKey), router);
+    }
+  } catch (const std::logic_error& e) {
+    throwLogic("LatencyInjectionRoute: {}", e.what());
+  }
+
   if (beforeLatency.count() == 0 && afterLatency.count() == 0 &&
-      totalLatency.count() == 0 && !requestLatency) {
+      totalLatency.count() == 0 && !requestLatency && !profile) {
     // if we are not injecting any latency, optimize this rh away.
     return child;
   }
@@ -293,7 +403,15 @@ typename RouterInfo::RouteHandlePtr makeLatencyInjectionRoute(
       afterLatency,
       totalLatency,
       requestLatency,
-      maxRequestLatency);
+      maxRequestLatency,
+      std::move(profile));
+}
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeLatencyInjectionRoute(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  return createLatencyInjectionRoute<RouterInfo>(factory, json, nullptr);
 }
 
 } // namespace mcrouter
@@ -10,12 +10,14 @@
 #include <algorithm>
 #include <cassert>
 #include <fstream>
+#include <limits>
 #include <string>
 #include <utility>
 
 #include <folly/Conv.h>
 #include <folly/Range.h>
 
+#include "mcrouter/ExponentialSmoothData.h"
 #include "mcrouter/McrouterFiberContext.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/HashUtil.h"
@@ -35,6 +37,10 @@ namespace mcrouter {
  * of the servers is used as 'weight' to the WeightedCh3Hash function to
  * determine the next destination server.
  *
+ * The "two-random-choices-client-load" algorithm doesn't need servers to
+ * report their load: of two random children it picks the one with the lower
+ * (outstanding requests + 1) * smoothed RTT, both measured by this route.
+ *
  * @tparam RouteHandleInfo   The Router
  */
 template <class RouterInfo>
@@ -47,16 +53,16 @@ class LoadBalancerRoute {
   enum class AlgorithmType : std::uint8_t {
     WEIGHTED_HASHING = 1,
     TWO_RANDOM_CHOICES = 2,
+    TWO_RANDOM_CHOICES_CLIENT_LOAD = 3,
   };
 
   static constexpr folly::StringPiece kWeightedHashing = "weighted-hashing";
   static constexpr folly::StringPiece kTwoRandomChoices = "two-random-choices";
+  static constexpr folly::StringPiece kTwoRandomChoicesClientLoad =
+      "two-random-choices-client-load";
 
   std::string routeName() const {
-    return folly::to<std::string>(
-        "loadbalancer|",
-        algorithm_ == AlgorithmType::WEIGHTED_HASHING ? kWeightedHashing
-                                                      : kTwoRandomChoices);
+    return folly::to<std::string>("loadbalancer|", algorithmName());
   }
 
   /**
@@ -89,6 +95,10 @@ class LoadBalancerRoute {
         loadComplements_(children_.size(), 1.0),
         medianLoadScratch_(children_.size()),
         expTimes_(children_.size(), std::chrono::microseconds(0)),
+        outstanding_(children_.size(), 0),
+        rtts_(children_.size()),
+        rttExpTimes_(children_.size(), std::chrono::microseconds(0)),
+        errorExpTimes_(children_.size(), std::chrono::microseconds(0)),
         gen_(seed),
         algorithm_(algorithm),
         enableThriftServerLoad_(enableThriftServerLoad) {
@@ -108,6 +118,9 @@ class LoadBalancerRoute {
     if (algorithm_ == AlgorithmType::TWO_RANDOM_CHOICES) {
       return routeTwoRandomChoices(req);
     }
+    if (algorithm_ == AlgorithmType::TWO_RANDOM_CHOICES_CLIENT_LOAD) {
+      return routeTwoRandomChoicesClientLoad(req);
+    }
     // first try
     size_t idx = selectWeightedHashing(req, loadComplements_, salt_);
     auto reply = doRoute(req, idx);
@@ -165,6 +178,15 @@ class LoadBalancerRoute {
   std::vector<double> medianLoadScratch_;
   // Point in time when the loadComplement becomes too old to be trusted.
   std::vector<std::chrono::microseconds> expTimes_;
+  // Requests sent to each child by this route that haven't replied yet.
+  // Used by the TwoRandomChoicesClientLoad algorithm, as are the two below.
+  std::vector<uint32_t> outstanding_;
+  // Smoothed round trip time of each child, in microseconds.
+  std::vector<ExponentialSmoothData<16>> rtts_;
+  // Point in time when the rtt becomes too old to be trusted.
+  std::vector<std::chrono::microseconds> rttExpTimes_;
+  // Point in time until which a child is avoided after an error reply.
+  std::vector<std::chrono::microseconds> errorExpTimes_;
   // Random Number generator used for TwoRandomChoices algorithm
   std::ranlux24_base gen_;
   // Load balancing algorithm
@@ -202,6 +224,18 @@ class LoadBalancerRoute {
         });
   }
 
+  folly::StringPiece algorithmName() const {
+    switch (algorithm_) {
+      case AlgorithmType::WEIGHTED_HASHING:
+        return kWeightedHashing;
+      case AlgorithmType::TWO_RANDOM_CHOICES:
+        return kTwoRandomChoices;
+      case AlgorithmType::TWO_RANDOM_CHOICES_CLIENT_LOAD:
+        return kTwoRandomChoicesClientLoad;
+    }
+    return kWeightedHashing;
+  }
+
   template <class Reply>
   bool shouldFailover(const Reply& reply) {
     return isErrorResult(*reply.result_ref());
@@ -255,6 +289,51 @@ class LoadBalancerRoute {
     return rep;
   }
 
+  template <class Request>
+  ReplyT<Request> routeTwoRandomChoicesClientLoad(const Request& req) {
+    auto idxs = pickTwoRandomChildren();
+    const int64_t now = nowUs();
+    const size_t idx =
+        clientLoadCost(idxs.first, now) <= clientLoadCost(idxs.second, now)
+        ? idxs.first
+        : idxs.second;
+
+    ++outstanding_[idx];
+    auto reply = children_[idx]->route(req);
+    --outstanding_[idx];
+
+    const int64_t end = nowUs();
+    if (isErrorResult(*reply.result_ref())) {
+      // Errors (e.g. TKO) are usually fast, so they would make the child
+      // look great. Keep it out of the way for loadTtl_ instead.
+      errorExpTimes_[idx] = std::chrono::microseconds(end + loadTtl_.count());
+    } else {
+      // Like server loads, RTTs expire after loadTtl_ so that children that
+      // were slow once get probed again and start over from fresh samples.
+      if (rttExpTimes_[idx].count() <= now) {
+        rtts_[idx].reset();
+      }
+      rtts_[idx].insertSample(end - now);
+      rttExpTimes_[idx] = std::chrono::microseconds(end + loadTtl_.count());
+    }
+
+    return reply;
+  }
+
+  /**
+   * Children without a recent RTT sample cost only their outstanding
+   * requests, so that they get probed.
+   */
+  double clientLoadCost(size_t idx, int64_t now) const {
+    if (errorExpTimes_[idx].count() > now) {
+      return std::numeric_limits<double>::infinity();
+    }
+    if (!rtts_[idx].hasValue() || rttExpTimes_[idx].count() <= now) {
+      return outstanding_[idx];
+    }
+    return (outstanding_[idx] + 1) * rtts_[idx].value();
+  }
+
   template <class Request>
   size_t selectWeightedHashingInternal(
       const Request& req,
@@ -286,6 +365,15 @@ class LoadBalancerRoute {
    *
    */
   std::pair<size_t, size_t> selectTwoRandomChoices() {
+    auto [x, y] = pickTwoRandomChildren();
+    if (loadComplements_[x] > loadComplements_[y]) {
+      return std::make_pair<size_t, size_t>(x, y);
+    }
+    return std::make_pair<size_t, size_t>(y, x);
+  }
+
+  // Two distinct random children.
+  std::pair<size_t, size_t> pickTwoRandomChildren() {
     uint32_t x = 0;
     uint32_t y = 1;
     if (children_.size() > 2) {
@@ -295,11 +383,7 @@ class LoadBalancerRoute {
         y = children_.size() - 1;
       }
     }
-
-    if (loadComplements_[x] > loadComplements_[y]) {
-      return std::make_pair<size_t, size_t>(x, y);
-    }
-    return std::make_pair<size_t, size_t>(y, x);
+    return std::make_pair<size_t, size_t>(x, y);
   }
 
   template <class Request>
@@ -332,6 +416,9 @@ template <class RouterInfo>
 constexpr folly::StringPiece LoadBalancerRoute<RouterInfo>::kWeightedHashing;
 template <class RouterInfo>
 constexpr folly::StringPiece LoadBalancerRoute<RouterInfo>::kTwoRandomChoices;
+template <class RouterInfo>
+constexpr folly::StringPiece
+    LoadBalancerRoute<RouterInfo>::kTwoRandomChoicesClientLoad;
 
 template <class RouterInfo>
 struct LoadBalancerRouteOptions {
@@ -378,6 +465,11 @@ LoadBalancerRouteOptions<RouterInfo> parseLoadBalancerRouteJson(
         algorithmStr == LoadBalancerRoute<RouterInfo>::kTwoRandomChoices) {
       options.algorithm =
           LoadBalancerRoute<RouterInfo>::AlgorithmType::TWO_RANDOM_CHOICES;
+    } else if (
+        algorithmStr ==
+        LoadBalancerRoute<RouterInfo>::kTwoRandomChoicesClientLoad) {
+      options.algorithm = LoadBalancerRoute<
+          RouterInfo>::AlgorithmType::TWO_RANDOM_CHOICES_CLIENT_LOAD;
     } else {
       throwLogic("Unknown algorithm: {}", algorithmStr);
     }
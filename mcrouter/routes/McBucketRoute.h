@@ -75,9 +75,7 @@ class McBucketRoute {
     if (fiber_local<RouterInfo>::getBucketId().has_value()) {
       return t(*rh_, req);
     }
-    auto bucketId = folly::fibers::runInMainContext([this, &req]() {
-      return ch3_(getRoutingKey<Request>(req, this->salt_));
-    });
+    auto bucketId = computeBucketId(req);
     if (bucketId < bucketizeUntil_) {
       if (auto* ctx = fiber_local<RouterInfo>::getTraverseCtx()) {
         ctx->recordBucketizationData(
@@ -96,9 +94,7 @@ class McBucketRoute {
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    auto bucketId = folly::fibers::runInMainContext([this, &req]() {
-      return ch3_(getRoutingKey<Request>(req, this->salt_));
-    });
+    auto bucketId = computeBucketId(req);
     auto& ctx = fiber_local<RouterInfo>::getSharedCtx();
 
     if (FOLLY_UNLIKELY(ctx->recordingBucketData())) {
@@ -131,6 +127,26 @@ class McBucketRoute {
   const std::string salt_;
   const Ch3HashFunc ch3_;
   const std::string bucketizationKeyspace_;
+
+  template <class Request>
+  size_t computeBucketId(const Request& req) const {
+    // Unsalted, this is the hash a CH3 pool of totalBuckets_ hosts would
+    // compute, so it's shared with those through the key's hash cache.
+    size_t bucketId;
+    if (salt_.empty() &&
+        req.key_ref()->getCachedHash(
+            totalBuckets_, Ch3HashFunc::typeId(), bucketId)) {
+      return bucketId;
+    }
+    bucketId = folly::fibers::runInMainContext([this, &req]() {
+      return salt_.empty() ? ch3_(req.key_ref()->routingKey())
+                           : ch3_(getRoutingKey<Request>(req, salt_));
+    });
+    if (salt_.empty()) {
+      req.key_ref()->cacheHash(bucketId, totalBuckets_, Ch3HashFunc::typeId());
+    }
+    return bucketId;
+  }
 };
 
 McBucketRouteSettings parseMcBucketRouteSettings(const folly::dynamic& json);
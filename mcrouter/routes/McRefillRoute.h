@@ -10,11 +10,18 @@
 #include <algorithm>
 #include <cassert>
 #include <fstream>
+#include <functional>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <folly/Conv.h>
+#include <folly/Optional.h>
 #include <folly/Range.h>
+#include <folly/container/F14Set.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/fibers/WhenN.h>
 
 #include "mcrouter/McrouterFiberContext.h"
 #include "mcrouter/config.h"
@@ -24,11 +31,28 @@
 #include "mcrouter/lib/WeightedCh3HashFunc.h"
 #include "mcrouter/lib/routes/NullRoute.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/RetryBudget.h"
+#include "mcrouter/stats.h"
 
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
 
+/**
+ * Sends gets to "primary"; on a miss, refills the key from "refill": gets
+ * the value (and its exptime, with a metaget) from "refill" and sets it in
+ * "primary". The miss is replied right away, refills happen in the
+ * background.
+ *
+ * Refills are:
+ *  - coalesced per key: a miss on a key whose refill is already queued or
+ *    in flight doesn't start another one;
+ *  - batched: refills queued while the proxy is busy are sent together, so
+ *    that requests to the same destination go out in one write;
+ *  - optionally limited by "refill_budget" (see RetryBudget), as a
+ *    percentage of the gets sent to "primary", shared by all proxies. At
+ *    most "max_pending_refills" refills are queued on each proxy.
+ */
 template <class RouterInfo>
 class McRefillRoute {
  private:
@@ -36,6 +60,8 @@ class McRefillRoute {
   using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
 
  public:
+  static constexpr size_t kDefaultMaxPendingRefills = 1000;
+
   std::string routeName() const {
     return "McRefillRoute";
   }
@@ -43,8 +69,15 @@ class McRefillRoute {
   /**
    * Constructs McRefillRoute.
    */
-  McRefillRoute(RouteHandlePtr primary, RouteHandlePtr refill)
-      : primary_(primary), refill_(refill) {
+  McRefillRoute(
+      RouteHandlePtr primary,
+      RouteHandlePtr refill,
+      std::shared_ptr<const RetryBudget> refillBudget = nullptr,
+      size_t maxPendingRefills = kDefaultMaxPendingRefills)
+      : primary_(primary),
+        refill_(refill),
+        refillBudget_(std::move(refillBudget)),
+        maxPendingRefills_(maxPendingRefills) {
     assert(primary_ != nullptr);
     assert(refill_ != nullptr);
   }
@@ -64,46 +97,24 @@ class McRefillRoute {
     return t(*refill_, req);
   }
 
-  McLeaseGetReply route(const McLeaseGetRequest& req) const {
+  McLeaseGetReply route(const McLeaseGetRequest& req) {
     constexpr size_t kLeaseHotMissToken = 1;
     auto reply = primary_->route(req);
+    recordPrimaryGet();
     if (isMissResult(*reply.result_ref()) &&
         *reply.leaseToken_ref() != kLeaseHotMissToken) {
-      // send request to prod
-      auto refillReply = refill_->route(genGetRequest(req));
-      if (isHitResult(*refillReply.result_ref())) {
-        McMetagetRequest metaGet(req.key_ref()->fullKey());
-        auto metaReply = refill_->route(metaGet);
-        if (isHitResult(*metaReply.result_ref())) {
-          folly::fibers::addTask(
-              [this,
-               setReq = genSetRequest(req, reply, refillReply, metaReply)]() {
-                primary_->route(setReq);
-              });
-        }
-      }
+      // Only the holder of the lease may set the key.
+      queueRefill(req.key_ref()->fullKey(), *reply.leaseToken_ref());
     }
     return reply;
   }
 
   template <class Request>
-  ReplyT<Request> route(const Request& req, carbon::GetLikeT<Request> = 0)
-      const {
+  ReplyT<Request> route(const Request& req, carbon::GetLikeT<Request> = 0) {
     auto reply = primary_->route(req);
+    recordPrimaryGet();
     if (isMissResult(*reply.result_ref())) {
-      // send request to prod
-      auto refillReply = refill_->route(genGetRequest(req));
-      if (isHitResult(*refillReply.result_ref())) {
-        McMetagetRequest metaGet(req.key_ref()->fullKey());
-        auto metaReply = refill_->route(metaGet);
-        if (isHitResult(*metaReply.result_ref())) {
-          folly::fibers::addTask(
-              [this,
-               setReq = genSetRequest(req, reply, refillReply, metaReply)]() {
-                primary_->route(setReq);
-              });
-        }
-      }
+      queueRefill(req.key_ref()->fullKey(), folly::none);
     }
     return reply;
   }
@@ -116,45 +127,100 @@ class McRefillRoute {
   }
 
  private:
+  struct Refill {
+    std::string key;
+    // Lease token of the primary miss, for lease-gets.
+    folly::Optional<int64_t> leaseToken;
+  };
+
   const std::shared_ptr<RouteHandleIf> primary_;
   const std::shared_ptr<RouteHandleIf> refill_;
+  const std::shared_ptr<const RetryBudget> refillBudget_;
+  const size_t maxPendingRefills_;
+
+  // Route handles are per proxy, so this is only accessed from one thread.
+  std::vector<Refill> pendingRefills_;
+  // Keys queued or being refilled.
+  folly::F14FastSet<std::string> refillingKeys_;
+  bool flushScheduled_{false};
 
-  McGetRequest genGetRequest(const McGetRequest& req) const {
-    return req;
+  void recordPrimaryGet() const {
+    if (refillBudget_) {
+      refillBudget_->recordSuccess();
+    }
   }
 
-  template <class Request>
-  McGetRequest genGetRequest(const Request& req, carbon::GetLikeT<Request> = 0)
-      const {
-    McGetRequest getReq(req.key_ref()->fullKey());
-    return getReq;
+  void queueRefill(
+      folly::StringPiece key,
+      folly::Optional<int64_t> leaseToken) {
+    if (refillingKeys_.count(key)) {
+      bumpStat(refill_coalesced_stat);
+      return;
+    }
+    if (refillingKeys_.size() >= maxPendingRefills_ ||
+        (refillBudget_ && !refillBudget_->tryRetry())) {
+      bumpStat(refill_budget_exhausted_stat);
+      return;
+    }
+    refillingKeys_.insert(key.str());
+    pendingRefills_.push_back(Refill{key.str(), leaseToken});
+    if (!flushScheduled_) {
+      flushScheduled_ = true;
+      // Runs once the fibers that are ready now are done, so that misses
+      // they run into are refilled in the same batch.
+      folly::fibers::addTask([this]() { flushRefills(); });
+    }
   }
 
-  McLeaseSetRequest genSetRequest(
-      const McLeaseGetRequest& primaryReq,
-      const McLeaseGetReply& primaryReply,
-      const McGetReply& refillReply,
-      const McMetagetReply& metaReply) const {
-    McLeaseSetRequest sreq(primaryReq.key_ref()->fullKey());
-    sreq.value_ref() = *refillReply.value_ref();
-    sreq.flags_ref() = *refillReply.flags_ref();
-    sreq.exptime_ref() = *metaReply.exptime_ref();
-    sreq.leaseToken_ref() = *primaryReply.leaseToken_ref();
-    return sreq;
+  void flushRefills() {
+    while (!pendingRefills_.empty()) {
+      std::vector<Refill> batch;
+      batch.swap(pendingRefills_);
+
+      std::vector<std::function<void()>> refills;
+      refills.reserve(batch.size());
+      for (const auto& refill : batch) {
+        refills.push_back([this, &refill]() { doRefill(refill); });
+      }
+      folly::fibers::collectAll(refills.begin(), refills.end());
+
+      for (const auto& refill : batch) {
+        refillingKeys_.erase(refill.key);
+      }
+    }
+    flushScheduled_ = false;
   }
 
-  template <class Request>
-  McSetRequest genSetRequest(
-      const Request& primaryReq,
-      const ReplyT<Request>& /* unused */,
-      const McGetReply& refillReply,
-      const McMetagetReply& metaReply,
-      carbon::GetLikeT<Request> = 0) const {
-    McSetRequest sreq(primaryReq.key_ref()->fullKey());
-    sreq.value_ref() = *refillReply.value_ref();
-    sreq.flags_ref() = *refillReply.flags_ref();
-    sreq.exptime_ref() = *metaReply.exptime_ref();
-    return sreq;
+  void doRefill(const Refill& refill) {
+    bumpStat(refill_sent_stat);
+    auto refillReply = refill_->route(McGetRequest(refill.key));
+    if (!isHitResult(*refillReply.result_ref())) {
+      return;
+    }
+    auto metaReply = refill_->route(McMetagetRequest(refill.key));
+    if (!isHitResult(*metaReply.result_ref())) {
+      return;
+    }
+    if (refill.leaseToken) {
+      McLeaseSetRequest sreq(refill.key);
+      sreq.value_ref() = *refillReply.value_ref();
+      sreq.flags_ref() = *refillReply.flags_ref();
+      sreq.exptime_ref() = *metaReply.exptime_ref();
+      sreq.leaseToken_ref() = *refill.leaseToken;
+      primary_->route(sreq);
+    } else {
+      McSetRequest sreq(refill.key);
+      sreq.value_ref() = *refillReply.value_ref();
+      sreq.flags_ref() = *refillReply.flags_ref();
+      sreq.exptime_ref() = *metaReply.exptime_ref();
+      primary_->route(sreq);
+    }
+  }
+
+  static void bumpStat(stat_name_t stat) {
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      ctx->proxy().stats().increment(stat);
+    }
   }
 };
 
@@ -166,8 +232,24 @@ typename RouterInfo::RouteHandlePtr makeMcRefillRoute(
   checkLogic(json.count("primary"), "McRefillRoute: no primary route");
   checkLogic(json.count("refill"), "McRefillRoute: no refill route");
 
+  std::shared_ptr<const RetryBudget> refillBudget;
+  if (auto jRefillBudget = json.get_ptr("refill_budget")) {
+    refillBudget = RetryBudget::getShared(*jRefillBudget, json);
+  }
+  size_t maxPendingRefills =
+      McRefillRoute<RouterInfo>::kDefaultMaxPendingRefills;
+  if (auto jMaxPending = json.get_ptr("max_pending_refills")) {
+    checkLogic(
+        jMaxPending->isInt() && jMaxPending->getInt() > 0,
+        "McRefillRoute: max_pending_refills is not a positive integer");
+    maxPendingRefills = jMaxPending->getInt();
+  }
+
   return makeRouteHandleWithInfo<RouterInfo, McRefillRoute>(
-      factory.create(json["primary"]), factory.create(json["refill"]));
+      factory.create(json["primary"]),
+      factory.create(json["refill"]),
+      std::move(refillBudget),
+      maxPendingRefills);
 }
 
 } // namespace mcrouter
@@ -5,7 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <folly/Conv.h>
 #include <folly/Range.h>
@@ -15,6 +17,7 @@
 #include "mcrouter/PoolFactory.h"
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyDestination.h"
+#include "mcrouter/ProxyDestinationKey.h"
 #include "mcrouter/ProxyDestinationMap.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/WeightedCh3HashFunc.h"
@@ -35,6 +38,8 @@
 #include "mcrouter/routes/HashRouteFactory.h"
 #include "mcrouter/routes/McBucketRoute.h"
 #include "mcrouter/routes/PoolRouteUtils.h"
+#include "mcrouter/routes/ProfilingRoute.h"
+#include "mcrouter/routes/TracingRoute.h"
 #include "mcrouter/routes/RateLimitRoute.h"
 #include "mcrouter/routes/RateLimiter.h"
 #include "mcrouter/routes/ShadowRoute.h"
@@ -222,6 +227,13 @@ McRouteHandleProvider<RouterInfo>::makePool(
       keepRoutingPrefix = parseBool(*jKeepRoutingPrefix, "keep_routing_prefix");
     }
 
+    // Pools that normally only get failover traffic: keep their connections
+    // open, see standby_keepalive_interval_ms.
+    bool standby = false;
+    if (auto jStandby = json.get_ptr("standby")) {
+      standby = parseBool(*jStandby, "standby");
+    }
+
     uint32_t qosClass = opts.default_qos_class;
     uint32_t qosPath = opts.default_qos_path;
     if (auto jQos = json.get_ptr("qos")) {
@@ -284,6 +296,7 @@ McRouteHandleProvider<RouterInfo>::makePool(
     auto jhostnames = json.get_ptr("hostnames");
     auto jfailureDomains = json.get_ptr("failure_domains");
     auto jAdditionalFanout = json.get_ptr("additional_fanout");
+    auto jConnectionsPerServer = json.get_ptr("connections_per_server");
     checkLogic(
         !jfailureDomains || jfailureDomains->isArray(),
         "failure_domains is not an array");
@@ -310,18 +323,32 @@ McRouteHandleProvider<RouterInfo>::makePool(
     if (jAdditionalFanout) {
       additionalFanout = jAdditionalFanout->getInt();
     }
+    uint32_t connectionsPerServer =
+        proxy_.router().opts().connections_per_destination;
+    if (jConnectionsPerServer) {
+      checkLogic(
+          jConnectionsPerServer->isInt() && jConnectionsPerServer->getInt() > 0,
+          "connections_per_server is not a positive integer");
+      connectionsPerServer = jConnectionsPerServer->getInt();
+    }
+    connectionsPerServer = std::max<uint32_t>(connectionsPerServer, 1);
     checkLogic(
-        static_cast<uint64_t>(additionalFanout + 1) *
+        static_cast<uint64_t>(additionalFanout + 1) * connectionsPerServer *
                 static_cast<uint64_t>(proxy_.router().opts().num_proxies) <=
             kMaxTotalFanout,
-        "(additional_fanout={} + 1) * num_proxies={} must be <= {}",
+        "(additional_fanout={} + 1) * connections_per_server={} * "
+        "num_proxies={} must be <= {}",
         additionalFanout,
+        connectionsPerServer,
         proxy_.router().opts().num_proxies,
         kMaxTotalFanout);
 
     checkLogic(
         additionalFanout == 0 || !proxy_.router().opts().thread_affinity,
         "additional_fanout is not supported with thread_affinity");
+    checkLogic(
+        connectionsPerServer == 1 || !proxy_.router().opts().thread_affinity,
+        "connections_per_server is not supported with thread_affinity");
 
     int32_t poolStatIndex = proxy_.router().getStatsEnabledPoolIndex(name);
 
@@ -364,6 +391,14 @@ McRouteHandleProvider<RouterInfo>::makePool(
       for (uint32_t idx = 0; idx < (1 + additionalFanout); ++idx) {
         auto ap = createAccessPoint(
             server.stringPiece(), failureDomain, proxy_.router(), *apAttr);
+        // Connections beyond the first one use indices past the fanout ones,
+        // so that every connection gets its own ProxyDestination.
+        std::vector<std::shared_ptr<AccessPoint>> extraAps;
+        extraAps.reserve(connectionsPerServer - 1);
+        for (uint32_t conn = 1; conn < connectionsPerServer; ++conn) {
+          extraAps.push_back(createAccessPoint(
+              server.stringPiece(), failureDomain, proxy_.router(), *apAttr));
+        }
 
         auto it = accessPoints_.find(name);
         if (it == accessPoints_.end()) {
@@ -395,7 +430,10 @@ McRouteHandleProvider<RouterInfo>::makePool(
               disableRequestDeadlineCheck,
               poolTkoTracker,
               keepRoutingPrefix,
-              idx);
+              standby,
+              idx,
+              std::move(extraAps),
+              1 + additionalFanout);
           it->second.insert(destResult.second);
           addDestination(std::move(destResult.first));
         } else {
@@ -412,7 +450,10 @@ McRouteHandleProvider<RouterInfo>::makePool(
               disableRequestDeadlineCheck,
               poolTkoTracker,
               keepRoutingPrefix,
-              idx);
+              standby,
+              idx,
+              std::move(extraAps),
+              1 + additionalFanout);
           it->second.insert(destResult.second);
           addDestination(std::move(destResult.first));
         }
@@ -501,12 +542,47 @@ McRouteHandleProvider<RouterInfo>::createDestinationRoute(
     bool disableRequestDeadlineCheck,
     const std::shared_ptr<PoolTkoTracker>& poolTkoTracker,
     bool keepRoutingPrefix,
-    uint32_t idx) {
+    bool standby,
+    uint32_t idx,
+    std::vector<std::shared_ptr<AccessPoint>> extraAps,
+    uint32_t extraIdxStride) {
   auto pdstn = proxy_.destinationMap()->template emplace<Transport>(
       std::move(ap), timeout, qosClass, qosPath, poolTkoTracker, idx);
   pdstn->updateShortestTimeout(connectTimeout, timeout);
+  if (standby) {
+    pdstn->setStandby();
+  }
   auto resAp = pdstn->accessPoint();
 
+  std::vector<std::shared_ptr<ProxyDestination<Transport>>> extraDestinations;
+  extraDestinations.reserve(extraAps.size());
+  for (size_t conn = 0; conn < extraAps.size(); ++conn) {
+    auto extraIdx = idx + (conn + 1) * extraIdxStride;
+    auto extraDestination =
+        proxy_.destinationMap()->template emplace<Transport>(
+            std::move(extraAps[conn]),
+            timeout,
+            qosClass,
+            qosPath,
+            poolTkoTracker,
+            extraIdx);
+    extraDestination->updateShortestTimeout(connectTimeout, timeout);
+    extraDestinations.push_back(std::move(extraDestination));
+  }
+
+  // Cold destinations share a connection owned by one proxy, picked by
+  // hashing the destination so that load is spread across proxies.
+  // Standby destinations are cold on purpose, but every proxy keeps its own
+  // connection ready for failover traffic.
+  ProxyBase* sharedOwner = nullptr;
+  const auto& opts = proxy_.router().opts();
+  if (!standby && opts.shared_cold_connections && opts.num_proxies > 1) {
+    auto ownerId = ProxyDestinationKey(*pdstn).hash() % opts.num_proxies;
+    if (ownerId != proxy_.getId()) {
+      sharedOwner = proxy_.router().getProxyBase(ownerId);
+    }
+  }
+
   return {
       makeDestinationRoute<RouterInfo, Transport>(
           std::move(pdstn),
@@ -515,7 +591,10 @@ McRouteHandleProvider<RouterInfo>::createDestinationRoute(
           poolStatIndex,
           timeout,
           disableRequestDeadlineCheck,
-          keepRoutingPrefix),
+          keepRoutingPrefix,
+          std::move(extraDestinations),
+          sharedOwner,
+          opts.shared_connection_promote_rps),
       std::move(resAp)};
 }
 
@@ -551,6 +630,11 @@ McRouteHandleProvider<RouterInfo>::createSRRoute(
     }
   }
 
+  if (auto adaptiveJson = json.get_ptr("adaptive_outstanding")) {
+    route = makeOutstandingLimitRoute<RouterInfo>(
+        std::move(route), AdaptiveConcurrencyLimit::Options(*adaptiveJson));
+  }
+
   if (!(proxy_.router().opts().disable_shard_split_route)) {
     if (auto jsplits = json.get_ptr("shard_splits")) {
       route = makeShardSplitRoute<RouterInfo>(
@@ -665,6 +749,11 @@ McRouteHandleProvider<RouterInfo>::makePoolRoute(
       if (auto* jNeedBucketization = json.get_ptr("bucketize")) {
         if (parseBool(*jNeedBucketization, "bucketize")) {
           jhashWithWeights["bucketize"] = true;
+          // Only buckets below bucketize_until are routed by bucket id, so
+          // their destinations can be computed upfront.
+          if (auto* jBucketizeUntil = json.get_ptr("bucketize_until")) {
+            jhashWithWeights["bucketize_until"] = *jBucketizeUntil;
+          }
         }
       }
       // When setting useBucketHashSelector, the PoolRoute is constructed with
@@ -875,6 +964,28 @@ McRouteHandleProvider<RouterInfo>::create(
     RouteHandleFactory<RouteHandleIf>& factory,
     folly::StringPiece type,
     const folly::dynamic& json) {
+  auto ret = createUnprofiled(factory, type, json);
+  // Pool destinations are left alone: there are too many of them, and they
+  // mostly wait on the network anyway.
+  if (auto* profiler = proxy_.routeProfiler(); profiler && type != "Pool") {
+    for (auto& route : ret) {
+      route = makeProfilingRoute<RouterInfo>(std::move(route), *profiler);
+    }
+  }
+  if (auto* tracer = proxy_.requestTracer(); tracer && type != "Pool") {
+    for (auto& route : ret) {
+      route = makeTracingRoute<RouterInfo>(std::move(route), *tracer);
+    }
+  }
+  return ret;
+}
+
+template <class RouterInfo>
+std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>
+McRouteHandleProvider<RouterInfo>::createUnprofiled(
+    RouteHandleFactory<RouteHandleIf>& factory,
+    folly::StringPiece type,
+    const folly::dynamic& json) {
   if (type == "Pool") {
     return std::get<0>(makePool(factory, poolFactory_.parsePool(json)));
   } else if (type == "ShadowRoute") {
@@ -7,15 +7,19 @@
 
 #include "McRouteHandleProvider.h"
 
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyRequestContext.h"
 #include "mcrouter/lib/network/MessageHelpers.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/lib/routes/NullRoute.h"
+#include "mcrouter/routes/ActiveWarmUpRoute.h"
 #include "mcrouter/routes/AllAsyncRouteFactory.h"
 #include "mcrouter/routes/AllFastestRouteFactory.h"
 #include "mcrouter/routes/AllInitialRouteFactory.h"
 #include "mcrouter/routes/AllMajorityRouteFactory.h"
 #include "mcrouter/routes/AllSyncRouteFactory.h"
 #include "mcrouter/routes/BlackholeRoute.h"
+#include "mcrouter/routes/BloomFilterRoute.h"
 #include "mcrouter/routes/CarbonLookasideRoute.h"
 #include "mcrouter/routes/DevNullRoute.h"
 #include "mcrouter/routes/DistributionRoute.h"
@@ -90,6 +94,11 @@ std::shared_ptr<CommonAccessPointAttributes> getCommonAccessPointAttributes(
     enableCompression = parseBool(*jCompression, "enable_compression");
   }
 
+  apAttr.useIoUring = router.opts().io_uring_transport;
+  if (auto jUseIoUring = json.get_ptr("use_io_uring")) {
+    apAttr.useIoUring = parseBool(*jUseIoUring, "use_io_uring");
+  }
+
   auto& mech = apAttr.mech;
   mech = SecurityMech::NONE;
   auto& mechOverride = apAttr.mechOverride;
@@ -183,6 +192,8 @@ std::shared_ptr<AccessPoint> createAccessPoint(
     ap->serviceIdOverride(serviceIdOverride.value());
   }
 
+  ap->setUseIoUring(apAttr.useIoUring);
+
   if (withinDcMech.has_value() || crossDcMech.has_value() ||
       withinDcPort.has_value() || crossDcPort.has_value()) {
     bool isInLocalDc = isInLocalDatacenter(ap->getHost());
@@ -231,6 +242,18 @@ createCarbonLookasideRoute<MemcacheRouterInfo, MemcacheCarbonLookasideHelper>(
     RouteHandleFactory<MemcacheRouteHandleIf>& factory,
     const folly::dynamic& json);
 
+McrouterRouteHandlePtr makeCoalescingRoute(
+    McRouteHandleFactory& factory,
+    const folly::dynamic& json);
+
+McrouterRouteHandlePtr makeHedgedRoute(
+    McRouteHandleFactory& factory,
+    const folly::dynamic& json);
+
+McrouterRouteHandlePtr makeNearCacheRoute(
+    McRouteHandleFactory& factory,
+    const folly::dynamic& json);
+
 McrouterRouteHandlePtr makeWarmUpRoute(
     McRouteHandleFactory& factory,
     const folly::dynamic& json);
@@ -245,16 +268,26 @@ template <>
 typename McRouteHandleProvider<MemcacheRouterInfo>::RouteHandleFactoryMap
 McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
   RouteHandleFactoryMap map{
+      {"ActiveWarmUpRoute",
+       [](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return makeActiveWarmUpRoute<MemcacheRouterInfo>(factory, json);
+       }},
       {"AllAsyncRoute", &makeAllAsyncRoute<MemcacheRouterInfo>},
       {"AllFastestRoute", &makeAllFastestRoute<MemcacheRouterInfo>},
       {"AllInitialRoute", &makeAllInitialRoute<MemcacheRouterInfo>},
       {"AllMajorityRoute", &makeAllMajorityRoute<MemcacheRouterInfo>},
       {"AllSyncRoute", &makeAllSyncRoute<MemcacheRouterInfo>},
       {"BlackholeRoute", &makeBlackholeRoute<MemcacheRouterInfo>},
+      {"BloomFilterRoute",
+       [this](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return makeBloomFilterRoute<MemcacheRouterInfo>(
+             factory, json, proxy_.router());
+       }},
       {"CarbonLookasideRoute",
        &createCarbonLookasideRoute<
            MemcacheRouterInfo,
            MemcacheCarbonLookasideHelper>},
+      {"CoalescingRoute", &makeCoalescingRoute},
       {"DevNullRoute", &makeDevNullRoute<MemcacheRouterInfo>},
       {"DistributionRoute",
        [](McRouteHandleFactory& factory, const folly::dynamic& json) {
@@ -267,8 +300,13 @@ McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
        [](McRouteHandleFactory& factory, const folly::dynamic& json) {
          return makeHashRoute<McrouterRouterInfo>(factory, json);
        }},
+      {"HedgedRoute", &makeHedgedRoute},
       {"HostIdRoute", &makeHostIdRoute<MemcacheRouterInfo>},
-      {"LatencyInjectionRoute", &makeLatencyInjectionRoute<MemcacheRouterInfo>},
+      {"LatencyInjectionRoute",
+       [this](McRouteHandleFactory& factory, const folly::dynamic& json) {
+         return createLatencyInjectionRoute<MemcacheRouterInfo>(
+             factory, json, &proxy_.router());
+       }},
       {"L1L2CacheRoute", &makeL1L2CacheRoute<MemcacheRouterInfo>},
       {"L1L2SizeSplitRoute", &makeL1L2SizeSplitRoute<MemcacheRouterInfo>},
       {"KeySplitRoute", &makeKeySplitRoute<MemcacheRouterInfo>},
@@ -283,6 +321,7 @@ McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
       {"MissFailoverRoute", &makeMissFailoverRoute<MemcacheRouterInfo>},
       {"ModifyKeyRoute", &makeModifyKeyRoute<MemcacheRouterInfo>},
       {"ModifyExptimeRoute", &makeModifyExptimeRoute<MemcacheRouterInfo>},
+      {"NearCacheRoute", &makeNearCacheRoute},
       {"NullRoute", &makeNullRoute<MemcacheRouteHandleIf>},
       {"OperationSelectorRoute",
        &makeOperationSelectorRoute<MemcacheRouterInfo>},
@@ -296,7 +335,12 @@ McRouteHandleProvider<MemcacheRouterInfo>::buildRouteMap() {
       {"RandomRoute", &makeRandomRoute<MemcacheRouterInfo>},
       {"RateLimitRoute",
        [](McRouteHandleFactory& factory, const folly::dynamic& json) {
-         return makeRateLimitRoute(factory, json);
+         // Clients are only known by address, with retain_source_ip.
+         return makeRateLimitRoute(factory, json, []() {
+           auto& ctx = fiber_local<MemcacheRouterInfo>::getSharedCtx();
+           return ctx ? folly::StringPiece(ctx->userIpAddress())
+                      : folly::StringPiece();
+         });
        }},
       {"RoutingGroupRoute", &makeRoutingGroupRoute<MemcacheRouterInfo>},
       {"StagingRoute", &makeStagingRoute},
@@ -59,6 +59,7 @@ struct CommonAccessPointAttributes {
   std::optional<folly::StringPiece> serviceIdOverride;
   uint16_t port;
   bool enableCompression;
+  bool useIoUring{false};
 
   bool operator==(const CommonAccessPointAttributes& other) const {
     return protocol == other.protocol && mech == other.mech &&
@@ -67,6 +68,7 @@ struct CommonAccessPointAttributes {
         crossDcMech == other.crossDcMech && crossDcPort == other.crossDcPort &&
         withinDcPort == other.withinDcPort && port == other.port &&
         enableCompression == other.enableCompression &&
+        useIoUring == other.useIoUring &&
         serviceIdOverride == other.serviceIdOverride;
   }
 };
@@ -208,6 +210,11 @@ class McRouteHandleProvider
       ProxyBase& proxy,
       const folly::dynamic& json);
 
+  std::vector<RouteHandlePtr> createUnprofiled(
+      RouteHandleFactory<RouteHandleIf>& factory,
+      folly::StringPiece type,
+      const folly::dynamic& json);
+
   template <class Transport>
   std::pair<RouteHandlePtr, std::shared_ptr<const AccessPoint>>
   createDestinationRoute(
@@ -222,7 +229,10 @@ class McRouteHandleProvider
       bool disableRequestDeadlineCheck,
       const std::shared_ptr<PoolTkoTracker>& poolTkoTracker,
       bool keepRoutingPrefix,
-      uint32_t idx);
+      bool standby,
+      uint32_t idx,
+      std::vector<std::shared_ptr<AccessPoint>> extraAps,
+      uint32_t extraIdxStride);
 
   RouteHandleFactoryMap buildRouteMap();
   RouteHandleFactoryMapWithProxy buildRouteMapWithProxy();
@@ -25,7 +25,8 @@ typename RouterInfo::RouteHandlePtr makeMigrateRoute(
     typename RouterInfo::RouteHandlePtr fh,
     typename RouterInfo::RouteHandlePtr th,
     time_t start_time_sec,
-    time_t interval_sec) {
+    time_t interval_sec,
+    time_t ramp_interval_sec) {
   return makeRouteHandle<
       typename RouterInfo::RouteHandleIf,
       MigrateRoute,
@@ -34,6 +35,7 @@ typename RouterInfo::RouteHandlePtr makeMigrateRoute(
       std::move(th),
       start_time_sec,
       interval_sec,
+      ramp_interval_sec,
       TimeProviderFunc());
 }
 
@@ -56,12 +58,20 @@ typename RouterInfo::RouteHandlePtr makeMigrateRoute(
     checkLogic(jinterval->isInt(), "MigrateRoute interval is not integer");
     intervalSec = jinterval->asInt();
   }
+  time_t rampIntervalSec = intervalSec;
+  if (auto jramp = json.get_ptr("ramp_interval")) {
+    checkLogic(
+        jramp->isInt() && jramp->asInt() >= 0,
+        "MigrateRoute ramp_interval is not a non-negative integer");
+    rampIntervalSec = jramp->asInt();
+  }
 
   return detail::makeMigrateRoute<RouterInfo>(
       factory.create(json["from"]),
       factory.create(json["to"]),
       startTimeSec,
-      intervalSec);
+      intervalSec,
+      rampIntervalSec);
 }
 } // namespace mcrouter
 } // namespace memcache
@@ -14,6 +14,8 @@
 #include <folly/dynamic.h>
 
 #include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/ProxyRequestContextTyped.h"
 #include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
@@ -21,6 +23,7 @@
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/routes/NullRoute.h"
+#include "mcrouter/routes/RetryBudget.h"
 
 namespace facebook {
 namespace memcache {
@@ -31,6 +34,7 @@ namespace mcrouter {
  * to each destination in the list in order until the first hit reply.
  * If all replies result in errors/misses, returns the reply from the
  * last destination in the list.
+ * With a retry budget, stops failing over once the budget is exhausted.
  */
 template <class RouterInfo>
 class MissFailoverRoute {
@@ -40,8 +44,11 @@ class MissFailoverRoute {
  public:
   explicit MissFailoverRoute(
       std::vector<std::shared_ptr<RouteHandleIf>> targets,
-      bool returnBestOnError = false)
-      : targets_(std::move(targets)), returnBestOnError_(returnBestOnError) {
+      bool returnBestOnError = false,
+      std::shared_ptr<const RetryBudget> retryBudget = nullptr)
+      : targets_(std::move(targets)),
+        returnBestOnError_(returnBestOnError),
+        retryBudget_(std::move(retryBudget)) {
     assert(targets_.size() > 1);
   }
 
@@ -79,6 +86,7 @@ class MissFailoverRoute {
  private:
   const std::vector<std::shared_ptr<RouteHandleIf>> targets_;
   const bool returnBestOnError_;
+  const std::shared_ptr<const RetryBudget> retryBudget_;
 
   bool shouldFailover(const carbon::Result replyResult) const {
     return !isHitResult(replyResult) && (replyResult != carbon::Result::OK);
@@ -87,6 +95,9 @@ class MissFailoverRoute {
   template <class Request>
   ReplyT<Request> routeImpl(const Request& req) const {
     auto reply = targets_[0]->route(req);
+    if (retryBudget_ && !isErrorResult(*reply.result_ref())) {
+      retryBudget_->recordSuccess();
+    }
     if (!shouldFailover(*reply.result_ref())) {
       return reply;
     }
@@ -96,6 +107,12 @@ class MissFailoverRoute {
         [this, &req, bestReply = std::move(reply)]() mutable {
           fiber_local<RouterInfo>::addRequestClass(RequestClass::kFailover);
           for (size_t i = 1, s = targets_.size(); i < s; ++i) {
+            if (retryBudget_ && !retryBudget_->tryRetry()) {
+              if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+                ctx->proxy().stats().increment(retry_budget_exhausted_stat);
+              }
+              break;
+            }
             auto failoverReply = targets_[i]->route(req);
             if (!shouldFailover(*failoverReply.result_ref())) {
               return failoverReply;
@@ -123,7 +140,8 @@ namespace detail {
 template <class RouterInfo>
 typename RouterInfo::RouteHandlePtr makeMissFailoverRoute(
     std::vector<typename RouterInfo::RouteHandlePtr> targets,
-    bool returnBestOnError) {
+    bool returnBestOnError,
+    std::shared_ptr<const RetryBudget> retryBudget = nullptr) {
   if (targets.empty()) {
     return createNullRoute<typename RouterInfo::RouteHandleIf>();
   }
@@ -133,7 +151,7 @@ typename RouterInfo::RouteHandlePtr makeMissFailoverRoute(
   }
 
   return makeRouteHandleWithInfo<RouterInfo, MissFailoverRoute>(
-      std::move(targets), returnBestOnError);
+      std::move(targets), returnBestOnError, std::move(retryBudget));
 }
 
 } // namespace detail
@@ -144,6 +162,7 @@ typename RouterInfo::RouteHandlePtr makeMissFailoverRoute(
     const folly::dynamic& json) {
   std::vector<typename RouterInfo::RouteHandlePtr> children;
   bool returnBestOnError = false;
+  std::shared_ptr<const RetryBudget> retryBudget;
   if (json.isObject()) {
     if (auto jChildren = json.get_ptr("children")) {
       children = factory.createList(*jChildren);
@@ -154,12 +173,15 @@ typename RouterInfo::RouteHandlePtr makeMissFailoverRoute(
           "ModifyKeyRoute: return_best_on_error is not a bool");
       returnBestOnError = jReturnBest->asBool();
     }
+    if (auto jRetryBudget = json.get_ptr("retry_budget")) {
+      retryBudget = RetryBudget::getShared(*jRetryBudget, json);
+    }
 
   } else {
     children = factory.createList(json);
   }
   return detail::makeMissFailoverRoute<RouterInfo>(
-      std::move(children), returnBestOnError);
+      std::move(children), returnBestOnError, std::move(retryBudget));
 }
 } // namespace mcrouter
 } // namespace memcache
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <cctype>
+#include <cstring>
+#include <initializer_list>
 #include <memory>
 #include <string>
 #include <vector>
@@ -76,17 +78,20 @@ class ModifyKeyRoute {
   bool traverse(
       const Request& req,
       const RouteHandleTraverser<RouteHandleIf>& t) const {
-    auto cloneReq = req;
-    auto key = getModifiedKey(*req.key_ref());
-    if (key) {
-      cloneReq.key_ref() = key.value();
+    KeyBuffer buf;
+    auto key = getModifiedKey(*req.key_ref(), buf);
+    if (!key) {
+      return t(*target_, req);
     }
+    auto cloneReq = req;
+    cloneReq.key_ref() = key.value();
     return t(*target_, cloneReq);
   }
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    const auto key = getModifiedKey(*req.key_ref());
+    KeyBuffer buf;
+    const auto key = getModifiedKey(*req.key_ref(), buf);
     if (key) {
       return routeReqWithKey(req, key.value());
     }
@@ -101,9 +106,49 @@ class ModifyKeyRoute {
   const folly::Optional<std::string> keyReplace_;
   const std::string keySuffix_;
 
+  // Modified keys up to this size (i.e. all valid memcache keys) are built
+  // on the stack.
+  static constexpr size_t kMaxStackKeySize = 256;
+
+  struct KeyBuffer {
+    char stack[kMaxStackKeySize];
+    std::string heap;
+  };
+
+  /**
+   * Concatenates `pieces` into `buf`, without allocating if they fit on the
+   * stack.
+   */
+  static folly::StringPiece buildKey(
+      KeyBuffer& buf,
+      std::initializer_list<folly::StringPiece> pieces) {
+    size_t size = 0;
+    for (auto piece : pieces) {
+      size += piece.size();
+    }
+    char* out = buf.stack;
+    if (size > sizeof(buf.stack)) {
+      buf.heap.resize(size);
+      out = &buf.heap[0];
+    }
+    char* pos = out;
+    for (auto piece : pieces) {
+      if (!piece.empty()) {
+        std::memcpy(pos, piece.data(), piece.size());
+        pos += piece.size();
+      }
+    }
+    return folly::StringPiece(out, size);
+  }
+
+  /**
+   * @return  the modified key, written to `buf`, or none if the key is left
+   *          as it is.
+   */
   template <class StringLike>
-  folly::Optional<std::string> getModifiedKey(
-      const carbon::Keys<StringLike>& reqKey) const {
+  folly::Optional<folly::StringPiece> getModifiedKey(
+      const carbon::Keys<StringLike>& reqKey,
+      KeyBuffer& buf) const {
     folly::StringPiece rp = routingPrefix_.hasValue() ? routingPrefix_.value()
                                                       : reqKey.routingPrefix();
 
@@ -111,19 +156,17 @@ class ModifyKeyRoute {
         reqKey.keyWithoutRoute().startsWith(keyReplace_.value())) {
       auto keyWithoutRoute = reqKey.keyWithoutRoute();
       keyWithoutRoute.advance(keyReplace_.value().size());
-      return folly::to<std::string>(
-          rp, keyPrefix_, keyWithoutRoute, keySuffix_);
+      return buildKey(buf, {rp, keyPrefix_, keyWithoutRoute, keySuffix_});
     } else if (!reqKey.keyWithoutRoute().startsWith(keyPrefix_)) {
       auto keyWithoutRoute = reqKey.keyWithoutRoute();
       if (modifyInplace_ && keyWithoutRoute.size() >= keyPrefix_.size()) {
         keyWithoutRoute.advance(keyPrefix_.size());
       }
-      return folly::to<std::string>(
-          rp, keyPrefix_, keyWithoutRoute, keySuffix_);
+      return buildKey(buf, {rp, keyPrefix_, keyWithoutRoute, keySuffix_});
     } else if (routingPrefix_.hasValue() && rp != reqKey.routingPrefix()) {
-      return folly::to<std::string>(rp, reqKey.keyWithoutRoute(), keySuffix_);
+      return buildKey(buf, {rp, reqKey.keyWithoutRoute(), keySuffix_});
     } else if (!keySuffix_.empty()) {
-      return folly::to<std::string>(reqKey.fullKey(), keySuffix_);
+      return buildKey(buf, {reqKey.fullKey(), keySuffix_});
     }
     return folly::none;
   }
@@ -140,6 +183,9 @@ class ModifyKeyRoute {
           "ModifyKeyRoute: invalid key: " +
               std::string(mc_req_err_to_string(err)));
     }
+    // The copy shares the value (and every other IOBuf) with req, only the
+    // key is replaced. Keys of up to Keys::kMaxInlineKeySize bytes are stored
+    // inline, so that doesn't allocate either.
     auto cloneReq = req;
     cloneReq.key_ref() = key;
     return target_->route(cloneReq);
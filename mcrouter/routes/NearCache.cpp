@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "NearCache.h"
+
+#include <folly/io/Cursor.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+// Rough per-entry bookkeeping cost (list node, index slot, IOBuf header)
+// so that lots of tiny values can't blow past the byte budget.
+constexpr size_t kEntryOverhead = sizeof(NearCache::Entry) + 64;
+
+} // namespace
+
+NearCache::NearCache(
+    std::chrono::milliseconds ttl,
+    size_t maxBytes,
+    size_t maxValueSize)
+    : ttl_(ttl), maxBytes_(maxBytes), maxValueSize_(maxValueSize) {}
+
+const NearCache::Entry* NearCache::find(
+    folly::StringPiece key,
+    Clock::time_point now) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  auto entryIt = it->second;
+  if (entryIt->expiresAt <= now) {
+    erase(entryIt);
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, entryIt);
+  return &*entryIt;
+}
+
+bool NearCache::insert(
+    folly::StringPiece key,
+    const folly::IOBuf& value,
+    uint64_t flags,
+    Clock::time_point now) {
+  auto valueSize = value.computeChainDataLength();
+  auto entryBytes = key.size() + valueSize + kEntryOverhead;
+  if (valueSize > maxValueSize_ || entryBytes > maxBytes_) {
+    return false;
+  }
+
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    erase(it->second);
+  }
+  while (bytes_ + entryBytes > maxBytes_ && !lru_.empty()) {
+    erase(std::prev(lru_.end()));
+    ++evictions_;
+  }
+
+  lru_.emplace_front();
+  auto& entry = lru_.front();
+  entry.key = key.str();
+  entry.value = folly::IOBuf(folly::IOBuf::CREATE, valueSize);
+  folly::io::Cursor(&value).pull(entry.value.writableData(), valueSize);
+  entry.value.append(valueSize);
+  entry.flags = flags;
+  entry.expiresAt = now + ttl_;
+  entry.bytes = entryBytes;
+
+  index_.emplace(folly::StringPiece(entry.key), lru_.begin());
+  bytes_ += entryBytes;
+  return true;
+}
+
+bool NearCache::invalidate(folly::StringPiece key) {
+  ++epoch_;
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+  erase(it->second);
+  return true;
+}
+
+void NearCache::clear() {
+  ++epoch_;
+  index_.clear();
+  lru_.clear();
+  bytes_ = 0;
+}
+
+void NearCache::erase(List::iterator it) {
+  bytes_ -= it->bytes;
+  index_.erase(folly::StringPiece(it->key));
+  lru_.erase(it);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
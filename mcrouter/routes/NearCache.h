@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Small in-memory LRU cache of get replies, bounded by total bytes and by
+ * a per-entry TTL.
+ *
+ * Not thread-safe: every proxy builds its own route tree, so each
+ * NearCacheRoute (and its NearCache) is only ever touched from one proxy
+ * thread.
+ */
+class NearCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::string key;
+    folly::IOBuf value;
+    uint64_t flags{0};
+    Clock::time_point expiresAt;
+    size_t bytes{0};
+  };
+
+  /**
+   * @param ttl           How long an entry may be served after it was filled.
+   * @param maxBytes      Upper bound on the memory accounted to all entries.
+   * @param maxValueSize  Values larger than this are never cached.
+   */
+  NearCache(
+      std::chrono::milliseconds ttl,
+      size_t maxBytes,
+      size_t maxValueSize);
+
+  NearCache(const NearCache&) = delete;
+  NearCache& operator=(const NearCache&) = delete;
+
+  /**
+   * @return  the live entry for `key` (marking it most recently used), or
+   *          nullptr if there is none or it has expired.
+   */
+  const Entry* find(folly::StringPiece key, Clock::time_point now);
+
+  /**
+   * Stores a private copy of `value`, so that cached entries never pin
+   * network read buffers.
+   *
+   * @return  false if the value is too big to be cached.
+   */
+  bool insert(
+      folly::StringPiece key,
+      const folly::IOBuf& value,
+      uint64_t flags,
+      Clock::time_point now);
+
+  /**
+   * Drops `key` from the cache and bumps the epoch.
+   *
+   * @return  true if an entry was removed.
+   */
+  bool invalidate(folly::StringPiece key);
+
+  /**
+   * Drops every entry and bumps the epoch.
+   */
+  void clear();
+
+  /**
+   * Incremented on every invalidation. A get that snapshots the epoch before
+   * going to the backend must only fill the cache if the epoch is still the
+   * same when the reply arrives, otherwise an update that raced with it could
+   * be shadowed by the stale value.
+   */
+  uint64_t epoch() const {
+    return epoch_;
+  }
+
+  size_t size() const {
+    return index_.size();
+  }
+
+  size_t bytes() const {
+    return bytes_;
+  }
+
+  /**
+   * Number of entries pushed out to make room for new ones.
+   */
+  uint64_t evictions() const {
+    return evictions_;
+  }
+
+ private:
+  using List = std::list<Entry>;
+
+  const std::chrono::milliseconds ttl_;
+  const size_t maxBytes_;
+  const size_t maxValueSize_;
+
+  // Most recently used entries at the front. Keys of `index_` point into
+  // the entries' own key strings, which are stable since list nodes never
+  // move.
+  List lru_;
+  folly::F14FastMap<folly::StringPiece, List::iterator> index_;
+  size_t bytes_{0};
+  uint64_t epoch_{0};
+  uint64_t evictions_{0};
+
+  void erase(List::iterator it);
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
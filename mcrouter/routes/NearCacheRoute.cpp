@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "NearCacheRoute.h"
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/lib/config/RouteHandleFactory.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr int64_t kDefaultTtlMs = 1000;
+constexpr int64_t kDefaultMaxBytes = 8 * 1024 * 1024;
+constexpr int64_t kDefaultMaxValueSize = 16 * 1024;
+
+int64_t parsePositiveInt(
+    const folly::dynamic& json,
+    folly::StringPiece name,
+    int64_t defaultValue) {
+  auto jvalue = json.get_ptr(name);
+  if (!jvalue) {
+    return defaultValue;
+  }
+  checkLogic(jvalue->isInt(), "NearCacheRoute: {} is not an integer", name);
+  checkLogic(jvalue->getInt() > 0, "NearCacheRoute: {} must be positive", name);
+  return jvalue->getInt();
+}
+
+} // namespace
+
+McrouterRouteHandlePtr makeNearCacheRoute(
+    RouteHandleFactory<McrouterRouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  checkLogic(json.isObject(), "NearCacheRoute should be object");
+  auto jchild = json.get_ptr("child");
+  checkLogic(jchild != nullptr, "NearCacheRoute: no child route");
+
+  auto ttlMs = parsePositiveInt(json, "ttl_ms", kDefaultTtlMs);
+  auto maxBytes = parsePositiveInt(json, "max_bytes", kDefaultMaxBytes);
+  auto maxValueSize =
+      parsePositiveInt(json, "max_value_size", kDefaultMaxValueSize);
+  uint64_t hotKeysMinCount = 0;
+  if (auto jhotKeys = json.get_ptr("hot_keys_min_count")) {
+    checkLogic(
+        jhotKeys->isInt() && jhotKeys->getInt() >= 0,
+        "NearCacheRoute: hot_keys_min_count is not a non-negative integer");
+    hotKeysMinCount = jhotKeys->getInt();
+  }
+
+  return makeMcrouterRouteHandleWithInfo<NearCacheRoute>(
+      factory.create(*jchild),
+      std::chrono::milliseconds(ttlMs),
+      static_cast<size_t>(maxBytes),
+      static_cast<size_t>(maxValueSize),
+      hotKeysMinCount);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <folly/Format.h>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/ProxyBase.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/RequestReplyUtil.h"
+#include "mcrouter/lib/carbon/RoutingGroups.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/routes/McrouterRouteHandle.h"
+#include "mcrouter/routes/NearCache.h"
+#include "mcrouter/stats.h"
+
+namespace folly {
+struct dynamic;
+}
+
+namespace facebook {
+namespace memcache {
+
+template <class RouteHandleIf>
+class RouteHandleFactory;
+
+namespace mcrouter {
+
+/**
+ * Serves hot keys straight from proxy memory.
+ *
+ * get: answered from the local cache if there is a live entry, otherwise
+ *     sent to "child"; hits from "child" fill the cache for "ttl_ms".
+ * gets/lease-get/gat/gats/metaget: always sent to "child", since their
+ *     replies carry per-request state (cas/lease tokens, exptime) that can't
+ *     be reproduced locally.
+ * set/add/delete/incr/decr/etc.: drop the key from the local cache and send
+ *     to "child".
+ * flush_all: clear the local cache and send to "child".
+ *
+ * Only updates passing through this mcrouter instance invalidate the cache;
+ * updates made elsewhere become visible at most "ttl_ms" later, so the TTL
+ * should be kept short. Each proxy has its own cache budget of "max_bytes".
+ *
+ * With "hot_keys_min_count" only keys tracked as hot by the proxy's hot key
+ * sketch are admitted into the cache.
+ */
+template <class RouterInfo>
+class NearCacheRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+  using RouteHandlePtr = typename RouterInfo::RouteHandlePtr;
+
+ public:
+  std::string routeName() const {
+    return folly::sformat(
+        "near-cache|ttl_ms={}|max_bytes={}|max_value_size={}"
+        "|hot_keys_min_count={}",
+        ttl_.count(),
+        maxBytes_,
+        maxValueSize_,
+        hotKeysMinCount_);
+  }
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(*child_, req);
+  }
+
+  NearCacheRoute(
+      RouteHandlePtr child,
+      std::chrono::milliseconds ttl,
+      size_t maxBytes,
+      size_t maxValueSize,
+      uint64_t hotKeysMinCount = 0)
+      : child_(std::move(child)),
+        ttl_(ttl),
+        maxBytes_(maxBytes),
+        maxValueSize_(maxValueSize),
+        hotKeysMinCount_(hotKeysMinCount),
+        cache_(ttl, maxBytes, maxValueSize) {
+    assert(child_ != nullptr);
+  }
+
+  McGetReply route(const McGetRequest& req) {
+    auto key = req.key_ref()->fullKey();
+    if (auto entry = cache_.find(key, NearCache::Clock::now())) {
+      bumpStat(near_cache_hits_stat);
+      McGetReply reply(carbon::Result::FOUND);
+      reply.value_ref() = entry->value.cloneAsValue();
+      reply.flags_ref() = entry->flags;
+      return reply;
+    }
+
+    bumpStat(near_cache_misses_stat);
+    auto epoch = cache_.epoch();
+    auto reply = child_->route(req);
+    // Don't fill if anything was invalidated while the get was in flight:
+    // the reply may predate an update that went through this route.
+    if (*reply.result_ref() == carbon::Result::FOUND &&
+        cache_.epoch() == epoch && shouldAdmit(key)) {
+      auto evictionsBefore = cache_.evictions();
+      const auto* value = carbon::valuePtrUnsafe(reply);
+      if (cache_.insert(
+              key,
+              value ? *value : folly::IOBuf(),
+              *reply.flags_ref(),
+              NearCache::Clock::now())) {
+        bumpStat(near_cache_fills_stat);
+      }
+      bumpStat(near_cache_evictions_stat, cache_.evictions() - evictionsBefore);
+    }
+    return reply;
+  }
+
+  McFlushAllReply route(const McFlushAllRequest& req) {
+    cache_.clear();
+    return child_->route(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::GetLikeT<Request> = 0) const {
+    return child_->route(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::UpdateLikeT<Request> = 0) {
+    return invalidateAndRoute(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::DeleteLikeT<Request> = 0) {
+    return invalidateAndRoute(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::ArithmeticLikeT<Request> = 0) {
+    return invalidateAndRoute(req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(
+      const Request& req,
+      carbon::OtherThanT<
+          Request,
+          carbon::GetLike<>,
+          carbon::UpdateLike<>,
+          carbon::DeleteLike<>,
+          carbon::ArithmeticLike<>> = 0) const {
+    return child_->route(req);
+  }
+
+ private:
+  const RouteHandlePtr child_;
+  const std::chrono::milliseconds ttl_;
+  const size_t maxBytes_;
+  const size_t maxValueSize_;
+  const uint64_t hotKeysMinCount_;
+  NearCache cache_;
+
+  /**
+   * If "hot_keys_min_count" is set, only keys that the proxy's hot key sketch
+   * (see hot_keys_sample_period) has sampled at least that many times are
+   * cached, which keeps one-off keys from churning the cache.
+   */
+  bool shouldAdmit(folly::StringPiece key) const {
+    if (hotKeysMinCount_ == 0) {
+      return true;
+    }
+    auto& ctx = fiber_local<RouterInfo>::getSharedCtx();
+    if (!ctx) {
+      return false;
+    }
+    auto hotKeys = ctx->proxy().hotKeys();
+    return hotKeys && hotKeys->isHot(key, hotKeysMinCount_);
+  }
+
+  template <class Request>
+  ReplyT<Request> invalidateAndRoute(const Request& req) {
+    auto key = req.key_ref()->fullKey();
+    invalidate(key);
+    auto reply = child_->route(req);
+    // Gets issued while the update was in flight may have read and cached
+    // the old value, drop it again now that the update has landed.
+    invalidate(key);
+    return reply;
+  }
+
+  void invalidate(folly::StringPiece key) {
+    if (cache_.invalidate(key)) {
+      bumpStat(near_cache_invalidations_stat);
+    }
+  }
+
+  static void bumpStat(stat_name_t stat, uint64_t amount = 1) {
+    if (amount == 0) {
+      return;
+    }
+    if (auto& ctx = fiber_local<RouterInfo>::getSharedCtx()) {
+      ctx->proxy().stats().increment(stat, amount);
+    }
+  }
+};
+
+McrouterRouteHandlePtr makeNearCacheRoute(
+    RouteHandleFactory<McrouterRouteHandleIf>& factory,
+    const folly::dynamic& json);
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -46,37 +46,40 @@ class OperationSelectorRoute {
       carbon::RequestIdMap<RoutableRequests, RouteHandlePtr> operationPolicies,
       RouteHandlePtr&& defaultPolicy)
       : operationPolicies_(std::move(operationPolicies)),
-        defaultPolicy_(std::move(defaultPolicy)) {}
+        defaultPolicy_(std::move(defaultPolicy)) {
+    using Targets = carbon::RequestIdMap<RoutableRequests, RouteHandleIf*>;
+    for (size_t id = Targets::kMinId; id <= Targets::kMaxId; ++id) {
+      const auto& rh = operationPolicies_.getById(id);
+      targets_.set(id, rh ? rh.get() : defaultPolicy_.get());
+    }
+  }
 
   template <class Request>
   bool traverse(
       const Request& req,
       const RouteHandleTraverser<RouteHandleIf>& t) const {
-    if (const auto& rh =
-            operationPolicies_.template getByRequestType<Request>()) {
+    if (auto* rh = targets_.template getByRequestType<Request>()) {
       return t(*rh, req);
-    } else if (defaultPolicy_) {
-      return t(*defaultPolicy_, req);
     }
     return false;
   }
 
   template <class Request>
   ReplyT<Request> route(const Request& req) const {
-    if (const auto& rh =
-            operationPolicies_.template getByRequestType<Request>()) {
+    if (auto* rh = targets_.template getByRequestType<Request>()) {
       return rh->route(req);
-    } else if (defaultPolicy_) {
-      return defaultPolicy_->route(req);
     }
 
     return ReplyT<Request>();
   }
 
  private:
+  // Own the route handles.
   const carbon::RequestIdMap<RoutableRequests, RouteHandlePtr>
       operationPolicies_;
   const RouteHandlePtr defaultPolicy_;
+  // Operation policy, or the default one, of every operation.
+  carbon::RequestIdMap<RoutableRequests, RouteHandleIf*> targets_;
 };
 
 template <class RouterInfo>
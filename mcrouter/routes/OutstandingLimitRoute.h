@@ -9,6 +9,7 @@
 
 #include <list>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include <folly/Conv.h>
@@ -24,6 +25,7 @@
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/options.h"
+#include "mcrouter/routes/AdaptiveConcurrencyLimit.h"
 
 namespace folly {
 struct dynamic;
@@ -41,6 +43,9 @@ namespace mcrouter {
  * No more than N requests will be allowed to be concurrently processed by child
  * route. All blocked requests will be sent one request per sender id in
  * round-robin fashion to guarantee fairness.
+ *
+ * N is either fixed or adapted to the latency of the child route
+ * (see AdaptiveConcurrencyLimit).
  */
 template <class RouterInfo>
 class OutstandingLimitRoute {
@@ -49,7 +54,11 @@ class OutstandingLimitRoute {
 
  public:
   std::string routeName() const {
-    return folly::to<std::string>("outstanding-limit|limit=", maxOutstanding_);
+    return folly::to<std::string>(
+        "outstanding-limit|",
+        adaptive_ ? "adaptive|" : "",
+        "limit=",
+        limit());
   }
 
   template <class Request>
@@ -64,9 +73,16 @@ class OutstandingLimitRoute {
       size_t maxOutstanding)
       : target_(std::move(target)), maxOutstanding_(maxOutstanding) {}
 
+  OutstandingLimitRoute(
+      std::shared_ptr<RouteHandleIf> target,
+      AdaptiveConcurrencyLimit::Options adaptiveOpts)
+      : target_(std::move(target)),
+        maxOutstanding_(adaptiveOpts.maxLimit),
+        adaptive_(std::in_place, adaptiveOpts) {}
+
   template <class Request>
   ReplyT<Request> route(const Request& req) {
-    if (outstanding_ == maxOutstanding_) {
+    if (outstanding_ >= limit()) {
       auto& ctx = fiber_local<RouterInfo>::getSharedCtx();
       auto senderId = ctx->senderId();
       auto& entry = [&]() -> QueueEntry& {
@@ -92,6 +108,7 @@ class OutstandingLimitRoute {
         waitingSince = nowUs();
       }
       entry.batons.push_back(&baton);
+      ++numWaiting_;
       baton.wait();
       if (waitingSince > 0) {
         if (carbon::GetLike<Request>::value) {
@@ -119,23 +136,18 @@ class OutstandingLimitRoute {
       assert(outstanding_ <= maxOutstanding_);
     }
 
+    int64_t sentAt = adaptive_ ? nowUs() : 0;
+    size_t inflight = outstanding_;
     SCOPE_EXIT {
-      if (!blockedRequests_.empty()) {
-        auto entry = std::move(blockedRequests_.front());
-        blockedRequests_.pop_front();
-
-        assert(!entry->batons.empty());
-
-        entry->batons.front()->post();
-        entry->batons.pop_front();
-
-        if (!entry->batons.empty()) {
-          blockedRequests_.push_back(std::move(entry));
-        } else {
-          senderIdToEntry_.erase(entry->senderId);
-        }
-      } else {
-        outstanding_--;
+      if (adaptive_) {
+        adaptive_->onSample(nowUs() - sentAt, inflight);
+      }
+      // The slot of this request goes to the next blocked one, unless the
+      // limit went down meanwhile.
+      outstanding_--;
+      while (!blockedRequests_.empty() && outstanding_ < limit()) {
+        wakeUpNext();
+        outstanding_++;
       }
     };
 
@@ -145,7 +157,9 @@ class OutstandingLimitRoute {
  private:
   const std::shared_ptr<RouteHandleIf> target_;
   const size_t maxOutstanding_;
+  std::optional<AdaptiveConcurrencyLimit> adaptive_;
   size_t outstanding_{0};
+  size_t numWaiting_{0};
   size_t currentGetReqsWaiting_{0};
   size_t currentUpdateReqsWaiting_{0};
 
@@ -160,6 +174,42 @@ class OutstandingLimitRoute {
 
   std::list<std::unique_ptr<QueueEntry>> blockedRequests_;
   std::unordered_map<size_t, QueueEntry*> senderIdToEntry_;
+
+  size_t limit() const {
+    return adaptive_ ? adaptive_->limit() : maxOutstanding_;
+  }
+
+  void wakeUpNext() {
+    assert(numWaiting_ > 0);
+    --numWaiting_;
+    if (adaptive_ && adaptive_->options().lifo && numWaiting_ >= limit()) {
+      // Overloaded: the oldest requests are likely to time out anyway, serve
+      // the newest one.
+      auto& entry = blockedRequests_.back();
+      assert(!entry->batons.empty());
+      entry->batons.back()->post();
+      entry->batons.pop_back();
+      if (entry->batons.empty()) {
+        senderIdToEntry_.erase(entry->senderId);
+        blockedRequests_.pop_back();
+      }
+      return;
+    }
+
+    auto entry = std::move(blockedRequests_.front());
+    blockedRequests_.pop_front();
+
+    assert(!entry->batons.empty());
+
+    entry->batons.front()->post();
+    entry->batons.pop_front();
+
+    if (!entry->batons.empty()) {
+      blockedRequests_.push_back(std::move(entry));
+    } else {
+      senderIdToEntry_.erase(entry->senderId);
+    }
+  }
 };
 
 template <class RouterInfo>
@@ -170,6 +220,14 @@ std::shared_ptr<typename RouterInfo::RouteHandleIf> makeOutstandingLimitRoute(
       std::move(normalRoute), maxOutstanding);
 }
 
+template <class RouterInfo>
+std::shared_ptr<typename RouterInfo::RouteHandleIf> makeOutstandingLimitRoute(
+    std::shared_ptr<typename RouterInfo::RouteHandleIf> normalRoute,
+    AdaptiveConcurrencyLimit::Options adaptiveOpts) {
+  return makeRouteHandleWithInfo<RouterInfo, OutstandingLimitRoute>(
+      std::move(normalRoute), std::move(adaptiveOpts));
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -8,15 +8,19 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <folly/dynamic.h>
 
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/carbon/TypeList.h"
 #include "mcrouter/lib/fbi/cpp/ParsingUtil.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/routes/OutstandingLimitRoute.h"
 #include "mcrouter/routes/SlowWarmUpRoute.h"
 #include "mcrouter/routes/SlowWarmUpRouteSettings.h"
+#include "mcrouter/routes/SlowWarmUpState.h"
 
 namespace facebook {
 namespace memcache {
@@ -27,6 +31,39 @@ class ProxyBase;
 template <class RouterHandleIf>
 class ExtraRouteHandleProviderIf;
 
+namespace detail {
+
+template <class Requests>
+struct FirstRequest;
+
+template <class Request, class... Requests>
+struct FirstRequest<carbon::List<Request, Requests...>> {
+  using type = Request;
+};
+
+/**
+ * @return  The first server (AccessPoint::toString()) that `route` sends
+ *          requests to, empty if there is none.
+ */
+template <class RouterInfo>
+std::string firstAccessPoint(const typename RouterInfo::RouteHandleIf& route) {
+  std::string result;
+  RouteHandleTraverser<typename RouterInfo::RouteHandleIf> t(
+      nullptr,
+      nullptr,
+      [&result](const AccessPoint& accessPoint, const PoolContext&) {
+        if (result.empty()) {
+          result = accessPoint.toString();
+        }
+        return true;
+      });
+  t(route,
+    typename FirstRequest<typename RouterInfo::RoutableRequests>::type());
+  return result;
+}
+
+} // namespace detail
+
 /**
  * Wraps pool "destinations" with route handles according to config in "json".
  *
@@ -35,6 +72,7 @@ class ExtraRouteHandleProviderIf;
  * @param poolName        The name of the pool that "destinations" belong to.
  * @param json            Json containing basic PoolRoute settings:
  *                           - "max_outstanding" (optional),
+ *                           - "adaptive_outstanding" (optional),
  *                           - "slow_warmup" (optional),
  *                           - "shadows", "shadow_policy" (optional)
  * @param proxy           Instance of ProxyBase.
@@ -64,6 +102,14 @@ std::vector<typename RouterInfo::RouteHandlePtr> wrapPoolDestinations(
         }
       }
 
+      if (auto adaptiveJson = json.get_ptr("adaptive_outstanding")) {
+        AdaptiveConcurrencyLimit::Options opts(*adaptiveJson);
+        for (auto& destination : destinations) {
+          destination = makeOutstandingLimitRoute<RouterInfo>(
+              std::move(destination), opts);
+        }
+      }
+
       if (auto slowWarmUpJson = json.get_ptr("slow_warmup")) {
         checkLogic(
             slowWarmUpJson->isObject(), "slow_warmup must be a json object");
@@ -86,8 +132,18 @@ std::vector<typename RouterInfo::RouteHandlePtr> wrapPoolDestinations(
         }
 
         for (auto& destination : destinations) {
+          // Shared by the proxies, and kept as long as the server is in the
+          // config.
+          std::shared_ptr<const SlowWarmUpState> state;
+          auto server = detail::firstAccessPoint<RouterInfo>(*destination);
+          if (!server.empty()) {
+            state = SlowWarmUpState::getShared(&proxy.router(), server);
+          }
           destination = makeSlowWarmUpRoute<RouterInfo>(
-              std::move(destination), failoverTarget, slowWarmUpSettings);
+              std::move(destination),
+              failoverTarget,
+              slowWarmUpSettings,
+              std::move(state));
         }
       }
 
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/debug/RouteProfiler.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Records the time sampled requests spend in the child route handle in the
+ * proxy's RouteProfiler, under the child's routeName().
+ */
+template <class RouterInfo>
+class ProfilingRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  std::string routeName() const {
+    return "profiling";
+  }
+
+  ProfilingRoute(std::shared_ptr<RouteHandleIf> rh, RouteProfiler& profiler)
+      : rh_(std::move(rh)), name_(rh_->routeName()), profiler_(profiler) {}
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(*rh_, req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    RouteProfiler::Scope scope(profiler_, name_);
+    return rh_->route(req);
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> rh_;
+  const std::string name_;
+  RouteProfiler& profiler_;
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeProfilingRoute(
+    typename RouterInfo::RouteHandlePtr rh,
+    RouteProfiler& profiler) {
+  return makeRouteHandleWithInfo<RouterInfo, ProfilingRoute>(
+      std::move(rh), profiler);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
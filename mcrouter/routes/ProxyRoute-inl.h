@@ -7,9 +7,14 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include <folly/Optional.h>
+#include <folly/dynamic.h>
+#include <folly/fibers/WhenN.h>
 
 #include "mcrouter/Proxy.h"
+#include "mcrouter/ProxyRequestContextTyped.h"
 #include "mcrouter/lib/config/RouteHandleBuilder.h"
 #include "mcrouter/routes/BigValueRoute.h"
 #include "mcrouter/routes/LoggingRoute.h"
@@ -32,8 +37,18 @@ typename RouterInfo::RouteHandlePtr wrapWithBigValueRoute(
   BigValueRouteOptions options(
       routerOpts.big_value_split_threshold,
       routerOpts.big_value_batch_size,
-      routerOpts.big_value_hide_reply_flag);
-  return makeBigValueRoute<RouterInfo>(std::move(ch), std::move(options));
+      routerOpts.big_value_hide_reply_flag,
+      routerOpts.big_value_max_window,
+      routerOpts.big_value_compression_level);
+  std::shared_ptr<const RetryBudget> retryBudget;
+  if (routerOpts.big_value_retry_budget_percent > 0) {
+    retryBudget = RetryBudget::getShared(
+        folly::dynamic::object(
+            "percent", routerOpts.big_value_retry_budget_percent),
+        "BigValueRoute");
+  }
+  return makeBigValueRoute<RouterInfo>(
+      std::move(ch), std::move(options), std::move(retryBudget));
 }
 
 } // namespace detail
@@ -70,12 +85,100 @@ ProxyRoute<RouterInfo>::getAllDestinations() const {
   //
   // Important: keep the shared_ptr alive for the duration of the loop.
   auto config = proxy_.getConfigUnsafe();
+  std::vector<folly::StringPiece> poolNames;
+  poolNames.reserve(config->getPools().size());
   for (auto& it : config->getPools()) {
-    rh.insert(rh.end(), it.second.begin(), it.second.end());
+    poolNames.push_back(it.first);
+  }
+  std::sort(poolNames.begin(), poolNames.end());
+  for (auto poolName : poolNames) {
+    const auto& pool = config->getPools().at(poolName);
+    rh.insert(rh.end(), pool.begin(), pool.end());
   }
   return rh;
 }
 
+template <class RouterInfo>
+template <class Request>
+ReplyT<Request> ProxyRoute<RouterInfo>::routeToAllDestinations(
+    const Request& req) const {
+  auto& ctx = fiber_local<RouterInfo>::getSharedCtx();
+  if (const auto& fanout = ctx->broadcastFanout()) {
+    // Our part of a broadcast another proxy received, which it will reply.
+    routeToSlice(req, *fanout, ctx->broadcastSlice());
+    return ReplyT<Request>(carbon::Result::OK);
+  }
+
+  const auto& opts = proxy_.getRouterOptions();
+  const size_t numSlices =
+      opts.broadcast_spread_proxies && !ctx->recording() ? opts.num_proxies
+                                                         : 1;
+  const size_t ownSlice = numSlices > 1 ? proxy_.getId() : 0;
+  auto fanout = std::make_shared<BroadcastFanout>(numSlices);
+  for (size_t i = 0; i < numSlices; ++i) {
+    if (i == ownSlice) {
+      continue;
+    }
+    auto& other =
+        static_cast<Proxy<RouterInfo>&>(*proxy_.router().getProxyBase(i));
+    if (other.messageQueueFull()) {
+      // Don't block this proxy's thread, send it from here instead.
+      routeToSlice(req, *fanout, i);
+      fanout->sliceDone();
+      continue;
+    }
+    auto sliceCtx = createProxyRequestContext(
+        other,
+        req,
+        [fanout](auto&, const Request&, ReplyT<Request>&& reply) {
+          if (isErrorResult(*reply.result_ref())) {
+            fanout->addSliceError(*reply.result_ref());
+          }
+          fanout->sliceDone();
+        });
+    sliceCtx->setBroadcastSlice(fanout, i);
+    other.sendMessage(ProxyMessage::Type::REQUEST, sliceCtx.release());
+  }
+  routeToSlice(req, *fanout, ownSlice);
+  fanout->sliceDone();
+  fanout->wait();
+  return fanout->template reply<ReplyT<Request>>();
+}
+
+template <class RouterInfo>
+template <class Request>
+void ProxyRoute<RouterInfo>::routeToSlice(
+    const Request& req,
+    BroadcastFanout& fanout,
+    size_t slice) const {
+  const auto destinations = getAllDestinations();
+  const size_t numSlices = fanout.numSlices();
+  const size_t count = destinations.size() > slice
+      ? (destinations.size() - slice + numSlices - 1) / numSlices
+      : 0;
+  const size_t maxOutstanding =
+      proxy_.getRouterOptions().broadcast_max_outstanding;
+  const size_t window =
+      maxOutstanding == 0 ? count : std::min<size_t>(maxOutstanding, count);
+
+  auto& stats = proxy_.stats();
+  stats.increment(broadcast_destinations_pending_stat, count);
+  size_t next = 0;
+  std::vector<std::function<void()>> workers(window, [&]() {
+    while (next < count) {
+      const auto& rh = destinations[slice + numSlices * next++];
+      auto reply = rh->route(req);
+      stats.decrement(broadcast_destinations_pending_stat);
+      stats.increment(broadcast_destinations_sent_count_stat);
+      if (isErrorResult(*reply.result_ref())) {
+        stats.increment(broadcast_destinations_failed_count_stat);
+      }
+      fanout.addResult(*reply.result_ref());
+    }
+  });
+  folly::fibers::collectAll(workers.begin(), workers.end());
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 
+#include "mcrouter/BroadcastFanout.h"
 #include "mcrouter/McrouterFiberContext.h"
 #include "mcrouter/ProxyDestination.h"
 #include "mcrouter/ProxyDestinationMap.h"
@@ -18,7 +19,6 @@
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/lib/mc/msg.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
-#include "mcrouter/lib/routes/AllSyncRoute.h"
 #include "mcrouter/routes/BigValueRouteIf.h"
 #include "mcrouter/routes/RouteSelectorMap.h"
 #include "mcrouter/stats.h"
@@ -70,17 +70,37 @@ class ProxyRoute {
 
   McFlushAllReply route(const McFlushAllRequest& req) const {
     // route to all destinations in the config.
-    return AllSyncRoute<typename RouterInfo::RouteHandleIf>(
-               getAllDestinations())
-        .route(req);
+    return routeToAllDestinations(req);
   }
 
  private:
   Proxy<RouterInfo>& proxy_;
   std::shared_ptr<typename RouterInfo::RouteHandleIf> root_;
 
+  /**
+   * All destinations of the config, pools sorted by name so that every
+   * proxy lists them in the same order.
+   */
   std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>
   getAllDestinations() const;
+
+  /**
+   * Sends `req` to every destination, at most broadcast_max_outstanding at
+   * a time per proxy, and with broadcast_spread_proxies split across all
+   * proxies. Replies with the "most awful" reply.
+   */
+  template <class Request>
+  ReplyT<Request> routeToAllDestinations(const Request& req) const;
+
+  /**
+   * Sends `req` to every fanout.numSlices()-th destination starting from
+   * the `slice`-th one, adding the results to `fanout`.
+   */
+  template <class Request>
+  void routeToSlice(
+      const Request& req,
+      BroadcastFanout& fanout,
+      size_t slice) const;
 };
 
 } // namespace mcrouter
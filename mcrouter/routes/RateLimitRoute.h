@@ -7,9 +7,14 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
+#include <folly/Range.h>
+
 #include "mcrouter/lib/Reply.h"
 #include "mcrouter/lib/RouteHandleTraverser.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
@@ -27,9 +32,31 @@ class RouteHandleFactory;
 
 namespace mcrouter {
 
+/**
+ * Per client and per key prefix limits of a RateLimitRoute, checked before
+ * the limits of the route itself: a request goes through only if it's
+ * within all of them.
+ */
+struct RateLimitRouteKeyedLimits {
+  /**
+   * @return  Identity of the client of the request being routed, empty if
+   *          unknown (such requests are only subject to the other limits).
+   */
+  using ClientIdFunc = std::function<folly::StringPiece()>;
+
+  std::optional<KeyedRateLimiter> perClient;
+  ClientIdFunc clientId;
+
+  std::optional<KeyedRateLimiter> perKeyPrefix;
+  // The prefix of a key goes up to the first delimiter included. Keys
+  // without the delimiter share a limiter.
+  std::string keyPrefixDelimiter{":"};
+};
+
 /**
  * Requests sent through this route will be rate limited according
- * to settings in the RateLimiter passed to the constructor.
+ * to settings in the RateLimiter passed to the constructor, and optionally
+ * per client and per key prefix (see RateLimitRouteKeyedLimits).
  *
  * See comments in TokenBucket.h for algorithm details.
  */
@@ -38,6 +65,12 @@ class RateLimitRoute {
  public:
   std::string routeName() const {
     auto rlStr = rl_.toDebugStr();
+    if (keyed_.perClient) {
+      rlStr += "|per_client:" + keyed_.perClient->toDebugStr();
+    }
+    if (keyed_.perKeyPrefix) {
+      rlStr += "|per_key_prefix:" + keyed_.perKeyPrefix->toDebugStr();
+    }
     if (rlStr.empty()) {
       return "rate-limit";
     }
@@ -56,14 +89,17 @@ class RateLimitRoute {
   RateLimitRoute(
       std::shared_ptr<RouteHandleIf> target,
       RateLimiter rl,
-      std::shared_ptr<RouteHandleIf> fallback)
+      std::shared_ptr<RouteHandleIf> fallback,
+      RateLimitRouteKeyedLimits keyed = {})
       : target_(std::move(target)),
         fallback_(std::move(fallback)),
-        rl_(std::move(rl)) {}
+        rl_(std::move(rl)),
+        keyed_(std::move(keyed)) {}
 
   template <class Request>
   ReplyT<Request> route(const Request& req) {
-    if (FOLLY_LIKELY(rl_.canPassThrough<Request>())) {
+    if (FOLLY_LIKELY(
+            canPassThroughKeyed(req) && rl_.canPassThrough<Request>())) {
       return target_->route(req);
     }
     if (fallback_) {
@@ -76,21 +112,67 @@ class RateLimitRoute {
   const std::shared_ptr<RouteHandleIf> target_;
   const std::shared_ptr<RouteHandleIf> fallback_;
   RateLimiter rl_;
+  RateLimitRouteKeyedLimits keyed_;
+
+  template <class Request>
+  bool canPassThroughKeyed(const Request& req) {
+    if constexpr (
+        carbon::GetLike<Request>::value || carbon::UpdateLike<Request>::value ||
+        carbon::DeleteLike<Request>::value) {
+      if (keyed_.perClient && keyed_.clientId) {
+        const auto client = keyed_.clientId();
+        if (!client.empty() &&
+            !keyed_.perClient->canPassThrough<Request>(client)) {
+          return false;
+        }
+      }
+      if (keyed_.perKeyPrefix) {
+        const auto key = req.key_ref()->routingKey();
+        const auto pos = key.find(keyed_.keyPrefixDelimiter);
+        const auto prefix = pos == folly::StringPiece::npos
+            ? folly::StringPiece()
+            : key.subpiece(0, pos + keyed_.keyPrefixDelimiter.size());
+        if (!keyed_.perKeyPrefix->canPassThrough<Request>(prefix)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
 };
 
 template <class RouteHandleIf>
 std::shared_ptr<RouteHandleIf> createRateLimitRoute(
     std::shared_ptr<RouteHandleIf> normalRoute,
     RateLimiter rateLimiter,
-    std::shared_ptr<RouteHandleIf> fallbackRoute = nullptr) {
+    std::shared_ptr<RouteHandleIf> fallbackRoute = nullptr,
+    RateLimitRouteKeyedLimits keyed = {}) {
   return makeRouteHandle<RouteHandleIf, RateLimitRoute>(
-      std::move(normalRoute), std::move(rateLimiter), std::move(fallbackRoute));
+      std::move(normalRoute),
+      std::move(rateLimiter),
+      std::move(fallbackRoute),
+      std::move(keyed));
 }
 
+/**
+ * Sample json:
+ * {
+ *   "type": "RateLimitRoute",
+ *   "target": "PoolRoute|pool_name",
+ *   "rates": {"gets_rate": 100000},
+ *   "per_client_rates": {"gets_rate": 10000, "max_keys": 1000},
+ *   "per_key_prefix_rates": {"sets_rate": 1000},
+ *   "key_prefix_delimiter": ":"
+ * }
+ * "rates" applies to all requests, see RateLimiter. "per_client_rates" and
+ * "per_key_prefix_rates" (see KeyedRateLimiter) are optional; clients are
+ * identified by `clientId`, per client limits need it.
+ */
 template <class RouteHandleIf>
 std::shared_ptr<RouteHandleIf> makeRateLimitRoute(
     RouteHandleFactory<RouteHandleIf>& factory,
-    const folly::dynamic& json) {
+    const folly::dynamic& json,
+    RateLimitRouteKeyedLimits::ClientIdFunc clientId = nullptr) {
   checkLogic(json.isObject(), "RateLimitRoute is not an object");
   auto jtarget = json.get_ptr("target");
   checkLogic(jtarget, "RateLimitRoute: target not found");
@@ -104,8 +186,28 @@ std::shared_ptr<RouteHandleIf> makeRateLimitRoute(
         "RateLimitRoute: target and fallback are the same");
     fallback = factory.create(*jfallback);
   }
+  RateLimitRouteKeyedLimits keyed;
+  if (auto jclient = json.get_ptr("per_client_rates")) {
+    checkLogic(
+        clientId != nullptr,
+        "RateLimitRoute: per_client_rates is not supported here");
+    keyed.perClient.emplace(*jclient);
+    keyed.clientId = std::move(clientId);
+  }
+  if (auto jprefix = json.get_ptr("per_key_prefix_rates")) {
+    keyed.perKeyPrefix.emplace(*jprefix);
+    if (auto jdelimiter = json.get_ptr("key_prefix_delimiter")) {
+      checkLogic(
+          jdelimiter->isString() && !jdelimiter->getString().empty(),
+          "RateLimitRoute: key_prefix_delimiter is not a non-empty string");
+      keyed.keyPrefixDelimiter = jdelimiter->getString();
+    }
+  }
   return createRateLimitRoute(
-      std::move(target), RateLimiter(*jrates), std::move(fallback));
+      std::move(target),
+      RateLimiter(*jrates),
+      std::move(fallback),
+      std::move(keyed));
 }
 
 } // namespace mcrouter
@@ -44,10 +44,11 @@ asPositiveDoubleDefault(const dynamic& obj, const string& keyName, double def) {
 
 } // namespace
 
-RateLimiter::RateLimiter(const folly::dynamic& json) {
+RateLimiter::RateLimiter(const folly::dynamic& json, bool startFull) {
   checkLogic(json.isObject(), "RateLimiter settings json is not an object");
 
-  auto now = folly::TokenBucket::defaultClockNow();
+  // Buckets fill up from this time on.
+  auto now = startFull ? 0.0 : folly::TokenBucket::defaultClockNow();
 
   if (json.count("gets_rate")) {
     double rate = asPositiveDouble(json, "gets_rate");
@@ -84,6 +85,30 @@ std::string RateLimiter::toDebugStr() const {
   }
   return folly::join('|', pieces);
 }
+
+namespace {
+
+size_t maxKeys(const folly::dynamic& json) {
+  checkLogic(json.isObject(), "RateLimiter settings json is not an object");
+  if (auto jMaxKeys = json.get_ptr("max_keys")) {
+    checkLogic(
+        jMaxKeys->isInt() && jMaxKeys->getInt() > 0,
+        "max_keys is not a positive integer");
+    return jMaxKeys->getInt();
+  }
+  return 10000;
+}
+
+} // namespace
+
+KeyedRateLimiter::KeyedRateLimiter(const folly::dynamic& json)
+    : prototype_(json, /* startFull */ true),
+      maxKeys_(maxKeys(json)),
+      limiters_(maxKeys_) {}
+
+std::string KeyedRateLimiter::toDebugStr() const {
+  return folly::to<string>(prototype_.toDebugStr(), "|max_keys=", maxKeys_);
+}
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -7,8 +7,14 @@
 
 #pragma once
 
+#include <cstdint>
+#include <string>
+
 #include <folly/Optional.h>
+#include <folly/Range.h>
 #include <folly/TokenBucket.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/hash/SpookyHashV2.h>
 
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 
@@ -39,8 +45,10 @@ class RateLimiter {
    *              performed for that operation.
    *              If some *_burst key is missing, burst is set
    *              equal to rate.
+   * @param startFull  If true, a whole burst may go through right away
+   *                   instead of the buckets filling up from empty.
    */
-  explicit RateLimiter(const folly::dynamic& json);
+  explicit RateLimiter(const folly::dynamic& json, bool startFull = false);
 
   template <class Request>
   bool canPassThrough(carbon::GetLikeT<Request> = 0) {
@@ -83,6 +91,44 @@ class RateLimiter {
   folly::Optional<folly::TokenBucket> setsTb_;
   folly::Optional<folly::TokenBucket> deletesTb_;
 };
+
+/**
+ * A RateLimiter with the same settings for every key it's asked about
+ * (e.g. client or key prefix), so that no key can use up the rate of the
+ * others. The json is the same as for RateLimiter, plus "max_keys"
+ * (default 10000): when more keys are seen, the least recently used one is
+ * forgotten, and starts over with a full burst if seen again.
+ *
+ * Keys are tracked by hash, so the rare keys with colliding hashes share a
+ * limiter. Not thread safe: like the route using it, it belongs to a single
+ * proxy.
+ */
+class KeyedRateLimiter {
+ public:
+  explicit KeyedRateLimiter(const folly::dynamic& json);
+
+  template <class Request>
+  bool canPassThrough(folly::StringPiece key) {
+    const auto hash =
+        folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+    auto it = limiters_.find(hash);
+    if (it == limiters_.end()) {
+      it = limiters_.insert(hash, prototype_).first;
+    }
+    return it->second.template canPassThrough<Request>();
+  }
+
+  size_t numKeys() const {
+    return limiters_.size();
+  }
+
+  std::string toDebugStr() const;
+
+ private:
+  const RateLimiter prototype_;
+  const size_t maxKeys_;
+  folly::EvictingCacheMap<uint64_t, RateLimiter> limiters_;
+};
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RetryBudget.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <folly/Conv.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+
+#include "mcrouter/lib/SharedObjectCache.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr uint32_t kDefaultMinRetriesPerSec = 10;
+constexpr uint32_t kDefaultWindowSec = 10;
+
+int64_t nowSec() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+RetryBudget::RetryBudget(
+    double percent,
+    uint32_t minRetriesPerSec,
+    uint32_t windowSec)
+    : ratio_(std::max(percent, 0.0) / 100.0),
+      windowSec_(std::min(std::max<uint32_t>(windowSec, 1), kMaxWindowSec)),
+      minRetries_(static_cast<uint64_t>(minRetriesPerSec) * windowSec_) {}
+
+std::shared_ptr<const RetryBudget> RetryBudget::getShared(
+    const folly::dynamic& json,
+    const folly::dynamic& routeJson) {
+  // Leaked on purpose, so that routes may be destroyed at any time.
+  static auto* budgets = new SharedObjectCache<RetryBudget>();
+  folly::json::serialization_opts opts;
+  opts.sort_keys = true;
+  auto key = folly::to<std::string>(
+      folly::json::serialize(routeJson, opts),
+      '\0',
+      folly::json::serialize(json, opts));
+  return budgets->getOrCreate(std::move(key), [&json]() {
+    checkLogic(json.isObject(), "RetryBudget: config is not an object");
+    auto jPercent = json.get_ptr("percent");
+    checkLogic(jPercent != nullptr, "RetryBudget: percent not found");
+    checkLogic(jPercent->isNumber(), "RetryBudget: percent is not a number");
+    int64_t minRetriesPerSec = kDefaultMinRetriesPerSec;
+    if (auto jMinRetries = json.get_ptr("min_retries_per_sec")) {
+      checkLogic(
+          jMinRetries->isInt(),
+          "RetryBudget: min_retries_per_sec is not an integer");
+      minRetriesPerSec = std::max<int64_t>(jMinRetries->getInt(), 0);
+    }
+    int64_t windowSec = kDefaultWindowSec;
+    if (auto jWindow = json.get_ptr("window_sec")) {
+      checkLogic(jWindow->isInt(), "RetryBudget: window_sec is not an integer");
+      windowSec = std::max<int64_t>(jWindow->getInt(), 1);
+    }
+    return std::make_shared<const RetryBudget>(
+        jPercent->asDouble(),
+        static_cast<uint32_t>(minRetriesPerSec),
+        static_cast<uint32_t>(std::min<int64_t>(windowSec, kMaxWindowSec)));
+  });
+}
+
+RetryBudget::Slot& RetryBudget::currentSlot(int64_t now) const {
+  auto& slot = slots_[now % windowSec_];
+  auto second = slot.second.load(std::memory_order_acquire);
+  if (second != now &&
+      slot.second.compare_exchange_strong(
+          second, now, std::memory_order_acq_rel)) {
+    // We won the race to reuse this slot for the current second.
+    slot.successes.store(0, std::memory_order_relaxed);
+    slot.retries.store(0, std::memory_order_relaxed);
+  }
+  return slot;
+}
+
+void RetryBudget::recordSuccess() const {
+  currentSlot(nowSec()).successes.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool RetryBudget::tryRetry() const {
+  auto now = nowSec();
+  auto& current = currentSlot(now);
+
+  uint64_t successes = 0;
+  uint64_t retries = 0;
+  for (uint32_t i = 0; i < windowSec_; ++i) {
+    const auto& slot = slots_[i];
+    if (slot.second.load(std::memory_order_acquire) > now - windowSec_) {
+      successes += slot.successes.load(std::memory_order_relaxed);
+      retries += slot.retries.load(std::memory_order_relaxed);
+    }
+  }
+  if (retries >= ratio_ * successes + minRetries_) {
+    return false;
+  }
+  current.retries.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace folly {
+struct dynamic;
+} // namespace folly
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Limits retries to a fraction of successful requests over a sliding window,
+ * so that retries can't amplify an outage: once most requests fail, only
+ * `minRetriesPerSec` retries per second are let through.
+ *
+ * A retry is allowed if, over the last `windowSec` seconds,
+ *   retries < percent / 100 * successes + minRetriesPerSec * windowSec.
+ *
+ * Budgets are meant to be shared by all proxies (see getShared()), so all
+ * methods are thread-safe and lock-free. Counters of the window are kept
+ * per second; counting is approximate around the second boundaries.
+ */
+class RetryBudget {
+ public:
+  static constexpr uint32_t kMaxWindowSec = 60;
+
+  RetryBudget(double percent, uint32_t minRetriesPerSec, uint32_t windowSec);
+
+  /**
+   * @param json  Budget configuration; must be an object. Format:
+   *                {
+   *                  "percent": [0..INF],
+   *                  "min_retries_per_sec": [0..INF], (default 10)
+   *                  "window_sec": [1..60] (default 10)
+   *                }
+   * @param routeJson  Config of the route using the budget, so that
+   *                   unrelated routes don't share budgets.
+   *
+   * @return  budget shared by everyone asking for the same `json` and
+   *          `routeJson`.
+   */
+  static std::shared_ptr<const RetryBudget> getShared(
+      const folly::dynamic& json,
+      const folly::dynamic& routeJson);
+
+  void recordSuccess() const;
+
+  /**
+   * Withdraws one retry from the budget.
+   *
+   * @return  false if the budget is exhausted, the retry should not be sent.
+   */
+  bool tryRetry() const;
+
+ private:
+  struct Slot {
+    std::atomic<int64_t> second{-1};
+    std::atomic<uint64_t> successes{0};
+    std::atomic<uint64_t> retries{0};
+  };
+
+  const double ratio_;
+  const uint32_t windowSec_;
+  const uint64_t minRetries_;
+  mutable std::array<Slot, kMaxWindowSec> slots_;
+
+  Slot& currentSlot(int64_t now) const;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
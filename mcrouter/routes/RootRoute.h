@@ -45,6 +45,7 @@ class RootRoute {
             opts_.default_route,
             opts_.send_invalid_route_to_default,
             opts_.enable_route_policy_v2),
+        defaultTargets_(rhMap_.getDefaultTargets()),
         defaultRoute_(opts_.default_route),
         enableDeleteDistribution_(enableDeleteDistribution),
         enableCrossRegionDeleteRpc_(enableCrossRegionDeleteRpc) {}
@@ -122,6 +123,10 @@ class RootRoute {
  private:
   const McrouterOptions& opts_;
   RouteHandleMap<typename RouterInfo::RouteHandleIf> rhMap_;
+  // Targets of requests without a routing prefix, resolved at config load if
+  // they don't depend on the key (see RouteHandleMap::getDefaultTargets()).
+  const std::vector<std::shared_ptr<typename RouterInfo::RouteHandleIf>>*
+      defaultTargets_;
   RoutingPrefix defaultRoute_;
   bool enableDeleteDistribution_;
   bool enableCrossRegionDeleteRpc_;
@@ -130,6 +135,9 @@ class RootRoute {
   FOLLY_ALWAYS_INLINE ReplyT<Request> getTargetsAndRoute(
       folly::StringPiece routingPrefix,
       const Request& req) const {
+    if (FOLLY_LIKELY(routingPrefix.empty() && defaultTargets_ != nullptr)) {
+      return routeImpl(*defaultTargets_, req);
+    }
     const auto* rhPtr =
         rhMap_.getTargetsForKeyFast(routingPrefix, req.key_ref()->routingKey());
 
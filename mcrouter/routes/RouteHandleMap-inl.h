@@ -129,6 +129,9 @@ RouteHandleMap<RouteHandleIf>::RouteHandleMap(
 
   assert(byRoute_.find(defaultRoute_) != byRoute_.end());
   defaultRouteMap_ = byRoute_[defaultRoute_];
+  if (!defaultRouteMap_->hasKeyPolicies()) {
+    defaultTargets_ = &defaultRouteMap_->getTargetsForKey("");
+  }
 }
 
 template <class RouteHandleIf>
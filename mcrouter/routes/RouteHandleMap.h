@@ -54,12 +54,23 @@ class RouteHandleMap {
   FOLLY_NOINLINE std::vector<std::shared_ptr<RouteHandleIf>>
   getTargetsForKeySlow(folly::StringPiece prefix, folly::StringPiece key) const;
 
+  /**
+   * @return  The targets of every request without a routing prefix, if they
+   *          don't depend on the key (no key prefix policies in the default
+   *          route). nullptr otherwise.
+   */
+  const std::vector<std::shared_ptr<RouteHandleIf>>* getDefaultTargets()
+      const {
+    return defaultTargets_;
+  }
+
  private:
   const std::vector<std::shared_ptr<RouteHandleIf>> emptyV_;
   const RoutingPrefix& defaultRoute_;
   bool sendInvalidRouteToDefault_;
   bool enableRoutePolicyV2_;
   std::shared_ptr<RoutePolicyMap<RouteHandleIf>> defaultRouteMap_;
+  const std::vector<std::shared_ptr<RouteHandleIf>>* defaultTargets_{nullptr};
 
   std::shared_ptr<RoutePolicyMap<RouteHandleIf>> allRoutes_;
   folly::StringKeyedUnorderedMap<std::shared_ptr<RoutePolicyMap<RouteHandleIf>>>
@@ -52,6 +52,25 @@ RoutePolicyMap<RouteHandleIf>::RoutePolicyMap(
     const std::vector<std::shared_ptr<PrefixSelectorRoute<RouteHandleIf>>>&
         clusters,
     bool useV2) {
+  for (const auto& cluster : clusters) {
+    if (cluster->policies.begin() != cluster->policies.end()) {
+      hasKeyPolicies_ = true;
+      break;
+    }
+  }
+  if (!useV2) {
+    // With many key prefixes the Trie lookup misses cache on almost every
+    // character, the flat V2 table is faster and a lot smaller.
+    size_t numPolicies = 0;
+    for (const auto& cluster : clusters) {
+      for (auto it = cluster->policies.begin();
+           it != cluster->policies.end() && numPolicies < kV2MinPolicies;
+           ++it) {
+        ++numPolicies;
+      }
+    }
+    useV2 = numPolicies >= kV2MinPolicies;
+  }
   if (useV2) {
     v2_ = RoutePolicyMapV2<RouteHandleIf>(clusters);
     return;
@@ -83,9 +83,15 @@ class RoutePolicyMapV2 {
   LBRouteMap ut_;
 };
 
+/**
+ * Uses RoutePolicyMapV2 if `useV2` is set or if the clusters have at least
+ * kV2MinPolicies key prefix policies in total, the Trie otherwise.
+ */
 template <class RouteHandleIf>
 class RoutePolicyMap {
  public:
+  static constexpr size_t kV2MinPolicies = 256;
+
   explicit RoutePolicyMap(
       const std::vector<std::shared_ptr<PrefixSelectorRoute<RouteHandleIf>>>&
           clusters,
@@ -98,7 +104,16 @@ class RoutePolicyMap {
   const std::vector<std::shared_ptr<RouteHandleIf>>& getTargetsForKey(
       folly::StringPiece key) const;
 
+  /**
+   * @return  true if the targets depend on the key, i.e. some cluster has
+   *          key prefix policies.
+   */
+  bool hasKeyPolicies() const {
+    return hasKeyPolicies_;
+  }
+
  private:
+  bool hasKeyPolicies_{false};
   RoutePolicyMapV2<RouteHandleIf> v2_;
   const std::vector<std::shared_ptr<RouteHandleIf>> emptyV_;
   /**
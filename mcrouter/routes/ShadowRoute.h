@@ -153,8 +153,17 @@ class ShadowRoute {
       return settings->shouldShadowKey(req, bucketId);
     }
 
-    return settings->shouldShadow(
-        req, bucketId, ctx->proxy().randomGenerator());
+    if (!settings->shouldShadow(
+            req, bucketId, ctx->proxy().randomGenerator())) {
+      return false;
+    }
+    if (auto* throttle = ctx->proxy().shadowThrottle()) {
+      if (!throttle->admit()) {
+        ctx->proxy().stats().increment(shadow_requests_shed_stat);
+        return false;
+      }
+    }
+    return true;
   }
 
   template <class Request>
@@ -97,9 +97,13 @@ void ShadowSettings::setKeyRange(double start, double end) {
   uint64_t keyEnd = end * std::numeric_limits<uint32_t>::max();
   keyRange_ = (keyStart << 32UL) | keyEnd;
   if (totalBuckets_ > 0) {
-    bucketRange_ = {
-        static_cast<uint64_t>(start * (totalBuckets_ - 1)),
-        static_cast<uint64_t>(end * (totalBuckets_ - 1))};
+    checkLogic(
+        totalBuckets_ <= std::numeric_limits<uint32_t>::max(),
+        "too many buckets for ShadowSettings: {}",
+        totalBuckets_);
+    uint64_t bucketStart = start * (totalBuckets_ - 1);
+    uint64_t bucketEnd = end * (totalBuckets_ - 1);
+    bucketRange_ = (bucketStart << 32UL) | bucketEnd;
   }
 }
 
@@ -77,7 +77,8 @@ class ShadowSettings {
     uint64_t end;
   };
   BucketRange bucketRange() const {
-    return bucketRange_.load();
+    auto range = bucketRange_.load();
+    return {range >> 32, range & ((1UL << 32) - 1)};
   }
 
   void setTotalBuckets(size_t totalBuckets) {
@@ -140,7 +141,7 @@ class ShadowSettings {
     }
 
     if (bucketId) {
-      auto bucketRange = bucketRange_.load();
+      auto bucketRange = this->bucketRange();
       return bucketRange.start <= *bucketId && *bucketId <= bucketRange.end;
     }
     auto range = keyRange();
@@ -170,7 +171,9 @@ class ShadowSettings {
 
   std::atomic<uint64_t> keyRange_{0};
 
-  std::atomic<BucketRange> bucketRange_{{.start = 1, .end = 0}};
+  // [start, end] packed like keyRange_. A 16 byte std::atomic<BucketRange>
+  // isn't lock free: every request read it through libatomic's locks.
+  std::atomic<uint64_t> bucketRange_{1UL << 32};
   size_t totalBuckets_{0};
 
   bool validateReplies_{false};
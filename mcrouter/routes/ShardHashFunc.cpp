@@ -46,15 +46,8 @@ bool ConstShardHashFunc::shardLookup(folly::StringPiece key, size_t* result)
   if (!getShardId(key, shard)) {
     return false;
   }
-  for (const auto& iter : shard) {
-    if (!isdigit(iter)) {
-      return false;
-    }
-  }
   size_t index;
-  try {
-    index = folly::to<size_t>(shard);
-  } catch (...) {
+  if (!parseShardIdNumber(shard, index)) {
     return false;
   }
 
@@ -9,6 +9,8 @@
 
 #include <string>
 
+#include <folly/Conv.h>
+#include <folly/Likely.h>
 #include <folly/Range.h>
 
 #include "mcrouter/lib/Ch3HashFunc.h"
@@ -28,6 +30,8 @@ namespace mcrouter {
  *                           ^^^^^^
  *                           shardId
  *
+ * Both colons are found with qfind, which is vectorized (memchr).
+ *
  * @param [in] key Any string
  * @param [out] shardId Subpiece of original key
  *
@@ -36,6 +40,45 @@ namespace mcrouter {
  */
 bool getShardId(folly::StringPiece key, folly::StringPiece& shardId);
 
+/**
+ * Parses a shard id made of decimal digits only (no sign, no whitespace).
+ *
+ * This is on the request path, so it's a single pass over the digits that
+ * never throws, unlike folly::to.
+ *
+ * @return false if shardId is empty, has a non-digit character or overflows.
+ */
+inline bool parseShardIdNumber(folly::StringPiece shardId, size_t& result) {
+  // Any 19 digits number fits into 64 bits.
+  constexpr size_t kMaxSafeDigits = 19;
+  if (shardId.empty()) {
+    return false;
+  }
+  if (FOLLY_UNLIKELY(shardId.size() > kMaxSafeDigits)) {
+    for (auto c : shardId) {
+      if (c < '0' || c > '9') {
+        return false;
+      }
+    }
+    auto value = folly::tryTo<size_t>(shardId);
+    if (!value) {
+      return false;
+    }
+    result = *value;
+    return true;
+  }
+  size_t value = 0;
+  for (auto c : shardId) {
+    unsigned digit = static_cast<unsigned char>(c) - '0';
+    if (digit > 9) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  result = value;
+  return true;
+}
+
 /**
  * Shard hash function for const sharding. This function
  * assumes that the lookup key in the given key is the actual
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "mcrouter/routes/ShardMapFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <folly/Conv.h>
+#include <folly/hash/Checksum.h>
+
+#include "mcrouter/lib/SharedObjectCache.h"
+#include "mcrouter/lib/fbi/cpp/util.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x6d73636d; // "mcsm"
+
+struct Header {
+  uint32_t magic;
+  uint32_t numDestinations;
+  uint64_t numShardIds;
+};
+static_assert(sizeof(Header) == 16, "Unexpected shard map header size");
+
+} // namespace
+
+ShardMapFile::ShardMapFile(const std::string& path, uint32_t expectedChecksum)
+    : mapping_(path.c_str()) {
+  const auto data = mapping_.range();
+  checkLogic(data.size() >= sizeof(Header), "Shard map {} is too short", path);
+  const auto actualChecksum = checksum(folly::StringPiece(data));
+  checkLogic(
+      actualChecksum == expectedChecksum,
+      "Shard map {}: checksum is {}, expected {}",
+      path,
+      actualChecksum,
+      expectedChecksum);
+
+  Header header;
+  std::memcpy(&header, data.data(), sizeof(header));
+  checkLogic(header.magic == kMagic, "{} is not a shard map file", path);
+  checkLogic(
+      (data.size() - sizeof(Header)) / sizeof(uint32_t) ==
+          header.numShardIds,
+      "Shard map {}: size doesn't match {} shard ids",
+      path,
+      header.numShardIds);
+
+  // The mapping is page aligned, so are the indexes.
+  indexes_ = reinterpret_cast<const uint32_t*>(data.data() + sizeof(Header));
+  numShardIds_ = header.numShardIds;
+  numDestinations_ = header.numDestinations;
+  for (uint64_t shard = 0; shard < numShardIds_; ++shard) {
+    if (indexes_[shard] == kNotFound) {
+      continue;
+    }
+    checkLogic(
+        indexes_[shard] < numDestinations_,
+        "Shard map {}: shard {} maps to destination {}, only {} destinations",
+        path,
+        shard,
+        indexes_[shard],
+        numDestinations_);
+    ++size_;
+  }
+}
+
+/* static */ std::string ShardMapFile::build(
+    const std::vector<std::vector<size_t>>& shardsPerDestination) {
+  checkLogic(
+      shardsPerDestination.size() < kNotFound,
+      "Shard map: too many destinations {}",
+      shardsPerDestination.size());
+  uint64_t numShardIds = 0;
+  for (const auto& shards : shardsPerDestination) {
+    for (auto shard : shards) {
+      numShardIds = std::max<uint64_t>(numShardIds, shard + 1);
+    }
+  }
+
+  std::vector<uint32_t> indexes(numShardIds, kNotFound);
+  for (size_t i = 0; i < shardsPerDestination.size(); ++i) {
+    for (auto shard : shardsPerDestination[i]) {
+      if (indexes[shard] == kNotFound) {
+        indexes[shard] = i;
+      }
+    }
+  }
+
+  std::string result(sizeof(Header) + numShardIds * sizeof(uint32_t), '\0');
+  const Header header{
+      kMagic, static_cast<uint32_t>(shardsPerDestination.size()), numShardIds};
+  std::memcpy(&result[0], &header, sizeof(header));
+  if (numShardIds > 0) {
+    std::memcpy(
+        &result[sizeof(Header)],
+        indexes.data(),
+        numShardIds * sizeof(uint32_t));
+  }
+  return result;
+}
+
+/* static */ uint32_t ShardMapFile::checksum(folly::StringPiece data) {
+  return folly::crc32c(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+}
+
+/* static */ std::shared_ptr<const ShardMapFile> ShardMapFile::getShared(
+    const std::string& path,
+    uint32_t checksum) {
+  // Leaked on purpose, so that routes may be destroyed at any time.
+  static auto* files = new SharedObjectCache<ShardMapFile>();
+  return files->getOrCreate(
+      folly::to<std::string>(path, '\0', checksum), [&]() {
+        return std::make_shared<const ShardMapFile>(path, checksum);
+      });
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
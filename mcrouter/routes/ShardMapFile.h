@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+#include <folly/system/MemoryMapping.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Read only map from shard id to destination index, memory mapped from a
+ * prebuilt file, so that large maps don't have to be part of the config.
+ *
+ * File format (little endian):
+ *   uint32_t magic            "mcsm" (0x6d73636d)
+ *   uint32_t numDestinations  number of destinations of the pool
+ *   uint64_t numShardIds      number of entries, i.e. max shard id + 1
+ *   uint32_t indexes[numShardIds]
+ * indexes[shard] is the destination of the shard, or kNotFound (0xffffffff).
+ * build() produces such files. The config references a file by path and
+ * checksum (crc32c of the whole file, see checksum()).
+ */
+class ShardMapFile {
+ public:
+  static constexpr uint32_t kNotFound = std::numeric_limits<uint32_t>::max();
+
+  /**
+   * @throws std::logic_error  if the file is invalid or its checksum is not
+   *                           `expectedChecksum`.
+   * @throws std::system_error if the file can't be mapped.
+   */
+  ShardMapFile(const std::string& path, uint32_t expectedChecksum);
+
+  bool contains(size_t shard) const noexcept {
+    return find(shard) != kNotFound;
+  }
+
+  /**
+   * @return  Destination index of the shard, or kNotFound.
+   */
+  uint32_t find(size_t shard) const noexcept {
+    return shard < numShardIds_ ? indexes_[shard] : kNotFound;
+  }
+
+  /**
+   * Number of present shards.
+   */
+  size_t size() const noexcept {
+    return size_;
+  }
+
+  /**
+   * Number of entries of the file, i.e. max shard id + 1.
+   */
+  size_t capacity() const noexcept {
+    return numShardIds_;
+  }
+
+  uint32_t numDestinations() const noexcept {
+    return numDestinations_;
+  }
+
+  /**
+   * @param shardsPerDestination  For each destination, the shards it serves.
+   *                              A shard served by several destinations is
+   *                              mapped to the first one.
+   * @return  The content of a file mapping those shards.
+   */
+  static std::string build(
+      const std::vector<std::vector<size_t>>& shardsPerDestination);
+
+  /**
+   * @return  The checksum of the file content `data`.
+   */
+  static uint32_t checksum(folly::StringPiece data);
+
+  /**
+   * @return  The file at `path`, mapped once and shared by every route (of
+   *          every proxy and config) referencing it while any of them lives.
+   */
+  static std::shared_ptr<const ShardMapFile> getShared(
+      const std::string& path,
+      uint32_t checksum);
+
+ private:
+  folly::MemoryMapping mapping_;
+  const uint32_t* indexes_{nullptr};
+  uint64_t numShardIds_{0};
+  uint32_t numDestinations_{0};
+  size_t size_{0};
+};
+
+/**
+ * Shard map of a ShardMapFile, with the read only interface of FlatShardMap.
+ * Copies share the mapping. Can be used as the MapType of the
+ * ShardSelectionRoute factory, which then requires 'shards_file'.
+ */
+class MappedShardMap {
+ public:
+  static constexpr uint32_t kNotFound = ShardMapFile::kNotFound;
+
+  explicit MappedShardMap(std::shared_ptr<const ShardMapFile> file)
+      : file_(std::move(file)) {}
+
+  bool contains(size_t shard) const noexcept {
+    return file_->contains(shard);
+  }
+
+  uint32_t find(size_t shard) const noexcept {
+    return file_->find(shard);
+  }
+
+  size_t size() const noexcept {
+    return file_->size();
+  }
+
+  bool empty() const noexcept {
+    return file_->size() == 0;
+  }
+
+  size_t capacity() const noexcept {
+    return file_->capacity();
+  }
+
+ private:
+  std::shared_ptr<const ShardMapFile> file_;
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
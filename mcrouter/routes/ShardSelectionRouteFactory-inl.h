@@ -16,8 +16,10 @@
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
 #include "mcrouter/routes/ErrorRoute.h"
+#include "mcrouter/routes/FlatShardMap.h"
 #include "mcrouter/routes/LatestRoute.h"
 #include "mcrouter/routes/LoadBalancerRoute.h"
+#include "mcrouter/routes/ShardMapFile.h"
 
 namespace facebook {
 namespace memcache {
@@ -64,6 +66,12 @@ inline std::unordered_map<uint32_t, uint32_t> prepareMap(
     size_t /* maxShardId */) {
   return std::unordered_map<uint32_t, uint32_t>(numDistinctShards);
 }
+template <>
+inline FlatShardMap prepareMap(
+    size_t /* numDistinctShards */,
+    size_t maxShardId) {
+  return FlatShardMap(maxShardId);
+}
 
 inline bool containsShard(const std::vector<uint16_t>& vec, size_t shard) {
   return vec.at(shard) != std::numeric_limits<uint16_t>::max();
@@ -73,6 +81,9 @@ inline bool containsShard(
     size_t shard) {
   return (map.find(shard) != map.end());
 }
+inline bool containsShard(const FlatShardMap& map, size_t shard) {
+  return map.contains(shard);
+}
 
 template <class RouterInfo>
 const folly::dynamic& getPoolJson(
@@ -173,6 +184,72 @@ MapType getShardsMap(const folly::dynamic& json, size_t numDestinations) {
   return shardsMap;
 }
 
+/**
+ * Looks for "shards_file" where getShardsJson() looks for "shards".
+ *
+ * @return  The shared shard map file, or nullptr if there's no "shards_file".
+ */
+template <class RouterInfo>
+std::shared_ptr<const ShardMapFile> getShardMapFile(
+    RouteHandleFactory<typename RouterInfo::RouteHandleIf>& factory,
+    const folly::dynamic& json) {
+  const auto& poolJson = getPoolJson<RouterInfo>(factory, json);
+  const auto* fileJson = poolJson.get_ptr("shards_file");
+  if (!fileJson) {
+    fileJson = json.get_ptr("shards_file");
+  }
+  if (!fileJson) {
+    return nullptr;
+  }
+  checkLogic(
+      fileJson->isObject(),
+      "ShardSelectionRoute: 'shards_file' is not an object");
+  const auto* pathJson = fileJson->get_ptr("path");
+  checkLogic(
+      pathJson && pathJson->isString(),
+      "ShardSelectionRoute: 'shards_file.path' not found or not a string");
+  const auto* checksumJson = fileJson->get_ptr("checksum");
+  checkLogic(
+      checksumJson && checksumJson->isInt() && checksumJson->asInt() >= 0 &&
+          checksumJson->asInt() <= std::numeric_limits<uint32_t>::max(),
+      "ShardSelectionRoute: 'shards_file.checksum' not found or not a uint32");
+  return ShardMapFile::getShared(
+      pathJson->getString(), static_cast<uint32_t>(checksumJson->asInt()));
+}
+
+/**
+ * Build a map from shardId -> destinationId out of a shard map file.
+ */
+template <class MapType>
+MapType getShardsMap(std::shared_ptr<const ShardMapFile> file) {
+  checkLogic(
+      file->numDestinations() < std::numeric_limits<uint16_t>::max(),
+      "ShardSelectionRoute: Only up to {} destinations are supported. "
+      "Current number of destinations: {}",
+      std::numeric_limits<uint16_t>::max() - 1,
+      file->numDestinations());
+
+  auto shardsMap = prepareMap<MapType>(
+      file->size(), file->capacity() > 0 ? file->capacity() - 1 : 0);
+  for (size_t shard = 0; shard < file->capacity(); ++shard) {
+    const auto index = file->find(shard);
+    if (index != ShardMapFile::kNotFound) {
+      shardsMap[shard] = index;
+    }
+  }
+  return shardsMap;
+}
+template <>
+inline MappedShardMap getShardsMap(std::shared_ptr<const ShardMapFile> file) {
+  return MappedShardMap(std::move(file));
+}
+template <>
+inline MappedShardMap getShardsMap(
+    const folly::dynamic& /* json */,
+    size_t /* numDestinations */) {
+  throwLogic("ShardSelectionRoute: this route requires 'shards_file'");
+}
+
 template <class RouterInfo>
 using ShardDestinationsMapCustomFn = std::function<
     void(uint32_t, std::vector<typename RouterInfo::RouteHandlePtr>&)>;
@@ -343,17 +420,29 @@ typename RouterInfo::RouteHandlePtr createShardSelectionRoute(
         "ShardSelectionRoute has an empty list of destinations");
   }
 
-  const auto& shardsJson = detail::getShardsJson<RouterInfo>(factory, json);
-  checkLogic(
-      shardsJson.size() == destinations.size(),
-      folly::sformat(
-          "ShardSelectionRoute: 'shards' must have the same number of "
-          "entries as servers in 'pool'. Servers size: {}. Shards size: {}.",
+  auto shardsMap = [&]() {
+    if (auto file = detail::getShardMapFile<RouterInfo>(factory, json)) {
+      checkLogic(
+          file->numDestinations() == destinations.size(),
+          "ShardSelectionRoute: 'shards_file' must have the same number of "
+          "destinations as servers in 'pool'. Servers size: {}. "
+          "Destinations in file: {}.",
           destinations.size(),
-          shardsJson.size()));
+          file->numDestinations());
+      return detail::getShardsMap<MapType>(std::move(file));
+    }
+    const auto& shardsJson = detail::getShardsJson<RouterInfo>(factory, json);
+    checkLogic(
+        shardsJson.size() == destinations.size(),
+        folly::sformat(
+            "ShardSelectionRoute: 'shards' must have the same number of "
+            "entries as servers in 'pool'. Servers size: {}. Shards size: {}.",
+            destinations.size(),
+            shardsJson.size()));
+    return detail::getShardsMap<MapType>(shardsJson, destinations.size());
+  };
 
-  auto selector = ShardSelector(
-      detail::getShardsMap<MapType>(shardsJson, destinations.size()));
+  auto selector = ShardSelector(shardsMap());
 
   typename RouterInfo::RouteHandlePtr outOfRangeDestination = nullptr;
   if (auto outOfRangeJson = json.get_ptr("out_of_range")) {
@@ -13,6 +13,8 @@
 #include <folly/Random.h>
 #include <folly/dynamic.h>
 
+#include "mcrouter/routes/ShardHashFunc.h"
+
 namespace facebook {
 namespace memcache {
 namespace mcrouter {
@@ -47,6 +49,12 @@ std::vector<size_t> parseShardsJsonString(const folly::dynamic& shardsJson) {
   auto shardsStr = shardsJson.stringPiece();
   while (!shardsStr.empty()) {
     auto shardId = shardsStr.split_step(',');
+    size_t shard;
+    if (parseShardIdNumber(shardId, shard)) {
+      shards.push_back(shard);
+      continue;
+    }
+    // Slow path for anything unusual (e.g. whitespace), and error reporting.
     try {
       shards.push_back(folly::to<size_t>(shardId));
     } catch (const std::exception& e) {
@@ -73,15 +73,22 @@ using ChildrenFactoryMap = std::
  * }
  *
  *
+ * Instead of "shards", large maps can be given as a prebuilt file (see
+ * ShardMapFile), which is mapped once and shared by every proxy and config:
+ *   "shards_file": { "path": "/path/to/map", "checksum": 1234567 }
+ *
  * NOTE:
  *  - "shards" and "servers" must have the same number of entries, in exactly
  *    the same order (e.g. shards[5] shows the shards processed by servers[5]).
+ *    The same goes for the destinations of "shards_file".
  *
  * @tparam ShardSelector Class responsible for selecting the shard responsible
  *                       for handling the request. The ShardSelector constructor
  *                       accepts a MapType shardsMap that maps
  *                       shardId -> destinationId.
  * @tparam MapType       C++ type container that maps shardId -> destinationId.
+ *                       With MappedShardMap, the selector reads the mapped
+ *                       "shards_file" directly instead of a copy of it.
  *
  * @param factory               RouteHandleFactory to create destinations.
  * @param json                  JSON object with RouteHandle representation.
@@ -148,6 +155,8 @@ typename RouterInfo::RouteHandlePtr createShardSelectionRoute(
  *                       takes a shardsMap (unordered_map) that maps
  *                       shardId -> destinationIndex.
  * @tparam MapType       C++ type container that maps shardId -> destinationIdx
+ *                       (std::unordered_map<uint32_t, uint32_t> or the
+ *                       denser FlatShardMap).
  *
  * @param factory             The route handle factory.
  * @param json                JSON object with the config of this route handle.
@@ -236,6 +245,8 @@ typename RouterInfo::RouteHandlePtr createEagerShardSelectionRoute(
  *                       takes a shardsMap (unordered_map) that maps
  *                       shardId -> destinationIndex.
  * @tparam MapType       C++ type container that maps shardId -> destinationIdx
+ *                       (std::unordered_map<uint32_t, uint32_t> or the
+ *                       denser FlatShardMap).
  *
  * @param factory             The route handle factory.
  * @param json                JSON object with the config of this route handle.
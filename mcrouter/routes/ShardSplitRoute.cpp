@@ -7,6 +7,9 @@
 
 #include "ShardSplitRoute.h"
 
+#include <cassert>
+#include <cstring>
+
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 
 namespace facebook {
@@ -43,6 +46,20 @@ std::string createSplitKey(
   return newKey;
 }
 
+size_t writeSplitKey(
+    char* out,
+    folly::StringPiece fullKey,
+    size_t offset,
+    folly::StringPiece shard) {
+  assert(offset > 0);
+  auto prefixSize = shard.end() - fullKey.begin();
+  std::memcpy(out, fullKey.begin(), prefixSize);
+  out[prefixSize] = 'a' + ((offset - 1) % 26);
+  out[prefixSize + 1] = 'a' + ((offset - 1) / 26);
+  std::memcpy(out + prefixSize + 2, shard.end(), fullKey.end() - shard.end());
+  return fullKey.size() + 2;
+}
+
 } // namespace detail
 
 } // namespace mcrouter
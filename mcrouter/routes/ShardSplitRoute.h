@@ -65,6 +65,18 @@ std::string createSplitKey(
     folly::StringPiece fullKey,
     size_t offset,
     folly::StringPiece shard);
+
+/**
+ * Same as createSplitKey() for offset > 0, but writes the key to 'out', which
+ * must have room for fullKey.size() + 2 bytes.
+ *
+ * @return Size of the new key.
+ */
+size_t writeSplitKey(
+    char* out,
+    folly::StringPiece fullKey,
+    size_t offset,
+    folly::StringPiece shard);
 } // namespace detail
 
 /**
@@ -106,14 +118,18 @@ class ShardSplitRoute {
     auto splitSize = t.options().getSplitSize();
     // use true value for fanoutDeletesEnabled when splitSize is specified
     bool fanoutDeletesEnabled = true;
+    size_t offset = 0;
 
     if (splitSize == 0) {
       // if splitSize is not set in traverser options, get related info from
       // shardSplitter
 
-      auto split = shardSplitter_.getShardSplit(shard);
+      auto& split = shardSplitter_.getShardSplit(shard);
       splitSize = split.getSplitSizeForCurrentHost();
       fanoutDeletesEnabled = split.fanoutDeletesEnabled();
+      offset = split.getSplitOffsetForCurrentHost();
+    } else {
+      offset = globals::hostid() % splitSize;
     }
 
     if (carbon::DeleteLike<Request>::value && fanoutDeletesEnabled) {
@@ -128,13 +144,12 @@ class ShardSplitRoute {
         }
       }
     } else {
-      size_t i = globals::hostid() % splitSize;
       // Note that foreachPossibleClient always calls traverse on a request with
       // no flags set.
-      if (i == 0) {
+      if (offset == 0) {
         return t(*rh_, req);
       }
-      return t(*rh_, splitReq(req, i, shard));
+      return t(*rh_, splitReq(req, offset, shard));
     }
     return false;
   }
@@ -160,7 +175,7 @@ class ShardSplitRoute {
       }
       return rh_->route(req);
     } else {
-      size_t i = globals::hostid() % splitSize;
+      size_t i = split->getSplitOffsetForCurrentHost();
       if (i == 0) {
         return rh_->route(req);
       }
@@ -178,8 +193,15 @@ class ShardSplitRoute {
   Request splitReq(const Request& req, size_t offset, folly::StringPiece shard)
       const {
     auto reqCopy = req;
-    reqCopy.key_ref() =
-        detail::createSplitKey(req.key_ref()->fullKey(), offset, shard);
+    auto fullKey = req.key_ref()->fullKey();
+    // Build the key on the stack, so the key storage is the only allocation.
+    char buf[256];
+    if (offset != 0 && fullKey.size() + 2 <= sizeof(buf)) {
+      reqCopy.key_ref() = folly::StringPiece(
+          buf, detail::writeSplitKey(buf, fullKey, offset, shard));
+    } else {
+      reqCopy.key_ref() = detail::createSplitKey(fullKey, offset, shard);
+    }
     return reqCopy;
   }
 };
@@ -7,7 +7,11 @@
 
 #include "ShardSplitter.h"
 
+#include <algorithm>
+#include <limits>
+
 #include <folly/dynamic.h>
+#include <folly/hash/Hash.h>
 
 #include "mcrouter/lib/fbi/cpp/globals.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
@@ -41,6 +45,37 @@ size_t checkShardSplitSize(
   return static_cast<size_t>(split);
 }
 
+std::vector<uint32_t> parseSplitWeights(
+    const folly::dynamic& json,
+    folly::StringPiece id,
+    size_t newSplit) {
+  std::vector<uint32_t> weights;
+  auto jWeights = json.get_ptr("split_weights");
+  if (!jWeights) {
+    return weights;
+  }
+  checkLogic(
+      jWeights->isArray(),
+      "ShardSplitter: split_weights is not an array for {}",
+      id);
+  checkLogic(
+      jWeights->size() == newSplit,
+      "ShardSplitter: split_weights must have new_split_size entries for {}",
+      id);
+  uint64_t total = 0;
+  for (const auto& jWeight : *jWeights) {
+    checkLogic(
+        jWeight.isInt() && jWeight.asInt() >= 0 &&
+            jWeight.asInt() <= std::numeric_limits<uint16_t>::max(),
+        "ShardSplitter: split_weights for {} should be ints in [0, 65535]",
+        id);
+    weights.push_back(static_cast<uint32_t>(jWeight.asInt()));
+    total += weights.back();
+  }
+  checkLogic(total > 0, "ShardSplitter: split_weights are all 0 for {}", id);
+  return weights;
+}
+
 ShardSplitter::ShardSplitInfo parseSplit(
     const folly::dynamic& json,
     folly::StringPiece id,
@@ -83,16 +118,21 @@ ShardSplitter::ShardSplitInfo parseSplit(
         fanoutDeletesJson.isBool(),
         "ShardSplitter: fanout_deletes is not bool for {}",
         id);
-    if (now > startTime + migrationPeriod || newSplit == oldSplit) {
-      return ShardSplitter::ShardSplitInfo(
-          newSplit, fanoutDeletesJson.asBool());
+    auto weights = parseSplitWeights(json, id, newSplit);
+    if (now > startTime + migrationPeriod ||
+        (newSplit == oldSplit && weights.empty())) {
+      ShardSplitter::ShardSplitInfo split(newSplit, fanoutDeletesJson.asBool());
+      split.setNewSplitWeights(weights);
+      return split;
     } else {
-      return ShardSplitter::ShardSplitInfo(
+      ShardSplitter::ShardSplitInfo split(
           oldSplit,
           newSplit,
           startTime,
           migrationPeriod,
           fanoutDeletesJson.asBool());
+      split.setNewSplitWeights(weights);
+      return split;
     }
   }
   // Should never reach here
@@ -102,27 +142,59 @@ ShardSplitter::ShardSplitInfo parseSplit(
 
 } // namespace
 
-size_t ShardSplitter::ShardSplitInfo::getSplitSizeForCurrentHost() const {
+bool ShardSplitter::ShardSplitInfo::currentHostOnNewSplits() const {
   if (migrating_) {
     auto now = std::chrono::system_clock::now();
     if (now < startTime_) {
-      return oldSplitSize_;
+      return false;
     } else if (now > startTime_ + migrationPeriod_) {
       migrating_ = false;
-      return newSplitSize_;
+      return true;
     } else {
       double point = std::chrono::duration_cast<std::chrono::duration<double>>(
                          now - startTime_)
                          .count() /
           migrationPeriod_.count();
       return globals::hostid() % kHostIdModulo /
-                  static_cast<double>(kHostIdModulo) <
-              point
-          ? newSplitSize_
-          : oldSplitSize_;
+          static_cast<double>(kHostIdModulo) <
+          point;
     }
   }
-  return newSplitSize_;
+  return true;
+}
+
+size_t ShardSplitter::ShardSplitInfo::getSplitSizeForCurrentHost() const {
+  return currentHostOnNewSplits() ? newSplitSize_ : oldSplitSize_;
+}
+
+size_t ShardSplitter::ShardSplitInfo::getSplitOffsetForCurrentHost() const {
+  if (!currentHostOnNewSplits()) {
+    return globals::hostid() % oldSplitSize_;
+  }
+  if (cumulativeWeights_.empty()) {
+    return globals::hostid() % newSplitSize_;
+  }
+  // Mix the host id, so that the choice of split is independent from the
+  // migration point of the host.
+  auto point = folly::hash::twang_mix64(globals::hostid()) %
+      cumulativeWeights_.back();
+  return std::upper_bound(
+             cumulativeWeights_.begin(), cumulativeWeights_.end(), point) -
+      cumulativeWeights_.begin();
+}
+
+void ShardSplitter::ShardSplitInfo::setNewSplitWeights(
+    const std::vector<uint32_t>& weights) {
+  cumulativeWeights_.clear();
+  if (weights.empty()) {
+    return;
+  }
+  assert(weights.size() == newSplitSize_);
+  uint32_t total = 0;
+  for (auto weight : weights) {
+    total += weight;
+    cumulativeWeights_.push_back(total);
+  }
 }
 
 ShardSplitter::ShardSplitter(
@@ -148,7 +220,7 @@ ShardSplitter::ShardSplitter(
     folly::StringPiece shardId = it.first.getString();
     const auto split = parseSplit(it.second, shardId, now);
     // Only store if different than the default or is is migrating
-    if (split.hasMigrationConfigured() ||
+    if (split.hasMigrationConfigured() || split.hasSplitWeights() ||
         split.getNewSplitSize() != defaultShardSplit_.getNewSplitSize()) {
       shardSplits_.emplace(shardId, split);
     }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <vector>
 
 #include <folly/Range.h>
 #include <folly/dynamic.h>
@@ -42,6 +43,15 @@ class ShardSplitter {
           fanoutDeletes_(fanoutDeletes),
           migrating_(true) {}
 
+    /**
+     * Makes hosts pick among the new splits in proportion to `weights`
+     * (one per new split) instead of evenly. Hosts still move from the old
+     * splits to the new ones over the migration period, so changing the
+     * weights of a split (e.g. to 0 to drain it) can be rolled out
+     * gradually.
+     */
+    void setNewSplitWeights(const std::vector<uint32_t>& weights);
+
     bool fanoutDeletesEnabled() const {
       return fanoutDeletes_;
     }
@@ -53,6 +63,16 @@ class ShardSplitter {
     }
     size_t getSplitSizeForCurrentHost() const;
 
+    /**
+     * @return  The split this host sends non-fanout requests to, in
+     *          [0, getSplitSizeForCurrentHost()).
+     */
+    size_t getSplitOffsetForCurrentHost() const;
+
+    bool hasSplitWeights() const {
+      return !cumulativeWeights_.empty();
+    }
+
     bool hasMigrationConfigured() const {
       return migrating_;
     }
@@ -64,6 +84,10 @@ class ShardSplitter {
     const std::chrono::duration<double> migrationPeriod_;
     const bool fanoutDeletes_;
     mutable bool migrating_;
+    // Running sums of the new split weights, empty if splits are even.
+    std::vector<uint32_t> cumulativeWeights_;
+
+    bool currentHostOnNewSplits() const;
   };
 
   explicit ShardSplitter(
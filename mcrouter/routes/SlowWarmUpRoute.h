@@ -19,6 +19,7 @@
 #include "mcrouter/lib/carbon/RoutingGroups.h"
 #include "mcrouter/routes/McRouteHandleBuilder.h"
 #include "mcrouter/routes/SlowWarmUpRouteSettings.h"
+#include "mcrouter/routes/SlowWarmUpState.h"
 
 namespace facebook {
 namespace memcache {
@@ -34,8 +35,10 @@ namespace mcrouter {
  * a network roundtrip), so it's purpose is to be used together with a failover
  * route handle.
  *
- * One SlowWarmUpRoute is created for each ProxyDestination, which allows us to
- * keep state related to the destination.
+ * One SlowWarmUpRoute is created for each ProxyDestination. The hit rate and
+ * warm up state of the destination are kept in a SlowWarmUpState shared by
+ * the routes of all the proxies and kept across reconfigures, so warm up
+ * ramps the same on every proxy and doesn't restart on every config push.
  *
  * This route handle is flexible and can be configured via the "settings"
  * property. Bellow is a list of parameters that can be tweaked to adjust
@@ -71,13 +74,25 @@ class SlowWarmUpRoute {
     return "slow-warmup";
   }
 
+  /**
+   * @param state  State of the destination, shared with the routes of the
+   *               other proxies. A new one if null.
+   */
   SlowWarmUpRoute(
       std::shared_ptr<RouteHandleIf> target,
       std::shared_ptr<RouteHandleIf> failoverTarget,
-      std::shared_ptr<SlowWarmUpRouteSettings> settings)
+      std::shared_ptr<SlowWarmUpRouteSettings> settings,
+      std::shared_ptr<const SlowWarmUpState> state = nullptr)
       : target_(std::move(target)),
         failoverTarget_(std::move(failoverTarget)),
-        settings_(std::move(settings)) {}
+        settings_(std::move(settings)),
+        state_(
+            state ? std::move(state)
+                  : std::make_shared<const SlowWarmUpState>()) {}
+
+  ~SlowWarmUpRoute() {
+    state_->add(pending_.hits, pending_.misses);
+  }
 
   template <class Request>
   bool traverse(
@@ -114,45 +129,49 @@ class SlowWarmUpRoute {
   ReplyT<Request> routeImpl(const Request& req) const {
     auto reply = target_->route(req);
     if (isHitResult(*reply.result_ref())) {
-      ++stats_.hits;
+      ++pending_.hits;
     } else if (isMissResult(*reply.result_ref())) {
-      ++stats_.misses;
+      ++pending_.misses;
+    } else {
+      return reply;
+    }
+    if (pending_.hits + pending_.misses >= kMaxPendingResults) {
+      flushPending();
     }
     return reply;
   }
 
  private:
-  struct WarmUpStats {
+  // Results counted locally before adding them to the shared state, so that
+  // the proxies don't all write the same cache line on every request. The
+  // shared hit rate lags by up to this many results per proxy.
+  static constexpr uint64_t kMaxPendingResults = 16;
+
+  struct PendingResults {
     uint64_t hits{0};
     uint64_t misses{0};
-    bool enabled{false};
   };
 
   const std::shared_ptr<RouteHandleIf> target_;
   const std::shared_ptr<RouteHandleIf> failoverTarget_;
   const std::shared_ptr<SlowWarmUpRouteSettings> settings_;
-  mutable WarmUpStats stats_;
+  const std::shared_ptr<const SlowWarmUpState> state_;
+  // Every proxy has its own copy of the route, so this isn't shared.
+  mutable PendingResults pending_;
 
-  bool warmingUp() const {
-    if (stats_.enabled) {
-      stats_.enabled = hitRate() < settings_->disableThreshold();
-    } else {
-      stats_.enabled = hitRate() < settings_->enableThreshold();
-    }
-    return stats_.enabled;
+  void flushPending() const {
+    state_->add(pending_.hits, pending_.misses);
+    pending_ = PendingResults();
   }
 
-  double hitRate() const {
-    uint64_t total = stats_.hits + stats_.misses;
-    if (total < settings_->minRequests()) {
-      return 1.0;
-    }
-    return stats_.hits / static_cast<double>(total);
+  bool warmingUp() const {
+    return state_->warmingUp(*settings_);
   }
 
   template <class RNG>
   bool shouldSendRequest(RNG& rng) const {
-    double target = settings_->start() + (hitRate() * settings_->step());
+    double target =
+        settings_->start() + (state_->hitRate(*settings_) * settings_->step());
     return std::generate_canonical<double, std::numeric_limits<double>::digits>(
                rng) <= target;
   }
@@ -162,9 +181,13 @@ template <class RouterInfo>
 std::shared_ptr<typename RouterInfo::RouteHandleIf> makeSlowWarmUpRoute(
     std::shared_ptr<typename RouterInfo::RouteHandleIf> target,
     std::shared_ptr<typename RouterInfo::RouteHandleIf> failoverTarget,
-    std::shared_ptr<SlowWarmUpRouteSettings> settings) {
+    std::shared_ptr<SlowWarmUpRouteSettings> settings,
+    std::shared_ptr<const SlowWarmUpState> state = nullptr) {
   return makeRouteHandleWithInfo<RouterInfo, SlowWarmUpRoute>(
-      std::move(target), std::move(failoverTarget), std::move(settings));
+      std::move(target),
+      std::move(failoverTarget),
+      std::move(settings),
+      std::move(state));
 }
 
 } // namespace mcrouter
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SlowWarmUpState.h"
+
+#include <folly/Conv.h>
+
+#include "mcrouter/lib/SharedObjectCache.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/* static */ std::shared_ptr<const SlowWarmUpState> SlowWarmUpState::getShared(
+    const void* router,
+    const std::string& key) {
+  // Leaked on purpose, so that routes may be destroyed at any time.
+  static auto* states = new SharedObjectCache<SlowWarmUpState>();
+  return states->getOrCreate(
+      folly::to<std::string>(reinterpret_cast<uintptr_t>(router), '\0', key),
+      []() { return std::make_shared<const SlowWarmUpState>(); });
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
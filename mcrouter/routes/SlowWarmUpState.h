@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "mcrouter/routes/SlowWarmUpRouteSettings.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Hit rate and warm up state of a destination of SlowWarmUpRoute.
+ *
+ * The SlowWarmUpRoutes of every proxy for the same destination share one
+ * state (see getShared()), which outlives reconfigures as long as the new
+ * config still has the destination. Proxies update it with relaxed atomics;
+ * each route batches its counts before adding them (see SlowWarmUpRoute).
+ */
+class SlowWarmUpState {
+ public:
+  void add(uint64_t hits, uint64_t misses) const {
+    if (hits > 0) {
+      hits_.fetch_add(hits, std::memory_order_relaxed);
+    }
+    if (misses > 0) {
+      misses_.fetch_add(misses, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Hit rate, 1 until settings.minRequests() results were added.
+   */
+  double hitRate(const SlowWarmUpRouteSettings& settings) const {
+    const auto hits = hits_.load(std::memory_order_relaxed);
+    const auto total = hits + misses_.load(std::memory_order_relaxed);
+    if (total < settings.minRequests()) {
+      return 1.0;
+    }
+    return hits / static_cast<double>(total);
+  }
+
+  /**
+   * Enters warm up when the hit rate goes below settings.enableThreshold(),
+   * exits it when the hit rate goes above settings.disableThreshold().
+   *
+   * @return  true if the destination is being warmed up.
+   */
+  bool warmingUp(const SlowWarmUpRouteSettings& settings) const {
+    const bool enabled = enabled_.load(std::memory_order_relaxed);
+    const bool nowEnabled = hitRate(settings) <
+        (enabled ? settings.disableThreshold() : settings.enableThreshold());
+    if (nowEnabled != enabled) {
+      enabled_.store(nowEnabled, std::memory_order_relaxed);
+    }
+    return nowEnabled;
+  }
+
+  /**
+   * @return  The state of the destination `key` in `router` (using the same
+   *          key for the same destination of every proxy), created if no
+   *          route uses it yet.
+   */
+  static std::shared_ptr<const SlowWarmUpState> getShared(
+      const void* router,
+      const std::string& key);
+
+ private:
+  mutable std::atomic<uint64_t> hits_{0};
+  mutable std::atomic<uint64_t> misses_{0};
+  mutable std::atomic<bool> enabled_{false};
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
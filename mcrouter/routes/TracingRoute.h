@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/lib/Reply.h"
+#include "mcrouter/lib/RouteHandleTraverser.h"
+#include "mcrouter/lib/config/RouteHandleBuilder.h"
+#include "mcrouter/lib/debug/RequestTracer.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+/**
+ * Records a span, named after the child's routeName(), for the time sampled
+ * requests spend in the child route handle.
+ */
+template <class RouterInfo>
+class TracingRoute {
+ private:
+  using RouteHandleIf = typename RouterInfo::RouteHandleIf;
+
+ public:
+  std::string routeName() const {
+    return "tracing";
+  }
+
+  TracingRoute(std::shared_ptr<RouteHandleIf> rh, RequestTracer& tracer)
+      : rh_(std::move(rh)), name_(rh_->routeName()), tracer_(tracer) {}
+
+  template <class Request>
+  bool traverse(
+      const Request& req,
+      const RouteHandleTraverser<RouteHandleIf>& t) const {
+    return t(*rh_, req);
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& req) const {
+    RequestTracer::Scope scope(
+        tracer_, fiber_local<RouterInfo>::traceContext(), name_);
+    return rh_->route(req);
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> rh_;
+  const std::string name_;
+  RequestTracer& tracer_;
+};
+
+template <class RouterInfo>
+typename RouterInfo::RouteHandlePtr makeTracingRoute(
+    typename RouterInfo::RouteHandlePtr rh,
+    RequestTracer& tracer) {
+  return makeRouteHandleWithInfo<RouterInfo, TracingRoute>(
+      std::move(rh), tracer);
+}
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
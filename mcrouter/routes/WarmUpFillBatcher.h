@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <folly/TokenBucket.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/fibers/WhenN.h>
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcrouter {
+
+struct WarmUpBatchSettings {
+  // Max number of fills sent together; 0 disables batching.
+  size_t maxBatchSize{0};
+  // A batch is sent as soon as its keys and values add up to this size.
+  size_t maxBatchBytes{1024 * 1024};
+  // Max time a fill waits for its batch to fill up. With 0 the batch is sent
+  // as soon as the fiber that started it yields.
+  std::chrono::milliseconds maxDelay{10};
+  // Max number of fills per second; 0 for no limit.
+  double maxFillsPerSec{0};
+};
+
+/**
+ * Accumulates the asynchronous 'add' requests warming up the cold route and
+ * sends them in batches. All the requests of a batch are sent concurrently,
+ * so the ones going to the same cold server are pipelined on its
+ * connection.
+ *
+ * If maxFillsPerSec is set, fills above that rate are dropped. The rate
+ * also adapts to the load of the cold route: it is halved each time more
+ * than 10% of a batch fails, and grows back by 5% of the max rate with
+ * each batch that doesn't.
+ *
+ * Not thread safe, must be used from a single fiber manager.
+ */
+template <class RouteHandleIf>
+class WarmUpFillBatcher
+    : public std::enable_shared_from_this<WarmUpFillBatcher<RouteHandleIf>> {
+ public:
+  WarmUpFillBatcher(
+      std::shared_ptr<RouteHandleIf> cold,
+      WarmUpBatchSettings settings)
+      : cold_(std::move(cold)),
+        settings_(std::move(settings)),
+        fillsPerSec_(settings_.maxFillsPerSec) {}
+
+  void add(McAddRequest req) {
+    if (fillsPerSec_ > 0 &&
+        !rateLimiter_.consume(
+            1.0,
+            fillsPerSec_,
+            std::max(fillsPerSec_, 1.0),
+            folly::DynamicTokenBucket::defaultClockNow())) {
+      ++numDropped_;
+      return;
+    }
+
+    pendingBytes_ += req.key_ref()->fullKey().size() +
+        req.value_ref()->computeChainDataLength();
+    pending_.push_back(std::move(req));
+    if (pending_.size() >= settings_.maxBatchSize ||
+        pendingBytes_ >= settings_.maxBatchBytes) {
+      flush();
+    } else if (!flushScheduled_) {
+      flushScheduled_ = true;
+      folly::fibers::addTask([self = this->shared_from_this()]() {
+        if (self->settings_.maxDelay.count() > 0) {
+          folly::fibers::Baton baton;
+          baton.try_wait_for(self->settings_.maxDelay);
+        }
+        self->flushScheduled_ = false;
+        self->flush();
+      });
+    }
+  }
+
+  double fillsPerSec() const {
+    return fillsPerSec_;
+  }
+
+  uint64_t numDropped() const {
+    return numDropped_;
+  }
+
+ private:
+  const std::shared_ptr<RouteHandleIf> cold_;
+  const WarmUpBatchSettings settings_;
+
+  std::vector<McAddRequest> pending_;
+  size_t pendingBytes_{0};
+  bool flushScheduled_{false};
+
+  folly::DynamicTokenBucket rateLimiter_;
+  double fillsPerSec_;
+  uint64_t numDropped_{0};
+
+  void flush() {
+    if (pending_.empty()) {
+      return;
+    }
+    auto batch = std::make_shared<std::vector<McAddRequest>>();
+    batch->swap(pending_);
+    pendingBytes_ = 0;
+
+    folly::fibers::addTask([self = this->shared_from_this(), batch]() {
+      std::vector<std::function<carbon::Result()>> fills;
+      fills.reserve(batch->size());
+      for (const auto& req : *batch) {
+        fills.emplace_back([&cold = *self->cold_, &req]() {
+          return *cold.route(req).result_ref();
+        });
+      }
+      auto results = folly::fibers::collectAll(fills.begin(), fills.end());
+      self->onBatchDone(results);
+    });
+  }
+
+  void onBatchDone(const std::vector<carbon::Result>& results) {
+    if (settings_.maxFillsPerSec <= 0) {
+      return;
+    }
+    auto numErrors = std::count_if(
+        results.begin(), results.end(), [](carbon::Result result) {
+          return isErrorResult(result);
+        });
+    if (static_cast<size_t>(numErrors) * 10 > results.size()) {
+      fillsPerSec_ =
+          std::max(fillsPerSec_ / 2, settings_.maxFillsPerSec / 100);
+    } else {
+      fillsPerSec_ = std::min(
+          fillsPerSec_ + settings_.maxFillsPerSec / 20,
+          settings_.maxFillsPerSec);
+    }
+  }
+};
+
+} // namespace mcrouter
+} // namespace memcache
+} // namespace facebook
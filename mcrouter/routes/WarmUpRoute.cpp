@@ -21,9 +21,13 @@ namespace mcrouter {
 McrouterRouteHandlePtr makeWarmUpRoute(
     McrouterRouteHandlePtr warm,
     McrouterRouteHandlePtr cold,
-    folly::Optional<uint32_t> exptime) {
+    folly::Optional<uint32_t> exptime,
+    WarmUpBatchSettings batchSettings) {
   return makeMcrouterRouteHandle<WarmUpRoute>(
-      std::move(warm), std::move(cold), std::move(exptime));
+      std::move(warm),
+      std::move(cold),
+      std::move(exptime),
+      std::move(batchSettings));
 }
 
 McrouterRouteHandlePtr makeWarmUpRoute(
@@ -47,10 +51,40 @@ McrouterRouteHandlePtr makeWarmUpRoute(
     exptime = 0;
   }
 
+  WarmUpBatchSettings batchSettings;
+  if (auto jbatchSize = json.get_ptr("fill_batch_size")) {
+    checkLogic(
+        jbatchSize->isInt() && jbatchSize->getInt() >= 0,
+        "WarmUpRoute: fill_batch_size is not a non-negative integer");
+    batchSettings.maxBatchSize = jbatchSize->getInt();
+  }
+  if (auto jbatchBytes = json.get_ptr("fill_batch_bytes")) {
+    checkLogic(
+        jbatchBytes->isInt() && jbatchBytes->getInt() > 0,
+        "WarmUpRoute: fill_batch_bytes is not a positive integer");
+    batchSettings.maxBatchBytes = jbatchBytes->getInt();
+  }
+  if (auto jbatchDelay = json.get_ptr("fill_batch_delay_ms")) {
+    checkLogic(
+        jbatchDelay->isInt() && jbatchDelay->getInt() >= 0,
+        "WarmUpRoute: fill_batch_delay_ms is not a non-negative integer");
+    batchSettings.maxDelay = std::chrono::milliseconds(jbatchDelay->getInt());
+  }
+  if (auto jfillRate = json.get_ptr("fill_rate")) {
+    checkLogic(
+        jfillRate->isNumber() && jfillRate->asDouble() >= 0,
+        "WarmUpRoute: fill_rate is not a non-negative number");
+    checkLogic(
+        batchSettings.maxBatchSize > 0,
+        "WarmUpRoute: fill_rate requires fill_batch_size");
+    batchSettings.maxFillsPerSec = jfillRate->asDouble();
+  }
+
   return makeWarmUpRoute(
       factory.create(json["warm"]),
       factory.create(json["cold"]),
-      std::move(exptime));
+      std::move(exptime),
+      std::move(batchSettings));
 }
 } // namespace mcrouter
 } // namespace memcache
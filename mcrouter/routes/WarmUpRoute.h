@@ -21,6 +21,7 @@
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/routes/McrouterRouteHandle.h"
 #include "mcrouter/routes/RoutingUtils.h"
+#include "mcrouter/routes/WarmUpFillBatcher.h"
 
 namespace facebook {
 namespace memcache {
@@ -58,6 +59,12 @@ namespace mcrouter {
  * configured with "exptime" field. If the field is not present and
  * "enable_metaget" is true, exptime is fetched from "warm" on every update
  * operation with additional 'metaget' request.
+ *
+ * The asynchronous 'add' requests of gets can be batched and rate limited
+ * (see WarmUpFillBatcher), to warm up a new cold pool faster without
+ * overloading it: "fill_batch_size" enables batching, "fill_batch_bytes"
+ * and "fill_batch_delay_ms" bound the size and the wait of a batch, and
+ * "fill_rate" caps the number of fills per second.
  */
 template <class RouteHandleIf>
 class WarmUpRoute {
@@ -79,12 +86,17 @@ class WarmUpRoute {
   WarmUpRoute(
       std::shared_ptr<RouteHandleIf> warm,
       std::shared_ptr<RouteHandleIf> cold,
-      folly::Optional<uint32_t> exptime)
+      folly::Optional<uint32_t> exptime,
+      WarmUpBatchSettings batchSettings = WarmUpBatchSettings())
       : warm_(std::move(warm)),
         cold_(std::move(cold)),
         exptime_(std::move(exptime)) {
     assert(warm_ != nullptr);
     assert(cold_ != nullptr);
+    if (batchSettings.maxBatchSize > 0) {
+      fillBatcher_ = std::make_shared<WarmUpFillBatcher<RouteHandleIf>>(
+          cold_, std::move(batchSettings));
+    }
   }
 
   //////////////////////////////// get /////////////////////////////////////
@@ -99,12 +111,16 @@ class WarmUpRoute {
     uint32_t exptime = 0;
     if (isHitResult(*warmReply.result_ref()) &&
         getExptimeForCold(req, exptime)) {
-      folly::fibers::addTask(
-          [cold = cold_,
-           addReq = createRequestFromMessage<McAddRequest>(
-               req.key_ref()->fullKey(), warmReply, exptime)]() {
-            cold->route(addReq);
-          });
+      auto addReq = createRequestFromMessage<McAddRequest>(
+          req.key_ref()->fullKey(), warmReply, exptime);
+      if (fillBatcher_) {
+        fillBatcher_->add(std::move(addReq));
+      } else {
+        folly::fibers::addTask(
+            [cold = cold_, addReq = std::move(addReq)]() {
+              cold->route(addReq);
+            });
+      }
     }
     return warmReply;
   }
@@ -224,6 +240,8 @@ class WarmUpRoute {
   const std::shared_ptr<RouteHandleIf> warm_;
   const std::shared_ptr<RouteHandleIf> cold_;
   const folly::Optional<uint32_t> exptime_;
+  // Shared with the fibers sending the batches, which may outlive the route.
+  std::shared_ptr<WarmUpFillBatcher<RouteHandleIf>> fillBatcher_;
 
   template <class Request>
   bool getExptimeForCold(const Request& req, uint32_t& exptime) {
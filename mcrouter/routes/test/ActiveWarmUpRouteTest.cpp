@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/hash/Hash.h>
+
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/ActiveWarmUpRoute.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+using std::make_shared;
+using std::string;
+using std::vector;
+
+TEST(activeWarmUpRouteTest, warmsListedKeys) {
+  auto warm = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"),
+      UpdateRouteTestData(carbon::Result::STORED),
+      DeleteRouteTestData(carbon::Result::DELETED));
+  auto cold = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::NOTFOUND, ""),
+      UpdateRouteTestData(carbon::Result::STORED),
+      DeleteRouteTestData(carbon::Result::NOTFOUND));
+
+  ActiveWarmUpRoute<McrouterRouterInfo>::Settings settings;
+  settings.keys = {"key1", "key2", "key3", "key4"};
+  // Fast enough never to wait between keys.
+  settings.keysPerSec = 1e12;
+  settings.hotKeysLimit = 0;
+  settings.exptime = 100;
+  auto rh = makeMcrouterRouteHandleWithInfo<ActiveWarmUpRoute>(
+      warm->rh, cold->rh, settings);
+
+  // The keys are split among proxies, the test context runs on proxy 0.
+  const auto numProxies =
+      getTestRouter<McrouterRouterInfo>()->opts().num_proxies;
+  vector<string> expected;
+  for (const auto& key : settings.keys) {
+    if (numProxies == 1 || folly::hash::fnv64(key) % numProxies == 0) {
+      expected.push_back(key);
+    }
+  }
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto reply = rh->route(McGetRequest("get"));
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+  });
+  fm.run([]() {});
+
+  EXPECT_EQ(expected, cold->saw_keys);
+  for (auto exptime : cold->sawExptimes) {
+    EXPECT_EQ(100, exptime);
+  }
+  // Regular traffic only goes to warm.
+  EXPECT_EQ("get", warm->saw_keys.front());
+}
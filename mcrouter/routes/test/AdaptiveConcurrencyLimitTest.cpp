@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/routes/AdaptiveConcurrencyLimit.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+AdaptiveConcurrencyLimit::Options makeOptions() {
+  return AdaptiveConcurrencyLimit::Options(folly::dynamic::object(
+      "initial_limit", 20)("min_limit", 2)("max_limit", 200)(
+      "probe_interval", 1000));
+}
+
+void probe(AdaptiveConcurrencyLimit& limit, int64_t rttUs) {
+  for (size_t i = 0; i < 25; ++i) {
+    limit.onSample(rttUs, limit.limit());
+  }
+}
+
+} // namespace
+
+TEST(AdaptiveConcurrencyLimit, options) {
+  auto opts = makeOptions();
+  EXPECT_EQ(20, opts.initialLimit);
+  EXPECT_EQ(2, opts.minLimit);
+  EXPECT_EQ(200, opts.maxLimit);
+  EXPECT_TRUE(opts.lifo);
+
+  EXPECT_THROW(
+      AdaptiveConcurrencyLimit::Options(folly::dynamic::array()),
+      std::logic_error);
+  EXPECT_THROW(
+      AdaptiveConcurrencyLimit::Options(
+          folly::dynamic::object("min_limit", 10)("max_limit", 5)),
+      std::logic_error);
+}
+
+TEST(AdaptiveConcurrencyLimit, startsWithProbe) {
+  AdaptiveConcurrencyLimit limit(makeOptions());
+  EXPECT_EQ(2, limit.limit());
+
+  // Requests queued behind others don't count towards the minimum RTT.
+  for (size_t i = 0; i < 100; ++i) {
+    limit.onSample(100, 10);
+  }
+  EXPECT_EQ(2, limit.limit());
+
+  probe(limit, 100);
+  EXPECT_EQ(20, limit.limit());
+}
+
+TEST(AdaptiveConcurrencyLimit, growsWhileLatencyIsLow) {
+  AdaptiveConcurrencyLimit limit(makeOptions());
+  probe(limit, 100);
+  for (size_t i = 0; i < 500; ++i) {
+    limit.onSample(100, limit.limit());
+  }
+  EXPECT_EQ(200, limit.limit());
+}
+
+TEST(AdaptiveConcurrencyLimit, shrinksWhenLatencyGrows) {
+  AdaptiveConcurrencyLimit limit(makeOptions());
+  probe(limit, 100);
+  for (size_t i = 0; i < 500; ++i) {
+    limit.onSample(1000, limit.limit());
+  }
+  EXPECT_LT(limit.limit(), 10);
+  EXPECT_GE(limit.limit(), 2);
+}
+
+TEST(AdaptiveConcurrencyLimit, ignoresIdleSamples) {
+  AdaptiveConcurrencyLimit limit(makeOptions());
+  probe(limit, 100);
+  for (size_t i = 0; i < 500; ++i) {
+    limit.onSample(1000, 1);
+  }
+  EXPECT_EQ(20, limit.limit());
+}
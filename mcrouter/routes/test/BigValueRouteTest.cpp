@@ -26,3 +26,9 @@ TEST(BigValueRouteTest, bigvalue) {
   facebook::memcache::mcrouter::testBigvalue<
       facebook::memcache::MemcacheRouterInfo>();
 }
+
+TEST(BigValueRouteTest, bigvaluePipelined) {
+  facebook::memcache::mcrouter::testBigvalue<
+      facebook::memcache::MemcacheRouterInfo>(
+      facebook::memcache::mcrouter::BIG_VALUE_ROUTE_TEST_OPTS_WINDOW);
+}
@@ -33,6 +33,11 @@ constexpr BigValueRouteOptions BIG_VALUE_ROUTE_TEST_OPTS_NO_FLAG(
     BIG_VALUE_ROUTE_TEST_THRESHOLD,
     /* batchSize */ 0,
     /* hideReplyFlags */ true);
+constexpr BigValueRouteOptions BIG_VALUE_ROUTE_TEST_OPTS_WINDOW(
+    BIG_VALUE_ROUTE_TEST_THRESHOLD,
+    /* batchSize */ 0,
+    /* hideReplyFlags */ false,
+    /* maxWindow */ 3);
 
 template <class RouterInfo>
 void testSmallvalue() {
@@ -144,7 +149,8 @@ void testBigvalueWithoutFlag() {
 }
 
 template <class RouterInfo>
-void testBigvalue() {
+void testBigvalue(
+    const BigValueRouteOptions& opts = BIG_VALUE_ROUTE_TEST_OPTS) {
   using TestHandle = TestHandleImpl<typename RouterInfo::RouteHandleIf>;
   // for big values, used saw_keys of test route handle to verify that
   // get path and set path saw original key and chunk keys in correct sequesne.
@@ -174,7 +180,7 @@ void testBigvalue() {
   fm.runAll({[&]() {
     { // Test Get Like path with init_reply in corect format
       typename RouterInfo::template RouteHandle<BigValueRoute<RouterInfo>> rh(
-          routeHandles[0], BIG_VALUE_ROUTE_TEST_OPTS);
+          routeHandles[0], opts);
 
       McGetRequest reqGet(keyGet);
 
@@ -201,7 +207,7 @@ void testBigvalue() {
 
     { // Test Get Like path with init_reply_error
       typename RouterInfo::template RouteHandle<BigValueRoute<RouterInfo>> rh(
-          routeHandles[1], BIG_VALUE_ROUTE_TEST_OPTS);
+          routeHandles[1], opts);
 
       McGetRequest reqGet(keyGet);
 
@@ -217,7 +223,7 @@ void testBigvalue() {
 
     { // Test Update Like path with mc_op_set op
       typename RouterInfo::template RouteHandle<BigValueRoute<RouterInfo>> rh(
-          routeHandles[2], BIG_VALUE_ROUTE_TEST_OPTS);
+          routeHandles[2], opts);
 
       std::string bigValue = folly::to<std::string>(
           std::string(BIG_VALUE_ROUTE_TEST_THRESHOLD * (num_chunks / 2), 't'),
@@ -265,7 +271,7 @@ void testBigvalue() {
 
     { // Test Update Like path with mc_op_lease_set op
       typename RouterInfo::template RouteHandle<BigValueRoute<RouterInfo>> rh(
-          routeHandles[3], BIG_VALUE_ROUTE_TEST_OPTS);
+          routeHandles[3], opts);
 
       std::string bigValue = folly::to<std::string>(
           std::string(BIG_VALUE_ROUTE_TEST_THRESHOLD * (num_chunks / 2), 't'),
@@ -296,7 +302,7 @@ void testBigvalue() {
 
     { // Test Update Like path with mc_op_add op
       typename RouterInfo::template RouteHandle<BigValueRoute<RouterInfo>> rh(
-          routeHandles[4], BIG_VALUE_ROUTE_TEST_OPTS);
+          routeHandles[4], opts);
 
       std::string bigValue = folly::to<std::string>(
           std::string(BIG_VALUE_ROUTE_TEST_THRESHOLD * (num_chunks / 2), 't'),
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/BloomFilterRoute.h"
+#include "mcrouter/routes/KeyBloomFilter.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+using folly::test::TemporaryFile;
+using std::make_shared;
+using std::string;
+using std::vector;
+
+namespace {
+
+vector<string> presentKeys() {
+  vector<string> keys;
+  for (int i = 0; i < 100; ++i) {
+    keys.push_back("present" + std::to_string(i));
+  }
+  return keys;
+}
+
+std::shared_ptr<const KeyBloomFilterFile> writeFilter(
+    const TemporaryFile& file,
+    const vector<string>& keys) {
+  auto data = KeyBloomFilter::build(keys, 1 << 16, 7);
+  EXPECT_TRUE(folly::writeFile(data, file.path().c_str()));
+  return make_shared<const KeyBloomFilterFile>(
+      file.path().string(), std::chrono::seconds(60), nullptr);
+}
+
+} // namespace
+
+TEST(KeyBloomFilter, mayContain) {
+  TemporaryFile file("bloom_filter_test");
+  auto filterFile = writeFilter(file, presentKeys());
+  auto filter = filterFile->get();
+  ASSERT_NE(nullptr, filter);
+  EXPECT_EQ(1 << 16, filter->numBits());
+
+  for (const auto& key : presentKeys()) {
+    EXPECT_TRUE(filter->mayContain(key)) << key;
+  }
+  size_t falsePositives = 0;
+  for (int i = 0; i < 1000; ++i) {
+    falsePositives += filter->mayContain("absent" + std::to_string(i));
+  }
+  EXPECT_LT(falsePositives, 5);
+}
+
+TEST(KeyBloomFilter, invalidFile) {
+  TemporaryFile file("bloom_filter_test");
+  EXPECT_TRUE(folly::writeFile(string("not a filter"), file.path().c_str()));
+  EXPECT_ANY_THROW(KeyBloomFilter(file.path().string()));
+
+  auto data = KeyBloomFilter::build(presentKeys(), 1 << 16, 7);
+  data.resize(data.size() / 2);
+  EXPECT_TRUE(folly::writeFile(data, file.path().c_str()));
+  EXPECT_ANY_THROW(KeyBloomFilter(file.path().string()));
+  EXPECT_ANY_THROW(KeyBloomFilterFile(
+      file.path().string(), std::chrono::seconds(60), nullptr));
+}
+
+TEST(bloomFilterRouteTest, missesAbsentKeys) {
+  TemporaryFile file("bloom_filter_test");
+  auto child = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"),
+      UpdateRouteTestData(carbon::Result::STORED),
+      DeleteRouteTestData(carbon::Result::DELETED));
+  auto rh = makeMcrouterRouteHandleWithInfo<BloomFilterRoute>(
+      child->rh, writeFilter(file, presentKeys()));
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto hit = rh->route(McGetRequest("present1"));
+    EXPECT_EQ(carbon::Result::FOUND, *hit.result_ref());
+    EXPECT_EQ("a", carbon::valueRangeSlow(hit).str());
+
+    auto miss = rh->route(McGetRequest("absent"));
+    EXPECT_EQ(carbon::Result::NOTFOUND, *miss.result_ref());
+
+    // Only reads are filtered.
+    McSetRequest set("absent");
+    set.value_ref() = folly::IOBuf::copyBuffer("b");
+    EXPECT_EQ(carbon::Result::STORED, *rh->route(set).result_ref());
+  });
+
+  EXPECT_EQ((vector<string>{"present1", "absent"}), child->saw_keys);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/fibers/Baton.h>
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/CoalescingRoute.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+using std::make_shared;
+using std::string;
+using std::vector;
+
+namespace {
+
+McrouterRouteHandlePtr makeCoalescing(
+    McrouterRouteHandlePtr child,
+    size_t maxWaiters = 10,
+    std::chrono::milliseconds timeout = std::chrono::seconds(10)) {
+  return makeMcrouterRouteHandleWithInfo<CoalescingRoute>(
+      std::move(child), maxWaiters, timeout);
+}
+
+} // namespace
+
+TEST(coalescingRouteTest, concurrentGetsCoalesced) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"));
+  auto rh = makeCoalescing(handle->rh);
+
+  vector<string> values;
+  auto get = [&](string key) {
+    return [&, key]() {
+      auto reply = rh->route(McGetRequest(key));
+      values.push_back(carbon::valueRangeSlow(reply).str());
+    };
+  };
+
+  handle->pause();
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.runAll(
+      {get("key"),
+       get("key"),
+       get("key"),
+       get("other"),
+       [&]() { handle->unpause(); }});
+
+  EXPECT_EQ((vector<string>{"a", "a", "a", "a"}), values);
+  // The second and third get for "key" never went upstream.
+  auto sawKeys = handle->saw_keys;
+  std::sort(sawKeys.begin(), sawKeys.end());
+  EXPECT_EQ((vector<string>{"key", "other"}), sawKeys);
+}
+
+TEST(coalescingRouteTest, maxWaiters) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"));
+  auto rh = makeCoalescing(handle->rh, 1);
+
+  auto get = [&]() { rh->route(McGetRequest("key")); };
+
+  handle->pause();
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.runAll({get, get, get, [&]() { handle->unpause(); }});
+
+  // Leader + one waiter; the third get goes upstream on its own.
+  EXPECT_EQ((vector<string>{"key", "key"}), handle->saw_keys);
+}
+
+TEST(coalescingRouteTest, waiterTimeout) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"));
+  auto rh = makeCoalescing(handle->rh, 10, std::chrono::milliseconds(1));
+
+  auto get = [&]() { rh->route(McGetRequest("key")); };
+
+  handle->pause();
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.runAll(
+      {get, get, [&]() {
+         folly::fibers::Baton baton;
+         baton.try_wait_for(std::chrono::milliseconds(50));
+         handle->unpause();
+       }});
+
+  EXPECT_EQ((vector<string>{"key", "key"}), handle->saw_keys);
+}
+
+TEST(coalescingRouteTest, sequentialGetsNotCoalesced) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"),
+      UpdateRouteTestData(carbon::Result::STORED));
+  auto rh = makeCoalescing(handle->rh);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    rh->route(McGetRequest("key"));
+    rh->route(McSetRequest("key"));
+    rh->route(McGetRequest("key"));
+  });
+  EXPECT_EQ((vector<string>{"get", "set", "get"}), handle->sawOperations);
+}
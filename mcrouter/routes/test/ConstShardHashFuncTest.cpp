@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <limits>
+
 #include <gtest/gtest.h>
 
 #include "mcrouter/routes/ShardHashFunc.h"
@@ -31,3 +33,21 @@ TEST(constShardHashFuncTest, ch3Fallback) {
   EXPECT_EQ(0, func("blah:12c34:meh"));
   EXPECT_EQ(3, func("blah:4:meh"));
 }
+
+TEST(constShardHashFuncTest, parseShardIdNumber) {
+  size_t shard = 42;
+  EXPECT_TRUE(parseShardIdNumber("0", shard));
+  EXPECT_EQ(0, shard);
+  EXPECT_TRUE(parseShardIdNumber("123456", shard));
+  EXPECT_EQ(123456, shard);
+  EXPECT_TRUE(parseShardIdNumber("18446744073709551615", shard));
+  EXPECT_EQ(std::numeric_limits<size_t>::max(), shard);
+
+  shard = 42;
+  EXPECT_FALSE(parseShardIdNumber("", shard));
+  EXPECT_FALSE(parseShardIdNumber("12c34", shard));
+  EXPECT_FALSE(parseShardIdNumber("-1", shard));
+  EXPECT_FALSE(parseShardIdNumber(" 1", shard));
+  EXPECT_FALSE(parseShardIdNumber("18446744073709551616", shard));
+  EXPECT_EQ(42, shard);
+}
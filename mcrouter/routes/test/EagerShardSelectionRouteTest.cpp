@@ -19,6 +19,7 @@
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/options.h"
 #include "mcrouter/routes/AllMajorityRouteFactory.h"
+#include "mcrouter/routes/FlatShardMap.h"
 #include "mcrouter/routes/McRouteHandleProvider.h"
 #include "mcrouter/routes/ShardSelectionRouteFactory.h"
 #include "mcrouter/routes/test/RouteHandleTestBase.h"
@@ -54,6 +55,28 @@ class EagerShardSelector {
   const std::unordered_map<uint32_t, uint32_t> shardsMap_;
 };
 
+class FlatEagerShardSelector {
+ public:
+  explicit FlatEagerShardSelector(FlatShardMap shardsMap)
+      : shardsMap_(std::move(shardsMap)) {}
+
+  std::string type() const {
+    return "flat-shard-selector";
+  }
+
+  template <class Request>
+  size_t select(const Request& req, size_t /* size */) const {
+    auto dest = shardsMap_.find(*req.shardId_ref());
+    if (dest == FlatShardMap::kNotFound) {
+      return std::numeric_limits<size_t>::max();
+    }
+    return dest;
+  }
+
+ private:
+  const FlatShardMap shardsMap_;
+};
+
 class EagerShardSelectionRouteTest
     : public RouteHandleTestBase<HelloGoodbyeRouterInfo> {
  public:
@@ -655,6 +678,80 @@ TEST_F(EagerShardSelectionRouteTest, customJsonmRoute_twice) {
   EXPECT_GE(iterations, 8);
 }
 
+TEST(FlatShardMapTest, basic) {
+  FlatShardMap map(10);
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(11, map.capacity());
+
+  map[3] = 0;
+  map[7] = 1;
+  map[7] = 2;
+  EXPECT_EQ(2, map.size());
+  EXPECT_TRUE(map.contains(3));
+  EXPECT_TRUE(map.contains(7));
+  EXPECT_FALSE(map.contains(0));
+  EXPECT_FALSE(map.contains(11));
+  EXPECT_EQ(0, map.find(3));
+  EXPECT_EQ(2, map.find(7));
+  EXPECT_EQ(FlatShardMap::kNotFound, map.find(4));
+  EXPECT_EQ(FlatShardMap::kNotFound, map.find(1000000));
+
+  map[200] = 5;
+  EXPECT_EQ(3, map.size());
+  EXPECT_EQ(5, map.find(200));
+  EXPECT_FALSE(map.contains(199));
+}
+
+TEST_F(EagerShardSelectionRouteTest, flatShardMap) {
+  constexpr folly::StringPiece kSelectionRouteConfig = R"(
+  {
+    "children_type": "LoadBalancerRoute",
+    "pools": [
+      {
+        "pool": {
+          "type": "Pool",
+          "name": "pool1",
+          "servers": [ "localhost:12345", "localhost:12325" ],
+          "protocol": "caret"
+        },
+        "shards": [
+          "1, 2, 3",
+          "3, 5, 100"
+        ]
+      }
+    ],
+    "children_settings" : {
+      "load_ttl_ms": 1000000,
+      "default_server_load_percent": 99
+    }
+  }
+  )";
+
+  auto rh = createEagerShardSelectionRoute<
+      HelloGoodbyeRouterInfo,
+      FlatEagerShardSelector,
+      FlatShardMap>(rhFactory_, folly::parseJson(kSelectionRouteConfig));
+  ASSERT_TRUE(rh);
+  EXPECT_EQ("selection|flat-shard-selector", rh->routeName());
+
+  GoodbyeRequest req;
+  req.shardId_ref() = 100;
+  size_t iterations = 0;
+  RouteHandleTraverser<HelloGoodbyeRouterInfo::RouteHandleIf> t{
+      [&iterations](const HelloGoodbyeRouterInfo::RouteHandleIf& r) {
+        ++iterations;
+        if (iterations == 1) {
+          EXPECT_EQ(
+              folly::to<std::string>(
+                  "loadbalancer|",
+                  LoadBalancerRoute<HelloGoodbyeRouterInfo>::kWeightedHashing),
+              r.routeName());
+        }
+      }};
+  rh->traverse(req, t);
+  EXPECT_GE(iterations, 1);
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -327,6 +327,35 @@ TEST(failoverRouteTest, rateLimitWithTKO) {
   EXPECT_EQ(carbon::Result::FOUND, *reply4.result_ref());
 }
 
+TEST(failoverRouteTest, sharedRateLimiter) {
+  folly::dynamic limit =
+      folly::dynamic::object("rate", 0.5)("burst", 1)("shared", true);
+  folly::dynamic route = folly::dynamic::object("name", "pool-a");
+  FailoverRateLimiter a(limit, route);
+  FailoverRateLimiter b(limit, route);
+  folly::dynamic otherRoute = folly::dynamic::object("name", "pool-b");
+  FailoverRateLimiter c(limit, otherRoute);
+  ASSERT_TRUE(a.isShared());
+
+  // tokens: 1
+  a.bumpTotalReqs();
+  EXPECT_TRUE(a.failoverAllowed());
+  // tokens: 0.5, the first one was spent by `a`
+  b.bumpTotalReqs();
+  EXPECT_FALSE(b.failoverAllowed());
+  // tokens: 1, requests are counted by both limiters
+  a.bumpTotalReqs();
+  b.bumpTotalReqs();
+  EXPECT_TRUE(b.failoverAllowed());
+  EXPECT_FALSE(a.failoverAllowed());
+
+  // Different route, different bucket.
+  EXPECT_TRUE(c.failoverAllowed());
+
+  limit["shared"] = false;
+  EXPECT_FALSE(FailoverRateLimiter(limit, route).isShared());
+}
+
 TEST(failoverRouteTest, leastFailuresNoFailover) {
   std::vector<std::shared_ptr<TestHandle>> test_handles{
       make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
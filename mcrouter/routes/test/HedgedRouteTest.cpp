@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/HedgedRoute.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+using std::make_shared;
+using std::string;
+using std::vector;
+
+namespace {
+
+McrouterRouteHandlePtr makeHedged(
+    const vector<std::shared_ptr<TestHandle>>& handles) {
+  return makeMcrouterRouteHandleWithInfo<HedgedRoute>(
+      get_route_handles(handles),
+      std::chrono::milliseconds(1),
+      std::chrono::milliseconds(10));
+}
+
+} // namespace
+
+TEST(hedgedRouteTest, fastReplyNotHedged) {
+  vector<std::shared_ptr<TestHandle>> handles{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "b"))};
+  auto rh = makeHedged(handles);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto reply = rh->route(McGetRequest("key"));
+    EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+    EXPECT_EQ(vector<string>{"key"}, handles[0]->saw_keys);
+    EXPECT_TRUE(handles[1]->saw_keys.empty());
+  });
+}
+
+TEST(hedgedRouteTest, slowReplyHedged) {
+  vector<std::shared_ptr<TestHandle>> handles{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "b"))};
+  auto rh = makeHedged(handles);
+
+  handles[0]->pause();
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto reply = rh->route(McGetRequest("key"));
+    EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+    EXPECT_EQ(vector<string>{"key"}, handles[1]->saw_keys);
+    handles[0]->unpause();
+  });
+  EXPECT_EQ(vector<string>{"key"}, handles[0]->saw_keys);
+}
+
+TEST(hedgedRouteTest, errorFailsOver) {
+  vector<std::shared_ptr<TestHandle>> handles{
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::REMOTE_ERROR, "a")),
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "b"))};
+  auto rh = makeHedged(handles);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto reply = rh->route(McGetRequest("key"));
+    EXPECT_EQ(carbon::Result::FOUND, *reply.result_ref());
+    EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+
+    // The failing child is now tried last.
+    reply = rh->route(McGetRequest("key2"));
+    EXPECT_EQ("b", carbon::valueRangeSlow(reply).str());
+    EXPECT_EQ(vector<string>{"key"}, handles[0]->saw_keys);
+  });
+}
+
+TEST(hedgedRouteTest, allErrors) {
+  vector<std::shared_ptr<TestHandle>> handles{
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::REMOTE_ERROR, "a")),
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::REMOTE_ERROR, "b"))};
+  auto rh = makeHedged(handles);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto reply = rh->route(McGetRequest("key"));
+    EXPECT_EQ(carbon::Result::REMOTE_ERROR, *reply.result_ref());
+    EXPECT_EQ(vector<string>{"key"}, handles[0]->saw_keys);
+    EXPECT_EQ(vector<string>{"key"}, handles[1]->saw_keys);
+  });
+}
+
+TEST(hedgedRouteTest, updatesSentToAll) {
+  vector<std::shared_ptr<TestHandle>> handles{
+      make_shared<TestHandle>(UpdateRouteTestData(carbon::Result::STORED)),
+      make_shared<TestHandle>(UpdateRouteTestData(carbon::Result::STORED))};
+  auto rh = makeHedged(handles);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    auto reply = rh->route(McSetRequest("key"));
+    EXPECT_EQ(carbon::Result::STORED, *reply.result_ref());
+  });
+  EXPECT_EQ(vector<string>{"key"}, handles[0]->saw_keys);
+  EXPECT_EQ(vector<string>{"key"}, handles[1]->saw_keys);
+}
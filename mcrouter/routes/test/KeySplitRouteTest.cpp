@@ -6,7 +6,9 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -366,6 +368,124 @@ TEST_F(KeySplitRouteTest, TestLongKey) {
   }
 }
 
+TEST_F(KeySplitRouteTest, LeastLoaded) {
+  globals::HostidMock hostidMock(3);
+  th_ = std::make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"));
+  replicas_ = 5;
+  rh_ = std::make_shared<RouteHandle>(RouteHandle(
+      th_->rh,
+      replicas_,
+      /* allSync */ true,
+      /* firstHit */ false,
+      /* leastLoaded */ true));
+
+  // Nothing in flight: ties go to the replica of this host.
+  for (size_t i = 0; i < 10; ++i) {
+    auto reply = rh_->route(McGetRequest("abc"));
+  }
+  EXPECT_EQ(
+      std::vector<std::string>(10, expectedKey("abc", 3)), th_->saw_keys);
+
+  EXPECT_THROW(
+      makeKeySplitRoute<MemcacheRouterInfo>(
+          rhFactory_,
+          folly::parseJson(R"({
+            "replicas": 5,
+            "all_sync": false,
+            "least_loaded": true,
+            "destination": "NullRoute"
+          })")),
+      std::logic_error);
+}
+
+TEST_F(KeySplitRouteTest, AutoSplit) {
+  th_ = std::make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"),
+      UpdateRouteTestData(carbon::Result::STORED));
+  KeySplitAutoOptions opts;
+  opts.threshold = 3;
+  opts.window = std::chrono::milliseconds(20);
+  rh_ = std::make_shared<RouteHandle>(RouteHandle(
+      th_->rh,
+      3,
+      /* allSync */ true,
+      /* firstHit */ false,
+      /* leastLoaded */ false,
+      opts));
+
+  McSetRequest reqSet("hot");
+  reqSet.value_ref() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+  TestFiberManager<MemcacheRouterInfo> fm;
+
+  // Not hot yet: only the original key.
+  fm.runAll({[&]() {
+    for (size_t i = 0; i < 5; ++i) {
+      auto reply = rh_->route(reqSet);
+    }
+    auto reply = rh_->route(McGetRequest("cold"));
+  }});
+  EXPECT_EQ(
+      std::vector<std::string>({"hot", "hot", "hot", "hot", "hot", "cold"}),
+      th_->saw_keys);
+  th_->saw_keys.clear();
+
+  // Next window: sets and deletes of the hot key go to all replicas.
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  fm.runAll({[&]() { auto reply = rh_->route(reqSet); }});
+  std::sort(th_->saw_keys.begin(), th_->saw_keys.end());
+  EXPECT_EQ(
+      std::vector<std::string>({"hot", "hot::1", "hot::2"}), th_->saw_keys);
+  th_->saw_keys.clear();
+
+  fm.runAll({[&]() { auto reply = rh_->route(McDeleteRequest("hot")); }});
+  std::sort(th_->saw_keys.begin(), th_->saw_keys.end());
+  EXPECT_EQ(
+      std::vector<std::string>({"hot", "hot::1", "hot::2"}), th_->saw_keys);
+  th_->saw_keys.clear();
+
+  // Gets of the hot key hit one of the replicas, cold keys aren't split.
+  fm.runAll({[&]() {
+    auto reply = rh_->route(McGetRequest("hot"));
+    EXPECT_EQ(carbon::Result::FOUND, *reply.result_ref());
+    reply = rh_->route(McGetRequest("cold"));
+  }});
+  ASSERT_EQ(2, th_->saw_keys.size());
+  EXPECT_TRUE(folly::StringPiece(th_->saw_keys[0]).startsWith("hot"));
+  EXPECT_EQ("cold", th_->saw_keys[1]);
+  th_->saw_keys.clear();
+
+  // Cooled down after a window without requests: its replicas are deleted
+  // and it's no longer split.
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  fm.runAll({[&]() { auto reply = rh_->route(McGetRequest("cold")); }});
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  th_->saw_keys.clear();
+  th_->sawOperations.clear();
+  fm.runAll({[&]() { auto reply = rh_->route(reqSet); }});
+  std::sort(th_->saw_keys.begin(), th_->saw_keys.end());
+  EXPECT_EQ(
+      std::vector<std::string>({"hot", "hot::1", "hot::2"}), th_->saw_keys);
+  EXPECT_EQ(
+      std::vector<std::string>({"delete", "delete", "set"}),
+      [&] {
+        auto ops = th_->sawOperations;
+        std::sort(ops.begin(), ops.end());
+        return ops;
+      }());
+
+  EXPECT_THROW(
+      makeKeySplitRoute<MemcacheRouterInfo>(
+          rhFactory_,
+          folly::parseJson(R"({
+            "replicas": 3,
+            "all_sync": false,
+            "auto_split": {"threshold": 10},
+            "destination": "NullRoute"
+          })")),
+      std::logic_error);
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
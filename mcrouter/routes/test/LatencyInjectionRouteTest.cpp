@@ -8,6 +8,7 @@
 #include "mcrouter/routes/LatencyInjectionRoute.h"
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/PoolFactory.h"
+#include "mcrouter/RuntimeVarsData.h"
 #include "mcrouter/lib/carbon/example/gen/HelloGoodbyeRouterInfo.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/routes/McRouteHandleProvider.h"
@@ -158,6 +159,124 @@ TEST_F(LatencyInjectionRouteTest, routeTotal) {
   EXPECT_GE(elapsed.count(), 999);
 }
 
+constexpr folly::StringPiece kLatencyInjectionRouteDistribution = R"(
+{
+  "latency_distribution": {
+    "type": "pareto",
+    "scale_ms": 500,
+    "shape": 1000,
+    "max_ms": 2000
+  },
+  "child": "NullRoute"
+}
+)";
+TEST_F(LatencyInjectionRouteTest, routeDistribution) {
+  testCreate(kLatencyInjectionRouteDistribution);
+  auto rh = getLatencyInjectionRoute(kLatencyInjectionRouteDistribution);
+  ASSERT_TRUE(rh);
+
+  HelloRequest req;
+  HelloReply reply;
+
+  // Pareto samples are at least scale_ms.
+  const auto before_ms = getCurrentTimeInMs();
+  reply = rh->route(req);
+  const auto elapsed =
+      std::chrono::milliseconds(getCurrentTimeInMs() - before_ms);
+  EXPECT_EQ(carbon::Result::NOTFOUND, *reply.result_ref());
+  EXPECT_GE(elapsed.count(), 499);
+  EXPECT_LE(elapsed.count(), 20000);
+}
+
+constexpr folly::StringPiece kLatencyInjectionRouteErrors = R"(
+{
+  "error_rate": 1,
+  "error_result": "mc_res_busy",
+  "child": "NullRoute"
+}
+)";
+TEST_F(LatencyInjectionRouteTest, routeErrors) {
+  auto rh = getLatencyInjectionRoute(kLatencyInjectionRouteErrors);
+  ASSERT_TRUE(rh);
+
+  HelloRequest req;
+  auto reply = rh->route(req);
+  EXPECT_EQ(carbon::Result::BUSY, *reply.result_ref());
+}
+
+TEST_F(LatencyInjectionRouteTest, invalidProfile) {
+  EXPECT_ANY_THROW(getLatencyInjectionRoute(R"(
+    {
+      "latency_distribution": {"type": "uniform", "median_ms": 1},
+      "child": "NullRoute"
+    }
+  )"));
+  EXPECT_ANY_THROW(getLatencyInjectionRoute(R"(
+    {
+      "latency_distribution": {"type": "lognormal", "median_ms": 1},
+      "child": "NullRoute"
+    }
+  )"));
+  EXPECT_ANY_THROW(getLatencyInjectionRoute(R"(
+    {
+      "error_rate": 2,
+      "child": "NullRoute"
+    }
+  )"));
+  // Runtime vars need the router, which makeLatencyInjectionRoute() lacks.
+  EXPECT_ANY_THROW(getLatencyInjectionRoute(R"(
+    {
+      "runtime_vars_key": "latency",
+      "child": "NullRoute"
+    }
+  )"));
+}
+
+TEST_F(LatencyInjectionRouteTest, profileFromRuntimeVars) {
+  McrouterOptions opts = defaultTestOptions();
+  opts.config = "{ \"route\": \"NullRoute\" }";
+  auto* router =
+      CarbonRouterInstance<HelloGoodbyeRouterInfo>::init("test", opts);
+  ASSERT_NE(nullptr, router);
+
+  LatencyInjectionProfile base;
+  base.errorRate = 0.5;
+  LatencyInjectionProfileSource source(base, "latency_profile", router);
+  EXPECT_EQ(0.5, source.get()->errorRate);
+  EXPECT_FALSE(source.get()->distribution);
+
+  auto version = source.version();
+  router->rtVarsData().set(std::make_shared<const RuntimeVarsData>(R"(
+    {
+      "latency_profile": {
+        "latency_distribution": {
+          "type": "lognormal",
+          "median_ms": 2,
+          "sigma": 0.5
+        },
+        "latency_scale": 2
+      }
+    }
+  )"));
+  EXPECT_GT(source.version(), version);
+  EXPECT_TRUE(source.get()->distribution);
+  EXPECT_EQ(2, source.get()->latencyScale);
+  // Not overridden.
+  EXPECT_EQ(0.5, source.get()->errorRate);
+
+  // Invalid values keep the current profile.
+  version = source.version();
+  router->rtVarsData().set(std::make_shared<const RuntimeVarsData>(
+      R"({"latency_profile": {"error_rate": "high"}})"));
+  EXPECT_EQ(version, source.version());
+  EXPECT_EQ(2, source.get()->latencyScale);
+
+  // The config is back in effect once the variable is removed.
+  router->rtVarsData().set(std::make_shared<const RuntimeVarsData>("{}"));
+  EXPECT_FALSE(source.get()->distribution);
+  EXPECT_EQ(1, source.get()->latencyScale);
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
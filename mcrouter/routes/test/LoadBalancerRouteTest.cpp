@@ -5,7 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <chrono>
 #include <memory>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -14,6 +16,7 @@
 
 #include "mcrouter/CarbonRouterInstanceBase.h"
 #include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/WeightedCh3HashFunc.h"
 #include "mcrouter/lib/carbon/RequestReplyUtil.h"
 #include "mcrouter/lib/mc/msg.h"
@@ -83,6 +86,43 @@ class TestRoute {
   carbon::Result result_;
 };
 
+// Replies with its name after sleeping for `delay`.
+template <class RouteHandleIf>
+class DelayedTestRoute {
+ public:
+  DelayedTestRoute(
+      std::string name,
+      std::chrono::microseconds delay,
+      carbon::Result result = carbon::Result::OK)
+      : name_(std::move(name)), delay_(delay), result_(result) {}
+
+  template <class Request>
+  bool traverse(const Request&, const RouteHandleTraverser<RouteHandleIf>&)
+      const {
+    return false;
+  }
+
+  template <class Request>
+  ReplyT<Request> route(const Request& /* req */) {
+    /* sleep override */
+    std::this_thread::sleep_for(delay_);
+    ReplyT<Request> reply(result_);
+    if constexpr (carbon::GetLike<Request>::value) {
+      reply.value_ref() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, name_);
+    }
+    return reply;
+  }
+
+  static std::string routeName() {
+    return "delayed-test-route";
+  }
+
+ private:
+  std::string name_;
+  std::chrono::microseconds delay_;
+  carbon::Result result_;
+};
+
 } // anonymous namespace
 
 TEST(LoadBalancerRouteTest, basic) {
@@ -628,3 +668,62 @@ TEST(CpuLoadBalancerRouteTest, LoadsWithWaitTwoChoice) {
   EXPECT_TRUE((cmap["cpub"] >= 35) && (cmap["cpub"] <= 47));
   EXPECT_TRUE((cmap["cpuc"] >= 35) && (cmap["cpuc"] <= 47));
 }
+
+TEST(ClientLoadBalancerRouteTest, slowChildAvoided) {
+  std::vector<std::shared_ptr<TestRouteHandleIf>> testHandles{
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "fasta", std::chrono::microseconds(0)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "fastb", std::chrono::microseconds(0)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "slow", std::chrono::milliseconds(5))};
+
+  TestRouteHandle<LoadBalancerRoute<TestRouterInfo>> rh(
+      testHandles,
+      "",
+      std::chrono::seconds(10),
+      /* failoverCount */ 1,
+      LoadBalancerRoute<
+          TestRouterInfo>::AlgorithmType::TWO_RANDOM_CHOICES_CLIENT_LOAD,
+      /* fixed seed */ 0);
+
+  std::unordered_map<std::string, size_t> cmap;
+  for (int i = 0; i < 200; i++) {
+    auto reply = rh.route(McGetRequest("0" + std::to_string(i)));
+    ++cmap[carbon::valueRangeSlow(reply).str()];
+  }
+  LOG(INFO) << cmap["fasta"] << " " << cmap["fastb"] << " " << cmap["slow"];
+  // Once sampled, "slow" is more expensive than either of the fast children,
+  // so it's never picked again.
+  EXPECT_LE(cmap["slow"], 1);
+  EXPECT_GE(cmap["fasta"], 50);
+  EXPECT_GE(cmap["fastb"], 50);
+}
+
+TEST(ClientLoadBalancerRouteTest, errorChildAvoided) {
+  std::vector<std::shared_ptr<TestRouteHandleIf>> testHandles{
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "a", std::chrono::microseconds(0)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "b", std::chrono::microseconds(0)),
+      makeRouteHandle<TestRouteHandleIf, DelayedTestRoute>(
+          "tko", std::chrono::microseconds(0), carbon::Result::TKO)};
+
+  TestRouteHandle<LoadBalancerRoute<TestRouterInfo>> rh(
+      testHandles,
+      "",
+      std::chrono::seconds(10),
+      /* failoverCount */ 1,
+      LoadBalancerRoute<
+          TestRouterInfo>::AlgorithmType::TWO_RANDOM_CHOICES_CLIENT_LOAD,
+      /* fixed seed */ 0);
+
+  size_t errors = 0;
+  for (int i = 0; i < 200; i++) {
+    auto reply = rh.route(McGetRequest("0" + std::to_string(i)));
+    if (isErrorResult(*reply.result_ref())) {
+      ++errors;
+    }
+  }
+  EXPECT_LE(errors, 1);
+}
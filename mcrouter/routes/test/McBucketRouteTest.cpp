@@ -7,6 +7,8 @@
 
 #include "mcrouter/routes/McBucketRoute.h"
 #include "mcrouter/McrouterFiberContext.h"
+#include "mcrouter/lib/HashSelector.h"
+#include "mcrouter/lib/WeightedCh3HashFunc.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/routes/test/RouteHandleTestUtil.h"
@@ -193,4 +195,25 @@ TEST(McBucketRouteTest, recordBucketizationData) {
   EXPECT_EQ("getReq", keyBucketPairs[0].first);
   EXPECT_EQ("28", keyBucketPairs[0].second);
 }
+TEST(McBucketRouteTest, precomputedBucketDestinations) {
+  constexpr size_t kNumDestinations = 5;
+  WeightedCh3HashFunc func(std::vector<double>(kNumDestinations, 1.0));
+  BucketHashSelector<WeightedCh3HashFunc, MemcacheRouterInfo> precomputed(
+      "salt", func, /* numPrecomputedBuckets */ 50, kNumDestinations);
+  BucketHashSelector<WeightedCh3HashFunc, MemcacheRouterInfo> computed(
+      "salt", func);
+
+  mockFiberContext();
+  McGetRequest req("key");
+  // Buckets past the precomputed ones fall back to hashing.
+  for (size_t bucketId = 0; bucketId < 100; ++bucketId) {
+    fiber_local<MemcacheRouterInfo>::runWithLocals([&]() {
+      fiber_local<MemcacheRouterInfo>::setBucketId(bucketId);
+      EXPECT_EQ(
+          computed.select(req, kNumDestinations),
+          precomputed.select(req, kNumDestinations));
+    });
+  }
+}
+
 } // namespace facebook::memcache::mcrouter
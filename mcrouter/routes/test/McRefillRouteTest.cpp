@@ -11,14 +11,20 @@
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 #include "mcrouter/lib/test/RouteHandleTestUtil.h"
 #include "mcrouter/lib/test/TestRouteHandle.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
 #include "mcrouter/routes/test/RouteHandleTestBase.h"
 #include "mcrouter/routes/test/RouteHandleTestUtil.h"
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <folly/dynamic.h>
+#include <folly/fibers/Baton.h>
 #include <gtest/gtest.h>
 #include "folly/fibers/FiberManagerMap.h"
 #include "folly/io/async/EventBase.h"
@@ -43,4 +49,39 @@ TEST_F(McRefillRouteTest, create) {
   EXPECT_EQ("McRefillRoute", rh->routeName());
 }
 
+TEST_F(McRefillRouteTest, refillsCoalescedPerKey) {
+  auto primary = std::make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::NOTFOUND, ""),
+      UpdateRouteTestData(carbon::Result::STORED));
+  auto refill = std::make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "v"));
+  auto rh =
+      makeMcrouterRouteHandleWithInfo<McRefillRoute>(primary->rh, refill->rh);
+
+  auto get = [&rh](std::string key) {
+    return [&rh, key]() {
+      auto reply = rh->route(McGetRequest(key));
+      // Misses are replied right away, refills happen in the background.
+      EXPECT_EQ(carbon::Result::NOTFOUND, *reply.result_ref());
+    };
+  };
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.runAll({get("a"), get("a"), get("b"), []() {
+               // Let the queued refills run.
+               folly::fibers::Baton baton;
+               baton.try_wait_for(std::chrono::milliseconds(50));
+             }});
+
+  // The second miss on "a" joined the refill of the first one.
+  std::vector<std::string> refilledKeys;
+  for (size_t i = 0; i < refill->saw_keys.size(); ++i) {
+    if (refill->sawOperations[i] == "get") {
+      refilledKeys.push_back(refill->saw_keys[i]);
+    }
+  }
+  std::sort(refilledKeys.begin(), refilledKeys.end());
+  EXPECT_EQ((std::vector<std::string>{"a", "b"}), refilledKeys);
+}
+
 } // namespace facebook::memcache::mcrouter
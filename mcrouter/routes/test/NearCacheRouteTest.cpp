@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/McRouteHandleBuilder.h"
+#include "mcrouter/routes/NearCache.h"
+#include "mcrouter/routes/NearCacheRoute.h"
+#include "mcrouter/routes/test/RouteHandleTestUtil.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+using std::make_shared;
+using std::string;
+using std::vector;
+
+namespace {
+
+McrouterRouteHandlePtr makeNearCache(
+    McrouterRouteHandlePtr child,
+    std::chrono::milliseconds ttl = std::chrono::seconds(10),
+    size_t maxBytes = 1024 * 1024,
+    size_t maxValueSize = 1024) {
+  return makeMcrouterRouteHandleWithInfo<NearCacheRoute>(
+      std::move(child), ttl, maxBytes, maxValueSize);
+}
+
+} // namespace
+
+TEST(nearCacheRouteTest, hitServedLocally) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"),
+      UpdateRouteTestData(carbon::Result::STORED),
+      DeleteRouteTestData(carbon::Result::DELETED));
+  auto rh = makeNearCache(handle->rh);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    for (int i = 0; i < 3; ++i) {
+      auto reply = rh->route(McGetRequest("key"));
+      EXPECT_EQ(carbon::Result::FOUND, *reply.result_ref());
+      EXPECT_EQ("a", carbon::valueRangeSlow(reply).str());
+    }
+    EXPECT_EQ(vector<string>{"key"}, handle->saw_keys);
+  });
+}
+
+TEST(nearCacheRouteTest, missNotCached) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::NOTFOUND, ""));
+  auto rh = makeNearCache(handle->rh);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    rh->route(McGetRequest("key"));
+    rh->route(McGetRequest("key"));
+    EXPECT_EQ((vector<string>{"key", "key"}), handle->saw_keys);
+  });
+}
+
+TEST(nearCacheRouteTest, invalidatedByUpdates) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"),
+      UpdateRouteTestData(carbon::Result::STORED),
+      DeleteRouteTestData(carbon::Result::DELETED));
+  auto rh = makeNearCache(handle->rh);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    rh->route(McGetRequest("key"));
+    rh->route(McSetRequest("key"));
+    rh->route(McGetRequest("key"));
+    rh->route(McDeleteRequest("key"));
+    rh->route(McGetRequest("key"));
+    rh->route(McGetRequest("key"));
+    EXPECT_EQ(
+        (vector<string>{"get", "set", "get", "delete", "get"}),
+        handle->sawOperations);
+  });
+}
+
+TEST(nearCacheRouteTest, otherGetsBypassCache) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"));
+  auto rh = makeNearCache(handle->rh);
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    rh->route(McGetRequest("key"));
+    rh->route(McGetsRequest("key"));
+    rh->route(McLeaseGetRequest("key"));
+    EXPECT_EQ(
+        (vector<string>{"get", "gets", "lease-get"}), handle->sawOperations);
+  });
+}
+
+TEST(nearCacheRouteTest, ttlExpiry) {
+  auto handle = make_shared<TestHandle>(
+      GetRouteTestData(carbon::Result::FOUND, "a"));
+  auto rh = makeNearCache(handle->rh, std::chrono::milliseconds(0));
+
+  TestFiberManager<McrouterRouterInfo> fm;
+  fm.run([&]() {
+    mockFiberContext();
+    rh->route(McGetRequest("key"));
+    rh->route(McGetRequest("key"));
+    EXPECT_EQ((vector<string>{"key", "key"}), handle->saw_keys);
+  });
+}
+
+TEST(nearCacheTest, byteBudget) {
+  NearCache cache(std::chrono::seconds(10), 1024, 512);
+  auto now = NearCache::Clock::now();
+  std::string value(300, 'v');
+  folly::IOBuf buf(folly::IOBuf::COPY_BUFFER, value);
+
+  folly::IOBuf big(folly::IOBuf::COPY_BUFFER, string(600, 'v'));
+  EXPECT_FALSE(cache.insert("big", big, 0, now));
+
+  EXPECT_TRUE(cache.insert("a", buf, 0, now));
+  EXPECT_TRUE(cache.insert("b", buf, 0, now));
+  // Touch "a" so that "b" is the least recently used entry.
+  EXPECT_NE(nullptr, cache.find("a", now));
+  EXPECT_TRUE(cache.insert("c", buf, 0, now));
+
+  EXPECT_LE(cache.bytes(), 1024);
+  EXPECT_EQ(1, cache.evictions());
+  EXPECT_NE(nullptr, cache.find("a", now));
+  EXPECT_EQ(nullptr, cache.find("b", now));
+  auto entry = cache.find("c", now);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(value, entry->value.cloneAsValue().moveToFbString().toStdString());
+}
+
+TEST(nearCacheTest, epoch) {
+  NearCache cache(std::chrono::seconds(10), 1024, 512);
+  auto now = NearCache::Clock::now();
+  folly::IOBuf buf(folly::IOBuf::COPY_BUFFER, "v");
+
+  auto epoch = cache.epoch();
+  EXPECT_FALSE(cache.invalidate("a"));
+  EXPECT_NE(epoch, cache.epoch());
+
+  EXPECT_TRUE(cache.insert("a", buf, 0, now));
+  EXPECT_TRUE(cache.invalidate("a"));
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(0, cache.bytes());
+}
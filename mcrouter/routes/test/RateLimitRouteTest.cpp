@@ -155,3 +155,70 @@ TEST(rateLimitRouteTest, deletesBurst) {
 TEST(rateLimitRouteTest, deletesFallback) {
   testDeletes(false, true);
 }
+
+TEST(rateLimitRouteTest, perKeyPrefix) {
+  vector<std::shared_ptr<TestHandle>> normalHandle{
+      make_shared<TestHandle>(GetRouteTestData(carbon::Result::FOUND, "a")),
+  };
+  RateLimitRouteKeyedLimits keyed;
+  keyed.perKeyPrefix.emplace(
+      parseJsonString(R"({"gets_rate": 0.001, "gets_burst": 2})"));
+  McrouterRouteHandle<RateLimitRoute<McrouterRouteHandleIf>> rh(
+      get_route_handles(normalHandle)[0],
+      RateLimiter(parseJsonString(R"({"gets_rate": 1000000})"), true),
+      nullptr,
+      std::move(keyed));
+
+  // New prefixes start with a full burst.
+  EXPECT_EQ(carbon::Result::FOUND, *rh.route(McGetRequest("a:1")).result_ref());
+  EXPECT_EQ(carbon::Result::FOUND, *rh.route(McGetRequest("a:2")).result_ref());
+  EXPECT_EQ(
+      carbon::Result::NOTFOUND, *rh.route(McGetRequest("a:3")).result_ref());
+  // Other prefixes aren't affected.
+  EXPECT_EQ(carbon::Result::FOUND, *rh.route(McGetRequest("b:1")).result_ref());
+  // Keys without the delimiter share a limiter.
+  EXPECT_EQ(carbon::Result::FOUND, *rh.route(McGetRequest("c")).result_ref());
+  EXPECT_EQ(carbon::Result::FOUND, *rh.route(McGetRequest("d")).result_ref());
+  EXPECT_EQ(
+      carbon::Result::NOTFOUND, *rh.route(McGetRequest("e")).result_ref());
+
+  EXPECT_EQ(
+      (vector<string>{"a:1", "a:2", "b:1", "c", "d"}),
+      normalHandle[0]->saw_keys);
+}
+
+TEST(rateLimitRouteTest, perClient) {
+  vector<std::shared_ptr<TestHandle>> normalHandle{
+      make_shared<TestHandle>(UpdateRouteTestData(carbon::Result::STORED)),
+  };
+  std::string client = "client1";
+  RateLimitRouteKeyedLimits keyed;
+  keyed.perClient.emplace(
+      parseJsonString(R"({"sets_rate": 0.001, "sets_burst": 1,
+                          "max_keys": 2})"));
+  keyed.clientId = [&client]() { return folly::StringPiece(client); };
+  McrouterRouteHandle<RateLimitRoute<McrouterRouteHandleIf>> rh(
+      get_route_handles(normalHandle)[0],
+      RateLimiter(parseJsonString("{}")),
+      nullptr,
+      std::move(keyed));
+
+  auto set = [&rh]() {
+    McSetRequest req("key");
+    req.value_ref() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, "value");
+    return *rh.route(req).result_ref();
+  };
+  EXPECT_EQ(carbon::Result::STORED, set());
+  EXPECT_EQ(carbon::Result::NOTSTORED, set());
+  client = "client2";
+  EXPECT_EQ(carbon::Result::STORED, set());
+  // Unknown clients are only subject to the other limits.
+  client = "";
+  EXPECT_EQ(carbon::Result::STORED, set());
+  EXPECT_EQ(carbon::Result::STORED, set());
+  // client1 is evicted to make room for client3, and starts over.
+  client = "client3";
+  EXPECT_EQ(carbon::Result::STORED, set());
+  client = "client1";
+  EXPECT_EQ(carbon::Result::STORED, set());
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <folly/dynamic.h>
+
+#include "mcrouter/routes/RetryBudget.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(RetryBudget, minRetries) {
+  RetryBudget budget(20, 1, 10);
+
+  // Without any successful request, only min_retries_per_sec * window_sec
+  // retries are allowed.
+  size_t allowed = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    allowed += budget.tryRetry();
+  }
+  EXPECT_EQ(10, allowed);
+}
+
+TEST(RetryBudget, percentOfSuccesses) {
+  RetryBudget budget(20, 0, 10);
+  EXPECT_FALSE(budget.tryRetry());
+
+  for (size_t i = 0; i < 1000; ++i) {
+    budget.recordSuccess();
+  }
+  size_t allowed = 0;
+  for (size_t i = 0; i < 1000; ++i) {
+    allowed += budget.tryRetry();
+  }
+  EXPECT_EQ(200, allowed);
+}
+
+TEST(RetryBudget, shared) {
+  folly::dynamic config = folly::dynamic::object("percent", 10)(
+      "min_retries_per_sec", 0)("window_sec", 5);
+  folly::dynamic route = folly::dynamic::object("name", "pool-a");
+  auto a = RetryBudget::getShared(config, route);
+  auto b = RetryBudget::getShared(config, route);
+  auto c = RetryBudget::getShared(
+      config, folly::dynamic::object("name", "pool-b"));
+  EXPECT_EQ(a.get(), b.get());
+  EXPECT_NE(a.get(), c.get());
+
+  for (size_t i = 0; i < 10; ++i) {
+    a->recordSuccess();
+  }
+  EXPECT_TRUE(b->tryRetry());
+  EXPECT_FALSE(a->tryRetry());
+  EXPECT_FALSE(c->tryRetry());
+}
@@ -12,6 +12,8 @@
 #include <string>
 #include <utility>
 
+#include <folly/Conv.h>
+
 #include "mcrouter/routes/PrefixSelectorRoute.h"
 
 namespace facebook::memcache::mcrouter {
@@ -140,5 +142,32 @@ TEST(RoutePolicyMapTest, RepeatedWildcard) {
   ASSERT_THAT(routesFor(m, "a"), ::testing::ElementsAre(1, 2));
 }
 
+TEST(RoutePolicyMapTest, ManyPolicies) {
+  // Enough policies to switch to the flat table even when V2 is disabled.
+  MockPrefixSelectorRoute first{.wildcard = 0};
+  MockPrefixSelectorRoute second{.wildcard = 1};
+  for (int i = 0; i != 300; ++i) {
+    first.policies.emplace_back(folly::to<std::string>("a", i), i + 2);
+    if (i % 3 == 0) {
+      second.policies.emplace_back(folly::to<std::string>("a", i, ":"), i + 2);
+    }
+  }
+  auto m = makeMap({first, second});
+
+  ASSERT_THAT(routesFor(m, "b"), ::testing::ElementsAre(0, 1));
+  ASSERT_THAT(routesFor(m, "a1"), ::testing::ElementsAre(3, 1));
+  ASSERT_THAT(routesFor(m, "a12x"), ::testing::ElementsAre(14, 1));
+  ASSERT_THAT(routesFor(m, "a12:x"), ::testing::ElementsAre(14));
+  ASSERT_THAT(routesFor(m, "a299"), ::testing::ElementsAre(301, 1));
+}
+
+TEST(RoutePolicyMapTest, HasKeyPolicies) {
+  EXPECT_FALSE(
+      makeMap({{.wildcard = 1}, {.wildcard = 2}}).m0.hasKeyPolicies());
+  auto m = makeMap({{.wildcard = 1}, {.wildcard = 2, .policies = {{"a", 3}}}});
+  EXPECT_TRUE(m.m0.hasKeyPolicies());
+  EXPECT_TRUE(m.m1.hasKeyPolicies());
+}
+
 } // namespace
-} // namespace facebook::memcache::mcrouter
+} // namespace facebook::memcache::mcrouter
\ No newline at end of file
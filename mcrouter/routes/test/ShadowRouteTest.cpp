@@ -75,3 +75,19 @@ TEST(shadowRouteTest, defaultPolicy) {
   EXPECT_EQ(shadowHandles[0]->saw_keys, vector<string>{"key"});
   EXPECT_EQ(shadowHandles[1]->saw_keys, vector<string>{"key"});
 }
+
+TEST(shadowRouteTest, defaultPolicySharesBuffers) {
+  McSetRequest req("key");
+  req.value_ref() = folly::IOBuf(folly::IOBuf::COPY_BUFFER, string(4096, 'v'));
+
+  DefaultShadowPolicy policy;
+  auto adjustedReq = policy.makeAdjustedNormalRequest(req);
+  auto shadowReq = policy.makeShadowRequest(adjustedReq);
+
+  // All shadows get the same request object...
+  EXPECT_EQ(adjustedReq.get(), shadowReq.get());
+  // ...which references the key and value of the original one.
+  EXPECT_EQ(req.value_ref()->data(), shadowReq->value_ref()->data());
+  EXPECT_EQ(
+      req.key_ref()->fullKey().data(), shadowReq->key_ref()->fullKey().data());
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+
+#include "mcrouter/routes/FlatShardMap.h"
+#include "mcrouter/routes/ShardMapFile.h"
+#include "mcrouter/routes/ShardSelectionRouteFactory.h"
+
+using namespace facebook::memcache::mcrouter;
+
+using folly::test::TemporaryFile;
+
+namespace {
+
+uint32_t writeShardMap(
+    const TemporaryFile& file,
+    const std::vector<std::vector<size_t>>& shards) {
+  auto data = ShardMapFile::build(shards);
+  EXPECT_TRUE(folly::writeFile(data, file.path().c_str()));
+  return ShardMapFile::checksum(data);
+}
+
+} // namespace
+
+TEST(ShardMapFile, find) {
+  TemporaryFile file("shard_map_test");
+  auto checksum = writeShardMap(file, {{1, 2, 3}, {3, 5, 100}});
+  ShardMapFile map(file.path().string(), checksum);
+
+  EXPECT_EQ(2, map.numDestinations());
+  EXPECT_EQ(6, map.size());
+  EXPECT_EQ(101, map.capacity());
+  EXPECT_EQ(0, map.find(1));
+  EXPECT_EQ(0, map.find(3));
+  EXPECT_EQ(1, map.find(5));
+  EXPECT_EQ(1, map.find(100));
+  EXPECT_FALSE(map.contains(0));
+  EXPECT_FALSE(map.contains(4));
+  EXPECT_EQ(ShardMapFile::kNotFound, map.find(101));
+  EXPECT_EQ(ShardMapFile::kNotFound, map.find(1000000));
+}
+
+TEST(ShardMapFile, invalidFile) {
+  TemporaryFile file("shard_map_test");
+  const std::string garbage("not a shard map file");
+  EXPECT_TRUE(folly::writeFile(garbage, file.path().c_str()));
+  EXPECT_ANY_THROW(
+      ShardMapFile(file.path().string(), ShardMapFile::checksum(garbage)));
+
+  auto checksum = writeShardMap(file, {{1, 2}});
+  EXPECT_ANY_THROW(ShardMapFile(file.path().string(), checksum + 1));
+  EXPECT_ANY_THROW(ShardMapFile("/does/not/exist", checksum));
+}
+
+TEST(ShardMapFile, getShared) {
+  TemporaryFile file("shard_map_test");
+  auto checksum = writeShardMap(file, {{1}, {2}});
+  auto a = ShardMapFile::getShared(file.path().string(), checksum);
+  auto b = ShardMapFile::getShared(file.path().string(), checksum);
+  EXPECT_EQ(a.get(), b.get());
+
+  MappedShardMap mapped(a);
+  EXPECT_EQ(2, mapped.size());
+  EXPECT_EQ(1, mapped.find(2));
+}
+
+TEST(ShardMapFile, copyToShardsMap) {
+  TemporaryFile file("shard_map_test");
+  auto checksum = writeShardMap(file, {{0, 7}, {}, {4}});
+  auto shared = ShardMapFile::getShared(file.path().string(), checksum);
+
+  auto flat = detail::getShardsMap<FlatShardMap>(shared);
+  EXPECT_EQ(3, flat.size());
+  EXPECT_EQ(0, flat.find(7));
+  EXPECT_EQ(2, flat.find(4));
+  EXPECT_FALSE(flat.contains(1));
+
+  auto vec = detail::getShardsMap<std::vector<uint16_t>>(shared);
+  ASSERT_EQ(8, vec.size());
+  EXPECT_EQ(0, vec[0]);
+  EXPECT_EQ(2, vec[4]);
+  EXPECT_EQ(std::numeric_limits<uint16_t>::max(), vec[5]);
+}
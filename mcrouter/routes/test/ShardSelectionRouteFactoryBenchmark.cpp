@@ -13,6 +13,8 @@
 #include "mcrouter/lib/carbon/example/gen/HelloGoodbyeRouterInfo.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/lib/test/RouteHandleTestUtil.h"
+#include "mcrouter/routes/FlatShardMap.h"
+#include "mcrouter/routes/ShardHashFunc.h"
 #include "mcrouter/routes/ShardSelectionRouteFactory.h"
 
 using facebook::memcache::RouteHandleFactory;
@@ -44,6 +46,28 @@ class BasicShardSelector {
   const std::unordered_map<uint32_t, uint32_t> shardsMap_;
 };
 
+class FlatShardSelector {
+ public:
+  explicit FlatShardSelector(facebook::memcache::mcrouter::FlatShardMap map)
+      : shardsMap_(std::move(map)) {}
+
+  std::string type() const {
+    return "flat-shard-selector";
+  }
+
+  template <class Request>
+  size_t select(const Request& req, size_t /* size */) const {
+    auto idx = shardsMap_.find(*req.shardId_ref());
+    if (idx == facebook::memcache::mcrouter::FlatShardMap::kNotFound) {
+      return std::numeric_limits<size_t>::max();
+    }
+    return idx;
+  }
+
+ private:
+  const facebook::memcache::mcrouter::FlatShardMap shardsMap_;
+};
+
 constexpr folly::StringPiece kShardSelectionSmall = R"(
 {
   "pool": {
@@ -986,6 +1010,14 @@ HelloGoodbyeRouterInfo::RouteHandlePtr buildEagerShardSelectionRoute(
       std::unordered_map<uint32_t, uint32_t>>(gFactory, json);
 }
 
+HelloGoodbyeRouterInfo::RouteHandlePtr buildFlatEagerShardSelectionRoute(
+    const folly::dynamic& json) {
+  return facebook::memcache::mcrouter::createEagerShardSelectionRoute<
+      HelloGoodbyeRouterInfo,
+      FlatShardSelector,
+      facebook::memcache::mcrouter::FlatShardMap>(gFactory, json);
+}
+
 } // anonymous namespace
 
 BENCHMARK(createShardSelectionRoute_small) {
@@ -1014,6 +1046,45 @@ BENCHMARK(createEagerShardSelectionRoute_LoadBalancer_huge) {
   folly::doNotOptimizeAway(rh);
 }
 
+BENCHMARK(createEagerShardSelectionRoute_FlatShardMap_huge) {
+  auto rh = buildFlatEagerShardSelectionRoute(kEagerShardSelectionHugeJson);
+  folly::doNotOptimizeAway(rh);
+}
+
+BENCHMARK_DRAW_LINE();
+
+// Per-request shard id extraction, as done by ConstShardHashFunc and
+// ShardSplitRoute.
+BENCHMARK(getShardId, iters) {
+  constexpr folly::StringPiece kKey = "prefix:1234567:some_longer_key_suffix";
+  for (size_t i = 0; i < iters; ++i) {
+    folly::StringPiece shard;
+    auto found = facebook::memcache::mcrouter::getShardId(kKey, shard);
+    folly::doNotOptimizeAway(found);
+    folly::doNotOptimizeAway(shard);
+  }
+}
+
+BENCHMARK(getShardIdAndParse, iters) {
+  constexpr folly::StringPiece kKey = "prefix:1234567:some_longer_key_suffix";
+  for (size_t i = 0; i < iters; ++i) {
+    folly::StringPiece shard;
+    size_t shardId = 0;
+    auto found = facebook::memcache::mcrouter::getShardId(kKey, shard) &&
+        facebook::memcache::mcrouter::parseShardIdNumber(shard, shardId);
+    folly::doNotOptimizeAway(found);
+    folly::doNotOptimizeAway(shardId);
+  }
+}
+
+BENCHMARK(constShardHashFunc, iters) {
+  facebook::memcache::mcrouter::ConstShardHashFunc func(10000000);
+  constexpr folly::StringPiece kKey = "prefix:1234567:some_longer_key_suffix";
+  for (size_t i = 0; i < iters; ++i) {
+    folly::doNotOptimizeAway(func(kKey));
+  }
+}
+
 /**
  * BENCHMARK RESULTS (opt mode):
  *
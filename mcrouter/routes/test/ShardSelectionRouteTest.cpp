@@ -9,15 +9,19 @@
 
 #include <gtest/gtest.h>
 
+#include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/experimental/TestUtil.h>
 #include <folly/json.h>
 
 #include "mcrouter/CarbonRouterInstance.h"
 #include "mcrouter/PoolFactory.h"
+#include "mcrouter/lib/McResUtil.h"
 #include "mcrouter/lib/carbon/example/gen/HelloGoodbyeRouterInfo.h"
 #include "mcrouter/lib/config/RouteHandleFactory.h"
 #include "mcrouter/options.h"
 #include "mcrouter/routes/McRouteHandleProvider.h"
+#include "mcrouter/routes/ShardMapFile.h"
 #include "mcrouter/routes/ShardSelectionRouteFactory.h"
 #include "mcrouter/routes/test/RouteHandleTestBase.h"
 
@@ -677,6 +681,45 @@ TEST_F(ShardSelectionRouteTest, customOutOfRangeRouteString) {
   EXPECT_EQ(carbon::Result::NOTFOUND, *reply.result_ref());
 }
 
+TEST_F(ShardSelectionRouteTest, shardsFile) {
+  folly::test::TemporaryFile file("shard_map_test");
+  const auto data = ShardMapFile::build({{1, 2}, {3}});
+  ASSERT_TRUE(folly::writeFile(data, file.path().c_str()));
+  const auto shardsFile = folly::toJson(folly::dynamic::object(
+      "path", file.path().string())("checksum", ShardMapFile::checksum(data)));
+
+  const std::string config = R"(
+  {
+    "pool": {
+      "type": "Pool",
+      "name": "SamplePool1",
+      "servers": [
+        {"type": "NullRoute"},
+        {"type": "ErrorRoute"}
+      ],
+      "protocol": "caret"
+    },
+    "shards_file": )" +
+      shardsFile + "}";
+
+  auto rh = getShardSelectionRoute(config);
+  ASSERT_TRUE(rh);
+
+  GoodbyeRequest req;
+  req.shardId_ref() = 2;
+  EXPECT_EQ(carbon::Result::NOTFOUND, *rh->route(req).result_ref());
+  req.shardId_ref() = 3;
+  EXPECT_TRUE(isErrorResult(*rh->route(req).result_ref()));
+
+  // The checksum must match the file.
+  const auto badConfig = folly::toJson(folly::dynamic::object(
+      "pool", folly::parseJson(config)["pool"])(
+      "shards_file",
+      folly::dynamic::object("path", file.path().string())(
+          "checksum", ShardMapFile::checksum(data) ^ 1)));
+  EXPECT_ANY_THROW(getShardSelectionRoute(badConfig));
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
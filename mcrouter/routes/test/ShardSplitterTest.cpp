@@ -6,6 +6,7 @@
  */
 
 #include <chrono>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -121,3 +122,29 @@ TEST(ShardSplitter, migration90Pct) {
   auto config = getConfigTemplate(nowInSec() - 6480);
   migrationTest(config, 0.9);
 }
+
+TEST(ShardSplitter, splitWeights) {
+  auto config = folly::dynamic::object(
+      "123",
+      folly::dynamic::object("old_split_size", 3)("new_split_size", 3)(
+          "split_weights", folly::dynamic::array(1, 0, 3))(
+          "migration_period", 0)("split_start", 0));
+  std::vector<size_t> counts(3, 0);
+  for (size_t i = 0; i < kNumHostIds; ++i) {
+    HostidMock hostidMock(i);
+    ShardSplitter splitter(config);
+    folly::StringPiece shard;
+    auto split = splitter.getShardSplit("abc:123:", shard);
+    ASSERT_NE(nullptr, split);
+    EXPECT_EQ(3, split->getSplitSizeForCurrentHost());
+    ++counts[split->getSplitOffsetForCurrentHost()];
+  }
+  EXPECT_EQ(0, counts[1]);
+  EXPECT_NEAR(0.25, counts[0] / (double)kNumHostIds, 0.02);
+  EXPECT_NEAR(0.75, counts[2] / (double)kNumHostIds, 0.02);
+
+  config["123"]["split_weights"] = folly::dynamic::array(1, 1);
+  EXPECT_THROW(ShardSplitter{config}, std::logic_error);
+  config["123"]["split_weights"] = folly::dynamic::array(0, 0, 0);
+  EXPECT_THROW(ShardSplitter{config}, std::logic_error);
+}
@@ -181,3 +181,53 @@ TEST(SlowWarmUpRoute, minRequests) {
     EXPECT_EQ(50, numNormal + numFailover);
   });
 }
+
+TEST(SlowWarmUpRoute, sharedState) {
+  auto settings = std::make_shared<SlowWarmUpRouteSettings>(
+      /* enable */ 0.5,
+      /* disable */ 0.9,
+      /* start */ 0.1,
+      /* step */ 1.0,
+      /* numReqs  */ 10);
+  int router;
+  auto state = SlowWarmUpState::getShared(&router, "host:1:ascii:plain");
+  EXPECT_EQ(state, SlowWarmUpState::getShared(&router, "host:1:ascii:plain"));
+  EXPECT_NE(state, SlowWarmUpState::getShared(&router, "host:2:ascii:plain"));
+
+  TestFiberManager<TestRouterInfo> fm;
+
+  std::vector<std::shared_ptr<TestHandle>> targets{
+      std::make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::FOUND, "a"),
+          UpdateRouteTestData(carbon::Result::STORED),
+          DeleteRouteTestData(carbon::Result::NOTFOUND)),
+      std::make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::FOUND, "b"),
+          UpdateRouteTestData(carbon::Result::STORED),
+          DeleteRouteTestData(carbon::Result::NOTFOUND)),
+  };
+  auto handles = get_route_handles(targets);
+
+  auto ctx = getContext();
+  fm.run([&]() {
+    fiber_local<MemcacheRouterInfo>::setSharedCtx(ctx);
+    {
+      // The route of a first config (or proxy) only sees misses.
+      TestRouteHandle<SlowWarmUpRoute<TestRouterInfo>> rh(
+          handles[0], handles[1], settings, state);
+      for (int i = 0; i < 30; ++i) {
+        rh.route(McDeleteRequest("0"));
+      }
+    }
+    EXPECT_TRUE(state->warmingUp(*settings));
+
+    // The route of the next one keeps warming up the destination.
+    TestRouteHandle<SlowWarmUpRoute<TestRouterInfo>> rh(
+        handles[0], handles[1], settings, state);
+    size_t numNormal = 0;
+    size_t numFailover = 0;
+    sendWorkload(rh, 100, numNormal, numFailover);
+    EXPECT_GT(numFailover, 0);
+    EXPECT_EQ(100, numNormal + numFailover);
+  });
+}
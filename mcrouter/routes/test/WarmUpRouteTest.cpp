@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
@@ -87,3 +88,68 @@ TEST(warmUpRouteTest, warmUp) {
     EXPECT_EQ(vector<string>{"key_del"}, test_handles[2]->saw_keys);
   });
 }
+
+TEST(warmUpRouteTest, batchedFills) {
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::FOUND, "a"),
+          UpdateRouteTestData(carbon::Result::STORED),
+          DeleteRouteTestData(carbon::Result::DELETED)),
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::NOTFOUND, ""),
+          UpdateRouteTestData(carbon::Result::STORED),
+          DeleteRouteTestData(carbon::Result::NOTFOUND)),
+  };
+  auto route_handles = get_route_handles(test_handles);
+
+  TestFiberManager<TestRouterInfo> fm;
+  WarmUpBatchSettings settings;
+  settings.maxBatchSize = 3;
+  settings.maxDelay = std::chrono::milliseconds(0);
+  TestRouteHandle<WarmUpRoute<TestRouteHandleIf>> rh(
+      route_handles[0], route_handles[1], 1, settings);
+
+  fm.runAll({
+      [&]() { rh.route(McGetRequest("key1")); },
+      [&]() { rh.route(McGetRequest("key2")); },
+  });
+  // Lets the fibers sending the batch run.
+  fm.run([]() {});
+  fm.run([&]() {
+    auto& ops = test_handles[1]->sawOperations;
+    EXPECT_EQ(2, std::count(ops.begin(), ops.end(), "add"));
+    EXPECT_EQ((vector<uint32_t>{0, 0, 1, 1}), test_handles[1]->sawExptimes);
+  });
+}
+
+TEST(warmUpRouteTest, fillRateAdaptsToColdErrors) {
+  vector<std::shared_ptr<TestHandle>> test_handles{
+      make_shared<TestHandle>(
+          GetRouteTestData(carbon::Result::NOTFOUND, ""),
+          UpdateRouteTestData(carbon::Result::REMOTE_ERROR),
+          DeleteRouteTestData(carbon::Result::NOTFOUND)),
+  };
+  auto route_handles = get_route_handles(test_handles);
+
+  TestFiberManager<TestRouterInfo> fm;
+  WarmUpBatchSettings settings;
+  settings.maxBatchSize = 1;
+  settings.maxFillsPerSec = 1;
+  auto batcher = make_shared<WarmUpFillBatcher<TestRouteHandleIf>>(
+      route_handles[0], settings);
+
+  fm.run([&]() {
+    for (auto key : {"key1", "key2", "key3"}) {
+      McAddRequest req(key);
+      req.value_ref() = *folly::IOBuf::copyBuffer("value");
+      batcher->add(std::move(req));
+    }
+  });
+  fm.run([]() {});
+  fm.run([&]() {
+    // Only the first fill fits in the burst, and it failed.
+    EXPECT_EQ(2, batcher->numDropped());
+    EXPECT_EQ(vector<string>{"key1"}, test_handles[0]->saw_keys);
+    EXPECT_DOUBLE_EQ(0.5, batcher->fillsPerSec());
+  });
+}
@@ -52,6 +52,16 @@ MCROUTER_OPTION_OTHER(
     no_short,
     "SSL Port(s) to listen on (comma separated)")
 
+MCROUTER_OPTION_OTHER(
+    std::vector<uint16_t>,
+    async_priority_ports,
+    ,
+    "async-priority-port",
+    no_short,
+    "Port(s) among --port (comma separated) whose requests are queued by the"
+    " proxies with async priority, behind the requests of the other ports."
+    " See proxy-max-inflight-async-requests.")
+
 MCROUTER_OPTION_STRING(
   tls_ticket_key_seed_path, "",
   "tls-ticket-key-seed-path", no_short,
@@ -93,6 +103,14 @@ MCROUTER_OPTION_TOGGLE(
     no_short,
     "Use KTLS for all TLS 1.2 connections")
 
+MCROUTER_OPTION_TOGGLE(
+    ssl_use_ktls13,
+    false,
+    "ssl-use-ktls13",
+    no_short,
+    "Use KTLS for all accepted TLS 1.3 (fizz) connections, if supported by"
+    " the kernel and the negotiated cipher")
+
 MCROUTER_OPTION_INTEGER(
     int,
     listen_sock_fd,
@@ -108,6 +126,35 @@ MCROUTER_OPTION_STRING(
     no_short,
     "Unix domain socket path")
 
+MCROUTER_OPTION_STRING(
+    local_sock,
+    "",
+    "local-sock",
+    no_short,
+    "Unix domain socket path to listen on in addition to the ports, for"
+    " clients running on the same host")
+
+MCROUTER_OPTION_STRING(
+    takeover_socket_path,
+    "",
+    "takeover-socket-path",
+    no_short,
+    "If set, on startup take the listening sockets over from the mcrouter"
+    " running with the same path, if any, instead of binding the ports; the"
+    " old process then stops accepting, drains its connections and exits."
+    " Once started, hand the sockets over the same way to the next process."
+    " Requires a single listening socket on plain ports or on SSL ports, not"
+    " both. Not supported in dual mode.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    takeover_timeout_ms,
+    5000,
+    "takeover-timeout-ms",
+    no_short,
+    "How long to wait for the old process during a takeover, see"
+    " takeover-socket-path.")
+
 MCROUTER_OPTION_INTEGER(
     size_t,
     max_conns,
@@ -134,6 +181,16 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "Maximum requests outstanding per client (0 to disable)")
 
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    client_overload_pause_ms,
+    5,
+    "client-overload-pause-ms",
+    no_short,
+    "How long to stop reading from a client connection when the proxy is"
+    " overloaded before checking again (see proxy-queue-delay-target-us and"
+    " proxy-overload-fibers-percent).")
+
 MCROUTER_OPTION_TOGGLE(
     retain_source_ip,
     false,
@@ -167,6 +224,65 @@ MCROUTER_OPTION_INTEGER(
     "How often to collect server load data. "
     "(0 to disable exposing server load)")
 
+MCROUTER_OPTION_TOGGLE(
+    server_load_from_thread_cpu,
+    false,
+    "server-load-from-thread-cpu",
+    no_short,
+    "Compute the server load from the CPU time of the server threads only,"
+    " instead of the CPU use of the whole host.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    server_load_full_loop_lag_us,
+    0,
+    "server-load-full-loop-lag-us",
+    no_short,
+    "If non-zero, the server load is at least the event loop lag of the"
+    " server threads over this value, so that a lag of this many"
+    " microseconds reports full load. (0 to ignore loop lag)")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    go_away_timeout_ms,
+    0,
+    "go-away-timeout-ms",
+    no_short,
+    "If non-zero, caret connections closed by the server are first sent a"
+    " GoAway message, and closed once the client acknowledges it or after"
+    " this many ms. 0 to close them right away.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    connection_rebalance_interval_ms,
+    0,
+    "connection-rebalance-interval-ms",
+    no_short,
+    "How often every server thread compares its CPU usage with the others'."
+    " A thread that stays busier than the average closes some of its idle"
+    " connections, asking caret clients to reconnect with a GoAway message"
+    " (see --go-away-timeout-ms), so that they get spread over the other"
+    " threads. 0 to disable.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    connection_rebalance_min_imbalance_pct,
+    20,
+    "connection-rebalance-min-imbalance-pct",
+    no_short,
+    "A server thread is considered busier than the others when its CPU usage"
+    " is this many % of a core above the average, for 3 consecutive"
+    " intervals.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    connection_rebalance_max_conns,
+    4,
+    "connection-rebalance-max-conns",
+    no_short,
+    "Max number of connections a busy server thread moves away per"
+    " rebalancing interval.")
+
 MCROUTER_OPTION_INTEGER(
     uint32_t,
     tfo_queue_size,
@@ -230,6 +346,73 @@ MCROUTER_OPTION_INTEGER(
     no_short,
     "adjust how many listening sockets to use. Must be <= num_proxies")
 
+MCROUTER_OPTION_TOGGLE(
+    per_thread_listening_sockets,
+    false,
+    "per-thread-listening-sockets",
+    no_short,
+    "Open one SO_REUSEPORT listening socket per proxy thread, each thread only"
+    " accepting its own connections. Overrides num_listening_sockets.")
+
+MCROUTER_OPTION_TOGGLE(
+    reuseport_cpu_steering,
+    false,
+    "reuseport-cpu-steering",
+    no_short,
+    "With per_thread_listening_sockets, hand every new connection to the"
+    " proxy thread of the CPU that received it (cpu % num_proxies), and pin"
+    " the proxy threads to their CPUs. Linux only.")
+
+MCROUTER_OPTION_TOGGLE(
+    server_io_uring_transport,
+    false,
+    "server-io-uring-transport",
+    no_short,
+    "Use io_uring backed transport for plaintext client connections, so that"
+    " the replies of all the connections of a proxy thread are submitted in"
+    " one batch per event loop. Has no effect unless proxy event bases run on"
+    " the io_uring backend (--proxy-io-uring-backend), or with"
+    " tcp_zero_copy_threshold.")
+
+MCROUTER_OPTION_INTEGER(
+    uint32_t,
+    server_busy_poll_us,
+    0,
+    "server-busy-poll-us",
+    no_short,
+    "If non-zero, reads on client connections busy-poll the network device"
+    " for up to this many microseconds (SO_BUSY_POLL) instead of sleeping"
+    " right away. Costs CPU, saves wakeup latency.")
+
+MCROUTER_OPTION_TOGGLE(
+    release_idle_read_buffers,
+    false,
+    "release-idle-read-buffers",
+    no_short,
+    "Only hold a read buffer for a client connection while it has data being"
+    " parsed, sharing the buffers of idle connections within a proxy thread."
+    " See the read_buffer_bytes stat.")
+
+MCROUTER_OPTION_INTEGER(
+    size_t,
+    large_request_read_threshold,
+    0,
+    "large-request-read-threshold",
+    no_short,
+    "Read caret requests of at least this many bytes (e.g. sets of large"
+    " values) straight into a buffer of their size, instead of growing the"
+    " connection's read buffer and copying it. If 0, every request goes"
+    " through the read buffer.")
+
+MCROUTER_OPTION_TOGGLE(
+    ascii_multiget_streaming,
+    false,
+    "ascii-multiget-streaming",
+    no_short,
+    "Write the hits of an ascii multi-get as soon as they are ready instead"
+    " of in the order of the keys (END still comes last). Only for clients"
+    " that match values by key.")
+
 MCROUTER_OPTION_TOGGLE(
     remote_thread,
     false,
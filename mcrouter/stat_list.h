@@ -81,6 +81,16 @@ STUI(num_fail_open_state_entered, 0, 1)
 STUI(num_fail_open_state_exited, 0, 1)
 // Connections closed due to retransmits
 STUI(retrans_closed_connections, 0, 1)
+// Connections closed due to RTT above the pool median
+STUI(rtt_closed_connections, 0, 1)
+// Requests sent through a connection owned by another proxy, and
+// destinations that got their own connection after crossing the threshold
+// (see shared_cold_connections).
+STUI(shared_connection_forwarded_reqs, 0, 1)
+STUI(shared_connection_promotions, 0, 1)
+// Version requests sent to idle or disconnected destinations of standby
+// pools, to keep their connections open (see standby_keepalive_interval_ms).
+STUI(standby_keepalives_sent, 0, 1)
 #undef GROUP
 
 /**
@@ -99,6 +109,12 @@ STUI(asynclog_spool_success_rate, 0, 1)
 STUI(axon_proxy_request_success_rate, 0, 1)
 // number of requests sending to Axon proxy service
 STUI(axon_proxy_request_fail_rate, 0, 1)
+// number of coalesced records written to Axon proxy service
+STUI(axon_batch_writes, 0, 1)
+// number of deletes dropped from an Axon batch already holding their key
+STUI(axon_batch_deduped_keys, 0, 1)
+// number of deletes not batched for Axon because too many were pending
+STUI(axon_batch_rejected_keys, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | basic_stats
 // Average number of requests waiting in OLR at any given time
@@ -142,6 +158,51 @@ STUI(ps_vsize, 0, 0)
 STUI(fibers_allocated, 0, 0)
 STUI(fibers_pool_size, 0, 0)
 STUI(fibers_stack_high_watermark, 0, 0)
+STUI(fibers_large_stack_allocated, 0, 0)
+STUI(fibers_large_stack_high_watermark, 0, 0)
+#undef GROUP
+
+/**
+ * Stats about recycling of server write buffers
+ */
+#define GROUP ods_stats | basic_stats
+STUI(write_buffer_pool_hits, 0, 0)
+STUI(write_buffer_pool_misses, 0, 0)
+STUI(write_buffer_pool_trimmed, 0, 0)
+STUI(write_buffer_storage_pool_hits, 0, 0)
+STUI(write_buffer_storage_pool_misses, 0, 0)
+#undef GROUP
+
+/**
+ * Stats about connection read buffers
+ */
+#define GROUP ods_stats | basic_stats
+STUI(read_buffer_bytes, 0, 0)
+STUI(read_buffer_pool_hits, 0, 0)
+STUI(read_buffer_pool_misses, 0, 0)
+#undef GROUP
+
+/**
+ * Stats about TLS handshakes run on the auxiliary IO thread pool, see
+ * --ssl-handshake-offload
+ */
+#define GROUP ods_stats | basic_stats
+STUI(ssl_handshake_offload_queue_depth, 0, 0)
+STUI(ssl_handshakes_offloaded, 0, 0)
+#undef GROUP
+
+/**
+ * Stats about the jemalloc arenas of the proxy threads, see
+ * --proxy-jemalloc-arena. Fragmentation is the share of the active pages
+ * not used by live allocations.
+ */
+#define GROUP ods_stats | basic_stats
+STUI(proxy_arena_allocated_bytes, 0, 0)
+STUI(proxy_arena_active_bytes, 0, 0)
+STUI(proxy_arena_resident_bytes, 0, 0)
+STUI(proxy_arena_max_allocated_bytes, 0, 0)
+STAT(proxy_arena_fragmentation_ratio, stat_double, 0, .dbl = 0.0)
+STUI(proxy_arena_purges, 0, 1)
 #undef GROUP
 
 /**
@@ -154,8 +215,14 @@ STAT(asynclog_duration_us, stat_double, 0, .dbl = 0.0)
 STAT(axon_proxy_duration_us, stat_double, 0, .dbl = 0.0)
 // Proxy requests that are currently being routed.
 STUI(proxy_reqs_processing, 0, 1)
+// Async priority proxy requests that are currently being routed.
+STUI(proxy_async_reqs_processing, 0, 1)
+// Bytes of keys and values of the requests queued up or being routed.
+STUI(proxy_inflight_bytes, 0, 1)
 // Proxy requests queued up and not routed yet
 STUI(proxy_reqs_waiting, 0, 1)
+// asynclog entries waiting to be written to disk
+STUI(asynclog_queue_size, 0, 1)
 // At least one MPMC queue between clients and proxy is full
 STUI(proxy_queue_full, 0, 1)
 // All MPMC queues between clients and proxies are full
@@ -172,6 +239,8 @@ STUI(distribution_replay_xregion_directed_no_prefix_error, 0, 1)
 STUI(distribution_replay_xregion_broadcast, 0, 1)
 STUI(distribution_replay_other, 0, 1)
 STAT(client_queue_notify_period, stat_double, 0, .dbl = 0.0)
+// Client queue notifications avoided by spin polling on the proxy side
+STUI(client_queue_spin_wakeups_avoided, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | detailed_stats
 STUI(proxy_request_num_outstanding, 0, 1)
@@ -196,10 +265,16 @@ STUIR(request_error, 0, 1)
 STUIR(request_success, 0, 1)
 STUIR(request_replied, 0, 1)
 STUIR(client_queue_notifications, 0, 1)
+// requests not sent by CarbonRouterClient::trySend() because of backpressure
+STUIR(client_queue_backpressure, 0, 1)
 STUIR(failover_all, 0, 1)
 STUIR(failover_all_failed, 0, 1)
 STUIR(failover_conditional, 0, 1)
 STUIR(failover_rate_limited, 0, 1)
+// retries (failovers, big value lease-get retries) denied by a RetryBudget
+STUIR(retry_budget_exhausted, 0, 1)
+// requests not sent to a degraded destination (see degraded-* options)
+STUIR(destination_degraded_shed, 0, 1)
 STUIR(failover_inorder_policy, 0, 1)
 STUIR(failover_inorder_policy_failed, 0, 1)
 STUIR(failover_least_failures_policy, 0, 1)
@@ -226,6 +301,40 @@ STUIR(after_request_latency_injected, 0, 1)
 STUIR(before_latency_injected, 0, 1)
 STUIR(after_latency_injected, 0, 1)
 STUIR(total_latency_injected, 0, 1)
+// LatencyInjectionRoute latency_distribution and error_rate
+STUIR(distribution_latency_injected, 0, 1)
+STUIR(error_injected, 0, 1)
+STUIR(near_cache_hits, 0, 1)
+STUIR(near_cache_misses, 0, 1)
+STUIR(near_cache_fills, 0, 1)
+STUIR(near_cache_evictions, 0, 1)
+STUIR(near_cache_invalidations, 0, 1)
+STUIR(hedged_requests, 0, 1)
+STUIR(hedged_requests_won, 0, 1)
+STUIR(coalesced_requests, 0, 1)
+STUIR(coalesced_requests_timeout, 0, 1)
+// McRefillRoute: refills sent to the refill route, misses that joined a
+// refill of the same key already queued, and refills denied by the budget
+STUIR(refill_sent, 0, 1)
+STUIR(refill_coalesced, 0, 1)
+STUIR(refill_budget_exhausted, 0, 1)
+// shadow requests dropped by ShadowThrottle because the proxy is loaded
+STUIR(shadow_requests_shed, 0, 1)
+// times reads from a client connection were paused (or kept paused) because
+// the proxy was overloaded
+STUIR(client_reads_paused_overload, 0, 1)
+// keys copied from warm to cold by ActiveWarmUpRoute, and keys it didn't
+// find in warm
+STUIR(active_warmup_fills, 0, 1)
+STUIR(active_warmup_misses, 0, 1)
+// gets answered as misses by BloomFilterRoute
+STUIR(bloom_filter_misses, 0, 1)
+// L2 hits of L1L2CacheRoute that updated L1, ones that didn't because the
+// key wasn't seen upgradeMinHits times yet, and ones whose update didn't fit
+// in the upgrade queue
+STUIR(l1_upgrades, 0, 1)
+STUIR(l1_upgrades_filtered, 0, 1)
+STUIR(l1_upgrades_dropped, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | count_stats
 STUI(result_error_count, 0, 1)
@@ -264,6 +373,17 @@ STUI(dest_with_no_failure_domain_count, 0, 1)
 STUI(failover_custom_db_enabled_region_count, 0, 1)
 STUI(failover_custom_db_disabled_all_regions_count, 0, 1)
 STUI(request_deadline_num_copy, 0, 1)
+// Requests not sent because the client's timeout budget was spent, and
+// destination timeouts shortened to what was left of it.
+STUI(request_timeout_budget_exceeded, 0, 1)
+STUI(request_timeout_budget_clamped, 0, 1)
+// Requests of disconnected clients dropped before being routed to a
+// destination, and while queued on a connection.
+STUI(request_client_gone_dropped, 0, 1)
+STUI(destination_client_gone_dropped, 0, 1)
+// Requests failed by their timeout while queued for a destination, see
+// target-expire-pending-requests.
+STUI(destination_pending_expired, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | detailed_stats | rate_stats
 STUIR(final_result_error, 0, 1)
@@ -311,6 +431,9 @@ STUI(destination_pending_reqs, 0, 1)
 // Total reqs waiting for reply from server.
 STUI(destination_inflight_reqs, 0, 1)
 STUI(destination_inflight_shadow_reqs, 0, 1)
+// percentage of shadow requests let through by ShadowThrottle, averaged
+// across proxies
+STAT(shadow_effective_percent, stat_double, 0, .dbl = 100.0)
 STAT(destination_batch_size, stat_double, 0, .dbl = 0.0)
 STAT(destination_reqs_dirty_buffer_ratio, stat_double, 0, .dbl = 0.0)
 // duration of the rpc call
@@ -318,6 +441,34 @@ STAT(duration_us, stat_double, 0, .dbl = 0.0)
 // Duration microseconds, broken down by request type (get-like and update-like)
 STAT(duration_get_us, stat_double, 0, .dbl = 0.0)
 STAT(duration_update_us, stat_double, 0, .dbl = 0.0)
+// Percentiles of the above, over roughly the last 16 seconds
+STUI(duration_us_p50, 0, 1)
+STUI(duration_us_p90, 0, 1)
+STUI(duration_us_p99, 0, 1)
+STUI(duration_us_p999, 0, 1)
+STUI(duration_get_us_p50, 0, 1)
+STUI(duration_get_us_p99, 0, 1)
+STUI(duration_update_us_p50, 0, 1)
+STUI(duration_update_us_p99, 0, 1)
+// Scheduling of the proxy threads (with proxy_scheduling_histograms): busy
+// time of event loop iterations, delay from a request being queued to its
+// fiber starting, and fiber run time between yields. The max_proxy stat is
+// the worst proxy's p99 queue delay.
+STUI(proxy_loop_time_us_p50, 0, 1)
+STUI(proxy_loop_time_us_p99, 0, 1)
+STUI(proxy_queue_delay_us_p50, 0, 1)
+STUI(proxy_queue_delay_us_p99, 0, 1)
+STUI(proxy_queue_delay_us_p999, 0, 1)
+STUI(proxy_queue_delay_us_p99_max_proxy, 0, 1)
+STUI(proxy_fiber_run_us_p50, 0, 1)
+STUI(proxy_fiber_run_us_p99, 0, 1)
+// Requests sent to every destination of the config (flush_all): destinations
+// not replied yet, and those replied and failed so far.
+STUI(broadcast_destinations_pending, 0, 1)
+#undef GROUP
+#define GROUP ods_stats | count_stats
+STUI(broadcast_destinations_sent_count, 0, 1)
+STUI(broadcast_destinations_failed_count, 0, 1)
 #undef GROUP
 #define GROUP ods_stats | basic_stats | max_stats
 STUI(destination_max_pending_reqs, 0, 1)
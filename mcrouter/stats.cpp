@@ -13,6 +13,7 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <limits>
 
 #include <folly/Conv.h>
@@ -21,13 +22,23 @@
 #include <folly/json.h>
 
 #include "mcrouter/CarbonRouterInstanceBase.h"
+#include "mcrouter/ClientTrafficSketch.h"
+#include "mcrouter/HotKeySketch.h"
+#include "mcrouter/LatencyHistogram.h"
 #include "mcrouter/McrouterLogFailure.h"
 #include "mcrouter/ProxyBase.h"
 #include "mcrouter/ProxyDestination.h"
 #include "mcrouter/ProxyDestinationMap.h"
+#include "mcrouter/ThreadUtil.h"
+#include "mcrouter/WorstDestinations.h"
 #include "mcrouter/config.h"
 #include "mcrouter/lib/StatsReply.h"
+#include "mcrouter/lib/carbon/CarbonQueueAppender.h"
+#include "mcrouter/lib/debug/RouteProfiler.h"
 #include "mcrouter/lib/fbi/cpp/util.h"
+#include "mcrouter/lib/network/McParser.h"
+#include "mcrouter/lib/network/SocketConnector.h"
+#include "mcrouter/lib/network/WriteBuffer.h"
 #include "mcrouter/lib/network/gen/MemcacheMessages.h"
 
 /**                             .__
@@ -368,6 +379,44 @@ void append_pool_stats(
   for (const auto& mergedPoolStatMapEntry : mergedPoolStatsMap) {
     stats.emplace_back(mergedPoolStatMapEntry.second);
   }
+
+  // Percentiles can't be summed, merge the histograms instead.
+  if (router.opts().num_proxies == 0) {
+    return;
+  }
+  auto* firstProxy = router.getProxyBase(0);
+  for (size_t i = 0; i < firstProxy->stats().numPoolStats(); ++i) {
+    LatencyHistogram::Counts durations{};
+    LatencyHistogram::Counts rtts{};
+    LatencyHistogram::Counts retrans{};
+    LatencyHistogram::Counts keyBytes{};
+    LatencyHistogram::Counts requestValueBytes{};
+    LatencyHistogram::Counts replyValueBytes{};
+    LatencyHistogram::Counts batchSizes{};
+    for (size_t j = 0; j < router.opts().num_proxies; ++j) {
+      auto* poolStats = router.getProxyBase(j)->stats().getPoolStats(i);
+      poolStats->durationHistogram().addWindowTo(durations);
+      poolStats->tcpRttHistogram().addWindowTo(rtts);
+      poolStats->tcpRetransHistogram().addWindowTo(retrans);
+      poolStats->keyBytesHistogram().addWindowTo(keyBytes);
+      poolStats->requestValueBytesHistogram().addWindowTo(requestValueBytes);
+      poolStats->replyValueBytesHistogram().addWindowTo(replyValueBytes);
+      poolStats->batchSizeHistogram().addWindowTo(batchSizes);
+    }
+    auto* poolStats = firstProxy->stats().getPoolStats(i);
+    for (auto& stat : poolStats->getPercentileStats(durations)) {
+      stats.push_back(std::move(stat));
+    }
+    for (auto& stat : poolStats->getSizeStats(
+             keyBytes, requestValueBytes, replyValueBytes, batchSizes)) {
+      stats.push_back(std::move(stat));
+    }
+    if (router.opts().tcp_info_sample_period > 0) {
+      for (auto& stat : poolStats->getTcpInfoStats(rtts, retrans)) {
+        stats.push_back(std::move(stat));
+      }
+    }
+  }
 }
 
 void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
@@ -527,9 +576,78 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
   stat_set(stats, ps_rss_stat, ps_data.rss);
   stat_set(stats, ps_vsize_stat, ps_data.vsize);
 
+  stat_set(stats, write_buffer_pool_hits_stat, WriteBufferQueue::poolHits());
+  stat_set(
+      stats, write_buffer_pool_misses_stat, WriteBufferQueue::poolMisses());
+  stat_set(
+      stats, write_buffer_pool_trimmed_stat, WriteBufferQueue::poolTrimmed());
+  stat_set(
+      stats,
+      write_buffer_storage_pool_hits_stat,
+      carbon::CarbonQueueAppenderStoragePool::hits());
+  stat_set(
+      stats,
+      write_buffer_storage_pool_misses_stat,
+      carbon::CarbonQueueAppenderStoragePool::misses());
+  stat_set(
+      stats,
+      read_buffer_bytes_stat,
+      static_cast<uint64_t>(std::max<int64_t>(McParser::readBufferBytes(), 0)));
+  stat_set(stats, read_buffer_pool_hits_stat, McParser::readBufferPoolHits());
+  stat_set(
+      stats, read_buffer_pool_misses_stat, McParser::readBufferPoolMisses());
+  stat_set(
+      stats,
+      ssl_handshake_offload_queue_depth_stat,
+      sslHandshakeOffloadQueueDepth());
+  stat_set(stats, ssl_handshakes_offloaded_stat, sslHandshakesOffloaded());
+
+  if (router.opts().proxy_jemalloc_arena) {
+    refreshJemallocStats();
+    JemallocArenaStats total;
+    size_t maxAllocated = 0;
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      auto arena = router.getProxyBase(i)->jemallocArena();
+      if (!arena) {
+        continue;
+      }
+      if (auto arenaStats = getJemallocArenaStats(*arena)) {
+        total.allocated += arenaStats->allocated;
+        total.active += arenaStats->active;
+        total.resident += arenaStats->resident;
+        maxAllocated = std::max(maxAllocated, arenaStats->allocated);
+      }
+    }
+    stat_set(
+        stats,
+        proxy_arena_allocated_bytes_stat,
+        static_cast<uint64_t>(total.allocated));
+    stat_set(
+        stats,
+        proxy_arena_active_bytes_stat,
+        static_cast<uint64_t>(total.active));
+    stat_set(
+        stats,
+        proxy_arena_resident_bytes_stat,
+        static_cast<uint64_t>(total.resident));
+    stat_set(
+        stats,
+        proxy_arena_max_allocated_bytes_stat,
+        static_cast<uint64_t>(maxAllocated));
+    stat_set(
+        stats,
+        proxy_arena_fragmentation_ratio_stat,
+        total.active > total.allocated
+            ? 1.0 - static_cast<double>(total.allocated) / total.active
+            : 0.0);
+  }
+
+  stat_set(stats, shadow_effective_percent_stat, 0.0);
   stat_set(stats, fibers_allocated_stat, UINT64_C(0));
   stat_set(stats, fibers_pool_size_stat, UINT64_C(0));
   stat_set(stats, fibers_stack_high_watermark_stat, UINT64_C(0));
+  stat_set(stats, fibers_large_stack_allocated_stat, UINT64_C(0));
+  stat_set(stats, fibers_large_stack_high_watermark_stat, UINT64_C(0));
   for (size_t i = 0; i < router.opts().num_proxies; ++i) {
     auto pr = router.getProxyBase(i);
     stat_incr(
@@ -546,6 +664,22 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
         std::max(
             stat_get_uint64(stats, fibers_stack_high_watermark_stat),
             pr->fiberManager().stackHighWatermark()));
+    if (auto largeFm = pr->largeStackFiberManager()) {
+      stat_incr(
+          stats,
+          fibers_large_stack_allocated_stat,
+          static_cast<int64_t>(largeFm->fibersAllocated()));
+      stat_set(
+          stats,
+          fibers_large_stack_high_watermark_stat,
+          std::max(
+              stat_get_uint64(stats, fibers_large_stack_high_watermark_stat),
+              largeFm->stackHighWatermark()));
+    }
+    stat_incr(
+        stats,
+        shadow_effective_percent_stat,
+        pr->shadowThrottle() ? pr->shadowThrottle()->admitPercent() : 100.0);
     stat_incr(stats, duration_us_stat, pr->stats().durationUs().value());
     stat_incr(stats, duration_get_us_stat, pr->stats().durationGetUs().value());
     stat_incr(
@@ -558,6 +692,10 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
         stats,
         client_queue_notify_period_stat,
         static_cast<int64_t>(pr->queueNotifyPeriod()));
+    stat_incr(
+        stats,
+        client_queue_spin_wakeups_avoided_stat,
+        static_cast<int64_t>(pr->queueSpinWakeupsAvoided()));
     stat_incr(
         stats,
         asynclog_duration_us_stat,
@@ -580,7 +718,85 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
             static_cast<uint64_t>(pr->messageQueueFull() ? 1 : 0)));
   }
 
+  LatencyHistogram::Counts durations{};
+  LatencyHistogram::Counts getDurations{};
+  LatencyHistogram::Counts updateDurations{};
+  for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+    auto pr = router.getProxyBase(i);
+    pr->stats().durationUsHistogram().addWindowTo(durations);
+    pr->stats().durationGetUsHistogram().addWindowTo(getDurations);
+    pr->stats().durationUpdateUsHistogram().addWindowTo(updateDurations);
+  }
+  stat_set(
+      stats, duration_us_p50_stat, LatencyHistogram::percentile(durations, 50));
+  stat_set(
+      stats, duration_us_p90_stat, LatencyHistogram::percentile(durations, 90));
+  stat_set(
+      stats, duration_us_p99_stat, LatencyHistogram::percentile(durations, 99));
+  stat_set(
+      stats,
+      duration_us_p999_stat,
+      LatencyHistogram::percentile(durations, 99.9));
+  stat_set(
+      stats,
+      duration_get_us_p50_stat,
+      LatencyHistogram::percentile(getDurations, 50));
+  stat_set(
+      stats,
+      duration_get_us_p99_stat,
+      LatencyHistogram::percentile(getDurations, 99));
+  stat_set(
+      stats,
+      duration_update_us_p50_stat,
+      LatencyHistogram::percentile(updateDurations, 50));
+  stat_set(
+      stats,
+      duration_update_us_p99_stat,
+      LatencyHistogram::percentile(updateDurations, 99));
+
+  LatencyHistogram::Counts loopTimes{};
+  LatencyHistogram::Counts queueDelays{};
+  LatencyHistogram::Counts fiberRunTimes{};
+  uint64_t maxQueueDelayP99 = 0;
+  for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+    auto& proxyStats = router.getProxyBase(i)->stats();
+    proxyStats.loopTimeUsHistogram().addWindowTo(loopTimes);
+    proxyStats.queueDelayUsHistogram().addWindowTo(queueDelays);
+    proxyStats.fiberRunUsHistogram().addWindowTo(fiberRunTimes);
+    maxQueueDelayP99 = std::max(maxQueueDelayP99, proxyStats.queueDelayUsP99());
+  }
+  stat_set(
+      stats,
+      proxy_loop_time_us_p50_stat,
+      LatencyHistogram::percentile(loopTimes, 50));
+  stat_set(
+      stats,
+      proxy_loop_time_us_p99_stat,
+      LatencyHistogram::percentile(loopTimes, 99));
+  stat_set(
+      stats,
+      proxy_queue_delay_us_p50_stat,
+      LatencyHistogram::percentile(queueDelays, 50));
+  stat_set(
+      stats,
+      proxy_queue_delay_us_p99_stat,
+      LatencyHistogram::percentile(queueDelays, 99));
+  stat_set(
+      stats,
+      proxy_queue_delay_us_p999_stat,
+      LatencyHistogram::percentile(queueDelays, 99.9));
+  stat_set(stats, proxy_queue_delay_us_p99_max_proxy_stat, maxQueueDelayP99);
+  stat_set(
+      stats,
+      proxy_fiber_run_us_p50_stat,
+      LatencyHistogram::percentile(fiberRunTimes, 50));
+  stat_set(
+      stats,
+      proxy_fiber_run_us_p99_stat,
+      LatencyHistogram::percentile(fiberRunTimes, 99));
+
   if (router.opts().num_proxies > 0) {
+    stat_div(stats, shadow_effective_percent_stat, router.opts().num_proxies);
     stat_div(stats, duration_us_stat, router.opts().num_proxies);
     stat_div(stats, duration_get_us_stat, router.opts().num_proxies);
     stat_div(stats, duration_update_us_stat, router.opts().num_proxies);
@@ -624,6 +840,37 @@ void prepare_stats(CarbonRouterInstanceBase& router, stat_t* stats) {
   }
 }
 
+/**
+ * "<lower bound>:<count>" for every power of two with samples in `counts`,
+ * e.g. "0:3 64:120 128:7" (values below 8 are all in the first bucket).
+ */
+static std::string size_histogram_to_str(
+    const LatencyHistogram::Counts& counts) {
+  std::string out;
+  uint64_t lower = 0;
+  uint64_t sum = 0;
+  auto flush = [&]() {
+    if (sum != 0) {
+      if (!out.empty()) {
+        out.push_back(' ');
+      }
+      folly::toAppend(lower, ':', sum, &out);
+    }
+  };
+  for (size_t i = 0; i < counts.size(); ++i) {
+    if (i >= LatencyHistogram::kSubBuckets &&
+        i % LatencyHistogram::kSubBuckets == 0) {
+      flush();
+      lower = uint64_t(1) << (i / LatencyHistogram::kSubBuckets +
+                              LatencyHistogram::kSubBucketsShift - 1);
+      sum = 0;
+    }
+    sum += counts[i];
+  }
+  flush();
+  return out;
+}
+
 static stat_group_t stat_parse_group_str(folly::StringPiece str) {
   if (str == "all") {
     return all_stats;
@@ -641,6 +888,16 @@ static stat_group_t stat_parse_group_str(folly::StringPiece str) {
     return count_stats;
   } else if (str == "external") {
     return external_stats;
+  } else if (str == "hotkeys") {
+    return hot_key_stats;
+  } else if (str == "route_profile") {
+    return route_profile_stats;
+  } else if (str == "worst_servers") {
+    return worst_server_stats;
+  } else if (str == "clients") {
+    return client_stats;
+  } else if (str == "sizes") {
+    return size_stats;
   } else if (str.empty()) {
     return basic_stats;
   } else {
@@ -725,12 +982,9 @@ McStatsReply stats_reply(ProxyBase* proxy, folly::StringPiece group_str) {
             auto& stat = serverStats[key.str()];
             stat.isHardTko = pdstn.tracker()->isHardTko();
             stat.isSoftTko = pdstn.tracker()->isSoftTko();
-            if (pdstn.stats().results) {
-              for (size_t j = 0;
-                   j < static_cast<size_t>(carbon::Result::NUM_RESULTS);
-                   ++j) {
-                stat.results[j] += (*pdstn.stats().results)[j];
-              }
+            const auto& results = *pdstn.stats().results;
+            for (size_t j = 0; j < results.size(); ++j) {
+              stat.results[j] += results[j];
             }
             ++stat.states[(size_t)pdstn.stats().state];
 
@@ -769,6 +1023,121 @@ McStatsReply stats_reply(ProxyBase* proxy, folly::StringPiece group_str) {
     }
   }
 
+  if (groups & hot_key_stats) {
+    const auto& router = proxy->router();
+    std::vector<std::vector<HotKeySketch::Item>> snapshots;
+    uint64_t sampled = 0;
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      if (auto hotKeys = router.getProxyBase(i)->hotKeys()) {
+        snapshots.push_back(hotKeys->snapshot());
+        sampled += hotKeys->total();
+      }
+    }
+    reply.addStat("hot_keys_sampled", folly::to<std::string>(sampled));
+    for (const auto& item :
+         HotKeySketch::merge(snapshots, router.opts().hot_keys_capacity)) {
+      reply.addStat(
+          item.key,
+          folly::format("count:{} error:{}", item.count, item.error).str());
+    }
+  }
+
+  if (groups & route_profile_stats) {
+    const auto& router = proxy->router();
+    std::vector<std::vector<RouteProfiler::Entry>> snapshots;
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      if (auto routeProfiler = router.getProxyBase(i)->routeProfiler()) {
+        snapshots.push_back(routeProfiler->snapshot());
+      }
+    }
+    for (const auto& entry : RouteProfiler::merge(snapshots)) {
+      reply.addStat(
+          entry.name,
+          folly::format(
+              "samples:{} wall_us:{} cpu_us:{} wait_us:{}",
+              entry.samples,
+              entry.wallUs,
+              entry.cpuUs,
+              entry.waitUs())
+              .str());
+    }
+  }
+
+  if (groups & worst_server_stats) {
+    const auto& router = proxy->router();
+    std::vector<std::vector<WorstDestinations::Item>> snapshots;
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      if (auto worst = router.getProxyBase(i)->worstDestinations()) {
+        snapshots.push_back(worst->snapshot());
+      }
+    }
+    for (const auto& item : WorstDestinations::merge(
+             snapshots, router.opts().worst_destinations_count)) {
+      reply.addStat(
+          item.name, folly::format("score_us:{:.0f}", item.score).str());
+    }
+  }
+
+  if (groups & client_stats) {
+    const auto& router = proxy->router();
+    std::vector<std::vector<ClientTrafficSketch::Item>> snapshots;
+    uint64_t sampled = 0;
+    for (size_t i = 0; i < router.opts().num_proxies; ++i) {
+      if (auto clientTraffic = router.getProxyBase(i)->clientTraffic()) {
+        snapshots.push_back(clientTraffic->snapshot());
+        sampled += clientTraffic->total();
+      }
+    }
+    reply.addStat("clients_sampled", folly::to<std::string>(sampled));
+    for (const auto& item : ClientTrafficSketch::merge(
+             snapshots, router.opts().client_stats_capacity)) {
+      reply.addStat(
+          item.client,
+          folly::format(
+              "requests:{} error:{} bytes_in:{} bytes_out:{} duration_us:{}",
+              item.requests,
+              item.error,
+              item.bytesIn,
+              item.bytesOut,
+              item.durationUs)
+              .str());
+    }
+  }
+
+  if (groups & size_stats) {
+    const auto& router = proxy->router();
+    if (router.opts().num_proxies != 0) {
+      auto* firstProxy = router.getProxyBase(0);
+      for (size_t i = 0; i < firstProxy->stats().numPoolStats(); ++i) {
+        LatencyHistogram::Counts keyBytes{};
+        LatencyHistogram::Counts requestValueBytes{};
+        LatencyHistogram::Counts replyValueBytes{};
+        LatencyHistogram::Counts batchSizes{};
+        for (size_t j = 0; j < router.opts().num_proxies; ++j) {
+          auto* poolStats = router.getProxyBase(j)->stats().getPoolStats(i);
+          poolStats->keyBytesHistogram().addWindowTo(keyBytes);
+          poolStats->requestValueBytesHistogram().addWindowTo(
+              requestValueBytes);
+          poolStats->replyValueBytesHistogram().addWindowTo(replyValueBytes);
+          poolStats->batchSizeHistogram().addWindowTo(batchSizes);
+        }
+        const auto& poolName = router.getStatsEnabledPools()[i];
+        reply.addStat(
+            folly::to<std::string>(poolName, ".key_bytes"),
+            size_histogram_to_str(keyBytes));
+        reply.addStat(
+            folly::to<std::string>(poolName, ".request_value_bytes"),
+            size_histogram_to_str(requestValueBytes));
+        reply.addStat(
+            folly::to<std::string>(poolName, ".reply_value_bytes"),
+            size_histogram_to_str(replyValueBytes));
+        reply.addStat(
+            folly::to<std::string>(poolName, ".batch_size"),
+            size_histogram_to_str(batchSizes));
+      }
+    }
+  }
+
   if (groups & external_stats) {
     const auto externalStats =
         proxy->router().externalStatsHandler().getStats();
@@ -76,6 +76,11 @@ enum stat_group_t {
   server_stats = 0x10000,
   suspect_server_stats = 0x40000,
   external_stats = 0x80000,
+  hot_key_stats = 0x100000,
+  route_profile_stats = 0x200000,
+  worst_server_stats = 0x400000,
+  client_stats = 0x800000,
+  size_stats = 0x1000000,
   unknown_stats = 0x10000000,
 };
 
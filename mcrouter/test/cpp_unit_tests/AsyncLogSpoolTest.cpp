@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <unistd.h>
+
+#include <string>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+#include <folly/FileUtil.h>
+#include <folly/experimental/TestUtil.h>
+
+#include "mcrouter/AsyncLogSpool.h"
+
+using namespace facebook::memcache::mcrouter;
+
+using folly::test::TemporaryFile;
+
+namespace {
+
+void writeSpool(int fd, bool compress, size_t numBlocks, size_t perBlock) {
+  auto header = AsyncLogSpoolWriter::fileHeader("svc", "flavor", "region");
+  ASSERT_EQ(header.size(), folly::writeFull(fd, header.data(), header.size()));
+  AsyncLogSpoolWriter writer(compress);
+  std::unordered_map<std::string, uint64_t> attributes{{"al", 1}};
+  for (size_t b = 0; b < numBlocks; ++b) {
+    for (size_t i = 0; i < perBlock; ++i) {
+      writer.add(
+          1000 + b * perBlock + i,
+          "10.0.0.1",
+          11211,
+          "pool",
+          "key:" + std::to_string(b * perBlock + i),
+          attributes);
+    }
+    EXPECT_EQ(perBlock, writer.numEntries());
+    auto block = writer.finishBlock();
+    EXPECT_EQ(0, writer.numEntries());
+    ASSERT_EQ(block.size(), folly::writeFull(fd, block.data(), block.size()));
+  }
+  lseek(fd, 0, SEEK_SET);
+}
+
+void checkRoundTrip(bool compress) {
+  TemporaryFile f("asynclog_spool_test");
+  writeSpool(f.fd(), compress, 3, 100);
+
+  AsyncLogSpoolReader reader(f.fd());
+  EXPECT_EQ("svc", reader.service());
+  EXPECT_EQ("flavor", reader.flavor());
+  EXPECT_EQ("region", reader.region());
+
+  AsyncLogSpoolEntry entry;
+  size_t n = 0;
+  while (reader.next(entry)) {
+    EXPECT_EQ(1000 + n, entry.timestampMs);
+    EXPECT_EQ("10.0.0.1", entry.host);
+    EXPECT_EQ(11211, entry.port);
+    EXPECT_EQ("pool", entry.pool);
+    EXPECT_EQ("key:" + std::to_string(n), entry.key);
+    ASSERT_EQ(1, entry.attributes.size());
+    EXPECT_EQ("al", entry.attributes[0].first);
+    EXPECT_EQ(1, entry.attributes[0].second);
+    ++n;
+  }
+  EXPECT_EQ(300, n);
+}
+
+} // namespace
+
+TEST(AsyncLogSpool, roundTrip) {
+  checkRoundTrip(/* compress */ false);
+}
+
+TEST(AsyncLogSpool, roundTripCompressed) {
+  checkRoundTrip(/* compress */ true);
+}
+
+TEST(AsyncLogSpool, truncatedLastBlock) {
+  TemporaryFile f("asynclog_spool_test");
+  writeSpool(f.fd(), false, 2, 10);
+  off_t size = lseek(f.fd(), 0, SEEK_END);
+  ASSERT_EQ(0, ftruncate(f.fd(), size - 5));
+  lseek(f.fd(), 0, SEEK_SET);
+
+  AsyncLogSpoolReader reader(f.fd());
+  AsyncLogSpoolEntry entry;
+  size_t n = 0;
+  while (reader.next(entry)) {
+    ++n;
+  }
+  EXPECT_EQ(10, n);
+}
+
+TEST(AsyncLogSpool, corruptedBlock) {
+  TemporaryFile f("asynclog_spool_test");
+  writeSpool(f.fd(), false, 1, 10);
+  off_t size = lseek(f.fd(), 0, SEEK_END);
+  ASSERT_EQ(1, pwrite(f.fd(), "X", 1, size - 3));
+  lseek(f.fd(), 0, SEEK_SET);
+
+  AsyncLogSpoolReader reader(f.fd());
+  AsyncLogSpoolEntry entry;
+  EXPECT_THROW(reader.next(entry), std::runtime_error);
+}
+
+TEST(AsyncLogSpool, notASpool) {
+  TemporaryFile f("asynclog_spool_test");
+  std::string data = "[\"AS2.0\", 1.0, \"C\", {}]\n";
+  ASSERT_EQ(data.size(), folly::writeFull(f.fd(), data.data(), data.size()));
+  lseek(f.fd(), 0, SEEK_SET);
+  EXPECT_THROW(AsyncLogSpoolReader reader(f.fd()), std::runtime_error);
+}
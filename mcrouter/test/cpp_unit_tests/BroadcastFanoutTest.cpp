@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/BroadcastFanout.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+TEST(BroadcastFanout, allOk) {
+  BroadcastFanout fanout(2);
+  std::thread other([&fanout] {
+    fanout.addResult(carbon::Result::OK);
+    fanout.addResult(carbon::Result::OK);
+    fanout.sliceDone();
+  });
+  fanout.addResult(carbon::Result::OK);
+  fanout.sliceDone();
+  fanout.wait();
+  other.join();
+
+  auto reply = fanout.reply<McFlushAllReply>();
+  EXPECT_EQ(carbon::Result::OK, *reply.result_ref());
+  EXPECT_TRUE(reply.message_ref()->empty());
+}
+
+TEST(BroadcastFanout, partialFailure) {
+  BroadcastFanout fanout(3);
+  fanout.addResult(carbon::Result::OK);
+  fanout.addResult(carbon::Result::TIMEOUT);
+  fanout.sliceDone();
+  fanout.addResult(carbon::Result::OK);
+  fanout.sliceDone();
+  fanout.addSliceError(carbon::Result::LOCAL_ERROR);
+  fanout.sliceDone();
+  fanout.wait();
+
+  auto reply = fanout.reply<McFlushAllReply>();
+  EXPECT_TRUE(isErrorResult(*reply.result_ref()));
+  EXPECT_EQ(
+      "1 of 3 destinations failed, 1 of 3 proxies didn't send it",
+      *reply.message_ref());
+}
+
+TEST(BroadcastFanout, noDestinations) {
+  BroadcastFanout fanout(1);
+  fanout.sliceDone();
+  fanout.wait();
+  EXPECT_EQ(
+      carbon::Result::OK, *fanout.reply<McFlushAllReply>().result_ref());
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/ClientTrafficSketch.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(ClientTrafficSketch, exactBelowCapacity) {
+  ClientTrafficSketch sketch(4);
+  sketch.record("a", 10, 100, 5);
+  sketch.record("b", 1, 0, 1);
+  sketch.record("a", 20, 0, 7);
+
+  auto items = sketch.snapshot();
+  ASSERT_EQ(2, items.size());
+  EXPECT_EQ("a", items[0].client);
+  EXPECT_EQ(2, items[0].requests);
+  EXPECT_EQ(0, items[0].error);
+  EXPECT_EQ(30, items[0].bytesIn);
+  EXPECT_EQ(100, items[0].bytesOut);
+  EXPECT_EQ(12, items[0].durationUs);
+  EXPECT_EQ("b", items[1].client);
+  EXPECT_EQ(1, items[1].requests);
+  EXPECT_EQ(3, sketch.total());
+}
+
+TEST(ClientTrafficSketch, busyClientsSurviveChurn) {
+  ClientTrafficSketch sketch(4);
+  for (size_t i = 0; i < 1000; ++i) {
+    sketch.record("busy", 1, 1, 1);
+    sketch.record(folly::to<std::string>("idle", i), 1, 1, 1);
+  }
+
+  auto items = sketch.snapshot();
+  ASSERT_EQ(4, items.size());
+  EXPECT_EQ("busy", items[0].client);
+  EXPECT_EQ(1000, items[0].requests);
+  EXPECT_EQ(0, items[0].error);
+  EXPECT_EQ(1000, items[0].bytesIn);
+  for (const auto& item : items) {
+    EXPECT_LE(item.error, item.requests);
+  }
+  EXPECT_EQ(2000, sketch.total());
+}
+
+TEST(ClientTrafficSketch, merge) {
+  std::vector<std::vector<ClientTrafficSketch::Item>> snapshots{
+      {{"a", 10, 1, 100, 10, 50}, {"b", 5, 0, 50, 5, 20}},
+      {{"b", 7, 2, 70, 7, 30}, {"c", 1, 0, 10, 1, 5}},
+  };
+  auto merged = ClientTrafficSketch::merge(snapshots, 2);
+  ASSERT_EQ(2, merged.size());
+  EXPECT_EQ("b", merged[0].client);
+  EXPECT_EQ(12, merged[0].requests);
+  EXPECT_EQ(2, merged[0].error);
+  EXPECT_EQ(120, merged[0].bytesIn);
+  EXPECT_EQ(12, merged[0].bytesOut);
+  EXPECT_EQ(50, merged[0].durationUs);
+  EXPECT_EQ("a", merged[1].client);
+  EXPECT_EQ(10, merged[1].requests);
+}
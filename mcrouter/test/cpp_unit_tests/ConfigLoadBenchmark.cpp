@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <folly/Format.h>
+#include <folly/dynamic.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+
+#include "mcrouter/CarbonRouterInstance.h"
+#include "mcrouter/Proxy.h"
+#include "mcrouter/ProxyConfig.h"
+#include "mcrouter/ProxyConfigBuilder.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+
+/**
+ * Cost of loading a large config, split in the phases of a reconfiguration:
+ *   preprocess  ProxyConfigBuilder: macros, imports and pool parsing
+ *               (ConfigPreprocessor + PoolFactory).
+ *   build       ProxyConfig of every proxy (McRouteHandleProvider).
+ *   swap        Installing the new configs in the proxies.
+ *
+ * The config is synthetic: --pools pools of --hosts hosts each, and
+ * --prefixes routing prefixes, each going to a failover between two pools
+ * with a shadow of a third one. Every phase reports the wall time and the
+ * peak growth of the resident set size, averaged over --iterations runs.
+ */
+
+DEFINE_uint32(pools, 100, "Number of pools in the config");
+DEFINE_uint32(hosts, 20, "Number of hosts in each pool");
+DEFINE_uint32(prefixes, 50, "Number of routing prefixes");
+DEFINE_uint32(proxies, 1, "Number of proxies to build configs for");
+DEFINE_uint32(iterations, 5, "Number of reconfigurations to measure");
+DEFINE_bool(dump_config, false, "Print the generated config and exit");
+
+using facebook::memcache::MemcacheRouterInfo;
+using facebook::memcache::mcrouter::CarbonRouterInstance;
+using facebook::memcache::mcrouter::defaultTestOptions;
+using facebook::memcache::mcrouter::ProxyConfig;
+using facebook::memcache::mcrouter::ProxyConfigBuilder;
+
+namespace {
+
+std::string poolName(size_t pool) {
+  return folly::sformat("pool_{}", pool);
+}
+
+std::string generateConfig() {
+  const size_t numPools = std::max<uint32_t>(FLAGS_pools, 1);
+  folly::dynamic pools = folly::dynamic::object;
+  size_t hostId = 0;
+  for (size_t i = 0; i < numPools; ++i) {
+    folly::dynamic servers = folly::dynamic::array;
+    for (size_t j = 0; j < FLAGS_hosts; ++j, ++hostId) {
+      // Addresses only, nothing connects to them.
+      servers.push_back(folly::sformat(
+          "10.{}.{}.{}:11211",
+          (hostId >> 16) & 0xff,
+          (hostId >> 8) & 0xff,
+          hostId & 0xff));
+    }
+    pools[poolName(i)] = folly::dynamic::object("servers", std::move(servers));
+  }
+
+  // Goes through the preprocessor for every prefix.
+  folly::dynamic macros = folly::dynamic::object(
+      "shadowed_failover",
+      folly::dynamic::object("type", "macroDef")(
+          "params", folly::dynamic::array("primary", "secondary", "shadow"))(
+          "result",
+          folly::dynamic::object("type", "FailoverRoute")(
+              "children",
+              folly::dynamic::array(
+                  folly::dynamic::object("type", "PoolRoute")(
+                      "pool", "%primary%")(
+                      "shadows",
+                      folly::dynamic::array(folly::dynamic::object(
+                          "target", "PoolRoute|%shadow%")(
+                          "key_fraction_range",
+                          folly::dynamic::array(0.0, 0.1)))),
+                  "PoolRoute|%secondary%"))));
+
+  folly::dynamic policies = folly::dynamic::object;
+  for (size_t i = 0; i < FLAGS_prefixes; ++i) {
+    policies[folly::sformat("prefix{}:", i)] = folly::sformat(
+        "@shadowed_failover({},{},{})",
+        poolName(i % numPools),
+        poolName((i + 1) % numPools),
+        poolName((i + 2) % numPools));
+  }
+
+  folly::dynamic config = folly::dynamic::object("macros", std::move(macros))(
+      "pools", std::move(pools))(
+      "route",
+      folly::dynamic::object("type", "PrefixSelectorRoute")(
+          "policies", std::move(policies))(
+          "wildcard", "PoolRoute|" + poolName(0)));
+  return folly::toPrettyJson(config);
+}
+
+/**
+ * Resets the peak RSS of the process (VmHWM), Linux 4.0+.
+ */
+void resetPeakRss() {
+  std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+/**
+ * @return  (current, peak) RSS of the process in KB.
+ */
+std::pair<size_t, size_t> readRss() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  size_t rss = 0;
+  size_t hwm = 0;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmRSS:") == 0) {
+      rss = std::stoul(line.substr(6));
+    } else if (line.compare(0, 6, "VmHWM:") == 0) {
+      hwm = std::stoul(line.substr(6));
+    }
+  }
+  return {rss, hwm};
+}
+
+struct PhaseStats {
+  const char* name;
+  std::chrono::microseconds time{0};
+  size_t peakGrowthKb{0};
+};
+
+template <class F>
+void measure(PhaseStats& stats, F&& phase) {
+  resetPeakRss();
+  const auto before = readRss().first;
+  const auto start = std::chrono::steady_clock::now();
+  phase();
+  stats.time += std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  const auto peak = readRss().second;
+  stats.peakGrowthKb += peak > before ? peak - before : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  const auto config = generateConfig();
+  if (FLAGS_dump_config) {
+    std::printf("%s\n", config.c_str());
+    return 0;
+  }
+
+  auto opts = defaultTestOptions();
+  opts.num_proxies = std::max<uint32_t>(FLAGS_proxies, 1);
+  opts.config_str = R"({ "route": "NullRoute" })";
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "ConfigLoadBenchmark", opts);
+  CHECK(router != nullptr) << "Failed to start the router";
+
+  PhaseStats preprocess{"preprocess"};
+  PhaseStats build{"build"};
+  PhaseStats swap{"swap"};
+  const size_t iterations = std::max<uint32_t>(FLAGS_iterations, 1);
+  for (size_t it = 0; it < iterations; ++it) {
+    std::unique_ptr<ProxyConfigBuilder> builder;
+    measure(preprocess, [&]() {
+      builder = std::make_unique<ProxyConfigBuilder>(
+          opts, router->configApi(), config, MemcacheRouterInfo::name);
+    });
+
+    std::vector<std::shared_ptr<ProxyConfig<MemcacheRouterInfo>>> configs(
+        opts.num_proxies);
+    measure(build, [&]() {
+      for (size_t i = 0; i < opts.num_proxies; ++i) {
+        configs[i] =
+            builder->buildConfig<MemcacheRouterInfo>(*router->getProxy(i), i);
+      }
+    });
+
+    measure(swap, [&]() {
+      for (size_t i = 0; i < opts.num_proxies; ++i) {
+        proxy_config_swap(router->getProxy(i), std::move(configs[i]));
+      }
+    });
+  }
+
+  std::printf(
+      "%u pools x %u hosts, %u prefixes, %zu proxies, config %zu bytes\n",
+      FLAGS_pools,
+      FLAGS_hosts,
+      FLAGS_prefixes,
+      opts.num_proxies,
+      config.size());
+  std::printf("%-12s %14s %18s\n", "phase", "time (ms)", "peak RSS +(KB)");
+  for (const auto* stats : {&preprocess, &build, &swap}) {
+    std::printf(
+        "%-12s %14.3f %18zu\n",
+        stats->name,
+        stats->time.count() / 1000.0 / iterations,
+        stats->peakGrowthKb / iterations);
+  }
+
+  router->shutdown();
+  facebook::memcache::mcrouter::freeAllRouters();
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Range.h>
+#include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/json.h>
+
+#include "mcrouter/ConfigSnapshot.h"
+#include "mcrouter/lib/config/ConfigPreprocessor.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+class MockImportResolver : public ImportResolverIf {
+ public:
+  std::string import(folly::StringPiece path) override {
+    auto it = files.find(path);
+    if (it == files.end()) {
+      throw std::runtime_error("Can not read " + path.str());
+    }
+    return it->second;
+  }
+
+  folly::StringKeyedUnorderedMap<std::string> files;
+};
+
+const char* const kConfig = R"({
+  // comment
+  "pools": "@import(pools.json)",
+  "route": "%ROUTE%"
+})";
+
+ConfigSnapshot makeSnapshot(MockImportResolver& resolver) {
+  folly::StringKeyedUnorderedMap<folly::dynamic> params{
+      {"ROUTE", "PoolRoute|A"}};
+  ConfigSnapshot snapshot;
+  snapshot.key = configSnapshotKey(kConfig, params);
+  RecordingImportResolver recorder(resolver);
+  folly::json::metadata_map configMetadataMap;
+  snapshot.config = ConfigPreprocessor::getConfigWithoutMacros(
+      kConfig, recorder, std::move(params), &configMetadataMap);
+  snapshot.imports = recorder.releaseImports();
+  return snapshot;
+}
+
+} // namespace
+
+TEST(ConfigSnapshot, roundTrip) {
+  MockImportResolver resolver;
+  resolver.files.emplace("pools.json", R"({"A": {"servers": []}})");
+  auto snapshot = makeSnapshot(resolver);
+  EXPECT_EQ(1, snapshot.imports.size());
+
+  auto data = snapshot.serialize();
+  auto loaded = ConfigSnapshot::deserialize(folly::StringPiece(data));
+  ASSERT_TRUE(loaded.hasValue());
+  EXPECT_EQ(snapshot.key, loaded->key);
+  EXPECT_EQ(snapshot.imports, loaded->imports);
+  EXPECT_EQ(snapshot.config, loaded->config);
+  EXPECT_EQ("PoolRoute|A", loaded->config["route"].getString());
+  EXPECT_TRUE(loaded->importsUnchanged(resolver));
+
+  resolver.files["pools.json"] = R"({"A": {"servers": ["localhost:1"]}})";
+  EXPECT_FALSE(loaded->importsUnchanged(resolver));
+  resolver.files.clear();
+  EXPECT_FALSE(loaded->importsUnchanged(resolver));
+}
+
+TEST(ConfigSnapshot, key) {
+  folly::StringKeyedUnorderedMap<folly::dynamic> params{{"a", 1}, {"b", "x"}};
+  auto key = configSnapshotKey(kConfig, params);
+  EXPECT_EQ(key, configSnapshotKey(kConfig, params));
+  EXPECT_NE(key, configSnapshotKey("{}", params));
+  params["b"] = "y";
+  EXPECT_NE(key, configSnapshotKey(kConfig, params));
+}
+
+TEST(ConfigSnapshot, invalidData) {
+  EXPECT_FALSE(ConfigSnapshot::deserialize(folly::StringPiece("")));
+  EXPECT_FALSE(ConfigSnapshot::deserialize(folly::StringPiece("garbage")));
+}
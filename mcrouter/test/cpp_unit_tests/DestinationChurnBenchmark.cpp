@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/dynamic.h>
+#include <folly/fibers/Baton.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <folly/synchronization/Baton.h>
+
+#include "mcrouter/CarbonRouterClient.h"
+#include "mcrouter/CarbonRouterInstance.h"
+#include "mcrouter/Proxy.h"
+#include "mcrouter/ProxyConfigBuilder.h"
+#include "mcrouter/ProxyDestinationBase.h"
+#include "mcrouter/ProxyDestinationMap.h"
+#include "mcrouter/TkoTracker.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/network/AccessPoint.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+
+/**
+ * Destinations flapping during an incident, with reconfigs and request
+ * routing going on at the same time:
+ *   routing   --senders threads send gets, hashed over --pools pools of
+ *             --hosts hosts each, through --proxies proxies.
+ *   flapping  Hosts are closed local ports: requests and probes fail right
+ *             away (connection refused), so hosts get marked TKO and probed
+ *             through the real code paths. Every --flap_interval_ms,
+ *             --flap_percent% of the TKO hosts come back, as if a probe
+ *             succeeded, and get marked TKO again by the next requests.
+ *   reconfig  Every --reconfig_interval_ms, a new config moves
+ *             --churn_percent% of the hosts of every pool to another
+ *             address, so their destinations (and TkoTrackers) are removed
+ *             and new ones created in every proxy.
+ *
+ * Lock hold times are measured from the outside: a prober thread
+ * repeatedly takes each lock through the cheapest call that takes it (a
+ * single hash lookup) and records how long the call took. The prober's own
+ * hold time is constant, so the tail of these latencies is the time spent
+ * waiting for the other holders of the lock, i.e. their hold times.
+ *   destinations  ProxyDestinationMap::destinationsLock_ of every proxy
+ *                 (replace() of a destination that doesn't exist).
+ *   tko_trackers  TkoTrackerMap::mx_ (createPoolTkoTracker() of an
+ *                 existing pool tracker).
+ *   tko_suspects  TkoTrackerMap::suspectsMx_ (getSuspectServersCount()).
+ */
+
+DEFINE_uint32(proxies, 32, "Number of proxies");
+DEFINE_uint32(pools, 100, "Number of pools in the config");
+DEFINE_uint32(hosts, 50, "Number of hosts in each pool");
+DEFINE_uint32(senders, 8, "Number of threads sending requests");
+DEFINE_uint32(duration_s, 10, "How long to run for");
+DEFINE_uint32(base_port, 20000, "First port of the (closed) local hosts");
+DEFINE_uint32(flap_interval_ms, 100, "How often TKO hosts come back");
+DEFINE_uint32(flap_percent, 20, "Percentage of TKO hosts that come back");
+DEFINE_uint32(reconfig_interval_ms, 500, "How often to reconfigure");
+DEFINE_uint32(churn_percent, 10, "Percentage of hosts moved by a reconfig");
+DEFINE_uint32(probe_interval_us, 100, "Pause between two lock probes");
+
+using facebook::memcache::AccessPoint;
+using facebook::memcache::AsyncMcClient;
+using facebook::memcache::McGetReply;
+using facebook::memcache::McGetRequest;
+using facebook::memcache::MemcacheRouterInfo;
+using facebook::memcache::mcrouter::CarbonRouterInstance;
+using facebook::memcache::mcrouter::defaultTestOptions;
+using facebook::memcache::mcrouter::PoolTkoTracker;
+using facebook::memcache::mcrouter::ProxyConfigBuilder;
+
+namespace {
+
+// Requests handed to the client with a single send() call.
+constexpr size_t kBatchSize = 64;
+
+std::string poolName(size_t pool) {
+  return folly::sformat("pool_{}", pool);
+}
+
+/**
+ * Hosts moved by the reconfig of `epoch` alternate between two addresses,
+ * the others stay on 127.0.0.1.
+ */
+std::string generateConfig(size_t epoch) {
+  const size_t numPools = std::max<uint32_t>(FLAGS_pools, 1);
+  const size_t churned = FLAGS_hosts * FLAGS_churn_percent / 100;
+  folly::dynamic pools = folly::dynamic::object;
+  folly::dynamic children = folly::dynamic::array;
+  size_t hostId = 0;
+  for (size_t i = 0; i < numPools; ++i) {
+    folly::dynamic servers = folly::dynamic::array;
+    for (size_t j = 0; j < FLAGS_hosts; ++j, ++hostId) {
+      servers.push_back(folly::sformat(
+          "127.0.0.{}:{}:ascii",
+          j < churned ? 2 + epoch % 2 : 1,
+          FLAGS_base_port + hostId));
+    }
+    pools[poolName(i)] = folly::dynamic::object("servers", std::move(servers));
+    children.push_back("PoolRoute|" + poolName(i));
+  }
+
+  folly::dynamic config = folly::dynamic::object("pools", std::move(pools))(
+      "route",
+      folly::dynamic::object("type", "HashRoute")(
+          "children", std::move(children)));
+  return folly::toJson(config);
+}
+
+struct Latencies {
+  const char* name;
+  std::vector<uint64_t> samplesNs;
+
+  void print() {
+    if (samplesNs.empty()) {
+      std::printf("%-14s %10s\n", name, "no samples");
+      return;
+    }
+    std::sort(samplesNs.begin(), samplesNs.end());
+    auto at = [&](double q) {
+      return samplesNs[std::min(
+                 samplesNs.size() - 1,
+                 static_cast<size_t>(q * samplesNs.size()))] /
+          1000.0;
+    };
+    std::printf(
+        "%-14s %10zu %10.1f %10.1f %10.1f %10.1f\n",
+        name,
+        samplesNs.size(),
+        at(0.5),
+        at(0.99),
+        at(0.999),
+        samplesNs.back() / 1000.0);
+  }
+};
+
+template <class F>
+void timeCall(Latencies& latencies, F&& f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  latencies.samplesNs.push_back(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  const size_t totalHosts = static_cast<size_t>(FLAGS_pools) * FLAGS_hosts;
+  CHECK(FLAGS_base_port + totalHosts <= 65536)
+      << "Too many hosts for --base_port=" << FLAGS_base_port;
+
+  auto opts = defaultTestOptions();
+  opts.num_proxies = std::max<uint32_t>(FLAGS_proxies, 1);
+  opts.config_str = generateConfig(0);
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "DestinationChurnBenchmark", opts);
+  CHECK(router != nullptr) << "Failed to start the router";
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+
+  // Routing.
+  std::atomic<uint64_t> numReplies{0};
+  for (size_t i = 0; i < FLAGS_senders; ++i) {
+    threads.emplace_back([&]() {
+      auto client = router->createClient(
+          0 /* max_outstanding_requests */,
+          false /* max_outstanding_requests_error */);
+      std::vector<McGetRequest> requests(kBatchSize);
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (auto& req : requests) {
+          req.key_ref() = folly::sformat("churn:{}", folly::Random::rand64());
+        }
+        std::atomic<size_t> pending{kBatchSize};
+        folly::fibers::Baton baton;
+        client->send(
+            requests.begin(),
+            requests.end(),
+            [&pending, &baton](const McGetRequest&, McGetReply&&) {
+              if (--pending == 0) {
+                baton.post();
+              }
+            });
+        baton.wait();
+        numReplies += kBatchSize;
+      }
+    });
+  }
+
+  // Flapping: TKO hosts come back, as after a successful probe. Only the
+  // destination responsible for a TKO host can un-TKO it.
+  std::atomic<uint64_t> numUnTkos{0};
+  threads.emplace_back([&]() {
+    while (!stop.load(std::memory_order_relaxed)) {
+      for (size_t i = 0; i < opts.num_proxies; ++i) {
+        auto* proxy = router->getProxy(i);
+        folly::Baton<> done;
+        proxy->eventBase().runInEventBaseThread([&]() {
+          for (auto& dst : proxy->destinationMap()->getAllDestinations()) {
+            auto tracker = dst->tracker();
+            if (tracker && tracker->isTko() &&
+                folly::Random::rand32(100) < FLAGS_flap_percent &&
+                tracker->recordSuccess(dst.get())) {
+              ++numUnTkos;
+            }
+          }
+          done.post();
+        });
+        done.wait();
+      }
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(FLAGS_flap_interval_ms));
+    }
+  });
+
+  // Reconfigs.
+  Latencies reconfigs{"reconfig"};
+  threads.emplace_back([&]() {
+    for (size_t epoch = 1; !stop.load(std::memory_order_relaxed); ++epoch) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(FLAGS_reconfig_interval_ms));
+      const auto config = generateConfig(epoch);
+      timeCall(reconfigs, [&]() {
+        ProxyConfigBuilder builder(
+            opts, router->configApi(), config, MemcacheRouterInfo::name);
+        for (size_t i = 0; i < opts.num_proxies; ++i) {
+          auto* proxy = router->getProxy(i);
+          proxy_config_swap(
+              proxy, builder.buildConfig<MemcacheRouterInfo>(*proxy, i));
+        }
+      });
+    }
+  });
+
+  // Lock probes.
+  Latencies destinations{"destinations"};
+  Latencies tkoTrackers{"tko_trackers"};
+  Latencies tkoSuspects{"tko_suspects"};
+  size_t maxTkos = 0;
+  threads.emplace_back([&]() {
+    const AccessPoint missing("127.0.0.254", 1, mc_ascii_protocol);
+    const std::chrono::milliseconds timeout{opts.server_timeout_ms};
+    // Kept alive, so that every probe finds it.
+    std::shared_ptr<PoolTkoTracker> poolTracker;
+    auto& tkoMap = router->tkoTrackerMap();
+    for (size_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+      auto* map = router->getProxy(i % opts.num_proxies)->destinationMap();
+      timeCall(destinations, [&]() {
+        CHECK(!map->replace<AsyncMcClient>(missing, nullptr, timeout));
+      });
+      timeCall(tkoTrackers, [&]() {
+        poolTracker = tkoMap.createPoolTkoTracker("churn_probe", 1, 1);
+      });
+      timeCall(tkoSuspects, [&]() { tkoMap.getSuspectServersCount(); });
+      maxTkos = std::max(
+          maxTkos,
+          tkoMap.globalTkos().hardTkos.load() +
+              tkoMap.globalTkos().softTkos.load());
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(FLAGS_probe_interval_us));
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::seconds(FLAGS_duration_s));
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  std::printf(
+      "%zu proxies, %u pools x %u hosts, %u senders, %u s\n",
+      opts.num_proxies,
+      FLAGS_pools,
+      FLAGS_hosts,
+      FLAGS_senders,
+      FLAGS_duration_s);
+  std::printf(
+      "routing: %.0f requests/s\n",
+      numReplies.load() / static_cast<double>(FLAGS_duration_s));
+  std::printf(
+      "flapping: %llu un-TKOs, at most %zu hosts TKO at once\n",
+      static_cast<unsigned long long>(numUnTkos.load()),
+      maxTkos);
+  std::printf(
+      "%-14s %10s %10s %10s %10s %10s\n",
+      "(us)",
+      "samples",
+      "p50",
+      "p99",
+      "p99.9",
+      "max");
+  reconfigs.print();
+  destinations.print();
+  tkoTrackers.print();
+  tkoSuspects.print();
+
+  router->shutdown();
+  facebook::memcache::mcrouter::freeAllRouters();
+  return 0;
+}
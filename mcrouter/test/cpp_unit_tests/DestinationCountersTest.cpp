@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/DestinationCounters.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(DestinationCounters, rowsAreStableAndReused) {
+  DestinationCounters counters;
+  std::vector<DestinationCounters::Results*> rows;
+  for (size_t i = 0; i < DestinationCounters::kRowsPerChunk + 1; ++i) {
+    rows.push_back(counters.allocate());
+    ++(*rows.back())[0];
+  }
+  EXPECT_EQ(DestinationCounters::kRowsPerChunk + 1, counters.size());
+  EXPECT_EQ(2 * DestinationCounters::kRowsPerChunk, counters.capacity());
+  // Rows of a chunk are contiguous, in allocation order.
+  EXPECT_EQ(rows[0] + 1, rows[1]);
+  for (auto* row : rows) {
+    EXPECT_EQ(1, (*row)[0]);
+  }
+
+  auto* released = rows[3];
+  (*released)[5] = 7;
+  counters.release(released);
+  EXPECT_EQ(DestinationCounters::kRowsPerChunk, counters.size());
+
+  auto* reused = counters.allocate();
+  EXPECT_EQ(released, reused);
+  for (auto count : *reused) {
+    EXPECT_EQ(0, count);
+  }
+  EXPECT_EQ(2 * DestinationCounters::kRowsPerChunk, counters.capacity());
+}
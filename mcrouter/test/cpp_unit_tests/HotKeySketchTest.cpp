@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/HotKeySketch.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(HotKeySketch, exactBelowCapacity) {
+  HotKeySketch sketch(4);
+  sketch.record("a", 3);
+  sketch.record("b");
+  sketch.record("a");
+
+  auto items = sketch.snapshot();
+  ASSERT_EQ(2, items.size());
+  EXPECT_EQ("a", items[0].key);
+  EXPECT_EQ(4, items[0].count);
+  EXPECT_EQ(0, items[0].error);
+  EXPECT_EQ("b", items[1].key);
+  EXPECT_EQ(1, items[1].count);
+  EXPECT_EQ(5, sketch.total());
+}
+
+TEST(HotKeySketch, heavyHittersSurviveChurn) {
+  HotKeySketch sketch(8);
+  for (size_t i = 0; i < 10000; ++i) {
+    sketch.record("hot1");
+    if (i % 2 == 0) {
+      sketch.record("hot2");
+    }
+    sketch.record(folly::to<std::string>("cold", i));
+  }
+
+  auto items = sketch.snapshot();
+  ASSERT_EQ(8, items.size());
+  EXPECT_EQ("hot1", items[0].key);
+  EXPECT_EQ("hot2", items[1].key);
+  EXPECT_TRUE(sketch.isHot("hot1", 10000));
+  EXPECT_TRUE(sketch.isHot("hot2", 5000));
+  EXPECT_FALSE(sketch.isHot("cold0"));
+  for (const auto& item : items) {
+    EXPECT_LE(item.error, item.count);
+  }
+}
+
+TEST(HotKeySketch, merge) {
+  std::vector<std::vector<HotKeySketch::Item>> snapshots{
+      {{"a", 10, 1}, {"b", 5, 0}},
+      {{"b", 7, 2}, {"c", 1, 0}},
+  };
+  auto merged = HotKeySketch::merge(snapshots, 2);
+  ASSERT_EQ(2, merged.size());
+  EXPECT_EQ("b", merged[0].key);
+  EXPECT_EQ(12, merged[0].count);
+  EXPECT_EQ(2, merged[0].error);
+  EXPECT_EQ("a", merged[1].key);
+  EXPECT_EQ(10, merged[1].count);
+}
+
+TEST(HotKeySketch, clear) {
+  HotKeySketch sketch(2);
+  sketch.record("a");
+  sketch.clear();
+  EXPECT_TRUE(sketch.snapshot().empty());
+  EXPECT_EQ(0, sketch.total());
+  EXPECT_FALSE(sketch.isHot("a"));
+}
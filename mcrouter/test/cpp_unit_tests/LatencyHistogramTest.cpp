@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/LatencyHistogram.h"
+
+using facebook::memcache::mcrouter::LatencyHistogram;
+
+TEST(LatencyHistogram, buckets) {
+  for (uint64_t v = 0; v < 8; ++v) {
+    EXPECT_EQ(v, LatencyHistogram::bucketIndex(v));
+    EXPECT_EQ(v, LatencyHistogram::bucketValue(v));
+  }
+  size_t lastIdx = 0;
+  for (uint64_t v = 1; v < (1 << 30); v = v * 3 / 2 + 1) {
+    auto idx = LatencyHistogram::bucketIndex(v);
+    EXPECT_GE(idx, lastIdx);
+    lastIdx = idx;
+    auto value = LatencyHistogram::bucketValue(idx);
+    EXPECT_LE(v - v / LatencyHistogram::kSubBuckets, value) << v;
+    EXPECT_GE(v + v / LatencyHistogram::kSubBuckets, value) << v;
+  }
+  EXPECT_EQ(
+      LatencyHistogram::kNumBuckets - 1,
+      LatencyHistogram::bucketIndex(uint64_t(1) << 40));
+}
+
+TEST(LatencyHistogram, percentile) {
+  LatencyHistogram h;
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    h.record(v);
+  }
+  h.advance();
+
+  LatencyHistogram::Counts counts{};
+  h.addWindowTo(counts);
+  EXPECT_NEAR(500, LatencyHistogram::percentile(counts, 50), 500 / 8);
+  EXPECT_NEAR(990, LatencyHistogram::percentile(counts, 99), 990 / 8);
+  EXPECT_GE(LatencyHistogram::percentile(counts, 100), 900);
+
+  LatencyHistogram::Counts empty{};
+  EXPECT_EQ(0, LatencyHistogram::percentile(empty, 99));
+}
+
+TEST(LatencyHistogram, merge) {
+  LatencyHistogram fast;
+  LatencyHistogram slow;
+  for (int i = 0; i < 99; ++i) {
+    fast.record(10);
+  }
+  slow.record(100000);
+  fast.advance();
+  slow.advance();
+
+  LatencyHistogram::Counts counts{};
+  fast.addWindowTo(counts);
+  EXPECT_EQ(10, LatencyHistogram::percentile(counts, 99.9));
+  slow.addWindowTo(counts);
+  EXPECT_EQ(10, LatencyHistogram::percentile(counts, 50));
+  EXPECT_NEAR(100000, LatencyHistogram::percentile(counts, 99.9), 100000 / 8);
+}
+
+TEST(LatencyHistogram, decay) {
+  LatencyHistogram h;
+  for (int i = 0; i < 100; ++i) {
+    h.record(1000);
+  }
+  for (int i = 0; i < 200; ++i) {
+    h.advance();
+  }
+  for (int i = 0; i < 100; ++i) {
+    h.record(10);
+  }
+  h.advance();
+
+  LatencyHistogram::Counts counts{};
+  h.addWindowTo(counts);
+  // Old samples are gone entirely, only the ones recorded later remain.
+  EXPECT_EQ(10, LatencyHistogram::percentile(counts, 100));
+  EXPECT_EQ(0, counts[LatencyHistogram::bucketIndex(1000)]);
+  EXPECT_EQ(100, counts[LatencyHistogram::bucketIndex(10)]);
+}
@@ -7,6 +7,7 @@
 
 #include <chrono>
 #include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -149,3 +150,32 @@ TEST(LeaseTokenMap, stress) {
     }
   }
 }
+
+TEST(LeaseTokenMap, concurrent) {
+  auto scheduler = std::make_shared<folly::FunctionScheduler>();
+  scheduler->start();
+  LeaseTokenMap map(scheduler);
+
+  constexpr size_t kNumThreads = 8;
+  constexpr size_t kPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&map, t]() {
+      std::vector<uint64_t> tokens;
+      for (size_t i = 0; i < kPerThread; ++i) {
+        tokens.push_back(map.insert("route01", {t * kPerThread + i, t}));
+      }
+      for (size_t i = 0; i < kPerThread; ++i) {
+        EXPECT_EQ(
+            t * kPerThread + i,
+            map.getOriginalLeaseToken("route01", tokens[i]));
+        assertQueryTrue(map, "route01", tokens[i], {t * kPerThread + i, t});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(map.size(), 0);
+}
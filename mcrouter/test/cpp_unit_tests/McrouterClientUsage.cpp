@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <thread>
 #include <utility>
@@ -13,6 +15,7 @@
 #include <gtest/gtest.h>
 
 #include <folly/fibers/Baton.h>
+#include <folly/synchronization/Baton.h>
 #include <folly/io/async/EventBase.h>
 
 #include "mcrouter/CarbonRouterClient.h"
@@ -723,3 +726,85 @@ TEST(CarbonRouterClient, requestExpiryTestWithLatencyInjectionRoute) {
   server.shutdown();
   EXPECT_TRUE(replyReceived);
 }
+
+TEST(CarbonRouterClient, replyEventBaseUsage) {
+  // Replies are delivered on the EventBase of the caller instead of on the
+  // proxy thread.
+  auto opts = defaultTestOptions();
+  opts.num_proxies = 2;
+  opts.config_str = R"({ "route": "NullRoute" })";
+
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+      "replyEventBaseUsage", opts);
+
+  folly::EventBase evb;
+  auto client = router->createClient(
+      0 /* max_outstanding_requests */,
+      false /* max_outstanding_requests_error */);
+  client->setReplyEventBase(&evb);
+
+  std::vector<McGetRequest> reqs{
+      McGetRequest("key1"), McGetRequest("key2"), McGetRequest("key3")};
+  size_t repliesReceived = 0;
+  client->send(
+      reqs.begin(),
+      reqs.end(),
+      [&evb, &reqs, &repliesReceived](const McGetRequest&, McGetReply&& reply) {
+        EXPECT_TRUE(evb.isInEventBaseThread());
+        EXPECT_EQ(carbon::Result::NOTFOUND, *reply.result_ref());
+        if (++repliesReceived == reqs.size()) {
+          evb.terminateLoopSoon();
+        }
+      });
+
+  evb.loopForever();
+  router->shutdown();
+  EXPECT_EQ(reqs.size(), repliesReceived);
+}
+
+TEST(CarbonRouterClient, trySend) {
+  auto opts = defaultTestOptions();
+  opts.config_str = R"({ "route": "NullRoute" })";
+  opts.num_proxies = 1;
+  opts.client_queue_size = 8;
+  opts.client_queue_backpressure_watermark = 2;
+
+  auto router = CarbonRouterInstance<MemcacheRouterInfo>::init("trySend", opts);
+  using TrySendResult = CarbonRouterClient<MemcacheRouterInfo>::TrySendResult;
+
+  // Keep the proxy busy, so that requests pile up in its queue.
+  folly::Baton<> proxyBlocked;
+  folly::Baton<> unblockProxy;
+  router->getProxyBase(0)->eventBase().runInEventBaseThread([&]() {
+    proxyBlocked.post();
+    unblockProxy.wait();
+  });
+  proxyBlocked.wait();
+
+  const McGetRequest req("key");
+  std::atomic<size_t> numReplies{0};
+  auto callback = [&numReplies](const McGetRequest&, McGetReply&& reply) {
+    EXPECT_EQ(carbon::Result::NOTFOUND, *reply.result_ref());
+    ++numReplies;
+  };
+
+  auto quotaClient = router->createClient(
+      1 /* max_outstanding_requests */,
+      false /* max_outstanding_requests_error */);
+  EXPECT_EQ(TrySendResult::kSent, quotaClient->trySend(req, callback));
+  // Would block with send().
+  EXPECT_EQ(TrySendResult::kQuotaExceeded, quotaClient->trySend(req, callback));
+
+  auto client = router->createClient(
+      0 /* max_outstanding_requests */,
+      false /* max_outstanding_requests_error */);
+  EXPECT_EQ(TrySendResult::kSent, client->trySend(req, callback));
+  EXPECT_EQ(TrySendResult::kBackpressure, client->trySend(req, callback));
+
+  unblockProxy.post();
+  while (numReplies < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  router->shutdown();
+  EXPECT_EQ(2, numReplies);
+}
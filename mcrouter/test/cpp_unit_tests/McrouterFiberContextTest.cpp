@@ -119,6 +119,37 @@ TEST(McrouterFiberContextTest, testExtraDataCallback) {
   });
 }
 
+TEST(McrouterFiberContextTest, extraDataCallbacksCopyOnWrite) {
+  folly::EventBase evb;
+  auto& fm = folly::fibers::getFiberManagerT<fiber_local<RouterInfo>>(evb);
+  fm.addTask([]() {
+    EXPECT_TRUE(fiber_local<RouterInfo>::getExtraDataCallbacks().empty());
+    fiber_local<RouterInfo>::addExtraDataCallbacks([]() -> ExtraDataMap {
+      return {{"0", "0"}};
+    });
+    const auto* parentCallbacks =
+        &fiber_local<RouterInfo>::getExtraDataCallbacks();
+
+    folly::fibers::addTask([parentCallbacks]() {
+      // Not modified: still shared with the parent fiber.
+      EXPECT_EQ(
+          parentCallbacks, &fiber_local<RouterInfo>::getExtraDataCallbacks());
+      fiber_local<RouterInfo>::updateExtraDataCallbacks(
+          0, []() -> ExtraDataMap { return {{"1", "1"}}; });
+      EXPECT_EQ(
+          "{\"1\":\"1\"}",
+          runExtraDataCallbacks(
+              fiber_local<RouterInfo>::getExtraDataCallbacks()));
+    });
+    folly::fibers::yield();
+    EXPECT_EQ(
+        "{\"0\":\"0\"}",
+        runExtraDataCallbacks(
+            fiber_local<RouterInfo>::getExtraDataCallbacks()));
+  });
+  evb.loop();
+}
+
 } // namespace mcrouter
 } // namespace memcache
 } // namespace facebook
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <set>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/ProbeScheduler.h"
+
+using namespace facebook::memcache::mcrouter;
+using std::chrono::milliseconds;
+
+TEST(ProbeScheduler, backoffStaysInBounds) {
+  ProbeScheduler scheduler(milliseconds(1000), milliseconds(60000), 1);
+
+  auto delay = scheduler.start("host:1");
+  EXPECT_LE(500, delay.count());
+  EXPECT_GE(1500, delay.count());
+  EXPECT_EQ(1, scheduler.numProbing());
+
+  for (size_t i = 0; i < 100; ++i) {
+    auto prev = delay;
+    delay = scheduler.next("host:1");
+    EXPECT_LE(1000, delay.count());
+    EXPECT_GE(60000, delay.count());
+    EXPECT_GE(std::max<int64_t>(prev.count() * 3, 1000), delay.count());
+  }
+
+  scheduler.stop("host:1");
+  EXPECT_EQ(0, scheduler.numProbing());
+}
+
+TEST(ProbeScheduler, instancesAreNotInLockstep) {
+  std::set<int64_t> firstDelays;
+  for (uint64_t seed = 0; seed < 10; ++seed) {
+    ProbeScheduler scheduler(milliseconds(10000), milliseconds(60000), seed);
+    firstDelays.insert(scheduler.start("host:1").count());
+  }
+  EXPECT_LT(5, firstDelays.size());
+}
+
+TEST(ProbeScheduler, flappingResumesBackoff) {
+  ProbeScheduler scheduler(milliseconds(10), milliseconds(100000), 1);
+  scheduler.start("host:1");
+  milliseconds delay;
+  for (size_t i = 0; i < 50; ++i) {
+    delay = scheduler.next("host:1");
+  }
+  scheduler.stop("host:1");
+
+  // TKO again right away: no need to probe at the initial rate.
+  auto resumed = scheduler.start("host:1");
+  EXPECT_LE(10, resumed.count());
+  EXPECT_GE(delay.count(), resumed.count());
+
+  // Another proxy taking over keeps the current delay.
+  EXPECT_EQ(resumed, scheduler.start("host:1"));
+  EXPECT_EQ(1, scheduler.numProbing());
+
+  // Other destinations are independent.
+  EXPECT_GE(15, scheduler.start("host:2").count());
+}
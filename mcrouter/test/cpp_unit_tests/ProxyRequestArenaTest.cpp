@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/ProxyRequestArena.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(ProxyRequestArena, bumpAllocation) {
+  alignas(std::max_align_t) char storage[64];
+  ProxyRequestArena arena(storage, sizeof(storage));
+  EXPECT_EQ(sizeof(storage), arena.capacity());
+  EXPECT_EQ(0, arena.used());
+
+  auto p1 = arena.tryAllocate(1, 1);
+  ASSERT_NE(nullptr, p1);
+  EXPECT_TRUE(arena.contains(p1));
+
+  auto p2 = arena.tryAllocate(8, 8);
+  ASSERT_NE(nullptr, p2);
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p2) % 8);
+  EXPECT_EQ(16, arena.used());
+
+  EXPECT_EQ(nullptr, arena.tryAllocate(64, 1));
+  EXPECT_EQ(16, arena.used());
+}
+
+TEST(ProxyRequestArena, heapFallback) {
+  alignas(std::max_align_t) char storage[16];
+  ProxyRequestArena arena(storage, sizeof(storage));
+
+  auto inArena = arena.allocate(16);
+  EXPECT_TRUE(arena.contains(inArena));
+  auto onHeap = arena.allocate(16);
+  EXPECT_FALSE(arena.contains(onHeap));
+
+  arena.deallocate(inArena);
+  arena.deallocate(onHeap);
+}
+
+TEST(ProxyRequestArena, stdAllocator) {
+  alignas(std::max_align_t) char storage[256];
+  ProxyRequestArena arena(storage, sizeof(storage));
+
+  std::vector<int, ProxyRequestArenaAllocator<int>> v(
+      ProxyRequestArenaAllocator<int>{arena});
+  for (int i = 0; i < 100; ++i) {
+    v.push_back(i);
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, v[i]);
+  }
+
+  auto sp = std::allocate_shared<int>(ProxyRequestArenaAllocator<int>{arena});
+  *sp = 42;
+  EXPECT_EQ(42, *sp);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/ProxyRequestStatsBatch.h"
+#include "mcrouter/ProxyStats.h"
+#include "mcrouter/stats.h"
+
+using namespace facebook::memcache::mcrouter;
+
+using DurationKind = ProxyRequestStatsBatch::DurationKind;
+
+TEST(ProxyRequestStatsBatch, flushesAtEndOfLoop) {
+  folly::EventBase evb;
+  ProxyStats stats({});
+  ProxyRequestStatsBatch batch(stats, evb);
+
+  batch.add(carbon::Result::FOUND, true, 100, DurationKind::Get);
+  batch.add(carbon::Result::TIMEOUT, true, 300, DurationKind::Get);
+  batch.add(carbon::Result::TIMEOUT, false, 500, DurationKind::Update);
+  EXPECT_EQ(0, stats.getValue(result_error_all_stat));
+  EXPECT_FALSE(stats.durationUs().hasValue());
+
+  evb.loopOnce();
+
+  EXPECT_EQ(1, stats.getValue(result_error_stat));
+  EXPECT_EQ(2, stats.getValue(result_error_all_stat));
+  EXPECT_EQ(1, stats.getValue(result_data_timeout_stat));
+  EXPECT_EQ(2, stats.getValue(result_data_timeout_all_stat));
+  EXPECT_EQ(0, stats.getValue(result_tko_all_stat));
+
+  // Same as inserting the samples one by one.
+  ExponentialSmoothData<64> expected;
+  expected.insertSample(100);
+  expected.insertSample(300);
+  expected.insertSample(500);
+  EXPECT_DOUBLE_EQ(expected.value(), stats.durationUs().value());
+  ExponentialSmoothData<64> expectedGet;
+  expectedGet.insertSample(100);
+  expectedGet.insertSample(300);
+  EXPECT_DOUBLE_EQ(expectedGet.value(), stats.durationGetUs().value());
+  EXPECT_DOUBLE_EQ(500, stats.durationUpdateUs().value());
+}
+
+TEST(ProxyRequestStatsBatch, flushesWhenFull) {
+  folly::EventBase evb;
+  ProxyStats stats({});
+  ProxyRequestStatsBatch batch(stats, evb);
+
+  for (size_t i = 0; i < ProxyRequestStatsBatch::kMaxDurations; ++i) {
+    batch.add(carbon::Result::TKO, true, 10, DurationKind::Other);
+  }
+  EXPECT_EQ(
+      ProxyRequestStatsBatch::kMaxDurations,
+      stats.getValue(result_tko_all_stat));
+  EXPECT_DOUBLE_EQ(10, stats.durationUs().value());
+  EXPECT_FALSE(stats.durationGetUs().hasValue());
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/QueueDelayMonitor.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(QueueDelayMonitor, standingQueue) {
+  QueueDelayMonitor monitor(/* targetUs */ 1000, /* intervalUs */ 100000);
+  EXPECT_FALSE(monitor.overloaded(0));
+
+  // Over the target, but not for a whole interval yet.
+  monitor.onDequeue(5000, 10000);
+  monitor.onDequeue(5000, 60000);
+  EXPECT_FALSE(monitor.overloaded(60000));
+
+  monitor.onDequeue(5000, 110000);
+  EXPECT_TRUE(monitor.overloaded(110000));
+
+  // A single request under the target ends the overload.
+  monitor.onDequeue(10, 120000);
+  EXPECT_FALSE(monitor.overloaded(120000));
+  monitor.onDequeue(5000, 130000);
+  EXPECT_FALSE(monitor.overloaded(130000));
+}
+
+TEST(QueueDelayMonitor, burst) {
+  QueueDelayMonitor monitor(1000, 100000);
+  for (int64_t now = 0; now < 1000000; now += 10000) {
+    monitor.onDequeue(now % 50000 == 0 ? 10 : 5000, now);
+    EXPECT_FALSE(monitor.overloaded(now));
+  }
+}
+
+TEST(QueueDelayMonitor, drained) {
+  QueueDelayMonitor monitor(1000, 100000);
+  monitor.onDequeue(5000, 0);
+  monitor.onDequeue(5000, 100000);
+  EXPECT_TRUE(monitor.overloaded(150000));
+  // Nothing was dequeued for a whole interval.
+  EXPECT_FALSE(monitor.overloaded(200000));
+}
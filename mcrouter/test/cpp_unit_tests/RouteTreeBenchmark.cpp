@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/Benchmark.h>
+#include <folly/Format.h>
+#include <folly/fibers/Baton.h>
+#include <folly/init/Init.h>
+
+#include "mcrouter/CarbonRouterClient.h"
+#include "mcrouter/CarbonRouterInstance.h"
+#include "mcrouter/config.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+
+/**
+ * End-to-end cost of routing a request through a whole route tree in
+ * process: CarbonRouterClient -> proxy thread -> route tree -> reply
+ * callback. Leaves are NullRoute/ErrorRoute, so no sockets are involved and
+ * the numbers are the cost of mcrouter itself.
+ *
+ * Run with --json (or --bm_json_verbose) to get output that can be compared
+ * across commits, e.g.
+ *   RouteTreeBenchmark --json > before.json
+ *   ...
+ *   RouteTreeBenchmark --bm_relative_to=before.json
+ */
+
+using facebook::memcache::McGetReply;
+using facebook::memcache::McGetRequest;
+using facebook::memcache::MemcacheRouterInfo;
+using facebook::memcache::mcrouter::CarbonRouterClient;
+using facebook::memcache::mcrouter::CarbonRouterInstance;
+using facebook::memcache::mcrouter::defaultTestOptions;
+
+namespace {
+
+// Requests handed to the client with a single send() call.
+constexpr size_t kBatchSize = 64;
+
+struct Router {
+  CarbonRouterInstance<MemcacheRouterInfo>* router{nullptr};
+  CarbonRouterClient<MemcacheRouterInfo>::Pointer client;
+};
+
+std::unordered_map<std::string, Router>& routers() {
+  static std::unordered_map<std::string, Router> routers;
+  return routers;
+}
+
+std::string nullChildren(size_t n) {
+  std::string children;
+  for (size_t i = 0; i < n; ++i) {
+    children += i == 0 ? "\"NullRoute\"" : ", \"NullRoute\"";
+  }
+  return children;
+}
+
+std::string configFor(const std::string& shape) {
+  if (shape == "null") {
+    return R"({ "route": "NullRoute" })";
+  }
+  if (shape == "prefix_selector") {
+    return R"({
+      "route": {
+        "type": "PrefixSelectorRoute",
+        "policies": { "a": "ErrorRoute", "b": "ErrorRoute" },
+        "wildcard": "NullRoute"
+      }
+    })";
+  }
+  if (shape == "hash_8") {
+    return folly::sformat(
+        R"({{ "route": {{ "type": "HashRoute", "children": [{}] }} }})",
+        nullChildren(8));
+  }
+  if (shape == "failover") {
+    return R"({
+      "route": {
+        "type": "FailoverRoute",
+        "children": [ "ErrorRoute", "ErrorRoute", "NullRoute" ]
+      }
+    })";
+  }
+  if (shape == "all_sync_4") {
+    return folly::sformat(
+        R"({{ "route": {{ "type": "AllSyncRoute", "children": [{}] }} }})",
+        nullChildren(4));
+  }
+  if (shape == "operation_selector") {
+    return folly::sformat(
+        R"({{
+          "route": {{
+            "type": "OperationSelectorRoute",
+            "default_policy": "ErrorRoute",
+            "operation_policies": {{
+              "get": {{ "type": "HashRoute", "children": [{}] }}
+            }}
+          }}
+        }})",
+        nullChildren(8));
+  }
+  LOG(FATAL) << "Unknown route shape: " << shape;
+  return "";
+}
+
+Router& getRouter(const std::string& shape) {
+  auto& router = routers()[shape];
+  if (router.router == nullptr) {
+    auto opts = defaultTestOptions();
+    opts.num_proxies = 1;
+    opts.config_str = configFor(shape);
+    router.router = CarbonRouterInstance<MemcacheRouterInfo>::init(
+        "RouteTreeBenchmark_" + shape, opts);
+    CHECK(router.router != nullptr) << "Failed to configure " << shape;
+    router.client = router.router->createClient(
+        0 /* max_outstanding_requests */,
+        false /* max_outstanding_requests_error */);
+  }
+  return router;
+}
+
+void routeRequests(size_t iters, const std::string& shape) {
+  CarbonRouterClient<MemcacheRouterInfo>* client;
+  std::vector<McGetRequest> requests;
+  BENCHMARK_SUSPEND {
+    client = getRouter(shape).client.get();
+    for (size_t i = 0; i < kBatchSize; ++i) {
+      requests.emplace_back(folly::sformat("bench:key:{}", i));
+    }
+  }
+
+  while (iters > 0) {
+    const size_t n = std::min(iters, kBatchSize);
+    std::atomic<size_t> pending{n};
+    folly::fibers::Baton baton;
+    client->send(
+        requests.begin(),
+        requests.begin() + n,
+        [&pending, &baton](const McGetRequest&, McGetReply&&) {
+          if (--pending == 0) {
+            baton.post();
+          }
+        });
+    baton.wait();
+    iters -= n;
+  }
+}
+
+} // namespace
+
+BENCHMARK_NAMED_PARAM(routeRequests, null, "null")
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    routeRequests,
+    prefix_selector,
+    "prefix_selector")
+BENCHMARK_RELATIVE_NAMED_PARAM(routeRequests, hash_8, "hash_8")
+BENCHMARK_RELATIVE_NAMED_PARAM(routeRequests, failover, "failover")
+BENCHMARK_RELATIVE_NAMED_PARAM(routeRequests, all_sync_4, "all_sync_4")
+BENCHMARK_RELATIVE_NAMED_PARAM(
+    routeRequests,
+    operation_selector,
+    "operation_selector")
+
+BENCHMARK_DRAW_LINE();
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv, true);
+
+  folly::runBenchmarks();
+
+  for (auto& it : routers()) {
+    it.second.client.reset();
+  }
+  routers().clear();
+  facebook::memcache::mcrouter::freeAllRouters();
+  return 0;
+}
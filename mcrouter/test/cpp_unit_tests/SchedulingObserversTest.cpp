@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include <folly/fibers/FiberManagerMap.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/LatencyHistogram.h"
+#include "mcrouter/SchedulingObservers.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+uint64_t p50(const LatencyHistogram& h) {
+  LatencyHistogram::Counts counts{};
+  h.addWindowTo(counts);
+  return LatencyHistogram::percentile(counts, 50);
+}
+
+} // namespace
+
+TEST(SchedulingObservers, loopTime) {
+  auto h = std::make_shared<LatencyHistogram>();
+  LoopTimeObserver observer(h);
+  observer.loopSample(1000, 50);
+  observer.loopSample(1000, 50);
+  observer.loopSample(-5, 50);
+  h->advance();
+  EXPECT_NEAR(1000, p50(*h), 1000 / 8);
+}
+
+TEST(SchedulingObservers, fiberRunTime) {
+  LatencyHistogram h;
+  FiberRunTimeObserver observer(h);
+  folly::EventBase evb;
+  auto& fm = folly::fibers::getFiberManager(evb);
+  fm.addObserver(&observer);
+
+  for (int i = 0; i < 3; ++i) {
+    fm.addTask(
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+  }
+  evb.loop();
+  h.advance();
+  EXPECT_LE(20000, p50(h));
+}
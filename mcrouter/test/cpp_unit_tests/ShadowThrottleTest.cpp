@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/ShadowThrottle.h"
+
+using namespace facebook::memcache::mcrouter;
+
+TEST(ShadowThrottle, rampFraction) {
+  // Disabled.
+  EXPECT_EQ(0.0, ShadowThrottle::rampFraction(1000.0, 0.0, 0.0));
+
+  EXPECT_EQ(0.0, ShadowThrottle::rampFraction(50.0, 100.0, 200.0));
+  EXPECT_EQ(0.0, ShadowThrottle::rampFraction(100.0, 100.0, 200.0));
+  EXPECT_DOUBLE_EQ(0.25, ShadowThrottle::rampFraction(125.0, 100.0, 200.0));
+  EXPECT_DOUBLE_EQ(0.5, ShadowThrottle::rampFraction(150.0, 100.0, 200.0));
+  EXPECT_EQ(1.0, ShadowThrottle::rampFraction(200.0, 100.0, 200.0));
+  EXPECT_EQ(1.0, ShadowThrottle::rampFraction(500.0, 100.0, 200.0));
+
+  // Empty ramp is a cliff.
+  EXPECT_EQ(1.0, ShadowThrottle::rampFraction(100.5, 100.0, 100.0));
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/SlowRequestLog.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+SlowRequestLog::Entry makeEntry(size_t i) {
+  SlowRequestLog::Entry entry;
+  entry.request = "get";
+  entry.key = folly::to<std::string>("key", i);
+  entry.startUs = i;
+  SlowRequestLog::Hop hop;
+  hop.destination = "127.0.0.1:11211";
+  hop.durationUs = i;
+  entry.hops.push_back(std::move(hop));
+  return entry;
+}
+
+} // namespace
+
+TEST(SlowRequestLog, keepsLastEntries) {
+  SlowRequestLog log(1000, 3);
+  EXPECT_EQ(1000, log.thresholdUs());
+  EXPECT_TRUE(log.snapshot().empty());
+
+  log.add(makeEntry(0));
+  log.add(makeEntry(1));
+  auto entries = log.snapshot();
+  ASSERT_EQ(2, entries.size());
+  EXPECT_EQ("key0", entries[0].key);
+  EXPECT_EQ("key1", entries[1].key);
+
+  for (size_t i = 2; i < 7; ++i) {
+    log.add(makeEntry(i));
+  }
+  entries = log.snapshot();
+  ASSERT_EQ(3, entries.size());
+  EXPECT_EQ("key4", entries[0].key);
+  EXPECT_EQ("key5", entries[1].key);
+  EXPECT_EQ("key6", entries[2].key);
+  ASSERT_EQ(1, entries[2].hops.size());
+  EXPECT_EQ("127.0.0.1:11211", entries[2].hops[0].destination);
+  EXPECT_EQ(6, entries[2].hops[0].durationUs);
+}
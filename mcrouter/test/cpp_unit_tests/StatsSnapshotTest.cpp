@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <folly/Conv.h>
+
+#include "mcrouter/StatsSnapshot.h"
+
+using namespace facebook::memcache;
+using namespace facebook::memcache::mcrouter;
+
+TEST(StatsSnapshot, collectsGroupsAskedFor) {
+  StatsSnapshot snapshot;
+  std::vector<std::string> collected;
+  size_t round = 0;
+  StatsSnapshot::Collector collector = [&](folly::StringPiece group) {
+    collected.push_back(group.str());
+    McStatsReply reply;
+    reply.stats_ref() =
+        std::vector<std::string>{folly::to<std::string>(group, ":", round)};
+    return reply;
+  };
+
+  // Nothing asked for yet.
+  snapshot.collect(collector);
+  EXPECT_TRUE(collected.empty());
+
+  EXPECT_EQ(nullptr, snapshot.get("all"));
+  EXPECT_EQ(nullptr, snapshot.get("servers"));
+  snapshot.collect(collector);
+  std::sort(collected.begin(), collected.end());
+  EXPECT_EQ(std::vector<std::string>({"all", "servers"}), collected);
+
+  auto all = snapshot.get("all");
+  ASSERT_NE(nullptr, all);
+  EXPECT_EQ(std::vector<std::string>({"all:0"}), *all->stats_ref());
+
+  // Readers keep the reply they got while a new one is published.
+  ++round;
+  snapshot.collect(collector);
+  EXPECT_EQ(std::vector<std::string>({"all:0"}), *all->stats_ref());
+  EXPECT_EQ(
+      std::vector<std::string>({"all:1"}), *snapshot.get("all")->stats_ref());
+  EXPECT_EQ(
+      std::vector<std::string>({"servers:1"}),
+      *snapshot.get("servers")->stats_ref());
+}
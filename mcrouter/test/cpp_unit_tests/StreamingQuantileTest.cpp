@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/StreamingQuantile.h"
+
+using facebook::memcache::mcrouter::StreamingQuantile;
+
+TEST(StreamingQuantile, sanity) {
+  StreamingQuantile q(0.99);
+  EXPECT_EQ(0, q.numSamples());
+  EXPECT_DOUBLE_EQ(0.0, q.value());
+
+  q.insertSample(100);
+  EXPECT_EQ(1, q.numSamples());
+  EXPECT_DOUBLE_EQ(100.0, q.value());
+
+  q.insertSample(100);
+  EXPECT_DOUBLE_EQ(100.0, q.value());
+  q.insertSample(200);
+  EXPECT_LT(100.0, q.value());
+  q.insertSample(1);
+  EXPECT_GT(200.0, q.value());
+
+  q.reset();
+  EXPECT_EQ(0, q.numSamples());
+  EXPECT_DOUBLE_EQ(0.0, q.value());
+}
+
+TEST(StreamingQuantile, converges) {
+  std::mt19937 gen(42);
+  std::lognormal_distribution<double> dist(7.0, 0.5);
+  StreamingQuantile q(0.99);
+  std::vector<double> samples;
+  for (size_t i = 0; i < 20000; ++i) {
+    samples.push_back(dist(gen));
+    q.insertSample(samples.back());
+  }
+  std::sort(samples.begin(), samples.end());
+  auto p99 = samples[samples.size() * 99 / 100];
+  EXPECT_NEAR(p99, q.value(), p99 * 0.15);
+
+  // Follows the distribution when it shifts.
+  for (size_t i = 0; i < 2000; ++i) {
+    q.insertSample(dist(gen) * 3);
+  }
+  EXPECT_NEAR(3 * p99, q.value(), 3 * p99 * 0.25);
+}
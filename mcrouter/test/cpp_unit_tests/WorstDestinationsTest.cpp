@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mcrouter/WorstDestinations.h"
+
+using namespace facebook::memcache::mcrouter;
+
+namespace {
+
+struct Destination {
+  std::string name;
+  bool tracked{false};
+
+  void record(WorstDestinations& worst, double score) {
+    tracked = worst.record(this, tracked, score, [this]() { return name; });
+  }
+};
+
+} // namespace
+
+TEST(WorstDestinations, keepsHighestScores) {
+  WorstDestinations worst(2);
+  Destination a{"a"}, b{"b"}, c{"c"};
+
+  a.record(worst, 10);
+  b.record(worst, 20);
+  EXPECT_TRUE(a.tracked);
+  EXPECT_TRUE(b.tracked);
+
+  // Not worse than the best of the tracked ones: rejected.
+  c.record(worst, 5);
+  EXPECT_FALSE(c.tracked);
+
+  // Replaces a, the least bad one.
+  c.record(worst, 30);
+  EXPECT_TRUE(c.tracked);
+  a.record(worst, 15);
+  EXPECT_FALSE(a.tracked);
+
+  auto items = worst.snapshot();
+  ASSERT_EQ(2, items.size());
+  EXPECT_EQ("c", items[0].name);
+  EXPECT_EQ(30, items[0].score);
+  EXPECT_EQ("b", items[1].name);
+
+  // Tracked destinations get their score updated, even when it improves.
+  b.record(worst, 1);
+  items = worst.snapshot();
+  ASSERT_EQ(2, items.size());
+  EXPECT_EQ("b", items[1].name);
+  EXPECT_EQ(1, items[1].score);
+  a.record(worst, 15);
+  EXPECT_TRUE(a.tracked);
+}
+
+TEST(WorstDestinations, removeAndMerge) {
+  WorstDestinations worst1(2);
+  WorstDestinations worst2(2);
+  Destination a1{"a"}, b1{"b"}, a2{"a"}, c2{"c"};
+  a1.record(worst1, 10);
+  b1.record(worst1, 20);
+  a2.record(worst2, 40);
+  c2.record(worst2, 5);
+
+  worst1.remove(&b1);
+  EXPECT_EQ(1, worst1.snapshot().size());
+
+  auto items =
+      WorstDestinations::merge({worst1.snapshot(), worst2.snapshot()}, 5);
+  ASSERT_EQ(2, items.size());
+  EXPECT_EQ("a", items[0].name);
+  EXPECT_EQ(40, items[0].score);
+  EXPECT_EQ("c", items[1].name);
+
+  EXPECT_EQ(1, WorstDestinations::merge({worst2.snapshot()}, 1).size());
+}
@@ -117,3 +117,30 @@ TEST(RouteHandleFactoryTest, sanity) {
     EXPECT_TRUE(isErrorResult(*reply.result_ref()));
   });
 }
+
+TEST(RouteHandleFactoryTest, maxTreeHeight) {
+  auto router = getTestRouter();
+  auto proxy = router->getProxy(0);
+  PoolFactory pf(
+      folly::dynamic::object(),
+      router->configApi(),
+      folly::json::metadata_map{});
+  McRouteHandleProvider<MemcacheRouterInfo> provider(*proxy, pf);
+  RouteHandleFactory<MemcacheRouteHandleIf> factory(provider, proxy->getId());
+  EXPECT_EQ(0, factory.maxTreeHeight());
+
+  factory.create("ErrorRoute");
+  EXPECT_EQ(1, factory.maxTreeHeight());
+
+  factory.create(folly::dynamic::object("type", "FailoverRoute")("name", "F")(
+      "children", folly::dynamic::array("AllSyncRoute|ErrorRoute")));
+  EXPECT_EQ(3, factory.maxTreeHeight());
+
+  // Reusing a named handle counts its whole tree.
+  factory.create(folly::dynamic::object("type", "AllAsyncRoute")(
+      "children",
+      folly::dynamic::array(
+          folly::dynamic::object("type", "MissFailoverRoute")(
+              "children", folly::dynamic::array("F")))));
+  EXPECT_EQ(5, factory.maxTreeHeight());
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "KeyGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/hash/Hash.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcloadgen {
+
+namespace {
+
+double zeta(uint64_t n, double theta) {
+  double sum = 0;
+  for (uint64_t i = 1; i <= n; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i), theta);
+  }
+  return sum;
+}
+
+} // namespace
+
+ZipfianKeyGenerator::ZipfianKeyGenerator(uint64_t keySpace, double theta)
+    : keySpace_(keySpace), theta_(theta) {
+  if (keySpace_ == 0) {
+    throw std::invalid_argument("zipfian: empty key space");
+  }
+  if (!(theta_ > 0 && theta_ < 1)) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "zipfian: theta must be in (0, 1), got ", theta));
+  }
+  zetaN_ = zeta(keySpace_, theta_);
+  alpha_ = 1.0 / (1.0 - theta_);
+  eta_ = (1.0 - std::pow(2.0 / keySpace_, 1.0 - theta_)) /
+      (1.0 - zeta(2, theta_) / zetaN_);
+}
+
+uint64_t ZipfianKeyGenerator::next(std::mt19937_64& rng) {
+  auto u = dist_(rng);
+  auto uz = u * zetaN_;
+  uint64_t rank;
+  if (uz < 1.0) {
+    rank = 0;
+  } else if (uz < 1.0 + std::pow(0.5, theta_)) {
+    rank = 1;
+  } else {
+    rank = static_cast<uint64_t>(
+        keySpace_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+  }
+  return folly::hash::twang_mix64(std::min(rank, keySpace_ - 1)) % keySpace_;
+}
+
+std::unique_ptr<KeyGenerator> createKeyGenerator(
+    folly::StringPiece distribution,
+    uint64_t keySpace,
+    double zipfTheta) {
+  if (keySpace == 0) {
+    throw std::invalid_argument("key space must not be empty");
+  }
+  if (distribution == "uniform") {
+    return std::make_unique<UniformKeyGenerator>(keySpace);
+  }
+  if (distribution == "zipfian") {
+    return std::make_unique<ZipfianKeyGenerator>(keySpace, zipfTheta);
+  }
+  throw std::invalid_argument(folly::to<std::string>(
+      "unknown key distribution '", distribution, "'"));
+}
+
+} // namespace mcloadgen
+} // namespace memcache
+} // namespace facebook
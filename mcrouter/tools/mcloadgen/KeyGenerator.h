@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcloadgen {
+
+/**
+ * Picks key ids in [0, keySpace).
+ */
+class KeyGenerator {
+ public:
+  virtual ~KeyGenerator() = default;
+
+  virtual uint64_t next(std::mt19937_64& rng) = 0;
+};
+
+/**
+ * Every key is equally likely.
+ */
+class UniformKeyGenerator : public KeyGenerator {
+ public:
+  explicit UniformKeyGenerator(uint64_t keySpace) : dist_(0, keySpace - 1) {}
+
+  uint64_t next(std::mt19937_64& rng) override {
+    return dist_(rng);
+  }
+
+ private:
+  std::uniform_int_distribution<uint64_t> dist_;
+};
+
+/**
+ * Zipfian distribution ("Quickly generating billion-record synthetic
+ * databases", Gray et al.): the i-th most popular key is picked with
+ * probability proportional to 1 / i^theta.
+ *
+ * Popular keys are scattered over the key space, so that they don't all
+ * land on the same server.
+ */
+class ZipfianKeyGenerator : public KeyGenerator {
+ public:
+  /**
+   * @param theta  Skew, in (0, 1). 0.99 is the usual "realistic" value.
+   *
+   * Takes O(keySpace) time.
+   */
+  ZipfianKeyGenerator(uint64_t keySpace, double theta);
+
+  uint64_t next(std::mt19937_64& rng) override;
+
+ private:
+  const uint64_t keySpace_;
+  const double theta_;
+  double zetaN_{0};
+  double alpha_{0};
+  double eta_{0};
+  std::uniform_real_distribution<double> dist_{0.0, 1.0};
+};
+
+/**
+ * @param distribution  "uniform" or "zipfian".
+ *
+ * @throws std::invalid_argument on unknown distribution or bad parameters.
+ */
+std::unique_ptr<KeyGenerator> createKeyGenerator(
+    folly::StringPiece distribution,
+    uint64_t keySpace,
+    double zipfTheta);
+
+} // namespace mcloadgen
+} // namespace memcache
+} // namespace facebook
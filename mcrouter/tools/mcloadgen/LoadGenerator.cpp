@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "LoadGenerator.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/EventBaseLoopController.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/mc/protocol.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/ConnectionOptions.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
+#include "mcrouter/lib/network/gen/MemcacheThriftTransport.h"
+#include "mcrouter/tools/mcloadgen/KeyGenerator.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcloadgen {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int64_t kLatencyBucketUs = 10;
+constexpr int64_t kMaxLatencyUs = 2 * 1000 * 1000;
+
+int64_t toUs(Clock::duration d) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+/**
+ * State shared by the main thread and the threads of one run.
+ */
+struct RunState {
+  Clock::time_point start;
+  Clock::time_point measureStart;
+  Clock::time_point end;
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> numCompleted{0};
+};
+
+template <class Transport>
+class Worker {
+ public:
+  Worker(const Settings& settings, RunState& state, size_t id)
+      : settings_(settings),
+        state_(state),
+        opMix_(settings.opMix),
+        keys_(createKeyGenerator(
+            settings.distribution,
+            settings.keySpace,
+            settings.zipfTheta)),
+        rng_(folly::randomNumberSeed() + id),
+        values_(settings.valueSizeMax, 'v') {}
+
+  void start() {
+    thread_ = std::thread([this] { run(); });
+  }
+
+  Report join() {
+    thread_.join();
+    return std::move(report_);
+  }
+
+ private:
+  const Settings& settings_;
+  RunState& state_;
+  const OpMix opMix_;
+  std::unique_ptr<KeyGenerator> keys_;
+  std::mt19937_64 rng_;
+  const std::string values_;
+  std::thread thread_;
+  Report report_;
+
+  std::vector<std::unique_ptr<Transport>> connections_;
+  size_t inflight_{0};
+  size_t nextConnection_{0};
+
+  void run() {
+    folly::EventBase evb;
+    folly::fibers::FiberManager fm(
+        std::make_unique<folly::fibers::EventBaseLoopController>());
+    dynamic_cast<folly::fibers::EventBaseLoopController&>(fm.loopController())
+        .attachEventBase(evb);
+
+    ConnectionOptions options(
+        settings_.host,
+        settings_.port,
+        mc_string_to_protocol(settings_.protocol.c_str()));
+    options.connectTimeout = std::chrono::milliseconds(settings_.timeoutMs);
+    options.writeTimeout = std::chrono::milliseconds(settings_.timeoutMs);
+    for (size_t i = 0; i < settings_.connectionsPerThread; ++i) {
+      connections_.push_back(std::make_unique<Transport>(evb, options));
+    }
+
+    const size_t maxInflight =
+        settings_.connectionsPerThread * settings_.depth;
+    if (settings_.qps == 0) {
+      for (size_t i = 0; i < maxInflight; ++i) {
+        auto& connection = *connections_[i % connections_.size()];
+        fm.addTask([this, &connection] {
+          while (!state_.stop.load(std::memory_order_relaxed)) {
+            sendOne(connection, Clock::now());
+          }
+        });
+      }
+    } else {
+      fm.addTask([this, &fm, maxInflight] { openLoop(fm, maxInflight); });
+    }
+
+    fm.addTask([this, &evb] {
+      folly::fibers::Baton baton;
+      baton.try_wait_for(state_.end - Clock::now());
+      state_.stop = true;
+      while (inflight_ > 0) {
+        folly::fibers::Baton wait;
+        wait.try_wait_for(std::chrono::milliseconds(1));
+      }
+      for (auto& connection : connections_) {
+        connection->closeNow();
+      }
+      evb.terminateLoopSoon();
+    });
+
+    evb.loopForever();
+    connections_.clear();
+  }
+
+  void openLoop(folly::fibers::FiberManager& fm, size_t maxInflight) {
+    const double perThreadQps =
+        static_cast<double>(settings_.qps) / settings_.numThreads;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / perThreadQps));
+    auto due = state_.start;
+    while (!state_.stop.load(std::memory_order_relaxed)) {
+      auto now = Clock::now();
+      for (; due <= now; due += interval) {
+        if (inflight_ >= maxInflight) {
+          if (due >= state_.measureStart) {
+            ++report_.numSkipped;
+          }
+          continue;
+        }
+        auto& connection =
+            *connections_[nextConnection_++ % connections_.size()];
+        fm.addTask([this, &connection, due] { sendOne(connection, due); });
+        // Reserve the slot right away, the task above runs later.
+        ++inflight_;
+      }
+      folly::fibers::Baton baton;
+      baton.try_wait_for(due - Clock::now());
+    }
+  }
+
+  void sendOne(Transport& connection, Clock::time_point due) {
+    // Closed loop requests are counted here, open loop ones when scheduled.
+    if (settings_.qps == 0) {
+      ++inflight_;
+    }
+    auto op = opMix_.pick(folly::Random::rand64(opMix_.total(), rng_));
+    auto key =
+        folly::to<std::string>(settings_.keyPrefix, keys_->next(rng_));
+    const std::chrono::milliseconds timeout(settings_.timeoutMs);
+
+    carbon::Result result;
+    switch (op) {
+      case Op::kGet:
+        result = *connection.sendSync(McGetRequest(key), timeout).result_ref();
+        break;
+      case Op::kSet: {
+        McSetRequest req(key);
+        auto size = settings_.valueSizeMin +
+            folly::Random::rand64(
+                        settings_.valueSizeMax - settings_.valueSizeMin + 1,
+                        rng_);
+        req.value_ref() = folly::IOBuf(
+            folly::IOBuf::WRAP_BUFFER, values_.data(), size);
+        result = *connection.sendSync(req, timeout).result_ref();
+        break;
+      }
+      default:
+        result =
+            *connection.sendSync(McDeleteRequest(key), timeout).result_ref();
+        break;
+    }
+    --inflight_;
+
+    auto now = Clock::now();
+    if (now < state_.measureStart || now > state_.end) {
+      return;
+    }
+    ++report_.numRequests;
+    ++report_.numByOp[static_cast<size_t>(op)];
+    ++report_.numByResult[result];
+    report_.latencyUs.addValue(std::min(toUs(now - due), kMaxLatencyUs));
+    state_.numCompleted.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+template <class Transport>
+Report runWorkers(
+    const Settings& settings,
+    RunState& state,
+    std::ostream& progress) {
+  std::vector<std::unique_ptr<Worker<Transport>>> workers;
+  for (size_t i = 0; i < settings.numThreads; ++i) {
+    workers.push_back(
+        std::make_unique<Worker<Transport>>(settings, state, i));
+  }
+  for (auto& worker : workers) {
+    worker->start();
+  }
+
+  const auto interval =
+      std::chrono::seconds(std::max<uint32_t>(settings.reportIntervalSec, 1));
+  uint64_t lastCompleted = 0;
+  for (auto next = state.measureStart + interval; next <= state.end;
+       next += interval) {
+    std::this_thread::sleep_until(next);
+    auto completed = state.numCompleted.load(std::memory_order_relaxed);
+    progress << folly::sformat(
+                    "{:>6}s {:>12.0f} req/s",
+                    toUs(next - state.measureStart) / 1000000,
+                    (completed - lastCompleted) /
+                        std::chrono::duration<double>(interval).count())
+             << std::endl;
+    lastCompleted = completed;
+  }
+
+  Report report;
+  for (auto& worker : workers) {
+    report.merge(worker->join());
+  }
+  report.durationSec = settings.durationSec;
+  return report;
+}
+
+} // namespace
+
+folly::StringPiece opName(Op op) {
+  switch (op) {
+    case Op::kGet:
+      return "get";
+    case Op::kSet:
+      return "set";
+    case Op::kDelete:
+      return "delete";
+    default:
+      return "unknown";
+  }
+}
+
+OpMix::OpMix(folly::StringPiece spec) {
+  std::vector<folly::StringPiece> parts;
+  folly::split(',', spec, parts, /* ignoreEmpty */ true);
+  for (auto part : parts) {
+    folly::StringPiece name;
+    uint64_t weight;
+    if (!folly::split(':', part, name, weight)) {
+      throw std::invalid_argument(
+          folly::to<std::string>("bad op mix entry '", part, "'"));
+    }
+    name = folly::trimWhitespace(name);
+    size_t op = 0;
+    while (op < weights_.size() && opName(static_cast<Op>(op)) != name) {
+      ++op;
+    }
+    if (op == weights_.size()) {
+      throw std::invalid_argument(
+          folly::to<std::string>("unknown op '", name, "' in op mix"));
+    }
+    weights_[op] += weight;
+    total_ += weight;
+  }
+  if (total_ == 0) {
+    throw std::invalid_argument("op mix is empty");
+  }
+}
+
+Op OpMix::pick(uint64_t r) const {
+  for (size_t op = 0; op < weights_.size(); ++op) {
+    if (r < weights_[op]) {
+      return static_cast<Op>(op);
+    }
+    r -= weights_[op];
+  }
+  return Op::kGet;
+}
+
+Report::Report() : latencyUs(kLatencyBucketUs, 0, kMaxLatencyUs + 1) {}
+
+void Report::merge(const Report& other) {
+  numRequests += other.numRequests;
+  numSkipped += other.numSkipped;
+  for (size_t op = 0; op < numByOp.size(); ++op) {
+    numByOp[op] += other.numByOp[op];
+  }
+  for (const auto& it : other.numByResult) {
+    numByResult[it.first] += it.second;
+  }
+  latencyUs.merge(other.latencyUs);
+}
+
+void Report::print(std::ostream& out) const {
+  out << folly::sformat(
+             "requests: {}  duration: {}s  throughput: {:.0f} req/s",
+             numRequests,
+             durationSec,
+             durationSec > 0 ? numRequests / durationSec : 0.0)
+      << std::endl;
+  if (numSkipped > 0) {
+    out << "skipped (all connections busy): " << numSkipped << std::endl;
+  }
+  for (size_t op = 0; op < numByOp.size(); ++op) {
+    if (numByOp[op] > 0) {
+      out << "  " << opName(static_cast<Op>(op)) << ": " << numByOp[op]
+          << std::endl;
+    }
+  }
+  out << "results:" << std::endl;
+  for (const auto& it : numByResult) {
+    out << "  " << carbon::resultToString(it.first) << ": " << it.second
+        << std::endl;
+  }
+  out << "latency (us):";
+  for (auto pct : {0.5, 0.9, 0.99, 0.999}) {
+    out << folly::sformat(
+        "  p{}: {}", pct * 100, latencyUs.getPercentileEstimate(pct));
+  }
+  out << std::endl;
+}
+
+LoadGenerator::LoadGenerator(Settings settings)
+    : settings_(std::move(settings)) {}
+
+Report LoadGenerator::run(std::ostream& progress) {
+  if (settings_.numThreads == 0 || settings_.connectionsPerThread == 0 ||
+      settings_.depth == 0) {
+    throw std::invalid_argument(
+        "threads, connections per thread and depth must be positive");
+  }
+  if (settings_.valueSizeMax < settings_.valueSizeMin) {
+    throw std::invalid_argument("value size max < value size min");
+  }
+  // Validate before starting threads.
+  OpMix(settings_.opMix);
+  createKeyGenerator(
+      settings_.distribution, settings_.keySpace, settings_.zipfTheta);
+  auto protocol = mc_string_to_protocol(settings_.protocol.c_str());
+
+  RunState state;
+  state.start = Clock::now();
+  state.measureStart = state.start + std::chrono::seconds(settings_.warmupSec);
+  state.end = state.measureStart + std::chrono::seconds(settings_.durationSec);
+
+  switch (protocol) {
+    case mc_ascii_protocol:
+    case mc_caret_protocol:
+      return runWorkers<AsyncMcClient>(settings_, state, progress);
+    case mc_thrift_protocol:
+      return runWorkers<ThriftTransport<MemcacheRouterInfo>>(
+          settings_, state, progress);
+    default:
+      throw std::invalid_argument(folly::to<std::string>(
+          "unsupported protocol '", settings_.protocol, "'"));
+  }
+}
+
+} // namespace mcloadgen
+} // namespace memcache
+} // namespace facebook
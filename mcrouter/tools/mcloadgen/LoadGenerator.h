@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/stats/Histogram.h>
+
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcloadgen {
+
+struct Settings {
+  std::string host{"localhost"};
+  uint16_t port{11211};
+  // "ascii", "caret" or "thrift".
+  std::string protocol{"caret"};
+
+  size_t numThreads{4};
+  size_t connectionsPerThread{1};
+  // Requests in flight per connection.
+  size_t depth{8};
+  // Target requests per second over all threads. 0 means closed loop: every
+  // connection keeps `depth` requests in flight, back to back.
+  uint64_t qps{0};
+
+  uint32_t durationSec{10};
+  uint32_t warmupSec{0};
+  uint32_t reportIntervalSec{1};
+  uint32_t timeoutMs{1000};
+
+  uint64_t keySpace{100000};
+  std::string keyPrefix{"mcloadgen:"};
+  // "uniform" or "zipfian".
+  std::string distribution{"uniform"};
+  double zipfTheta{0.99};
+
+  // Values are between valueSizeMin and valueSizeMax bytes (uniformly).
+  size_t valueSizeMin{100};
+  size_t valueSizeMax{100};
+
+  // Comma separated "op:weight" list, with ops from get, set and delete.
+  std::string opMix{"get:90,set:10"};
+};
+
+enum class Op : size_t {
+  kGet,
+  kSet,
+  kDelete,
+  kNumOps,
+};
+
+folly::StringPiece opName(Op op);
+
+/**
+ * Relative weights of the operations to send.
+ */
+class OpMix {
+ public:
+  /**
+   * @throws std::invalid_argument on malformed spec.
+   */
+  explicit OpMix(folly::StringPiece spec);
+
+  /**
+   * @param r  Uniformly distributed in [0, total()).
+   */
+  Op pick(uint64_t r) const;
+
+  uint64_t total() const {
+    return total_;
+  }
+
+ private:
+  std::array<uint64_t, static_cast<size_t>(Op::kNumOps)> weights_{};
+  uint64_t total_{0};
+};
+
+struct Report {
+  Report();
+
+  double durationSec{0};
+  uint64_t numRequests{0};
+  // Open loop only: requests that were due while all connections were busy.
+  uint64_t numSkipped{0};
+  std::array<uint64_t, static_cast<size_t>(Op::kNumOps)> numByOp{};
+  std::map<carbon::Result, uint64_t> numByResult;
+  // In microseconds.
+  folly::Histogram<int64_t> latencyUs;
+
+  void merge(const Report& other);
+
+  void print(std::ostream& out) const;
+};
+
+/**
+ * Sends load to a single memcache server (or mcrouter) from numThreads
+ * threads, each with its own event base and connections, and measures
+ * throughput and latency.
+ *
+ * In open loop mode latencies are measured from the time a request was due,
+ * not when it was sent, so queueing in the load generator counts too.
+ */
+class LoadGenerator {
+ public:
+  explicit LoadGenerator(Settings settings);
+
+  /**
+   * Runs the load for settings.durationSec (after warmup), printing the
+   * throughput to `progress` every reportIntervalSec.
+   *
+   * @throws std::invalid_argument on bad settings.
+   */
+  Report run(std::ostream& progress);
+
+ private:
+  const Settings settings_;
+};
+
+} // namespace mcloadgen
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/program_options.hpp>
+
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <folly/logging/Init.h>
+#include <glog/logging.h>
+
+#include "mcrouter/tools/mcloadgen/LoadGenerator.h"
+
+using namespace facebook::memcache::mcloadgen;
+
+namespace {
+
+std::string getUsage(const char* binaryName) {
+  return folly::sformat(
+      "Usage: {} [OPTION]...\n"
+      "Sends get/set/delete load to a memcache server or mcrouter and "
+      "reports throughput and latency.\n"
+      "Without --qps, every connection keeps --depth requests in flight "
+      "(closed loop). With --qps, requests are sent at a fixed rate "
+      "(open loop).\n",
+      binaryName);
+}
+
+Settings parseOptions(int argc, char** argv) {
+  Settings settings;
+
+  namespace po = boost::program_options;
+
+  po::options_description opts("Allowed options");
+  opts.add_options()("help,h", "Print this help message.")(
+      "host,H",
+      po::value<std::string>(&settings.host)->default_value(settings.host),
+      "Host to send requests to.")(
+      "port,p",
+      po::value<uint16_t>(&settings.port)->default_value(settings.port),
+      "Port to send requests to.")(
+      "protocol,P",
+      po::value<std::string>(&settings.protocol)
+          ->default_value(settings.protocol),
+      "\"ascii\", \"caret\" or \"thrift\".")(
+      "threads,t",
+      po::value<size_t>(&settings.numThreads)
+          ->default_value(settings.numThreads),
+      "Number of client threads.")(
+      "connections,c",
+      po::value<size_t>(&settings.connectionsPerThread)
+          ->default_value(settings.connectionsPerThread),
+      "Connections per thread.")(
+      "depth,d",
+      po::value<size_t>(&settings.depth)->default_value(settings.depth),
+      "Requests in flight per connection.")(
+      "qps,q",
+      po::value<uint64_t>(&settings.qps)->default_value(settings.qps),
+      "Target requests per second over all threads; 0 means closed loop.")(
+      "duration,D",
+      po::value<uint32_t>(&settings.durationSec)
+          ->default_value(settings.durationSec),
+      "Seconds to measure for.")(
+      "warmup,w",
+      po::value<uint32_t>(&settings.warmupSec)
+          ->default_value(settings.warmupSec),
+      "Seconds to send load for before measuring.")(
+      "report-interval,i",
+      po::value<uint32_t>(&settings.reportIntervalSec)
+          ->default_value(settings.reportIntervalSec),
+      "Print the throughput every <arg> seconds.")(
+      "timeout-ms",
+      po::value<uint32_t>(&settings.timeoutMs)
+          ->default_value(settings.timeoutMs),
+      "Request and connect timeout.")(
+      "key-space,k",
+      po::value<uint64_t>(&settings.keySpace)
+          ->default_value(settings.keySpace),
+      "Number of distinct keys.")(
+      "key-prefix",
+      po::value<std::string>(&settings.keyPrefix)
+          ->default_value(settings.keyPrefix),
+      "Prepended to every key.")(
+      "distribution",
+      po::value<std::string>(&settings.distribution)
+          ->default_value(settings.distribution),
+      "Key popularity; \"uniform\" or \"zipfian\".")(
+      "zipf-theta",
+      po::value<double>(&settings.zipfTheta)
+          ->default_value(settings.zipfTheta),
+      "Skew of the zipfian distribution, in (0, 1).")(
+      "value-size-min",
+      po::value<size_t>(&settings.valueSizeMin)
+          ->default_value(settings.valueSizeMin),
+      "Minimum size of set values.")(
+      "value-size-max",
+      po::value<size_t>(&settings.valueSizeMax)
+          ->default_value(settings.valueSizeMax),
+      "Maximum size of set values.")(
+      "op-mix,o",
+      po::value<std::string>(&settings.opMix)->default_value(settings.opMix),
+      "Comma separated op:weight list, e.g. \"get:90,set:9,delete:1\".");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, opts), vm);
+    po::notify(vm);
+  } catch (po::error& ex) {
+    LOG(ERROR) << ex.what();
+    exit(1);
+  }
+
+  if (vm.count("help")) {
+    std::cerr << getUsage(argv[0]) << std::endl;
+    opts.print(std::cerr);
+    exit(0);
+  }
+
+  return settings;
+}
+
+} // anonymous namespace
+
+FOLLY_INIT_LOGGING_CONFIG(".=WARNING,folly=INFO; default:async=true");
+
+int main(int argc, char** argv) {
+  // Just give the binary name to folly::init() because we use
+  // boost::program_options instead of gflags.
+  int tempArgc = 1;
+  folly::init(&tempArgc, &argv, false);
+
+  auto settings = parseOptions(argc, argv);
+  try {
+    LoadGenerator loadGenerator(std::move(settings));
+    loadGenerator.run(std::cerr).print(std::cout);
+  } catch (const std::invalid_argument& ex) {
+    LOG(ERROR) << ex.what();
+    return 1;
+  }
+  return 0;
+}
@@ -108,7 +108,13 @@ class ClientServerMcParser {
       this->dispatchTypedRequest(headerInfo, buffer);
     }
 
+    template <class Request>
+    void onMetaRequest(Request&& req, const McAsciiMetaFlags& /* meta */) {
+      callback_.requestReady(0, std::move(req));
+    }
+
     void multiOpEnd() {}
+    void metaNoop() {}
     void parseError(carbon::Result, folly::StringPiece) {}
 
    private:
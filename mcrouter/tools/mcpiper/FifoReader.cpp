@@ -8,8 +8,10 @@
 #include "FifoReader.h"
 
 #include <fcntl.h>
+#include <sys/stat.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <vector>
 
@@ -189,6 +191,18 @@ void FifoReadCallback::forwardMessage(
   }
 }
 
+void FifoReadCallback::feed(folly::ByteRange data) noexcept {
+  while (!data.empty()) {
+    void* buf;
+    size_t len;
+    getReadBuffer(&buf, &len);
+    len = std::min(len, data.size());
+    std::memcpy(buf, data.data(), len);
+    readDataAvailable(len);
+    data.advance(len);
+  }
+}
+
 void FifoReadCallback::readEOF() noexcept {
   LOG(INFO) << "Fifo \"" << fifoName_ << "\" disconnected";
 }
@@ -201,12 +215,17 @@ FifoReaderManager::FifoReaderManager(
     folly::EventBase& evb,
     MessageReadyFn messageReady,
     std::string dir,
-    std::unique_ptr<boost::regex> filenamePattern)
+    std::unique_ptr<boost::regex> filenamePattern,
+    uint32_t ringSamplePeriod,
+    std::string ringMatch)
     : evb_(evb),
       messageReady_(std::move(messageReady)),
       directory_(std::move(dir)),
-      filenamePattern_(std::move(filenamePattern)) {
+      filenamePattern_(std::move(filenamePattern)),
+      ringSamplePeriod_(ringSamplePeriod),
+      ringMatch_(std::move(ringMatch)) {
   runScanDirectory();
+  runPollRings();
 }
 
 std::vector<std::string> FifoReaderManager::getMatchedFiles() const {
@@ -246,6 +265,9 @@ void FifoReaderManager::runScanDirectory() {
     if (fifoReaders_.find(fifo) != fifoReaders_.end()) {
       continue;
     }
+    if (tryAddRing(fifo)) {
+      continue;
+    }
     auto fd = ::open(fifo.c_str(), O_RDONLY | O_NONBLOCK);
     if (fd >= 0) {
       auto pipeReader = folly::AsyncPipeReader::UniquePtr(
@@ -263,10 +285,57 @@ void FifoReaderManager::runScanDirectory() {
       [this]() { runScanDirectory(); }, kPollDirectoryIntervalMs);
 }
 
+bool FifoReaderManager::tryAddRing(const std::string& path) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  auto it = ringReaders_.find(path);
+  if (it != ringReaders_.end()) {
+    if (it->second.first->inode() == st.st_ino) {
+      return true;
+    }
+    // The writer restarted.
+    ringReaders_.erase(it);
+  }
+  auto ring = ShmRingReader::open(path);
+  if (!ring) {
+    return false;
+  }
+  ringReaders_.emplace(
+      path,
+      RingReader(
+          std::move(ring),
+          std::make_unique<FifoReadCallback>(path, messageReady_)));
+  return true;
+}
+
+void FifoReaderManager::runPollRings() {
+  if (!running_) {
+    return;
+  }
+  auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+                   .count();
+  for (auto& it : ringReaders_) {
+    auto& ring = *it.second.first;
+    auto& callback = *it.second.second;
+    ring.heartbeat(nowMs, ringSamplePeriod_, ringMatch_);
+    auto lost = ring.read([&callback](folly::ByteRange record) {
+      callback.feed(record);
+    });
+    if (lost > 0) {
+      VLOG(1) << "Fell behind reading \"" << it.first << "\", messages lost";
+    }
+  }
+  evb_.runAfterDelay([this]() { runPollRings(); }, kPollRingsIntervalMs);
+}
+
 void FifoReaderManager::unregisterCallbacks() {
   for (auto& fifoReader : fifoReaders_) {
     fifoReader.second.first->setReadCB(nullptr);
   }
+  running_ = false;
 }
 
 } // namespace memcache
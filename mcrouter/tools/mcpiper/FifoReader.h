@@ -21,6 +21,7 @@
 #include <folly/io/async/AsyncSocketException.h>
 
 #include "mcrouter/lib/debug/ConnectionFifoProtocol.h"
+#include "mcrouter/lib/debug/ShmRing.h"
 #include "mcrouter/lib/network/gen/MemcacheRouterInfo.h"
 
 namespace folly {
@@ -65,6 +66,11 @@ class FifoReadCallback : public folly::AsyncReader::ReadCallback {
   void readEOF() noexcept final;
   void readErr(const folly::AsyncSocketException& ex) noexcept final;
 
+  /**
+   * Processes data not read from a pipe (i.e. a shared memory ring record).
+   */
+  void feed(folly::ByteRange data) noexcept;
+
  private:
   static constexpr uint64_t kMinSize{256};
   folly::IOBufQueue readBuffer_{folly::IOBufQueue::cacheChainLength()};
@@ -93,7 +99,8 @@ class FifoReadCallback : public folly::AsyncReader::ReadCallback {
 };
 
 /**
- * Manages all fifo readers in a directory.
+ * Manages all fifo readers in a directory. Files that are shared memory
+ * rings (see ShmRingWriter) are polled instead.
  */
 class FifoReaderManager {
  public:
@@ -109,12 +116,18 @@ class FifoReaderManager {
    *                        read from the fifo.
    * @param dir             Directory to watch.
    * @param filenamePattern Regex that file names must match.
+   * @param ringSamplePeriod  Asks ring writers to only write one in every
+   *                          ringSamplePeriod messages.
+   * @param ringMatch         Asks ring writers to only write messages
+   *                          containing this string.
    */
   FifoReaderManager(
       folly::EventBase& evb,
       MessageReadyFn messageReady,
       std::string dir,
-      std::unique_ptr<boost::regex> filenamePattern);
+      std::unique_ptr<boost::regex> filenamePattern,
+      uint32_t ringSamplePeriod = 0,
+      std::string ringMatch = "");
 
   // non-copyable
   FifoReaderManager(const FifoReaderManager&) = delete;
@@ -130,15 +143,26 @@ class FifoReaderManager {
       folly::AsyncPipeReader::UniquePtr,
       std::unique_ptr<FifoReadCallback>>;
 
+  using RingReader = std::pair<
+      std::unique_ptr<ShmRingReader>,
+      std::unique_ptr<FifoReadCallback>>;
+
   static constexpr size_t kPollDirectoryIntervalMs = 1000;
+  static constexpr size_t kPollRingsIntervalMs = 10;
   folly::EventBase& evb_;
   MessageReadyFn messageReady_;
   const std::string directory_;
   const std::unique_ptr<boost::regex> filenamePattern_;
+  const uint32_t ringSamplePeriod_;
+  const std::string ringMatch_;
   std::unordered_map<std::string, FifoReader> fifoReaders_;
+  std::unordered_map<std::string, RingReader> ringReaders_;
+  bool running_{true};
 
   std::vector<std::string> getMatchedFiles() const;
   void runScanDirectory();
+  void runPollRings();
+  bool tryAddRing(const std::string& path);
 };
 } // namespace memcache
 } // namespace facebook
@@ -12,6 +12,7 @@
 #include "mcrouter/lib/network/CarbonMessageList.h"
 #include "mcrouter/tools/mcpiper/FifoReader.h"
 #include "mcrouter/tools/mcpiper/MessagePrinter.h"
+#include "mcrouter/tools/mcpiper/ParserPool.h"
 
 using namespace facebook::memcache::mcpiper;
 
@@ -23,9 +24,13 @@ namespace {
 
 const std::unordered_set<size_t> kNotSupporttedTypes = {McStatsReply::typeId};
 
-MessagePrinter::Options getOptions(const Settings& settings, McPiper* mcpiper) {
+MessagePrinter::Options getOptions(
+    const Settings& settings,
+    McPiper* mcpiper,
+    TrafficRecorder* recorder) {
   MessagePrinter::Options options;
 
+  options.recorder = recorder;
   options.numAfterMatch = settings.numAfterMatch;
   options.quiet = settings.quiet;
   options.raw = settings.raw;
@@ -133,19 +138,41 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
     std::cerr << "Filename pattern: " << *filenamePattern << std::endl;
   }
 
-  messagePrinter_ = std::make_unique<MessagePrinter>(
-      getOptions(settings, this),
-      getFilter(settings),
-      createValueFormatter(),
-      targetOut);
+  if (!settings.recordPath.empty()) {
+    try {
+      recorder_ = std::make_unique<TrafficRecorder>(settings.recordPath);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << e.what();
+      exit(1);
+    }
+    std::cerr << "Recording requests to " << settings.recordPath << std::endl;
+  }
 
-  std::unordered_map<
-      uint64_t,
-      std::unique_ptr<SnifferParserBase<MessagePrinter>>>
-      parserMap;
+  auto options = getOptions(settings, this, recorder_.get());
+  options.stats = &stats_;
+  auto filter = getFilter(settings);
+  // The recorder takes the time of the current message from the reader
+  // thread, so recording is always done on that thread.
+  const size_t numParserThreads = recorder_ ? 1 : settings.numParserThreads;
+  if (numParserThreads > 1) {
+    parserPool_ = std::make_unique<ParserPool>(
+        numParserThreads,
+        [&options, &filter](std::ostream& out) {
+          return std::make_unique<MessagePrinter>(
+              options, filter, createValueFormatter(), out);
+        },
+        targetOut);
+  } else {
+    messagePrinter_ = std::make_unique<MessagePrinter>(
+        std::move(options),
+        std::move(filter),
+        createValueFormatter(),
+        targetOut);
+    parsers_ = std::make_unique<ConnectionParsers>(*messagePrinter_);
+  }
 
   // Callback from fifoManager. Read the data and feed the correct parser.
-  auto fifoReaderCallback = [&parserMap, this](
+  auto fifoReaderCallback = [this](
                                 uint64_t connectionId,
                                 uint64_t packetId,
                                 folly::SocketAddress from,
@@ -160,20 +187,30 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
     if (kNotSupporttedTypes.find(typeId) != kNotSupporttedTypes.end()) {
       return;
     }
-    auto it = parserMap.find(connectionId);
-    if (it == parserMap.end()) {
-      it = addCarbonSnifferParser(
-          routerName, parserMap, connectionId, *messagePrinter_);
+    if (parserPool_) {
+      parserPool_->feed(
+          connectionId,
+          packetId,
+          std::move(from),
+          std::move(to),
+          typeId,
+          msgStartTime,
+          std::move(routerName),
+          data);
+      return;
     }
-    auto& snifferParser = it->second;
-
-    if (packetId == 0) {
-      snifferParser->resetParser();
+    if (recorder_) {
+      recorder_->setCurrentTimeUs(msgStartTime);
     }
-
-    snifferParser->setAddresses(std::move(from), std::move(to));
-    snifferParser->setCurrentMsgStartTime(msgStartTime);
-    snifferParser->parse(data, typeId, packetId == 0 /* isFirstPacket */);
+    parsers_->parse(
+        connectionId,
+        packetId,
+        std::move(from),
+        std::move(to),
+        typeId,
+        msgStartTime,
+        routerName,
+        data);
   };
 
   initCompression();
@@ -182,13 +219,22 @@ void McPiper::run(Settings settings, std::ostream& targetOut) {
       eventBase_,
       fifoReaderCallback,
       settings.fifoRoot,
-      std::move(filenamePattern));
+      std::move(filenamePattern),
+      settings.ringSamplePeriod,
+      settings.ringMatch);
 
   while (running_) {
     eventBase_.loopOnce();
   }
 
   fifoReaderManager_.reset();
+  // Finishes printing what was already read.
+  parserPool_.reset();
+  if (recorder_) {
+    std::cerr << recorder_->numRecorded() << " requests recorded."
+              << std::endl;
+    recorder_.reset();
+  }
 }
 
 } // namespace mcpiper
@@ -15,6 +15,8 @@
 #include "mcrouter/tools/mcpiper/Config.h"
 #include "mcrouter/tools/mcpiper/FifoReader.h"
 #include "mcrouter/tools/mcpiper/MessagePrinter.h"
+#include "mcrouter/tools/mcpiper/ParserPool.h"
+#include "mcrouter/tools/mcpiper/TrafficRecorder.h"
 
 namespace facebook {
 namespace memcache {
@@ -42,6 +44,14 @@ struct Settings {
   std::string protocol;
   bool raw{false};
   bool script{false};
+  uint32_t ringSamplePeriod{0};
+  std::string ringMatch;
+  // If not empty, matching requests are recorded to this file (see
+  // TrafficRecorder) instead of being printed.
+  std::string recordPath;
+  // Number of threads parsing and printing messages; 1 does everything on
+  // the thread reading the fifos.
+  size_t numParserThreads{1};
 };
 
 class McPiper {
@@ -51,12 +61,17 @@ class McPiper {
   void stop();
 
   const MessagePrinter::Stats& stats() const noexcept {
-    return messagePrinter_->stats();
+    return stats_;
   }
 
  private:
+  // Shared by all the message printers.
+  MessagePrinter::Stats stats_;
   folly::EventBase eventBase_;
+  std::unique_ptr<TrafficRecorder> recorder_;
   std::unique_ptr<MessagePrinter> messagePrinter_;
+  std::unique_ptr<ConnectionParsers> parsers_;
+  std::unique_ptr<ParserPool> parserPool_;
   std::unique_ptr<FifoReaderManager> fifoReaderManager_;
   std::atomic<bool> running_{false};
 };
@@ -17,6 +17,7 @@
 #include "mcrouter/tools/mcpiper/Color.h"
 #include "mcrouter/tools/mcpiper/Config.h"
 #include "mcrouter/tools/mcpiper/McPiperVisitor.h"
+#include "mcrouter/tools/mcpiper/TrafficRecorder.h"
 #include "mcrouter/tools/mcpiper/Util.h"
 
 namespace facebook {
@@ -94,7 +95,11 @@ void MessagePrinter::requestReady(
           from,
           to,
           protocol)) {
-    if (options_.raw) {
+    if (options_.recorder) {
+      if (options_.recorder->record(request)) {
+        countStats();
+      }
+    } else if (options_.raw) {
       printRawRequest(msgId, request, protocol);
     } else {
       printMessage(out.value());
@@ -122,6 +127,9 @@ void MessagePrinter::replyReady(
           protocol,
           latencyUs,
           rpcStatsContext.serverLoad)) {
+    if (options_.recorder) {
+      return;
+    }
     stats_.numBytesBeforeCompression +=
         rpcStatsContext.replySizeBeforeCompression;
     stats_.numBytesAfterCompression +=
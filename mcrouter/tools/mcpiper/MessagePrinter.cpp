@@ -46,7 +46,8 @@ MessagePrinter::MessagePrinter(
     : options_(std::move(options)),
       filter_(std::move(filter)),
       valueFormatter_(std::move(valueFormatter)),
-      targetOut_(targetOut) {
+      targetOut_(targetOut),
+      stats_(options_.stats ? *options_.stats : ownStats_) {
   if (options_.disableColor) {
     targetOut_.setColorOutput(false);
   }
@@ -24,11 +24,20 @@
 namespace facebook {
 namespace memcache {
 
+class TrafficRecorder;
+
 /**
  * Class responsible for formatting and printing requests and replies.
  */
 class MessagePrinter {
  public:
+  struct Stats {
+    std::atomic<uint64_t> totalMessages{0};
+    std::atomic<uint64_t> printedMessages{0};
+    std::atomic<uint64_t> numBytesBeforeCompression{0};
+    std::atomic<uint64_t> numBytesAfterCompression{0};
+  };
+
   /**
    * Format settings
    */
@@ -58,13 +67,14 @@ class MessagePrinter {
 
     // Machine-readable JSON format (has no effect if raw is true)
     bool script{false};
-  };
 
-  struct Stats {
-    std::atomic<uint64_t> totalMessages{0};
-    std::atomic<uint64_t> printedMessages{0};
-    std::atomic<uint64_t> numBytesBeforeCompression{0};
-    std::atomic<uint64_t> numBytesAfterCompression{0};
+    // If set, matching requests are written to this trace instead of being
+    // printed, and replies are dropped.
+    TrafficRecorder* recorder{nullptr};
+
+    // If set, stats are accounted here rather than in the printer, so that
+    // several printers can share them (and maxMessages).
+    Stats* stats{nullptr};
   };
 
   /**
@@ -76,7 +86,7 @@ class MessagePrinter {
     uint32_t valueMinSize{0};
     uint32_t valueMaxSize{std::numeric_limits<uint32_t>::max()};
     int64_t minLatencyUs{0}; // 0 means include all messages
-    std::unique_ptr<boost::regex> pattern;
+    std::shared_ptr<const boost::regex> pattern;
     bool invertMatch{false};
     folly::Optional<mc_protocol_t> protocol;
   };
@@ -120,7 +130,8 @@ class MessagePrinter {
 
   std::unique_ptr<ValueFormatter> valueFormatter_;
   AnsiColorCodeStream targetOut_;
-  Stats stats_;
+  Stats ownStats_;
+  Stats& stats_;
   uint32_t afterMatchCount_{0};
 
   // SnifferParser Callbacks
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "ParserPool.h"
+
+#include <algorithm>
+
+#include <folly/Conv.h>
+#include <folly/system/ThreadName.h>
+
+#include "mcrouter/tools/mcpiper/Config.h"
+
+namespace facebook {
+namespace memcache {
+
+void ConnectionParsers::parse(
+    uint64_t connectionId,
+    uint64_t packetId,
+    folly::SocketAddress from,
+    folly::SocketAddress to,
+    uint32_t typeId,
+    uint64_t msgStartTime,
+    const std::string& routerName,
+    folly::ByteRange data) {
+  auto it = parsers_.find(connectionId);
+  if (it == parsers_.end()) {
+    it = addCarbonSnifferParser(routerName, parsers_, connectionId, printer_);
+  }
+  auto& snifferParser = it->second;
+
+  if (packetId == 0) {
+    snifferParser->resetParser();
+  }
+
+  snifferParser->setAddresses(std::move(from), std::move(to));
+  snifferParser->setCurrentMsgStartTime(msgStartTime);
+  snifferParser->parse(data, typeId, packetId == 0 /* isFirstPacket */);
+}
+
+ParserPool::ParserPool(
+    size_t numWorkers,
+    const PrinterFactory& factory,
+    std::ostream& out,
+    size_t queueSize)
+    : out_(out) {
+  for (size_t i = 0; i < std::max<size_t>(numWorkers, 1); ++i) {
+    auto worker = std::make_unique<Worker>(queueSize);
+    worker->printer = factory(worker->out);
+    worker->parsers = std::make_unique<ConnectionParsers>(*worker->printer);
+    workers_.push_back(std::move(worker));
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    auto& worker = *workers_[i];
+    worker.thread = std::thread([this, &worker, i] {
+      folly::setThreadName(folly::to<std::string>("mcpiper-parse-", i));
+      run(worker);
+    });
+  }
+}
+
+ParserPool::~ParserPool() {
+  for (auto& worker : workers_) {
+    worker->queue.blockingWrite(nullptr);
+  }
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void ParserPool::feed(
+    uint64_t connectionId,
+    uint64_t packetId,
+    folly::SocketAddress from,
+    folly::SocketAddress to,
+    uint32_t typeId,
+    uint64_t msgStartTime,
+    std::string routerName,
+    folly::ByteRange data) {
+  auto packet = std::make_unique<Packet>(Packet{
+      nextSeq_++,
+      connectionId,
+      packetId,
+      std::move(from),
+      std::move(to),
+      typeId,
+      msgStartTime,
+      std::move(routerName),
+      std::string(reinterpret_cast<const char*>(data.data()), data.size())});
+  workers_[connectionId % workers_.size()]->queue.blockingWrite(
+      std::move(packet));
+}
+
+void ParserPool::run(Worker& worker) {
+  std::unique_ptr<Packet> packet;
+  while (true) {
+    worker.queue.blockingRead(packet);
+    if (!packet) {
+      return;
+    }
+    worker.parsers->parse(
+        packet->connectionId,
+        packet->packetId,
+        std::move(packet->from),
+        std::move(packet->to),
+        packet->typeId,
+        packet->msgStartTime,
+        packet->routerName,
+        folly::ByteRange(folly::StringPiece(packet->data)));
+    // Packets that print nothing still need to be accounted for, so that
+    // the packets fed after them can be written out.
+    output(packet->seq, worker.out.str());
+    worker.out.str("");
+  }
+}
+
+void ParserPool::output(uint64_t seq, std::string text) {
+  std::lock_guard<std::mutex> lock(outputMutex_);
+  if (seq != nextOutputSeq_) {
+    pendingOutput_.emplace(seq, std::move(text));
+    return;
+  }
+  bool written = !text.empty();
+  out_ << text;
+  ++nextOutputSeq_;
+  for (auto it = pendingOutput_.begin();
+       it != pendingOutput_.end() && it->first == nextOutputSeq_;
+       it = pendingOutput_.erase(it)) {
+    written |= !it->second.empty();
+    out_ << it->second;
+    ++nextOutputSeq_;
+  }
+  if (written) {
+    out_.flush();
+  }
+}
+
+} // namespace memcache
+} // namespace facebook
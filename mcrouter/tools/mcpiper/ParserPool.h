@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/MPMCQueue.h>
+#include <folly/Range.h>
+#include <folly/SocketAddress.h>
+
+#include "mcrouter/tools/mcpiper/MessagePrinter.h"
+#include "mcrouter/tools/mcpiper/SnifferParser.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * The sniffer parsers of all the connections seen in the fifos, all feeding
+ * the same message printer.
+ */
+class ConnectionParsers {
+ public:
+  explicit ConnectionParsers(MessagePrinter& printer) : printer_(printer) {}
+
+  /**
+   * Feeds a packet read from a fifo to the parser of its connection.
+   * See MessageReadyFn for the parameters.
+   */
+  void parse(
+      uint64_t connectionId,
+      uint64_t packetId,
+      folly::SocketAddress from,
+      folly::SocketAddress to,
+      uint32_t typeId,
+      uint64_t msgStartTime,
+      const std::string& routerName,
+      folly::ByteRange data);
+
+ private:
+  MessagePrinter& printer_;
+  std::unordered_map<
+      uint64_t,
+      std::unique_ptr<SnifferParserBase<MessagePrinter>>>
+      parsers_;
+};
+
+/**
+ * Parses and prints packets on several worker threads.
+ *
+ * All the packets of a connection go to the same worker, so they're parsed
+ * in order. Every worker prints to a buffer of its own; the output of each
+ * packet is written out in the order the packets were fed, regardless of
+ * which worker finished first.
+ */
+class ParserPool {
+ public:
+  /**
+   * Creates the message printer of a worker, printing to the given stream.
+   */
+  using PrinterFactory =
+      std::function<std::unique_ptr<MessagePrinter>(std::ostream&)>;
+
+  /**
+   * @param numWorkers  Number of worker threads.
+   * @param factory     Creates the printers of the workers.
+   * @param out         Where the merged output is written.
+   * @param queueSize   Max number of packets waiting for each worker; feed()
+   *                    blocks when the queue of the worker is full.
+   */
+  ParserPool(
+      size_t numWorkers,
+      const PrinterFactory& factory,
+      std::ostream& out,
+      size_t queueSize = 16 * 1024);
+
+  /**
+   * Processes the packets already fed and joins the workers.
+   */
+  ~ParserPool();
+
+  ParserPool(const ParserPool&) = delete;
+  ParserPool& operator=(const ParserPool&) = delete;
+
+  /**
+   * Queues a packet for the worker of its connection.
+   * Must always be called from the same thread.
+   */
+  void feed(
+      uint64_t connectionId,
+      uint64_t packetId,
+      folly::SocketAddress from,
+      folly::SocketAddress to,
+      uint32_t typeId,
+      uint64_t msgStartTime,
+      std::string routerName,
+      folly::ByteRange data);
+
+ private:
+  struct Packet {
+    uint64_t seq;
+    uint64_t connectionId;
+    uint64_t packetId;
+    folly::SocketAddress from;
+    folly::SocketAddress to;
+    uint32_t typeId;
+    uint64_t msgStartTime;
+    std::string routerName;
+    std::string data;
+  };
+
+  struct Worker {
+    explicit Worker(size_t queueSize) : queue(queueSize) {}
+
+    // nullptr tells the worker to exit.
+    folly::MPMCQueue<std::unique_ptr<Packet>> queue;
+    std::ostringstream out;
+    std::unique_ptr<MessagePrinter> printer;
+    std::unique_ptr<ConnectionParsers> parsers;
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  uint64_t nextSeq_{0};
+
+  std::mutex outputMutex_;
+  std::ostream& out_;
+  // Sequence number of the next packet to be written out.
+  uint64_t nextOutputSeq_{0};
+  // Output of packets done before some packet fed earlier.
+  std::map<uint64_t, std::string> pendingOutput_;
+
+  void run(Worker& worker);
+  void output(uint64_t seq, std::string text);
+};
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "TrafficRecorder.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+
+namespace facebook {
+namespace memcache {
+
+TrafficRecorder::TrafficRecorder(const std::string& path)
+    : file_(fopen(path.c_str(), "wb")) {
+  if (file_ == nullptr ||
+      fwrite(kTraceMagic.data(), kTraceMagic.size(), 1, file_) != 1) {
+    throw std::runtime_error(folly::to<std::string>(
+        "Can't create trace file '", path, "': ", strerror(errno)));
+  }
+}
+
+TrafficRecorder::~TrafficRecorder() {
+  if (file_) {
+    fclose(file_);
+  }
+}
+
+bool TrafficRecorder::write(
+    uint32_t typeId,
+    const struct iovec* iovs,
+    size_t iovsCount) {
+  size_t length = 0;
+  for (size_t i = 0; i < iovsCount; ++i) {
+    length += iovs[i].iov_len;
+  }
+  TraceRecordHeader header;
+  header.timeUs = folly::Endian::little(currentTimeUs_);
+  header.typeId = folly::Endian::little(typeId);
+  header.length = folly::Endian::little(static_cast<uint32_t>(length));
+  if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+    return false;
+  }
+  for (size_t i = 0; i < iovsCount; ++i) {
+    if (iovs[i].iov_len > 0 &&
+        fwrite(iovs[i].iov_base, iovs[i].iov_len, 1, file_) != 1) {
+      return false;
+    }
+  }
+  ++numRecorded_;
+  return true;
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <folly/Range.h>
+
+#include "mcrouter/lib/network/McSerializedRequest.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Trace file format, shared by TrafficRecorder and TrafficReplayer.
+ *
+ * The file starts with kTraceMagic, followed by records made of a
+ * TraceRecordHeader (little endian) and the request serialized in caret.
+ */
+constexpr folly::StringPiece kTraceMagic{"MCTRACE1"};
+
+struct __attribute__((__packed__)) TraceRecordHeader {
+  // Time the request was sent by mcrouter, in microseconds.
+  uint64_t timeUs;
+  uint32_t typeId;
+  uint32_t length;
+};
+
+/**
+ * Writes the requests captured by mcpiper to a trace file, so they can be
+ * replayed later (see TrafficReplayer).
+ */
+class TrafficRecorder {
+ public:
+  /**
+   * @throws std::runtime_error  if the file cannot be created.
+   */
+  explicit TrafficRecorder(const std::string& path);
+  ~TrafficRecorder();
+
+  TrafficRecorder(const TrafficRecorder&) = delete;
+  TrafficRecorder& operator=(const TrafficRecorder&) = delete;
+
+  /**
+   * Time of the message about to be parsed, as reported by mcrouter.
+   */
+  void setCurrentTimeUs(uint64_t timeUs) {
+    currentTimeUs_ = timeUs;
+  }
+
+  /**
+   * Appends the request to the trace.
+   *
+   * @return  false if the request could not be serialized or written.
+   */
+  template <class Request>
+  bool record(const Request& request) {
+    McSerializedRequest serialized(
+        request, 1 /* reqId */, mc_caret_protocol, CodecIdRange::Empty);
+    if (serialized.serializationResult() != McSerializedRequest::Result::OK) {
+      return false;
+    }
+    return write(
+        serialized.typeId(), serialized.getIovs(), serialized.getIovsCount());
+  }
+
+  uint64_t numRecorded() const {
+    return numRecorded_;
+  }
+
+ private:
+  FILE* file_{nullptr};
+  uint64_t currentTimeUs_{0};
+  uint64_t numRecorded_{0};
+
+  bool write(uint32_t typeId, const struct iovec* iovs, size_t iovsCount);
+};
+
+} // namespace memcache
+} // namespace facebook
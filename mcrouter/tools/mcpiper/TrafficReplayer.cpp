@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "TrafficReplayer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+#include <folly/Format.h>
+#include <folly/Optional.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/EventBaseLoopController.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/io/async/EventBase.h>
+
+#include "mcrouter/lib/mc/protocol.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/ConnectionOptions.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/lib/network/gen/MemcacheServer.h"
+#include "mcrouter/tools/mcpiper/ClientServerMcParser.h"
+#include "mcrouter/tools/mcpiper/TrafficRecorder.h"
+
+namespace facebook {
+namespace memcache {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int64_t kLatencyBucketUs = 10;
+constexpr int64_t kMaxLatencyUs = 2 * 1000 * 1000;
+
+int64_t toUs(Clock::duration d) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+void sleepFor(Clock::duration d) {
+  folly::fibers::Baton baton;
+  baton.try_wait_for(d);
+}
+
+/**
+ * Reads the trace and sends its requests; runs on a fiber. Also the callback
+ * of the parser that turns the records back into typed requests.
+ */
+class Replay {
+ public:
+  Replay(
+      const TrafficReplayer::Settings& settings,
+      folly::fibers::FiberManager& fm,
+      AsyncMcClient& client,
+      TrafficReplayer::Report& report)
+      : settings_(settings), fm_(fm), client_(client), report_(report) {}
+
+  void run(FILE* file) {
+    ClientServerMcParser<Replay, memcache::detail::MemcacheRequestList> parser(
+        *this);
+    TraceRecordHeader header;
+    std::string body;
+    folly::Optional<uint64_t> firstTimeUs;
+    const auto start = Clock::now();
+
+    while (fread(&header, sizeof(header), 1, file) == 1) {
+      body.resize(folly::Endian::little(header.length));
+      if (body.empty() || fread(&body[0], body.size(), 1, file) != 1) {
+        // Truncated, e.g. mcpiper was killed while recording.
+        ++report_.numBadRecords;
+        break;
+      }
+
+      const auto timeUs = folly::Endian::little(header.timeUs);
+      if (!firstTimeUs) {
+        firstTimeUs = timeUs;
+      }
+      due_ = start;
+      if (settings_.speed > 0 && timeUs > *firstTimeUs) {
+        due_ += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(
+                (timeUs - *firstTimeUs) / settings_.speed));
+      }
+      if (settings_.speed > 0) {
+        sleepFor(due_ - Clock::now());
+      } else {
+        // As fast as possible: wait for a free slot instead of skipping.
+        while (inflight_ >= settings_.maxInflight) {
+          sleepFor(std::chrono::milliseconds(1));
+        }
+      }
+
+      parsed_ = false;
+      parser.parse(
+          folly::ByteRange(folly::StringPiece(body)),
+          folly::Endian::little(header.typeId),
+          true /* isFirstPacket */);
+      if (!parsed_) {
+        ++report_.numBadRecords;
+        parser.reset();
+      }
+    }
+
+    while (inflight_ > 0) {
+      sleepFor(std::chrono::milliseconds(1));
+    }
+    report_.durationSec =
+        std::chrono::duration<double>(Clock::now() - start).count();
+  }
+
+  // ClientServerMcParser callbacks
+  template <class Request>
+  void requestReady(uint64_t /* reqId */, Request&& request) {
+    parsed_ = true;
+    if (inflight_ >= settings_.maxInflight) {
+      ++report_.numSkipped;
+      return;
+    }
+    ++inflight_;
+    fm_.addTask([this, req = std::move(request), due = due_]() {
+      const auto sent = Clock::now();
+      auto reply = client_.sendSync(
+          req, std::chrono::milliseconds(settings_.timeoutMs));
+      const auto now = Clock::now();
+      --inflight_;
+
+      ++report_.numRequests;
+      ++report_.numByResult[*reply.result_ref()];
+      report_.latencyUs.addValue(std::min(toUs(now - sent), kMaxLatencyUs));
+      report_.lagUs.addValue(
+          std::min(std::max<int64_t>(toUs(sent - due), 0), kMaxLatencyUs));
+    });
+  }
+
+  template <class Reply>
+  void replyReady(uint64_t, Reply&&, RpcStatsContext) {}
+
+ private:
+  const TrafficReplayer::Settings& settings_;
+  folly::fibers::FiberManager& fm_;
+  AsyncMcClient& client_;
+  TrafficReplayer::Report& report_;
+
+  // Scheduled send time of the record being parsed.
+  Clock::time_point due_;
+  bool parsed_{false};
+  size_t inflight_{0};
+};
+
+} // namespace
+
+TrafficReplayer::Report::Report()
+    : latencyUs(kLatencyBucketUs, 0, kMaxLatencyUs + 1),
+      lagUs(kLatencyBucketUs, 0, kMaxLatencyUs + 1) {}
+
+void TrafficReplayer::Report::print(std::ostream& out) const {
+  out << folly::sformat(
+             "requests: {}  duration: {:.1f}s  throughput: {:.0f} req/s",
+             numRequests,
+             durationSec,
+             durationSec > 0 ? numRequests / durationSec : 0.0)
+      << std::endl;
+  if (numSkipped > 0) {
+    out << "skipped (too many requests in flight): " << numSkipped
+        << std::endl;
+  }
+  if (numBadRecords > 0) {
+    out << "bad records: " << numBadRecords << std::endl;
+  }
+  out << "results:" << std::endl;
+  for (const auto& it : numByResult) {
+    out << "  " << carbon::resultToString(it.first) << ": " << it.second
+        << std::endl;
+  }
+  for (const auto& it :
+       {std::make_pair("latency (us):", &latencyUs),
+        std::make_pair("send lag (us):", &lagUs)}) {
+    out << it.first;
+    for (auto pct : {0.5, 0.9, 0.99, 0.999}) {
+      out << folly::sformat(
+          "  p{}: {}", pct * 100, it.second->getPercentileEstimate(pct));
+    }
+    out << std::endl;
+  }
+}
+
+TrafficReplayer::TrafficReplayer(Settings settings)
+    : settings_(std::move(settings)) {}
+
+TrafficReplayer::Report TrafficReplayer::run(const std::string& tracePath) {
+  const auto protocol = mc_string_to_protocol(settings_.protocol.c_str());
+  if (protocol != mc_ascii_protocol && protocol != mc_caret_protocol) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "Invalid replay protocol '",
+        settings_.protocol,
+        "', ascii|caret expected"));
+  }
+  if (settings_.maxInflight == 0) {
+    throw std::invalid_argument("max inflight must be positive");
+  }
+
+  std::unique_ptr<FILE, int (*)(FILE*)> file(
+      fopen(tracePath.c_str(), "rb"), fclose);
+  if (!file) {
+    throw std::runtime_error(folly::to<std::string>(
+        "Can't open trace file '", tracePath, "': ", strerror(errno)));
+  }
+  std::string magic(kTraceMagic.size(), '\0');
+  if (fread(&magic[0], magic.size(), 1, file.get()) != 1 ||
+      folly::StringPiece(magic) != kTraceMagic) {
+    throw std::runtime_error(folly::to<std::string>(
+        "'", tracePath, "' is not a mcpiper trace file"));
+  }
+
+  folly::EventBase evb;
+  folly::fibers::FiberManager fm(
+      std::make_unique<folly::fibers::EventBaseLoopController>());
+  dynamic_cast<folly::fibers::EventBaseLoopController&>(fm.loopController())
+      .attachEventBase(evb);
+
+  ConnectionOptions options(settings_.host, settings_.port, protocol);
+  options.connectTimeout = std::chrono::milliseconds(settings_.timeoutMs);
+  options.writeTimeout = std::chrono::milliseconds(settings_.timeoutMs);
+  AsyncMcClient client(evb, options);
+
+  Report report;
+  Replay replay(settings_, fm, client, report);
+  fm.addTask([&] {
+    replay.run(file.get());
+    client.closeNow();
+    evb.terminateLoopSoon();
+  });
+  evb.loopForever();
+  return report;
+}
+
+} // namespace memcache
+} // namespace facebook
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include <folly/stats/Histogram.h>
+
+#include "mcrouter/lib/carbon/Result.h"
+
+namespace facebook {
+namespace memcache {
+
+/**
+ * Replays a trace written by TrafficRecorder against a memcache server (or
+ * a mcrouter), keeping the recorded inter-arrival times.
+ */
+class TrafficReplayer {
+ public:
+  struct Settings {
+    std::string host{"localhost"};
+    uint16_t port{0};
+    // "ascii" or "caret".
+    std::string protocol{"caret"};
+    // 2.0 replays twice as fast as recorded; 0 sends as fast as possible.
+    double speed{1.0};
+    uint32_t timeoutMs{1000};
+    // Requests that are due while this many are outstanding are skipped,
+    // rather than delaying the rest of the trace.
+    uint32_t maxInflight{1000};
+  };
+
+  struct Report {
+    Report();
+
+    uint64_t numRequests{0};
+    uint64_t numSkipped{0};
+    uint64_t numBadRecords{0};
+    double durationSec{0};
+    std::map<carbon::Result, uint64_t> numByResult;
+    folly::Histogram<int64_t> latencyUs;
+    // How late requests were sent compared to the (scaled) trace.
+    folly::Histogram<int64_t> lagUs;
+
+    void print(std::ostream& out) const;
+  };
+
+  explicit TrafficReplayer(Settings settings);
+
+  /**
+   * @throws std::runtime_error  if the trace can't be read.
+   */
+  Report run(const std::string& tracePath);
+
+ private:
+  const Settings settings_;
+};
+
+} // namespace memcache
+} // namespace facebook
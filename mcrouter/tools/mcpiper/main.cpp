@@ -15,8 +15,10 @@
 #include <folly/logging/Init.h>
 
 #include "mcrouter/tools/mcpiper/McPiper.h"
+#include "mcrouter/tools/mcpiper/TrafficReplayer.h"
 
 using namespace facebook::memcache::mcpiper;
+using facebook::memcache::TrafficReplayer;
 
 namespace {
 
@@ -55,6 +57,10 @@ std::string getUsage(const char* binaryName) {
       binaryName);
 }
 
+// Set if mcpiper should replay a trace rather than read fifos.
+std::string gReplayPath;
+TrafficReplayer::Settings gReplaySettings;
+
 Settings parseOptions(int argc, char** argv) {
   Settings settings;
 
@@ -117,7 +123,46 @@ Settings parseOptions(int argc, char** argv) {
       "ASCII protocol is not supported")(
       "script",
       po::bool_switch(&settings.script)->default_value(false),
-      "Machine-readable JSON output (useful for post-processing).");
+      "Machine-readable JSON output (useful for post-processing).")(
+      "ring-sample-period",
+      po::value<uint32_t>(&settings.ringSamplePeriod),
+      "For shared memory ring fifos (--debug-fifo-shm-ring-kb): ask mcrouter"
+      " to capture only one in every ARG messages.")(
+      "ring-match",
+      po::value<std::string>(&settings.ringMatch),
+      "For shared memory ring fifos: ask mcrouter to capture only messages"
+      " containing this string (e.g. a key or a key prefix).")(
+      "parser-threads",
+      po::value<size_t>(&settings.numParserThreads),
+      "Parse and print messages on ARG threads (connections are spread"
+      " among them, output order is kept). Useful to keep up with busy"
+      " mcrouters. Ignored with --record.")(
+      "record",
+      po::value<std::string>(&settings.recordPath),
+      "Don't print anything, record the matching requests (and their"
+      " timing) to file ARG instead, to be replayed with --replay.")(
+      "replay",
+      po::value<std::string>(&gReplayPath),
+      "Don't read fifos, replay the requests recorded in file ARG (see"
+      " --record) against --replay-port instead, and report latencies.")(
+      "replay-host",
+      po::value<std::string>(&gReplaySettings.host),
+      "Host to replay requests to.")(
+      "replay-port",
+      po::value<uint16_t>(&gReplaySettings.port),
+      "Port to replay requests to.")(
+      "replay-protocol",
+      po::value<std::string>(&gReplaySettings.protocol),
+      "Protocol to replay requests with; ARG is \"ascii\" or \"caret\".")(
+      "replay-speed",
+      po::value<double>(&gReplaySettings.speed),
+      "Replay ARG times faster than recorded; 0 to send as fast as possible.")(
+      "replay-timeout-ms",
+      po::value<uint32_t>(&gReplaySettings.timeoutMs),
+      "Timeout of replayed requests.")(
+      "replay-max-inflight",
+      po::value<uint32_t>(&gReplaySettings.maxInflight),
+      "Requests due while ARG are outstanding are skipped.");
 
   // Positional arguments - hidden from the help message
   po::options_description hiddenOpts("Hidden options");
@@ -166,6 +211,9 @@ Settings parseOptions(int argc, char** argv) {
   // Handles constraints
   CHECK(!settings.fifoRoot.empty())
       << "Fifo's directory (--fifo-root) cannot be empty";
+  CHECK(gReplayPath.empty() || gReplaySettings.port != 0)
+      << "--replay requires --replay-port";
+  CHECK(gReplaySettings.speed >= 0) << "--replay-speed cannot be negative";
 
   FLAGS_v = settings.verboseLevel;
 
@@ -194,6 +242,17 @@ int main(int argc, char** argv) {
     sigaction(sig, &sa, nullptr);
   }
 
-  gMcpiper->run(parseOptions(argc, argv));
+  auto settings = parseOptions(argc, argv);
+  if (!gReplayPath.empty()) {
+    try {
+      TrafficReplayer(gReplaySettings).run(gReplayPath).print(std::cout);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << e.what();
+      exit(1);
+    }
+    exit(0);
+  }
+
+  gMcpiper->run(std::move(settings));
   cleanExit(0);
 }
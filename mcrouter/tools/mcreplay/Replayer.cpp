@@ -0,0 +1,591 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "Replayer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <folly/Conv.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/container/F14Map.h>
+#include <folly/fibers/EventBaseLoopController.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/io/async/EventBase.h>
+#include <glog/logging.h>
+
+#include "mcrouter/lib/McResUtil.h"
+#include "mcrouter/lib/mc/protocol.h"
+#include "mcrouter/lib/network/AsyncMcClient.h"
+#include "mcrouter/lib/network/ConnectionOptions.h"
+#include "mcrouter/lib/network/gen/MemcacheMessages.h"
+#include "mcrouter/tools/mcreplay/SpoolFile.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcreplay {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Deletes handed to a worker at once.
+constexpr size_t kDispatchBatch = 64;
+// Deletes of a file that are checkpointed together.
+constexpr size_t kChunkSize = 1024;
+
+/**
+ * Bounds the number of deletes read but not replayed yet.
+ */
+class PendingLimiter {
+ public:
+  explicit PendingLimiter(size_t max) : max_(max) {}
+
+  bool tryAcquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_ >= max_) {
+      return false;
+    }
+    ++pending_;
+    return true;
+  }
+
+  void acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_ < max_; });
+    ++pending_;
+  }
+
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --pending_;
+    }
+    cv_.notify_all();
+  }
+
+  /**
+   * No more deletes will be read.
+   */
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  /**
+   * @return  true once closed and all deletes were replayed, false if the
+   *          deadline came first.
+   */
+  bool waitDone(Clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_until(
+        lock, deadline, [this] { return closed_ && pending_ == 0; });
+  }
+
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+  }
+
+ private:
+  const size_t max_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t pending_{0};
+  bool closed_{false};
+};
+
+struct Chunk {
+  // Index (in the file) after its last delete.
+  uint64_t end{0};
+  // Deletes of the chunk not replayed yet.
+  size_t outstanding{0};
+  // No more deletes will be added.
+  bool sealed{false};
+};
+
+/**
+ * Tracks how far a file was replayed. Deletes are added in file order by
+ * its reader, in chunks, and completed in any order by the workers; the
+ * file is done up to the first chunk that is not fully replayed.
+ */
+class FileProgress {
+ public:
+  FileProgress(std::string path, uint64_t done)
+      : path_(std::move(path)), initialDone_(done), done_(done) {}
+
+  const std::string& path() const {
+    return path_;
+  }
+
+  uint64_t initialDone() const {
+    return initialDone_;
+  }
+
+  uint64_t done() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return done_;
+  }
+
+  Chunk* add(uint64_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (chunks_.empty() || chunks_.back()->sealed) {
+      chunks_.push_back(std::make_unique<Chunk>());
+    }
+    auto* chunk = chunks_.back().get();
+    ++chunk->outstanding;
+    chunk->end = index + 1;
+    chunk->sealed = chunk->end % kChunkSize == 0;
+    return chunk;
+  }
+
+  void complete(Chunk* chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --chunk->outstanding;
+    advance();
+  }
+
+  /**
+   * @param numRecords  Number of deletes read from the file.
+   */
+  void finish(uint64_t numRecords) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (chunks_.empty()) {
+      done_ = std::max(done_, numRecords);
+      return;
+    }
+    chunks_.back()->sealed = true;
+    advance();
+  }
+
+ private:
+  const std::string path_;
+  const uint64_t initialDone_;
+  mutable std::mutex mutex_;
+  uint64_t done_;
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+
+  void advance() {
+    while (!chunks_.empty() && chunks_.front()->sealed &&
+           chunks_.front()->outstanding == 0) {
+      done_ = chunks_.front()->end;
+      chunks_.pop_front();
+    }
+  }
+};
+
+struct Item {
+  ReplayRecord record;
+  // "host:port"
+  std::string destination;
+  FileProgress* file{nullptr};
+  Chunk* chunk{nullptr};
+};
+
+/**
+ * State shared by all threads of a run.
+ */
+class RunState {
+ public:
+  explicit RunState(const Settings& settings) : limiter(settings.maxPending) {
+    if (!settings.failedPath.empty()) {
+      failed_ = folly::File(
+          settings.failedPath, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC);
+    }
+  }
+
+  PendingLimiter limiter;
+  std::atomic<uint64_t> numRecords{0};
+  std::atomic<uint64_t> numSkipped{0};
+  std::atomic<uint64_t> numReplayed{0};
+  std::atomic<uint64_t> numFailed{0};
+  std::atomic<uint64_t> numMalformed{0};
+  std::atomic<uint64_t> numBadFiles{0};
+
+  void complete(const Item& item, carbon::Result result) {
+    if (isErrorResult(result)) {
+      numFailed.fetch_add(1, std::memory_order_relaxed);
+      writeFailed(item.record);
+    } else {
+      numReplayed.fetch_add(1, std::memory_order_relaxed);
+    }
+    item.file->complete(item.chunk);
+    limiter.release();
+  }
+
+ private:
+  std::mutex failedMutex_;
+  folly::File failed_;
+
+  void writeFailed(const ReplayRecord& record) {
+    if (!failed_) {
+      return;
+    }
+    auto line = formatAsyncLogLine(record);
+    std::lock_guard<std::mutex> lock(failedMutex_);
+    if (folly::writeFull(failed_.fd(), line.data(), line.size()) < 0) {
+      PLOG_EVERY_N(ERROR, 1000) << "Failed to write a failed delete";
+    }
+  }
+};
+
+/**
+ * Sends the deletes of the destinations it owns, from its own thread.
+ */
+class Worker {
+ public:
+  Worker(const Settings& settings, RunState& state)
+      : settings_(settings),
+        state_(state),
+        protocol_(mc_string_to_protocol(settings.protocol.c_str())),
+        fm_(std::make_unique<folly::fibers::EventBaseLoopController>()) {
+    dynamic_cast<folly::fibers::EventBaseLoopController&>(fm_.loopController())
+        .attachEventBase(evb_);
+  }
+
+  void start() {
+    thread_ = std::thread([this] { evb_.loopForever(); });
+  }
+
+  /**
+   * Queues deletes to send. May be called from any thread.
+   */
+  void add(std::vector<Item> items) {
+    evb_.runInEventBaseThread([this, items = std::move(items)]() mutable {
+      for (auto& item : items) {
+        auto& destination = getDestination(item);
+        destination.queue.push_back(std::move(item));
+        // Every sender drains the queue until it's empty, one more is
+        // started per queued delete up to the concurrency.
+        if (destination.numSenders < settings_.concurrency) {
+          ++destination.numSenders;
+          fm_.addTask([this, &destination] { send(destination); });
+        }
+      }
+    });
+  }
+
+  /**
+   * Closes all connections and stops the thread. Must only be called once
+   * all deletes were replayed.
+   */
+  void stop() {
+    evb_.runInEventBaseThread([this] {
+      for (auto& it : destinations_) {
+        it.second->client->closeNow();
+      }
+      evb_.terminateLoopSoon();
+    });
+    thread_.join();
+    destinations_.clear();
+  }
+
+ private:
+  struct Destination {
+    std::unique_ptr<AsyncMcClient> client;
+    std::deque<Item> queue;
+    size_t numSenders{0};
+  };
+
+  const Settings& settings_;
+  RunState& state_;
+  const mc_protocol_t protocol_;
+  folly::EventBase evb_;
+  folly::fibers::FiberManager fm_;
+  std::thread thread_;
+  folly::F14FastMap<std::string, std::unique_ptr<Destination>> destinations_;
+
+  Destination& getDestination(const Item& item) {
+    auto& destination = destinations_[item.destination];
+    if (!destination) {
+      destination = std::make_unique<Destination>();
+      ConnectionOptions options(
+          item.record.host,
+          settings_.portOverride != 0 ? settings_.portOverride
+                                      : item.record.port,
+          protocol_);
+      options.connectTimeout = std::chrono::milliseconds(settings_.timeoutMs);
+      options.writeTimeout = std::chrono::milliseconds(settings_.timeoutMs);
+      destination->client = std::make_unique<AsyncMcClient>(evb_, options);
+    }
+    return *destination;
+  }
+
+  void send(Destination& destination) {
+    const std::chrono::milliseconds timeout(settings_.timeoutMs);
+    while (!destination.queue.empty()) {
+      auto item = std::move(destination.queue.front());
+      destination.queue.pop_front();
+
+      McDeleteRequest req(item.record.key);
+      for (const auto& attribute : item.record.attributes) {
+        req.attributes_ref()->emplace(attribute.first, attribute.second);
+      }
+      auto result = carbon::Result::UNKNOWN;
+      for (uint32_t attempt = 0; attempt <= settings_.retries; ++attempt) {
+        result = *destination.client->sendSync(req, timeout).result_ref();
+        if (!isErrorResult(result)) {
+          break;
+        }
+      }
+      state_.complete(item, result);
+    }
+    --destination.numSenders;
+  }
+};
+
+void readFiles(
+    const Settings& settings,
+    RunState& state,
+    std::vector<std::unique_ptr<FileProgress>>& files,
+    std::atomic<size_t>& nextFile,
+    std::vector<std::unique_ptr<Worker>>& workers) {
+  std::vector<std::vector<Item>> outgoing(workers.size());
+  auto flush = [&](size_t worker) {
+    if (!outgoing[worker].empty()) {
+      workers[worker]->add(std::move(outgoing[worker]));
+      outgoing[worker].clear();
+    }
+  };
+  auto flushAll = [&]() {
+    for (size_t worker = 0; worker < workers.size(); ++worker) {
+      flush(worker);
+    }
+  };
+
+  for (size_t i; (i = nextFile.fetch_add(1)) < files.size();) {
+    auto& file = *files[i];
+    uint64_t index = 0;
+    try {
+      SpoolFileReader reader(file.path());
+      ReplayRecord record;
+      while (reader.next(record)) {
+        state.numRecords.fetch_add(1, std::memory_order_relaxed);
+        if (index < file.initialDone()) {
+          state.numSkipped.fetch_add(1, std::memory_order_relaxed);
+          ++index;
+          continue;
+        }
+        if (!state.limiter.tryAcquire()) {
+          // The deletes held here must be sent for others to complete.
+          flushAll();
+          state.limiter.acquire();
+        }
+
+        Item item;
+        item.destination = folly::to<std::string>(
+            record.host,
+            ':',
+            settings.portOverride != 0 ? settings.portOverride : record.port);
+        item.record = std::move(record);
+        item.file = &file;
+        item.chunk = file.add(index++);
+
+        auto worker = std::hash<std::string>()(item.destination) %
+            workers.size();
+        outgoing[worker].push_back(std::move(item));
+        if (outgoing[worker].size() >= kDispatchBatch) {
+          flush(worker);
+        }
+        record = ReplayRecord();
+      }
+      state.numMalformed.fetch_add(
+          reader.numMalformed(), std::memory_order_relaxed);
+    } catch (const std::exception& ex) {
+      LOG(ERROR) << "Failed to read " << file.path() << " after " << index
+                 << " deletes: " << ex.what();
+      state.numBadFiles.fetch_add(1, std::memory_order_relaxed);
+    }
+    flushAll();
+    file.finish(index);
+  }
+}
+
+} // namespace
+
+Checkpoint loadCheckpoint(const std::string& path) {
+  Checkpoint checkpoint;
+  if (::access(path.c_str(), F_OK) != 0) {
+    return checkpoint;
+  }
+  std::string content;
+  if (!folly::readFile(path.c_str(), content)) {
+    throw std::runtime_error(folly::to<std::string>(
+        "can't read checkpoint ", path, ": ", folly::errnoStr(errno)));
+  }
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', content, lines, /* ignoreEmpty */ true);
+  for (auto line : lines) {
+    // "<deletes done>\t<file>"
+    folly::StringPiece done;
+    folly::StringPiece file;
+    if (!folly::split<false>('\t', line, done, file) ||
+        !folly::tryTo<uint64_t>(done).hasValue()) {
+      throw std::runtime_error(folly::to<std::string>(
+          "malformed checkpoint ", path, ": '", line, "'"));
+    }
+    checkpoint[file.str()] = folly::to<uint64_t>(done);
+  }
+  return checkpoint;
+}
+
+bool saveCheckpoint(const std::string& path, const Checkpoint& checkpoint) {
+  std::string content;
+  for (const auto& it : checkpoint) {
+    content += folly::to<std::string>(it.second, '\t', it.first, '\n');
+  }
+  auto tmpPath = path + ".tmp";
+  if (!folly::writeFile(content, tmpPath.c_str()) ||
+      ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    PLOG(ERROR) << "Failed to save checkpoint " << path;
+    return false;
+  }
+  return true;
+}
+
+void Report::print(std::ostream& out) const {
+  out << folly::sformat(
+             "deletes: {}  replayed: {}  failed: {}  skipped: {}  "
+             "duration: {:.1f}s  throughput: {:.0f} deletes/s",
+             numRecords,
+             numReplayed,
+             numFailed,
+             numSkipped,
+             durationSec,
+             durationSec > 0 ? (numReplayed + numFailed) / durationSec : 0.0)
+      << std::endl;
+  if (numMalformed > 0) {
+    out << "malformed lines: " << numMalformed << std::endl;
+  }
+  if (numBadFiles > 0) {
+    out << "files not read to the end: " << numBadFiles << std::endl;
+  }
+}
+
+Replayer::Replayer(Settings settings) : settings_(std::move(settings)) {}
+
+Report Replayer::run(std::ostream& progress) {
+  if (settings_.files.empty()) {
+    throw std::invalid_argument("no spool files to replay");
+  }
+  if (settings_.readerThreads == 0 || settings_.workerThreads == 0 ||
+      settings_.concurrency == 0 || settings_.maxPending == 0) {
+    throw std::invalid_argument(
+        "reader threads, worker threads, concurrency and max pending "
+        "must be positive");
+  }
+  auto protocol = mc_string_to_protocol(settings_.protocol.c_str());
+  if (protocol != mc_ascii_protocol && protocol != mc_caret_protocol) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "unsupported protocol '", settings_.protocol, "'"));
+  }
+
+  Checkpoint checkpoint;
+  if (!settings_.checkpointPath.empty()) {
+    checkpoint = loadCheckpoint(settings_.checkpointPath);
+  }
+  std::vector<std::unique_ptr<FileProgress>> files;
+  for (const auto& path : settings_.files) {
+    auto it = checkpoint.find(path);
+    files.push_back(std::make_unique<FileProgress>(
+        path, it != checkpoint.end() ? it->second : 0));
+  }
+  auto updateCheckpoint = [&]() {
+    if (settings_.checkpointPath.empty()) {
+      return;
+    }
+    for (const auto& file : files) {
+      checkpoint[file->path()] = file->done();
+    }
+    saveCheckpoint(settings_.checkpointPath, checkpoint);
+  };
+
+  RunState state(settings_);
+  const auto start = Clock::now();
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (size_t i = 0; i < settings_.workerThreads; ++i) {
+    workers.push_back(std::make_unique<Worker>(settings_, state));
+    workers.back()->start();
+  }
+
+  std::atomic<size_t> nextFile{0};
+  std::atomic<size_t> readersLeft{settings_.readerThreads};
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < settings_.readerThreads; ++i) {
+    readers.emplace_back([&]() {
+      readFiles(settings_, state, files, nextFile, workers);
+      if (readersLeft.fetch_sub(1) == 1) {
+        state.limiter.close();
+      }
+    });
+  }
+
+  const auto interval = std::chrono::seconds(
+      std::max<uint32_t>(settings_.checkpointIntervalSec, 1));
+  uint64_t lastCompleted = 0;
+  for (auto next = start + interval; !state.limiter.waitDone(next);
+       next += interval) {
+    auto completed = state.numReplayed.load() + state.numFailed.load();
+    progress << folly::sformat(
+                    "{:>6}s {:>10.0f} deletes/s  replayed: {}  failed: {}  "
+                    "pending: {}",
+                    std::chrono::duration_cast<std::chrono::seconds>(
+                        next - start)
+                        .count(),
+                    (completed - lastCompleted) /
+                        std::chrono::duration<double>(interval).count(),
+                    state.numReplayed.load(),
+                    state.numFailed.load(),
+                    state.limiter.pending())
+             << std::endl;
+    lastCompleted = completed;
+    updateCheckpoint();
+  }
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  for (auto& worker : workers) {
+    worker->stop();
+  }
+  updateCheckpoint();
+
+  Report report;
+  report.durationSec =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  report.numRecords = state.numRecords.load();
+  report.numSkipped = state.numSkipped.load();
+  report.numReplayed = state.numReplayed.load();
+  report.numFailed = state.numFailed.load();
+  report.numMalformed = state.numMalformed.load();
+  report.numBadFiles = state.numBadFiles.load();
+  return report;
+}
+
+} // namespace mcreplay
+} // namespace memcache
+} // namespace facebook
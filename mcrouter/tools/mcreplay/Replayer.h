@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <folly/container/F14Map.h>
+
+namespace facebook {
+namespace memcache {
+namespace mcreplay {
+
+struct Settings {
+  // Spool files to replay.
+  std::vector<std::string> files;
+  // If set, progress is saved to (and resumed from) this file.
+  std::string checkpointPath;
+  // If set, deletes that failed after all retries are appended to this file,
+  // as "AS2.0" asynclog lines, so they can be replayed again.
+  std::string failedPath;
+
+  // Number of files read in parallel.
+  size_t readerThreads{4};
+  // Number of threads sending the deletes. Every destination is handled by
+  // one of them.
+  size_t workerThreads{4};
+  // Deletes in flight per destination, pipelined over one connection.
+  size_t concurrency{16};
+  // Max number of deletes read but not replayed yet, over all files.
+  size_t maxPending{100000};
+
+  // "ascii" or "caret".
+  std::string protocol{"ascii"};
+  // If non-zero, used instead of the port logged with every delete.
+  uint16_t portOverride{0};
+  uint32_t timeoutMs{1000};
+  // Number of times a failed delete is sent again.
+  uint32_t retries{2};
+
+  uint32_t checkpointIntervalSec{5};
+};
+
+struct Report {
+  double durationSec{0};
+  // Deletes in the files, including the ones skipped.
+  uint64_t numRecords{0};
+  // Deletes already replayed according to the checkpoint.
+  uint64_t numSkipped{0};
+  uint64_t numReplayed{0};
+  uint64_t numFailed{0};
+  uint64_t numMalformed{0};
+  // Files that couldn't be read to the end.
+  uint64_t numBadFiles{0};
+
+  void print(std::ostream& out) const;
+};
+
+/**
+ * Progress of every file: the number of deletes at its start that were
+ * replayed (successfully or not).
+ */
+using Checkpoint = folly::F14FastMap<std::string, uint64_t>;
+
+/**
+ * @return  The checkpoint saved in `path`, empty if there is no such file.
+ *
+ * @throws std::runtime_error on malformed file.
+ */
+Checkpoint loadCheckpoint(const std::string& path);
+
+/**
+ * Atomically replaces `path` with the checkpoint.
+ *
+ * @return  false on error.
+ */
+bool saveCheckpoint(const std::string& path, const Checkpoint& checkpoint);
+
+/**
+ * Sends the deletes logged to asynclog spool files again, to the servers
+ * they were meant for.
+ *
+ * Files are read in parallel by readerThreads threads. Deletes are handed
+ * to the worker thread owning their destination (host:port), which keeps up
+ * to `concurrency` of them in flight on a single connection per destination,
+ * so a slow or dead destination doesn't hold back the others.
+ *
+ * Deletes complete out of order, so a file's checkpoint only covers the
+ * deletes before the first one still in flight: after a crash some deletes
+ * may be sent twice, but none is lost.
+ */
+class Replayer {
+ public:
+  explicit Replayer(Settings settings);
+
+  /**
+   * Replays all files, printing the progress to `progress` every
+   * checkpointIntervalSec.
+   *
+   * @throws std::invalid_argument on bad settings.
+   */
+  Report run(std::ostream& progress);
+
+ private:
+  const Settings settings_;
+};
+
+} // namespace mcreplay
+} // namespace memcache
+} // namespace facebook
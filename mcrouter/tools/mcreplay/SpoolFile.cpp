@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "SpoolFile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/json.h>
+
+#include "mcrouter/AsyncLogSpool.h"
+
+namespace facebook {
+namespace memcache {
+namespace mcreplay {
+
+namespace {
+
+constexpr folly::StringPiece kAsyncLogMagic{"AS1.0"};
+constexpr folly::StringPiece kAsyncLogMagic2{"AS2.0"};
+constexpr size_t kReadSize = 1 << 20;
+
+bool parseHostPort(folly::StringPiece s, std::string& host, uint16_t& port) {
+  // "[host]:port"
+  auto close = s.rfind("]:");
+  if (s.empty() || s.front() != '[' || close == folly::StringPiece::npos) {
+    return false;
+  }
+  auto parsedPort = folly::tryTo<uint16_t>(s.subpiece(close + 2));
+  if (!parsedPort.hasValue()) {
+    return false;
+  }
+  host = s.subpiece(1, close - 1).str();
+  port = *parsedPort;
+  return !host.empty();
+}
+
+} // namespace
+
+SpoolFileReader::SpoolFileReader(const std::string& path)
+    : file_(path, O_RDONLY) {
+  char magic[mcrouter::AsyncLogSpoolWriter::kFileMagic.size()];
+  auto n = folly::preadFull(file_.fd(), magic, sizeof(magic), 0);
+  if (n == static_cast<ssize_t>(sizeof(magic)) &&
+      folly::StringPiece(magic, sizeof(magic)) ==
+          mcrouter::AsyncLogSpoolWriter::kFileMagic) {
+    binary_ = std::make_unique<mcrouter::AsyncLogSpoolReader>(file_.fd());
+  }
+}
+
+SpoolFileReader::~SpoolFileReader() = default;
+
+bool SpoolFileReader::next(ReplayRecord& record) {
+  if (binary_) {
+    mcrouter::AsyncLogSpoolEntry entry;
+    if (!binary_->next(entry)) {
+      return false;
+    }
+    record.host = std::move(entry.host);
+    record.port = entry.port;
+    record.pool = std::move(entry.pool);
+    record.key = std::move(entry.key);
+    record.attributes = std::move(entry.attributes);
+    return true;
+  }
+
+  folly::StringPiece line;
+  while (nextLine(line)) {
+    if (folly::trimWhitespace(line).empty()) {
+      continue;
+    }
+    if (parseAsyncLogLine(line, record)) {
+      return true;
+    }
+    ++numMalformed_;
+  }
+  return false;
+}
+
+bool SpoolFileReader::nextLine(folly::StringPiece& line) {
+  while (true) {
+    auto end = buffer_.find('\n', bufferPos_);
+    if (end != std::string::npos) {
+      line = folly::StringPiece(buffer_.data() + bufferPos_, end - bufferPos_);
+      bufferPos_ = end + 1;
+      return true;
+    }
+    if (eof_) {
+      if (bufferPos_ == buffer_.size()) {
+        return false;
+      }
+      // Last line without a newline, e.g. cut short by a crash.
+      line = folly::StringPiece(buffer_).subpiece(bufferPos_);
+      bufferPos_ = buffer_.size();
+      return true;
+    }
+    buffer_.erase(0, bufferPos_);
+    bufferPos_ = 0;
+    auto size = buffer_.size();
+    buffer_.resize(size + kReadSize);
+    auto n = folly::readFull(file_.fd(), &buffer_[size], kReadSize);
+    if (n < 0) {
+      throw std::runtime_error(
+          folly::to<std::string>("read failed: ", folly::errnoStr(errno)));
+    }
+    buffer_.resize(size + n);
+    eof_ = n == 0;
+  }
+}
+
+bool parseAsyncLogLine(folly::StringPiece line, ReplayRecord& record) {
+  // ["AS1.0", 1289416829.836, "C", ["10.0.0.1", 11302, "delete foo\r\n"]]
+  // OR ["AS2.0", 1289416829.836, "C", {"f":"flavor","h":"[10.0.0.1]:11302",
+  //                                    "p":"pool_name","k":"foo"}]
+  try {
+    auto json = folly::parseJson(line);
+    if (!json.isArray() || json.size() != 4 || !json[0].isString()) {
+      return false;
+    }
+    const auto& op = json[3];
+    record = ReplayRecord();
+    if (json[0].stringPiece() == kAsyncLogMagic) {
+      if (!op.isArray() || op.size() != 3) {
+        return false;
+      }
+      record.host = op[0].asString();
+      record.port = folly::to<uint16_t>(op[1].asInt());
+      folly::StringPiece command = op[2].stringPiece();
+      if (!command.removePrefix("delete ")) {
+        return false;
+      }
+      record.key = folly::rtrimWhitespace(command).str();
+    } else if (json[0].stringPiece() == kAsyncLogMagic2) {
+      if (!op.isObject() || !op.count("h") || !op.count("k")) {
+        return false;
+      }
+      if (!parseHostPort(op["h"].stringPiece(), record.host, record.port)) {
+        return false;
+      }
+      record.key = folly::rtrimWhitespace(op["k"].stringPiece()).str();
+      if (auto pool = op.get_ptr("p")) {
+        record.pool = pool->asString();
+      }
+      if (auto attributes = op.get_ptr("a")) {
+        for (const auto& it : attributes->items()) {
+          record.attributes.emplace_back(
+              it.first.asString(), static_cast<uint64_t>(it.second.asInt()));
+        }
+      }
+    } else {
+      return false;
+    }
+    return !record.key.empty();
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+std::string formatAsyncLogLine(const ReplayRecord& record) {
+  folly::dynamic op = folly::dynamic::object;
+  op["h"] = folly::to<std::string>("[", record.host, "]:", record.port);
+  op["p"] = record.pool;
+  op["k"] = record.key;
+  folly::dynamic attributes = folly::dynamic::object;
+  for (const auto& it : record.attributes) {
+    attributes[it.first] = static_cast<int64_t>(it.second);
+  }
+  op["a"] = std::move(attributes);
+
+  auto timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+  folly::dynamic json = folly::dynamic::array(
+      kAsyncLogMagic2, 1e-3 * timestampMs, "C", std::move(op));
+  return folly::toJson(json) + "\n";
+}
+
+} // namespace mcreplay
+} // namespace memcache
+} // namespace facebook
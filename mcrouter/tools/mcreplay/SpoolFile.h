@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/File.h>
+#include <folly/Range.h>
+
+namespace facebook {
+namespace memcache {
+
+namespace mcrouter {
+class AsyncLogSpoolReader;
+} // namespace mcrouter
+
+namespace mcreplay {
+
+/**
+ * A delete logged to asynclog, to be sent again to host:port.
+ */
+struct ReplayRecord {
+  std::string host;
+  uint16_t port{0};
+  std::string pool;
+  std::string key;
+  std::vector<std::pair<std::string, uint64_t>> attributes;
+};
+
+/**
+ * Reads the deletes of an asynclog spool file, in any of the formats
+ * AsyncLog writes: binary (--asynclog-binary) or json lines, "AS1.0" or
+ * "AS2.0" (--use-asynclog-version2).
+ *
+ * Not thread-safe.
+ */
+class SpoolFileReader {
+ public:
+  /**
+   * @throws std::runtime_error if the file can't be opened.
+   */
+  explicit SpoolFileReader(const std::string& path);
+  ~SpoolFileReader();
+
+  /**
+   * Reads the next delete.
+   *
+   * @return  false at the end of file.
+   *
+   * @throws std::runtime_error on a corrupted binary block. Malformed json
+   *         lines are skipped (and counted, see numMalformed()).
+   */
+  bool next(ReplayRecord& record);
+
+  size_t numMalformed() const {
+    return numMalformed_;
+  }
+
+ private:
+  folly::File file_;
+  std::unique_ptr<mcrouter::AsyncLogSpoolReader> binary_;
+
+  // Json lines not parsed yet.
+  std::string buffer_;
+  size_t bufferPos_{0};
+  bool eof_{false};
+  size_t numMalformed_{0};
+
+  bool nextLine(folly::StringPiece& line);
+};
+
+/**
+ * Parses a json asynclog line.
+ *
+ * @return  false if the line is not a well formed delete.
+ */
+bool parseAsyncLogLine(folly::StringPiece line, ReplayRecord& record);
+
+/**
+ * Formats a delete as an "AS2.0" json line (with the trailing newline), so
+ * that deletes that couldn't be replayed can be replayed again later.
+ */
+std::string formatAsyncLogLine(const ReplayRecord& record);
+
+} // namespace mcreplay
+} // namespace memcache
+} // namespace facebook
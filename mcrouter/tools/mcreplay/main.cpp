@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/program_options.hpp>
+
+#include <folly/Format.h>
+#include <folly/init/Init.h>
+#include <folly/logging/Init.h>
+#include <glog/logging.h>
+
+#include "mcrouter/tools/mcreplay/Replayer.h"
+
+using namespace facebook::memcache::mcreplay;
+
+namespace {
+
+std::string getUsage(const char* binaryName) {
+  return folly::sformat(
+      "Usage: {} [OPTION]... FILE...\n"
+      "Sends the deletes logged to asynclog spool files (binary or json) "
+      "again, to the servers they were meant for.\n"
+      "Files are read in parallel and deletes are pipelined per destination. "
+      "With --checkpoint, an interrupted replay resumes where it stopped "
+      "(some deletes may be sent twice).\n",
+      binaryName);
+}
+
+Settings parseOptions(int argc, char** argv) {
+  Settings settings;
+
+  namespace po = boost::program_options;
+
+  po::options_description opts("Allowed options");
+  opts.add_options()("help,h", "Print this help message.")(
+      "checkpoint,C",
+      po::value<std::string>(&settings.checkpointPath),
+      "Save progress to (and resume from) this file.")(
+      "failed-output,F",
+      po::value<std::string>(&settings.failedPath),
+      "Append deletes that failed to this file, in asynclog format.")(
+      "readers,r",
+      po::value<size_t>(&settings.readerThreads)
+          ->default_value(settings.readerThreads),
+      "Number of files read in parallel.")(
+      "threads,t",
+      po::value<size_t>(&settings.workerThreads)
+          ->default_value(settings.workerThreads),
+      "Number of threads sending deletes.")(
+      "concurrency,c",
+      po::value<size_t>(&settings.concurrency)
+          ->default_value(settings.concurrency),
+      "Deletes in flight per destination.")(
+      "max-pending,m",
+      po::value<size_t>(&settings.maxPending)
+          ->default_value(settings.maxPending),
+      "Max number of deletes read but not replayed yet.")(
+      "protocol,P",
+      po::value<std::string>(&settings.protocol)
+          ->default_value(settings.protocol),
+      "\"ascii\" or \"caret\".")(
+      "port-override",
+      po::value<uint16_t>(&settings.portOverride)
+          ->default_value(settings.portOverride),
+      "If non-zero, send to this port instead of the logged one.")(
+      "timeout-ms",
+      po::value<uint32_t>(&settings.timeoutMs)
+          ->default_value(settings.timeoutMs),
+      "Request and connect timeout.")(
+      "retries",
+      po::value<uint32_t>(&settings.retries)->default_value(settings.retries),
+      "Number of times a failed delete is sent again.")(
+      "checkpoint-interval,i",
+      po::value<uint32_t>(&settings.checkpointIntervalSec)
+          ->default_value(settings.checkpointIntervalSec),
+      "Print the progress and save the checkpoint every <arg> seconds.");
+
+  po::options_description hidden;
+  hidden.add_options()(
+      "files", po::value<std::vector<std::string>>(&settings.files));
+  po::positional_options_description positional;
+  positional.add("files", -1);
+
+  po::options_description all;
+  all.add(opts).add(hidden);
+
+  po::variables_map vm;
+  try {
+    po::store(
+        po::command_line_parser(argc, argv)
+            .options(all)
+            .positional(positional)
+            .run(),
+        vm);
+    po::notify(vm);
+  } catch (po::error& ex) {
+    LOG(ERROR) << ex.what();
+    exit(1);
+  }
+
+  if (vm.count("help")) {
+    std::cerr << getUsage(argv[0]) << std::endl;
+    opts.print(std::cerr);
+    exit(0);
+  }
+
+  return settings;
+}
+
+} // anonymous namespace
+
+FOLLY_INIT_LOGGING_CONFIG(".=WARNING,folly=INFO; default:async=true");
+
+int main(int argc, char** argv) {
+  // Just give the binary name to folly::init() because we use
+  // boost::program_options instead of gflags.
+  int tempArgc = 1;
+  folly::init(&tempArgc, &argv, false);
+
+  auto settings = parseOptions(argc, argv);
+  try {
+    Replayer replayer(std::move(settings));
+    auto report = replayer.run(std::cerr);
+    report.print(std::cout);
+    return report.numFailed == 0 && report.numBadFiles == 0 ? 0 : 2;
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << ex.what();
+    return 1;
+  }
+}